@@ -30,15 +30,24 @@
 #define LOG_TAG "agm_client_wrapper"
 
 #include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <agm/agm_api.h>
 #include <gio/gio.h>
+#include <gio/gunixfdlist.h>
 #include "utils.h"
+#include "agm-dbus-shmem.h"
 
 #define AGM_OBJECT_PATH "/org/qti/agm"
 #define AGM_MODULE_IFACE "org.Qti.Agm"
 #define AGM_SESSION_IFACE "org.Qti.Agm.Session"
 #define AGM_DBUS_CONNECTION "org.Qti.AgmService"
 #define AGM_MAX_G_OBJ_PATH 128
+/* Set to 0 in the environment to force the inline "ay" data path */
+#define AGM_DBUS_SHMEM_ENV "AGM_DBUS_SHMEM"
+/* Delay before setting the ring up again after a failed doorbell */
+#define AGM_SHMEM_RETRY_US (1000 * 1000)
 
 typedef struct {
     GDBusConnection *conn;
@@ -55,6 +64,13 @@ typedef struct {
     GThread *thread_loop;
     GMainLoop *loop;
     GList *callbacks;
+    /* Shared memory ring for read/write, NULL when using the inline path */
+    int shm_fd;
+    struct agm_shmem_hdr *shm;
+    size_t shm_size;
+    struct agm_shmem_geom shm_geom;
+    /* monotonic time at which to set the ring up again, 0 if not pending */
+    gint64 shm_retry_us;
 } agm_client_session_data;
 
 typedef struct {
@@ -1485,6 +1501,199 @@ int agm_session_set_config(uint64_t handle,
     return 0;
 }
 
+static void agm_session_shmem_release(agm_client_session_data *ses_data) {
+    if (ses_data->shm == NULL)
+        return;
+
+    munmap(ses_data->shm, ses_data->shm_size);
+    close(ses_data->shm_fd);
+    ses_data->shm = NULL;
+    ses_data->shm_size = 0;
+    ses_data->shm_fd = -1;
+}
+
+/* Drops a ring that may be out of sync after a failed doorbell. The
+ * session uses the inline path until the ring is set up again.
+ */
+static void agm_session_shmem_reset(agm_client_session_data *ses_data) {
+    agm_session_shmem_release(ses_data);
+    ses_data->shm_retry_us = g_get_monotonic_time() + AGM_SHMEM_RETRY_US;
+}
+
+/* Negotiates the shared memory data plane with the server. On any failure
+ * the session keeps using the inline DBus path.
+ */
+static void agm_session_shmem_setup(agm_client_session_data *ses_data) {
+    GVariant *result = NULL;
+    GUnixFDList *fd_list = NULL;
+    GError *error = NULL;
+    const char *env = getenv(AGM_DBUS_SHMEM_ENV);
+    gint32 fd_idx;
+    guint32 num_slots, slot_size;
+    size_t map_size;
+    void *map = MAP_FAILED;
+    int fd = -1;
+
+    if (env != NULL && !strcmp(env, "0"))
+        return;
+
+    result = g_dbus_proxy_call_with_unix_fd_list_sync(ses_data->proxy,
+                                    "AgmSessionShmemSetup",
+                                    g_variant_new("(uu)",
+                                                  AGM_SHMEM_DEFAULT_SLOTS,
+                                                  AGM_SHMEM_DEFAULT_SLOT_SIZE),
+                                    G_DBUS_CALL_FLAGS_NONE,
+                                    -1,
+                                    NULL,
+                                    &fd_list,
+                                    NULL,
+                                    &error);
+
+    if (result == NULL) {
+        AGM_LOGI("%s: shmem not available, using inline path: %s\n",
+                  __func__, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    g_variant_get(result, "(huu)", &fd_idx, &num_slots, &slot_size);
+    g_variant_unref(result);
+
+    if (fd_list != NULL) {
+        fd = g_unix_fd_list_get(fd_list, fd_idx, &error);
+        g_object_unref(fd_list);
+    }
+
+    if (fd < 0) {
+        AGM_LOGE("%s: no fd received for shmem ring\n", __func__);
+        if (error)
+            g_error_free(error);
+        return;
+    }
+
+    map_size = agm_shmem_map_size(num_slots, slot_size);
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED ||
+        agm_shmem_validate((struct agm_shmem_hdr *)map, map_size,
+                           &ses_data->shm_geom)) {
+        AGM_LOGE("%s: invalid shmem ring\n", __func__);
+        if (map != MAP_FAILED)
+            munmap(map, map_size);
+        close(fd);
+        return;
+    }
+
+    ses_data->shm_fd = fd;
+    ses_data->shm = (struct agm_shmem_hdr *)map;
+    ses_data->shm_size = map_size;
+    AGM_LOGD("%s: session %d using shmem ring %d x %d bytes\n", __func__,
+             ses_data->session_id, num_slots, slot_size);
+}
+
+static void agm_session_shmem_retry(agm_client_session_data *ses_data) {
+    if (ses_data->shm != NULL || ses_data->shm_retry_us == 0 ||
+        g_get_monotonic_time() < ses_data->shm_retry_us)
+        return;
+
+    agm_session_shmem_setup(ses_data);
+    if (ses_data->shm == NULL)
+        ses_data->shm_retry_us = g_get_monotonic_time() + AGM_SHMEM_RETRY_US;
+    else
+        ses_data->shm_retry_us = 0;
+}
+
+/* Returns -EAGAIN when the buffer was not written and has to go inline */
+static int agm_session_shmem_write(agm_client_session_data *ses_data,
+                                   void *buf, size_t *byte_count) {
+    GVariant *result = NULL;
+    GError *error = NULL;
+    int64_t idx;
+    guint32 written;
+
+    idx = agm_shmem_produce_begin(ses_data->shm, &ses_data->shm_geom);
+    if (idx < 0) {
+        /* Doorbells are consumed before their reply, a full ring is stale */
+        agm_session_shmem_reset(ses_data);
+        return -EAGAIN;
+    }
+
+    memcpy(agm_shmem_slot_data(ses_data->shm, &ses_data->shm_geom,
+                               (uint32_t)idx), buf, *byte_count);
+    agm_shmem_produce_commit(ses_data->shm, &ses_data->shm_geom,
+                             (uint32_t)idx, *byte_count);
+
+    result = g_dbus_proxy_call_sync(ses_data->proxy,
+                                    "AgmSessionShmemWrite",
+                                    g_variant_new("(u)", (guint32)idx),
+                                    G_DBUS_CALL_FLAGS_NONE,
+                                    -1,
+                                    NULL,
+                                    &error);
+
+    if (result == NULL) {
+        AGM_LOGE("%s: Error invoking AgmSessionShmemWrite: %s\n", __func__,
+                  error->message);
+        g_error_free(error);
+        /* A consumed slot was passed to agm_session_write, which failed */
+        if (__atomic_load_n(&ses_data->shm->tail, __ATOMIC_ACQUIRE) ==
+                                                    (uint32_t)idx + 1)
+            return -EINVAL;
+        /* The server never got to the slot and head cannot be rolled back */
+        agm_session_shmem_reset(ses_data);
+        return -EAGAIN;
+    }
+
+    g_variant_get(result, "(u)", &written);
+    *byte_count = written;
+    g_variant_unref(result);
+    return 0;
+}
+
+/* Returns -EAGAIN when nothing was read and the inline path has to be used */
+static int agm_session_shmem_read(agm_client_session_data *ses_data,
+                                  void *buf, size_t *byte_count) {
+    GVariant *result = NULL;
+    GError *error = NULL;
+    int64_t idx;
+    guint32 slot, size;
+
+    result = g_dbus_proxy_call_sync(ses_data->proxy,
+                                    "AgmSessionShmemRead",
+                                    g_variant_new("(u)", (guint32)*byte_count),
+                                    G_DBUS_CALL_FLAGS_NONE,
+                                    -1,
+                                    NULL,
+                                    &error);
+
+    if (result == NULL) {
+        AGM_LOGE("%s: Error invoking AgmSessionShmemRead: %s\n", __func__,
+                  error->message);
+        g_error_free(error);
+        /* The server fills the slot only once agm_session_read succeeded */
+        if (agm_shmem_consume_begin(ses_data->shm) >= 0)
+            agm_session_shmem_reset(ses_data);
+        return -EAGAIN;
+    }
+
+    g_variant_get(result, "(uu)", &slot, &size);
+    g_variant_unref(result);
+
+    idx = agm_shmem_consume_begin(ses_data->shm);
+    if (idx < 0 || (uint32_t)idx != slot || size > *byte_count ||
+        size > ses_data->shm_geom.slot_size) {
+        AGM_LOGE("%s: shmem ring out of sync, slot %u size %u\n", __func__,
+                  slot, size);
+        agm_session_shmem_reset(ses_data);
+        return -EAGAIN;
+    }
+
+    memcpy(buf, agm_shmem_slot_data(ses_data->shm, &ses_data->shm_geom, slot),
+           size);
+    agm_shmem_consume_end(ses_data->shm, slot);
+    *byte_count = size;
+    return 0;
+}
+
 int agm_session_write(uint64_t handle, void *buf, size_t *byte_count) {
     agm_client_session_data *ses_data = (agm_client_session_data *) handle;
     GVariant *result = NULL, *arr = NULL, *argument = NULL;
@@ -1494,6 +1703,15 @@ int agm_session_write(uint64_t handle, void *buf, size_t *byte_count) {
     g_assert(ses_data->proxy != NULL);
     AGM_LOGD("%s\n", __func__);
 
+    agm_session_shmem_retry(ses_data);
+    if (ses_data->shm != NULL &&
+        *byte_count <= ses_data->shm_geom.slot_size) {
+        int ret = agm_session_shmem_write(ses_data, buf, byte_count);
+
+        if (ret != -EAGAIN)
+            return ret;
+    }
+
     arr = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
                                     (gconstpointer)buf,
                                     *byte_count,
@@ -1534,6 +1752,15 @@ int agm_session_read(uint64_t handle, void *buf, size_t *byte_count) {
     g_assert(ses_data->proxy != NULL);
     AGM_LOGD("%s\n", __func__);
 
+    agm_session_shmem_retry(ses_data);
+    if (ses_data->shm != NULL &&
+        *byte_count <= ses_data->shm_geom.slot_size) {
+        int ret = agm_session_shmem_read(ses_data, buf, byte_count);
+
+        if (ret != -EAGAIN)
+            return ret;
+    }
+
     argument = g_variant_new("(@u)", g_variant_new_uint32(*byte_count));
 
     result = g_dbus_proxy_call_sync(ses_data->proxy,
@@ -1740,6 +1967,7 @@ int agm_session_close(uint64_t handle) {
         ses_data->thread_loop = NULL;
     }
 
+    agm_session_shmem_release(ses_data);
     g_hash_table_remove(mdata->ses_hash_table,
                         GINT_TO_POINTER(ses_data->session_id));
     g_free(ses_data->obj_path);
@@ -1813,6 +2041,7 @@ int agm_session_open(uint32_t session_id, uint64_t *handle) {
         }
 
         ses_data->session_id = session_id;
+        agm_session_shmem_setup(ses_data);
         /* add session to sessions hash table */
         g_hash_table_insert(mdata->ses_hash_table,
                             GINT_TO_POINTER(ses_data->session_id),
@@ -1821,6 +2050,8 @@ int agm_session_open(uint32_t session_id, uint64_t *handle) {
         return rc;
     } else {
         *handle = (uint64_t)ses_data;
+        if (ses_data->shm == NULL && ses_data->proxy != NULL)
+            agm_session_shmem_setup(ses_data);
         return rc;
     }
 
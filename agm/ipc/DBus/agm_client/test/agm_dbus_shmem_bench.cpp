@@ -0,0 +1,334 @@
+/*
+** Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+** SPDX-License-Identifier: BSD-3-Clause-Clear
+**/
+
+/*
+ * Loopback benchmark for the AGM DBus data plane.
+ *
+ * A loopback service and a client run in the same process on two separate
+ * connections to the session bus, so every call goes through the bus daemon
+ * exactly like agm_server <-> agmclient. For each buffer size the client
+ * pushes buffers through the inline "ay" path and through the shared memory
+ * ring + doorbell path and reports throughput and per call latency.
+ *
+ * Usage: dbus-run-session -- agm_dbus_shmem_bench [iterations]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <vector>
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+#include "agm-dbus-shmem.h"
+
+#define BENCH_BUS_NAME "org.Qti.AgmShmemBench"
+#define BENCH_OBJECT_PATH "/org/qti/agm/bench"
+#define BENCH_IFACE "org.Qti.AgmShmemBench"
+#define BENCH_DEFAULT_ITERATIONS 2000
+
+static const gchar bench_introspection_xml[] =
+    "<node>"
+    "  <interface name='" BENCH_IFACE "'>"
+    "    <method name='Write'>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='ay' direction='in'/>"
+    "      <arg type='u' direction='out'/>"
+    "    </method>"
+    "    <method name='ShmemSetup'>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='h' direction='out'/>"
+    "      <arg type='u' direction='out'/>"
+    "      <arg type='u' direction='out'/>"
+    "    </method>"
+    "    <method name='ShmemWrite'>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='u' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+typedef struct {
+    struct agm_shmem_hdr *shm;
+    struct agm_shmem_geom geom;
+    size_t shm_size;
+    int shm_fd;
+    /* the sink touches every byte like a real consumer would */
+    uint64_t checksum;
+} bench_server;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void consume(bench_server *srv, const uint8_t *buf, size_t size) {
+    for (size_t i = 0; i < size; i += 64)
+        srv->checksum += buf[i];
+}
+
+static void bench_method_call(GDBusConnection *conn, const gchar *sender,
+                              const gchar *object_path,
+                              const gchar *interface_name,
+                              const gchar *method_name, GVariant *parameters,
+                              GDBusMethodInvocation *invocation,
+                              gpointer user_data) {
+    bench_server *srv = (bench_server *)user_data;
+    GUnixFDList *fd_list = NULL;
+    guint32 size, slot, num_slots, slot_size;
+    GVariant *arr = NULL;
+    gconstpointer value;
+    gsize n_elements;
+    int64_t idx;
+    size_t map_size;
+
+    if (!g_strcmp0(method_name, "Write")) {
+        g_variant_get(parameters, "(u@ay)", &size, &arr);
+        value = g_variant_get_fixed_array(arr, &n_elements, sizeof(guchar));
+        /* the server wrapper copies into a private buffer before writing */
+        uint8_t *buf = (uint8_t *)malloc(n_elements);
+        memcpy(buf, value, n_elements);
+        consume(srv, buf, n_elements);
+        free(buf);
+        g_variant_unref(arr);
+        g_dbus_method_invocation_return_value(invocation,
+                                    g_variant_new("(u)", (guint32)n_elements));
+    } else if (!g_strcmp0(method_name, "ShmemSetup")) {
+        g_variant_get(parameters, "(uu)", &num_slots, &slot_size);
+        map_size = agm_shmem_map_size(num_slots, slot_size);
+        srv->shm_fd = memfd_create("agm_bench_shmem", MFD_CLOEXEC);
+        if (srv->shm_fd < 0 || ftruncate(srv->shm_fd, map_size) < 0) {
+            g_dbus_method_invocation_return_dbus_error(invocation,
+                              "org.freedesktop.DBus.Error.Failed", "memfd");
+            return;
+        }
+        srv->shm = (struct agm_shmem_hdr *)mmap(NULL, map_size,
+                      PROT_READ | PROT_WRITE, MAP_SHARED, srv->shm_fd, 0);
+        srv->shm_size = map_size;
+        agm_shmem_init(srv->shm, &srv->geom, num_slots, slot_size);
+        fd_list = g_unix_fd_list_new();
+        g_unix_fd_list_append(fd_list, srv->shm_fd, NULL);
+        g_dbus_method_invocation_return_value_with_unix_fd_list(invocation,
+                      g_variant_new("(huu)", 0, num_slots, slot_size), fd_list);
+        g_object_unref(fd_list);
+    } else if (!g_strcmp0(method_name, "ShmemWrite")) {
+        g_variant_get(parameters, "(u)", &slot);
+        idx = agm_shmem_consume_begin(srv->shm);
+        if (idx < 0 || (guint32)idx != slot) {
+            g_dbus_method_invocation_return_dbus_error(invocation,
+                              "org.freedesktop.DBus.Error.Failed", "sync");
+            return;
+        }
+        size = agm_shmem_slot_size(srv->shm, &srv->geom, (uint32_t)idx);
+        consume(srv, agm_shmem_slot_data(srv->shm, &srv->geom, (uint32_t)idx),
+                size);
+        agm_shmem_consume_end(srv->shm, (uint32_t)idx);
+        g_dbus_method_invocation_return_value(invocation,
+                                              g_variant_new("(u)", size));
+    }
+}
+
+static const GDBusInterfaceVTable bench_vtable = {
+    bench_method_call, NULL, NULL, {0}
+};
+
+static GMainLoop *server_loop = NULL;
+
+static gpointer server_thread(gpointer data) {
+    bench_server *srv = (bench_server *)data;
+    GMainContext *ctx = g_main_context_new();
+    GDBusNodeInfo *info = NULL;
+    GDBusConnection *conn = NULL;
+    GError *error = NULL;
+    GVariant *ret = NULL;
+    gchar *address = NULL;
+
+    g_main_context_push_thread_default(ctx);
+    address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SESSION, NULL, &error);
+    if (address == NULL) {
+        fprintf(stderr, "server: no session bus: %s\n", error->message);
+        exit(1);
+    }
+    /* private connection so that client calls really cross the bus */
+    conn = g_dbus_connection_new_for_address_sync(address,
+               (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+               G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+               NULL, NULL, &error);
+    g_free(address);
+    if (conn == NULL) {
+        fprintf(stderr, "server: connection failed: %s\n", error->message);
+        exit(1);
+    }
+    info = g_dbus_node_info_new_for_xml(bench_introspection_xml, NULL);
+    g_dbus_connection_register_object(conn, BENCH_OBJECT_PATH,
+                                      info->interfaces[0], &bench_vtable,
+                                      srv, NULL, NULL);
+    ret = g_dbus_connection_call_sync(conn, "org.freedesktop.DBus",
+                    "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                    "RequestName", g_variant_new("(su)", BENCH_BUS_NAME, 0),
+                    NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+    if (ret)
+        g_variant_unref(ret);
+
+    server_loop = g_main_loop_new(ctx, FALSE);
+    g_main_loop_run(server_loop);
+    g_dbus_node_info_unref(info);
+    g_object_unref(conn);
+    g_main_context_pop_thread_default(ctx);
+    return NULL;
+}
+
+static void report(const char *path, size_t size, int iterations,
+                   std::vector<uint64_t> &lat, uint64_t total_ns) {
+    std::sort(lat.begin(), lat.end());
+    double secs = total_ns / 1e9;
+
+    printf("%-7s %7zu B  %9.1f MB/s  avg %7.1f us  p50 %7.1f us  p99 %7.1f us\n",
+           path, size, (double)size * iterations / secs / (1024 * 1024),
+           total_ns / 1e3 / iterations, lat[lat.size() / 2] / 1e3,
+           lat[(lat.size() * 99) / 100] / 1e3);
+}
+
+static int run_inline(GDBusProxy *proxy, size_t size, int iterations) {
+    std::vector<uint8_t> buf(size, 0x5a);
+    std::vector<uint64_t> lat;
+    GError *error = NULL;
+    GVariant *result = NULL, *arr = NULL;
+    uint64_t start, t0;
+
+    start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        t0 = now_ns();
+        arr = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, buf.data(), size,
+                                        sizeof(guchar));
+        result = g_dbus_proxy_call_sync(proxy, "Write",
+                                        g_variant_new("(u@ay)", (guint32)size, arr),
+                                        G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+        if (result == NULL) {
+            fprintf(stderr, "Write failed: %s\n", error->message);
+            return -EIO;
+        }
+        g_variant_unref(result);
+        lat.push_back(now_ns() - t0);
+    }
+    report("inline", size, iterations, lat, now_ns() - start);
+    return 0;
+}
+
+static int run_shmem(GDBusProxy *proxy, struct agm_shmem_hdr *shm,
+                     const struct agm_shmem_geom *geom, size_t size,
+                     int iterations) {
+    std::vector<uint8_t> buf(size, 0xa5);
+    std::vector<uint64_t> lat;
+    GError *error = NULL;
+    GVariant *result = NULL;
+    uint64_t start, t0;
+    int64_t idx;
+
+    start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        t0 = now_ns();
+        idx = agm_shmem_produce_begin(shm, geom);
+        if (idx < 0)
+            return -EAGAIN;
+        memcpy(agm_shmem_slot_data(shm, geom, (uint32_t)idx), buf.data(), size);
+        agm_shmem_produce_commit(shm, geom, (uint32_t)idx, size);
+        result = g_dbus_proxy_call_sync(proxy, "ShmemWrite",
+                                        g_variant_new("(u)", (guint32)idx),
+                                        G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+        if (result == NULL) {
+            fprintf(stderr, "ShmemWrite failed: %s\n", error->message);
+            return -EIO;
+        }
+        g_variant_unref(result);
+        lat.push_back(now_ns() - t0);
+    }
+    report("shmem", size, iterations, lat, now_ns() - start);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const size_t sizes[] = {960, 3840, 7680, 16384, 65536};
+    bench_server srv = {};
+    GDBusProxy *proxy = NULL;
+    GUnixFDList *fd_list = NULL;
+    GError *error = NULL;
+    GVariant *result = NULL;
+    GThread *thread = NULL;
+    struct agm_shmem_hdr *shm = NULL;
+    struct agm_shmem_geom geom;
+    gint32 fd_idx;
+    guint32 num_slots, slot_size;
+    int iterations = BENCH_DEFAULT_ITERATIONS;
+    int fd, rc = 0;
+
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0)
+        iterations = BENCH_DEFAULT_ITERATIONS;
+
+    thread = g_thread_new("agm_bench_server", server_thread, &srv);
+
+    /* wait for the service to own its name */
+    for (int retry = 0; retry < 100 && proxy == NULL; retry++) {
+        proxy = g_dbus_proxy_new_for_bus_sync(G_BUS_TYPE_SESSION,
+                    G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START, NULL, BENCH_BUS_NAME,
+                    BENCH_OBJECT_PATH, BENCH_IFACE, NULL, NULL);
+        if (proxy && !g_dbus_proxy_get_name_owner(proxy)) {
+            g_object_unref(proxy);
+            proxy = NULL;
+            usleep(10000);
+        }
+    }
+    if (proxy == NULL) {
+        fprintf(stderr, "loopback service did not come up, is a session bus running?\n");
+        return 1;
+    }
+
+    result = g_dbus_proxy_call_with_unix_fd_list_sync(proxy, "ShmemSetup",
+                    g_variant_new("(uu)", AGM_SHMEM_DEFAULT_SLOTS,
+                                  AGM_SHMEM_DEFAULT_SLOT_SIZE),
+                    G_DBUS_CALL_FLAGS_NONE, -1, NULL, &fd_list, NULL, &error);
+    if (result == NULL) {
+        fprintf(stderr, "ShmemSetup failed: %s\n", error->message);
+        return 1;
+    }
+    g_variant_get(result, "(huu)", &fd_idx, &num_slots, &slot_size);
+    g_variant_unref(result);
+    fd = g_unix_fd_list_get(fd_list, fd_idx, NULL);
+    g_object_unref(fd_list);
+    shm = (struct agm_shmem_hdr *)mmap(NULL,
+                    agm_shmem_map_size(num_slots, slot_size),
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (shm == MAP_FAILED ||
+        agm_shmem_validate(shm, agm_shmem_map_size(num_slots, slot_size),
+                           &geom)) {
+        fprintf(stderr, "invalid shared memory ring\n");
+        return 1;
+    }
+
+    printf("%d iterations per case, ring %u x %u bytes\n", iterations,
+           num_slots, slot_size);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && !rc; i++) {
+        rc = run_inline(proxy, sizes[i], iterations);
+        if (!rc)
+            rc = run_shmem(proxy, shm, &geom, sizes[i], iterations);
+    }
+
+    munmap(shm, agm_shmem_map_size(num_slots, slot_size));
+    close(fd);
+    g_object_unref(proxy);
+    if (server_loop)
+        g_main_loop_quit(server_loop);
+    g_thread_join(thread);
+    return rc ? 1 : 0;
+}
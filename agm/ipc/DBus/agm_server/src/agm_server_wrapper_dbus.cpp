@@ -33,9 +33,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sstream>
 #include <agm/agm_api.h>
 #include "agm-dbus-utils.h"
+#include "agm-dbus-shmem.h"
 #include "agm_server_wrapper_dbus.h"
 
 #include "utils.h"
@@ -68,6 +71,12 @@ typedef struct {
     /* List which maintains all the callbacks associated with a session id.
        Used to de-register callbacks when client dies abruptly */
     GList *callbacks;
+    /* Shared memory ring negotiated by the client, -1/NULL if not in use */
+    int shm_fd;
+    struct agm_shmem_hdr *shm;
+    size_t shm_size;
+    /* Geometry the ring was set up with, the header copy is client writable */
+    struct agm_shmem_geom shm_geom;
 } agm_session_data;
 
 typedef struct {
@@ -116,6 +125,9 @@ enum AgmSessionMethods {
     AgmSessionEos,
     AgmSessionGetTime,
     AgmGetHwProcessedBufCount,
+    AgmSessionShmemSetup,
+    AgmSessionShmemWrite,
+    AgmSessionShmemRead,
     AgmDbusSessionMethodMax
 };
 
@@ -223,6 +235,15 @@ static void ipc_agm_session_register_cb(DBusConnection *conn,
 static void ipc_agm_session_deregister_cb(DBusConnection *conn,
                                           DBusMessage *msg,
                                           void *userdata);
+static void ipc_agm_session_shmem_setup(DBusConnection *conn,
+                                        DBusMessage *msg,
+                                        void *userdata);
+static void ipc_agm_session_shmem_write(DBusConnection *conn,
+                                        DBusMessage *msg,
+                                        void *userdata);
+static void ipc_agm_session_shmem_read(DBusConnection *conn,
+                                       DBusMessage *msg,
+                                       void *userdata);
 
 static agm_dbus_method agm_dbus_module_methods[AgmDbusModuleMethodMax] = {
     {"AgmAifSetMediaConfig", "u(uui)", ipc_agm_audio_intf_set_media_config},
@@ -264,7 +285,10 @@ static agm_dbus_method agm_dbus_session_methods[AgmDbusSessionMethodMax] = {
     {"AgmSessionSetConfig", "(uuu)(uu)ay", ipc_agm_session_set_config},
     {"AgmSessionEos", "", ipc_agm_session_eos},
     {"AgmSessionGetTime", "", ipc_agm_get_session_time},
-    {"AgmGetHwProcessedBufCount", "u", ipc_agm_get_hw_processed_buff_cnt}
+    {"AgmGetHwProcessedBufCount", "u", ipc_agm_get_hw_processed_buff_cnt},
+    {"AgmSessionShmemSetup", "uu", ipc_agm_session_shmem_setup},
+    {"AgmSessionShmemWrite", "u", ipc_agm_session_shmem_write},
+    {"AgmSessionShmemRead", "u", ipc_agm_session_shmem_read}
 };
 
 static agm_dbus_signal event_callback[AgmSignalMax] = {
@@ -287,6 +311,19 @@ agm_dbus_interface_info session_interface_info = {
     .signal_count=AgmSignalMax
 };
 
+static void agm_session_shmem_release(agm_session_data *ses_data) {
+    if (ses_data->shm != NULL) {
+        munmap(ses_data->shm, ses_data->shm_size);
+        ses_data->shm = NULL;
+        ses_data->shm_size = 0;
+    }
+
+    if (ses_data->shm_fd >= 0) {
+        close(ses_data->shm_fd);
+        ses_data->shm_fd = -1;
+    }
+}
+
 static DBusHandlerResult disconnection_filter_cb(DBusConnection *conn,
                                                  DBusMessage *msg,
                                                  void *userdata) {
@@ -329,6 +366,7 @@ static DBusHandlerResult disconnection_filter_cb(DBusConnection *conn,
         g_list_free(ses_data->callbacks);
 
         dbus_connection_remove_filter(conn, disconnection_filter_cb, ses_data);
+        agm_session_shmem_release(ses_data);
 
         if (agm_session_close(ses_data->handle) != 0) {
             AGM_LOGE("agm_session_close failed.");
@@ -370,6 +408,7 @@ void agm_free_session(gpointer c_data) {
         data->dbus_obj_path = NULL;
     }
 
+    agm_session_shmem_release(data);
     free(data);
     data = NULL;
 }
@@ -410,6 +449,9 @@ static agm_session_data * get_session_data(agm_module_dbus_data *mdata,
                  "/session_",
                  session_id);
         ses_data->callbacks = NULL;
+        ses_data->shm_fd = -1;
+        ses_data->shm = NULL;
+        ses_data->shm_size = 0;
 
         if (agm_dbus_add_interface(mdata->conn,
                                    ses_data->dbus_obj_path,
@@ -2007,6 +2049,209 @@ static void ipc_agm_session_read(DBusConnection *conn,
     dbus_message_unref(reply);
 }
 
+static void ipc_agm_session_shmem_setup(DBusConnection *conn,
+                                        DBusMessage *msg,
+                                        void *userdata) {
+    DBusMessage *reply = NULL;
+    DBusMessageIter arg_i, r_arg;
+    agm_session_data *ses_data = (agm_session_data *)userdata;
+    uint32_t num_slots, slot_size;
+    size_t map_size;
+    void *map = MAP_FAILED;
+    int fd = -1;
+
+    if (userdata == NULL) {
+        AGM_LOGE("Invalid userdata");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "userdata is NULL");
+        return;
+    }
+
+    if (!dbus_message_iter_init(msg, &arg_i)) {
+        AGM_LOGE("ipc_agm_session_shmem_setup has no arguments");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "ipc_agm_session_shmem_setup has no arguments");
+        return;
+    }
+
+    if (strcmp(dbus_message_get_signature(msg), "uu")) {
+        AGM_LOGE("Invalid signature for ipc_agm_session_shmem_setup.");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                      "Invalid signature for ipc_agm_session_shmem_setup.");
+        return;
+    }
+
+    if (!dbus_connection_can_send_type(conn, DBUS_TYPE_UNIX_FD)) {
+        AGM_LOGE("connection does not support fd passing");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_NOT_SUPPORTED,
+                            "fd passing not supported");
+        return;
+    }
+
+    AGM_LOGV("%s : ", __func__);
+
+    dbus_message_iter_get_basic(&arg_i, &num_slots);
+    dbus_message_iter_next(&arg_i);
+    dbus_message_iter_get_basic(&arg_i, &slot_size);
+
+    if (num_slots == 0 || num_slots > AGM_SHMEM_MAX_SLOTS)
+        num_slots = AGM_SHMEM_DEFAULT_SLOTS;
+    if (slot_size == 0 || slot_size > AGM_SHMEM_MAX_SLOT_SIZE)
+        slot_size = AGM_SHMEM_DEFAULT_SLOT_SIZE;
+    map_size = agm_shmem_map_size(num_slots, slot_size);
+
+    /* A client reopening the ring drops the previous one */
+    agm_session_shmem_release(ses_data);
+
+    fd = memfd_create("agm_session_shmem", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, map_size) < 0) {
+        AGM_LOGE("memfd setup failed, errno %d", errno);
+        goto fail;
+    }
+
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        AGM_LOGE("mmap failed, errno %d", errno);
+        goto fail;
+    }
+
+    ses_data->shm_fd = fd;
+    ses_data->shm = (struct agm_shmem_hdr *)map;
+    ses_data->shm_size = map_size;
+    agm_shmem_init(ses_data->shm, &ses_data->shm_geom, num_slots, slot_size);
+
+    reply = dbus_message_new_method_return(msg);
+    dbus_message_iter_init_append(reply, &r_arg);
+    dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UNIX_FD, &fd);
+    dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UINT32, &num_slots);
+    dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UINT32, &slot_size);
+    dbus_connection_send(conn, reply, NULL);
+    dbus_message_unref(reply);
+    AGM_LOGD("session %d shmem ring %d x %d bytes", ses_data->session_id,
+             num_slots, slot_size);
+    return;
+
+fail:
+    if (fd >= 0)
+        close(fd);
+    agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                        "shared memory setup failed.");
+}
+
+static void ipc_agm_session_shmem_write(DBusConnection *conn,
+                                        DBusMessage *msg,
+                                        void *userdata) {
+    DBusMessage *reply = NULL;
+    DBusMessageIter arg_i, r_arg;
+    agm_session_data *ses_data = (agm_session_data *)userdata;
+    uint32_t slot, buf_size;
+    int64_t idx;
+    size_t size;
+
+    if (userdata == NULL || ses_data->shm == NULL) {
+        AGM_LOGE("Invalid userdata or shmem not set up");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "shmem not set up");
+        return;
+    }
+
+    if (!dbus_message_iter_init(msg, &arg_i) ||
+        strcmp(dbus_message_get_signature(msg), "u")) {
+        AGM_LOGE("Invalid signature for ipc_agm_session_shmem_write.");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                      "Invalid signature for ipc_agm_session_shmem_write.");
+        return;
+    }
+
+    dbus_message_iter_get_basic(&arg_i, &slot);
+
+    idx = agm_shmem_consume_begin(ses_data->shm);
+    if (idx < 0 || (uint32_t)idx != slot) {
+        AGM_LOGE("doorbell for slot %u, ring at %lld", slot, (long long)idx);
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "shmem ring out of sync.");
+        return;
+    }
+
+    size = agm_shmem_slot_size(ses_data->shm, &ses_data->shm_geom, slot);
+    if (agm_session_write(ses_data->handle,
+                          agm_shmem_slot_data(ses_data->shm,
+                                              &ses_data->shm_geom, slot),
+                          &size)) {
+        agm_shmem_consume_end(ses_data->shm, slot);
+        AGM_LOGE("agm_session_write failed.");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "agm_session_write failed.");
+        return;
+    }
+    agm_shmem_consume_end(ses_data->shm, slot);
+    buf_size = size;
+
+    reply = dbus_message_new_method_return(msg);
+    dbus_message_iter_init_append(reply, &r_arg);
+    dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UINT32, &buf_size);
+    dbus_connection_send(conn, reply, NULL);
+    dbus_message_unref(reply);
+}
+
+static void ipc_agm_session_shmem_read(DBusConnection *conn,
+                                       DBusMessage *msg,
+                                       void *userdata) {
+    DBusMessage *reply = NULL;
+    DBusMessageIter arg_i, r_arg;
+    agm_session_data *ses_data = (agm_session_data *)userdata;
+    uint32_t slot, buf_size;
+    int64_t idx;
+    size_t size;
+
+    if (userdata == NULL || ses_data->shm == NULL) {
+        AGM_LOGE("Invalid userdata or shmem not set up");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "shmem not set up");
+        return;
+    }
+
+    if (!dbus_message_iter_init(msg, &arg_i) ||
+        strcmp(dbus_message_get_signature(msg), "u")) {
+        AGM_LOGE("Invalid signature for ipc_agm_session_shmem_read.");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                      "Invalid signature for ipc_agm_session_shmem_read.");
+        return;
+    }
+
+    dbus_message_iter_get_basic(&arg_i, &buf_size);
+
+    idx = agm_shmem_produce_begin(ses_data->shm, &ses_data->shm_geom);
+    if (idx < 0) {
+        AGM_LOGE("shmem ring full");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_LIMITS_EXCEEDED,
+                            "shmem ring full.");
+        return;
+    }
+
+    slot = (uint32_t)idx;
+    size = buf_size > ses_data->shm_geom.slot_size ?
+                                ses_data->shm_geom.slot_size : buf_size;
+    if (agm_session_read(ses_data->handle,
+                         agm_shmem_slot_data(ses_data->shm,
+                                             &ses_data->shm_geom, slot),
+                         &size)) {
+        AGM_LOGE("agm_session_read failed.");
+        agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
+                            "agm_session_read failed.");
+        return;
+    }
+    agm_shmem_produce_commit(ses_data->shm, &ses_data->shm_geom, slot, size);
+    buf_size = size;
+
+    reply = dbus_message_new_method_return(msg);
+    dbus_message_iter_init_append(reply, &r_arg);
+    dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UINT32, &slot);
+    dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UINT32, &buf_size);
+    dbus_connection_send(conn, reply, NULL);
+    dbus_message_unref(reply);
+}
+
 static void ipc_agm_session_resume(DBusConnection *conn,
                                    DBusMessage *msg,
                                    void *userdata) {
@@ -2175,6 +2420,7 @@ static void ipc_agm_session_close(DBusConnection *conn,
     }
 
     g_list_free(ses_data->callbacks);
+    agm_session_shmem_release(ses_data);
 
     if (agm_dbus_remove_interface(mdata->conn,
                                   ses_data->dbus_obj_path,
@@ -0,0 +1,168 @@
+/*
+** Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+** SPDX-License-Identifier: BSD-3-Clause-Clear
+**/
+
+/*
+ * Shared memory data plane for AGM session read/write over DBus.
+ *
+ * The server creates a memfd per session when the client asks for it
+ * (AgmSessionShmemSetup) and passes the fd back over DBus. Audio buffers are
+ * then exchanged through a ring of fixed size slots in that memory and DBus
+ * only carries the doorbell (AgmSessionShmemWrite/AgmSessionShmemRead) with
+ * the slot index. Buffers bigger than a slot use the inline "ay" path.
+ *
+ * The ring is single producer/single consumer. For writes the client
+ * produces and the server consumes, for reads it is the other way around.
+ * Every doorbell is synchronous, its slot is consumed before the reply, so
+ * the client asks for a single slot. The header keeps room for more.
+ */
+
+#ifndef __AGM_DBUS_SHMEM_H__
+#define __AGM_DBUS_SHMEM_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+
+#define AGM_SHMEM_MAGIC 0x524d4741 /* "AGMR" */
+#define AGM_SHMEM_VERSION 1
+#define AGM_SHMEM_MAX_SLOTS 16
+#define AGM_SHMEM_DEFAULT_SLOTS 1
+#define AGM_SHMEM_DEFAULT_SLOT_SIZE (64 * 1024)
+#define AGM_SHMEM_MAX_SLOT_SIZE (1024 * 1024)
+#define AGM_SHMEM_DATA_ALIGN 64
+
+struct agm_shmem_slot {
+    uint32_t size;
+    uint32_t reserved;
+};
+
+struct agm_shmem_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_slots;
+    uint32_t slot_size;
+    /* free running counters, slot index is counter % num_slots */
+    uint32_t head;
+    uint32_t tail;
+    struct agm_shmem_slot slots[AGM_SHMEM_MAX_SLOTS];
+};
+
+/*
+ * Ring geometry as the local side set it up or validated it. The copy in
+ * the header stays writable by the peer, so indexing and size clamps only
+ * ever use this one.
+ */
+struct agm_shmem_geom {
+    uint32_t num_slots;
+    uint32_t slot_size;
+};
+
+static inline size_t agm_shmem_hdr_size(void)
+{
+    return (sizeof(struct agm_shmem_hdr) + AGM_SHMEM_DATA_ALIGN - 1) &
+                                            ~((size_t)AGM_SHMEM_DATA_ALIGN - 1);
+}
+
+static inline size_t agm_shmem_map_size(uint32_t num_slots, uint32_t slot_size)
+{
+    return agm_shmem_hdr_size() + (size_t)num_slots * slot_size;
+}
+
+static inline void agm_shmem_init(struct agm_shmem_hdr *hdr,
+                                  struct agm_shmem_geom *geom,
+                                  uint32_t num_slots, uint32_t slot_size)
+{
+    hdr->magic = AGM_SHMEM_MAGIC;
+    hdr->version = AGM_SHMEM_VERSION;
+    hdr->num_slots = num_slots;
+    hdr->slot_size = slot_size;
+    __atomic_store_n(&hdr->head, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&hdr->tail, 0, __ATOMIC_RELEASE);
+    geom->num_slots = num_slots;
+    geom->slot_size = slot_size;
+}
+
+/*
+ * Validates a ring mapped from a peer and copies its geometry into geom.
+ * Each header field is read once, so the peer cannot change it between
+ * the check and the copy.
+ */
+static inline int agm_shmem_validate(struct agm_shmem_hdr *hdr, size_t map_size,
+                                     struct agm_shmem_geom *geom)
+{
+    uint32_t magic = __atomic_load_n(&hdr->magic, __ATOMIC_RELAXED);
+    uint32_t version = __atomic_load_n(&hdr->version, __ATOMIC_RELAXED);
+    uint32_t num_slots = __atomic_load_n(&hdr->num_slots, __ATOMIC_RELAXED);
+    uint32_t slot_size = __atomic_load_n(&hdr->slot_size, __ATOMIC_RELAXED);
+
+    if (magic != AGM_SHMEM_MAGIC || version != AGM_SHMEM_VERSION)
+        return -EINVAL;
+    if (num_slots == 0 || num_slots > AGM_SHMEM_MAX_SLOTS ||
+        slot_size == 0 || slot_size > AGM_SHMEM_MAX_SLOT_SIZE)
+        return -EINVAL;
+    if (agm_shmem_map_size(num_slots, slot_size) > map_size)
+        return -EINVAL;
+    geom->num_slots = num_slots;
+    geom->slot_size = slot_size;
+    return 0;
+}
+
+static inline uint8_t *agm_shmem_slot_data(struct agm_shmem_hdr *hdr,
+                                           const struct agm_shmem_geom *geom,
+                                           uint32_t idx)
+{
+    return (uint8_t *)hdr + agm_shmem_hdr_size() +
+                   (size_t)(idx % geom->num_slots) * geom->slot_size;
+}
+
+/* Returns the counter of the next free slot, or -EAGAIN if the ring is full */
+static inline int64_t agm_shmem_produce_begin(struct agm_shmem_hdr *hdr,
+                                              const struct agm_shmem_geom *geom)
+{
+    uint32_t head = __atomic_load_n(&hdr->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= geom->num_slots)
+        return -EAGAIN;
+    return head;
+}
+
+static inline void agm_shmem_produce_commit(struct agm_shmem_hdr *hdr,
+                                            const struct agm_shmem_geom *geom,
+                                            uint32_t idx, uint32_t size)
+{
+    hdr->slots[idx % geom->num_slots].size = size;
+    __atomic_store_n(&hdr->head, idx + 1, __ATOMIC_RELEASE);
+}
+
+/* Returns the counter of the oldest filled slot, or -EAGAIN if empty */
+static inline int64_t agm_shmem_consume_begin(struct agm_shmem_hdr *hdr)
+{
+    uint32_t tail = __atomic_load_n(&hdr->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail)
+        return -EAGAIN;
+    return tail;
+}
+
+/* Size of a filled slot, read once and clamped to the local slot size */
+static inline uint32_t agm_shmem_slot_size(struct agm_shmem_hdr *hdr,
+                                           const struct agm_shmem_geom *geom,
+                                           uint32_t idx)
+{
+    uint32_t size = __atomic_load_n(&hdr->slots[idx % geom->num_slots].size,
+                                    __ATOMIC_RELAXED);
+
+    return size > geom->slot_size ? geom->slot_size : size;
+}
+
+static inline void agm_shmem_consume_end(struct agm_shmem_hdr *hdr,
+                                         uint32_t idx)
+{
+    __atomic_store_n(&hdr->tail, idx + 1, __ATOMIC_RELEASE);
+}
+
+#endif /* __AGM_DBUS_SHMEM_H__ */
@@ -74,3 +74,43 @@ endif
 
 include $(BUILD_SHARED_LIBRARY)
 
+
+# Build agm_metadata_test
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := agm_metadata_test
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        := -D_ANDROID_ -Wall
+LOCAL_C_INCLUDES    := $(LOCAL_PATH)/inc/public
+LOCAL_C_INCLUDES    += $(LOCAL_PATH)/inc/private
+
+LOCAL_SRC_FILES  := \
+    src/metadata.c \
+    test/src/agm_metadata_test.c
+
+LOCAL_HEADER_LIBRARIES := libspf-headers libutils_headers
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_EXECUTABLE)
+
+# Build agm_session_bench
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := agm_session_bench
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        := -D_ANDROID_ -Wall
+LOCAL_C_INCLUDES    := $(LOCAL_PATH)/inc/public
+LOCAL_C_INCLUDES    += $(LOCAL_PATH)/inc/private
+
+LOCAL_SRC_FILES  := test/src/agm_session_bench.c
+
+LOCAL_HEADER_LIBRARIES := libspf-headers libutils_headers libacdb_headers
+LOCAL_SHARED_LIBRARIES := libagm liblog
+
+include $(BUILD_EXECUTABLE)
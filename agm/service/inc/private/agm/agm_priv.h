@@ -62,6 +62,10 @@ struct agm_meta_data_gsl {
      * Used to lookup the property ids
      */
      struct sg_prop sg_props;
+     /**
+     * Bumped on every change, used to validate cached merges
+     */
+     uint64_t gen;
 };
 
 struct agm_tag_config_gsl {
@@ -33,7 +33,27 @@
 #include <stdarg.h>
 #include <agm/agm_priv.h>
 
+#define METADATA_CACHE_MAX_INPUTS 4
+
+/*
+ * Result of a merge kept along with the generation of each input. It is
+ * reused as long as none of the inputs was copied, updated or freed since.
+ * The cache is not locked, callers serialize access to it.
+ */
+struct metadata_cache {
+    struct agm_meta_data_gsl *merged;
+    int num_inputs;
+    struct agm_meta_data_gsl *input[METADATA_CACHE_MAX_INPUTS];
+    uint64_t gen[METADATA_CACHE_MAX_INPUTS];
+    uint32_t hits;
+    uint32_t misses;
+};
+
 struct agm_meta_data_gsl* metadata_merge(int num, ...);
+/* returned metadata is owned by the cache, do not free it */
+struct agm_meta_data_gsl* metadata_merge_cached(struct metadata_cache *cache,
+                                                int num, ...);
+void metadata_cache_free(struct metadata_cache *cache);
 int metadata_copy(struct agm_meta_data_gsl *dest, uint32_t size, uint8_t *payload);
 void metadata_free(struct agm_meta_data_gsl *metadata);
 void metadata_update_cal(struct agm_meta_data_gsl *meta_data,
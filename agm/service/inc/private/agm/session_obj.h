@@ -55,6 +55,8 @@ struct aif {
     struct device_obj *dev_obj;
     enum aif_state state;
     struct agm_meta_data_gsl sess_aif_meta;
+    /* merge of sess_meta, sess_aif_meta and dev_obj metadata */
+    struct metadata_cache merged_cache;
     void *params;
     size_t params_size;
     struct agm_tag_config *tag_config;
@@ -81,6 +83,9 @@ struct session_obj {
     enum session_state state;
     struct agm_meta_data_gsl sess_meta;
     struct listnode aif_pool;
+    /* aif objects of aif_pool indexed by aif id */
+    struct aif **aif_index;
+    uint32_t aif_index_size;
     struct listnode cb_pool;
     struct graph_obj *graph;
     struct agm_session_config stream_config;
@@ -98,11 +103,29 @@ struct session_obj {
     uint32_t tx_metadata_sz;
     pthread_mutex_t lock;
     pthread_mutex_t cb_pool_lock;
+    uint32_t slot;
+};
+
+#define SESSION_SLOTS_MAX 1024
+#define SESSION_HASH_SIZE (2 * SESSION_SLOTS_MAX)
+
+/*
+ * Session objects live until session_obj_deinit(), so a slot is never
+ * reused. The generation is bumped on every close and is part of the
+ * handle given out on open, which makes handles of a closed session stale.
+ */
+struct session_slot {
+    struct session_obj *obj;
+    uint32_t gen;
 };
 
 struct session_pool {
     struct listnode session_list;
     pthread_mutex_t lock;
+    struct session_slot slots[SESSION_SLOTS_MAX];
+    uint32_t num_slots;
+    /* session id lookup, insert only, read without the lock */
+    struct session_obj *id_hash[SESSION_HASH_SIZE];
 };
 
 struct session_pool *sess_pool;
@@ -110,6 +133,8 @@ struct session_pool *sess_pool;
 int session_obj_init();
 int session_obj_deinit();
 int session_obj_valid_check(uint64_t hndl);
+struct session_obj *session_obj_from_handle(uint64_t hndl);
+uint64_t session_obj_get_handle(struct session_obj *sess_obj);
 int session_obj_get(int session_id, struct session_obj **sess_obj);
 int session_obj_open(uint32_t session_id,
                      enum agm_session_mode sess_mode,
@@ -671,12 +671,18 @@ int agm_session_open(uint32_t session_id,
                      uint64_t *hndl)
 {
 
-    struct session_obj **handle = (struct session_obj**) hndl;
-    if (!handle) {
+    struct session_obj *handle = NULL;
+    int ret = 0;
+
+    if (!hndl) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_open(session_id, sess_mode, handle);
+
+    ret = session_obj_open(session_id, sess_mode, &handle);
+    if (!ret)
+        *hndl = session_obj_get_handle(handle);
+    return ret;
 }
 
 int agm_session_set_config(uint64_t hndl,
@@ -684,17 +690,12 @@ int agm_session_set_config(uint64_t hndl,
                            struct agm_media_config *media_config,
                            struct agm_buffer_config *buffer_config)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
-
     return session_obj_set_config(handle, stream_config, media_config,
                                                        buffer_config);
 }
@@ -702,168 +703,113 @@ int agm_session_set_config(uint64_t hndl,
 int agm_session_prepare(uint64_t hndl)
 {
 
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_prepare(handle);
 }
 
 int agm_session_start(uint64_t hndl)
 {
 
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_start(handle);
 }
 
 int agm_session_stop(uint64_t hndl)
 {
 
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_stop(handle);
 }
 
 int agm_session_close(uint64_t hndl)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_close(handle);
 }
 
 int agm_session_pause(uint64_t hndl)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_pause(handle);
 }
 
 int agm_session_flush(uint64_t hndl)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_flush(handle);
 }
 
 int agm_session_resume(uint64_t hndl)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_resume(handle);
 }
 
 int agm_session_suspend(uint64_t hndl)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_suspend(handle);
 }
 
 int agm_session_write(uint64_t hndl, void *buff, size_t *count)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_write(handle, buff, count);
 }
 
 int agm_session_read(uint64_t hndl, void *buff, size_t *count)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_read(handle, buff, count);
 }
 
 size_t agm_get_hw_processed_buff_cnt(uint64_t hndl, enum direction dir)
 {
-    struct session_obj *handle = (struct session_obj *) hndl;
+    struct session_obj *handle = session_obj_from_handle(hndl);
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-
-    if (!session_obj_valid_check(hndl)) {
-        AGM_LOGE("Invalid handle\n");
-        return -EINVAL;
-    }
     return session_obj_hw_processed_buff_cnt(handle, dir);
 }
 
@@ -918,30 +864,36 @@ done:
 
 int agm_session_eos(uint64_t handle)
 {
+    struct session_obj *sess_obj = NULL;
+
     if (!handle) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(handle)) {
+    sess_obj = session_obj_from_handle(handle);
+    if (!sess_obj) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_eos((struct session_obj *) handle);
+    return session_obj_eos(sess_obj);
 }
 
 int agm_get_session_time(uint64_t handle, uint64_t *timestamp)
 {
+    struct session_obj *sess_obj = NULL;
+
     if (!handle || !timestamp) {
         AGM_LOGE("Invalid handle or timestamp pointer\n");
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(handle)) {
+    sess_obj = session_obj_from_handle(handle);
+    if (!sess_obj) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_get_timestamp((struct session_obj *) handle, timestamp);
+    return session_obj_get_timestamp(sess_obj, timestamp);
 }
 
 int agm_get_buffer_timestamp(uint32_t session_id, uint64_t *timestamp)
@@ -997,48 +949,57 @@ int agm_set_gapless_session_metadata(uint64_t handle,
                          enum agm_gapless_silence_type type,
                          uint32_t silence)
 {
+    struct session_obj *sess_obj = NULL;
+
     if (!handle) {
         AGM_LOGE("%s Invalid handle\n", __func__);
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(handle)) {
+    sess_obj = session_obj_from_handle(handle);
+    if (!sess_obj) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_set_gapless_metadata((struct session_obj *) handle, type,
+    return session_obj_set_gapless_metadata(sess_obj, type,
                                              silence);
 }
 
 int agm_session_write_with_metadata(uint64_t handle, struct agm_buff *buff,
                                     size_t *consumed_size)
 {
+    struct session_obj *sess_obj = NULL;
+
     if (!handle) {
         AGM_LOGE("%s Invalid handle\n", __func__);
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(handle)) {
+    sess_obj = session_obj_from_handle(handle);
+    if (!sess_obj) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_write_with_metadata((struct session_obj *) handle, buff,
+    return session_obj_write_with_metadata(sess_obj, buff,
                                             consumed_size);
 }
 
 int agm_session_read_with_metadata(uint64_t handle, struct agm_buff *buff,
                                     uint32_t *captured_size )
 {
+    struct session_obj *sess_obj = NULL;
+
     if (!handle) {
         AGM_LOGE("%s Invalid handle\n", __func__);
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(handle)) {
+    sess_obj = session_obj_from_handle(handle);
+    if (!sess_obj) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_read_with_metadata((struct session_obj *) handle, buff,
+    return session_obj_read_with_metadata(sess_obj, buff,
                                            captured_size);
 }
 
@@ -1049,16 +1010,19 @@ int agm_session_set_non_tunnel_mode_config(uint64_t handle,
                                        struct agm_buffer_config *in_buffer_config,
                                        struct agm_buffer_config *out_buffer_config)
 {
+    struct session_obj *sess_obj = NULL;
+
     if (!handle) {
         AGM_LOGE("%s Invalid handle\n", __func__);
         return -EINVAL;
     }
 
-    if (!session_obj_valid_check(handle)) {
+    sess_obj = session_obj_from_handle(handle);
+    if (!sess_obj) {
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
-    return session_obj_set_non_tunnel_mode_config((struct session_obj *) handle,
+    return session_obj_set_non_tunnel_mode_config(sess_obj,
                                             session_config,
                                             in_media_config,
                                             out_media_config,
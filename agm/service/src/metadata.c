@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <malloc.h>
 #include <string.h>
+#include <stdbool.h>
 
 #include <agm/metadata.h>
 #include <agm/utils.h>
@@ -160,18 +161,32 @@ static void metadata_remove_dup(
     //metadata_print(meta_data);
 }
 
+static uint64_t metadata_gen;
+
+/* generations are global so that a freed and recopied metadata never repeats one */
+static void metadata_touch(struct agm_meta_data_gsl *meta_data)
+{
+    meta_data->gen = __atomic_add_fetch(&metadata_gen, 1, __ATOMIC_RELAXED);
+}
+
 void metadata_update_cal(struct agm_meta_data_gsl *meta_data,
                                      struct agm_key_vector_gsl *ckv)
 {
     int i, j;
+    bool updated = false;
 
     for (i = 0; i < meta_data->ckv.num_kvs; i++) {
         for (j = 0; j < ckv->num_kvs; j++) {
-            if (meta_data->ckv.kv[i].key == ckv->kv[j].key) {
+            if (meta_data->ckv.kv[i].key == ckv->kv[j].key &&
+                meta_data->ckv.kv[i].value != ckv->kv[j].value) {
                 meta_data->ckv.kv[i].value = ckv->kv[j].value;
+                updated = true;
             }
         }
     }
+
+    if (updated)
+        metadata_touch(meta_data);
 }
 
 struct agm_meta_data_gsl* metadata_merge(int num, ...)
@@ -270,6 +285,75 @@ struct agm_meta_data_gsl* metadata_merge(int num, ...)
     return merged;
 }
 
+struct agm_meta_data_gsl* metadata_merge_cached(struct metadata_cache *cache,
+                                                int num, ...)
+{
+    struct agm_meta_data_gsl *input[METADATA_CACHE_MAX_INPUTS];
+    struct agm_meta_data_gsl *merged;
+    va_list valist;
+    bool valid;
+    int i;
+
+    if (num <= 0 || num > METADATA_CACHE_MAX_INPUTS) {
+        AGM_LOGE("Invalid number of inputs %d to cached merge\n", num);
+        return NULL;
+    }
+
+    va_start(valist, num);
+    for (i = 0; i < num; i++)
+        input[i] = va_arg(valist, struct agm_meta_data_gsl*);
+    va_end(valist);
+
+    valid = cache->merged && cache->num_inputs == num;
+    for (i = 0; valid && i < num; i++) {
+        if (cache->input[i] != input[i] ||
+            cache->gen[i] != (input[i] ? input[i]->gen : 0))
+            valid = false;
+    }
+    if (valid) {
+        cache->hits++;
+        return cache->merged;
+    }
+
+    switch (num) {
+    case 1:
+        merged = metadata_merge(1, input[0]);
+        break;
+    case 2:
+        merged = metadata_merge(2, input[0], input[1]);
+        break;
+    case 3:
+        merged = metadata_merge(3, input[0], input[1], input[2]);
+        break;
+    default:
+        merged = metadata_merge(4, input[0], input[1], input[2], input[3]);
+        break;
+    }
+    if (!merged)
+        return NULL;
+
+    metadata_cache_free(cache);
+    cache->merged = merged;
+    cache->num_inputs = num;
+    for (i = 0; i < num; i++) {
+        cache->input[i] = input[i];
+        cache->gen[i] = input[i] ? input[i]->gen : 0;
+    }
+    cache->misses++;
+
+    return merged;
+}
+
+void metadata_cache_free(struct metadata_cache *cache)
+{
+    if (cache && cache->merged) {
+        metadata_free(cache->merged);
+        free(cache->merged);
+        cache->merged = NULL;
+        cache->num_inputs = 0;
+    }
+}
+
 int metadata_copy(struct agm_meta_data_gsl *dest, uint32_t size __unused,
                                               uint8_t *metadata)
 {
@@ -320,6 +404,7 @@ int metadata_copy(struct agm_meta_data_gsl *dest, uint32_t size __unused,
     }
     memcpy(dest->sg_props.values, PTR_TO_PROPS(metadata),
            dest->sg_props.num_values * sizeof(uint32_t));
+    metadata_touch(dest);
 
     return ret;
 
@@ -341,5 +426,6 @@ void metadata_free(struct agm_meta_data_gsl *metadata)
         metadata->sg_props.values = NULL;
 
         memset(metadata, 0, sizeof(struct agm_meta_data_gsl));
+        metadata_touch(metadata);
     }
 }
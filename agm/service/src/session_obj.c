@@ -46,13 +46,24 @@
 static int session_close(struct session_obj *sess_obj);
 static int session_set_loopback(struct session_obj *sess_obj,
                            uint32_t session_id, bool enable);
+static void aif_free(struct aif *aif_obj);
+static void sess_obj_free(struct session_obj *sess_obj);
+static void session_obj_retire_handle(struct session_obj *sess_obj);
 static pthread_mutex_t hwep_lock;
+#define AIF_INDEX_MIN_SIZE 16
+#define AIF_INDEX_MAX_SIZE 4096
+
 static struct aif *aif_obj_get_from_pool(struct session_obj *sess_obj,
                                       uint32_t aif)
 {
     struct listnode *node;
     struct aif *aif_node;
 
+    if (aif < sess_obj->aif_index_size)
+        return sess_obj->aif_index[aif];
+    if (aif < AIF_INDEX_MAX_SIZE)
+        return NULL;
+
     list_for_each(node, &sess_obj->aif_pool) {
         aif_node = node_to_item(node, struct aif, node);
         if (aif_node->aif_id == aif)
@@ -62,6 +73,44 @@ static struct aif *aif_obj_get_from_pool(struct session_obj *sess_obj,
     return NULL;
 }
 
+static int aif_obj_add_to_pool(struct session_obj *sess_obj,
+                               struct aif *aif_obj)
+{
+    uint32_t size = sess_obj->aif_index_size;
+    struct aif **index;
+
+    if (aif_obj->aif_id >= size && aif_obj->aif_id < AIF_INDEX_MAX_SIZE) {
+        if (!size)
+            size = AIF_INDEX_MIN_SIZE;
+        while (size <= aif_obj->aif_id)
+            size <<= 1;
+
+        index = realloc(sess_obj->aif_index, size * sizeof(struct aif *));
+        if (!index) {
+            AGM_LOGE("No memory to grow aif index to %d\n", size);
+            return -ENOMEM;
+        }
+        memset(index + sess_obj->aif_index_size, 0,
+               (size - sess_obj->aif_index_size) * sizeof(struct aif *));
+        sess_obj->aif_index = index;
+        sess_obj->aif_index_size = size;
+    }
+
+    if (aif_obj->aif_id < sess_obj->aif_index_size)
+        sess_obj->aif_index[aif_obj->aif_id] = aif_obj;
+    list_add_tail(&sess_obj->aif_pool, &aif_obj->node);
+
+    return 0;
+}
+
+static void aif_obj_remove_from_pool(struct session_obj *sess_obj,
+                                     struct aif *aif_obj)
+{
+    if (aif_obj->aif_id < sess_obj->aif_index_size)
+        sess_obj->aif_index[aif_obj->aif_id] = NULL;
+    list_remove(&aif_obj->node);
+}
+
 static struct aif* aif_obj_create(struct session_obj *sess_obj __unused, int aif_id)
 {
     struct aif *aif_obj = NULL;
@@ -104,7 +153,11 @@ int aif_obj_get(struct session_obj *sess_obj, int aif_id, struct aif **aif_obj)
             ret = -ENOMEM;
             return ret;
         }
-        list_add_tail(&sess_obj->aif_pool, &tobj->node);
+        ret = aif_obj_add_to_pool(sess_obj, tobj);
+        if (ret) {
+            aif_free(tobj);
+            return ret;
+        }
     }
 
     *aif_obj = tobj;
@@ -141,6 +194,7 @@ uint32_t aif_obj_get_count_with_state(struct session_obj *sess_obj,
 static struct agm_meta_data_gsl* session_get_merged_metadata(struct session_obj *sess_obj)
 {
     struct agm_meta_data_gsl *merged = NULL;
+    struct agm_meta_data_gsl *aif_merged = NULL;
     struct agm_meta_data_gsl *temp = NULL;
     enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
     struct listnode *node;
@@ -154,13 +208,17 @@ static struct agm_meta_data_gsl* session_get_merged_metadata(struct session_obj
                 continue;
             }
             pthread_mutex_lock(&aif_node->dev_obj->lock);
-            merged = metadata_merge(4, temp, &sess_obj->sess_meta,
-                           &aif_node->sess_aif_meta, &aif_node->dev_obj->metadata);
+            aif_merged = metadata_merge_cached(&aif_node->merged_cache, 3,
+                           &sess_obj->sess_meta, &aif_node->sess_aif_meta,
+                           &aif_node->dev_obj->metadata);
             pthread_mutex_unlock(&aif_node->dev_obj->lock);
+            merged = aif_merged ? metadata_merge(2, temp, aif_merged) : NULL;
             if (temp) {
                 metadata_free(temp);
                 free(temp);
             }
+            if (!merged)
+                return NULL;
             temp = merged;
         }
     } else {
@@ -214,6 +272,7 @@ done:
 static void aif_free(struct aif *aif_obj)
 {
     metadata_free(&aif_obj->sess_aif_meta);
+    metadata_cache_free(&aif_obj->merged_cache);
     free(aif_obj->params);
     free(aif_obj);
 }
@@ -225,9 +284,12 @@ static void aif_pool_free(struct session_obj *sess_obj)
 
     list_for_each_safe(node, next, &sess_obj->aif_pool) {
         aif_obj = node_to_item(node, struct aif, node);
-        list_remove(&aif_obj->node);
+        aif_obj_remove_from_pool(sess_obj, aif_obj);
         aif_free(aif_obj);
     }
+    free(sess_obj->aif_index);
+    sess_obj->aif_index = NULL;
+    sess_obj->aif_index_size = 0;
 }
 
 static void session_cb_pool_free(struct session_obj *sess_obj)
@@ -275,6 +337,7 @@ static void session_pool_free()
     }
     pthread_mutex_unlock(&sess_pool->lock);
     free(sess_pool);
+    sess_pool = NULL;
 }
 
 static struct session_obj* session_obj_create(int session_id)
@@ -296,38 +359,68 @@ static struct session_obj* session_obj_create(int session_id)
     return obj;
 }
 
-struct session_obj *session_obj_retrieve_from_pool(uint32_t session_id)
+static uint32_t session_id_hash(uint32_t session_id)
 {
-    struct session_obj *obj = NULL;
-    struct listnode *node;
+    return (session_id * 2654435761U) & (SESSION_HASH_SIZE - 1);
+}
 
-    pthread_mutex_lock(&sess_pool->lock);
-    list_for_each(node, &sess_pool->session_list) {
-        obj = node_to_item(node, struct session_obj, node);
-        if (obj->sess_id == session_id)
-            break;
-        else
-            obj = NULL;
+/* lock free, entries are only added and live until session_obj_deinit() */
+static struct session_obj *session_obj_lookup(uint32_t session_id)
+{
+    uint32_t i = session_id_hash(session_id);
+    struct session_obj *obj;
+    uint32_t probes;
+
+    for (probes = 0; probes < SESSION_HASH_SIZE; probes++) {
+        obj = __atomic_load_n(&sess_pool->id_hash[i], __ATOMIC_ACQUIRE);
+        if (!obj || obj->sess_id == session_id)
+            return obj;
+        i = (i + 1) & (SESSION_HASH_SIZE - 1);
     }
-    pthread_mutex_unlock(&sess_pool->lock);
 
-    return obj;
+    return NULL;
+}
+
+/* called with sess_pool lock held */
+static int session_obj_add_to_pool(struct session_obj *obj)
+{
+    uint32_t i = session_id_hash(obj->sess_id);
+
+    if (sess_pool->num_slots >= SESSION_SLOTS_MAX) {
+        AGM_LOGE("No free slot for session id:%d, %d sessions in use\n",
+                 obj->sess_id, sess_pool->num_slots);
+        return -ENOMEM;
+    }
+
+    obj->slot = sess_pool->num_slots++;
+    sess_pool->slots[obj->slot].gen = 1;
+    __atomic_store_n(&sess_pool->slots[obj->slot].obj, obj, __ATOMIC_RELEASE);
+
+    /* never more than half full, an empty entry is always found */
+    while (sess_pool->id_hash[i])
+        i = (i + 1) & (SESSION_HASH_SIZE - 1);
+    __atomic_store_n(&sess_pool->id_hash[i], obj, __ATOMIC_RELEASE);
+
+    list_add_tail(&sess_pool->session_list, &obj->node);
+    return 0;
+}
+
+struct session_obj *session_obj_retrieve_from_pool(uint32_t session_id)
+{
+    return session_obj_lookup(session_id);
 }
 
 struct session_obj *session_obj_get_from_pool(uint32_t session_id)
 {
     struct session_obj *obj = NULL;
-    struct listnode *node;
 
-    pthread_mutex_lock(&sess_pool->lock);
-    list_for_each(node, &sess_pool->session_list) {
-        obj = node_to_item(node, struct session_obj, node);
-        if (obj->sess_id == session_id)
-            break;
-        else
-            obj = NULL;
-    }
+    obj = session_obj_lookup(session_id);
+    if (obj)
+        return obj;
 
+    pthread_mutex_lock(&sess_pool->lock);
+    /* somebody else may have created it while we were not holding the lock */
+    obj = session_obj_lookup(session_id);
     if (!obj) {
         //AGM_LOGE("Couldnt find a session object in the list,
         //                             creating one\n");
@@ -336,29 +429,58 @@ struct session_obj *session_obj_get_from_pool(uint32_t session_id)
             AGM_LOGE("Couldnt create a session object\n");
             goto done;
         }
-        list_add_tail(&sess_pool->session_list, &obj->node);
+        if (session_obj_add_to_pool(obj)) {
+            sess_obj_free(obj);
+            obj = NULL;
+        }
     }
 
 done:
     pthread_mutex_unlock(&sess_pool->lock);
     return obj;
 }
-int session_obj_valid_check(uint64_t hndl)
+
+/*
+ * Handle given out by session_obj_open(): generation of the slot in the
+ * upper 32 bits, slot index in the lower ones.
+ */
+uint64_t session_obj_get_handle(struct session_obj *sess_obj)
 {
+    uint32_t gen = __atomic_load_n(&sess_pool->slots[sess_obj->slot].gen,
+                                   __ATOMIC_ACQUIRE);
 
-    struct session_obj *obj = NULL;
-    struct listnode *node;
+    return ((uint64_t)gen << 32) | sess_obj->slot;
+}
 
-    pthread_mutex_lock(&sess_pool->lock);
-    list_for_each(node, &sess_pool->session_list) {
-        obj = node_to_item(node, struct session_obj, node);
-        if (obj == hndl) {
-            pthread_mutex_unlock(&sess_pool->lock);
-            return  1;
-        }
-    }
-    pthread_mutex_unlock(&sess_pool->lock);
-    return 0;
+/* makes every handle given out so far for this session stale */
+static void session_obj_retire_handle(struct session_obj *sess_obj)
+{
+    uint32_t *gen = &sess_pool->slots[sess_obj->slot].gen;
+
+    if (__atomic_add_fetch(gen, 1, __ATOMIC_RELEASE) == 0)
+        __atomic_store_n(gen, 1, __ATOMIC_RELEASE);
+}
+
+struct session_obj *session_obj_from_handle(uint64_t hndl)
+{
+    uint32_t slot = (uint32_t)hndl;
+    uint32_t gen = (uint32_t)(hndl >> 32);
+    struct session_obj *obj;
+
+    if (!sess_pool || !gen || slot >= SESSION_SLOTS_MAX)
+        return NULL;
+
+    obj = __atomic_load_n(&sess_pool->slots[slot].obj, __ATOMIC_ACQUIRE);
+    if (!obj || __atomic_load_n(&sess_pool->slots[slot].gen,
+                                __ATOMIC_ACQUIRE) != gen)
+        return NULL;
+
+    return obj;
+}
+
+int session_obj_valid_check(uint64_t hndl)
+{
+    return session_obj_from_handle(hndl) ? 1 : 0;
 }
 
 /* returns session_obj associated with session id */
@@ -524,8 +646,9 @@ static int session_disconnect_aif(struct session_obj *sess_obj,
     struct graph_obj *graph = sess_obj->graph;
 
     pthread_mutex_lock(&aif_obj->dev_obj->lock);
-    merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                      &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+    merged_metadata = metadata_merge_cached(&aif_obj->merged_cache, 3,
+                      &sess_obj->sess_meta, &aif_obj->sess_aif_meta,
+                      &aif_obj->dev_obj->metadata);
     pthread_mutex_unlock(&aif_obj->dev_obj->lock);
     if (!merged_metadata) {
         AGM_LOGE("No memory to create merged_metadata session_id: %d, \
@@ -586,10 +709,6 @@ done:
         free(merged_meta_sess_aif);
     }
 
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
     return ret;
 }
 
@@ -705,8 +824,9 @@ static int session_connect_aif(struct session_obj *sess_obj,
 
     //step 2.a  merge metadata
     pthread_mutex_lock(&aif_obj->dev_obj->lock);
-    merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                         &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+    merged_metadata = metadata_merge_cached(&aif_obj->merged_cache, 3,
+                         &sess_obj->sess_meta, &aif_obj->sess_aif_meta,
+                         &aif_obj->dev_obj->metadata);
     pthread_mutex_unlock(&aif_obj->dev_obj->lock);
     if (!merged_metadata) {
         AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
@@ -819,10 +939,6 @@ close_device:
     device_close(aif_obj->dev_obj);
 
 done:
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
 
     return ret;
 }
@@ -1300,12 +1416,13 @@ static int session_close(struct session_obj *sess_obj)
                 free(aif_obj->tag_config);
                 aif_obj->tag_config = NULL;
             }
-            list_remove(&aif_obj->node);
+            aif_obj_remove_from_pool(sess_obj, aif_obj);
             aif_free(aif_obj);
         }
     }
     pthread_mutex_unlock(&hwep_lock);
     sess_obj->state = SESSION_CLOSED;
+    session_obj_retire_handle(sess_obj);
 done:
     AGM_LOGD("exit, ret %d", ret);
     return ret;
@@ -1514,8 +1631,9 @@ int session_obj_set_sess_aif_params_with_tag(struct session_obj *sess_obj,
         }
 
         pthread_mutex_lock(&aif_obj->dev_obj->lock);
-        merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                          &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+        merged_metadata = metadata_merge_cached(&aif_obj->merged_cache, 3,
+                          &sess_obj->sess_meta, &aif_obj->sess_aif_meta,
+                          &aif_obj->dev_obj->metadata);
         pthread_mutex_unlock(&aif_obj->dev_obj->lock);
         if (!merged_metadata) {
             AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
@@ -1555,11 +1673,6 @@ int session_obj_set_sess_aif_params_with_tag(struct session_obj *sess_obj,
     }
 
 done:
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
-
     pthread_mutex_unlock(&sess_obj->lock);
 
     return ret;
@@ -1592,8 +1705,9 @@ int session_obj_rw_acdb_params_with_tag(
     }
 
     pthread_mutex_lock(&aif_obj->dev_obj->lock);
-    merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                        &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+    merged_metadata = metadata_merge_cached(&aif_obj->merged_cache, 3,
+                        &sess_obj->sess_meta, &aif_obj->sess_aif_meta,
+                        &aif_obj->dev_obj->metadata);
     pthread_mutex_unlock(&aif_obj->dev_obj->lock);
 
     if (!merged_metadata) {
@@ -1608,7 +1722,7 @@ int session_obj_rw_acdb_params_with_tag(
                     tckv.num_kvs * sizeof(struct agm_key_value));
     if (!tckv.kv) {
         ret = -ENOMEM;
-        goto free_metadata;
+        goto error;
     }
 
     memcpy((uint8_t *)tckv.kv, acdb_param->blob,
@@ -1632,11 +1746,6 @@ int session_obj_rw_acdb_params_with_tag(
     }
     free(tckv.kv);
 
-free_metadata:
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
 error:
     pthread_mutex_unlock(&sess_obj->lock);
 
@@ -1695,8 +1804,9 @@ int session_obj_set_sess_aif_cal(struct session_obj *sess_obj,
         metadata_update_cal(&aif_obj->dev_obj->metadata, &ckv);
 
         pthread_mutex_lock(&aif_obj->dev_obj->lock);
-        merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                          &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+        merged_metadata = metadata_merge_cached(&aif_obj->merged_cache, 3,
+                          &sess_obj->sess_meta, &aif_obj->sess_aif_meta,
+                          &aif_obj->dev_obj->metadata);
         pthread_mutex_unlock(&aif_obj->dev_obj->lock);
         if (!merged_metadata) {
             AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
@@ -1729,11 +1839,6 @@ int session_obj_set_sess_aif_cal(struct session_obj *sess_obj,
     }
 
 done:
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
-
     pthread_mutex_unlock(&sess_obj->lock);
 
     return ret;
@@ -1807,8 +1912,9 @@ int session_obj_get_tag_with_module_info(struct session_obj *sess_obj,
             }
 
             pthread_mutex_lock(&aif_obj->dev_obj->lock);
-            merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                                &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+            merged_metadata = metadata_merge_cached(&aif_obj->merged_cache, 3,
+                                &sess_obj->sess_meta, &aif_obj->sess_aif_meta,
+                                &aif_obj->dev_obj->metadata);
             pthread_mutex_unlock(&aif_obj->dev_obj->lock);
             if (!merged_metadata) {
                 AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
@@ -1839,7 +1945,8 @@ int session_obj_get_tag_with_module_info(struct session_obj *sess_obj,
     }
 
 done:
-    if (merged_metadata) {
+    /* only the non tunnel merge is owned here, the aif one is cached */
+    if (merged_metadata && sess_mode == AGM_SESSION_NON_TUNNEL) {
         metadata_free(merged_metadata);
         free(merged_metadata);
     }
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Unit and benchmark test for metadata merge. The merge is checked against
+ * the reference quadratic dedup on KV sets shaped like the ones a session
+ * connect sees: stream, stream pp, device, device pp, instance and a few
+ * custom keys, with the overlap the platform config usually has.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <agm/metadata.h>
+
+#define NUM_ROUNDS 2000
+#define BENCH_ITERATIONS 200000
+
+static const uint32_t gkv_keys[] = {
+    0xA1000000, /* STREAMRX */
+    0xA2000000, /* DEVICERX */
+    0xA3000000, /* DEVICETX */
+    0xAB000000, /* INSTANCE */
+    0xAC000000, /* DEVICEPP_RX */
+    0xAD000000, /* DEVICEPP_TX */
+    0xAF000000, /* STREAMPP_RX */
+    0xB0000000, /* STREAMPP_TX */
+    0xB1000000, /* STREAMTX */
+    0xB2000000, /* VOLUME */
+    0xD2000000, /* SPK_PRO_DEV_MAP */
+    0xA5000000, /* custom */
+};
+
+static const uint32_t ckv_keys[] = {
+    0xA4000000, /* VOLUME */
+    0xA5000000, /* SAMPLINGRATE */
+    0xA6000000, /* BITWIDTH */
+    0xA7000000, /* GAIN */
+    0xAB000000, /* CHANNELS */
+};
+
+/* the dedup metadata_merge() does, kept here so a change to it is caught */
+static void ref_remove_dup_kv(struct agm_key_vector_gsl *kv_vec)
+{
+    size_t i, j, k, count = kv_vec->num_kvs;
+
+    for (i = 0; i < count; i++) {
+        for (j = i + 1; j < count; j++) {
+            if (kv_vec->kv[i].key == kv_vec->kv[j].key) {
+                for (k = j; k < count - 1; k++)
+                    kv_vec->kv[k] = kv_vec->kv[k + 1];
+                count--;
+                j--;
+            }
+        }
+    }
+    kv_vec->num_kvs = count;
+}
+
+static void ref_remove_dup_props(struct sg_prop *props)
+{
+    uint32_t i, j, k, count = props->num_values;
+
+    for (i = 0; i < count; i++) {
+        for (j = i + 1; j < count; j++) {
+            if (props->values[i] == props->values[j]) {
+                for (k = j; k < count - 1; k++)
+                    props->values[k] = props->values[k + 1];
+                count--;
+                j--;
+            }
+        }
+    }
+    props->num_values = count;
+}
+
+static struct agm_meta_data_gsl *ref_merge(int num, struct agm_meta_data_gsl **in)
+{
+    struct agm_meta_data_gsl *merged = calloc(1, sizeof(*merged));
+    int i;
+
+    for (i = 0; i < num; i++) {
+        merged->gkv.num_kvs += in[i]->gkv.num_kvs;
+        merged->ckv.num_kvs += in[i]->ckv.num_kvs;
+        merged->sg_props.num_values += in[i]->sg_props.num_values;
+    }
+    merged->gkv.kv = calloc(merged->gkv.num_kvs + 1, sizeof(struct agm_key_value));
+    merged->ckv.kv = calloc(merged->ckv.num_kvs + 1, sizeof(struct agm_key_value));
+    merged->sg_props.values = calloc(merged->sg_props.num_values + 1, sizeof(uint32_t));
+    merged->gkv.num_kvs = merged->ckv.num_kvs = merged->sg_props.num_values = 0;
+
+    for (i = 0; i < num; i++) {
+        memcpy(merged->gkv.kv + merged->gkv.num_kvs, in[i]->gkv.kv,
+               in[i]->gkv.num_kvs * sizeof(struct agm_key_value));
+        merged->gkv.num_kvs += in[i]->gkv.num_kvs;
+        memcpy(merged->ckv.kv + merged->ckv.num_kvs, in[i]->ckv.kv,
+               in[i]->ckv.num_kvs * sizeof(struct agm_key_value));
+        merged->ckv.num_kvs += in[i]->ckv.num_kvs;
+        if (in[i]->sg_props.values) {
+            merged->sg_props.prop_id = in[i]->sg_props.prop_id;
+            memcpy(merged->sg_props.values + merged->sg_props.num_values,
+                   in[i]->sg_props.values, in[i]->sg_props.num_values * sizeof(uint32_t));
+            merged->sg_props.num_values += in[i]->sg_props.num_values;
+        }
+    }
+    ref_remove_dup_kv(&merged->gkv);
+    ref_remove_dup_kv(&merged->ckv);
+    ref_remove_dup_props(&merged->sg_props);
+    return merged;
+}
+
+/* builds the payload metadata_copy() expects */
+static int fill_metadata(struct agm_meta_data_gsl *meta, uint32_t num_gkv,
+                         uint32_t num_ckv, uint32_t num_props)
+{
+    size_t size = 4 * sizeof(uint32_t) +
+                  (num_gkv + num_ckv) * sizeof(struct agm_key_value) +
+                  num_props * sizeof(uint32_t);
+    uint8_t *payload = calloc(1, size);
+    uint32_t *ptr = (uint32_t *)payload;
+    uint32_t i;
+    int ret;
+
+    *ptr++ = num_gkv;
+    for (i = 0; i < num_gkv; i++) {
+        *ptr++ = gkv_keys[rand() % (sizeof(gkv_keys) / sizeof(gkv_keys[0]))];
+        *ptr++ = rand() % 8 + 1;
+    }
+    *ptr++ = num_ckv;
+    for (i = 0; i < num_ckv; i++) {
+        *ptr++ = ckv_keys[rand() % (sizeof(ckv_keys) / sizeof(ckv_keys[0]))];
+        *ptr++ = rand() % 48000;
+    }
+    *ptr++ = 0x08000010; /* prop id */
+    *ptr++ = num_props;
+    for (i = 0; i < num_props; i++)
+        *ptr++ = rand() % 6 + 1;
+
+    metadata_free(meta);
+    ret = metadata_copy(meta, size, payload);
+    free(payload);
+    return ret;
+}
+
+static bool metadata_equal(struct agm_meta_data_gsl *a, struct agm_meta_data_gsl *b)
+{
+    if (a->gkv.num_kvs != b->gkv.num_kvs || a->ckv.num_kvs != b->ckv.num_kvs ||
+        a->sg_props.num_values != b->sg_props.num_values ||
+        a->sg_props.prop_id != b->sg_props.prop_id)
+        return false;
+
+    return !memcmp(a->gkv.kv, b->gkv.kv, a->gkv.num_kvs * sizeof(struct agm_key_value)) &&
+           !memcmp(a->ckv.kv, b->ckv.kv, a->ckv.num_kvs * sizeof(struct agm_key_value)) &&
+           !memcmp(a->sg_props.values, b->sg_props.values,
+                   a->sg_props.num_values * sizeof(uint32_t));
+}
+
+static void metadata_release(struct agm_meta_data_gsl *meta)
+{
+    metadata_free(meta);
+    free(meta);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int test_merge_matches_reference(void)
+{
+    struct agm_meta_data_gsl sess = {0}, aif = {0}, dev = {0};
+    struct agm_meta_data_gsl *in[3] = {&sess, &aif, &dev};
+    struct agm_meta_data_gsl *merged, *ref;
+    int i, failed = 0;
+
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        fill_metadata(&sess, rand() % 8, rand() % 4, rand() % 4);
+        fill_metadata(&aif, rand() % 8, rand() % 4, rand() % 4);
+        fill_metadata(&dev, rand() % 16, rand() % 6, rand() % 4);
+
+        merged = metadata_merge(3, &sess, &aif, &dev);
+        ref = ref_merge(3, in);
+        if (!merged || !metadata_equal(merged, ref)) {
+            printf("  round %d: merge differs from reference\n", i);
+            failed++;
+        }
+        if (merged)
+            metadata_release(merged);
+        metadata_release(ref);
+    }
+
+    metadata_free(&sess);
+    metadata_free(&aif);
+    metadata_free(&dev);
+    printf("%-40s %s\n", "merge matches reference", failed ? "FAIL" : "PASS");
+    return failed ? -1 : 0;
+}
+
+static int test_first_occurrence_wins(void)
+{
+    struct agm_key_value sess_kv[] = {{0xA1000000, 1}, {0xAB000000, 1}};
+    struct agm_key_value dev_kv[] = {{0xA2000000, 2}, {0xA1000000, 2}, {0xAB000000, 2}};
+    struct agm_meta_data_gsl sess = {0}, dev = {0};
+    struct agm_meta_data_gsl *merged;
+    int ret = 0;
+
+    sess.gkv.kv = sess_kv;
+    sess.gkv.num_kvs = 2;
+    dev.gkv.kv = dev_kv;
+    dev.gkv.num_kvs = 3;
+
+    merged = metadata_merge(2, &sess, &dev);
+    if (!merged || merged->gkv.num_kvs != 3 ||
+        merged->gkv.kv[0].key != 0xA1000000 || merged->gkv.kv[0].value != 1 ||
+        merged->gkv.kv[1].key != 0xAB000000 || merged->gkv.kv[1].value != 1 ||
+        merged->gkv.kv[2].key != 0xA2000000)
+        ret = -1;
+    if (merged)
+        metadata_release(merged);
+
+    printf("%-40s %s\n", "first occurrence wins, order kept", ret ? "FAIL" : "PASS");
+    return ret;
+}
+
+static int test_cache_invalidation(void)
+{
+    struct agm_meta_data_gsl sess = {0}, aif = {0}, dev = {0};
+    struct metadata_cache cache = {0};
+    struct agm_meta_data_gsl *first, *merged, *ref;
+    struct agm_meta_data_gsl *in[3] = {&sess, &aif, &dev};
+    struct agm_key_value cal_kv;
+    struct agm_key_vector_gsl cal = {1, &cal_kv};
+    int ret = 0;
+
+    fill_metadata(&sess, 4, 2, 1);
+    fill_metadata(&aif, 2, 1, 1);
+    fill_metadata(&dev, 6, 3, 2);
+
+    first = metadata_merge_cached(&cache, 3, &sess, &aif, &dev);
+    merged = metadata_merge_cached(&cache, 3, &sess, &aif, &dev);
+    if (!first || merged != first || cache.hits != 1 || cache.misses != 1) {
+        printf("  unchanged inputs were merged again\n");
+        ret = -1;
+    }
+
+    /* a cal update that changes nothing keeps the cache */
+    cal_kv.key = 0xDEAD0000;
+    cal_kv.value = 1;
+    metadata_update_cal(&dev, &cal);
+    metadata_merge_cached(&cache, 3, &sess, &aif, &dev);
+    if (cache.misses != 1) {
+        printf("  no-op cal update invalidated the cache\n");
+        ret = -1;
+    }
+
+    cal_kv.key = dev.ckv.kv[0].key;
+    cal_kv.value = dev.ckv.kv[0].value + 1;
+    metadata_update_cal(&dev, &cal);
+    merged = metadata_merge_cached(&cache, 3, &sess, &aif, &dev);
+    ref = ref_merge(3, in);
+    if (cache.misses != 2 || !merged || !metadata_equal(merged, ref)) {
+        printf("  cal update not picked up\n");
+        ret = -1;
+    }
+    metadata_release(ref);
+
+    /* freeing and copying the same content again must still invalidate */
+    fill_metadata(&aif, 3, 1, 1);
+    merged = metadata_merge_cached(&cache, 3, &sess, &aif, &dev);
+    ref = ref_merge(3, in);
+    if (cache.misses != 3 || !merged || !metadata_equal(merged, ref)) {
+        printf("  metadata copy not picked up\n");
+        ret = -1;
+    }
+    metadata_release(ref);
+
+    metadata_cache_free(&cache);
+    metadata_free(&sess);
+    metadata_free(&aif);
+    metadata_free(&dev);
+    printf("%-40s %s\n", "cache invalidated on input change", ret ? "FAIL" : "PASS");
+    return ret;
+}
+
+static void bench(uint32_t num_gkv_dev)
+{
+    struct agm_meta_data_gsl sess = {0}, aif = {0}, dev = {0};
+    struct agm_meta_data_gsl *in[3] = {&sess, &aif, &dev};
+    struct metadata_cache cache = {0};
+    uint64_t start, ref_ns, merge_ns, cached_ns;
+    int i;
+
+    fill_metadata(&sess, 6, 3, 2);
+    fill_metadata(&aif, 4, 2, 2);
+    fill_metadata(&dev, num_gkv_dev, 6, 4);
+
+    start = now_ns();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+        metadata_release(ref_merge(3, in));
+    ref_ns = now_ns() - start;
+
+    start = now_ns();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+        metadata_release(metadata_merge(3, &sess, &aif, &dev));
+    merge_ns = now_ns() - start;
+
+    start = now_ns();
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+        metadata_merge_cached(&cache, 3, &sess, &aif, &dev);
+    cached_ns = now_ns() - start;
+
+    printf("%2d input gkvs: reference %6.0f ns  merge %6.0f ns  cached %6.1f ns\n",
+           (int)(sess.gkv.num_kvs + aif.gkv.num_kvs + dev.gkv.num_kvs),
+           (double)ref_ns / BENCH_ITERATIONS, (double)merge_ns / BENCH_ITERATIONS,
+           (double)cached_ns / BENCH_ITERATIONS);
+
+    metadata_cache_free(&cache);
+    metadata_free(&sess);
+    metadata_free(&aif);
+    metadata_free(&dev);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = 0;
+
+    srand(1);
+    ret |= test_first_occurrence_wins();
+    ret |= test_merge_matches_reference();
+    ret |= test_cache_invalidation();
+
+    if (argc > 1 && !strcmp(argv[1], "-b")) {
+        bench(8);
+        bench(24);
+        bench(38);
+    }
+
+    printf("%s\n", ret ? "FAILED" : "PASSED");
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Measures the per call overhead AGM adds to find a session, by session id
+ * and by handle, with N sessions in the pool and T threads calling in
+ * concurrently like IPC clients do at buffer rate. The sessions are never
+ * opened, so the calls timed only look the session up and cache state.
+ *
+ * Before that it opens, closes and reopens one more session and checks
+ * that the public calls refuse the handle of the first open. That session
+ * uses the agm_test stream metadata and needs its graph in ACDB.
+ *
+ * usage: agm_session_bench [num_sessions] [num_threads] [iterations]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <agm/agm_api.h>
+#include <agm/session_obj.h>
+
+#define DEFAULT_SESSIONS 32
+#define DEFAULT_THREADS 4
+#define DEFAULT_ITERATIONS 1000000
+#define SESSION_ID_BASE 100
+
+/* PCM deep buffer playback, as in agm_test */
+static uint32_t stream_metadata[] = {
+    1, /* No of GKVS*/
+    0xA1000000, 0xA1000001, /*GKVS*/
+    2, /* No of CKVS*/
+    0xA5000000, 48000, 0xA6000000, 16, /*CKVS*/
+    1, /* Property ID*/
+    2, /* No of Properties*/
+    1, 2, /* Properties*/
+};
+
+struct bench_thread {
+    pthread_t thread;
+    uint32_t num_sessions;
+    uint32_t iterations;
+    uint64_t *handles;
+    uint64_t id_ns;
+    uint64_t hndl_ns;
+    uint64_t check_ns;
+    uint32_t errors;
+};
+
+#define EXPECT_STALE(call)                                          \
+    do {                                                            \
+        if ((call) != -EINVAL) {                                    \
+            printf("stale handle accepted by %s\n", #call);         \
+            errors++;                                               \
+        }                                                           \
+    } while (0)
+
+static uint32_t check_stale_handle(uint32_t session_id)
+{
+    struct agm_session_config stream_config = {0};
+    struct agm_media_config media_config = {0};
+    struct agm_buffer_config buffer_config = {0};
+    uint64_t old_hndl = 0, new_hndl = 0, timestamp;
+    uint8_t buf[64] = {0};
+    size_t count = sizeof(buf);
+    uint32_t errors = 0;
+    int ret;
+
+    ret = agm_session_set_metadata(session_id, sizeof(stream_metadata),
+                                   (uint8_t *)stream_metadata);
+    if (!ret)
+        ret = agm_session_open(session_id, AGM_SESSION_NO_CONFIG, &old_hndl);
+    if (!ret)
+        ret = agm_session_close(old_hndl);
+    if (!ret)
+        ret = agm_session_open(session_id, AGM_SESSION_NO_CONFIG, &new_hndl);
+    if (ret) {
+        printf("could not open, close and reopen session %d: %d\n",
+               session_id, ret);
+        return 1;
+    }
+
+    if (new_hndl == old_hndl) {
+        printf("reopen returned the closed handle\n");
+        errors++;
+    }
+    EXPECT_STALE(agm_session_set_config(old_hndl, &stream_config,
+                                        &media_config, &buffer_config));
+    EXPECT_STALE(agm_session_prepare(old_hndl));
+    EXPECT_STALE(agm_session_start(old_hndl));
+    EXPECT_STALE(agm_session_pause(old_hndl));
+    EXPECT_STALE(agm_session_resume(old_hndl));
+    EXPECT_STALE(agm_session_flush(old_hndl));
+    EXPECT_STALE(agm_session_stop(old_hndl));
+    EXPECT_STALE(agm_session_write(old_hndl, buf, &count));
+    EXPECT_STALE(agm_session_read(old_hndl, buf, &count));
+    EXPECT_STALE(agm_session_eos(old_hndl));
+    EXPECT_STALE(agm_get_session_time(old_hndl, &timestamp));
+    EXPECT_STALE(agm_session_close(old_hndl));
+
+    /* none of the above touched the reopened session */
+    ret = agm_session_close(new_hndl);
+    if (ret) {
+        printf("could not close reopened session %d: %d\n", session_id, ret);
+        errors++;
+    }
+    EXPECT_STALE(agm_session_close(new_hndl));
+
+    return errors;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *bench_thread_loop(void *arg)
+{
+    struct bench_thread *bt = arg;
+    struct agm_session_config stream_config = {0};
+    struct agm_media_config media_config = {0};
+    struct agm_buffer_config buffer_config = {0};
+    uint32_t i, idx;
+    uint64_t start;
+
+    start = now_ns();
+    for (i = 0; i < bt->iterations; i++) {
+        idx = (i * 7) % bt->num_sessions;
+        /* no callback registered with this cookie, only looks up the session */
+        if (agm_session_register_cb(SESSION_ID_BASE + idx, NULL,
+                                    AGM_EVENT_MODULE, bt))
+            bt->errors++;
+    }
+    bt->id_ns = now_ns() - start;
+
+    start = now_ns();
+    for (i = 0; i < bt->iterations; i++) {
+        idx = (i * 7) % bt->num_sessions;
+        /* on a closed session this only caches the config */
+        if (agm_session_set_config(bt->handles[idx], &stream_config,
+                                   &media_config, &buffer_config))
+            bt->errors++;
+    }
+    bt->hndl_ns = now_ns() - start;
+
+    start = now_ns();
+    for (i = 0; i < bt->iterations; i++) {
+        idx = (i * 7) % bt->num_sessions;
+        if (!session_obj_valid_check(bt->handles[idx]))
+            bt->errors++;
+    }
+    bt->check_ns = now_ns() - start;
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_sessions = DEFAULT_SESSIONS;
+    uint32_t num_threads = DEFAULT_THREADS;
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    struct bench_thread *threads;
+    struct session_obj *sess_obj;
+    uint64_t *handles;
+    uint64_t id_ns = 0, hndl_ns = 0, check_ns = 0;
+    uint32_t i, errors = 0;
+    int ret;
+
+    if (argc > 1)
+        num_sessions = atoi(argv[1]);
+    if (argc > 2)
+        num_threads = atoi(argv[2]);
+    if (argc > 3)
+        iterations = atoi(argv[3]);
+    if (!num_sessions || !num_threads || !iterations) {
+        printf("usage: %s [num_sessions] [num_threads] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    ret = agm_init();
+    if (ret) {
+        printf("agm_init failed %d\n", ret);
+        return 1;
+    }
+
+    handles = calloc(num_sessions, sizeof(uint64_t));
+    threads = calloc(num_threads, sizeof(struct bench_thread));
+    if (!handles || !threads) {
+        printf("no memory\n");
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num_sessions; i++) {
+        ret = session_obj_get(SESSION_ID_BASE + i, &sess_obj);
+        if (ret) {
+            printf("could not create session %d: %d\n", SESSION_ID_BASE + i, ret);
+            goto done;
+        }
+        handles[i] = session_obj_get_handle(sess_obj);
+    }
+
+    errors += check_stale_handle(SESSION_ID_BASE + num_sessions);
+
+    for (i = 0; i < num_threads; i++) {
+        threads[i].num_sessions = num_sessions;
+        threads[i].iterations = iterations;
+        threads[i].handles = handles;
+        pthread_create(&threads[i].thread, NULL, bench_thread_loop, &threads[i]);
+    }
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i].thread, NULL);
+        id_ns += threads[i].id_ns;
+        hndl_ns += threads[i].hndl_ns;
+        check_ns += threads[i].check_ns;
+        errors += threads[i].errors;
+    }
+
+    printf("%d sessions %d threads: by id %.1f ns/call, by handle %.1f ns/call "
+           "(handle check %.1f ns), %d errors\n",
+           num_sessions, num_threads,
+           (double)id_ns / ((uint64_t)num_threads * iterations),
+           (double)hndl_ns / ((uint64_t)num_threads * iterations),
+           (double)check_ns / ((uint64_t)num_threads * iterations), errors);
+    ret = errors ? -EINVAL : 0;
+
+done:
+    free(threads);
+    free(handles);
+    agm_deinit();
+    return ret ? 1 : 0;
+}
@@ -63,6 +63,9 @@ LOCAL_SRC_FILES := \
     AudioStream.cpp \
     AudioDevice.cpp \
     AudioVoice.cpp \
+    PcmKernels.cpp \
+    LatencyHistogram.cpp \
+    DataPathGate.cpp \
     audio_extn/soundtrigger.cpp \
     audio_extn/Gain.cpp \
     audio_extn/AudioExtn.cpp
@@ -109,3 +112,40 @@ endif
 endif
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := PcmKernelsBench
+LOCAL_MODULE_OWNER := qti
+LOCAL_SRC_FILES := \
+    PcmKernels.cpp \
+    test/PcmKernelsBench.cpp
+LOCAL_CFLAGS := -Wall -Werror -O2
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# the same bench on the device, where the NEON kernels are built
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := PcmKernelsBench
+LOCAL_MODULE_OWNER := qti
+LOCAL_MODULE_TAGS := optional
+LOCAL_VENDOR_MODULE := true
+LOCAL_SRC_FILES := \
+    PcmKernels.cpp \
+    test/PcmKernelsBench.cpp
+LOCAL_CFLAGS := -Wall -Werror -O2
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := DataPathGateTest
+LOCAL_MODULE_OWNER := qti
+LOCAL_SRC_FILES := \
+    DataPathGate.cpp \
+    test/DataPathGateTest.cpp
+LOCAL_CFLAGS := -Wall -Werror -O1
+LOCAL_SANITIZE := thread
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -83,6 +83,7 @@
 #include <audio_effects/effect_ns.h>
 #include "audio_extn.h"
 #include <audio_utils/format.h>
+#include "PcmKernels.h"
 
 #define COMPRESS_OFFLOAD_FRAGMENT_SIZE (32 * 1024)
 #define FLAC_COMPRESS_OFFLOAD_FRAGMENT_SIZE (256 * 1024)
@@ -106,6 +107,46 @@ static bool is_pcm_format(audio_format_t format)
     return false;
 }
 
+/* Format conversion of the write path, the common cases go through the
+ * vectorized PcmKernels and the rest through audio_utils.
+ */
+static void convert_pcm_format(void *dst, audio_format_t dstFormat, const void *src,
+                               audio_format_t srcFormat, size_t samples)
+{
+    if (srcFormat == AUDIO_FORMAT_PCM_FLOAT && dstFormat == AUDIO_FORMAT_PCM_32_BIT)
+        pcm_i32_from_float((int32_t *)dst, (const float *)src, samples);
+    else if (srcFormat == AUDIO_FORMAT_PCM_16_BIT && dstFormat == AUDIO_FORMAT_PCM_32_BIT)
+        pcm_i32_from_i16((int32_t *)dst, (const int16_t *)src, samples);
+    else if (srcFormat == AUDIO_FORMAT_PCM_32_BIT && dstFormat == AUDIO_FORMAT_PCM_16_BIT)
+        pcm_i16_from_i32((int16_t *)dst, (const int32_t *)src, samples);
+    else if (srcFormat == AUDIO_FORMAT_PCM_24_BIT_PACKED && dstFormat == AUDIO_FORMAT_PCM_32_BIT)
+        pcm_i32_from_p24((int32_t *)dst, (const uint8_t *)src, samples);
+    else
+        memcpy_by_audio_format(dst, dstFormat, src, srcFormat, samples);
+}
+
+static int64_t monotonic_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* playback/capture duration of a PCM buffer, 0 for compressed formats */
+static int64_t buffer_duration_ns(size_t bytes, audio_format_t format, uint32_t channels,
+                                  uint32_t sampleRate)
+{
+    size_t frameSize;
+
+    if (!audio_has_proportional_frames(format) || !sampleRate)
+        return 0;
+    frameSize = audio_bytes_per_frame(channels, format);
+    if (!frameSize)
+        return 0;
+    return (int64_t)(bytes / frameSize) * 1000000000LL / sampleRate;
+}
+
 static int get_hdr_mode() {
     std::shared_ptr<AudioDevice> adevice = AudioDevice::GetInstance();
     if (property_get_bool("vendor.audio.hdr.spf.record.enable", false)) {
@@ -368,7 +409,7 @@ static int32_t pal_callback(pal_stream_handle_t *stream_handle,
         {
             std::lock_guard<std::mutex> drain_guard (astream_out->drain_wait_mutex_);
             astream_out->drain_ready_ = true;
-            astream_out->sendGaplessMetadata = true;
+            astream_out->RequestGaplessMetadata();
             AHAL_DBG("received PARTIAL DRAIN_READY event");
             (astream_out->drain_condition_).notify_all();
             event = STREAM_CBK_EVENT_DRAIN_READY;
@@ -700,11 +741,40 @@ static int astream_out_standby(struct audio_stream *stream) {
     return ret;
 }
 
-static int astream_dump(const struct audio_stream *stream, int fd) {
-    std::ignore = stream;
-    std::ignore = fd;
-    AHAL_DBG("dump function not implemented");
-    return 0;
+static int astream_out_dump(const struct audio_stream *stream, int fd) {
+    std::shared_ptr<AudioDevice> adevice = AudioDevice::GetInstance();
+    std::shared_ptr<StreamOutPrimary> astream_out;
+
+    if (!adevice) {
+        AHAL_ERR("unable to get audio device");
+        return -EINVAL;
+    }
+
+    astream_out = adevice->OutGetStream((audio_stream_t*)stream);
+    if (!astream_out) {
+        AHAL_ERR("unable to get audio stream");
+        return -EINVAL;
+    }
+
+    return astream_out->Dump(fd);
+}
+
+static int astream_in_dump(const struct audio_stream *stream, int fd) {
+    std::shared_ptr<AudioDevice> adevice = AudioDevice::GetInstance();
+    std::shared_ptr<StreamInPrimary> astream_in;
+
+    if (!adevice) {
+        AHAL_ERR("unable to get audio device");
+        return -EINVAL;
+    }
+
+    astream_in = adevice->InGetStream((audio_stream_t*)stream);
+    if (!astream_in) {
+        AHAL_ERR("unable to get audio stream");
+        return -EINVAL;
+    }
+
+    return astream_in->Dump(fd);
 }
 #ifdef USEHIDL7_1
 static int astream_set_latency_mode(struct audio_stream_out *stream, audio_latency_mode_t mode) {
@@ -1947,7 +2017,7 @@ int StreamOutPrimary::FillHalFnPtrs() {
     stream_.get()->common.get_format = astream_out_get_format;
     stream_.get()->common.set_format = astream_set_format;
     stream_.get()->common.standby = astream_out_standby;
-    stream_.get()->common.dump = astream_dump;
+    stream_.get()->common.dump = astream_out_dump;
     stream_.get()->common.set_parameters = astream_out_set_parameters;
     stream_.get()->common.get_parameters = astream_out_get_parameters;
     stream_.get()->common.add_audio_effect = astream_out_add_audio_effect;
@@ -2063,7 +2133,7 @@ int StreamOutPrimary::Stop() {
     int ret = -ENOSYS;
 
     AHAL_INFO("Enter: OutPrimary usecase(%d: %s)", GetUseCase(), use_case_table[GetUseCase()]);
-    stream_mutex_.lock();
+    LockDataPath();
     if (usecase_ == USECASE_AUDIO_PLAYBACK_MMAP &&
             pal_stream_handle_ && stream_started_) {
 
@@ -2071,9 +2141,10 @@ int StreamOutPrimary::Stop() {
         if (ret == 0) {
             stream_started_ = false;
             stream_paused_ = false;
+            PostDataPathUpdate(DATA_PATH_RECONFIG);
         }
     }
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("Exit ret: %d", ret);
     return ret;
 }
@@ -2102,7 +2173,7 @@ int StreamOutPrimary::Pause() {
 
     AHAL_INFO("Enter: usecase(%d: %s)", GetUseCase(), use_case_table[GetUseCase()]);
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (!pal_stream_handle_ || !stream_started_) {
         AHAL_DBG("Stream not started yet");
         ret = -1;
@@ -2127,7 +2198,7 @@ int StreamOutPrimary::Pause() {
     }
 
 exit:
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("Exit ret: %d", ret);
     return ret;
 }
@@ -2137,7 +2208,7 @@ int StreamOutPrimary::Resume() {
 
     AHAL_INFO("Enter: usecase(%d: %s)", GetUseCase(), use_case_table[GetUseCase()]);
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (!pal_stream_handle_ || !stream_started_) {
         AHAL_DBG("Stream not started yet");
         ret = -1;
@@ -2154,7 +2225,7 @@ int StreamOutPrimary::Resume() {
     }
 
 exit:
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("Exit ret: %d", ret);
     return ret;
 }
@@ -2163,7 +2234,7 @@ int StreamOutPrimary::Flush() {
     int ret = 0;
     AHAL_INFO("Enter: usecase(%d: %s)", GetUseCase(), use_case_table[GetUseCase()]);
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (pal_stream_handle_) {
         if(stream_paused_ == true)
         {
@@ -2179,7 +2250,8 @@ int StreamOutPrimary::Flush() {
         mBytesWritten = 0;
     }
     sendGaplessMetadata = true;
-    stream_mutex_.unlock();
+    PostDataPathUpdate(DATA_PATH_RECONFIG);
+    UnlockDataPath();
 
     if (ret)
         ret = -EINVAL;
@@ -2205,10 +2277,10 @@ int StreamOutPrimary::Drain(audio_drain_type_t type) {
            return -EINVAL;
     }
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (pal_stream_handle_)
         ret = pal_stream_drain(pal_stream_handle_, palDrainType);
-    stream_mutex_.unlock();
+    UnlockDataPath();
 
     if (ret) {
         AHAL_ERR("Invalid drain type:%d", type);
@@ -2217,6 +2289,12 @@ int StreamOutPrimary::Drain(audio_drain_type_t type) {
     return ret;
 }
 
+void StreamOutPrimary::RequestGaplessMetadata()
+{
+    sendGaplessMetadata = true;
+    PostDataPathUpdate(DATA_PATH_RECONFIG);
+}
+
 void StreamOutPrimary::UpdatemCachedPosition(uint64_t val)
 {
     mCachedPosition = val;
@@ -2226,7 +2304,7 @@ int StreamOutPrimary::Standby() {
     int ret = 0;
 
     AHAL_DBG("Enter");
-    stream_mutex_.lock();
+    LockDataPath();
     if (pal_stream_handle_) {
         if (streamAttributes_.type == PAL_STREAM_PCM_OFFLOAD) {
             /*
@@ -2260,6 +2338,7 @@ int StreamOutPrimary::Standby() {
     stream_started_ = false;
     stream_paused_ = false;
     sendGaplessMetadata = true;
+    PostDataPathUpdate(DATA_PATH_RECONFIG);
     if (CheckOffloadEffectsType(streamAttributes_.type)) {
         ret = StopOffloadEffects(handle_, pal_stream_handle_);
         ret = StopOffloadVisualizer(handle_, pal_stream_handle_);
@@ -2271,11 +2350,11 @@ int StreamOutPrimary::Standby() {
         if (usecase_ == USECASE_AUDIO_PLAYBACK_WITH_HAPTICS && pal_haptics_stream_handle) {
             ret = pal_stream_close(pal_haptics_stream_handle);
             pal_haptics_stream_handle = NULL;
-            if (hapticBuffer) {
-                free (hapticBuffer);
-                hapticBuffer = NULL;
+            if (splitBuffer) {
+                free (splitBuffer);
+                splitBuffer = NULL;
             }
-            hapticsBufSize = 0;
+            splitBufferFrames = 0;
             if (hapticsDevice) {
                 free(hapticsDevice);
                 hapticsDevice = NULL;
@@ -2305,7 +2384,7 @@ int StreamOutPrimary::Standby() {
         ret = -EINVAL;
 
 exit:
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("Exit ret: %d", ret);
     return ret;
 }
@@ -2323,7 +2402,7 @@ int StreamOutPrimary::RouteStream(const std::set<audio_devices_t>& new_devices,
     bool *payload_hifiFilter = &isHifiFilterEnabled;
     size_t param_size = 0;
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (!mInitialized) {
         AHAL_ERR("Not initialized, returning error");
         ret = -EINVAL;
@@ -2478,7 +2557,7 @@ done:
         free(device_cap_query);
         device_cap_query = NULL;
     }
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("exit %d", ret);
     return ret;
 }
@@ -2513,6 +2592,8 @@ int StreamOutPrimary::SetParameters(struct str_parms *parms) {
             AHAL_ERR("parse_compress_metadata Error (%x)", ret);
             goto error;
         }
+        if (isCompressMetadataAvail)
+            PostDataPathUpdate(DATA_PATH_RECONFIG);
 
         ret1 = str_parms_get_str(parms, AUDIO_OFFLOAD_CODEC_DELAY_SAMPLES, value, sizeof(value));
         if (ret1 >= 0 ) {
@@ -2574,11 +2655,20 @@ int StreamOutPrimary::SetVolume(float left , float right) {
         volume_->volume_pair[1].vol = right;
     }
 
-    /* if stream is not opened already cache the volume and set on open */
+    /* if stream is not opened already cache the volume and set on open,
+     * a buffer in flight applies it once written.
+     */
     if (pal_stream_handle_) {
-        ret = pal_stream_set_volume(pal_stream_handle_, volume_);
-        if (ret) {
-            AHAL_ERR("Pal Stream volume Error (%x)", ret);
+        PostDataPathUpdate(DATA_PATH_VOLUME);
+        /* a buffer in flight applies it when it is done */
+        if (dataPath_.claimIfIdle()) {
+            if (TakeDataPathUpdate(DATA_PATH_VOLUME)) {
+                ret = pal_stream_set_volume(pal_stream_handle_, volume_);
+                if (ret) {
+                    AHAL_ERR("Pal Stream volume Error (%x)", ret);
+                }
+            }
+            dataPath_.unclaim();
         }
     }
 
@@ -3158,6 +3248,22 @@ int StreamOutPrimary::Open() {
         if (ret) {
             AHAL_ERR("Pal Stream set buffer size Error  (%x)", ret);
         }
+
+        /* audio and haptics halves the write path splits into, a period at a time */
+        if (splitBuffer)
+            free(splitBuffer);
+        splitBufferFrames = LOW_LATENCY_PLAYBACK_PERIOD_SIZE;
+        splitBuffer = (uint8_t *)calloc(splitBufferFrames, audio_bytes_per_frame(
+                    audio_channel_count_from_out_mask(config_.channel_mask),
+                    config_.format));
+        if (!splitBuffer) {
+            splitBufferFrames = 0;
+            ret = -ENOMEM;
+            AHAL_ERR("haptics split buffer allocation failed. ret %d", ret);
+            goto error_open;
+        }
+        AHAL_DBG("haptics split buffer of %zu frames, %s kernels", splitBufferFrames,
+                 pcm_kernels_isa());
     }
 
 error_open:
@@ -3255,63 +3361,51 @@ int StreamOutPrimary::GetOutputUseCase(audio_output_flags_t halStreamFlags)
 ssize_t StreamOutPrimary::splitAndWriteAudioHapticsStream(const void *buffer, size_t bytes)
 {
      ssize_t ret = 0;
-     bool allocHapticsBuffer = false;
      struct pal_buffer audioBuf;
      struct pal_buffer hapticBuf;
-     size_t srcIndex = 0, audIndex = 0, hapIndex = 0;
+     const uint8_t *src = (const uint8_t *)buffer;
      uint8_t channelCount = audio_channel_count_from_out_mask(config_.channel_mask);
      uint8_t bytesPerSample = audio_bytes_per_sample(config_.format);
      uint32_t frameSize = channelCount * bytesPerSample;
      uint32_t frameCount = bytes / frameSize;
+     size_t frames;
 
-     // Calculate Haptics Buffer size
      uint8_t hapticsChannelCount = hapticsStreamAttributes.out_media_config.ch_info.channels;
      uint32_t hapticsFrameSize = bytesPerSample * hapticsChannelCount;
      uint32_t audioFrameSize = frameSize - hapticsFrameSize;
-     uint32_t totalHapticsBufferSize = frameCount * hapticsFrameSize;
-
-     if (!hapticBuffer) {
-         allocHapticsBuffer = true;
-     } else if (hapticsBufSize < totalHapticsBufferSize) {
-         if (hapticBuffer)
-             free (hapticBuffer);
-         allocHapticsBuffer = true;
-         hapticsBufSize = 0;
-     }
 
-     if (allocHapticsBuffer) {
-         hapticBuffer = (uint8_t *)calloc(1, totalHapticsBufferSize);
-         if(!hapticBuffer) {
-             AHAL_ERR("Failed to allocate mem for haptic buffer");
-             return -ENOMEM;
-         }
-         hapticsBufSize = totalHapticsBufferSize;
+     if (!splitBuffer) {
+         AHAL_ERR("haptics split buffer not allocated");
+         return -ENOMEM;
      }
 
-     audioBuf.buffer = (uint8_t *)buffer;
-     audioBuf.size = frameCount * audioFrameSize;
+     audioBuf.buffer = splitBuffer;
      audioBuf.offset = 0;
-     hapticBuf.buffer  = hapticBuffer;
-     hapticBuf.size = frameCount * hapticsFrameSize;
+     hapticBuf.buffer = splitBuffer + splitBufferFrames * audioFrameSize;
      hapticBuf.offset = 0;
 
-     for (size_t i = 0; i < frameCount; i++) {
-         memcpy((uint8_t *)(audioBuf.buffer) + audIndex, (uint8_t *)(audioBuf.buffer) + srcIndex,
-                audioFrameSize);
-         audIndex += audioFrameSize;
-         srcIndex += audioFrameSize;
-
-         memcpy((uint8_t *)(hapticBuf.buffer) + hapIndex, (uint8_t *)(audioBuf.buffer) + srcIndex,
-                    hapticsFrameSize);
-         hapIndex += hapticsFrameSize;
-         srcIndex += hapticsFrameSize;
+     // split into the buffer allocated at Open(), the client buffer stays untouched
+     while (frameCount > 0) {
+         frames = frameCount < splitBufferFrames ? frameCount : splitBufferFrames;
+         pcm_split_channels(audioBuf.buffer, hapticBuf.buffer, src, frames,
+                            channelCount - hapticsChannelCount, hapticsChannelCount,
+                            bytesPerSample);
+         audioBuf.size = frames * audioFrameSize;
+         hapticBuf.size = frames * hapticsFrameSize;
+
+         // write audio data
+         ret = pal_stream_write(pal_stream_handle_, &audioBuf);
+         if (ret < 0)
+             break;
+         // write haptics data
+         ret = pal_stream_write(pal_haptics_stream_handle, &hapticBuf);
+         if (ret < 0)
+             break;
+
+         src += frames * frameSize;
+         frameCount -= frames;
      }
 
-     // write audio data
-     ret = pal_stream_write(pal_stream_handle_, &audioBuf);
-     // write haptics data
-     ret = pal_stream_write(pal_haptics_stream_handle, &hapticBuf);
-
      return (ret < 0 ? ret : bytes);
 }
 
@@ -3468,6 +3562,8 @@ ssize_t StreamOutPrimary::write(const void *buffer, size_t bytes)
     ssize_t ret = 0;
     struct pal_buffer palBuffer;
     uint32_t frames;
+    bool locked;
+    int64_t startNs, palStartNs = 0, palEndNs = 0, endNs;
 
     palBuffer.buffer = (uint8_t*)buffer;
     palBuffer.size = bytes;
@@ -3475,16 +3571,19 @@ ssize_t StreamOutPrimary::write(const void *buffer, size_t bytes)
 
     AHAL_VERBOSE("handle_ %x bytes:(%zu)", handle_, bytes);
 
-    stream_mutex_.lock();
-    ret = configurePalOutputStream();
-    if (ret < 0)
-        goto exit;
+    startNs = monotonic_ns();
+    locked = AcquireDataPath();
+    if (locked) {
+        ret = configurePalOutputStream();
+        if (ret < 0)
+            goto exit;
+    }
     ATRACE_BEGIN("hal: pal_stream_write");
     if (halInputFormat != halOutputFormat && convertBuffer != NULL) {
         if (bytes > fragment_size_) {
             AHAL_ERR("Error written bytes %zu > %d (fragment_size)", bytes, fragment_size_);
             ATRACE_END();
-            stream_mutex_.unlock();
+            ReleaseDataPath(locked);
             return -EINVAL;
         }
         /* prevent division-by-zero */
@@ -3494,22 +3593,28 @@ ssize_t StreamOutPrimary::write(const void *buffer, size_t bytes)
         if (inputBitWidth == 0 || outputBitWidth == 0) {
             AHAL_ERR("Error inputBitWidth %u, outputBitWidth %u", inputBitWidth, outputBitWidth);
             ATRACE_END();
-            stream_mutex_.unlock();
+            ReleaseDataPath(locked);
             return -EINVAL;
         }
 
         frames = bytes / (inputBitWidth / 8);
-        memcpy_by_audio_format(convertBuffer, halOutputFormat, buffer, halInputFormat, frames);
+        convert_pcm_format(convertBuffer, halOutputFormat, buffer, halInputFormat, frames);
         palBuffer.buffer = (uint8_t *)convertBuffer;
         palBuffer.size = frames * (outputBitWidth / 8);
+        palStartNs = monotonic_ns();
         ret = pal_stream_write(pal_stream_handle_, &palBuffer);
+        palEndNs = monotonic_ns();
         if (ret >= 0) {
             ret = (ret * inputBitWidth) / outputBitWidth;
         }
     } else if (usecase_ == USECASE_AUDIO_PLAYBACK_WITH_HAPTICS && pal_haptics_stream_handle) {
+        palStartNs = monotonic_ns();
         ret = splitAndWriteAudioHapticsStream(buffer, bytes);
+        palEndNs = monotonic_ns();
     } else {
+        palStartNs = monotonic_ns();
         ret = pal_stream_write(pal_stream_handle_, &palBuffer);
+        palEndNs = monotonic_ns();
     }
     ATRACE_END();
 
@@ -3519,12 +3624,38 @@ exit:
     } else {
         mBytesWritten = UINT64_MAX;
     }
-    stream_mutex_.unlock();
+    ReleaseDataPath(locked);
     clock_gettime(CLOCK_MONOTONIC, &writeAt);
 
+    endNs = (int64_t)writeAt.tv_sec * 1000000000LL + writeAt.tv_nsec;
+    writeTime_.record(endNs - startNs);
+    if (palEndNs)
+        palWriteTime_.record(palEndNs - palStartNs);
+    /* a locked write follows standby or a reconfiguration, no jitter sample */
+    if (!locked && lastWriteNs_ && lastWriteDurationNs_ && ret >= 0)
+        writeJitter_.record(llabs(startNs - lastWriteNs_ - lastWriteDurationNs_));
+    lastWriteNs_ = ret < 0 ? 0 : startNs;
+    lastWriteDurationNs_ = buffer_duration_ns(bytes, config_.format,
+            audio_channel_count_from_out_mask(config_.channel_mask), config_.sample_rate);
+
     return (ret < 0 ? onWriteError(bytes, ret) : ret);
 }
 
+bool StreamOutPrimary::IsDataPathReady()
+{
+    return pal_stream_handle_ && stream_started_;
+}
+
+int StreamOutPrimary::Dump(int fd)
+{
+    dprintf(fd, "  StreamOut handle %d usecase %s\n", handle_, use_case_table[usecase_]);
+    DumpDataPath(fd);
+    writeTime_.dump(fd);
+    palWriteTime_.dump(fd);
+    writeJitter_.dump(fd);
+    return 0;
+}
+
 bool StreamOutPrimary::CheckOffloadEffectsType(pal_stream_type_t pal_stream_type) {
     if (pal_stream_type == PAL_STREAM_COMPRESSED  ||
         pal_stream_type == PAL_STREAM_PCM_OFFLOAD) {
@@ -3676,8 +3807,8 @@ StreamOutPrimary::StreamOutPrimary(
     mPalOutDevice = nullptr;
     convertBuffer = NULL;
     hapticsDevice = NULL;
-    hapticBuffer = NULL;
-    hapticsBufSize = 0;
+    splitBuffer = NULL;
+    splitBufferFrames = 0;
     writeAt.tv_sec = 0;
     writeAt.tv_nsec = 0;
     mBytesWritten = 0;
@@ -3863,7 +3994,7 @@ StreamOutPrimary::~StreamOutPrimary() {
     AHAL_DBG("close stream, handle(%x), pal_stream_handle (%p)",
           handle_, pal_stream_handle_);
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (pal_stream_handle_) {
         if (CheckOffloadEffectsType(streamAttributes_.type)) {
             StopOffloadEffects(handle_, pal_stream_handle_);
@@ -3877,11 +4008,11 @@ StreamOutPrimary::~StreamOutPrimary() {
     if (pal_haptics_stream_handle) {
         pal_stream_close(pal_haptics_stream_handle);
         pal_haptics_stream_handle = NULL;
-        if (hapticBuffer) {
-            free (hapticBuffer);
-            hapticBuffer = NULL;
+        if (splitBuffer) {
+            free (splitBuffer);
+            splitBuffer = NULL;
         }
-        hapticsBufSize = 0;
+        splitBufferFrames = 0;
     }
 
     if (convertBuffer)
@@ -3898,7 +4029,7 @@ StreamOutPrimary::~StreamOutPrimary() {
         free(hapticsDevice);
         hapticsDevice = NULL;
     }
-    stream_mutex_.unlock();
+    UnlockDataPath();
 }
 
 bool StreamInPrimary::isDeviceAvailable(pal_device_id_t deviceId)
@@ -3933,15 +4064,17 @@ int StreamInPrimary::Stop() {
     int ret = -ENOSYS;
 
     AHAL_INFO("Enter: InPrimary usecase(%d: %s)", GetUseCase(), use_case_table[GetUseCase()]);
-    stream_mutex_.lock();
+    LockDataPath();
     if (usecase_ == USECASE_AUDIO_RECORD_MMAP &&
             pal_stream_handle_ && stream_started_) {
 
         ret = pal_stream_stop(pal_stream_handle_);
-        if (ret == 0)
+        if (ret == 0) {
             stream_started_ = false;
+            PostDataPathUpdate(DATA_PATH_RECONFIG);
+        }
     }
-    stream_mutex_.unlock();
+    UnlockDataPath();
     return ret;
 }
 
@@ -4031,7 +4164,7 @@ int StreamInPrimary::Standby() {
     std::shared_ptr<AudioDevice> adevice = AudioDevice::GetInstance();
 
     AHAL_DBG("Enter");
-    stream_mutex_.lock();
+    LockDataPath();
     if (pal_stream_handle_) {
         if (!is_st_session) {
             ret = pal_stream_stop(pal_stream_handle_);
@@ -4045,6 +4178,7 @@ int StreamInPrimary::Standby() {
     }
     effects_applied_ = true;
     stream_started_ = false;
+    PostDataPathUpdate(DATA_PATH_RECONFIG);
 
     if (pal_stream_handle_ && !is_st_session) {
         ret = pal_stream_close(pal_stream_handle_);
@@ -4059,7 +4193,7 @@ int StreamInPrimary::Standby() {
     if (ret)
         ret = -EINVAL;
 
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("Exit ret: %d", ret);
     return ret;
 }
@@ -4156,6 +4290,7 @@ int StreamInPrimary::addRemoveAudioEffect(const struct audio_stream *stream __un
 exit:
     if (status) {
        effects_applied_ = false;
+       PostDataPathUpdate(DATA_PATH_RECONFIG);
     } else
        effects_applied_ = true;
 
@@ -4253,7 +4388,7 @@ int StreamInPrimary::RouteStream(const std::set<audio_devices_t>& new_devices, b
 
     AHAL_INFO("Enter: InPrimary usecase(%d: %s)", GetUseCase(), use_case_table[GetUseCase()]);
 
-    stream_mutex_.lock();
+    LockDataPath();
     if (!mInitialized){
         AHAL_ERR("Not initialized, returning error");
         ret = -EINVAL;
@@ -4391,7 +4526,7 @@ done:
         free(device_cap_query);
         device_cap_query = NULL;
     }
-    stream_mutex_.unlock();
+    UnlockDataPath();
     AHAL_DBG("exit %d", ret);
     return ret;
 }
@@ -4795,6 +4930,8 @@ ssize_t StreamInPrimary::read(const void *buffer, size_t bytes) {
     int retry_count = MAX_READ_RETRY_COUNT;
     ssize_t size = 0;
     struct pal_buffer palBuffer;
+    bool locked;
+    int64_t startNs, palStartNs = 0, palEndNs = 0, endNs;
 
     palBuffer.buffer = (uint8_t *)buffer;
     palBuffer.size = bytes;
@@ -4802,7 +4939,11 @@ ssize_t StreamInPrimary::read(const void *buffer, size_t bytes) {
     std::shared_ptr<AudioDevice> adevice = AudioDevice::GetInstance();
     AHAL_VERBOSE("requested bytes: %zu", bytes);
 
-    stream_mutex_.lock();
+    startNs = monotonic_ns();
+    locked = AcquireDataPath();
+    if (!locked)
+        goto pal_read;
+
     if (!pal_stream_handle_) {
         AutoPerfLock perfLock;
         ret = Open();
@@ -4880,7 +5021,10 @@ ssize_t StreamInPrimary::read(const void *buffer, size_t bytes) {
        effects_applied_ = true;
     }
 
+pal_read:
+    palStartNs = monotonic_ns();
     ret = pal_stream_read(pal_stream_handle_, &palBuffer);
+    palEndNs = monotonic_ns();
     AHAL_VERBOSE("received size= %d",palBuffer.size);
     if (usecase_ == USECASE_AUDIO_RECORD_COMPRESS && ret > 0) {
         size = palBuffer.size;
@@ -4900,12 +5044,38 @@ exit:
     } else {
         mBytesRead = UINT64_MAX;
     }
-    stream_mutex_.unlock();
+    ReleaseDataPath(locked);
     clock_gettime(CLOCK_MONOTONIC, &readAt);
+
+    endNs = (int64_t)readAt.tv_sec * 1000000000LL + readAt.tv_nsec;
+    readTime_.record(endNs - startNs);
+    if (palEndNs)
+        palReadTime_.record(palEndNs - palStartNs);
+    /* a locked read follows standby or a reconfiguration, no jitter sample */
+    if (!locked && lastReadNs_ && lastReadDurationNs_ && ret >= 0)
+        readJitter_.record(llabs(startNs - lastReadNs_ - lastReadDurationNs_));
+    lastReadNs_ = ret < 0 ? 0 : startNs;
+    lastReadDurationNs_ = buffer_duration_ns(bytes, config_.format,
+            audio_channel_count_from_in_mask(config_.channel_mask), config_.sample_rate);
     AHAL_VERBOSE("Exit: returning size: %zu size ", size);
     return (ret < 0 ? onReadError(bytes, ret) : (size > 0 ? size : bytes));
 }
 
+bool StreamInPrimary::IsDataPathReady()
+{
+    return pal_stream_handle_ && stream_started_ && effects_applied_ && !is_st_session;
+}
+
+int StreamInPrimary::Dump(int fd)
+{
+    dprintf(fd, "  StreamIn handle %d usecase %s\n", handle_, use_case_table[usecase_]);
+    DumpDataPath(fd);
+    readTime_.dump(fd);
+    palReadTime_.dump(fd);
+    readJitter_.dump(fd);
+    return 0;
+}
+
 int StreamInPrimary::FillHalFnPtrs() {
     int ret = 0;
 
@@ -4916,7 +5086,7 @@ int StreamInPrimary::FillHalFnPtrs() {
     stream_.get()->common.get_format = astream_in_get_format;
     stream_.get()->common.set_format = astream_set_format;
     stream_.get()->common.standby = astream_in_standby;
-    stream_.get()->common.dump = astream_dump;
+    stream_.get()->common.dump = astream_in_dump;
     stream_.get()->common.set_parameters = astream_in_set_parameters;
     stream_.get()->common.get_parameters = astream_in_get_parameters;
     stream_.get()->common.add_audio_effect = astream_in_add_audio_effect;
@@ -5193,7 +5363,7 @@ error:
 }
 
 StreamInPrimary::~StreamInPrimary() {
-    stream_mutex_.lock();
+    LockDataPath();
     if (pal_stream_handle_ && !is_st_session) {
         AHAL_DBG("close stream, pal_stream_handle (%p)",
              pal_stream_handle_);
@@ -5208,7 +5378,7 @@ StreamInPrimary::~StreamInPrimary() {
         free(mPalInDevice);
         mPalInDevice = NULL;
     }
-    stream_mutex_.unlock();
+    UnlockDataPath();
 }
 
 StreamPrimary::StreamPrimary(audio_io_handle_t handle,
@@ -5241,3 +5411,24 @@ StreamPrimary::~StreamPrimary(void)
     }
 }
 
+
+/* Ends the read()/write() started by AcquireDataPath() and applies what was
+ * posted while the buffer was in flight.
+ */
+void StreamPrimary::ReleaseDataPath(bool locked)
+{
+    int ret = 0;
+
+    if (!dataPath_.release(locked))
+        return;
+
+    if (TakeDataPathUpdate(DATA_PATH_VOLUME) && pal_stream_handle_ && volume_) {
+        ret = pal_stream_set_volume(pal_stream_handle_, volume_);
+        if (ret) {
+            AHAL_ERR("Pal Stream volume Error (%x)", ret);
+        }
+    }
+    if (!IsDataPathReady())
+        PostDataPathUpdate(DATA_PATH_RECONFIG);
+    stream_mutex_.unlock();
+}
@@ -78,6 +78,10 @@
 #include <mutex>
 #include <map>
 #include <unordered_map>
+#include <atomic>
+#include <condition_variable>
+#include "DataPathGate.h"
+#include "LatencyHistogram.h"
 
 #define LOW_LATENCY_PLATFORM_DELAY (13*1000LL)
 #define DEEP_BUFFER_PLATFORM_DELAY (29*1000LL)
@@ -507,6 +511,28 @@ public:
                             struct str_parms *query, struct str_parms *reply);
     virtual int RouteStream(const std::set<audio_devices_t>&, bool force_device_switch = false) = 0;
 protected:
+    /*
+     * read()/write() run without stream_mutex_ while nothing is pending.
+     * Calls that stop, close or re-route the PAL handle, or otherwise
+     * change what the data path uses (standby, flush, pause, drain,
+     * routing, destruction) take LockDataPath(), which waits for the
+     * buffer in flight. Other updates are posted and picked up at the
+     * next buffer boundary, under stream_mutex_. See DataPathGate.
+     */
+    enum {
+        DATA_PATH_RECONFIG = DataPathGate::RECONFIG,
+        DATA_PATH_VOLUME   = DataPathGate::VOLUME,
+    };
+    bool AcquireDataPath() { return dataPath_.acquire(); }
+    void ReleaseDataPath(bool locked);
+    void LockDataPath() { dataPath_.lock(); }
+    void UnlockDataPath() { dataPath_.unlock(); }
+    void PostDataPathUpdate(uint32_t update) { dataPath_.post(update); }
+    bool TakeDataPathUpdate(uint32_t update) { return dataPath_.take(update); }
+    virtual bool IsDataPathReady() = 0;
+    void DumpDataPath(int fd) { dataPath_.dump(fd); }
+    DataPathGate dataPath_{stream_mutex_};
+
     struct pal_stream_attributes streamAttributes_;
     pal_stream_handle_t*      pal_stream_handle_;
     audio_io_handle_t         handle_;
@@ -547,6 +573,8 @@ public:
     ~StreamOutPrimary();
     bool sendGaplessMetadata = true;
     bool isCompressMetadataAvail = false;
+    /* next write() sends the gapless metadata, from PAL callbacks too */
+    void RequestGaplessMetadata();
     void UpdatemCachedPosition(uint64_t val);
     int Standby();
     int SetVolume(float left, float right);
@@ -560,6 +588,7 @@ public:
     int Stop();
     ssize_t write(const void *buffer, size_t bytes);
     int Open();
+    int Dump(int fd);
     void GetStreamHandle(audio_stream_out** stream);
     uint32_t GetBufferSize();
     uint32_t GetBufferSizeForLowLatency();
@@ -583,6 +612,7 @@ public:
     std::vector<playback_track_metadata_t> tracks;
     int SetAggregateSourceMetadata(bool voice_active);
 protected:
+    bool IsDataPathReady();
     struct timespec writeAt;
     int get_compressed_buffer_size();
     int get_pcm_buffer_size();
@@ -596,7 +626,7 @@ protected:
     uint32_t msample_rate;
     uint16_t mchannels;
     std::shared_ptr<audio_stream_out>   stream_;
-    uint64_t mBytesWritten; /* total bytes written, not cleared when entering standby */
+    std::atomic<uint64_t> mBytesWritten; /* total bytes written, not cleared when entering standby */
     uint64_t mCachedPosition = 0; /* cache pcm offload position when entering standby */
     offload_effects_start_output fnp_offload_effect_start_output_ = nullptr;
     offload_effects_stop_output fnp_offload_effect_stop_output_ = nullptr;
@@ -608,8 +638,14 @@ protected:
     pal_stream_handle_t* pal_haptics_stream_handle;
     AudioExtn AudExtn;
     struct pal_device* hapticsDevice;
-    uint8_t* hapticBuffer;
-    size_t hapticsBufSize;
+    uint8_t* splitBuffer;       /* audio half followed by haptics half */
+    size_t splitBufferFrames;
+    //Latency telemetry, updated by the writing thread only
+    LatencyHistogram writeTime_{"write"};
+    LatencyHistogram palWriteTime_{"pal write"};
+    LatencyHistogram writeJitter_{"write jitter"};
+    int64_t lastWriteNs_ = 0;
+    int64_t lastWriteDurationNs_ = 0;
 
     int FillHalFnPtrs();
     friend class AudioDevice;
@@ -641,6 +677,7 @@ public:
     int Stop();
     int SetMicMute(bool mute);
     ssize_t read(const void *buffer, size_t bytes);
+    int Dump(int fd);
     uint32_t GetBufferSize();
     uint32_t GetBufferSizeForLowLatencyRecord();
     pal_stream_type_t GetPalStreamType(audio_input_flags_t halStreamFlags,
@@ -661,6 +698,7 @@ public:
     std::vector<record_track_metadata_t> tracks;
     int SetAggregateSinkMetadata(bool voice_active);
 protected:
+    bool IsDataPathReady();
     struct timespec readAt;
     uint32_t fragments_ = 0;
     uint32_t fragment_size_ = 0;
@@ -668,16 +706,22 @@ protected:
     std::shared_ptr<audio_stream_in>    stream_;
     audio_source_t                      source_;
     friend class AudioDevice;
-    uint64_t mBytesRead = 0; /* total bytes read, not cleared when entering standby */
+    std::atomic<uint64_t> mBytesRead{0}; /* total bytes read, not cleared when entering standby */
     /**
      * number of successful compress read calls
      * correlate to number of PCM frames read in
      * compress record usecase
      * */
-    uint64_t mCompressReadCalls = 0;
+    std::atomic<uint64_t> mCompressReadCalls{0};
     bool isECEnabled = false;
     bool isNSEnabled = false;
     bool effects_applied_ = true;
     pal_snd_enc_t palSndEnc;
+    //Latency telemetry, updated by the reading thread only
+    LatencyHistogram readTime_{"read"};
+    LatencyHistogram palReadTime_{"pal read"};
+    LatencyHistogram readJitter_{"read jitter"};
+    int64_t lastReadNs_ = 0;
+    int64_t lastReadDurationNs_ = 0;
 };
 #endif  // ANDROID_HARDWARE_AHAL_ASTREAM_H_
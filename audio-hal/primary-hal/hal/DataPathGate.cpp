@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "DataPathGate.h"
+
+/*
+ * busy_ and lockers_ are each stored before the other is loaded, all
+ * sequentially consistent, so a writer and a locker never both miss
+ * each other.
+ */
+DataPathGate::DataPathGate(std::mutex &lock)
+    : lock_(lock)
+{
+}
+
+void DataPathGate::wakeLockers()
+{
+    if (lockers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        idleCond_.notify_all();
+    }
+}
+
+bool DataPathGate::acquire()
+{
+    busy_.store(true);
+    if (pending_.load() == 0 && lockers_.load() == 0) {
+        lockFreeBuffers_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    busy_.store(false);
+    wakeLockers();
+
+    lock_.lock();
+    take(RECONFIG);
+    lockedBuffers_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool DataPathGate::release(bool locked)
+{
+    if (locked)
+        return true;
+
+    busy_.store(false);
+    wakeLockers();
+    if (!(pending_.load() & VOLUME))
+        return false;
+    lock_.lock();
+    return true;
+}
+
+void DataPathGate::lock()
+{
+    lockers_.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idleCond_.wait(lock, [this] { return !busy_.load(); });
+    }
+    lock_.lock();
+}
+
+void DataPathGate::unlock()
+{
+    lock_.unlock();
+    lockers_.fetch_sub(1);
+}
+
+bool DataPathGate::claimIfIdle()
+{
+    lockers_.fetch_add(1);
+    if (!busy_.load())
+        return true;
+    lockers_.fetch_sub(1);
+    return false;
+}
+
+void DataPathGate::unclaim()
+{
+    lockers_.fetch_sub(1);
+}
+
+void DataPathGate::dump(int fd)
+{
+    dprintf(fd, "    buffers: %" PRIu64 " lock free, %" PRIu64 " locked, pending 0x%x\n",
+            lockFreeBuffers_.load(std::memory_order_relaxed),
+            lockedBuffers_.load(std::memory_order_relaxed), pending_.load());
+}
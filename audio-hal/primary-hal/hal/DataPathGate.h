@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef DATA_PATH_GATE_H
+#define DATA_PATH_GATE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+/*
+ * Lets the one thread doing read()/write() on a stream reach PAL without
+ * the stream mutex while nothing is pending. Calls that change what the
+ * data path uses take lock(), which waits for the buffer in flight. Other
+ * updates are posted and picked up at the next buffer boundary, under the
+ * stream mutex.
+ */
+class DataPathGate {
+public:
+    enum {
+        RECONFIG = 0x1,  /* stream needs open, start or metadata */
+        VOLUME   = 0x2,  /* cached volume not yet applied */
+    };
+
+    explicit DataPathGate(std::mutex &lock);
+
+    /*
+     * Claims the data path for one buffer. Returns false when it may go to
+     * PAL lock free, true when an update is pending, the caller then holds
+     * the stream mutex and RECONFIG has been taken.
+     */
+    bool acquire();
+    /*
+     * Ends the buffer. Returns true when the caller holds the stream
+     * mutex, either from acquire() or because VOLUME was posted meanwhile,
+     * and has to apply the updates and unlock it.
+     */
+    bool release(bool locked);
+    /* stream mutex with no buffer in flight */
+    void lock();
+    void unlock();
+    /*
+     * With the stream mutex held: returns true when no buffer is in
+     * flight, a writer then waits for the mutex until unclaim(). Otherwise
+     * the buffer in flight picks up what was posted when it is released.
+     */
+    bool claimIfIdle();
+    void unclaim();
+
+    void post(uint32_t update) { pending_.fetch_or(update); }
+    bool take(uint32_t update) { return (pending_.fetch_and(~update) & update) != 0; }
+    void dump(int fd);
+
+private:
+    void wakeLockers();
+
+    std::mutex &lock_;
+    std::atomic<uint32_t> pending_{RECONFIG};
+    std::atomic<uint32_t> lockers_{0};
+    std::atomic<bool> busy_{false};
+    std::mutex idleMutex_;
+    std::condition_variable idleCond_;
+    std::atomic<uint64_t> lockFreeBuffers_{0};
+    std::atomic<uint64_t> lockedBuffers_{0};
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram(const char *name)
+    : name_(name), count_(0), sumUs_(0), maxUs_(0)
+{
+    for (int i = 0; i < kNumBuckets; i++)
+        buckets_[i].store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(int64_t ns)
+{
+    uint64_t us = ns > 0 ? (uint64_t)ns / 1000 : 0;
+    int bucket = us ? 64 - __builtin_clzll(us) : 0;
+
+    if (bucket >= kNumBuckets)
+        bucket = kNumBuckets - 1;
+    add(buckets_[bucket], 1);
+    add(count_, 1);
+    add(sumUs_, us);
+    if (us > maxUs_.load(std::memory_order_relaxed))
+        maxUs_.store(us, std::memory_order_relaxed);
+}
+
+/* upper bound of the bucket holding the given percentile */
+uint64_t LatencyHistogram::percentileUs(uint64_t count, int percent) const
+{
+    uint64_t target = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < kNumBuckets; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return (uint64_t)1 << i;
+    }
+    return (uint64_t)1 << (kNumBuckets - 1);
+}
+
+void LatencyHistogram::dump(int fd) const
+{
+    uint64_t count = count_.load(std::memory_order_relaxed);
+    uint64_t n;
+
+    if (!count) {
+        dprintf(fd, "    %s: no samples\n", name_);
+        return;
+    }
+    dprintf(fd, "    %s: %" PRIu64 " samples, mean %" PRIu64 " us, max %" PRIu64
+            " us, p50 <%" PRIu64 " us, p90 <%" PRIu64 " us, p99 <%" PRIu64 " us\n",
+            name_, count, sumUs_.load(std::memory_order_relaxed) / count,
+            maxUs_.load(std::memory_order_relaxed), percentileUs(count, 50),
+            percentileUs(count, 90), percentileUs(count, 99));
+    for (int i = 0; i < kNumBuckets; i++) {
+        n = buckets_[i].load(std::memory_order_relaxed);
+        if (n)
+            dprintf(fd, "      <%-8" PRIu64 " us %" PRIu64 "\n", (uint64_t)1 << i, n);
+    }
+}
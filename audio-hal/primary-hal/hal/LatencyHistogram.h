@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <atomic>
+
+/*
+ * Log2 histogram of durations in microseconds, bucket n holds values in
+ * [2^(n-1), 2^n) us. Recording takes no lock and is meant for the one
+ * thread doing read()/write() on a stream, dump() may run concurrently.
+ */
+class LatencyHistogram {
+public:
+    static const int kNumBuckets = 24;
+
+    explicit LatencyHistogram(const char *name);
+    void record(int64_t ns);
+    void dump(int fd) const;
+
+private:
+    uint64_t percentileUs(uint64_t count, int percent) const;
+    static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    const char *name_;
+    std::atomic<uint64_t> buckets_[kNumBuckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sumUs_;
+    std::atomic<uint64_t> maxUs_;
+};
+
+#endif
@@ -0,0 +1,550 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string.h>
+#include "PcmKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PCM_KERNELS_AVX2
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_KERNELS_SSE2
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PCM_KERNELS_SSSE3
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PCM_KERNELS_NEON
+#endif
+
+typedef void (*split_fn)(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames);
+typedef void (*merge_fn)(uint8_t *dst, const uint8_t *audio, const uint8_t *haptic,
+                         size_t frames);
+
+/*
+ * Scalar kernels. With the frame layout known at compile time the copies
+ * become plain (vector) register moves instead of memcpy calls.
+ */
+template <size_t A, size_t H>
+static void split_fixed(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        memcpy(audio, src, A);
+        memcpy(haptic, src + A, H);
+        audio += A;
+        haptic += H;
+        src += A + H;
+    }
+}
+
+template <size_t A, size_t H>
+static void merge_fixed(uint8_t *dst, const uint8_t *audio, const uint8_t *haptic, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        memcpy(dst, audio, A);
+        memcpy(dst + A, haptic, H);
+        audio += A;
+        haptic += H;
+        dst += A + H;
+    }
+}
+
+static void split_any(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames,
+                      size_t a, size_t h)
+{
+    for (size_t i = 0; i < frames; i++) {
+        memcpy(audio, src, a);
+        memcpy(haptic, src + a, h);
+        audio += a;
+        haptic += h;
+        src += a + h;
+    }
+}
+
+static void merge_any(uint8_t *dst, const uint8_t *audio, const uint8_t *haptic, size_t frames,
+                      size_t a, size_t h)
+{
+    for (size_t i = 0; i < frames; i++) {
+        memcpy(dst, audio, a);
+        memcpy(dst + a, haptic, h);
+        audio += a;
+        haptic += h;
+        dst += a + h;
+    }
+}
+
+/*
+ * 4 byte audio + 4 byte haptic frames: 16 bit 2+2, 32 bit 1+1.
+ */
+static void split_4_4(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_AVX2)
+    const __m256i idx = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    for (; i + 8 <= frames; i += 8) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(src + i * 8));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + i * 8 + 32));
+        v0 = _mm256_permutevar8x32_epi32(v0, idx);
+        v1 = _mm256_permutevar8x32_epi32(v1, idx);
+        _mm256_storeu_si256((__m256i *)(audio + i * 4), _mm256_permute2x128_si256(v0, v1, 0x20));
+        _mm256_storeu_si256((__m256i *)(haptic + i * 4), _mm256_permute2x128_si256(v0, v1, 0x31));
+    }
+#endif
+#if defined(PCM_KERNELS_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(src + i * 8));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + i * 8 + 16));
+        v0 = _mm_shuffle_epi32(v0, _MM_SHUFFLE(3, 1, 2, 0));
+        v1 = _mm_shuffle_epi32(v1, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(audio + i * 4), _mm_unpacklo_epi64(v0, v1));
+        _mm_storeu_si128((__m128i *)(haptic + i * 4), _mm_unpackhi_epi64(v0, v1));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        uint32x4x2_t v = vld2q_u32((const uint32_t *)(src + i * 8));
+        vst1q_u32((uint32_t *)(audio + i * 4), v.val[0]);
+        vst1q_u32((uint32_t *)(haptic + i * 4), v.val[1]);
+    }
+#endif
+    split_fixed<4, 4>(audio + i * 4, haptic + i * 4, src + i * 8, frames - i);
+}
+
+static void merge_4_4(uint8_t *dst, const uint8_t *audio, const uint8_t *haptic, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_AVX2)
+    for (; i + 8 <= frames; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(audio + i * 4));
+        __m256i h = _mm256_loadu_si256((const __m256i *)(haptic + i * 4));
+        __m256i lo = _mm256_unpacklo_epi32(a, h);
+        __m256i hi = _mm256_unpackhi_epi32(a, h);
+        _mm256_storeu_si256((__m256i *)(dst + i * 8), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + i * 8 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+#endif
+#if defined(PCM_KERNELS_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(audio + i * 4));
+        __m128i h = _mm_loadu_si128((const __m128i *)(haptic + i * 4));
+        _mm_storeu_si128((__m128i *)(dst + i * 8), _mm_unpacklo_epi32(a, h));
+        _mm_storeu_si128((__m128i *)(dst + i * 8 + 16), _mm_unpackhi_epi32(a, h));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        uint32x4x2_t v;
+        v.val[0] = vld1q_u32((const uint32_t *)(audio + i * 4));
+        v.val[1] = vld1q_u32((const uint32_t *)(haptic + i * 4));
+        vst2q_u32((uint32_t *)(dst + i * 8), v);
+    }
+#endif
+    merge_fixed<4, 4>(dst + i * 8, audio + i * 4, haptic + i * 4, frames - i);
+}
+
+/*
+ * 8 byte audio + 8 byte haptic frames: 32 bit 2+2, 16 bit 4+4.
+ */
+static void split_8_8(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_AVX2)
+    for (; i + 4 <= frames; i += 4) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(src + i * 16));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + i * 16 + 32));
+        v0 = _mm256_permute4x64_epi64(v0, _MM_SHUFFLE(3, 1, 2, 0));
+        v1 = _mm256_permute4x64_epi64(v1, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(audio + i * 8), _mm256_permute2x128_si256(v0, v1, 0x20));
+        _mm256_storeu_si256((__m256i *)(haptic + i * 8), _mm256_permute2x128_si256(v0, v1, 0x31));
+    }
+#endif
+#if defined(PCM_KERNELS_SSE2)
+    for (; i + 2 <= frames; i += 2) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(src + i * 16));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + i * 16 + 16));
+        _mm_storeu_si128((__m128i *)(audio + i * 8), _mm_unpacklo_epi64(v0, v1));
+        _mm_storeu_si128((__m128i *)(haptic + i * 8), _mm_unpackhi_epi64(v0, v1));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 2 <= frames; i += 2) {
+        uint64x2_t v0 = vld1q_u64((const uint64_t *)(src + i * 16));
+        uint64x2_t v1 = vld1q_u64((const uint64_t *)(src + i * 16 + 16));
+        vst1q_u64((uint64_t *)(audio + i * 8), vcombine_u64(vget_low_u64(v0), vget_low_u64(v1)));
+        vst1q_u64((uint64_t *)(haptic + i * 8), vcombine_u64(vget_high_u64(v0), vget_high_u64(v1)));
+    }
+#endif
+    split_fixed<8, 8>(audio + i * 8, haptic + i * 8, src + i * 16, frames - i);
+}
+
+static void merge_8_8(uint8_t *dst, const uint8_t *audio, const uint8_t *haptic, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_AVX2)
+    for (; i + 4 <= frames; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(audio + i * 8));
+        __m256i h = _mm256_loadu_si256((const __m256i *)(haptic + i * 8));
+        __m256i lo = _mm256_unpacklo_epi64(a, h);
+        __m256i hi = _mm256_unpackhi_epi64(a, h);
+        _mm256_storeu_si256((__m256i *)(dst + i * 16), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + i * 16 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+#endif
+#if defined(PCM_KERNELS_SSE2)
+    for (; i + 2 <= frames; i += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(audio + i * 8));
+        __m128i h = _mm_loadu_si128((const __m128i *)(haptic + i * 8));
+        _mm_storeu_si128((__m128i *)(dst + i * 16), _mm_unpacklo_epi64(a, h));
+        _mm_storeu_si128((__m128i *)(dst + i * 16 + 16), _mm_unpackhi_epi64(a, h));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 2 <= frames; i += 2) {
+        uint64x2_t a = vld1q_u64((const uint64_t *)(audio + i * 8));
+        uint64x2_t h = vld1q_u64((const uint64_t *)(haptic + i * 8));
+        vst1q_u64((uint64_t *)(dst + i * 16), vcombine_u64(vget_low_u64(a), vget_low_u64(h)));
+        vst1q_u64((uint64_t *)(dst + i * 16 + 16), vcombine_u64(vget_high_u64(a), vget_high_u64(h)));
+    }
+#endif
+    merge_fixed<8, 8>(dst + i * 16, audio + i * 8, haptic + i * 8, frames - i);
+}
+
+/*
+ * 4 byte audio + 2 byte haptic frames: 16 bit 2+1, the common haptics
+ * layout.
+ */
+static void split_4_2(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_SSSE3)
+    const __m128i a0m0 = _mm_setr_epi8(0, 1, 2, 3, 6, 7, 8, 9, 12, 13, 14, 15, -1, -1, -1, -1);
+    const __m128i a0m1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 4, 5);
+    const __m128i a1m1 = _mm_setr_epi8(8, 9, 10, 11, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i a1m2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 0, 1, 4, 5, 6, 7, 10, 11, 12, 13);
+    const __m128i hm0 = _mm_setr_epi8(4, 5, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i hm1 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, 6, 7, 12, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i hm2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 8, 9, 14, 15);
+    for (; i + 8 <= frames; i += 8) {
+        __m128i r0 = _mm_loadu_si128((const __m128i *)(src + i * 6));
+        __m128i r1 = _mm_loadu_si128((const __m128i *)(src + i * 6 + 16));
+        __m128i r2 = _mm_loadu_si128((const __m128i *)(src + i * 6 + 32));
+        _mm_storeu_si128((__m128i *)(audio + i * 4),
+                         _mm_or_si128(_mm_shuffle_epi8(r0, a0m0), _mm_shuffle_epi8(r1, a0m1)));
+        _mm_storeu_si128((__m128i *)(audio + i * 4 + 16),
+                         _mm_or_si128(_mm_shuffle_epi8(r1, a1m1), _mm_shuffle_epi8(r2, a1m2)));
+        _mm_storeu_si128((__m128i *)(haptic + i * 2),
+                         _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r0, hm0),
+                                                   _mm_shuffle_epi8(r1, hm1)),
+                                      _mm_shuffle_epi8(r2, hm2)));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 8 <= frames; i += 8) {
+        uint16x8x3_t v = vld3q_u16((const uint16_t *)(src + i * 6));
+        uint16x8x2_t a;
+        a.val[0] = v.val[0];
+        a.val[1] = v.val[1];
+        vst2q_u16((uint16_t *)(audio + i * 4), a);
+        vst1q_u16((uint16_t *)(haptic + i * 2), v.val[2]);
+    }
+#endif
+    split_fixed<4, 2>(audio + i * 4, haptic + i * 2, src + i * 6, frames - i);
+}
+
+static void merge_4_2(uint8_t *dst, const uint8_t *audio, const uint8_t *haptic, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_SSSE3)
+    const __m128i o0a0 = _mm_setr_epi8(0, 1, 2, 3, -1, -1, 4, 5, 6, 7, -1, -1, 8, 9, 10, 11);
+    const __m128i o0h = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1);
+    const __m128i o1a0 = _mm_setr_epi8(-1, -1, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i o1a1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3, -1, -1, 4, 5);
+    const __m128i o1h = _mm_setr_epi8(4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1);
+    const __m128i o2a1 = _mm_setr_epi8(6, 7, -1, -1, 8, 9, 10, 11, -1, -1, 12, 13, 14, 15, -1, -1);
+    const __m128i o2h = _mm_setr_epi8(-1, -1, 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15);
+    for (; i + 8 <= frames; i += 8) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(audio + i * 4));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(audio + i * 4 + 16));
+        __m128i h = _mm_loadu_si128((const __m128i *)(haptic + i * 2));
+        _mm_storeu_si128((__m128i *)(dst + i * 6),
+                         _mm_or_si128(_mm_shuffle_epi8(a0, o0a0), _mm_shuffle_epi8(h, o0h)));
+        _mm_storeu_si128((__m128i *)(dst + i * 6 + 16),
+                         _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, o1a0),
+                                                   _mm_shuffle_epi8(a1, o1a1)),
+                                      _mm_shuffle_epi8(h, o1h)));
+        _mm_storeu_si128((__m128i *)(dst + i * 6 + 32),
+                         _mm_or_si128(_mm_shuffle_epi8(a1, o2a1), _mm_shuffle_epi8(h, o2h)));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 8 <= frames; i += 8) {
+        uint16x8x2_t a = vld2q_u16((const uint16_t *)(audio + i * 4));
+        uint16x8x3_t v;
+        v.val[0] = a.val[0];
+        v.val[1] = a.val[1];
+        v.val[2] = vld1q_u16((const uint16_t *)(haptic + i * 2));
+        vst3q_u16((uint16_t *)(dst + i * 6), v);
+    }
+#endif
+    merge_fixed<4, 2>(dst + i * 6, audio + i * 4, haptic + i * 2, frames - i);
+}
+
+struct layout_kernel {
+    uint16_t audioBytes;
+    uint16_t hapticBytes;
+    split_fn split;
+    merge_fn merge;
+};
+
+#define FIXED_KERNEL(a, h) { a, h, split_fixed<a, h>, merge_fixed<a, h> }
+
+/* audio + haptic frame sizes for 1, 2 and 8 audio channels with one or two
+ * haptic channels at 16, 24 and 32 bit
+ */
+static const struct layout_kernel layoutKernels[] = {
+    { 4, 4, split_4_4, merge_4_4 },
+    { 8, 8, split_8_8, merge_8_8 },
+    { 4, 2, split_4_2, merge_4_2 },
+    FIXED_KERNEL(2, 2),
+    FIXED_KERNEL(2, 4),
+    FIXED_KERNEL(4, 8),
+    FIXED_KERNEL(16, 2),
+    FIXED_KERNEL(16, 4),
+    FIXED_KERNEL(3, 3),
+    FIXED_KERNEL(3, 6),
+    FIXED_KERNEL(6, 3),
+    FIXED_KERNEL(6, 6),
+    FIXED_KERNEL(24, 3),
+    FIXED_KERNEL(24, 6),
+    FIXED_KERNEL(8, 4),
+    FIXED_KERNEL(32, 4),
+    FIXED_KERNEL(32, 8),
+};
+
+static const struct layout_kernel *find_kernel(size_t audioBytes, size_t hapticBytes)
+{
+    for (size_t i = 0; i < sizeof(layoutKernels) / sizeof(layoutKernels[0]); i++) {
+        if (layoutKernels[i].audioBytes == audioBytes &&
+            layoutKernels[i].hapticBytes == hapticBytes)
+            return &layoutKernels[i];
+    }
+    return NULL;
+}
+
+void pcm_split_channels(void *audio, void *haptic, const void *src, size_t frames,
+                        uint32_t audioChannels, uint32_t hapticChannels,
+                        uint32_t bytesPerSample)
+{
+    size_t a = audioChannels * bytesPerSample;
+    size_t h = hapticChannels * bytesPerSample;
+    const struct layout_kernel *kernel = find_kernel(a, h);
+
+    if (kernel)
+        kernel->split((uint8_t *)audio, (uint8_t *)haptic, (const uint8_t *)src, frames);
+    else
+        split_any((uint8_t *)audio, (uint8_t *)haptic, (const uint8_t *)src, frames, a, h);
+}
+
+void pcm_merge_channels(void *dst, const void *audio, const void *haptic, size_t frames,
+                        uint32_t audioChannels, uint32_t hapticChannels,
+                        uint32_t bytesPerSample)
+{
+    size_t a = audioChannels * bytesPerSample;
+    size_t h = hapticChannels * bytesPerSample;
+    const struct layout_kernel *kernel = find_kernel(a, h);
+
+    if (kernel)
+        kernel->merge((uint8_t *)dst, (const uint8_t *)audio, (const uint8_t *)haptic, frames);
+    else
+        merge_any((uint8_t *)dst, (const uint8_t *)audio, (const uint8_t *)haptic, frames, a, h);
+}
+
+/*
+ * Same rounding as clamp32_from_float(): saturate outside [-1, 1), scale
+ * by 2^31 and round half away from zero. The vector versions add +-0.5 in
+ * float and truncate, which rounds the same way from 0.5 up to 2^23. Above
+ * that every float is an integer already, below 0.5 the result is 0 but the
+ * float sum of the largest such value ties up to 1, so both ranges are
+ * truncated as is.
+ */
+static inline int32_t i32_from_float(float f)
+{
+    if (f <= -1.0f)
+        return INT32_MIN;
+    if (f >= 1.0f)
+        return INT32_MAX;
+    f *= 2147483648.0f;
+    return f > 0 ? f + 0.5 : f - 0.5;
+}
+
+void pcm_i32_from_float(int32_t *dst, const float *src, size_t samples)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_AVX2)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 minusOne = _mm256_set1_ps(-1.0f);
+        const __m256 scale = _mm256_set1_ps(2147483648.0f);
+        const __m256 exact = _mm256_set1_ps(8388608.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        const __m256i maxv = _mm256_set1_epi32(INT32_MAX);
+        const __m256i minv = _mm256_set1_epi32(INT32_MIN);
+        for (; i + 8 <= samples; i += 8) {
+            __m256 f = _mm256_loadu_ps(src + i);
+            __m256 s = _mm256_mul_ps(f, scale);
+            __m256 r = _mm256_add_ps(s, _mm256_or_ps(_mm256_and_ps(s, sign), half));
+            __m256 a = _mm256_andnot_ps(sign, s);
+            __m256 asis = _mm256_or_ps(_mm256_cmp_ps(a, exact, _CMP_GE_OQ),
+                                       _mm256_cmp_ps(a, half, _CMP_LT_OQ));
+            __m256i v = _mm256_cvttps_epi32(_mm256_blendv_ps(r, s, asis));
+            v = _mm256_blendv_epi8(v, maxv,
+                                   _mm256_castps_si256(_mm256_cmp_ps(f, one, _CMP_GE_OQ)));
+            v = _mm256_blendv_epi8(v, minv,
+                                   _mm256_castps_si256(_mm256_cmp_ps(f, minusOne, _CMP_LE_OQ)));
+            _mm256_storeu_si256((__m256i *)(dst + i), v);
+        }
+    }
+#endif
+#if defined(PCM_KERNELS_SSE2)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minusOne = _mm_set1_ps(-1.0f);
+        const __m128 scale = _mm_set1_ps(2147483648.0f);
+        const __m128 exact = _mm_set1_ps(8388608.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128i maxv = _mm_set1_epi32(INT32_MAX);
+        const __m128i minv = _mm_set1_epi32(INT32_MIN);
+        for (; i + 4 <= samples; i += 4) {
+            __m128 f = _mm_loadu_ps(src + i);
+            __m128 s = _mm_mul_ps(f, scale);
+            __m128 r = _mm_add_ps(s, _mm_or_ps(_mm_and_ps(s, sign), half));
+            __m128 a = _mm_andnot_ps(sign, s);
+            __m128 asis = _mm_or_ps(_mm_cmpge_ps(a, exact), _mm_cmplt_ps(a, half));
+            __m128i v = _mm_cvttps_epi32(_mm_or_ps(_mm_and_ps(asis, s), _mm_andnot_ps(asis, r)));
+            __m128i hi = _mm_castps_si128(_mm_cmpge_ps(f, one));
+            __m128i lo = _mm_castps_si128(_mm_cmple_ps(f, minusOne));
+            v = _mm_or_si128(_mm_and_si128(hi, maxv), _mm_andnot_si128(hi, v));
+            v = _mm_or_si128(_mm_and_si128(lo, minv), _mm_andnot_si128(lo, v));
+            _mm_storeu_si128((__m128i *)(dst + i), v);
+        }
+    }
+#elif defined(PCM_KERNELS_NEON)
+    {
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+        const float32x4_t scale = vdupq_n_f32(2147483648.0f);
+        const float32x4_t exact = vdupq_n_f32(8388608.0f);
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        const float32x4_t minusHalf = vdupq_n_f32(-0.5f);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        for (; i + 4 <= samples; i += 4) {
+            float32x4_t f = vld1q_f32(src + i);
+            float32x4_t s = vmulq_f32(f, scale);
+            float32x4_t r = vaddq_f32(s, vbslq_f32(vcgtq_f32(s, zero), half, minusHalf));
+            float32x4_t a = vabsq_f32(s);
+            r = vbslq_f32(vorrq_u32(vcgeq_f32(a, exact), vcltq_f32(a, half)), s, r);
+            int32x4_t v = vcvtq_s32_f32(r);
+            v = vbslq_s32(vcgeq_f32(f, one), vdupq_n_s32(INT32_MAX), v);
+            v = vbslq_s32(vcleq_f32(f, minusOne), vdupq_n_s32(INT32_MIN), v);
+            vst1q_s32(dst + i, v);
+        }
+    }
+#endif
+    for (; i < samples; i++)
+        dst[i] = i32_from_float(src[i]);
+}
+
+void pcm_i32_from_i16(int32_t *dst, const int16_t *src, size_t samples)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_AVX2)
+    for (; i + 16 <= samples; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i lo = _mm256_slli_epi32(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v)), 16);
+        __m256i hi = _mm256_slli_epi32(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1)), 16);
+        _mm256_storeu_si256((__m256i *)(dst + i), lo);
+        _mm256_storeu_si256((__m256i *)(dst + i + 8), hi);
+    }
+#endif
+#if defined(PCM_KERNELS_SSE2)
+    for (; i + 8 <= samples; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(_mm_setzero_si128(), v));
+        _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi16(_mm_setzero_si128(), v));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(v), 16));
+        vst1q_s32(dst + i + 4, vshll_n_s16(vget_high_s16(v), 16));
+    }
+#endif
+    for (; i < samples; i++)
+        dst[i] = (int32_t)((uint32_t)src[i] << 16);
+}
+
+void pcm_i16_from_i32(int16_t *dst, const int32_t *src, size_t samples)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_SSE2)
+    for (; i + 8 <= samples; i += 8) {
+        __m128i lo = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(src + i)), 16);
+        __m128i hi = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(src + i + 4)), 16);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(PCM_KERNELS_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        int16x4_t lo = vshrn_n_s32(vld1q_s32(src + i), 16);
+        int16x4_t hi = vshrn_n_s32(vld1q_s32(src + i + 4), 16);
+        vst1q_s16(dst + i, vcombine_s16(lo, hi));
+    }
+#endif
+    for (; i < samples; i++)
+        dst[i] = src[i] >> 16;
+}
+
+void pcm_i32_from_p24(int32_t *dst, const uint8_t *src, size_t samples)
+{
+    size_t i = 0;
+
+#if defined(PCM_KERNELS_SSSE3)
+    /* 4 packed samples (12 bytes) into the upper 24 bits of 4 words */
+    const __m128i mask = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    for (; i + 6 <= samples; i += 4) {
+        /* reads 16 bytes, the 6 sample bound keeps that inside the buffer */
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+#endif
+    for (; i < samples; i++) {
+        const uint8_t *p = src + i * 3;
+        dst[i] = (int32_t)(((uint32_t)p[2] << 24) | ((uint32_t)p[1] << 16) |
+                           ((uint32_t)p[0] << 8));
+    }
+}
+
+const char *pcm_kernels_isa()
+{
+#if defined(PCM_KERNELS_AVX2)
+    return "avx2";
+#elif defined(PCM_KERNELS_SSSE3)
+    return "ssse3";
+#elif defined(PCM_KERNELS_SSE2)
+    return "sse2";
+#elif defined(PCM_KERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PCM_KERNELS_H
+#define PCM_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Channel split/merge and sample format kernels used on the playback write
+ * path. The instruction set is picked at build time (AVX2, SSSE3/SSE2 or
+ * NEON) and every kernel has a scalar fallback, so the results are the same
+ * on every target. Buffers need no particular alignment and must not
+ * overlap.
+ */
+
+/* Splits interleaved frames of audioChannels audio samples followed by
+ * hapticChannels haptic samples into separate interleaved audio and haptic
+ * buffers.
+ */
+void pcm_split_channels(void *audio, void *haptic, const void *src, size_t frames,
+                        uint32_t audioChannels, uint32_t hapticChannels,
+                        uint32_t bytesPerSample);
+
+/* Inverse of pcm_split_channels() */
+void pcm_merge_channels(void *dst, const void *audio, const void *haptic, size_t frames,
+                        uint32_t audioChannels, uint32_t hapticChannels,
+                        uint32_t bytesPerSample);
+
+/* Sample format conversions, bit exact with the audio_utils primitives
+ * memcpy_to_i32_from_float(), memcpy_to_i32_from_i16(),
+ * memcpy_to_i16_from_i32() and memcpy_to_i32_from_p24().
+ */
+void pcm_i32_from_float(int32_t *dst, const float *src, size_t samples);
+void pcm_i32_from_i16(int32_t *dst, const int16_t *src, size_t samples);
+void pcm_i16_from_i32(int16_t *dst, const int32_t *src, size_t samples);
+void pcm_i32_from_p24(int32_t *dst, const uint8_t *src, size_t samples);
+
+/* Instruction set the kernels were built for, for logs */
+const char *pcm_kernels_isa();
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Stress test of DataPathGate, meant to run under TSan. A writer thread
+ * does what StreamOutPrimary::write() does with the gate, while other
+ * threads stand the stream by, as Standby()/Stop() do, and set the volume
+ * the way SetVolume() does. It fails if a handle is closed or a volume is
+ * applied while a lock free buffer is in flight, or if the last volume
+ * set is not applied by the end.
+ *
+ * The PAL calls yield, so the threads interleave even on a single core.
+ *
+ * usage: DataPathGateTest [buffers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "DataPathGate.h"
+
+#define DEFAULT_BUFFERS 200000
+
+struct FakeStream {
+    std::mutex mutex;
+    DataPathGate gate{mutex};
+    int *handle = nullptr;     /* the PAL stream handle */
+    bool started = false;
+    int volume = 0;            /* cached volume, under mutex */
+    int applied = 0;           /* volume PAL has, under mutex or the gate */
+    std::atomic<bool> inFlight{false};
+    std::atomic<int> errors{0};
+
+    /* a PAL call that must not overlap a lock free buffer, it takes a while */
+    void palCall(const char *what) {
+        for (int i = 0; i < 20; i++) {
+            if (inFlight.load()) {
+                fprintf(stderr, "%s with a buffer in flight\n", what);
+                errors++;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void write() {
+        bool locked = gate.acquire();
+
+        if (locked) {
+            if (!handle) {
+                /* opening sets the cached volume */
+                handle = new int(42);
+                applied = volume;
+            }
+            started = true;
+        } else {
+            inFlight.store(true);
+        }
+        if (*handle != 42) {
+            fprintf(stderr, "write to a closed handle\n");
+            errors++;
+        }
+        /* the PAL write, yielding so that other threads get to run into it */
+        std::this_thread::yield();
+        inFlight.store(false);
+
+        if (!gate.release(locked))
+            return;
+        if (gate.take(DataPathGate::VOLUME) && handle)
+            applied = volume;
+        if (!handle || !started)
+            gate.post(DataPathGate::RECONFIG);
+        mutex.unlock();
+    }
+
+    void standby() {
+        gate.lock();
+        palCall("standby");
+        started = false;
+        gate.post(DataPathGate::RECONFIG);
+        if (handle) {
+            *handle = 0;
+            delete handle;
+            handle = nullptr;
+        }
+        gate.unlock();
+    }
+
+    void setVolume(int v) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        volume = v;
+        if (!handle)
+            return;
+        gate.post(DataPathGate::VOLUME);
+        if (gate.claimIfIdle()) {
+            if (gate.take(DataPathGate::VOLUME)) {
+                palCall("volume");
+                applied = v;
+            }
+            gate.unclaim();
+        }
+    }
+};
+
+int main(int argc, char **argv)
+{
+    int buffers = argc > 1 ? atoi(argv[1]) : DEFAULT_BUFFERS;
+    std::atomic<bool> stop{false};
+    int standbys = 0, volumes = 0;
+    FakeStream stream;
+
+    std::thread writer([&] {
+        for (int i = 0; i < buffers; i++) {
+            stream.write();
+            /* the audio thread waits for room between buffers */
+            for (volatile int j = 0; j < 200; j++);
+        }
+        stop.store(true);
+    });
+    std::thread standby([&] {
+        while (!stop.load()) {
+            stream.standby();
+            standbys++;
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    });
+    std::thread volume([&] {
+        while (!stop.load()) {
+            stream.setVolume(++volumes);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+    writer.join();
+    standby.join();
+    volume.join();
+
+    /* a volume posted while the handle was open is applied by now */
+    stream.write();
+    if (stream.applied != stream.volume) {
+        fprintf(stderr, "volume %d set, %d applied\n", stream.volume, stream.applied);
+        stream.errors++;
+    }
+
+    printf("%d buffers, %d standbys, %d volumes, %d errors\n", buffers + 1,
+           standbys, volumes, stream.errors.load());
+    fflush(stdout);
+    stream.gate.dump(1);
+    delete stream.handle;
+
+    return stream.errors.load() ? 1 : 0;
+}
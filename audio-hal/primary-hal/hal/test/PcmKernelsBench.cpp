@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Checks the PcmKernels results against straightforward reference code and
+ * times them against it: the per frame memcpy split the haptics write path
+ * used and the per sample audio_utils style conversions.
+ *
+ * usage: PcmKernelsBench [iterations]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "PcmKernels.h"
+
+#define PERIOD_FRAMES 240   /* LOW_LATENCY_PLAYBACK_PERIOD_SIZE */
+#define BENCH_FRAMES (PERIOD_FRAMES * 4 + 3)   /* odd tail on purpose */
+#define DEFAULT_ITERATIONS 2000
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void fillRandom(std::vector<uint8_t> &buf, uint32_t seed)
+{
+    for (size_t i = 0; i < buf.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 16;
+    }
+}
+
+/* the split StreamOutPrimary::splitAndWriteAudioHapticsStream() used to do */
+static void refSplit(uint8_t *audio, uint8_t *haptic, const uint8_t *src, size_t frames,
+                     size_t audioFrameSize, size_t hapticsFrameSize)
+{
+    for (size_t i = 0; i < frames; i++) {
+        memcpy(audio, src, audioFrameSize);
+        src += audioFrameSize;
+        audio += audioFrameSize;
+        memcpy(haptic, src, hapticsFrameSize);
+        src += hapticsFrameSize;
+        haptic += hapticsFrameSize;
+    }
+}
+
+/* clamp32_from_float() from audio_utils */
+static int32_t refI32FromFloat(float f)
+{
+    static const float scale = (float)(1UL << 31);
+
+    if (f <= -1.0f)
+        return INT32_MIN;
+    else if (f >= 1.0f)
+        return INT32_MAX;
+    f *= scale;
+    return f > 0 ? f + 0.5 : f - 0.5;
+}
+
+static int benchLayout(uint32_t audioCh, uint32_t hapticCh, uint32_t bps, int iterations)
+{
+    size_t a = audioCh * bps, h = hapticCh * bps;
+    std::vector<uint8_t> src(BENCH_FRAMES * (a + h)), merged(src.size());
+    std::vector<uint8_t> refAudio(BENCH_FRAMES * a), refHaptic(BENCH_FRAMES * h);
+    std::vector<uint8_t> audio(refAudio.size()), haptic(refHaptic.size());
+    uint64_t start, refNs, splitNs, mergeNs;
+    int ret = 0;
+
+    fillRandom(src, audioCh * 100 + hapticCh * 10 + bps);
+
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        refSplit(refAudio.data(), refHaptic.data(), src.data(), BENCH_FRAMES, a, h);
+    refNs = nowNs() - start;
+
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        pcm_split_channels(audio.data(), haptic.data(), src.data(), BENCH_FRAMES,
+                           audioCh, hapticCh, bps);
+    splitNs = nowNs() - start;
+
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        pcm_merge_channels(merged.data(), audio.data(), haptic.data(), BENCH_FRAMES,
+                           audioCh, hapticCh, bps);
+    mergeNs = nowNs() - start;
+
+    if (audio != refAudio || haptic != refHaptic) {
+        printf("  FAIL: split mismatch\n");
+        ret = -1;
+    }
+    if (merged != src) {
+        printf("  FAIL: merge mismatch\n");
+        ret = -1;
+    }
+
+    printf("split %d+%d %2d bit   memcpy %6.2f  split %6.2f  merge %6.2f ns/frame\n",
+           audioCh, hapticCh, bps * 8,
+           (double)refNs / iterations / BENCH_FRAMES,
+           (double)splitNs / iterations / BENCH_FRAMES,
+           (double)mergeNs / iterations / BENCH_FRAMES);
+    return ret;
+}
+
+/* converts n floats and counts the results that differ from the reference */
+static uint64_t countFloatMismatches(const float *src, size_t n, uint64_t mismatches)
+{
+    std::vector<int32_t> dst(n);
+
+    pcm_i32_from_float(dst.data(), src, n);
+    for (size_t i = 0; i < n; i++) {
+        if (dst[i] != refI32FromFloat(src[i])) {
+            if (!mismatches)
+                printf("  FAIL: %a -> %d expected %d\n", src[i], dst[i],
+                       refI32FromFloat(src[i]));
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static int checkFloatSweep()
+{
+    /* scaled values where the rounding or the saturation changes */
+    static const float edges[] = { 0.5f, 1.5f, 8388607.5f, 8388608.0f, 2147483648.0f };
+    const size_t chunk = 4096;
+    std::vector<float> src(chunk);
+    std::vector<float> near;
+    uint64_t mismatches = 0;
+    uint32_t bits = 0;
+    size_t n;
+
+    /* every 13th bit pattern, that covers all exponents */
+    do {
+        for (n = 0; n < chunk; n++) {
+            uint32_t b = bits;
+            float f;
+
+            memcpy(&f, &b, sizeof(f));
+            src[n] = (f != f) ? 0.0f : f;
+            if (bits > UINT32_MAX - 13) {
+                n++;
+                bits = 0;
+                break;
+            }
+            bits += 13;
+        }
+        mismatches = countFloatMismatches(src.data(), n, mismatches);
+    } while (bits);
+
+    /* and the floats next to each edge, which a stride can step over */
+    for (float edge : edges) {
+        float lo = edge / 2147483648.0f, hi = lo;
+
+        for (int k = 0; k < 4; k++) {
+            near.insert(near.end(), { lo, -lo, hi, -hi });
+            lo = nextafterf(lo, 0.0f);
+            hi = nextafterf(hi, 2.0f);
+        }
+    }
+    mismatches = countFloatMismatches(near.data(), near.size(), mismatches);
+
+    printf("float sweep          %s\n", mismatches ? "FAILED" : "bit exact");
+    return mismatches ? -1 : 0;
+}
+
+static int benchConvert(int iterations)
+{
+    const size_t samples = PERIOD_FRAMES * 2 * 4 + 5;
+    std::vector<uint8_t> raw(samples * 4);
+    std::vector<float> f(samples);
+    std::vector<int16_t> s16(samples), s16Ref(samples);
+    std::vector<int32_t> s32(samples), s32Ref(samples);
+    uint64_t start, refNs, ns;
+    int ret = 0;
+
+    fillRandom(raw, 7);
+    for (size_t i = 0; i < samples; i++)
+        f[i] = ((int32_t)(raw[i * 4] | raw[i * 4 + 1] << 8 | raw[i * 4 + 2] << 16) -
+                (1 << 23)) / (float)(1 << 22);   /* about -2..2, exercises clamping */
+    memcpy(s16.data(), raw.data(), samples * sizeof(int16_t));
+    memcpy(s32.data(), raw.data(), samples * sizeof(int32_t));
+
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        for (size_t i = 0; i < samples; i++)
+            s32Ref[i] = refI32FromFloat(f[i]);
+    refNs = nowNs() - start;
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        pcm_i32_from_float(s32.data(), f.data(), samples);
+    ns = nowNs() - start;
+    if (s32 != s32Ref) {
+        printf("  FAIL: float -> i32 mismatch\n");
+        ret = -1;
+    }
+    printf("float -> i32         ref %6.3f  kernel %6.3f ns/sample\n",
+           (double)refNs / iterations / samples, (double)ns / iterations / samples);
+
+    memcpy(s16.data(), raw.data(), samples * sizeof(int16_t));
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        for (size_t i = 0; i < samples; i++)
+            s32Ref[i] = (int32_t)((uint32_t)s16[i] << 16);
+    refNs = nowNs() - start;
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        pcm_i32_from_i16(s32.data(), s16.data(), samples);
+    ns = nowNs() - start;
+    if (s32 != s32Ref) {
+        printf("  FAIL: i16 -> i32 mismatch\n");
+        ret = -1;
+    }
+    printf("i16 -> i32           ref %6.3f  kernel %6.3f ns/sample\n",
+           (double)refNs / iterations / samples, (double)ns / iterations / samples);
+
+    memcpy(s32.data(), raw.data(), samples * sizeof(int32_t));
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        for (size_t i = 0; i < samples; i++)
+            s16Ref[i] = s32[i] >> 16;
+    refNs = nowNs() - start;
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        pcm_i16_from_i32(s16.data(), s32.data(), samples);
+    ns = nowNs() - start;
+    if (s16 != s16Ref) {
+        printf("  FAIL: i32 -> i16 mismatch\n");
+        ret = -1;
+    }
+    printf("i32 -> i16           ref %6.3f  kernel %6.3f ns/sample\n",
+           (double)refNs / iterations / samples, (double)ns / iterations / samples);
+
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        for (size_t i = 0; i < samples; i++) {
+            const uint8_t *p = raw.data() + i * 3;
+            s32Ref[i] = (int32_t)((uint32_t)p[2] << 24 | (uint32_t)p[1] << 16 |
+                                  (uint32_t)p[0] << 8);
+        }
+    refNs = nowNs() - start;
+    start = nowNs();
+    for (int it = 0; it < iterations; it++)
+        pcm_i32_from_p24(s32.data(), raw.data(), samples);
+    ns = nowNs() - start;
+    if (s32 != s32Ref) {
+        printf("  FAIL: p24 -> i32 mismatch\n");
+        ret = -1;
+    }
+    printf("p24 -> i32           ref %6.3f  kernel %6.3f ns/sample\n",
+           (double)refNs / iterations / samples, (double)ns / iterations / samples);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t layouts[][2] = { {2, 1}, {2, 2}, {8, 2} };
+    static const uint32_t widths[] = { 2, 3, 4 };
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    int ret = 0;
+
+    if (iterations <= 0) {
+        printf("usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    printf("kernels built for %s, %d frames x %d iterations\n", pcm_kernels_isa(),
+           BENCH_FRAMES, iterations);
+    for (auto &layout : layouts)
+        for (auto bps : widths)
+            ret |= benchLayout(layout[0], layout[1], bps, iterations);
+    ret |= benchConvert(iterations);
+    ret |= checkFloatSweep();
+
+    printf("%s\n", ret ? "FAILED" : "PASSED");
+    return ret ? 1 : 0;
+}
@@ -146,6 +146,19 @@ enum DispFetchParamType {
 /* Frame type bit mask */
 #define QD_SYNC_FRAME (0x1 << 0)
 
+/* One parameter of a batched set */
+struct DispParam {
+    enum DispParamType paramType;
+    void *param;
+};
+
+/* One parameter of a batched get, ret holds the result of fetching it */
+struct DispFetchParam {
+    enum DispFetchParamType paramType;
+    void *param;
+    int ret;
+};
+
 struct private_handle_t;
 int setMetaData(struct private_handle_t *handle, enum DispParamType paramType,
                 void *param);
@@ -168,14 +181,30 @@ int clearMetaDataVa(struct MetaData_t *data, enum DispParamType paramType);
 
 unsigned long getMetaDataSize();
 
-// Map, access metadata and unmap. Used by clients that do not import/free but
-//  clone and delete native_handle
+// Access metadata without leaving it mapped on the handle. Used by clients that do not
+//  import/free but clone and delete native_handle. The mapping is kept in a process wide
+//  cache shared by all handles of the buffer.
 int setMetaDataAndUnmap(struct private_handle_t *handle, enum DispParamType paramType,
                         void *param);
 int getMetaDataAndUnmap(struct private_handle_t *handle,
                         enum DispFetchParamType paramType,
                         void *param);
 
+// Set or get several parameters with a single metadata access. A handle that is not mapped is
+// accessed through the process wide mapping cache and is left unmapped, as with the *AndUnmap
+// calls. setMetaDataBatch returns the first error, getMetaDataBatch the number of parameters
+// fetched. Every parameter is attempted either way.
+int setMetaDataBatch(struct private_handle_t *handle, struct DispParam *params,
+                     unsigned int count);
+int getMetaDataBatch(struct private_handle_t *handle, struct DispFetchParam *params,
+                     unsigned int count);
+
+// Keep the metadata of a buffer in the mapping cache from import/clone of its handle until
+// release, instead of only while the cache has room for it. Calls must be balanced and made
+// while fd_metadata is open.
+int acquireMetaDataMapping(struct private_handle_t *handle);
+int releaseMetaDataMapping(struct private_handle_t *handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,8 +38,15 @@
 #include <log/log.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <cinttypes>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// Unreferenced metadata mappings the cache keeps, least recently used go first
+#define METADATA_CACHE_IDLE_MAX 64
 
 static int colorMetaDataToColorSpace(ColorMetaData in, ColorSpace_t *out) {
   if (in.colorPrimaries == ColorPrimaries_BT601_6_525 ||
@@ -236,7 +243,7 @@ unsigned long getMetaDataSizeWithReservedRegion(uint64_t reserved_size) {
   return static_cast<unsigned long>(ROUND_UP_PAGESIZE(sizeof(MetaData_t) + reserved_size));
 }
 
-static int validateAndMap(private_handle_t* handle) {
+static int validateHandle(private_handle_t *handle) {
     if (private_handle_t::validate(handle)) {
         ALOGE("%s: Private handle is invalid - handle:%p", __func__, handle);
         return -1;
@@ -245,32 +252,47 @@ static int validateAndMap(private_handle_t* handle) {
       // Metadata cannot be used
       return -1;
     }
+    return 0;
+}
+
+// Maps the metadata of handle, along with its reserved region if it has one
+static void *mapMetaData(private_handle_t *handle, unsigned long *mapped_size) {
+    auto size = getMetaDataSize();
+    void *base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED,
+            handle->fd_metadata, 0);
+    if (base == reinterpret_cast<void*>(MAP_FAILED)) {
+        ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s",
+            __func__, handle, handle->fd_metadata, strerror(errno));
+        return nullptr;
+    }
+    auto metadata = reinterpret_cast<MetaData_t *>(base);
+    if (metadata->reservedSize) {
+      auto reserved_size = metadata->reservedSize;
+      munmap(base, getMetaDataSize());
+      size = getMetaDataSizeWithReservedRegion(reserved_size);
+      base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd_metadata, 0);
+      if (base == reinterpret_cast<void *>(MAP_FAILED)) {
+        ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s", __func__, handle,
+              handle->fd_metadata, strerror(errno));
+        return nullptr;
+      }
+    }
+    *mapped_size = size;
+    return base;
+}
+
+static int validateAndMap(private_handle_t* handle) {
+    if (validateHandle(handle)) {
+        return -1;
+    }
 
     if (!handle->base_metadata) {
-        auto size = getMetaDataSize();
-        void *base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED,
-                handle->fd_metadata, 0);
-        if (base == reinterpret_cast<void*>(MAP_FAILED)) {
-            ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s",
-                __func__, handle, handle->fd_metadata, strerror(errno));
+        unsigned long size = 0;
+        void *base = mapMetaData(handle, &size);
+        if (!base) {
             return -1;
         }
         handle->base_metadata = (uintptr_t) base;
-        auto metadata = reinterpret_cast<MetaData_t *>(handle->base_metadata);
-        if (metadata->reservedSize) {
-          auto reserved_size = metadata->reservedSize;
-          munmap(reinterpret_cast<void *>(handle->base_metadata), getMetaDataSize());
-          handle->base_metadata = 0;
-          size = getMetaDataSizeWithReservedRegion(reserved_size);
-          void *new_base =
-              mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd_metadata, 0);
-          if (new_base == reinterpret_cast<void *>(MAP_FAILED)) {
-            ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s", __func__, handle,
-                  handle->fd_metadata, strerror(errno));
-            return -1;
-          }
-          handle->base_metadata = (uintptr_t)new_base;
-        }
     }
     return 0;
 }
@@ -285,6 +307,133 @@ static void unmapAndReset(private_handle_t *handle) {
     }
 }
 
+namespace {
+
+// Identifies a metadata buffer across the handles, clones and fds referring to it. A mapping
+// holds a reference on the buffer, so the inode of a cached buffer cannot be reused.
+struct MetaDataKey {
+  dev_t dev;
+  ino_t ino;
+
+  bool operator==(const MetaDataKey &other) const {
+    return dev == other.dev && ino == other.ino;
+  }
+};
+
+struct MetaDataKeyHash {
+  size_t operator()(const MetaDataKey &key) const {
+    return std::hash<uint64_t>()(static_cast<uint64_t>(key.ino) ^
+                                 (static_cast<uint64_t>(key.dev) << 32));
+  }
+};
+
+struct MetaDataMapping {
+  MetaData_t *base;
+  unsigned long size;
+  unsigned int refs;
+  std::list<MetaDataKey>::iterator idle;
+};
+
+// Metadata mappings for handles that are not mapped themselves. An entry stays mapped while
+// referenced, by an access in progress or by acquireMetaDataMapping(), and afterwards until it
+// ages out of the idle list.
+class MetaDataCache {
+ public:
+  MetaData_t *Get(private_handle_t *handle, MetaDataKey *key);
+  int Put(const MetaDataKey &key);
+
+ private:
+  std::mutex lock_;
+  std::unordered_map<MetaDataKey, MetaDataMapping, MetaDataKeyHash> mappings_;
+  // Unreferenced entries, most recently used first
+  std::list<MetaDataKey> idle_;
+};
+
+}  // namespace
+
+static int getMetaDataKey(private_handle_t *handle, MetaDataKey *key) {
+    struct stat st = {};
+    if (fstat(handle->fd_metadata, &st)) {
+        ALOGE("%s: metadata fstat failed - handle:%p fd: %d err: %s", __func__, handle,
+              handle->fd_metadata, strerror(errno));
+        return -1;
+    }
+    key->dev = st.st_dev;
+    key->ino = st.st_ino;
+    return 0;
+}
+
+MetaData_t *MetaDataCache::Get(private_handle_t *handle, MetaDataKey *key) {
+    if (getMetaDataKey(handle, key)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = mappings_.find(*key);
+    if (it == mappings_.end()) {
+        MetaDataMapping mapping = {};
+        mapping.base = reinterpret_cast<MetaData_t *>(mapMetaData(handle, &mapping.size));
+        if (!mapping.base) {
+            return nullptr;
+        }
+        mapping.idle = idle_.end();
+        it = mappings_.emplace(*key, mapping).first;
+    } else if (!it->second.refs) {
+        idle_.erase(it->second.idle);
+        it->second.idle = idle_.end();
+    }
+    it->second.refs++;
+    return it->second.base;
+}
+
+int MetaDataCache::Put(const MetaDataKey &key) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = mappings_.find(key);
+    if (it == mappings_.end() || !it->second.refs) {
+        return -EINVAL;
+    }
+    if (--it->second.refs) {
+        return 0;
+    }
+
+    idle_.push_front(key);
+    it->second.idle = idle_.begin();
+    while (idle_.size() > METADATA_CACHE_IDLE_MAX) {
+        auto oldest = mappings_.find(idle_.back());
+        munmap(oldest->second.base, oldest->second.size);
+        mappings_.erase(oldest);
+        idle_.pop_back();
+    }
+    return 0;
+}
+
+// Never destroyed, handles may be accessed from other threads during exit
+static MetaDataCache *getMetaDataCache() {
+    static MetaDataCache *cache = new MetaDataCache();
+    return cache;
+}
+
+// Runs access on the metadata of handle, through the handle's own mapping if it has one and
+// through the cache otherwise
+template <typename Access>
+static int accessMetaData(private_handle_t *handle, Access access) {
+    if (validateHandle(handle)) {
+        return -1;
+    }
+    if (handle->base_metadata) {
+        return access(reinterpret_cast<MetaData_t *>(handle->base_metadata));
+    }
+
+    MetaDataKey key = {};
+    MetaData_t *data = getMetaDataCache()->Get(handle, &key);
+    if (!data) {
+        return -1;
+    }
+    int ret = access(data);
+    getMetaDataCache()->Put(key);
+    return ret;
+}
+
 int setMetaData(private_handle_t *handle, DispParamType paramType,
                 void *param) {
     auto err = validateAndMap(handle);
@@ -628,15 +777,78 @@ int copyMetaDataVaToVa(MetaData_t *src_data, MetaData_t *dst_data) {
 
 int setMetaDataAndUnmap(struct private_handle_t *handle, enum DispParamType paramType,
                         void *param) {
-    auto ret = setMetaData(handle, paramType, param);
-    unmapAndReset(handle);
-    return ret;
+    if (validateHandle(handle) == 0 && handle->base_metadata) {
+        auto ret = setMetaData(handle, paramType, param);
+        unmapAndReset(handle);
+        return ret;
+    }
+    return accessMetaData(handle, [&](MetaData_t *data) {
+        return setMetaDataVa(data, paramType, param);
+    });
 }
 
 int getMetaDataAndUnmap(struct private_handle_t *handle,
                         enum DispFetchParamType paramType,
                         void *param) {
-    auto ret = getMetaData(handle, paramType, param);
-    unmapAndReset(handle);
-    return ret;
+    if (validateHandle(handle) == 0 && handle->base_metadata) {
+        auto ret = getMetaData(handle, paramType, param);
+        unmapAndReset(handle);
+        return ret;
+    }
+    return accessMetaData(handle, [&](MetaData_t *data) {
+        return getMetaDataVa(data, paramType, param);
+    });
+}
+
+int setMetaDataBatch(struct private_handle_t *handle, struct DispParam *params,
+                     unsigned int count) {
+    if (params == nullptr && count)
+        return -EINVAL;
+
+    return accessMetaData(handle, [&](MetaData_t *data) {
+        int ret = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            auto err = setMetaDataVa(data, params[i].paramType, params[i].param);
+            if (err != 0 && ret == 0)
+                ret = err;
+        }
+        return ret;
+    });
+}
+
+int getMetaDataBatch(struct private_handle_t *handle, struct DispFetchParam *params,
+                     unsigned int count) {
+    if (params == nullptr && count)
+        return -EINVAL;
+
+    for (unsigned int i = 0; i < count; i++)
+        params[i].ret = -EINVAL;
+
+    return accessMetaData(handle, [&](MetaData_t *data) {
+        int fetched = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            params[i].ret = getMetaDataVa(data, params[i].paramType, params[i].param);
+            if (params[i].ret == 0)
+                fetched++;
+        }
+        return fetched;
+    });
+}
+
+int acquireMetaDataMapping(struct private_handle_t *handle) {
+    if (validateHandle(handle))
+        return -1;
+
+    MetaDataKey key = {};
+    return getMetaDataCache()->Get(handle, &key) ? 0 : -1;
+}
+
+int releaseMetaDataMapping(struct private_handle_t *handle) {
+    if (validateHandle(handle))
+        return -1;
+
+    MetaDataKey key = {};
+    if (getMetaDataKey(handle, &key))
+        return -1;
+    return getMetaDataCache()->Put(key);
 }
@@ -0,0 +1,237 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Per frame metadata traffic of a video pipeline on cloned handles: each frame a clone of every
+// buffer's handle sets and reads back colour metadata, crop, interlace and UBWC stats. Compares
+// mapping per access, the mapping cache, batched access and a handle mapped for its lifetime.
+
+#include <gralloc_priv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "qdMetaData.h"
+
+#define DEFAULT_BUFFERS 8
+#define DEFAULT_FRAMES 20000
+#define MAX_BUFFERS 64
+#define PARAMS_PER_FRAME 4
+
+enum AccessMode {
+  kMapPerAccess,
+  kCachePerAccess,
+  kCacheBatched,
+  kMappedHandle,
+};
+
+static const char *mode_names[] = { "map per access", "cache per access", "cache batched",
+                                    "mapped handle" };
+
+struct FrameParams {
+  ColorMetaData color;
+  BufferDim_t dim;
+  int32_t interlaced;
+  UBWCStats ubwc_stats[UBWC_STATS_ARRAY_SIZE];
+};
+
+static int64_t GetTimeNs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// The map/access/unmap sequence *AndUnmap used for every parameter
+static int SetMapPerAccess(private_handle_t *handle, DispParamType type, void *param) {
+  int ret = setMetaData(handle, type, param);
+  if (handle->base_metadata) {
+    munmap(reinterpret_cast<void *>(handle->base_metadata), getMetaDataSize());
+    handle->base_metadata = 0;
+  }
+  return ret;
+}
+
+static int GetMapPerAccess(private_handle_t *handle, DispFetchParamType type, void *param) {
+  int ret = getMetaData(handle, type, param);
+  if (handle->base_metadata) {
+    munmap(reinterpret_cast<void *>(handle->base_metadata), getMetaDataSize());
+    handle->base_metadata = 0;
+  }
+  return ret;
+}
+
+static int RunFrame(private_handle_t *handle, AccessMode mode, FrameParams *in,
+                    FrameParams *out) {
+  DispParam set[PARAMS_PER_FRAME] = {
+    { COLOR_METADATA, &in->color },
+    { UPDATE_BUFFER_GEOMETRY, &in->dim },
+    { PP_PARAM_INTERLACED, &in->interlaced },
+    { SET_UBWC_CR_STATS_INFO, in->ubwc_stats },
+  };
+  DispFetchParam get[PARAMS_PER_FRAME] = {
+    { GET_COLOR_METADATA, &out->color, 0 },
+    { GET_BUFFER_GEOMETRY, &out->dim, 0 },
+    { GET_PP_PARAM_INTERLACED, &out->interlaced, 0 },
+    { GET_UBWC_CR_STATS_INFO, out->ubwc_stats, 0 },
+  };
+  int err = 0;
+
+  if (mode == kCacheBatched) {
+    err = setMetaDataBatch(handle, set, PARAMS_PER_FRAME);
+    if (!err && getMetaDataBatch(handle, get, PARAMS_PER_FRAME) != PARAMS_PER_FRAME) {
+      err = -1;
+    }
+    return err;
+  }
+
+  for (int i = 0; i < PARAMS_PER_FRAME && !err; i++) {
+    switch (mode) {
+      case kMapPerAccess:
+        err = SetMapPerAccess(handle, set[i].paramType, set[i].param);
+        break;
+      case kCachePerAccess:
+        err = setMetaDataAndUnmap(handle, set[i].paramType, set[i].param);
+        break;
+      default:
+        err = setMetaData(handle, set[i].paramType, set[i].param);
+        break;
+    }
+  }
+  for (int i = 0; i < PARAMS_PER_FRAME && !err; i++) {
+    switch (mode) {
+      case kMapPerAccess:
+        err = GetMapPerAccess(handle, get[i].paramType, get[i].param);
+        break;
+      case kCachePerAccess:
+        err = getMetaDataAndUnmap(handle, get[i].paramType, get[i].param);
+        break;
+      default:
+        err = getMetaData(handle, get[i].paramType, get[i].param);
+        break;
+    }
+  }
+
+  return err;
+}
+
+static int RunMode(int *meta_fds, int buffers, int frames, AccessMode mode, int64_t *ns) {
+  FrameParams in = {}, out = {};
+  in.color.colorPrimaries = ColorPrimaries_BT709_5;
+  in.color.range = Range_Limited;
+  in.dim.sliceWidth = 1920;
+  in.dim.sliceHeight = 1080;
+
+  private_handle_t *mapped[MAX_BUFFERS] = {};
+  int64_t start = GetTimeNs();
+
+  for (int frame = 0; frame < frames; frame++) {
+    int buffer = frame % buffers;
+    in.interlaced = frame & 1;
+    in.ubwc_stats[0].bDataValid = true;
+
+    private_handle_t *handle = NULL;
+    if (mode == kMappedHandle) {
+      if (!mapped[buffer]) {
+        mapped[buffer] = new private_handle_t(-1, meta_fds[buffer], 0, 1920, 1080, 1920, 1080, 0,
+                                             0, 0);
+      }
+      handle = mapped[buffer];
+    } else {
+      // Clones carry their own fds, the cache finds the buffer by inode
+      handle = new private_handle_t(-1, dup(meta_fds[buffer]), 0, 1920, 1080, 1920, 1080, 0, 0,
+                                    0);
+    }
+
+    int err = RunFrame(handle, mode, &in, &out);
+    if (!err && (out.interlaced != in.interlaced || out.dim.sliceWidth != in.dim.sliceWidth)) {
+      err = -1;
+    }
+
+    if (mode != kMappedHandle) {
+      close(handle->fd_metadata);
+      delete handle;
+    }
+    if (err) {
+      printf("%s: frame %d failed\n", mode_names[mode], frame);
+      return -1;
+    }
+  }
+
+  *ns = GetTimeNs() - start;
+
+  for (int i = 0; i < buffers; i++) {
+    if (mapped[i]) {
+      munmap(reinterpret_cast<void *>(mapped[i]->base_metadata), getMetaDataSize());
+      delete mapped[i];
+    }
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int buffers = (argc > 1) ? atoi(argv[1]) : DEFAULT_BUFFERS;
+  int frames = (argc > 2) ? atoi(argv[2]) : DEFAULT_FRAMES;
+  if (buffers <= 0 || buffers > MAX_BUFFERS || frames <= 0) {
+    printf("usage: %s [buffers, up to %d] [frames]\n", argv[0], MAX_BUFFERS);
+    return 1;
+  }
+
+  int meta_fds[MAX_BUFFERS] = {};
+  for (int i = 0; i < buffers; i++) {
+    meta_fds[i] = memfd_create("qdmetadata", 0);
+    if (meta_fds[i] < 0 || ftruncate(meta_fds[i], getMetaDataSize())) {
+      printf("metadata buffer allocation failed\n");
+      return 1;
+    }
+  }
+
+  printf("%d buffers, %d frames, %d sets and %d gets per frame\n", buffers, frames,
+         PARAMS_PER_FRAME, PARAMS_PER_FRAME);
+  for (int mode = kMapPerAccess; mode <= kMappedHandle; mode++) {
+    int64_t ns = 0;
+    if (RunMode(meta_fds, buffers, frames, static_cast<AccessMode>(mode), &ns)) {
+      return 1;
+    }
+    printf("%-18s %8lld ns per frame\n", mode_names[mode], static_cast<long long>(ns / frames));
+  }
+
+  for (int i = 0; i < buffers; i++) {
+    close(meta_fds[i]);
+  }
+
+  return 0;
+}
@@ -127,6 +127,10 @@ typedef enum {
   A2DP_CTRL_GET_PRESENTATION_POSITION,
   A2DP_CTRL_CMD_STREAM_OPEN,
   A2DP_CTRL_GET_SINK_LATENCY,
+  // Moves the PCM data onto a shared memory FIFO, see audio_a2dp_hw_fifo.h.
+  // The stack acks once to ask for the FIFO descriptors, which follow in a
+  // separate message, and acks again after mapping them.
+  A2DP_CTRL_CMD_SHM_DATAPATH,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
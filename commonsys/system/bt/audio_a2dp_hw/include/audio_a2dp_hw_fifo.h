@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*****************************************************************************
+ *
+ *  Filename:      audio_a2dp_hw_fifo.h
+ *
+ *  Description:   Shared memory PCM FIFO between the A2DP audio HAL and the
+ *                 A2DP source in the stack.
+ *
+ *  The FIFO is a single producer / single consumer ring in a sealed memfd.
+ *  The audio HAL creates it and passes the memfd and two eventfds to the
+ *  stack over the control channel (A2DP_CTRL_CMD_SHM_DATAPATH). Each side
+ *  only signals its eventfd when the other side said it is waiting, so a
+ *  steady stream does not cost any system calls.
+ *
+ *  The audio HAL and the stack do not link a common library, so the FIFO
+ *  is implemented inline here next to the control protocol definitions.
+ *
+ *****************************************************************************/
+
+#ifndef AUDIO_A2DP_HW_FIFO_H
+#define AUDIO_A2DP_HW_FIFO_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+
+/*****************************************************************************
+ *  Constants & Macros
+ *****************************************************************************/
+
+#define A2DP_FIFO_MAGIC 0x46504441 /* "ADPF" */
+#define A2DP_FIFO_VERSION 1
+
+// memfd, data eventfd and space eventfd, in that order
+#define A2DP_FIFO_NUM_FDS 3
+#define A2DP_FIFO_MEM_FD 0
+#define A2DP_FIFO_DATA_FD 1
+#define A2DP_FIFO_SPACE_FD 2
+
+#define A2DP_FIFO_MIN_SIZE 4096
+#define A2DP_FIFO_MAX_SIZE (1024 * 1024)
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "the shared FIFO needs address free atomics");
+
+/*****************************************************************************
+ *  Type definitions
+ *****************************************************************************/
+
+// Control block at the start of the shared memory, the ring data follows it.
+// Positions are free running byte counters, the indices are taken modulo
+// |size|. Writer and reader state live on separate cache lines.
+struct a2dp_fifo_shared {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  std::atomic<uint32_t> closed;
+
+  alignas(64) std::atomic<uint64_t> write_pos;
+  std::atomic<uint32_t> reader_waiting;
+
+  alignas(64) std::atomic<uint64_t> read_pos;
+  std::atomic<uint32_t> writer_waiting;
+};
+
+typedef struct {
+  struct a2dp_fifo_shared* shm;
+  uint8_t* data;
+  size_t map_len;
+  uint32_t size;
+  // Own position, the writer never trusts the shared write_pos and the
+  // reader never trusts the shared read_pos.
+  uint64_t pos;
+  int fds[A2DP_FIFO_NUM_FDS];
+} tA2DP_FIFO;
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+static inline uint64_t a2dp_fifo_now_ms(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline void a2dp_fifo_signal(int fd) {
+  uint64_t one = 1;
+  ssize_t ret;
+
+  do {
+    ret = write(fd, &one, sizeof(one));
+  } while (ret == -1 && errno == EINTR);
+}
+
+// Waits until |fd| is signaled or |deadline_ms| passes. Returns false on
+// timeout.
+static inline bool a2dp_fifo_wait(int fd, uint64_t deadline_ms) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+  uint64_t now = a2dp_fifo_now_ms();
+  uint64_t count;
+  int ret;
+
+  if (now >= deadline_ms) return false;
+  do {
+    ret = poll(&pfd, 1, (int)(deadline_ms - now));
+  } while (ret == -1 && errno == EINTR);
+  if (ret <= 0) return false;
+  // eventfds are non blocking, this only resets the counter
+  while (read(fd, &count, sizeof(count)) == -1 && errno == EINTR) {
+  }
+  return true;
+}
+
+static inline void a2dp_fifo_init(tA2DP_FIFO* fifo) {
+  memset(fifo, 0, sizeof(*fifo));
+  for (int i = 0; i < A2DP_FIFO_NUM_FDS; i++) fifo->fds[i] = -1;
+}
+
+static inline bool a2dp_fifo_is_open(const tA2DP_FIFO* fifo) {
+  return fifo->shm != NULL;
+}
+
+// Unmaps the FIFO and closes its descriptors.
+static inline void a2dp_fifo_destroy(tA2DP_FIFO* fifo) {
+  if (fifo->shm != NULL) munmap(fifo->shm, fifo->map_len);
+  for (int i = 0; i < A2DP_FIFO_NUM_FDS; i++)
+    if (fifo->fds[i] >= 0) close(fifo->fds[i]);
+  a2dp_fifo_init(fifo);
+}
+
+static inline int a2dp_fifo_map(tA2DP_FIFO* fifo, size_t map_len) {
+  void* p = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fifo->fds[A2DP_FIFO_MEM_FD], 0);
+
+  if (p == MAP_FAILED) return -errno;
+  fifo->shm = (struct a2dp_fifo_shared*)p;
+  fifo->data = (uint8_t*)p + sizeof(struct a2dp_fifo_shared);
+  fifo->map_len = map_len;
+  return 0;
+}
+
+// Creates a FIFO holding at least |min_size| bytes of audio, rounded up to a
+// power of two. Returns 0 on success, otherwise a negative errno.
+static inline int a2dp_fifo_create(tA2DP_FIFO* fifo, size_t min_size) {
+  uint32_t size = A2DP_FIFO_MIN_SIZE;
+  size_t map_len;
+  int ret;
+
+  a2dp_fifo_init(fifo);
+  if (min_size > A2DP_FIFO_MAX_SIZE) return -EINVAL;
+  while (size < min_size) size <<= 1;
+  map_len = sizeof(struct a2dp_fifo_shared) + size;
+
+  fifo->fds[A2DP_FIFO_MEM_FD] =
+      memfd_create("a2dp_fifo", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  fifo->fds[A2DP_FIFO_DATA_FD] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  fifo->fds[A2DP_FIFO_SPACE_FD] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  for (int i = 0; i < A2DP_FIFO_NUM_FDS; i++) {
+    if (fifo->fds[i] < 0) {
+      ret = -errno;
+      goto error;
+    }
+  }
+
+  // The reader maps the same size, sealing keeps the writer from shrinking
+  // the memfd under it.
+  if (ftruncate(fifo->fds[A2DP_FIFO_MEM_FD], map_len) < 0 ||
+      fcntl(fifo->fds[A2DP_FIFO_MEM_FD], F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+    ret = -errno;
+    goto error;
+  }
+  ret = a2dp_fifo_map(fifo, map_len);
+  if (ret < 0) goto error;
+
+  fifo->size = size;
+  fifo->shm->magic = A2DP_FIFO_MAGIC;
+  fifo->shm->version = A2DP_FIFO_VERSION;
+  fifo->shm->size = size;
+  fifo->shm->closed.store(0);
+  fifo->shm->write_pos.store(0);
+  fifo->shm->reader_waiting.store(0);
+  fifo->shm->read_pos.store(0);
+  fifo->shm->writer_waiting.store(0);
+  return 0;
+
+error:
+  a2dp_fifo_destroy(fifo);
+  return ret;
+}
+
+// Maps a FIFO created by the other side from the descriptors it sent.
+// Ownership of |fds| passes to |fifo| even on failure. Returns 0 on success,
+// otherwise a negative errno.
+static inline int a2dp_fifo_attach(tA2DP_FIFO* fifo,
+                                   const int fds[A2DP_FIFO_NUM_FDS]) {
+  struct stat st;
+  int seals;
+  uint32_t size;
+  int ret;
+
+  a2dp_fifo_init(fifo);
+  for (int i = 0; i < A2DP_FIFO_NUM_FDS; i++) fifo->fds[i] = fds[i];
+
+  if (fstat(fifo->fds[A2DP_FIFO_MEM_FD], &st) < 0) {
+    ret = -errno;
+    goto error;
+  }
+  seals = fcntl(fifo->fds[A2DP_FIFO_MEM_FD], F_GET_SEALS);
+  if (seals < 0 || !(seals & F_SEAL_SHRINK) ||
+      st.st_size <= (off_t)sizeof(struct a2dp_fifo_shared)) {
+    ret = -EINVAL;
+    goto error;
+  }
+  ret = a2dp_fifo_map(fifo, st.st_size);
+  if (ret < 0) goto error;
+
+  // Trust the memfd size, not the header, for the ring bounds
+  size = st.st_size - sizeof(struct a2dp_fifo_shared);
+  if (fifo->shm->magic != A2DP_FIFO_MAGIC ||
+      fifo->shm->version != A2DP_FIFO_VERSION || fifo->shm->size != size ||
+      size < A2DP_FIFO_MIN_SIZE || size > A2DP_FIFO_MAX_SIZE ||
+      (size & (size - 1))) {
+    ret = -EINVAL;
+    goto error;
+  }
+  fifo->size = size;
+  fifo->pos = fifo->shm->read_pos.load();
+  return 0;
+
+error:
+  a2dp_fifo_destroy(fifo);
+  return ret;
+}
+
+// Marks the FIFO closed and wakes up both sides. Either side may call it,
+// a blocked write then fails and a read returns what is left.
+static inline void a2dp_fifo_close(tA2DP_FIFO* fifo) {
+  if (fifo->shm == NULL) return;
+  fifo->shm->closed.store(1);
+  a2dp_fifo_signal(fifo->fds[A2DP_FIFO_DATA_FD]);
+  a2dp_fifo_signal(fifo->fds[A2DP_FIFO_SPACE_FD]);
+}
+
+// Writes all of |len| bytes, waiting up to |timeout_ms| for the reader to
+// make room. Returns |len|, or -1 with errno set to EPIPE when the FIFO was
+// closed or ETIMEDOUT.
+static inline ssize_t a2dp_fifo_write(tA2DP_FIFO* fifo, const void* buf,
+                                      size_t len, int timeout_ms) {
+  struct a2dp_fifo_shared* shm = fifo->shm;
+  const uint8_t* p = (const uint8_t*)buf;
+  uint64_t deadline_ms = a2dp_fifo_now_ms() + timeout_ms;
+  size_t done = 0;
+
+  while (done < len) {
+    if (shm->closed.load(std::memory_order_relaxed)) {
+      errno = EPIPE;
+      return -1;
+    }
+
+    uint64_t used = fifo->pos - shm->read_pos.load(std::memory_order_acquire);
+    if (used > fifo->size) {
+      // the reader moved past us, nothing in the ring can be trusted
+      a2dp_fifo_close(fifo);
+      errno = EPIPE;
+      return -1;
+    }
+    if (used == fifo->size) {
+      shm->writer_waiting.store(1);
+      if (fifo->pos - shm->read_pos.load() == fifo->size &&
+          !a2dp_fifo_wait(fifo->fds[A2DP_FIFO_SPACE_FD], deadline_ms)) {
+        shm->writer_waiting.store(0, std::memory_order_relaxed);
+        errno = ETIMEDOUT;
+        return -1;
+      }
+      shm->writer_waiting.store(0, std::memory_order_relaxed);
+      continue;
+    }
+
+    size_t n = fifo->size - used;
+    if (n > len - done) n = len - done;
+    uint32_t offset = fifo->pos & (fifo->size - 1);
+    size_t first = fifo->size - offset;
+    if (first > n) first = n;
+    memcpy(fifo->data + offset, p + done, first);
+    memcpy(fifo->data, p + done + first, n - first);
+
+    fifo->pos += n;
+    done += n;
+    shm->write_pos.store(fifo->pos);
+    if (shm->reader_waiting.load()) a2dp_fifo_signal(fifo->fds[A2DP_FIFO_DATA_FD]);
+  }
+  return done;
+}
+
+// Reads up to |len| bytes, waiting up to |timeout_ms| for the rest once the
+// FIFO runs empty. Returns the number of bytes read, short on timeout or
+// once the FIFO was closed and drained.
+static inline size_t a2dp_fifo_read(tA2DP_FIFO* fifo, void* buf, size_t len,
+                                    int timeout_ms) {
+  struct a2dp_fifo_shared* shm = fifo->shm;
+  uint8_t* p = (uint8_t*)buf;
+  uint64_t deadline_ms = a2dp_fifo_now_ms() + timeout_ms;
+  size_t done = 0;
+
+  while (done < len) {
+    uint64_t avail = shm->write_pos.load(std::memory_order_acquire) - fifo->pos;
+    if (avail > fifo->size) {
+      a2dp_fifo_close(fifo);
+      break;
+    }
+    if (avail == 0) {
+      if (shm->closed.load(std::memory_order_relaxed)) break;
+      shm->reader_waiting.store(1);
+      if (shm->write_pos.load() == fifo->pos &&
+          !a2dp_fifo_wait(fifo->fds[A2DP_FIFO_DATA_FD], deadline_ms)) {
+        shm->reader_waiting.store(0, std::memory_order_relaxed);
+        break;
+      }
+      shm->reader_waiting.store(0, std::memory_order_relaxed);
+      continue;
+    }
+
+    size_t n = avail;
+    if (n > len - done) n = len - done;
+    uint32_t offset = fifo->pos & (fifo->size - 1);
+    size_t first = fifo->size - offset;
+    if (first > n) first = n;
+    memcpy(p + done, fifo->data + offset, first);
+    memcpy(p + done + first, fifo->data, n - first);
+
+    fifo->pos += n;
+    done += n;
+    shm->read_pos.store(fifo->pos);
+    if (shm->writer_waiting.load()) a2dp_fifo_signal(fifo->fds[A2DP_FIFO_SPACE_FD]);
+  }
+  return done;
+}
+
+// Sends the FIFO descriptors over the unix socket |sock| attached to a
+// single byte. Returns 0 on success, otherwise -1 with errno set.
+static inline int a2dp_fifo_send_fds(int sock, const tA2DP_FIFO* fifo) {
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int) * A2DP_FIFO_NUM_FDS)];
+  } ctrl;
+  uint8_t byte = 0;
+  struct iovec iov = {&byte, sizeof(byte)};
+  struct msghdr msg;
+  ssize_t ret;
+
+  memset(&msg, 0, sizeof(msg));
+  memset(&ctrl, 0, sizeof(ctrl));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * A2DP_FIFO_NUM_FDS);
+  memcpy(CMSG_DATA(cmsg), fifo->fds, sizeof(int) * A2DP_FIFO_NUM_FDS);
+
+  do {
+    ret = sendmsg(sock, &msg, MSG_NOSIGNAL);
+  } while (ret == -1 && errno == EINTR);
+  return ret == 1 ? 0 : -1;
+}
+
+#endif /* AUDIO_A2DP_HW_FIFO_H */
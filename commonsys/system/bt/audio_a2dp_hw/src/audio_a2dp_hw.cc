@@ -59,6 +59,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
+#include "audio_a2dp_hw_fifo.h"
 
 #ifdef BT_AUDIO_SYSTRACE_LOG
 #include <cutils/trace.h>
@@ -146,6 +147,7 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  tA2DP_FIFO fifo;  // PCM goes here instead of audio_fd when mapped
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -409,6 +411,13 @@ static int skt_disconnect(int fd) {
   return 0;
 }
 
+static bool a2dp_shm_datapath_enabled(void) {
+  char value[PROPERTY_VALUE_MAX] = "false";
+
+  return property_get("persist.vendor.bt.a2dp.shm_datapath", value, "false") &&
+         !strcmp(value, "true");
+}
+
 /*****************************************************************************
  *
  *  AUDIO CONTROL PATH
@@ -913,6 +922,7 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_fifo_init(&common->fifo);
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -923,10 +933,49 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
   FNLOG();
 
+  a2dp_fifo_destroy(&common->fifo);
   delete common->mutex;
   common->mutex = NULL;
 }
 
+/* Offers the stack a shared memory FIFO for the PCM data. The data socket
+ * stays connected either way, it still tells the stack when the HAL goes
+ * away, and carries the data if the stack does not take the FIFO.
+ */
+static int a2dp_open_shm_datapath(struct a2dp_stream_common* common) {
+  tA2DP_FIFO fifo;
+  char ack;
+  int ret;
+
+  ret = a2dp_fifo_create(&fifo, common->buffer_sz);
+  if (ret < 0) {
+    ERROR("failed to create fifo (%s)", strerror(-ret));
+    return -1;
+  }
+
+  /* a stack without shared memory support fails the command, otherwise it
+     acks once for the descriptors and again once it has mapped them */
+  if (a2dp_command(common, A2DP_CTRL_CMD_SHM_DATAPATH) != 0 ||
+      a2dp_fifo_send_fds(common->ctrl_fd, &fifo) < 0 ||
+      a2dp_ctrl_receive(common, &ack, 1) < 0 || ack != A2DP_CTRL_ACK_SUCCESS) {
+    WARN("stack did not take the fifo, using the data socket");
+    a2dp_fifo_destroy(&fifo);
+    return -1;
+  }
+
+  common->fifo = fifo;
+  INFO("pcm over shared memory fifo (%u bytes)", fifo.size);
+  return 0;
+}
+
+static void a2dp_close_audio_datapath(struct a2dp_stream_common* common) {
+  /* wakes up a concurrent out_write(), the mapping stays until the next
+     start or until the stream is closed */
+  a2dp_fifo_close(&common->fifo);
+  skt_disconnect(common->audio_fd);
+  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+}
+
 static int start_audio_datapath(struct a2dp_stream_common* common) {
   INFO("state %d", common->state);
 
@@ -968,6 +1017,8 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
 
   /* connect socket if not yet connected */
   if (common->audio_fd == AUDIO_SKT_DISCONNECTED) {
+    /* the previous FIFO was only closed in case a write was still in it */
+    a2dp_fifo_destroy(&common->fifo);
     ERROR("Try opening data socket");
     common->audio_fd = skt_connect(A2DP_DATA_PATH, common->buffer_sz);
     if (common->audio_fd < 0) {
@@ -983,6 +1034,8 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
         ERROR("Audiopath start failed - error opening data socket");
         goto error;
       }
+    } else if (a2dp_shm_datapath_enabled()) {
+      a2dp_open_shm_datapath(common);
     }
   }
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STARTED;
@@ -1017,8 +1070,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STOPPED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_close_audio_datapath(common);
 
   return 0;
 }
@@ -1044,9 +1096,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
     common->state = AUDIO_A2DP_STATE_SUSPENDED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_close_audio_datapath(common);
   return 0;
 }
 
@@ -1060,6 +1110,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
                          size_t bytes) {
   struct a2dp_stream_out* out = (struct a2dp_stream_out*)stream;
   int sent = -1;
+  bool use_fifo;
   #ifdef BT_AUDIO_SYSTRACE_LOG
   char trace_buf[512];
   #endif
@@ -1106,6 +1157,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  use_fifo = a2dp_fifo_is_open(&out->common.fifo);
   lock.unlock();
   #ifdef BT_AUDIO_SYSTRACE_LOG
   snprintf(trace_buf, 32, "out_write:");
@@ -1114,7 +1166,13 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ATRACE_BEGIN(trace_buf);
   }
   #endif
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (use_fifo) {
+    sent = a2dp_fifo_write(&out->common.fifo, buffer, write_bytes,
+                           SOCK_SEND_TIMEOUT_MS);
+    if (sent == -1) ERROR("fifo write failed (%s)", strerror(errno));
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   #ifdef BT_AUDIO_SYSTRACE_LOG
   if (PERF_SYSTRACE)
   {
@@ -1130,8 +1188,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ERROR("ignore data write failure");
     }
 
-    skt_disconnect(out->common.audio_fd);
-    out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    a2dp_close_audio_datapath(&out->common);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
             (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "audio_a2dp_hw/include/audio_a2dp_hw.h"
+#include "audio_a2dp_hw/include/audio_a2dp_hw_fifo.h"
+
+namespace {
+
+// 20 ms of 48 kHz stereo 16 bit, what AudioFlinger writes and the encoder
+// reads per tick.
+constexpr size_t kPeriodBytes = 48 * 20 * 2 * 2;
+constexpr int kPeriodMs = 20;
+constexpr int kReadPollMs = 10;  // A2DP_DATA_READ_POLL_MS in the stack
+constexpr int kWritePollMs = 20;  // WRITE_POLL_MS in the HAL
+constexpr int kSendTimeoutMs = 2000;
+constexpr int kStreamPeriods = 40;
+
+uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t thread_cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Each period starts with its sequence number and write time, the rest is a
+// pattern derived from the sequence number.
+void fill_period(uint8_t* p, uint64_t seq) {
+  uint64_t ts = now_ns();
+  memcpy(p, &seq, sizeof(seq));
+  memcpy(p + 8, &ts, sizeof(ts));
+  for (size_t i = 16; i < kPeriodBytes; i++) p[i] = (uint8_t)(seq * 31 + i);
+}
+
+bool check_period(const uint8_t* p, uint64_t seq, uint64_t* ts) {
+  uint64_t got;
+  memcpy(&got, p, sizeof(got));
+  memcpy(ts, p + 8, sizeof(*ts));
+  if (got != seq) return false;
+  for (size_t i = 16; i < kPeriodBytes; i++)
+    if (p[i] != (uint8_t)(seq * 31 + i)) return false;
+  return true;
+}
+
+int recv_fds(int sock, int* fds, int max_fds) {
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int) * A2DP_FIFO_NUM_FDS)];
+  } ctrl;
+  uint8_t byte;
+  struct iovec iov = {&byte, sizeof(byte)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+  if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1) return -1;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS) return -1;
+  int n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+  n = std::min(n, max_fds);
+  memcpy(fds, CMSG_DATA(cmsg), n * sizeof(int));
+  return n;
+}
+
+// Creates a FIFO on the "HAL" side and maps it on the "stack" side through
+// descriptors passed over a unix socket, as the control channel does.
+void create_pair(tA2DP_FIFO* writer, tA2DP_FIFO* reader, size_t size) {
+  int sv[2];
+  int fds[A2DP_FIFO_NUM_FDS];
+
+  ASSERT_EQ(0, a2dp_fifo_create(writer, size));
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  ASSERT_EQ(0, a2dp_fifo_send_fds(sv[0], writer));
+  ASSERT_EQ(A2DP_FIFO_NUM_FDS, recv_fds(sv[1], fds, A2DP_FIFO_NUM_FDS));
+  close(sv[0]);
+  close(sv[1]);
+  ASSERT_EQ(0, a2dp_fifo_attach(reader, fds));
+}
+
+// The legacy transport: non blocking send with a sleep when the socket is
+// full on the HAL side, poll and recv on the stack side.
+class SocketTransport {
+ public:
+  explicit SocketTransport(int buffer_sz) {
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv_);
+    setsockopt(sv_[0], SOL_SOCKET, SO_SNDBUF, &buffer_sz, sizeof(buffer_sz));
+    setsockopt(sv_[1], SOL_SOCKET, SO_RCVBUF, &buffer_sz, sizeof(buffer_sz));
+  }
+  ~SocketTransport() {
+    close(sv_[0]);
+    close(sv_[1]);
+  }
+
+  ssize_t write(const uint8_t* p, size_t len) {
+    int ms_timeout = kSendTimeoutMs;
+    size_t count = 0;
+    while (count < len) {
+      ssize_t sent =
+          send(sv_[0], p + count, len - count, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+        if (ms_timeout < kWritePollMs) return -1;
+        usleep(kWritePollMs * 1000);
+        ms_timeout -= kWritePollMs;
+        continue;
+      }
+      count += sent;
+    }
+    return count;
+  }
+
+  size_t read(uint8_t* p, size_t len) {
+    size_t n_read = 0;
+    while (n_read < len) {
+      struct pollfd pfd = {sv_[1], POLLIN, 0};
+      if (poll(&pfd, 1, kReadPollMs) <= 0) break;
+      ssize_t n = recv(sv_[1], p + n_read, len - n_read, 0);
+      if (n <= 0) break;
+      n_read += n;
+    }
+    return n_read;
+  }
+
+  void close_writer() { shutdown(sv_[0], SHUT_WR); }
+
+ private:
+  int sv_[2];
+};
+
+class FifoTransport {
+ public:
+  explicit FifoTransport(size_t buffer_sz) {
+    create_pair(&writer_, &reader_, buffer_sz);
+  }
+  ~FifoTransport() {
+    a2dp_fifo_destroy(&writer_);
+    a2dp_fifo_destroy(&reader_);
+  }
+
+  ssize_t write(const uint8_t* p, size_t len) {
+    return a2dp_fifo_write(&writer_, p, len, kSendTimeoutMs);
+  }
+  size_t read(uint8_t* p, size_t len) {
+    return a2dp_fifo_read(&reader_, p, len, kReadPollMs);
+  }
+  void close_writer() { a2dp_fifo_close(&writer_); }
+
+ private:
+  tA2DP_FIFO writer_;
+  tA2DP_FIFO reader_;
+};
+
+struct StreamStats {
+  bool intact = true;
+  int periods = 0;
+  int underflows = 0;
+  std::vector<uint64_t> latency_ns;
+  uint64_t writer_cpu_ns = 0;
+  uint64_t reader_cpu_ns = 0;
+  uint64_t wall_ns = 0;
+};
+
+// AudioFlinger on one side writing whole periods as fast as the transport
+// takes them, the encoder on the other reading one period per tick.
+template <typename Transport>
+StreamStats stream_pcm(Transport& transport) {
+  StreamStats stats;
+  uint64_t start = now_ns();
+
+  std::thread writer([&] {
+    std::vector<uint8_t> period(kPeriodBytes);
+    uint64_t cpu = thread_cpu_ns();
+    for (uint64_t seq = 0; seq < kStreamPeriods; seq++) {
+      fill_period(period.data(), seq);
+      if (transport.write(period.data(), kPeriodBytes) != (ssize_t)kPeriodBytes)
+        break;
+    }
+    stats.writer_cpu_ns = thread_cpu_ns() - cpu;
+  });
+
+  std::thread reader([&] {
+    std::vector<uint8_t> period(kPeriodBytes);
+    uint64_t cpu = thread_cpu_ns();
+    uint64_t tick = now_ns();
+    size_t have = 0;
+    uint64_t seq = 0;
+    int idle_ticks = 0;
+    while (seq < kStreamPeriods && idle_ticks < 10) {
+      tick += kPeriodMs * 1000000ULL;
+      size_t n = transport.read(period.data() + have, kPeriodBytes - have);
+      idle_ticks = n ? 0 : idle_ticks + 1;
+      have += n;
+      if (have < kPeriodBytes) {
+        stats.underflows++;
+      } else {
+        uint64_t ts;
+        if (!check_period(period.data(), seq, &ts)) stats.intact = false;
+        stats.latency_ns.push_back(now_ns() - ts);
+        stats.periods++;
+        seq++;
+        have = 0;
+      }
+      uint64_t now = now_ns();
+      if (tick > now) usleep((tick - now) / 1000);
+    }
+    stats.reader_cpu_ns = thread_cpu_ns() - cpu;
+  });
+
+  writer.join();
+  reader.join();
+  stats.wall_ns = now_ns() - start;
+  return stats;
+}
+
+void report(const char* name, StreamStats& stats) {
+  std::sort(stats.latency_ns.begin(), stats.latency_ns.end());
+  uint64_t p50 = 0, p99 = 0;
+  if (!stats.latency_ns.empty()) {
+    p50 = stats.latency_ns[stats.latency_ns.size() / 2];
+    p99 = stats.latency_ns[stats.latency_ns.size() * 99 / 100];
+  }
+  printf("%-7s %d periods, %d underflows, latency p50 %.2f ms p99 %.2f ms, "
+         "cpu writer %.3f%% reader %.3f%%\n",
+         name, stats.periods, stats.underflows, p50 / 1e6, p99 / 1e6,
+         100.0 * stats.writer_cpu_ns / stats.wall_ns,
+         100.0 * stats.reader_cpu_ns / stats.wall_ns);
+}
+
+}  // namespace
+
+class AudioA2dpHwFifoTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    a2dp_fifo_init(&writer_);
+    a2dp_fifo_init(&reader_);
+  }
+  void TearDown() override {
+    a2dp_fifo_destroy(&writer_);
+    a2dp_fifo_destroy(&reader_);
+  }
+
+  tA2DP_FIFO writer_;
+  tA2DP_FIFO reader_;
+};
+
+TEST_F(AudioA2dpHwFifoTest, test_write_read_wraps) {
+  create_pair(&writer_, &reader_, A2DP_FIFO_MIN_SIZE);
+  ASSERT_EQ(A2DP_FIFO_MIN_SIZE, (int)reader_.size);
+
+  std::vector<uint8_t> in(1000), out(1000);
+  uint8_t value = 0;
+  // 1000 does not divide the ring size, so every write ends up wrapping
+  for (int i = 0; i < 50; i++) {
+    for (auto& b : in) b = value++;
+    ASSERT_EQ((ssize_t)in.size(), a2dp_fifo_write(&writer_, in.data(), in.size(), 0));
+    ASSERT_EQ(out.size(), a2dp_fifo_read(&reader_, out.data(), out.size(), 0));
+    ASSERT_EQ(in, out);
+  }
+  // empty now, a read times out short
+  EXPECT_EQ(0u, a2dp_fifo_read(&reader_, out.data(), out.size(), 1));
+}
+
+TEST_F(AudioA2dpHwFifoTest, test_full_write_times_out) {
+  create_pair(&writer_, &reader_, A2DP_FIFO_MIN_SIZE);
+  std::vector<uint8_t> buf(A2DP_FIFO_MIN_SIZE);
+
+  ASSERT_EQ((ssize_t)buf.size(), a2dp_fifo_write(&writer_, buf.data(), buf.size(), 0));
+  EXPECT_EQ(-1, a2dp_fifo_write(&writer_, buf.data(), 1, 5));
+  EXPECT_EQ(ETIMEDOUT, errno);
+}
+
+TEST_F(AudioA2dpHwFifoTest, test_close_wakes_blocked_writer) {
+  create_pair(&writer_, &reader_, A2DP_FIFO_MIN_SIZE);
+  std::vector<uint8_t> buf(A2DP_FIFO_MIN_SIZE * 2);
+  ssize_t ret = 0;
+  int err = 0;
+
+  uint64_t start = now_ns();
+  std::thread writer([&] {
+    ret = a2dp_fifo_write(&writer_, buf.data(), buf.size(), kSendTimeoutMs);
+    err = errno;
+  });
+  usleep(20 * 1000);
+  a2dp_fifo_close(&reader_);
+  writer.join();
+
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(EPIPE, err);
+  EXPECT_LT(now_ns() - start, kSendTimeoutMs * 1000000ULL / 2);
+  // what was written before the close can still be drained
+  EXPECT_EQ((size_t)A2DP_FIFO_MIN_SIZE,
+            a2dp_fifo_read(&reader_, buf.data(), buf.size(), 0));
+}
+
+TEST_F(AudioA2dpHwFifoTest, test_attach_rejects_unsealed_memfd) {
+  int fds[A2DP_FIFO_NUM_FDS];
+
+  fds[A2DP_FIFO_MEM_FD] = memfd_create("a2dp_fifo_test", MFD_CLOEXEC);
+  ASSERT_GE(fds[A2DP_FIFO_MEM_FD], 0);
+  ASSERT_EQ(0, ftruncate(fds[A2DP_FIFO_MEM_FD],
+                         sizeof(struct a2dp_fifo_shared) + A2DP_FIFO_MIN_SIZE));
+  fds[A2DP_FIFO_DATA_FD] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  fds[A2DP_FIFO_SPACE_FD] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  EXPECT_EQ(-EINVAL, a2dp_fifo_attach(&reader_, fds));
+  EXPECT_FALSE(a2dp_fifo_is_open(&reader_));
+}
+
+TEST_F(AudioA2dpHwFifoTest, test_attach_rejects_bad_header) {
+  ASSERT_EQ(0, a2dp_fifo_create(&writer_, A2DP_FIFO_MIN_SIZE));
+  writer_.shm->size = A2DP_FIFO_MAX_SIZE;
+
+  int fds[A2DP_FIFO_NUM_FDS];
+  for (int i = 0; i < A2DP_FIFO_NUM_FDS; i++) fds[i] = dup(writer_.fds[i]);
+  EXPECT_EQ(-EINVAL, a2dp_fifo_attach(&reader_, fds));
+}
+
+TEST_F(AudioA2dpHwFifoTest, test_stream_pcm_fifo_vs_socket) {
+  FifoTransport fifo(AUDIO_STREAM_OUTPUT_BUFFER_SZ);
+  StreamStats fifo_stats = stream_pcm(fifo);
+  fifo.close_writer();
+
+  SocketTransport socket(AUDIO_STREAM_OUTPUT_BUFFER_SZ);
+  StreamStats socket_stats = stream_pcm(socket);
+  socket.close_writer();
+
+  report("fifo", fifo_stats);
+  report("socket", socket_stats);
+
+  EXPECT_TRUE(fifo_stats.intact);
+  EXPECT_TRUE(socket_stats.intact);
+  EXPECT_EQ(kStreamPeriods, fifo_stats.periods);
+  EXPECT_EQ(kStreamPeriods, socket_stats.periods);
+}
@@ -57,4 +57,14 @@ void btif_a2dp_control_reset_audio_delay(int index);
 uint16_t btif_a2dp_control_get_audio_delay(int index);
 
 void btif_a2dp_pending_cmds_reset(void);
+
+// Reads up to |len| bytes of audio into |p_buf| from the shared memory FIFO
+// the audio HAL set up, waiting as long as a data socket read would.
+// |p_bytes_read| is set to the number of bytes read.
+// Returns false if there is no FIFO and the data socket has to be read.
+bool btif_a2dp_control_shm_read(uint8_t* p_buf, uint32_t len,
+                                uint32_t* p_bytes_read);
+
+// Closes the shared memory FIFO, if any, together with the data socket.
+void btif_a2dp_control_shm_close(void);
 #endif /* BTIF_A2DP_CONTROL_H */
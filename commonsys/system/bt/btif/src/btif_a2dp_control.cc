@@ -26,6 +26,7 @@
 #include <base/logging.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <mutex>
 
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
@@ -42,6 +43,7 @@
 #include "osi/include/osi.h"
 #include "uipc.h"
 #include "btif_a2dp_audio_interface.h"
+#include "audio_a2dp_hw/include/audio_a2dp_hw_fifo.h"
 
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
 #include "a2dp_hal_sim/audio_a2dp_hal.h"
@@ -77,6 +79,12 @@ static char a2dp_hal_imp[PROPERTY_VALUE_MAX] = "false";
 
 bool is_block_hal_start = false;
 
+/* Shared memory FIFO the audio HAL may hand over instead of writing the data
+ * socket. Mapped on the UIPC thread, read on the media thread.
+ */
+static std::mutex a2dp_shm_mutex;
+static tA2DP_FIFO a2dp_shm_fifo = {NULL, NULL, 0, 0, 0, {-1, -1, -1}};
+
 void btif_a2dp_control_init(void) {
   a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
   a2dp_cmd_queued = A2DP_CTRL_CMD_NONE;
@@ -94,6 +102,65 @@ void btif_a2dp_control_init(void) {
 void btif_a2dp_control_cleanup(void) {
   /* This calls blocks until UIPC is fully closed */
   UIPC_Close(UIPC_CH_ID_ALL);
+  btif_a2dp_control_shm_close();
+}
+
+/* Maps the FIFO sent by the audio HAL. Answers on its own, outside the
+ * pending command tracking, as it never reaches the state machine.
+ */
+static void btif_a2dp_recv_shm_datapath(void) {
+  uint8_t ack = A2DP_CTRL_ACK_SUCCESS;
+  uint8_t byte;
+  int fds[A2DP_FIFO_NUM_FDS];
+  tA2DP_FIFO fifo;
+  int n, ret;
+
+  /* ask for the descriptors */
+  UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &ack, sizeof(ack));
+
+  n = UIPC_ReadFds(UIPC_CH_ID_AV_CTRL, &byte, sizeof(byte), fds,
+                   A2DP_FIFO_NUM_FDS);
+  if (n != A2DP_FIFO_NUM_FDS) {
+    APPL_TRACE_ERROR("%s: expected %d descriptors, got %d", __func__,
+                     A2DP_FIFO_NUM_FDS, n);
+    for (int i = 0; i < n; i++) close(fds[i]);
+    ack = A2DP_CTRL_ACK_FAILURE;
+    UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &ack, sizeof(ack));
+    return;
+  }
+
+  ret = a2dp_fifo_attach(&fifo, fds);
+  if (ret < 0) {
+    APPL_TRACE_ERROR("%s: cannot map fifo (%s)", __func__, strerror(-ret));
+    ack = A2DP_CTRL_ACK_FAILURE;
+  } else {
+    std::lock_guard<std::mutex> lock(a2dp_shm_mutex);
+    a2dp_fifo_destroy(&a2dp_shm_fifo);
+    a2dp_shm_fifo = fifo;
+    APPL_TRACE_IMP("%s: pcm over shared memory fifo (%u bytes)", __func__,
+                   fifo.size);
+  }
+  UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &ack, sizeof(ack));
+}
+
+bool btif_a2dp_control_shm_read(uint8_t* p_buf, uint32_t len,
+                                uint32_t* p_bytes_read) {
+  std::lock_guard<std::mutex> lock(a2dp_shm_mutex);
+
+  if (!a2dp_fifo_is_open(&a2dp_shm_fifo)) return false;
+  *p_bytes_read =
+      a2dp_fifo_read(&a2dp_shm_fifo, p_buf, len, A2DP_DATA_READ_POLL_MS);
+  return true;
+}
+
+void btif_a2dp_control_shm_close(void) {
+  std::lock_guard<std::mutex> lock(a2dp_shm_mutex);
+
+  if (!a2dp_fifo_is_open(&a2dp_shm_fifo)) return;
+  APPL_TRACE_DEBUG("%s", __func__);
+  /* wakes up the HAL if it waits for room */
+  a2dp_fifo_close(&a2dp_shm_fifo);
+  a2dp_fifo_destroy(&a2dp_shm_fifo);
 }
 
 static void btif_a2dp_recv_ctrl_data(void) {
@@ -109,11 +176,17 @@ static void btif_a2dp_recv_ctrl_data(void) {
   if (n == 0) {
     APPL_TRACE_WARNING("%s: CTRL CH DETACHED", __func__);
     UIPC_Close(UIPC_CH_ID_AV_CTRL);
+    btif_a2dp_control_shm_close();
     return;
   }
 
   APPL_TRACE_DEBUG("btif_a2dp_recv_ctrl_data: %s", audio_a2dp_hw_dump_ctrl_event(cmd));
 
+  if (cmd == A2DP_CTRL_CMD_SHM_DATAPATH) {
+    btif_a2dp_recv_shm_datapath();
+    return;
+  }
+
   if (property_get("persist.vendor.bt.a2dp.hal.implementation", a2dp_hal_imp, "false") &&
           !strcmp(a2dp_hal_imp, "true")) {
     switch (cmd) {
@@ -902,6 +975,7 @@ static void btif_a2dp_data_cb(UNUSED_ATTR tUIPC_CH_ID ch_id,
 
     case UIPC_CLOSE_EVT:
       APPL_TRACE_EVENT("%s: ## AUDIO PATH DETACHED ##", __func__);
+      btif_a2dp_control_shm_close();
 
       if (property_get("persist.vendor.bt.a2dp.hal.implementation", a2dp_hal_imp, "false") &&
             !strcmp(a2dp_hal_imp, "true")) {
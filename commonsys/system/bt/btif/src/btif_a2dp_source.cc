@@ -984,8 +984,10 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
         bluetooth::audio::a2dp::read(p_buf, sizeof(p_buf)));
 #endif
   } else {
-    btif_a2dp_control_log_bytes_read(
-       UIPC_Read(UIPC_CH_ID_AV_AUDIO, &event, p_buf, sizeof(p_buf)));
+    uint32_t bytes_read;
+    if (!btif_a2dp_control_shm_read(p_buf, sizeof(p_buf), &bytes_read))
+      bytes_read = UIPC_Read(UIPC_CH_ID_AV_AUDIO, &event, p_buf, sizeof(p_buf));
+    btif_a2dp_control_log_bytes_read(bytes_read);
   }
 
 
@@ -995,6 +997,7 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
 
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     UIPC_Close(UIPC_CH_ID_AV_AUDIO);
+    btif_a2dp_control_shm_close();
   }
   /*
    * Try to send acknowldegment once the media stream is
@@ -1098,7 +1101,7 @@ static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
 #else
     bytes_read = bluetooth::audio::a2dp::read(p_buf, len);
 #endif
-  } else {
+  } else if (!btif_a2dp_control_shm_read(p_buf, len, &bytes_read)) {
     bytes_read = UIPC_Read(UIPC_CH_ID_AV_AUDIO, &event, p_buf, len);
   }
   if (bytes_read < len) {
@@ -112,6 +112,20 @@ bool UIPC_Send(tUIPC_CH_ID ch_id, uint16_t msg_evt, const uint8_t* p_buf,
 uint32_t UIPC_Read(tUIPC_CH_ID ch_id, uint16_t* p_msg_evt, uint8_t* p_buf,
                    uint32_t len);
 
+/*******************************************************************************
+ *
+ * Function         UIPC_ReadFds
+ *
+ * Description      Called to read a message carrying file descriptors
+ *                  (SCM_RIGHTS) from UIPC. Up to |max_fds| descriptors are
+ *                  stored in |p_fds|, the caller owns them.
+ *
+ * Returns          number of descriptors received, -1 on failure
+ *
+ ******************************************************************************/
+int UIPC_ReadFds(tUIPC_CH_ID ch_id, uint8_t* p_buf, uint32_t len, int* p_fds,
+                 int max_fds);
+
 /*******************************************************************************
  *
  * Function         UIPC_Ioctl
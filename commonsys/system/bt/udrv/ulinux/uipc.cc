@@ -74,6 +74,8 @@
 
 #define UIPC_FLUSH_BUFFER_SIZE 1024
 
+#define UIPC_MAX_RX_FDS 4
+
 #define CHAN_CREATE_WAIT_TIME_MS 30
 #define CHAN_CREATE_RETRY_COUNT 10
 
@@ -742,6 +744,91 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
   return n_read;
 }
 
+/*******************************************************************************
+ **
+ ** Function         UIPC_ReadFds
+ **
+ ** Description      Called to read a message carrying file descriptors
+ **                  (SCM_RIGHTS) from UIPC.
+ **
+ ** Returns          number of descriptors received, -1 on failure.
+ **
+ ******************************************************************************/
+
+int UIPC_ReadFds(tUIPC_CH_ID ch_id, uint8_t* p_buf, uint32_t len, int* p_fds,
+                 int max_fds) {
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int) * UIPC_MAX_RX_FDS)];
+  } ctrl;
+  struct iovec iov;
+  struct msghdr msg;
+  struct pollfd pfd;
+  int fd;
+  int n_fds = 0;
+
+  if (ch_id >= UIPC_CH_NUM || max_fds > UIPC_MAX_RX_FDS) {
+    BTIF_TRACE_ERROR("UIPC_ReadFds : invalid ch id %d", ch_id);
+    return -1;
+  }
+
+  fd = uipc_main.ch[ch_id].fd;
+
+  if (fd == UIPC_DISCONNECTED) {
+    BTIF_TRACE_ERROR("UIPC_ReadFds : channel %d closed", ch_id);
+    return -1;
+  }
+
+  pfd.fd = fd;
+  pfd.events = POLLIN | POLLHUP;
+
+  int poll_ret;
+  OSI_NO_INTR(poll_ret = poll(&pfd, 1, uipc_main.ch[ch_id].read_poll_tmo_ms));
+  if (poll_ret <= 0 || (pfd.revents & (POLLHUP | POLLNVAL))) {
+    BTIF_TRACE_WARNING("UIPC_ReadFds : no message (poll %d revents %x)",
+                       poll_ret, pfd.revents);
+    return -1;
+  }
+
+  iov.iov_base = p_buf;
+  iov.iov_len = len;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+
+  ssize_t n;
+  OSI_NO_INTR(n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC));
+  if (n <= 0) {
+    BTIF_TRACE_WARNING("UIPC_ReadFds : read failed (%s)",
+                       n ? strerror(errno) : "detached");
+    return -1;
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    int* fds = (int*)CMSG_DATA(cmsg);
+    for (int i = 0; i < count; i++) {
+      if (n_fds < max_fds)
+        p_fds[n_fds++] = fds[i];
+      else
+        close(fds[i]);
+    }
+  }
+
+  if (msg.msg_flags & MSG_CTRUNC) {
+    BTIF_TRACE_WARNING("UIPC_ReadFds : descriptors truncated");
+    for (int i = 0; i < n_fds; i++) close(p_fds[i]);
+    return -1;
+  }
+
+  return n_fds;
+}
+
 /*******************************************************************************
  *
  * Function         UIPC_Ioctl
@@ -40,6 +40,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPA_CONNTRACK_MESSAGE_H
 
 #include <pthread.h>
+#include <string.h>
+#include <time.h>
 #include "IPACM_Defs.h"
 
 
@@ -60,6 +62,45 @@ typedef struct cmd_s
 	ipacm_cmd_q_data data;
 }cmd_t;
 
+/* Events are queued on one of these lanes and the command queue thread
+   serves them in this order. Internal events always go first since they
+   continue the handling of an event that was already dispatched. The fast
+   and slow lanes are only used when EventPriorityLanes is set in
+   IPACM_cfg.xml, otherwise every external event goes to the normal lane. */
+typedef enum
+{
+	IPACM_EVT_LANE_INTERNAL = 0,  /* events raised by IPACM itself */
+	IPACM_EVT_LANE_FAST,          /* conntrack and neighbor updates */
+	IPACM_EVT_LANE_NORMAL,        /* all other external events */
+	IPACM_EVT_LANE_SLOW,          /* configuration and XML reloads */
+	IPACM_EVT_LANE_MAX
+} ipacm_evt_lane;
+
+/* a waiting lane is served at least once every this many events */
+#define IPACM_EVT_LANE_BURST 16
+
+/* free Message items kept for reuse */
+#define IPACM_MSG_POOL_MAX 256
+
+typedef struct
+{
+	uint32_t depth;               /* events queued right now */
+	uint32_t max_depth;
+	uint64_t posted;
+} ipacm_lane_stats;
+
+typedef struct
+{
+	uint32_t count;               /* listener callbacks run */
+	uint32_t dispatched;          /* events taken off the queue */
+	uint64_t wait_us;             /* total time spent queued */
+	uint32_t max_wait_us;
+	uint64_t run_us;              /* total time in listener callbacks */
+	uint32_t max_run_us;
+} ipacm_event_stat;
+
+extern ipacm_event_stat ipacm_event_stats[IPACM_EVENT_MAX];
+
 class Message
 {
 private:
@@ -67,6 +108,7 @@ private:
 
 public:
 	cmd_t evt;
+	struct timespec post_time;
 
 	Message()
 	{
@@ -84,25 +126,43 @@ class MessageQueue
 private:
 	Message *Head;
 	Message *Tail;
+	ipacm_lane_stats stats;
+	uint32_t skipped;
 	Message* dequeue(void);
-	static MessageQueue *inst_internal;
-	static MessageQueue *inst_external;
+	static MessageQueue *inst[IPACM_EVT_LANE_MAX];
+	static Message *free_items;
+	static int num_free_items;
 
 	MessageQueue()
 	{
 		Head = NULL;
 		Tail = NULL;
+		skipped = 0;
+		memset(&stats, 0, sizeof(stats));
 	}
 
+	static Message* dequeueNext(void);
+	static void recordStats(Message *item, struct timespec *start, struct timespec *end);
+
 public:
 
 	~MessageQueue() { }
 	void enqueue(Message *item);
 
 	static void* Process(void *);
+	static MessageQueue* getInstance(ipacm_evt_lane lane);
 	static MessageQueue* getInstanceInternal();
 	static MessageQueue* getInstanceExternal();
 
+	/* lane an event is queued on */
+	static ipacm_evt_lane getLane(ipa_cm_event_id event);
+	static const char* getLaneName(ipacm_evt_lane lane);
+
+	/* must be called with the command queue mutex held */
+	static Message* getItem(void);
+	static void putItem(Message *item);
+
+	static int getLaneStats(ipacm_evt_lane lane, ipacm_lane_stats *out);
 };
 
 #endif  /* IPA_CONNTRACK_MESSAGE_H */
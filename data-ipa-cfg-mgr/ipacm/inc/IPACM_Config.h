@@ -123,6 +123,9 @@ public:
 
 	bool ipacm_ip_passthrough_mode;
 
+	/* queue conntrack/neighbor and config reload events on their own lanes */
+	bool ipacm_evt_priority_lanes;
+
 	int ipa_nat_iface_entries;
 
 	/* Store the total number of wlan guest ap configured */
@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ConntrackBatch.h
+
+	@brief
+	This file defines the batched receive path for conntrack events: the
+	datagrams of a netlink socket are taken several at a time with
+	recvmmsg(), parsed, and the events of one batch are coalesced per
+	5-tuple before they are handed on.
+*/
+#ifndef IPACM_CONNTRACK_BATCH_H
+#define IPACM_CONNTRACK_BATCH_H
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+extern "C"
+{
+#include <libnetfilter_conntrack/libnetfilter_conntrack.h>
+}
+
+/* datagrams taken per recvmmsg() */
+#define CT_BATCH_MSGS 32
+/* a conntrack event is a few hundred bytes, one page holds any of them */
+#define CT_BATCH_MSG_SIZE 4096
+/* events held for coalescing before they are handed on */
+#define CT_BATCH_MAX_EVENTS 256
+/* slots of the 5-tuple index, a power of 2 at least twice CT_BATCH_MAX_EVENTS */
+#define CT_BATCH_TUPLE_SLOTS 512
+/* receive buffer asked for on the conntrack event sockets */
+#define CT_BATCH_RCVBUF_SIZE (2 * 1024 * 1024)
+
+/* same contract as a libnetfilter_conntrack callback, except that the
+ * callback always owns ct afterwards */
+typedef int (*ct_batch_cb)(enum nf_conntrack_msg_type, struct nf_conntrack *, void *);
+
+typedef struct
+{
+	uint64_t recv_calls;          /* recvmmsg() calls that returned data */
+	uint64_t datagrams;
+	uint64_t events;              /* conntrack messages parsed */
+	uint64_t delivered;           /* events handed to the callback */
+	uint64_t coalesced;           /* events folded into a later one of the same 5-tuple */
+	uint64_t cancelled;           /* events of connections opened and closed within a batch */
+	uint64_t filtered;            /* events of a type nobody asked for */
+	uint64_t overruns;            /* ENOBUFS, the socket dropped events */
+	uint64_t truncated;           /* datagrams larger than CT_BATCH_MSG_SIZE */
+	uint64_t parse_errors;
+	uint64_t resyncs;
+} ct_batch_stats;
+
+typedef struct
+{
+	uint8_t l3proto;
+	uint8_t l4proto;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint32_t src[4];
+	uint32_t dst[4];
+} ct_batch_tuple;
+
+typedef struct
+{
+	struct nf_conntrack *ct;      /* NULL once cancelled */
+	enum nf_conntrack_msg_type type;
+	ct_batch_tuple tuple;
+} ct_batch_event;
+
+class IPACM_ConntrackBatch
+{
+private:
+	int fd;
+	int msgs_per_call;
+	bool coalesce;
+	unsigned int type_mask;
+	ct_batch_cb cb;
+	void *cb_data;
+
+	char *bufs;
+	struct mmsghdr msgs[CT_BATCH_MSGS];
+	struct iovec iovs[CT_BATCH_MSGS];
+	struct sockaddr_nl addrs[CT_BATCH_MSGS];
+
+	ct_batch_event events[CT_BATCH_MAX_EVENTS];
+	int num_events;
+	/* index into events per 5-tuple slot, -1 if free */
+	int16_t tuple_slots[CT_BATCH_TUPLE_SLOTS];
+
+	bool resync_pending;
+	ct_batch_stats stats;
+
+	static void GetTuple(struct nf_conntrack *, ct_batch_tuple *);
+	static uint32_t TupleHash(const ct_batch_tuple *);
+	void ParseDatagram(char *, int);
+
+public:
+	/* type_mask is a mask of NFCT_T_NEW/UPDATE/DESTROY, other events are dropped */
+	IPACM_ConntrackBatch(ct_batch_cb, void *, unsigned int type_mask);
+	~IPACM_ConntrackBatch();
+
+	/* msgs_per_call of 1 with coalesce off reads one event at a time */
+	int Init(int fd, int msgs_per_call = CT_BATCH_MSGS, bool coalesce = true);
+
+	/* grow the socket receive buffer, SO_RCVBUFFORCE first */
+	int SetRcvBuf(int size);
+
+	/* block until at least one datagram is in, then hand on everything
+	 * received; returns the number of datagrams, 0 after an overrun or a
+	 * signal, -1 on other socket errors */
+	int Receive(void);
+
+	/* queue one event, takes ownership of ct */
+	void Add(struct nf_conntrack *, enum nf_conntrack_msg_type);
+	/* hand on the queued events */
+	void Flush(void);
+
+	/* true after an overrun until ResyncDone() */
+	inline bool ResyncPending(void)
+	{
+		return resync_pending;
+	}
+	void ResyncDone(bool);
+
+	void GetStats(ct_batch_stats *);
+};
+
+#endif /* IPACM_CONNTRACK_BATCH_H */
@@ -38,6 +38,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <errno.h>
 
 #include "IPACM_ConntrackClient.h"
+#include "IPACM_ConntrackBatch.h"
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Conntrack_NATApp.h"
 #include "IPACM_EvtDispatcher.h"
@@ -72,6 +73,12 @@ private:
    static int IPA_Conntrack_Filters_Ignore_Local_Addrs(struct nfct_filter *filter);
    static int IPA_Conntrack_Filters_Ignore_Bridge_Addrs(struct nfct_filter *filter);
    static int IPA_Conntrack_Filters_Ignore_Local_Iface(struct nfct_filter *, ipacm_event_iface_up *);
+   static int ReceiveConnTrackEvents(struct nfct_handle *, uint8_t, unsigned int);
+   static int ResyncConnTrack(IPACM_ConntrackBatch *, uint8_t);
+   static int PostResyncEvt(uint8_t, ipacm_ct_resync_phase);
+   static int ResyncDumpCB(enum nf_conntrack_msg_type type,
+                           struct nf_conntrack *ct,
+                           void *data);
    IPACM_ConntrackClient();
 
 public:
@@ -104,6 +104,7 @@ private:
 	int CheckNatIface(ipacm_event_data_all *, bool *);
 	void HandleNonNatIPAddr(void *, bool);
 	void HandleNatTableMove(void *in_param);
+	void HandleCTResync(void *in_param);
 
 #ifdef CT_OPT
 	void ProcessCTV6Message(void *);
@@ -35,6 +35,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "IPACM_Config.h"
 #include "IPACM_Xml.h"
+#include "IPACM_Conntrack_NATCache.h"
 
 extern "C"
 {
@@ -47,29 +48,19 @@ extern "C"
 #define IPACM_TCP_FULL_FILE_NAME  "/proc/sys/net/ipv4/netfilter/ip_conntrack_tcp_timeout_established"
 #define IPACM_UDP_FULL_FILE_NAME   "/proc/sys/net/ipv4/netfilter/ip_conntrack_udp_timeout_stream"
 
-typedef struct _nat_table_entry
-{
-	uint32_t private_ip;
-	uint16_t private_port;
-
-	uint32_t target_ip;
-	uint16_t target_port;
-
-	uint32_t public_ip;
-	uint16_t public_port;
+#define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
 
-	u_int8_t  protocol;
-	uint32_t timestamp;
+/* Upper bound on the UDP timestamp sweep interval, seconds */
+#define UDP_SWEEP_MAX_INTERVAL 60
+/* Active UDP flows that stretch the sweep interval by a second */
+#define UDP_SWEEP_FLOWS_PER_SEC 1024
 
-	bool dst_nat;
-	bool enabled;
-	uint32_t rule_hdl;
+/* protocols a conntrack resync is tracked for, TCP and UDP */
+#define CT_RESYNC_PROTOS 2
 
-	/* used for pcie-modem */
-	uint32_t rule_id;
-}nat_table_entry;
-
-#define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
+/* Conntrack refreshes sent per netlink sendmsg() */
+#define UDP_SWEEP_CT_BATCH 32
+#define UDP_SWEEP_CT_MSG_SIZE 512
 
 class NatApp
 {
@@ -77,6 +68,8 @@ private:
 
 	static NatApp *pInstance;
 
+	/* cache holds the entries of nat_cache, which indexes them */
+	NatCache nat_cache;
 	nat_table_entry *cache;
 	nat_table_entry temp[MAX_TEMP_ENTRIES];
 	uint32_t pub_ip_addr;
@@ -100,18 +93,40 @@ private:
 	struct nf_conntrack *ct;
 	struct nfct_handle *ct_hdl;
 
+	/* timestamp sweep scratch, max_entries each */
+	int *sweep_idx;
+	uint32_t *sweep_hdls;
+	uint32_t *sweep_ts;
+
+	/* conntrack refreshes staged for one sendmsg() */
+	nat_table_entry *ct_batch_rule[UDP_SWEEP_CT_BATCH];
+	uint32_t ct_batch_ts[UDP_SWEEP_CT_BATCH];
+	char ct_batch_buf[UDP_SWEEP_CT_BATCH][UDP_SWEEP_CT_MSG_SIZE];
+	int ct_batch_cnt;
+	uint32_t ct_batch_seq;
+
+	/* conntrack resync: the generation an entry was last seen in, max_entries */
+	uint32_t *resync_seen;
+	uint32_t resync_gen[CT_RESYNC_PROTOS];
+	bool resync_active[CT_RESYNC_PROTOS];
+	uint32_t resync_gen_next;
+
 	int m_fd_ipa;
 
 	NatApp();
 	~NatApp();
 	int Init();
 
+	int SetCTTimeout(const nat_table_entry *);
 	void UpdateCTUdpTs(nat_table_entry *, uint32_t);
+	void QueueCTUdpTs(nat_table_entry *, uint32_t);
+	void FlushCTUdpTs();
 	bool ChkForDup(const nat_table_entry *);
 	bool isAlgPort(uint8_t, uint16_t);
 	void Reset();
 	bool isPwrSaveIf(uint32_t);
 	uint32_t GenerateMetdata(uint8_t mux_id);
+	void MarkResynced(int);
 
 public:
 	static NatApp* GetInstance();
@@ -127,7 +142,10 @@ public:
 	int AddConnection(const nat_table_entry *);
 	int DelConnection(const uint32_t);
 
-	void UpdateUDPTimeStamp();
+	unsigned int UpdateUDPTimeStamp();
+
+	void ResyncBegin(uint8_t);
+	int ResyncEnd(uint8_t, bool);
 
 	int UpdatePwrSaveIf(uint32_t);
 	int ResetPwrSaveIf(uint32_t);
@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Conntrack_NATCache.h
+
+	@brief
+	This file defines the connection cache behind NatApp: the entries of the
+	offloaded connections, indexed by 5-tuple and by client ip address.
+*/
+#ifndef IPACM_CONNTRACK_NATCACHE_H
+#define IPACM_CONNTRACK_NATCACHE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define NAT_CACHE_INVALID_IDX -1
+/* number of client ip chains, a power of 2 */
+#define NAT_CACHE_CLNT_BUCKETS 256
+
+typedef struct _nat_table_entry
+{
+	uint32_t private_ip;
+	uint16_t private_port;
+
+	uint32_t target_ip;
+	uint16_t target_port;
+
+	uint32_t public_ip;
+	uint16_t public_port;
+
+	u_int8_t  protocol;
+	uint32_t timestamp;
+
+	bool dst_nat;
+	bool enabled;
+	uint32_t rule_hdl;
+
+	/* used for pcie-modem */
+	uint32_t rule_id;
+}nat_table_entry;
+
+/* chain links of a cache entry, the client chain of a free entry is the free list */
+typedef struct _nat_cache_link
+{
+	int tuple_next;
+	int tuple_prev;
+	int clnt_next;
+	int clnt_prev;
+}nat_cache_link;
+
+/* Fixed array of nat_table_entry, which stays the storage NatApp keeps the
+ * rule handles in and walks for table wide updates. Lookups by 5-tuple
+ * (private ip/port, target ip/port, protocol) and by private ip go through
+ * hash chains of indexes over the array, and free entries are kept on a
+ * list, so a conntrack event costs O(1) whatever the number of entries. */
+class NatCache
+{
+private:
+	nat_table_entry *entries;
+	nat_cache_link *links;
+	int *tuple_heads;
+	int *clnt_heads;
+	uint32_t tuple_mask;
+	int free_head;
+	int max_entries;
+
+	static uint32_t TupleHash(const nat_table_entry *);
+	static uint32_t ClntHash(uint32_t);
+	static bool IsSameTuple(const nat_table_entry *, const nat_table_entry *);
+
+public:
+	NatCache();
+	~NatCache();
+
+	int Init(int);
+
+	inline nat_table_entry* GetEntries(void)
+	{
+		return entries;
+	}
+
+	/* index of the entry with the 5-tuple of the rule, NAT_CACHE_INVALID_IDX if none */
+	int Find(const nat_table_entry *);
+	/* takes a free entry and sets the 5-tuple of the rule in it,
+	 * NAT_CACHE_INVALID_IDX if all are in use */
+	int Alloc(const nat_table_entry *);
+	/* clears the entry and puts it back on the free list */
+	void Free(int);
+	/* entries of a client, by private ip; the next one is to be taken
+	 * before the current one is freed */
+	int FirstOfClnt(uint32_t);
+	int NextOfClnt(int);
+};
+
+#endif /* IPACM_CONNTRACK_NATCACHE_H */
@@ -168,6 +168,7 @@ typedef enum
 	IPA_SW_ROUTING_DISABLE,                   /* NULL */
 	IPA_PROCESS_CT_MESSAGE,                   /* ipacm_ct_evt_data */
 	IPA_PROCESS_CT_MESSAGE_V6,                /* ipacm_ct_evt_data */
+	IPA_PROCESS_CT_RESYNC,                    /* ipacm_ct_resync_evt_data */
 	IPA_LAN_TO_LAN_NEW_CONNECTION,            /* ipacm_event_connection */
 	IPA_LAN_TO_LAN_DEL_CONNECTION,            /* ipacm_event_connection */
 	IPA_WLAN_SWITCH_TO_SCC,                   /* No Data */
@@ -254,6 +255,21 @@ typedef struct
 	enum nf_conntrack_msg_type type;
 }ipacm_ct_evt_data;
 
+/* a conntrack socket overran and its connections are dumped again: the NAT
+   entries of the protocol not seen between BEGIN and END are stale */
+typedef enum
+{
+	CT_RESYNC_BEGIN,
+	CT_RESYNC_END,
+	CT_RESYNC_ABORT
+}ipacm_ct_resync_phase;
+
+typedef struct
+{
+	uint8_t l4proto;
+	ipacm_ct_resync_phase phase;
+}ipacm_ct_resync_evt_data;
+
 typedef struct
 {
 	char iface_name[IPA_IFACE_NAME_LEN];
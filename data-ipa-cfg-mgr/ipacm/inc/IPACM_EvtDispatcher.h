@@ -56,6 +56,17 @@ typedef struct _cmd_evts
 
 
 
+/* Event payloads up to this size come from the dispatcher's slab pool */
+#define IPACM_EVT_POOL_MAX_SIZE 256
+
+typedef struct
+{
+	uint32_t in_use;              /* pooled payloads not yet freed */
+	uint32_t max_in_use;
+	uint64_t pooled;              /* allocations served from the pool */
+	uint64_t fallback;            /* allocations that went to malloc() */
+} ipacm_evt_pool_stats;
+
 class IPACM_EvtDispatcher
 {
 public:
@@ -69,8 +80,21 @@ public:
 	static int PostEvt(ipacm_cmd_q_data *);
 	static void ProcessEvt(ipacm_cmd_q_data *);
 
+	/* allocate/free an evt_data payload. ProcessEvt() releases the payload
+	   with FreeEvtData(), which also accepts malloc()ed payloads. */
+	static void* AllocEvtData(size_t size);
+	static void FreeEvtData(void *data);
+
+	static void GetPoolStats(ipacm_evt_pool_stats *out);
+
+	/* log ipacm_event_stats, queue depths and pool usage, runs on the
+	   command queue thread which owns ipacm_event_stats */
+	static void DumpStats(void);
+
 private:
-	static cmd_evts *head;
+	/* registrations, one list per event id */
+	static cmd_evts *head[IPACM_EVENT_MAX];
+	static cmd_evts *tail[IPACM_EVENT_MAX];
 };
 
 #endif /* IPACM_EvtDispatcher_H */
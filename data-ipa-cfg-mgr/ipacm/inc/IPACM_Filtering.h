@@ -50,6 +50,25 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPA_PCIE_MODEM_RULE_ID_START 69
 #define IPA_PCIE_MODEM_RULE_ID_MAX 1000
 
+/* filter table ioctls accounted by IPACM_Filtering */
+enum ipacm_flt_op
+{
+	IPACM_FLT_OP_ADD,
+	IPACM_FLT_OP_DEL,
+	IPACM_FLT_OP_MDFY,
+	IPACM_FLT_OP_COMMIT,
+	IPACM_FLT_OP_MAX
+};
+
+struct ipacm_flt_op_stats
+{
+	uint64_t ioctls;
+	uint64_t rules;
+	uint64_t commits;   /* ioctls that also committed the table to HW */
+	uint64_t total_us;
+	uint32_t max_us;
+};
+
 class IPACM_Filtering
 {
 public:
@@ -77,12 +96,18 @@ public:
 	bool ModifyFilteringRule(struct ipa_ioc_mdfy_flt_rule* ruleTable);
 	ipa_filter_action_enum_v01 GetQmiFilterAction(ipa_flt_action action);
 
+	void GetStats(enum ipacm_flt_op op, struct ipacm_flt_op_stats *out);
+	void DumpStats();
+
 private:
 	static const char *DEVICE_NAME;
 	int fd; /* File descriptor of the IPA device node /dev/ipa */
 	int total_num_offload_rules;
 	int pcie_modem_rule_id;
 	bool pcie_modem_rule_id_in_use[IPA_PCIE_MODEM_RULE_ID_MAX];
+	struct ipacm_flt_op_stats stats[IPACM_FLT_OP_MAX];
+
+	int FltIoctl(enum ipacm_flt_op op, unsigned long req, void *arg, int num_rules, bool commit);
 };
 
 #endif //IPACM_FILTERING_H
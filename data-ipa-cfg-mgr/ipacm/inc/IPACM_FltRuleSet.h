@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_FltRuleSet.h
+
+	@brief
+	This file defines a desired-state model for a block of filter rule
+	slots of an interface: the rules a slot should hold are described
+	after every event, and only the slots whose rule differs from what
+	is installed are sent to IPA, in one modify ioctl.
+*/
+#ifndef IPACM_FLT_RULE_SET_H
+#define IPACM_FLT_RULE_SET_H
+
+#include <stdint.h>
+#include <linux/msm_ipa.h>
+#include "IPACM_Filtering.h"
+
+#define IPACM_FLT_RULE_SET_NAME_LEN 48
+
+struct ipacm_flt_rule_set_stats
+{
+	uint64_t commits;        /* Commit() calls that issued an ioctl */
+	uint64_t skipped;        /* Commit() calls with nothing to change */
+	uint64_t rules_sent;
+	uint64_t rules_unchanged;
+	uint64_t total_us;
+	uint32_t max_us;
+};
+
+class IPACM_FltRuleSet
+{
+public:
+	IPACM_FltRuleSet();
+	~IPACM_FltRuleSet();
+
+	/* name is "<iface> <what>", for the logs */
+	int Init(const char *iface, const char *what, ipa_ip_type ip, int num_slots);
+
+	/* forget what is installed, the next Commit() sends every slot;
+	   needed whenever the slots are added again */
+	void Invalidate();
+
+	/* desired state of a slot */
+	void SetRule(int slot, const struct ipa_flt_rule_mdfy *rule);
+	void SetDummy(int slot, uint32_t rule_hdl);
+
+	int Commit(IPACM_Filtering *filtering);
+
+	void GetStats(struct ipacm_flt_rule_set_stats *out);
+
+private:
+	char name[IPACM_FLT_RULE_SET_NAME_LEN];
+	ipa_ip_type ip;
+	int num_slots;
+
+	struct ipa_flt_rule_mdfy *want;
+	struct ipa_flt_rule_mdfy *have;
+	bool *have_valid;
+	struct ipa_ioc_mdfy_flt_rule *table;
+
+	struct ipacm_flt_rule_set_stats stats;
+
+	bool SlotChanged(int slot);
+};
+
+#endif /* IPACM_FLT_RULE_SET_H */
@@ -47,6 +47,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Iface.h"
 #include "IPACM_Routing.h"
 #include "IPACM_Filtering.h"
+#include "IPACM_FltRuleSet.h"
 #include "IPACM_Config.h"
 #include "IPACM_Conntrack_NATApp.h"
 #include "IPACM_Wan.h"
@@ -132,6 +133,10 @@ public:
 	/* store filter cfg rule handles */
 	uint32_t filter_cfg_rule_hdl[IPA_MAX_FILTER_CFG_ENTRIES];
 
+	/* what the private subnet/MTU and filter cfg rule slots should hold */
+	IPACM_FltRuleSet private_flt_set;
+	IPACM_FltRuleSet filter_cfg_flt_set;
+
 	/* store downstream information */
 	static struct ipa_lan_downstream_info downstream_info[IPA_MAX_TETHER_IFACE_ENTRIES];
 
@@ -250,8 +255,6 @@ protected:
 
 	int handle_private_subnet_android(ipa_ip_type iptype);
 
-	int reset_to_dummy_flt_rule(ipa_ip_type iptype, uint32_t rule_hdl);
-
 	int handle_filter_cfg_update(ipa_ip_type iptype);
 
 	int add_dummy_filter_cfg_rules(ipa_ip_type iptype);
@@ -193,6 +193,8 @@ if (!(a)) {                                                 \
 #define IP_PassthroughFlag_TAG               "IPPassthroughFlag"
 #define IP_PassthroughMode_TAG               "IPPassthroughMode"
 
+#define EvtPriorityLanes_TAG                 "EventPriorityLanes"
+
 /*---------------------------------------------------------------------------
       IP protocol numbers - use in dss_socket() to identify protocols.
       Also contains the extension header types for IPv6.
@@ -308,6 +310,7 @@ typedef struct  _IPACM_conf_t
 	bool odu_embms_enable;
 	int num_wlan_guest_ap;
 	bool ip_passthrough_mode;
+	bool evt_priority_lanes;
 } IPACM_conf_t;  
 
 /* This function read IPACM XML configuration*/
@@ -39,47 +39,156 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include <string.h>
 #include "IPACM_CmdQueue.h"
+#include "IPACM_EvtDispatcher.h"
 #include "IPACM_Log.h"
 #include "IPACM_Iface.h"
 
+/* per-event statistics are logged every this many dispatched events */
+#define IPACM_EVT_STATS_DUMP_INTERVAL 8192
+
 pthread_mutex_t mutex    = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t  cond_var = PTHREAD_COND_INITIALIZER;
 
-MessageQueue* MessageQueue::inst_internal = NULL;
-MessageQueue* MessageQueue::inst_external = NULL;
+MessageQueue* MessageQueue::inst[IPACM_EVT_LANE_MAX];
+Message* MessageQueue::free_items = NULL;
+int MessageQueue::num_free_items = 0;
 
-MessageQueue* MessageQueue::getInstanceInternal()
+static const char *lane_names[IPACM_EVT_LANE_MAX] =
+{
+	"internal",
+	"fast",
+	"normal",
+	"slow"
+};
+
+MessageQueue* MessageQueue::getInstance(ipacm_evt_lane lane)
 {
-	if(inst_internal == NULL)
+	if(lane >= IPACM_EVT_LANE_MAX)
+	{
+		IPACMERR("invalid lane %d\n", lane);
+		return NULL;
+	}
+
+	if(inst[lane] == NULL)
 	{
-		inst_internal = new MessageQueue();
-		if(inst_internal == NULL)
+		inst[lane] = new MessageQueue();
+		if(inst[lane] == NULL)
 		{
-			IPACMERR("unable to create internal Message Queue instance\n");
+			IPACMERR("unable to create %s Message Queue instance\n", lane_names[lane]);
 			return NULL;
 		}
 	}
 
-	return inst_internal;
+	return inst[lane];
+}
+
+MessageQueue* MessageQueue::getInstanceInternal()
+{
+	return getInstance(IPACM_EVT_LANE_INTERNAL);
 }
 
 MessageQueue* MessageQueue::getInstanceExternal()
 {
-	if(inst_external == NULL)
+	return getInstance(IPACM_EVT_LANE_NORMAL);
+}
+
+ipacm_evt_lane MessageQueue::getLane(ipa_cm_event_id event)
+{
+	if(event >= IPA_EXTERNAL_EVENT_MAX)
 	{
-		inst_external = new MessageQueue();
-		if(inst_external == NULL)
-		{
-			IPACMERR("unable to create external Message Queue instance\n");
-			return NULL;
-		}
+		return IPACM_EVT_LANE_INTERNAL;
+	}
+
+	if(IPACM_Iface::ipacmcfg == NULL || !IPACM_Iface::ipacmcfg->ipacm_evt_priority_lanes)
+	{
+		return IPACM_EVT_LANE_NORMAL;
 	}
 
-	return inst_external;
+	switch(event)
+	{
+	case IPA_PROCESS_CT_MESSAGE:
+	case IPA_PROCESS_CT_MESSAGE_V6:
+	case IPA_PROCESS_CT_RESYNC:
+	case IPA_NEW_NEIGH_EVENT:
+	case IPA_DEL_NEIGH_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT:
+		return IPACM_EVT_LANE_FAST;
+
+	case IPA_CFG_CHANGE_EVENT:
+	case IPA_FIREWALL_CHANGE_EVENT:
+	case IPA_FILTER_CFG_CHANGE_EVENT:
+		return IPACM_EVT_LANE_SLOW;
+
+	default:
+		return IPACM_EVT_LANE_NORMAL;
+	}
+}
+
+const char* MessageQueue::getLaneName(ipacm_evt_lane lane)
+{
+	if(lane >= IPACM_EVT_LANE_MAX)
+	{
+		return NULL;
+	}
+	return lane_names[lane];
+}
+
+Message* MessageQueue::getItem(void)
+{
+	Message *item = free_items;
+
+	if(item == NULL)
+	{
+		return new Message();
+	}
+
+	free_items = item->getnext();
+	num_free_items--;
+	item->setnext(NULL);
+	return item;
+}
+
+void MessageQueue::putItem(Message *item)
+{
+	if(num_free_items >= IPACM_MSG_POOL_MAX)
+	{
+		delete item;
+		return;
+	}
+
+	item->setnext(free_items);
+	free_items = item;
+	num_free_items++;
+}
+
+int MessageQueue::getLaneStats(ipacm_evt_lane lane, ipacm_lane_stats *out)
+{
+	MessageQueue *queue = getInstance(lane);
+
+	if(queue == NULL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	if(pthread_mutex_lock(&mutex) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return IPACM_FAILURE;
+	}
+	memcpy(out, &queue->stats, sizeof(*out));
+	if(pthread_mutex_unlock(&mutex) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+		return IPACM_FAILURE;
+	}
+
+	return IPACM_SUCCESS;
 }
 
 void MessageQueue::enqueue(Message *item)
 {
+	item->setnext(NULL);
 	if(!Head)
 	{
 		Tail = item;
@@ -98,6 +207,13 @@ void MessageQueue::enqueue(Message *item)
 		}
 		Tail = item;
 	}
+
+	stats.posted++;
+	stats.depth++;
+	if(stats.depth > stats.max_depth)
+	{
+		stats.max_depth = stats.depth;
+	}
 }
 
 
@@ -111,34 +227,127 @@ Message* MessageQueue::dequeue(void)
 	{
 		Message *tmp = Head;
 		Head = Head->getnext();
+		stats.depth--;
 
 		return tmp;
 	}
 }
 
+/* Pick the next event to dispatch, called with the mutex held. Internal
+   events always win. Among the other lanes the highest priority one with
+   work is served, unless a lower one has been passed over
+   IPACM_EVT_LANE_BURST times in a row. */
+Message* MessageQueue::dequeueNext(void)
+{
+	int i, served = -1;
+	Message *item;
+
+	item = inst[IPACM_EVT_LANE_INTERNAL]->dequeue();
+	if(item != NULL)
+	{
+		return item;
+	}
+
+	for(i = IPACM_EVT_LANE_FAST; i < IPACM_EVT_LANE_MAX; i++)
+	{
+		if(inst[i]->Head != NULL && inst[i]->skipped >= IPACM_EVT_LANE_BURST)
+		{
+			served = i;
+			break;
+		}
+	}
+
+	if(served < 0)
+	{
+		for(i = IPACM_EVT_LANE_FAST; i < IPACM_EVT_LANE_MAX; i++)
+		{
+			if(inst[i]->Head != NULL)
+			{
+				served = i;
+				break;
+			}
+		}
+	}
+
+	if(served < 0)
+	{
+		return NULL;
+	}
+
+	for(i = IPACM_EVT_LANE_FAST; i < IPACM_EVT_LANE_MAX; i++)
+	{
+		if(i != served && inst[i]->Head != NULL)
+		{
+			inst[i]->skipped++;
+		}
+	}
+	inst[served]->skipped = 0;
+
+	return inst[served]->dequeue();
+}
+
+static uint32_t ipacm_elapsed_us(struct timespec *from, struct timespec *to)
+{
+	int64_t us;
+
+	us = (int64_t)(to->tv_sec - from->tv_sec) * 1000000 +
+		(to->tv_nsec - from->tv_nsec) / 1000;
+
+	return (us > 0) ? (uint32_t)us : 0;
+}
+
+/* Runs on the command queue thread only, no locking needed */
+void MessageQueue::recordStats(Message *item, struct timespec *start, struct timespec *end)
+{
+	static uint32_t num_dispatched = 0;
+	ipacm_event_stat *stat;
+	uint32_t wait_us, run_us;
+
+	if(item->evt.data.event >= IPACM_EVENT_MAX)
+	{
+		return;
+	}
+
+	wait_us = ipacm_elapsed_us(&item->post_time, start);
+	run_us = ipacm_elapsed_us(start, end);
+
+	stat = &ipacm_event_stats[item->evt.data.event];
+	stat->dispatched++;
+	stat->wait_us += wait_us;
+	stat->run_us += run_us;
+	if(wait_us > stat->max_wait_us)
+	{
+		stat->max_wait_us = wait_us;
+	}
+	if(run_us > stat->max_run_us)
+	{
+		stat->max_run_us = run_us;
+	}
+
+	if(++num_dispatched % IPACM_EVT_STATS_DUMP_INTERVAL == 0)
+	{
+		IPACM_EvtDispatcher::DumpStats();
+	}
+}
+
 
 void* MessageQueue::Process(void *param)
 {
-	MessageQueue *MsgQueueInternal = NULL;
-	MessageQueue *MsgQueueExternal = NULL;
-	Message *item = NULL;
+	Message *item = NULL, *done = NULL;
+	struct timespec start, end;
 	param = NULL;
 	const char *eventName = NULL;
+	int i;
 
 	IPACMDBG("MessageQueue::Process()\n");
 
-	MsgQueueInternal = MessageQueue::getInstanceInternal();
-	if(MsgQueueInternal == NULL)
+	for(i = 0; i < IPACM_EVT_LANE_MAX; i++)
 	{
-		IPACMERR("unable to start internal cmd queue process\n");
-		return NULL;
-	}
-
-	MsgQueueExternal = MessageQueue::getInstanceExternal();
-	if(MsgQueueExternal == NULL)
-	{
-		IPACMERR("unable to start external cmd queue process\n");
-		return NULL;
+		if(MessageQueue::getInstance((ipacm_evt_lane)i) == NULL)
+		{
+			IPACMERR("unable to start %s cmd queue process\n", lane_names[i]);
+			return NULL;
+		}
 	}
 
 	while(1)
@@ -149,27 +358,21 @@ void* MessageQueue::Process(void *param)
 			return NULL;
 		}
 
-		item = MsgQueueInternal->dequeue();
-		if(item == NULL)
+		/* recycle the item dispatched last time round */
+		if(done != NULL)
 		{
-			item = MsgQueueExternal->dequeue();
-			if(item)
-			{
-				eventName = IPACM_Iface::ipacmcfg->getEventName(item->evt.data.event);
-				if (eventName != NULL)
-				{
-					IPACMDBG("Get event %s from external queue.\n",
-							eventName);
-				}
-			}
+			putItem(done);
+			done = NULL;
 		}
-		else
+
+		item = dequeueNext();
+		if(item != NULL)
 		{
 			eventName = IPACM_Iface::ipacmcfg->getEventName(item->evt.data.event);
 			if (eventName != NULL)
 			{
-				IPACMDBG("Get event %s from internal queue.\n",
-					eventName);
+				IPACMDBG("Get event %s from %s queue.\n",
+					eventName, lane_names[getLane(item->evt.data.event)]);
 			}
 		}
 
@@ -206,8 +409,11 @@ void* MessageQueue::Process(void *param)
 			}
 
 			IPACMDBG("Processing item %pK event ID: %d\n",item,item->evt.data.event);
+			clock_gettime(CLOCK_MONOTONIC, &start);
 			item->evt.callback_ptr(&item->evt.data);
-			delete item;
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			recordStats(item, &start, &end);
+			done = item;
 			item = NULL;
 		}
 
@@ -81,6 +81,7 @@ const char *ipacm_event_name[] = {
 	__stringify(IPA_SW_ROUTING_DISABLE),                   /* NULL */
 	__stringify(IPA_PROCESS_CT_MESSAGE),                   /* ipacm_ct_evt_data */
 	__stringify(IPA_PROCESS_CT_MESSAGE_V6),                /* ipacm_ct_evt_data */
+	__stringify(IPA_PROCESS_CT_RESYNC),                    /* ipacm_ct_resync_evt_data */
 	__stringify(IPA_LAN_TO_LAN_NEW_CONNECTION),            /* ipacm_event_connection */
 	__stringify(IPA_LAN_TO_LAN_DEL_CONNECTION),            /* ipacm_event_connection */
 	__stringify(IPA_WLAN_SWITCH_TO_SCC),                   /* No Data */
@@ -149,6 +150,7 @@ IPACM_Config::IPACM_Config()
 	ipa_nat_iface_entries = 0;
 	ipa_sw_rt_enable = false;
 	ipa_bridge_enable = false;
+	ipacm_evt_priority_lanes = false;
 	isMCC_Mode = false;
 	ipa_max_valid_rm_entry = 0;
 	/* IPA_HW_FNR_STATS */
@@ -330,6 +332,9 @@ int IPACM_Config::Init(void)
 	ipacm_ip_passthrough_mode = cfg->ip_passthrough_mode;
 	IPACMDBG_H("ipacm_ip_passthrough_mode %d. \n", ipacm_ip_passthrough_mode);
 
+	ipacm_evt_priority_lanes = cfg->evt_priority_lanes;
+	IPACMDBG_H("ipacm_evt_priority_lanes %d\n", ipacm_evt_priority_lanes);
+
 	ipa_num_wlan_guest_ap = cfg->num_wlan_guest_ap;
 	IPACMDBG_H("ipa_num_wlan_guest_ap %d\n",ipa_num_wlan_guest_ap);
 
@@ -0,0 +1,379 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ConntrackBatch.cpp
+
+	@brief
+	This file implements the batched receive path for conntrack events
+*/
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IPACM_ConntrackBatch.h"
+#include "IPACM_Log.h"
+
+#ifndef NFNL_SUBSYS_ID
+#define NFNL_SUBSYS_ID(x) ((x & 0xff00) >> 8)
+#endif
+#ifndef NFNL_SUBSYS_CTNETLINK
+#define NFNL_SUBSYS_CTNETLINK 1
+#endif
+
+IPACM_ConntrackBatch::IPACM_ConntrackBatch(ct_batch_cb cb_fn, void *data, unsigned int mask)
+{
+	fd = -1;
+	msgs_per_call = CT_BATCH_MSGS;
+	coalesce = true;
+	type_mask = mask;
+	cb = cb_fn;
+	cb_data = data;
+	bufs = NULL;
+	num_events = 0;
+	resync_pending = false;
+	memset(tuple_slots, 0xff, sizeof(tuple_slots));
+	memset(&stats, 0, sizeof(stats));
+}
+
+IPACM_ConntrackBatch::~IPACM_ConntrackBatch()
+{
+	int i;
+
+	for(i = 0; i < num_events; i++)
+	{
+		if(events[i].ct != NULL)
+		{
+			nfct_destroy(events[i].ct);
+		}
+	}
+	free(bufs);
+}
+
+int IPACM_ConntrackBatch::Init(int sock_fd, int per_call, bool merge)
+{
+	int i;
+
+	if(sock_fd < 0 || per_call < 1 || per_call > CT_BATCH_MSGS)
+	{
+		IPACMERR("invalid fd %d or batch size %d\n", sock_fd, per_call);
+		return -1;
+	}
+
+	if(bufs == NULL)
+	{
+		bufs = (char *)malloc(CT_BATCH_MSGS * CT_BATCH_MSG_SIZE);
+		if(bufs == NULL)
+		{
+			IPACMERR("unable to allocate conntrack batch buffers\n");
+			return -1;
+		}
+	}
+
+	fd = sock_fd;
+	msgs_per_call = per_call;
+	coalesce = merge;
+
+	memset(msgs, 0, sizeof(msgs));
+	for(i = 0; i < CT_BATCH_MSGS; i++)
+	{
+		iovs[i].iov_base = bufs + i * CT_BATCH_MSG_SIZE;
+		iovs[i].iov_len = CT_BATCH_MSG_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+	}
+
+	return 0;
+}
+
+int IPACM_ConntrackBatch::SetRcvBuf(int size)
+{
+	int cur = 0;
+	socklen_t len = sizeof(cur);
+
+	if(setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0 &&
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) != 0)
+	{
+		IPACMERR("unable to set receive buffer of fd %d to %d: %s\n", fd, size, strerror(errno));
+		return -1;
+	}
+
+	if(getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &cur, &len) == 0)
+	{
+		IPACMDBG_H("receive buffer of fd %d is %d bytes\n", fd, cur);
+	}
+	return 0;
+}
+
+void IPACM_ConntrackBatch::GetTuple(struct nf_conntrack *ct, ct_batch_tuple *tuple)
+{
+	const void *addr;
+
+	memset(tuple, 0, sizeof(*tuple));
+	tuple->l3proto = nfct_get_attr_u8(ct, ATTR_ORIG_L3PROTO);
+	tuple->l4proto = nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+	tuple->src_port = nfct_get_attr_u16(ct, ATTR_ORIG_PORT_SRC);
+	tuple->dst_port = nfct_get_attr_u16(ct, ATTR_ORIG_PORT_DST);
+
+	if(tuple->l3proto == AF_INET6)
+	{
+		addr = nfct_get_attr(ct, ATTR_ORIG_IPV6_SRC);
+		if(addr != NULL)
+		{
+			memcpy(tuple->src, addr, sizeof(tuple->src));
+		}
+		addr = nfct_get_attr(ct, ATTR_ORIG_IPV6_DST);
+		if(addr != NULL)
+		{
+			memcpy(tuple->dst, addr, sizeof(tuple->dst));
+		}
+	}
+	else
+	{
+		tuple->src[0] = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_SRC);
+		tuple->dst[0] = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_DST);
+	}
+}
+
+/* FNV-1a over the tuple */
+uint32_t IPACM_ConntrackBatch::TupleHash(const ct_batch_tuple *tuple)
+{
+	const uint8_t *p = (const uint8_t *)tuple;
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for(i = 0; i < sizeof(*tuple); i++)
+	{
+		hash = (hash ^ p[i]) * 16777619u;
+	}
+	return hash;
+}
+
+/* Events of one 5-tuple in a batch collapse to the latest state, which is
+ * all the NAT handlers look at: an UPDATE replaces the pending NEW or
+ * UPDATE (a NEW stays a NEW), a DESTROY replaces a pending UPDATE, and a
+ * connection that is both opened and closed within the batch is dropped.
+ * A NEW after a DESTROY is a new connection on the same tuple and is kept
+ * as a separate event. */
+void IPACM_ConntrackBatch::Add(struct nf_conntrack *ct, enum nf_conntrack_msg_type type)
+{
+	ct_batch_tuple tuple;
+	ct_batch_event *prev;
+	uint32_t slot;
+	int idx;
+
+	if((type & type_mask) == 0)
+	{
+		stats.filtered++;
+		nfct_destroy(ct);
+		return;
+	}
+
+	if(!coalesce)
+	{
+		stats.delivered++;
+		cb(type, ct, cb_data);
+		return;
+	}
+
+	if(num_events == CT_BATCH_MAX_EVENTS)
+	{
+		Flush();
+	}
+
+	GetTuple(ct, &tuple);
+	slot = TupleHash(&tuple) & (CT_BATCH_TUPLE_SLOTS - 1);
+	while((idx = tuple_slots[slot]) >= 0 &&
+		memcmp(&events[idx].tuple, &tuple, sizeof(tuple)) != 0)
+	{
+		slot = (slot + 1) & (CT_BATCH_TUPLE_SLOTS - 1);
+	}
+
+	prev = (idx >= 0) ? &events[idx] : NULL;
+	if(prev != NULL && prev->ct != NULL && prev->type != NFCT_T_DESTROY)
+	{
+		if(type == NFCT_T_DESTROY && prev->type == NFCT_T_NEW)
+		{
+			nfct_destroy(prev->ct);
+			nfct_destroy(ct);
+			prev->ct = NULL;
+			stats.cancelled += 2;
+			return;
+		}
+
+		nfct_destroy(prev->ct);
+		prev->ct = ct;
+		if(type == NFCT_T_DESTROY || prev->type != NFCT_T_NEW)
+		{
+			prev->type = type;
+		}
+		stats.coalesced++;
+		return;
+	}
+
+	idx = num_events++;
+	events[idx].ct = ct;
+	events[idx].type = type;
+	memcpy(&events[idx].tuple, &tuple, sizeof(tuple));
+	tuple_slots[slot] = idx;
+}
+
+void IPACM_ConntrackBatch::Flush(void)
+{
+	int i;
+
+	for(i = 0; i < num_events; i++)
+	{
+		if(events[i].ct != NULL)
+		{
+			stats.delivered++;
+			cb(events[i].type, events[i].ct, cb_data);
+			events[i].ct = NULL;
+		}
+	}
+
+	if(num_events > 0)
+	{
+		num_events = 0;
+		memset(tuple_slots, 0xff, sizeof(tuple_slots));
+	}
+}
+
+void IPACM_ConntrackBatch::ParseDatagram(char *buf, int len)
+{
+	struct nlmsghdr *nlh;
+	struct nf_conntrack *ct;
+	int type;
+
+	for(nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
+	{
+		if(nlh->nlmsg_type == NLMSG_DONE)
+		{
+			break;
+		}
+
+		if(nlh->nlmsg_type < NLMSG_MIN_TYPE ||
+			NFNL_SUBSYS_ID(nlh->nlmsg_type) != NFNL_SUBSYS_CTNETLINK)
+		{
+			continue;
+		}
+
+		ct = nfct_new();
+		if(ct == NULL)
+		{
+			IPACMERR("unable to allocate conntrack object\n");
+			break;
+		}
+
+		type = nfct_parse_conntrack(NFCT_T_ALL, nlh, ct);
+		/* NFCT_T_UNKNOWN, or the sign bit of NFCT_T_ERROR */
+		if(type <= 0)
+		{
+			stats.parse_errors++;
+			nfct_destroy(ct);
+			continue;
+		}
+
+		stats.events++;
+		Add(ct, (enum nf_conntrack_msg_type)type);
+	}
+}
+
+int IPACM_ConntrackBatch::Receive(void)
+{
+	int i, n;
+
+	for(i = 0; i < msgs_per_call; i++)
+	{
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_flags = 0;
+	}
+
+	n = recvmmsg(fd, msgs, msgs_per_call, MSG_WAITFORONE, NULL);
+	if(n < 0)
+	{
+		if(errno == ENOBUFS)
+		{
+			/* the kernel dropped events, whatever was queued is still good */
+			stats.overruns++;
+			resync_pending = true;
+			IPACMERR("conntrack socket %d overrun (%llu so far)\n",
+				fd, (unsigned long long)stats.overruns);
+			return 0;
+		}
+		if(errno == EINTR)
+		{
+			return 0;
+		}
+		return -1;
+	}
+
+	stats.recv_calls++;
+	stats.datagrams += n;
+
+	for(i = 0; i < n; i++)
+	{
+		if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+		{
+			stats.truncated++;
+			continue;
+		}
+
+		/* only the kernel may send conntrack events */
+		if(msgs[i].msg_hdr.msg_namelen == sizeof(struct sockaddr_nl) &&
+			addrs[i].nl_pid != 0)
+		{
+			continue;
+		}
+
+		ParseDatagram((char *)iovs[i].iov_base, msgs[i].msg_len);
+	}
+
+	Flush();
+	return n;
+}
+
+void IPACM_ConntrackBatch::ResyncDone(bool success)
+{
+	resync_pending = false;
+	if(success)
+	{
+		stats.resyncs++;
+	}
+}
+
+void IPACM_ConntrackBatch::GetStats(ct_batch_stats *out)
+{
+	memcpy(out, &stats, sizeof(*out));
+}
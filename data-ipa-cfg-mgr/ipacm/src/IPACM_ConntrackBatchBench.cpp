@@ -0,0 +1,361 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ConntrackBatchBench.cpp
+
+	@brief
+	Synthetic load benchmark for the batched conntrack receive path. A
+	sender thread replays ctnetlink NEW, UPDATE and DESTROY events of many
+	short lived connections, one per datagram as the kernel sends them,
+	over a datagram socket pair. The events are received once a datagram
+	at a time without coalescing, as nfct_catch() does, and once batched
+	and coalesced. Both must leave the same connections open; events/sec,
+	receiver CPU time per event and the number of events handed on are
+	reported for both.
+
+	usage: ipacm_ct_batch_bench [connections]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <vector>
+#include <unordered_map>
+#include "IPACM_ConntrackBatch.h"
+
+extern "C"
+{
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netfilter/nfnetlink_conntrack.h>
+#include <libnetfilter_conntrack/libnetfilter_conntrack_tcp.h>
+}
+
+#define DEFAULT_CONNS 100000
+/* connections with events in flight at any time */
+#define ACTIVE_CONNS 16
+
+typedef struct
+{
+	std::vector<char> buf;
+	std::vector<int> len;
+} replay_stream;
+
+typedef struct
+{
+	int fd;
+	const replay_stream *stream;
+} sender_args;
+
+typedef struct
+{
+	uint64_t delivered;
+	std::unordered_map<uint64_t, int> open;
+} receiver_state;
+
+static uint64_t NowNs(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t seed = 1;
+static uint32_t Rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+typedef struct
+{
+	uint32_t src_ip;
+	uint16_t src_port;
+	uint8_t proto;
+	int updates;
+	int next;        /* 0 NEW, 1..updates UPDATE, then DESTROY */
+	bool closes;
+} replay_conn;
+
+/* conntrack never reports two live connections on one tuple: tuples are
+ * unique, except that a closed one is taken again now and then */
+static void NewConn(replay_conn *conn, int id, bool reuse)
+{
+	if(!reuse)
+	{
+		conn->src_ip = 0xC0A80000 + id % 0x10000;
+		conn->src_port = 1024 + id / 0x10000;
+	}
+	conn->proto = (Rand() % 3) ? IPPROTO_TCP : IPPROTO_UDP;
+	/* TCP reports SYN_RECV, ESTABLISHED and the close states */
+	conn->updates = (conn->proto == IPPROTO_TCP) ? 1 + Rand() % 4 : 0;
+	conn->next = 0;
+	conn->closes = (Rand() % 10) < 8;
+}
+
+/* one ctnetlink event of conn, the way the kernel builds it */
+static int BuildEvent(const replay_conn *conn, char *buf)
+{
+	struct nlmsghdr *nlh = (struct nlmsghdr *)buf;
+	struct nfgenmsg *nfg;
+	struct nf_conntrack *ct;
+	bool destroy = (conn->next > conn->updates);
+	int ret;
+
+	memset(buf, 0, CT_BATCH_MSG_SIZE);
+	nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct nfgenmsg));
+	nlh->nlmsg_type = (NFNL_SUBSYS_CTNETLINK << 8) |
+		(destroy ? IPCTNL_MSG_CT_DELETE : IPCTNL_MSG_CT_NEW);
+	nlh->nlmsg_flags = (conn->next == 0) ? (NLM_F_CREATE | NLM_F_EXCL) : 0;
+	nfg = (struct nfgenmsg *)NLMSG_DATA(nlh);
+	nfg->nfgen_family = AF_INET;
+	nfg->version = NFNETLINK_V0;
+
+	ct = nfct_new();
+	if(ct == NULL)
+	{
+		return -1;
+	}
+	nfct_set_attr_u8(ct, ATTR_ORIG_L3PROTO, AF_INET);
+	nfct_set_attr_u8(ct, ATTR_ORIG_L4PROTO, conn->proto);
+	nfct_set_attr_u32(ct, ATTR_ORIG_IPV4_SRC, htonl(conn->src_ip));
+	nfct_set_attr_u32(ct, ATTR_ORIG_IPV4_DST, htonl(0x08080808));
+	nfct_set_attr_u16(ct, ATTR_ORIG_PORT_SRC, htons(conn->src_port));
+	nfct_set_attr_u16(ct, ATTR_ORIG_PORT_DST, htons(443));
+	nfct_set_attr_u8(ct, ATTR_REPL_L3PROTO, AF_INET);
+	nfct_set_attr_u8(ct, ATTR_REPL_L4PROTO, conn->proto);
+	nfct_set_attr_u32(ct, ATTR_REPL_IPV4_SRC, htonl(0x08080808));
+	nfct_set_attr_u32(ct, ATTR_REPL_IPV4_DST, htonl(0x0A000001));
+	nfct_set_attr_u16(ct, ATTR_REPL_PORT_SRC, htons(443));
+	nfct_set_attr_u16(ct, ATTR_REPL_PORT_DST, htons(conn->src_port));
+	if(conn->proto == IPPROTO_TCP)
+	{
+		nfct_set_attr_u8(ct, ATTR_TCP_STATE, (conn->next < conn->updates) ?
+			TCP_CONNTRACK_SYN_RECV : TCP_CONNTRACK_ESTABLISHED);
+	}
+
+	ret = nfct_nlmsg_build(nlh, ct);
+	nfct_destroy(ct);
+	return (ret < 0) ? -1 : (int)nlh->nlmsg_len;
+}
+
+/* events of num_conns connections, ACTIVE_CONNS of them interleaved at a time */
+static int MakeStream(int num_conns, replay_stream *stream)
+{
+	replay_conn active[ACTIVE_CONNS];
+	char msg[CT_BATCH_MSG_SIZE];
+	int started = 0, live = 0, idx, len;
+
+	seed = num_conns;
+	stream->buf.clear();
+	stream->len.clear();
+	for(idx = 0; idx < ACTIVE_CONNS && started < num_conns; idx++, started++, live++)
+	{
+		NewConn(&active[idx], started, false);
+	}
+
+	while(live > 0)
+	{
+		idx = Rand() % live;
+		len = BuildEvent(&active[idx], msg);
+		if(len < 0)
+		{
+			return -1;
+		}
+		stream->buf.insert(stream->buf.end(), msg, msg + len);
+		stream->len.push_back(len);
+
+		active[idx].next++;
+		if(active[idx].next > active[idx].updates + (active[idx].closes ? 1 : 0))
+		{
+			if(started < num_conns)
+			{
+				NewConn(&active[idx], started, active[idx].closes && Rand() % 8 == 0);
+				started++;
+			}
+			else
+			{
+				active[idx] = active[--live];
+			}
+		}
+	}
+	return 0;
+}
+
+static void *Sender(void *arg)
+{
+	sender_args *args = (sender_args *)arg;
+	const char *buf = &args->stream->buf[0];
+	size_t cnt;
+
+	for(cnt = 0; cnt < args->stream->len.size(); cnt++)
+	{
+		if(send(args->fd, buf, args->stream->len[cnt], 0) < 0)
+		{
+			perror("send");
+			break;
+		}
+		buf += args->stream->len[cnt];
+	}
+	return NULL;
+}
+
+static uint64_t TupleKey(struct nf_conntrack *ct)
+{
+	return ((uint64_t)ntohl(nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_SRC)) << 24) |
+		((uint64_t)ntohs(nfct_get_attr_u16(ct, ATTR_ORIG_PORT_SRC)) << 8) |
+		nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+}
+
+/* the NAT side in short: NEW and UPDATE keep a connection, DESTROY drops it */
+static int Deliver(enum nf_conntrack_msg_type type, struct nf_conntrack *ct, void *data)
+{
+	receiver_state *state = (receiver_state *)data;
+
+	state->delivered++;
+	if(type == NFCT_T_DESTROY)
+	{
+		state->open.erase(TupleKey(ct));
+	}
+	else
+	{
+		state->open[TupleKey(ct)] = type;
+	}
+	nfct_destroy(ct);
+	return NFCT_CB_STOLEN;
+}
+
+static int Run(const char *name, const replay_stream *stream, int msgs_per_call, bool coalesce,
+	receiver_state *state)
+{
+	IPACM_ConntrackBatch batch(Deliver, state, NFCT_T_NEW | NFCT_T_UPDATE | NFCT_T_DESTROY);
+	ct_batch_stats stats;
+	sender_args args;
+	pthread_t thread;
+	uint64_t start, cpu_start, ns, cpu_ns, received = 0;
+	int fds[2], n;
+
+	if(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) != 0)
+	{
+		perror("socketpair");
+		return -1;
+	}
+	if(batch.Init(fds[0], msgs_per_call, coalesce) != 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+
+	args.fd = fds[1];
+	args.stream = stream;
+	start = NowNs(CLOCK_MONOTONIC);
+	cpu_start = NowNs(CLOCK_THREAD_CPUTIME_ID);
+	pthread_create(&thread, NULL, Sender, &args);
+	while(received < stream->len.size())
+	{
+		n = batch.Receive();
+		if(n < 0)
+		{
+			perror("recvmmsg");
+			break;
+		}
+		received += n;
+	}
+	cpu_ns = NowNs(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+	ns = NowNs(CLOCK_MONOTONIC) - start;
+	pthread_join(thread, NULL);
+	close(fds[0]);
+	close(fds[1]);
+
+	batch.GetStats(&stats);
+	printf("%-18s %9.0f events/sec %6.0f ns cpu/event %8llu recv calls %8llu handed on %8llu coalesced %8llu cancelled\n",
+		name, (double)stats.events * 1e9 / ns, (double)cpu_ns / stats.events,
+		(unsigned long long)stats.recv_calls,
+		(unsigned long long)stats.delivered, (unsigned long long)stats.coalesced,
+		(unsigned long long)stats.cancelled);
+
+	return (stats.events == stream->len.size() && stats.parse_errors == 0) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+	int num_conns = argc > 1 ? atoi(argv[1]) : DEFAULT_CONNS;
+	replay_stream stream;
+	receiver_state single, batched;
+	int ret = 0;
+
+	if(num_conns <= 0)
+	{
+		printf("usage: %s [connections]\n", argv[0]);
+		return 1;
+	}
+
+	if(MakeStream(num_conns, &stream) != 0)
+	{
+		printf("FAIL: unable to build conntrack events\n");
+		return 1;
+	}
+	printf("%d connections, %zu events, %d interleaved\n", num_conns, stream.len.size(),
+		ACTIVE_CONNS);
+
+	single.delivered = 0;
+	batched.delivered = 0;
+	ret |= Run("one at a time", &stream, 1, false, &single);
+	ret |= Run("batched+coalesced", &stream, CT_BATCH_MSGS, true, &batched);
+
+	/* coalescing may only drop events whose effect a later one overrides */
+	if(single.open.size() != batched.open.size())
+	{
+		printf("FAIL: %zu connections open one at a time, %zu batched\n",
+			single.open.size(), batched.open.size());
+		ret = -1;
+	}
+	for(std::unordered_map<uint64_t, int>::iterator it = single.open.begin();
+		ret == 0 && it != single.open.end(); ++it)
+	{
+		if(batched.open.find(it->first) == batched.open.end())
+		{
+			printf("FAIL: connection %llx lost by coalescing\n", (unsigned long long)it->first);
+			ret = -1;
+		}
+	}
+
+	printf("%s\n", ret ? "FAILED" : "PASSED");
+	return ret ? 1 : 0;
+}
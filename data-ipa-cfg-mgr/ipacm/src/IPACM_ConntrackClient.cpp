@@ -120,7 +120,7 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 
 #endif
 
-	ct_data = (ipacm_ct_evt_data *)malloc(sizeof(ipacm_ct_evt_data));
+	ct_data = (ipacm_ct_evt_data *)IPACM_EvtDispatcher::AllocEvtData(sizeof(ipacm_ct_evt_data));
 	if(ct_data == NULL)
 	{
 		IPACMERR("unable to allocate memory \n");
@@ -143,7 +143,7 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 	if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
 	{
 		IPACMERR("Error sending Conntrack message to processing thread!\n");
-		free(ct_data);
+		IPACM_EvtDispatcher::FreeEvtData(ct_data);
 		goto IGNORE;
 	}
 
@@ -402,8 +402,7 @@ void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
 
 	while(1)
 	{
-		nat_inst->UpdateUDPTimeStamp();
-		sleep(UDP_TIMEOUT_UPDATE);
+		sleep(nat_inst->UpdateUDPTimeStamp());
 	} /* end of while(1) loop */
 
 #ifdef IPACM_DEBUG
@@ -413,6 +412,164 @@ void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
 	return NULL;
 }
 
+int IPACM_ConntrackClient::PostResyncEvt(uint8_t l4proto, ipacm_ct_resync_phase phase)
+{
+	ipacm_cmd_q_data evt_data;
+	ipacm_ct_resync_evt_data *resync;
+
+	resync = (ipacm_ct_resync_evt_data *)IPACM_EvtDispatcher::AllocEvtData(sizeof(ipacm_ct_resync_evt_data));
+	if(resync == NULL)
+	{
+		IPACMERR("unable to allocate memory \n");
+		return -1;
+	}
+	resync->l4proto = l4proto;
+	resync->phase = phase;
+
+	evt_data.event = IPA_PROCESS_CT_RESYNC;
+	evt_data.evt_data = (void *)resync;
+	if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
+	{
+		IPACMERR("Error sending conntrack resync to processing thread!\n");
+		IPACM_EvtDispatcher::FreeEvtData(resync);
+		return -1;
+	}
+	return 0;
+}
+
+/* what a resync dump feeds, and the protocol it is for */
+typedef struct
+{
+	IPACM_ConntrackBatch *batch;
+	uint8_t l4proto;
+} ct_resync_ctx;
+
+/* Dump callback of a resync */
+int IPACM_ConntrackClient::ResyncDumpCB
+(
+	 enum nf_conntrack_msg_type type,
+	 struct nf_conntrack *ct,
+	 void *data
+	 )
+{
+	ct_resync_ctx *ctx = (ct_resync_ctx *)data;
+	uint32_t src;
+
+	(void)type;
+
+	/* the event sockets filter on protocol and loopback in the kernel,
+	   the dump returns everything */
+	src = ntohl(nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_SRC));
+	if(nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO) != ctx->l4proto ||
+		 (src >> 24) == 127)
+	{
+		nfct_destroy(ct);
+		return NFCT_CB_STOLEN;
+	}
+
+	/* a dump carries the current state, replay it the way the event
+	   socket reports it */
+	if(ctx->l4proto == IPPROTO_UDP)
+	{
+		ctx->batch->Add(ct, NFCT_T_NEW);
+	}
+	else
+	{
+		ctx->batch->Add(ct, NFCT_T_UPDATE);
+	}
+	return NFCT_CB_STOLEN;
+}
+
+/*
+ * The event socket of l4proto overran and the events it dropped are
+ * gone. Dump the IPv4 conntrack table and feed the connections of the
+ * protocol through the batch, bracketed by resync events so the NAT
+ * side can delete the entries the dump no longer has.
+ */
+int IPACM_ConntrackClient::ResyncConnTrack(IPACM_ConntrackBatch *batch, uint8_t l4proto)
+{
+	struct nfct_handle *dump_hdl;
+	ct_resync_ctx ctx;
+	uint32_t family = AF_INET;
+	int ret;
+
+	dump_hdl = nfct_open(CONNTRACK, 0);
+	if(dump_hdl == NULL)
+	{
+		IPACMERR("unable to open conntrack dump handle, proto %d not resynced: %s\n",
+			l4proto, strerror(errno));
+		return -1;
+	}
+
+	if(PostResyncEvt(l4proto, CT_RESYNC_BEGIN) != 0)
+	{
+		nfct_close(dump_hdl);
+		return -1;
+	}
+
+	ctx.batch = batch;
+	ctx.l4proto = l4proto;
+	nfct_callback_register(dump_hdl, NFCT_T_ALL, ResyncDumpCB, &ctx);
+	ret = nfct_query(dump_hdl, NFCT_Q_DUMP, &family);
+	batch->Flush();
+
+	if(ret != 0)
+	{
+		IPACMERR("conntrack dump for proto %d failed: %s\n", l4proto, strerror(errno));
+		PostResyncEvt(l4proto, CT_RESYNC_ABORT);
+	}
+	else
+	{
+		IPACMDBG_H("conntrack proto %d resynced\n", l4proto);
+		PostResyncEvt(l4proto, CT_RESYNC_END);
+	}
+
+	nfct_callback_unregister(dump_hdl);
+	nfct_close(dump_hdl);
+	return ret;
+}
+
+/*
+ * Event loop of a conntrack thread. Datagrams are read in batches and
+ * the events of a batch are coalesced per connection before they are
+ * posted. When the socket overruns, the lost state is recovered with
+ * ResyncConnTrack(). Only returns on a socket error, with -1.
+ */
+int IPACM_ConntrackClient::ReceiveConnTrackEvents
+(
+	 struct nfct_handle *hdl,
+	 uint8_t l4proto,
+	 unsigned int type_mask
+)
+{
+	IPACM_ConntrackBatch *batch;
+	ct_batch_stats stats;
+
+	batch = new IPACM_ConntrackBatch(IPAConntrackEventCB, NULL, type_mask);
+	if(batch->Init(nfct_fd(hdl)) != 0)
+	{
+		delete batch;
+		return -1;
+	}
+	batch->SetRcvBuf(CT_BATCH_RCVBUF_SIZE);
+
+	while(batch->Receive() >= 0)
+	{
+		if(batch->ResyncPending())
+		{
+			batch->ResyncDone(ResyncConnTrack(batch, l4proto) == 0);
+		}
+	}
+
+	batch->GetStats(&stats);
+	IPACMERR("conntrack proto %d receive failed: %s, %llu events, %llu delivered, %llu coalesced, %llu overruns\n",
+		l4proto, strerror(errno), (unsigned long long)stats.events,
+		(unsigned long long)stats.delivered, (unsigned long long)stats.coalesced,
+		(unsigned long long)stats.overruns);
+	delete batch;
+	return -1;
+}
+
 /* Thread to initialize TCP Conntrack Filters*/
 void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 {
@@ -467,33 +624,21 @@ void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
-	/* Register callback with netfilter handler */
 	IPACMDBG_H("tcp handle:%pK, fd:%d\n", pClient->tcp_hdl, nfct_fd(pClient->tcp_hdl));
+
+	/* Block to catch events from net filter connection track, they are
+		 handed to IPAConntrackEventCB() */
+	IPACMDBG("Waiting for events\n");
 #ifndef CT_OPT
-	nfct_callback_register(pClient->tcp_hdl,
-			(nf_conntrack_msg_type)	(NFCT_T_UPDATE | NFCT_T_DESTROY | NFCT_T_NEW),
-						IPAConntrackEventCB, NULL);
+	ret = ReceiveConnTrackEvents(pClient->tcp_hdl, IPPROTO_TCP,
+			(NFCT_T_UPDATE | NFCT_T_DESTROY | NFCT_T_NEW));
 #else
-	nfct_callback_register(pClient->tcp_hdl, (nf_conntrack_msg_type) NFCT_T_ALL, IPAConntrackEventCB, NULL);
+	ret = ReceiveConnTrackEvents(pClient->tcp_hdl, IPPROTO_TCP, NFCT_T_ALL);
 #endif
-
-	/* Block to catch events from net filter connection track */
-	/* nfct_catch() receives conntrack events from kernel-space, by default it
-			 blocks waiting for events. */
-	IPACMDBG("Waiting for events\n");
-
-ctcatch:
-	ret = nfct_catch(pClient->tcp_hdl);
-	if((ret == -1) && (errno != ENOMSG))
+	if(ret != 0)
 	{
-		IPACMERR("(%d)(%d)(%s)\n", ret, errno, strerror(errno));
 		return NULL;
 	}
-	else
-	{
-		IPACMDBG("ctcatch ret:%d, errno:%d\n", ret, errno);
-		goto ctcatch;
-	}
 
 	IPACMDBG("Exit from tcp thread\n");
 
@@ -564,26 +709,15 @@ void* IPACM_ConntrackClient::UDPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
-	/* Register callback with netfilter handler */
 	IPACMDBG_H("udp handle:%pK, fd:%d\n", pClient->udp_hdl, nfct_fd(pClient->udp_hdl));
-	nfct_callback_register(pClient->udp_hdl,
-			(nf_conntrack_msg_type)(NFCT_T_NEW | NFCT_T_DESTROY),
-			IPAConntrackEventCB,
-			NULL);
-
-	/* Block to catch events from net filter connection track */
-ctcatch:
-	ret = nfct_catch(pClient->udp_hdl);
-	/* Due to conntrack dump, sequence number might mismatch for initial events. */
-	if((ret == -1) && (errno != ENOMSG) && (errno != EILSEQ))
-	{
-		IPACMDBG("(%d)(%d)(%s)\n", ret, errno, strerror(errno));
-		return NULL;
-	}
-	else
+
+	/* Block to catch events from net filter connection track, they are
+		 handed to IPAConntrackEventCB() */
+	ret = ReceiveConnTrackEvents(pClient->udp_hdl, IPPROTO_UDP,
+			(NFCT_T_NEW | NFCT_T_DESTROY));
+	if(ret != 0)
 	{
-		IPACMDBG("ctcatch ret:%d, errno:%d\n", ret, errno);
-		goto ctcatch;
+		return NULL;
 	}
 
 	IPACMDBG("Exit from udp thread with ret: %d\n", ret);
@@ -95,6 +95,7 @@ IPACM_ConntrackListener::IPACM_ConntrackListener()
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_WAN_DOWN, this);
 	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_MESSAGE, this);
 	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_MESSAGE_V6, this);
+	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_RESYNC, this);
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_WLAN_UP, this);
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_LAN_UP, this);
 	 IPACM_EvtDispatcher::registr(IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT, this);
@@ -127,6 +128,11 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 			ProcessCTMessage(data);
 			break;
 
+	 case IPA_PROCESS_CT_RESYNC:
+			IPACMDBG_H("Received IPA_PROCESS_CT_RESYNC event\n");
+			HandleCTResync(data);
+			break;
+
 #ifdef CT_OPT
 	 case IPA_PROCESS_CT_MESSAGE_V6:
 			IPACMDBG("Received IPA_PROCESS_CT_MESSAGE_V6 event\n");
@@ -1547,6 +1553,35 @@ void IPACM_ConntrackListener::processCacheConntrack(void)
 	IPACMDBG("Exit:\n");
 }
 
+/* A conntrack client dumps its connections again after losing events */
+void IPACM_ConntrackListener::HandleCTResync(void *in_param)
+{
+	ipacm_ct_resync_evt_data *data = (ipacm_ct_resync_evt_data *)in_param;
+
+	switch(data->phase)
+	{
+	case CT_RESYNC_BEGIN:
+		/* the dump only reaches the NAT table while WAN is up */
+		if(isWanUp())
+		{
+			nat_inst->ResyncBegin(data->l4proto);
+		}
+		break;
+
+	case CT_RESYNC_END:
+		nat_inst->ResyncEnd(data->l4proto, true);
+		break;
+
+	case CT_RESYNC_ABORT:
+		nat_inst->ResyncEnd(data->l4proto, false);
+		break;
+
+	default:
+		IPACMERR("Invalid resync phase %d\n", data->phase);
+		break;
+	}
+}
+
 void IPACM_ConntrackListener::HandleNatTableMove(void *in_param)
 {
 	int ret;
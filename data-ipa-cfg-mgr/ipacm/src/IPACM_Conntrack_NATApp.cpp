@@ -34,6 +34,11 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 #include "IPACM_Iface.h"
 
+#include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
 #define INVALID_IP_ADDR 0x0
 
 #define HDR_METADATA_MUX_ID_BMASK 0x00FF0000
@@ -68,6 +73,21 @@ NatApp::NatApp()
 	ct = NULL;
 	ct_hdl = NULL;
 
+	tcp_timeout = 0;
+	udp_timeout = 0;
+
+	sweep_idx = NULL;
+	sweep_hdls = NULL;
+	sweep_ts = NULL;
+
+	ct_batch_cnt = 0;
+	ct_batch_seq = 0;
+
+	resync_seen = NULL;
+	memset(resync_gen, 0, sizeof(resync_gen));
+	memset(resync_active, 0, sizeof(resync_active));
+	resync_gen_next = 0;
+
 	memset(temp, 0, sizeof(temp));
 	m_fd_ipa = open(IPA_DEVICE_NAME, O_RDWR);
 	if(m_fd_ipa < 0)
@@ -86,7 +106,6 @@ NatApp::~NatApp()
 int NatApp::Init(void)
 {
 	IPACM_Config *pConfig;
-	int size = 0;
 
 	pConfig = IPACM_Config::GetInstance();
 	if(pConfig == NULL)
@@ -99,15 +118,32 @@ int NatApp::Init(void)
 
 	max_entries = pConfig->GetNatMaxEntries();
 
-	size = (sizeof(nat_table_entry) * max_entries);
-	cache = (nat_table_entry *)malloc(size);
-	if(cache == NULL)
+	if(max_entries > 0 && nat_cache.Init(max_entries))
 	{
 		IPACMERR("Unable to allocate memory for cache\n");
 		goto fail;
 	}
-	IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
-	memset(cache, 0, size);
+	cache = nat_cache.GetEntries();
+	IPACMDBG("Allocated %d entries for config manager nat cache\n", max_entries);
+
+	if(max_entries > 0)
+	{
+		sweep_idx = (int *)malloc(max_entries * sizeof(int));
+		sweep_hdls = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+		sweep_ts = (uint32_t *)malloc(max_entries * sizeof(uint32_t));
+		if(sweep_idx == NULL || sweep_hdls == NULL || sweep_ts == NULL)
+		{
+			IPACMERR("Unable to allocate memory for timestamp sweep\n");
+			goto fail;
+		}
+
+		resync_seen = (uint32_t *)calloc(max_entries, sizeof(uint32_t));
+		if(resync_seen == NULL)
+		{
+			IPACMERR("Unable to allocate memory for conntrack resync\n");
+			goto fail;
+		}
+	}
 
 	nALGPort = pConfig->GetAlgPortCnt();
 	if(nALGPort > 0)
@@ -137,14 +173,18 @@ int NatApp::Init(void)
 	return 0;
 
 fail:
-	if(cache != NULL)
-	{
-		free(cache);
-	}
 	if(pALGPorts != NULL)
 	{
 		free(pALGPorts);
 	}
+	free(sweep_idx);
+	free(sweep_hdls);
+	free(sweep_ts);
+	free(resync_seen);
+	sweep_idx = NULL;
+	sweep_hdls = NULL;
+	sweep_ts = NULL;
+	resync_seen = NULL;
 	return -1;
 }
 
@@ -225,7 +265,7 @@ int NatApp::AddTable(uint32_t pub_ip, uint8_t mux_id)
 				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 				{
 					IPACMERR("unable to add the rule delete from cache\n");
-					memset(&cache[cnt], 0, sizeof(cache[cnt]));
+					nat_cache.Free(cnt);
 					curCnt--;
 					continue;
 				}
@@ -336,21 +376,13 @@ int NatApp::MoveTable(bool to_ddr)
 /* Check for duplicate entries */
 bool NatApp::ChkForDup(const nat_table_entry *rule)
 {
-	int cnt = 0;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
-	for(; cnt < max_entries; cnt++)
+	if(nat_cache.Find(rule) != NAT_CACHE_INVALID_IDX)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
-		{
-			log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
-			rule->target_port,"Duplicate Rule\n");
-			return true;
-		}
+		log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
+		rule->target_port,"Duplicate Rule\n");
+		return true;
 	}
 
 	return false;
@@ -359,7 +391,7 @@ bool NatApp::ChkForDup(const nat_table_entry *rule)
 /* Delete the entry from Nat table on connection close */
 int NatApp::DeleteEntry(const nat_table_entry *rule)
 {
-	int cnt = 0;
+	int cnt;
 	int ret = 0;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
@@ -367,48 +399,40 @@ int NatApp::DeleteEntry(const nat_table_entry *rule)
 	rule->target_port,"for deletion\n");
 
 
-	for(; cnt < max_entries; cnt++)
+	cnt = nat_cache.Find(rule);
+	if(cnt != NAT_CACHE_INVALID_IDX)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
+		if(cache[cnt].enabled == true)
 		{
-
-			if(cache[cnt].enabled == true)
+			/* send connections del info to pcie modem first */
+			if ((CtList->backhaul_mode == Q6_MHI_WAN) && (cache[cnt].dst_nat == true || cache[cnt].protocol == IPPROTO_TCP) && (cache[cnt].rule_id > 0))
 			{
-				/* send connections del info to pcie modem first */
-				if ((CtList->backhaul_mode == Q6_MHI_WAN) && (cache[cnt].dst_nat == true || cache[cnt].protocol == IPPROTO_TCP) && (cache[cnt].rule_id > 0))
+				ret = DelConnection(cache[cnt].rule_id);
+				if(ret)
 				{
-					ret = DelConnection(cache[cnt].rule_id);
-					if(ret)
-					{
-						IPACMERR("unable to del Connection to pcie modem: %d\n", ret);
-					}
-					else
-					{
-						/* save the rule id for deletion */
-						cache[cnt].rule_id = 0;
-					}
+					IPACMERR("unable to del Connection to pcie modem: %d\n", ret);
 				}
-
-				if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+				else
 				{
-					IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
+					/* save the rule id for deletion */
+					cache[cnt].rule_id = 0;
 				}
-
-				IPACMDBG_H("Deleted Nat entry(%d) Successfully\n", cnt);
 			}
-			else
+
+			if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
 			{
-				IPACMDBG_H("Deleted Nat entry(%d) only from cache\n", cnt);
+				IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
-			break;
+			IPACMDBG_H("Deleted Nat entry(%d) Successfully\n", cnt);
 		}
+		else
+		{
+			IPACMDBG_H("Deleted Nat entry(%d) only from cache\n", cnt);
+		}
+
+		nat_cache.Free(cnt);
+		curCnt--;
 	}
 
 	return 0;
@@ -445,19 +469,8 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 
 	if(!ChkForDup(rule))
 	{
-		for(; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
+		cnt = nat_cache.Alloc(rule);
+		if(cnt == NAT_CACHE_INVALID_IDX)
 		{
 			IPACMERR("Error: Unable to add, reached maximum rules\n");
 			return -1;
@@ -485,6 +498,7 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 				{
 					IPACMERR("unable to add the rule\n");
+					nat_cache.Free(cnt);
 					return -1;
 				}
 
@@ -506,21 +520,18 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 					}
 				}
 			}
-			cache[cnt].private_ip = rule->private_ip;
-			cache[cnt].target_ip = rule->target_ip;
-			cache[cnt].target_port = rule->target_port;
-			cache[cnt].private_port = rule->private_port;
-			cache[cnt].protocol = rule->protocol;
 			cache[cnt].timestamp = 0;
 			cache[cnt].public_port = rule->public_port;
 			cache[cnt].dst_nat = rule->dst_nat;
 			curCnt++;
+			MarkResynced(cnt);
 		}
 
 	}
 	else
 	{
 		IPACMERR("Duplicate rule. Ignore it\n");
+		MarkResynced(nat_cache.Find(rule));
 		return -1;
 	}
 
@@ -666,25 +677,17 @@ fail:
 	return res;
 }
 
-void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
-{
-#ifdef FEATURE_IPACM_HAL
-	IOffloadManager::ConntrackTimeoutUpdater::natTimeoutUpdate_t entry;
-	IPACM_OffloadManager* OffloadMng;
-#endif
-	iptodot("Private IP:", rule->private_ip);
-	iptodot("Target IP:",  rule->target_ip);
-	IPACMDBG("Private Port: %d, Target Port: %d\n", rule->private_port, rule->target_port);
-
 #ifndef FEATURE_IPACM_HAL
-	int ret;
+/* Loads rule's conntrack tuple and refreshed timeout into ct */
+int NatApp::SetCTTimeout(const nat_table_entry *rule)
+{
 	if(!ct_hdl)
 	{
 		ct_hdl = nfct_open(CONNTRACK, 0);
 		if(!ct_hdl)
 		{
 			PERROR("nfct_open");
-			return;
+			return -1;
 		}
 	}
 
@@ -694,7 +697,7 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 		if(!ct)
 		{
 			PERROR("nfct_new");
-			return;
+			return -1;
 		}
 	}
 
@@ -739,6 +742,27 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 	IPACMDBG("updating %d connection with time: %d\n",
 					 rule->protocol, nfct_get_attr_u32(ct, ATTR_TIMEOUT));
 
+	return 0;
+}
+#endif
+
+void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
+{
+#ifdef FEATURE_IPACM_HAL
+	IOffloadManager::ConntrackTimeoutUpdater::natTimeoutUpdate_t entry;
+	IPACM_OffloadManager* OffloadMng;
+#endif
+	iptodot("Private IP:", rule->private_ip);
+	iptodot("Target IP:",  rule->target_ip);
+	IPACMDBG("Private Port: %d, Target Port: %d\n", rule->private_port, rule->target_port);
+
+#ifndef FEATURE_IPACM_HAL
+	int ret;
+	if(SetCTTimeout(rule))
+	{
+		return;
+	}
+
 	ret = nfct_query(ct_hdl, NFCT_Q_UPDATE, ct);
 	if(ret == -1)
 	{
@@ -794,65 +818,386 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 	return;
 }
 
-void NatApp::UpdateUDPTimeStamp()
+/*
+ * Stages a conntrack timeout refresh for rule. Staged refreshes go
+ * down in one sendmsg() per UDP_SWEEP_CT_BATCH rules, so a sweep
+ * that finds thousands of changed flows doesn't pay one netlink round
+ * trip each. The HAL has no batch interface, forward right away.
+ */
+void NatApp::QueueCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 {
-	int cnt;
-	uint32_t ts;
-	bool read_to = false;
-	bool keep_awake;
+#ifndef FEATURE_IPACM_HAL
+	struct nlmsghdr *nlh;
+	struct nfgenmsg *nfh;
+
+	if(SetCTTimeout(rule))
+	{
+		return;
+	}
+
+	nlh = (struct nlmsghdr *)ct_batch_buf[ct_batch_cnt];
+	memset(nlh, 0, UDP_SWEEP_CT_MSG_SIZE);
+	nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct nfgenmsg));
+	nlh->nlmsg_type = (NFNL_SUBSYS_CTNETLINK << 8) | IPCTNL_MSG_CT_NEW;
+	nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+	nlh->nlmsg_seq = ++ct_batch_seq;
+
+	nfh = (struct nfgenmsg *)NLMSG_DATA(nlh);
+	nfh->nfgen_family = AF_INET;
+	nfh->version = NFNETLINK_V0;
+	nfh->res_id = 0;
+
+	if(nfct_nlmsg_build(nlh, ct) < 0 ||
+		 NLMSG_ALIGN(nlh->nlmsg_len) > UDP_SWEEP_CT_MSG_SIZE)
+	{
+		IPACMERR("unable to build conntrack update, sending it alone\n");
+		UpdateCTUdpTs(rule, new_ts);
+		return;
+	}
 
-	keep_awake = ( max_entries && SRAM_IN_USE() && ipa_nat_is_sram_supported() );
+	ct_batch_rule[ct_batch_cnt] = rule;
+	ct_batch_ts[ct_batch_cnt] = new_ts;
+	ct_batch_cnt++;
 
-	if ( keep_awake )
+	if(ct_batch_cnt == UDP_SWEEP_CT_BATCH)
 	{
-		IPACMDBG("Voting clock on\n");
+		FlushCTUdpTs();
+	}
+#else
+	UpdateCTUdpTs(rule, new_ts);
+#endif
+	return;
+}
+
+/*
+ * Sends the staged refreshes and matches the acks back by sequence
+ * number. Same outcome per rule as UpdateCTUdpTs(): the cached
+ * timestamp moves on success, the entry is dropped if conntrack
+ * no longer knows the flow.
+ */
+void NatApp::FlushCTUdpTs()
+{
+#ifndef FEATURE_IPACM_HAL
+	struct iovec iov[UDP_SWEEP_CT_BATCH];
+	struct sockaddr_nl peer;
+	struct msghdr msg;
+	struct nlmsghdr *nlh;
+	struct nlmsgerr *err;
+	char buf[8192];
+	uint32_t first_seq, slot;
+	int cnt, len, acked = 0, fd;
+
+	if(ct_batch_cnt == 0)
+	{
+		return;
+	}
+
+	for(cnt = 0; cnt < ct_batch_cnt; cnt++)
+	{
+		nlh = (struct nlmsghdr *)ct_batch_buf[cnt];
+		iov[cnt].iov_base = nlh;
+		iov[cnt].iov_len = NLMSG_ALIGN(nlh->nlmsg_len);
+	}
+	first_seq = ((struct nlmsghdr *)ct_batch_buf[0])->nlmsg_seq;
+
+	memset(&peer, 0, sizeof(peer));
+	peer.nl_family = AF_NETLINK;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &peer;
+	msg.msg_namelen = sizeof(peer);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = ct_batch_cnt;
+
+	fd = nfct_fd(ct_hdl);
+	if(sendmsg(fd, &msg, 0) < 0)
+	{
+		IPACMERR("unable to send %d conntrack updates: %s, sending one by one\n",
+						 ct_batch_cnt, strerror(errno));
+		for(cnt = 0; cnt < ct_batch_cnt; cnt++)
+		{
+			UpdateCTUdpTs(ct_batch_rule[cnt], ct_batch_ts[cnt]);
+		}
+		ct_batch_cnt = 0;
+		return;
+	}
 
-		if ( ipa_nat_vote_clock(IPA_APP_CLK_VOTE) != 0 )
+	while(acked < ct_batch_cnt)
+	{
+		len = recv(fd, buf, sizeof(buf), 0);
+		if(len <= 0)
 		{
-			IPACMERR("Voting clock on failed\n");
-			return;
+			IPACMERR("lost %d conntrack update acks: %s\n",
+							 ct_batch_cnt - acked, strerror(errno));
+			break;
+		}
+
+		for(nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, (uint32_t)len); nlh = NLMSG_NEXT(nlh, len))
+		{
+			if(nlh->nlmsg_type != NLMSG_ERROR)
+			{
+				continue;
+			}
+
+			err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+			slot = err->msg.nlmsg_seq - first_seq;
+			if(slot >= (uint32_t)ct_batch_cnt)
+			{
+				continue;
+			}
+			acked++;
+
+			if(err->error != 0)
+			{
+				IPACMERR("unable to update time stamp: %d\n", err->error);
+				DeleteEntry(ct_batch_rule[slot]);
+			}
+			else
+			{
+				ct_batch_rule[slot]->timestamp = ct_batch_ts[slot];
+			}
 		}
 	}
 
+	IPACMDBG("Updated %d of %d time stamps in one batch\n", acked, ct_batch_cnt);
+	ct_batch_cnt = 0;
+#endif
+	return;
+}
+
+/*
+ * One pass over the offloaded connections: the IPA timestamps are
+ * read in bulk, flows that moved get their conntrack timeout pushed
+ * out. Returns the number of seconds until the next pass.
+ *
+ * The interval grows with the number of UDP flows so the per-flow
+ * work is spread over a longer period on busy tables, and backs off
+ * fully when there are none. It is capped at half the conntrack UDP
+ * timeout so a flow carried by hardware is always refreshed before
+ * the kernel would age it out.
+ */
+unsigned int NatApp::UpdateUDPTimeStamp()
+{
+	int cnt, idx, num = 0, num_read = 0, udp_flows = 0, refreshed = 0;
+	uint32_t ts;
+	bool read_to = false;
+	bool keep_awake;
+	unsigned int interval, ceiling;
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
 	for(cnt = 0; cnt < max_entries; cnt++)
 	{
-		ts = 0;
 		if(cache[cnt].enabled == true &&
 		   (cache[cnt].private_ip != cache[cnt].public_ip))
 		{
-			IPACMDBG("\n");
-			if(ipa_nat_query_timestamp(nat_table_hdl, cache[cnt].rule_hdl, &ts) < 0)
+			sweep_idx[num] = cnt;
+			sweep_hdls[num] = cache[cnt].rule_hdl;
+			num++;
+
+			if(cache[cnt].protocol == IPPROTO_UDP)
 			{
-				IPACMERR("unable to retrieve timeout for rule hanle: %d\n", cache[cnt].rule_hdl);
-				continue;
+				udp_flows++;
 			}
+		}
+	}
+
+	if(num > 0)
+	{
+		keep_awake = ( SRAM_IN_USE() && ipa_nat_is_sram_supported() );
+
+		if ( keep_awake )
+		{
+			IPACMDBG("Voting clock on\n");
 
-			if(cache[cnt].timestamp == ts)
+			if ( ipa_nat_vote_clock(IPA_APP_CLK_VOTE) != 0 )
 			{
-				IPACMDBG("No Change in Time Stamp: cahce:%d, ipahw:%d\n",
-								                  cache[cnt].timestamp, ts);
-				continue;
+				IPACMERR("Voting clock on failed\n");
+				return UDP_TIMEOUT_UPDATE;
 			}
+		}
+
+		num_read = ipa_nat_query_timestamps(nat_table_hdl, sweep_hdls, sweep_ts, num);
+
+		if ( keep_awake )
+		{
+			IPACMDBG("Voting clock off\n");
 
-			if (read_to == false) {
-				read_to = true;
-				Read_TcpUdp_Timeout();
+			if ( ipa_nat_vote_clock(IPA_APP_CLK_DEVOTE) != 0 )
+			{
+				IPACMERR("Voting clock off failed\n");
 			}
+		}
+
+		if(num_read < 0)
+		{
+			IPACMERR("unable to retrieve timestamps for %d rules\n", num);
+			num = 0;
+		}
+	}
+
+	for(cnt = 0; cnt < num; cnt++)
+	{
+		idx = sweep_idx[cnt];
+		ts = sweep_ts[cnt];
+
+		/* zero is what the bulk read leaves for rules it couldn't read */
+		if(ts == 0 || cache[idx].timestamp == ts)
+		{
+			continue;
+		}
+
+		if (read_to == false) {
+			read_to = true;
+			Read_TcpUdp_Timeout();
+		}
+
+		QueueCTUdpTs(&cache[idx], ts);
+		refreshed++;
+	}
+	FlushCTUdpTs();
+
+	if(udp_timeout == 0)
+	{
+		Read_TcpUdp_Timeout();
+	}
+
+	ceiling = UDP_SWEEP_MAX_INTERVAL;
+	if(udp_timeout == 0)
+	{
+		ceiling = UDP_TIMEOUT_UPDATE;
+	}
+	else if(udp_timeout / 2 < ceiling)
+	{
+		ceiling = udp_timeout / 2;
+	}
+
+	if(udp_flows == 0)
+	{
+		interval = ceiling;
+	}
+	else
+	{
+		interval = UDP_TIMEOUT_UPDATE + udp_flows / UDP_SWEEP_FLOWS_PER_SEC;
+		if(interval > ceiling)
+		{
+			interval = ceiling;
+		}
+	}
+	if(interval == 0)
+	{
+		interval = 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	IPACMDBG_H("UDP sweep: %d rules, %d read, %d refreshed, %d udp flows, %ld us, next in %u s\n",
+					 num, num_read, refreshed, udp_flows,
+					 (long)((end.tv_sec - start.tv_sec) * 1000000 +
+					        (end.tv_nsec - start.tv_nsec) / 1000),
+					 interval);
+
+	return interval;
+}
+
+static int ResyncProtoIdx(uint8_t proto)
+{
+	if(proto == IPPROTO_TCP)
+	{
+		return 0;
+	}
+	if(proto == IPPROTO_UDP)
+	{
+		return 1;
+	}
+	return -1;
+}
+
+/* Tag a cached entry as present in the conntrack resync of its protocol */
+void NatApp::MarkResynced(int cnt)
+{
+	int idx;
 
-			UpdateCTUdpTs(&cache[cnt], ts);
-		} /* end of outer if */
+	if(resync_seen == NULL || cnt < 0 || cnt >= max_entries)
+	{
+		return;
+	}
+
+	idx = ResyncProtoIdx(cache[cnt].protocol);
+	if(idx >= 0 && resync_active[idx])
+	{
+		resync_seen[cnt] = resync_gen[idx];
+	}
+}
+
+/*
+ * The conntrack client lost events for proto and is dumping its
+ * connections again. Every entry the dump hits goes through AddEntry
+ * and is tagged with a fresh generation.
+ */
+void NatApp::ResyncBegin(uint8_t proto)
+{
+	int idx = ResyncProtoIdx(proto);
+
+	if(idx < 0 || resync_seen == NULL)
+	{
+		return;
+	}
+
+	resync_gen_next++;
+	if(resync_gen_next == 0)
+	{
+		/* never hand out the value entries are allocated with */
+		memset(resync_seen, 0, max_entries * sizeof(uint32_t));
+		resync_gen_next = 1;
+	}
+	resync_gen[idx] = resync_gen_next;
+	resync_active[idx] = true;
+
+	IPACMDBG_H("conntrack resync of proto %d started, generation %u\n", proto, resync_gen[idx]);
+}
 
-	} /* end of for loop */
+/*
+ * End of the dump. If it completed, the entries of proto it did not
+ * hit belong to connections whose destroy event was lost: delete them.
+ * An aborted dump proves nothing and only closes the window.
+ * Returns the number of entries deleted.
+ */
+int NatApp::ResyncEnd(uint8_t proto, bool sweep)
+{
+	int idx = ResyncProtoIdx(proto);
+	int cnt, deleted = 0;
 
-	if ( keep_awake )
+	if(idx < 0 || resync_active[idx] == false)
 	{
-		IPACMDBG("Voting clock off\n");
+		return 0;
+	}
+	resync_active[idx] = false;
 
-		if ( ipa_nat_vote_clock(IPA_APP_CLK_DEVOTE) != 0 )
+	if(sweep)
+	{
+		for(cnt = 0; cnt < max_entries; cnt++)
 		{
-			IPACMERR("Voting clock off failed\n");
+			if(cache[cnt].private_ip == 0 || cache[cnt].protocol != proto ||
+			   resync_seen[cnt] == resync_gen[idx])
+			{
+				continue;
+			}
+
+			log_nat(cache[cnt].protocol, cache[cnt].private_ip, cache[cnt].target_ip,
+							cache[cnt].private_port, cache[cnt].target_port, "stale after resync\n");
+			/* DeleteEntry() frees the slot, so work on a copy */
+			nat_table_entry rule = cache[cnt];
+			if(DeleteEntry(&rule) == 0)
+			{
+				deleted++;
+			}
 		}
 	}
+
+	IPACMDBG_H("conntrack resync of proto %d %s, %d stale entries deleted\n",
+					 proto, sweep ? "done" : "aborted", deleted);
+	return deleted;
 }
 
 bool NatApp::isAlgPort(uint8_t proto, uint16_t port)
@@ -888,7 +1233,7 @@ bool NatApp::isPwrSaveIf(uint32_t ip_addr)
 
 int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 {
-	int cnt, ret;
+	int cnt, next, ret;
 	IPACMDBG_H("Received IP address: 0x%x\n", client_lan_ip);
 
 	if(client_lan_ip == INVALID_IP_ADDR)
@@ -916,10 +1261,10 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = nat_cache.FirstOfClnt(client_lan_ip); cnt != NAT_CACHE_INVALID_IDX; cnt = next)
 	{
-		if(cache[cnt].private_ip == client_lan_ip &&
-			 cache[cnt].enabled == true)
+		next = nat_cache.NextOfClnt(cnt);
+		if(cache[cnt].enabled == true)
 		{
 			/* send connections del info to pcie modem first */
 			if ((CtList->backhaul_mode == Q6_MHI_WAN) && (cache[cnt].dst_nat == true || cache[cnt].protocol == IPPROTO_TCP) && (cache[cnt].rule_id > 0))
@@ -952,7 +1297,7 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 
 int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 {
-	int cnt, ret;
+	int cnt, next, ret;
 	ipa_nat_ipv4_rule nat_rule;
 
 	IPACMDBG_H("Received ip address: 0x%x\n", client_lan_ip);
@@ -972,12 +1317,12 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = nat_cache.FirstOfClnt(client_lan_ip); cnt != NAT_CACHE_INVALID_IDX; cnt = next)
 	{
+		next = nat_cache.NextOfClnt(cnt);
 		IPACMDBG("cache (%d): enable %d, ip 0x%x\n", cnt, cache[cnt].enabled, cache[cnt].private_ip);
 
-		if(cache[cnt].private_ip == client_lan_ip &&
-			 cache[cnt].enabled == false)
+		if(cache[cnt].enabled == false)
 		{
 			memset(&nat_rule, 0 , sizeof(nat_rule));
 			nat_rule.private_ip = cache[cnt].private_ip;
@@ -990,7 +1335,7 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 			if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 			{
 				IPACMERR("unable to add the rule delete from cache\n");
-				memset(&cache[cnt], 0, sizeof(cache[cnt]));
+				nat_cache.Free(cnt);
 				curCnt--;
 				continue;
 			}
@@ -1156,7 +1501,7 @@ void NatApp::FlushTempEntries(uint32_t ip_addr, bool isAdd,
 
 int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 {
-	int cnt, tmp = 0, ret;
+	int cnt, next, tmp = 0, ret;
 	IPACMDBG_H("Received IP address: 0x%x\n", ip_addr);
 
 	if(ip_addr == INVALID_IP_ADDR)
@@ -1175,41 +1520,39 @@ int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = nat_cache.FirstOfClnt(ip_addr); cnt != NAT_CACHE_INVALID_IDX; cnt = next)
 	{
-		if(cache[cnt].private_ip == ip_addr)
+		next = nat_cache.NextOfClnt(cnt);
+		if(cache[cnt].enabled == true)
 		{
-			if(cache[cnt].enabled == true)
+			/* send connections del info to pcie modem first */
+			if ((CtList->backhaul_mode == Q6_MHI_WAN) && (cache[cnt].dst_nat == true || cache[cnt].protocol == IPPROTO_TCP) && (cache[cnt].rule_id > 0))
 			{
-				/* send connections del info to pcie modem first */
-				if ((CtList->backhaul_mode == Q6_MHI_WAN) && (cache[cnt].dst_nat == true || cache[cnt].protocol == IPPROTO_TCP) && (cache[cnt].rule_id > 0))
-				{
-					ret = DelConnection(cache[cnt].rule_id);
-					if(ret)
-					{
-						IPACMERR("unable to del Connection to pcie modem: %d\n", ret);
-					}
-					else
-					{
-						/* save the rule id for deletion */
-						cache[cnt].rule_id = 0;
-					}
-				}
-
-				if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+				ret = DelConnection(cache[cnt].rule_id);
+				if(ret)
 				{
-					IPACMERR("unable to delete the rule\n");
-					continue;
+					IPACMERR("unable to del Connection to pcie modem: %d\n", ret);
 				}
 				else
 				{
-					IPACMDBG("won't delete the rule\n");
-					cache[cnt].enabled = false;
-					tmp++;
+					/* save the rule id for deletion */
+					cache[cnt].rule_id = 0;
 				}
 			}
-			IPACMDBG("won't delete the rule for entry %d, enabled %d\n",cnt, cache[cnt].enabled);
+
+			if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+			{
+				IPACMERR("unable to delete the rule\n");
+				continue;
+			}
+			else
+			{
+				IPACMDBG("won't delete the rule\n");
+				cache[cnt].enabled = false;
+				tmp++;
+			}
 		}
+		IPACMDBG("won't delete the rule for entry %d, enabled %d\n",cnt, cache[cnt].enabled);
 	}
 
 	IPACMDBG("Deleted (but cached) %d entries\n", tmp);
@@ -1256,7 +1599,7 @@ int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 				}
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
+			nat_cache.Free(cnt);
 			curCnt--;
 		}
 	}
@@ -1281,19 +1624,8 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 
 	if(!ChkForDup(rule))
 	{
-		for(cnt=0; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
+		cnt = nat_cache.Alloc(rule);
+		if(cnt == NAT_CACHE_INVALID_IDX)
 		{
 			IPACMERR("Error: Unable to add, reached maximum rules\n");
 			return;
@@ -1302,22 +1634,19 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 		{
 			cache[cnt].enabled = false;
 			cache[cnt].rule_hdl = 0;
-			cache[cnt].private_ip = rule->private_ip;
-			cache[cnt].target_ip = rule->target_ip;
-			cache[cnt].target_port = rule->target_port;
-			cache[cnt].private_port = rule->private_port;
-			cache[cnt].protocol = rule->protocol;
 			cache[cnt].timestamp = 0;
 			cache[cnt].public_port = rule->public_port;
 			cache[cnt].public_ip = rule->public_ip;
 			cache[cnt].dst_nat = rule->dst_nat;
 			curCnt++;
+			MarkResynced(cnt);
 		}
 
 	}
 	else
 	{
 		IPACMERR("Duplicate rule. Ignore it\n");
+		MarkResynced(nat_cache.Find(rule));
 		return;
 	}
 
@@ -0,0 +1,291 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Conntrack_NATCache.cpp
+
+	@brief
+	This file implements the 5-tuple and client ip index of the NatApp
+	connection cache.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "IPACM_Conntrack_NATCache.h"
+#include "IPACM_Log.h"
+
+NatCache::NatCache()
+{
+	entries = NULL;
+	links = NULL;
+	tuple_heads = NULL;
+	clnt_heads = NULL;
+	tuple_mask = 0;
+	free_head = NAT_CACHE_INVALID_IDX;
+	max_entries = 0;
+}
+
+NatCache::~NatCache()
+{
+	free(entries);
+	free(links);
+	free(tuple_heads);
+	free(clnt_heads);
+}
+
+int NatCache::Init(int num_entries)
+{
+	uint32_t tuple_buckets = 1;
+	int cnt;
+
+	if(num_entries <= 0 || entries != NULL)
+	{
+		IPACMERR("Invalid number of cache entries %d\n", num_entries);
+		return -1;
+	}
+
+	/* at most one entry per chain on average */
+	while(tuple_buckets < (uint32_t)num_entries)
+	{
+		tuple_buckets <<= 1;
+	}
+
+	entries = (nat_table_entry *)calloc(num_entries, sizeof(nat_table_entry));
+	links = (nat_cache_link *)malloc(num_entries * sizeof(nat_cache_link));
+	tuple_heads = (int *)malloc(tuple_buckets * sizeof(int));
+	clnt_heads = (int *)malloc(NAT_CACHE_CLNT_BUCKETS * sizeof(int));
+	if(entries == NULL || links == NULL || tuple_heads == NULL || clnt_heads == NULL)
+	{
+		IPACMERR("Unable to allocate memory for %d cache entries\n", num_entries);
+		free(entries);
+		free(links);
+		free(tuple_heads);
+		free(clnt_heads);
+		entries = NULL;
+		links = NULL;
+		tuple_heads = NULL;
+		clnt_heads = NULL;
+		return -1;
+	}
+
+	for(cnt = 0; cnt < (int)tuple_buckets; cnt++)
+	{
+		tuple_heads[cnt] = NAT_CACHE_INVALID_IDX;
+	}
+	for(cnt = 0; cnt < NAT_CACHE_CLNT_BUCKETS; cnt++)
+	{
+		clnt_heads[cnt] = NAT_CACHE_INVALID_IDX;
+	}
+
+	/* free list in index order, so entries are taken from the start of the array */
+	for(cnt = 0; cnt < num_entries; cnt++)
+	{
+		links[cnt].tuple_next = NAT_CACHE_INVALID_IDX;
+		links[cnt].tuple_prev = NAT_CACHE_INVALID_IDX;
+		links[cnt].clnt_next = (cnt + 1 < num_entries) ? cnt + 1 : NAT_CACHE_INVALID_IDX;
+		links[cnt].clnt_prev = NAT_CACHE_INVALID_IDX;
+	}
+	free_head = 0;
+	tuple_mask = tuple_buckets - 1;
+	max_entries = num_entries;
+
+	IPACMDBG("Allocated %d cache entries, %u tuple chains\n", num_entries, tuple_buckets);
+	return 0;
+}
+
+uint32_t NatCache::TupleHash(const nat_table_entry *rule)
+{
+	uint32_t hash;
+
+	hash = rule->private_ip * 0x9E3779B1;
+	hash ^= rule->target_ip + 0x7F4A7C15 + (hash << 6) + (hash >> 2);
+	hash ^= (((uint32_t)rule->private_port << 16) | rule->target_port) * 0x85EBCA77;
+	hash ^= rule->protocol;
+
+	/* murmur3 finalizer, the chain is taken from the low bits */
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6B;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+uint32_t NatCache::ClntHash(uint32_t ip_addr)
+{
+	return ((ip_addr * 0x9E3779B1) >> 16) & (NAT_CACHE_CLNT_BUCKETS - 1);
+}
+
+bool NatCache::IsSameTuple(const nat_table_entry *a, const nat_table_entry *b)
+{
+	return (a->private_ip == b->private_ip &&
+			a->target_ip == b->target_ip &&
+			a->private_port == b->private_port &&
+			a->target_port == b->target_port &&
+			a->protocol == b->protocol);
+}
+
+int NatCache::Find(const nat_table_entry *rule)
+{
+	int idx;
+
+	if(entries == NULL)
+	{
+		return NAT_CACHE_INVALID_IDX;
+	}
+
+	for(idx = tuple_heads[TupleHash(rule) & tuple_mask];
+		idx != NAT_CACHE_INVALID_IDX;
+		idx = links[idx].tuple_next)
+	{
+		if(IsSameTuple(&entries[idx], rule))
+		{
+			return idx;
+		}
+	}
+
+	return NAT_CACHE_INVALID_IDX;
+}
+
+int NatCache::Alloc(const nat_table_entry *rule)
+{
+	int idx = free_head;
+	int *head;
+
+	if(idx == NAT_CACHE_INVALID_IDX)
+	{
+		return NAT_CACHE_INVALID_IDX;
+	}
+	free_head = links[idx].clnt_next;
+
+	memset(&entries[idx], 0, sizeof(entries[idx]));
+	entries[idx].private_ip = rule->private_ip;
+	entries[idx].target_ip = rule->target_ip;
+	entries[idx].private_port = rule->private_port;
+	entries[idx].target_port = rule->target_port;
+	entries[idx].protocol = rule->protocol;
+
+	head = &tuple_heads[TupleHash(rule) & tuple_mask];
+	links[idx].tuple_prev = NAT_CACHE_INVALID_IDX;
+	links[idx].tuple_next = *head;
+	if(*head != NAT_CACHE_INVALID_IDX)
+	{
+		links[*head].tuple_prev = idx;
+	}
+	*head = idx;
+
+	head = &clnt_heads[ClntHash(rule->private_ip)];
+	links[idx].clnt_prev = NAT_CACHE_INVALID_IDX;
+	links[idx].clnt_next = *head;
+	if(*head != NAT_CACHE_INVALID_IDX)
+	{
+		links[*head].clnt_prev = idx;
+	}
+	*head = idx;
+
+	return idx;
+}
+
+void NatCache::Free(int idx)
+{
+	nat_cache_link *link;
+
+	if(idx < 0 || idx >= max_entries)
+	{
+		IPACMERR("Invalid cache entry %d\n", idx);
+		return;
+	}
+	link = &links[idx];
+
+	if(link->tuple_prev != NAT_CACHE_INVALID_IDX)
+	{
+		links[link->tuple_prev].tuple_next = link->tuple_next;
+	}
+	else
+	{
+		tuple_heads[TupleHash(&entries[idx]) & tuple_mask] = link->tuple_next;
+	}
+	if(link->tuple_next != NAT_CACHE_INVALID_IDX)
+	{
+		links[link->tuple_next].tuple_prev = link->tuple_prev;
+	}
+
+	if(link->clnt_prev != NAT_CACHE_INVALID_IDX)
+	{
+		links[link->clnt_prev].clnt_next = link->clnt_next;
+	}
+	else
+	{
+		clnt_heads[ClntHash(entries[idx].private_ip)] = link->clnt_next;
+	}
+	if(link->clnt_next != NAT_CACHE_INVALID_IDX)
+	{
+		links[link->clnt_next].clnt_prev = link->clnt_prev;
+	}
+
+	memset(&entries[idx], 0, sizeof(entries[idx]));
+	link->tuple_next = NAT_CACHE_INVALID_IDX;
+	link->tuple_prev = NAT_CACHE_INVALID_IDX;
+	link->clnt_prev = NAT_CACHE_INVALID_IDX;
+	link->clnt_next = free_head;
+	free_head = idx;
+}
+
+int NatCache::FirstOfClnt(uint32_t ip_addr)
+{
+	int idx;
+
+	if(entries == NULL)
+	{
+		return NAT_CACHE_INVALID_IDX;
+	}
+
+	idx = clnt_heads[ClntHash(ip_addr)];
+	while(idx != NAT_CACHE_INVALID_IDX && entries[idx].private_ip != ip_addr)
+	{
+		idx = links[idx].clnt_next;
+	}
+	return idx;
+}
+
+int NatCache::NextOfClnt(int idx)
+{
+	uint32_t ip_addr = entries[idx].private_ip;
+
+	idx = links[idx].clnt_next;
+	while(idx != NAT_CACHE_INVALID_IDX && entries[idx].private_ip != ip_addr)
+	{
+		idx = links[idx].clnt_next;
+	}
+	return idx;
+}
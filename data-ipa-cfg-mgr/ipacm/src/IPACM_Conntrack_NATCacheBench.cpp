@@ -0,0 +1,370 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Conntrack_NATCacheBench.cpp
+
+	@brief
+	Conntrack replay benchmark for the NatApp connection cache. Fills a
+	cache of 10k to 64k entries to 90%, then replays NEW, duplicate NEW and
+	DESTROY events and client disconnect walks against NatCache and against
+	the flat array scans NatApp did before, and reports events/sec of both.
+
+	usage: ipacm_nat_cache_bench [events]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "IPACM_Conntrack_NATCache.h"
+
+#define DEFAULT_EVENTS 1000000
+/* the flat array scans are too slow to replay all events at 64k entries */
+#define LINEAR_EVENTS 5000
+#define NUM_CLIENTS 64
+/* one client disconnect walk every so many events */
+#define CLNT_WALK_PERIOD 1000
+
+static const int table_sizes[] = { 10000, 30000, 65535 };
+
+typedef enum
+{
+	EVT_NEW,
+	EVT_DUP,
+	EVT_DESTROY,
+	EVT_CLNT_WALK
+} replay_evt;
+
+typedef struct
+{
+	replay_evt evt;
+	nat_table_entry rule;
+} replay_entry;
+
+static uint64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t seed = 1;
+static uint32_t Rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 1;
+}
+
+static void NewFlow(nat_table_entry *rule)
+{
+	memset(rule, 0, sizeof(*rule));
+	rule->private_ip = 0xC0A82A02 + Rand() % NUM_CLIENTS;
+	rule->private_port = 1024 + Rand() % 64000;
+	rule->target_ip = 0x08080000 + Rand() % 0x10000;
+	rule->target_port = (Rand() % 4) ? 443 : 1 + Rand() % 65535;
+	rule->protocol = (Rand() % 3) ? 6 : 17;
+}
+
+/* events as conntrack delivers them with the table around 90% full */
+static void MakeReplay(int max_entries, int num_events, std::vector<nat_table_entry> &initial,
+	std::vector<replay_entry> &events)
+{
+	std::vector<nat_table_entry> live;
+	replay_entry entry;
+	int cnt, idx;
+
+	seed = max_entries;
+	initial.clear();
+	events.clear();
+	while((int)initial.size() < max_entries * 9 / 10)
+	{
+		NewFlow(&entry.rule);
+		initial.push_back(entry.rule);
+	}
+	live = initial;
+
+	for(cnt = 0; cnt < num_events; cnt++)
+	{
+		if(cnt % CLNT_WALK_PERIOD == CLNT_WALK_PERIOD - 1)
+		{
+			entry.evt = EVT_CLNT_WALK;
+			entry.rule.private_ip = 0xC0A82A02 + Rand() % NUM_CLIENTS;
+		}
+		else if(Rand() % 10 == 0 && !live.empty())
+		{
+			entry.evt = EVT_DUP;
+			entry.rule = live[Rand() % live.size()];
+		}
+		else if(((Rand() & 1) || (int)live.size() >= max_entries) && !live.empty())
+		{
+			entry.evt = EVT_DESTROY;
+			idx = Rand() % live.size();
+			entry.rule = live[idx];
+			live[idx] = live.back();
+			live.pop_back();
+		}
+		else
+		{
+			entry.evt = EVT_NEW;
+			NewFlow(&entry.rule);
+			live.push_back(entry.rule);
+		}
+		events.push_back(entry);
+	}
+}
+
+static bool SameTuple(const nat_table_entry *a, const nat_table_entry *b)
+{
+	return (a->private_ip == b->private_ip &&
+			a->target_ip == b->target_ip &&
+			a->private_port == b->private_port &&
+			a->target_port == b->target_port &&
+			a->protocol == b->protocol);
+}
+
+/* what ChkForDup(), AddEntry(), DeleteEntry() and DelEntriesOnClntDiscon() did */
+static int LinearFind(const nat_table_entry *cache, int max_entries, const nat_table_entry *rule)
+{
+	for(int cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(SameTuple(&cache[cnt], rule))
+		{
+			return cnt;
+		}
+	}
+	return -1;
+}
+
+static int LinearReplay(nat_table_entry *cache, int max_entries,
+	const std::vector<replay_entry> &events, int num_events)
+{
+	nat_table_entry empty;
+	int cnt, idx, walked = 0;
+
+	memset(&empty, 0, sizeof(empty));
+	for(cnt = 0; cnt < num_events; cnt++)
+	{
+		const nat_table_entry *rule = &events[cnt].rule;
+
+		switch(events[cnt].evt)
+		{
+		case EVT_NEW:
+		case EVT_DUP:
+			if(LinearFind(cache, max_entries, rule) >= 0)
+			{
+				break;
+			}
+			idx = LinearFind(cache, max_entries, &empty);
+			if(idx >= 0)
+			{
+				cache[idx] = *rule;
+			}
+			break;
+		case EVT_DESTROY:
+			idx = LinearFind(cache, max_entries, rule);
+			if(idx >= 0)
+			{
+				memset(&cache[idx], 0, sizeof(cache[idx]));
+			}
+			break;
+		case EVT_CLNT_WALK:
+			for(idx = 0; idx < max_entries; idx++)
+			{
+				if(cache[idx].private_ip == rule->private_ip)
+				{
+					cache[idx].enabled = !cache[idx].enabled;
+					walked++;
+				}
+			}
+			break;
+		}
+	}
+	return walked;
+}
+
+static int IndexReplay(NatCache &nat_cache, const std::vector<replay_entry> &events,
+	int num_events)
+{
+	nat_table_entry *cache = nat_cache.GetEntries();
+	int cnt, idx, walked = 0;
+
+	for(cnt = 0; cnt < num_events; cnt++)
+	{
+		const nat_table_entry *rule = &events[cnt].rule;
+
+		switch(events[cnt].evt)
+		{
+		case EVT_NEW:
+		case EVT_DUP:
+			if(nat_cache.Find(rule) != NAT_CACHE_INVALID_IDX)
+			{
+				break;
+			}
+			nat_cache.Alloc(rule);
+			break;
+		case EVT_DESTROY:
+			idx = nat_cache.Find(rule);
+			if(idx != NAT_CACHE_INVALID_IDX)
+			{
+				nat_cache.Free(idx);
+			}
+			break;
+		case EVT_CLNT_WALK:
+			for(idx = nat_cache.FirstOfClnt(rule->private_ip); idx != NAT_CACHE_INVALID_IDX;
+				idx = nat_cache.NextOfClnt(idx))
+			{
+				cache[idx].enabled = !cache[idx].enabled;
+				walked++;
+			}
+			break;
+		}
+	}
+	return walked;
+}
+
+/* same set of connections in both, and every one of them found through the index */
+static bool CheckSame(NatCache &nat_cache, const nat_table_entry *linear, int max_entries)
+{
+	nat_table_entry *cache = nat_cache.GetEntries();
+	int cnt, idx, live = 0, clnt_live = 0;
+
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(linear[cnt].protocol == 0)
+		{
+			continue;
+		}
+		live++;
+		idx = nat_cache.Find(&linear[cnt]);
+		if(idx == NAT_CACHE_INVALID_IDX || cache[idx].enabled != linear[cnt].enabled)
+		{
+			return false;
+		}
+	}
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(cache[cnt].protocol != 0)
+		{
+			live--;
+		}
+	}
+	for(cnt = 0; cnt < NUM_CLIENTS; cnt++)
+	{
+		for(idx = nat_cache.FirstOfClnt(0xC0A82A02 + cnt); idx != NAT_CACHE_INVALID_IDX;
+			idx = nat_cache.NextOfClnt(idx))
+		{
+			clnt_live++;
+		}
+	}
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(cache[cnt].protocol != 0)
+		{
+			clnt_live--;
+		}
+	}
+	return live == 0 && clnt_live == 0;
+}
+
+static int Bench(int max_entries, int num_events)
+{
+	std::vector<nat_table_entry> initial;
+	std::vector<replay_entry> events;
+	nat_table_entry *linear;
+	NatCache nat_cache, timed_cache;
+	uint64_t start, linear_ns, index_ns;
+	int linear_events = num_events < LINEAR_EVENTS ? num_events : LINEAR_EVENTS;
+	int cnt, ret = 0;
+
+	MakeReplay(max_entries, num_events, initial, events);
+
+	linear = (nat_table_entry *)calloc(max_entries, sizeof(nat_table_entry));
+	if(linear == NULL || nat_cache.Init(max_entries) || timed_cache.Init(max_entries))
+	{
+		printf("  FAIL: unable to allocate %d entries\n", max_entries);
+		free(linear);
+		return -1;
+	}
+	for(cnt = 0; cnt < (int)initial.size(); cnt++)
+	{
+		linear[cnt] = initial[cnt];
+		nat_cache.Alloc(&initial[cnt]);
+		timed_cache.Alloc(&initial[cnt]);
+	}
+
+	start = NowNs();
+	LinearReplay(linear, max_entries, events, linear_events);
+	linear_ns = NowNs() - start;
+
+	/* both replay the same first events, then must hold the same connections */
+	IndexReplay(nat_cache, events, linear_events);
+	if(!CheckSame(nat_cache, linear, max_entries))
+	{
+		printf("  FAIL: index and flat array differ\n");
+		ret = -1;
+	}
+
+	start = NowNs();
+	IndexReplay(timed_cache, events, num_events);
+	index_ns = NowNs() - start;
+
+	printf("%6d entries  flat array %10.0f events/sec  index %10.0f events/sec\n",
+		max_entries, (double)linear_events * 1e9 / linear_ns,
+		(double)num_events * 1e9 / index_ns);
+
+	free(linear);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int num_events = argc > 1 ? atoi(argv[1]) : DEFAULT_EVENTS;
+	int ret = 0;
+
+	if(num_events <= 0)
+	{
+		printf("usage: %s [events]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%d conntrack events, 1 in %d a client walk\n", num_events, CLNT_WALK_PERIOD);
+	for(unsigned int cnt = 0; cnt < sizeof(table_sizes) / sizeof(table_sizes[0]); cnt++)
+	{
+		ret |= Bench(table_sizes[cnt], num_events);
+	}
+
+	printf("%s\n", ret ? "FAILED" : "PASSED");
+	return ret ? 1 : 0;
+}
@@ -47,8 +47,220 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 extern pthread_mutex_t mutex;
 extern pthread_cond_t  cond_var;
 
-cmd_evts *IPACM_EvtDispatcher::head = NULL;
-extern uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+cmd_evts *IPACM_EvtDispatcher::head[IPACM_EVENT_MAX];
+cmd_evts *IPACM_EvtDispatcher::tail[IPACM_EVENT_MAX];
+
+/* Event payload pool. Each size class is a run of fixed size slots in
+   one arena, so FreeEvtData() can tell a pooled payload from a malloc()ed
+   one by its address. Slot sizes are multiples of 16 to keep payloads
+   aligned. */
+#define IPACM_EVT_POOL_CLASSES 4
+
+typedef struct _evt_pool_slot
+{
+	_evt_pool_slot *next;
+} evt_pool_slot;
+
+static const uint32_t evt_pool_size[IPACM_EVT_POOL_CLASSES] = { 32, 64, 128, IPACM_EVT_POOL_MAX_SIZE };
+static const uint32_t evt_pool_count[IPACM_EVT_POOL_CLASSES] = { 1024, 256, 256, 64 };
+
+static pthread_mutex_t evt_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool evt_pool_ready = false;
+static char *evt_pool_arena = NULL;
+static char *evt_pool_end = NULL;
+static char *evt_pool_base[IPACM_EVT_POOL_CLASSES];
+static evt_pool_slot *evt_pool_free[IPACM_EVT_POOL_CLASSES];
+static ipacm_evt_pool_stats evt_pool_stats;
+
+/* called with evt_pool_mutex held */
+static void ipacm_evt_pool_init(void)
+{
+	size_t len = 0;
+	uint32_t i, j;
+	char *slot;
+
+	evt_pool_ready = true;
+
+	for(i = 0; i < IPACM_EVT_POOL_CLASSES; i++)
+	{
+		len += (size_t)evt_pool_size[i] * evt_pool_count[i];
+	}
+
+	evt_pool_arena = (char *)malloc(len);
+	if(evt_pool_arena == NULL)
+	{
+		IPACMERR("unable to allocate event pool, using malloc for event data\n");
+		return;
+	}
+	evt_pool_end = evt_pool_arena + len;
+
+	slot = evt_pool_arena;
+	for(i = 0; i < IPACM_EVT_POOL_CLASSES; i++)
+	{
+		evt_pool_base[i] = slot;
+		evt_pool_free[i] = NULL;
+		for(j = 0; j < evt_pool_count[i]; j++)
+		{
+			((evt_pool_slot *)slot)->next = evt_pool_free[i];
+			evt_pool_free[i] = (evt_pool_slot *)slot;
+			slot += evt_pool_size[i];
+		}
+	}
+	IPACMDBG_H("event pool of %zu bytes ready\n", len);
+}
+
+void* IPACM_EvtDispatcher::AllocEvtData(size_t size)
+{
+	evt_pool_slot *slot = NULL;
+	uint32_t i;
+
+	if(pthread_mutex_lock(&evt_pool_mutex) != 0)
+	{
+		IPACMERR("unable to lock the event pool mutex\n");
+		return malloc(size);
+	}
+
+	if(!evt_pool_ready)
+	{
+		ipacm_evt_pool_init();
+	}
+
+	if(evt_pool_arena != NULL)
+	{
+		for(i = 0; i < IPACM_EVT_POOL_CLASSES; i++)
+		{
+			if(size <= evt_pool_size[i])
+			{
+				slot = evt_pool_free[i];
+				if(slot != NULL)
+				{
+					evt_pool_free[i] = slot->next;
+				}
+				break;
+			}
+		}
+	}
+
+	if(slot != NULL)
+	{
+		evt_pool_stats.pooled++;
+		evt_pool_stats.in_use++;
+		if(evt_pool_stats.in_use > evt_pool_stats.max_in_use)
+		{
+			evt_pool_stats.max_in_use = evt_pool_stats.in_use;
+		}
+	}
+	else
+	{
+		evt_pool_stats.fallback++;
+	}
+
+	if(pthread_mutex_unlock(&evt_pool_mutex) != 0)
+	{
+		IPACMERR("unable to unlock the event pool mutex\n");
+	}
+
+	return (slot != NULL) ? (void *)slot : malloc(size);
+}
+
+void IPACM_EvtDispatcher::FreeEvtData(void *data)
+{
+	char *p = (char *)data;
+	int i;
+
+	if(data == NULL)
+	{
+		return;
+	}
+
+	if(pthread_mutex_lock(&evt_pool_mutex) != 0)
+	{
+		IPACMERR("unable to lock the event pool mutex, leaking %pK\n", data);
+		return;
+	}
+
+	if(evt_pool_arena == NULL || p < evt_pool_arena || p >= evt_pool_end)
+	{
+		if(pthread_mutex_unlock(&evt_pool_mutex) != 0)
+		{
+			IPACMERR("unable to unlock the event pool mutex\n");
+		}
+		free(data);
+		return;
+	}
+
+	for(i = IPACM_EVT_POOL_CLASSES - 1; i > 0; i--)
+	{
+		if(p >= evt_pool_base[i])
+		{
+			break;
+		}
+	}
+	((evt_pool_slot *)p)->next = evt_pool_free[i];
+	evt_pool_free[i] = (evt_pool_slot *)p;
+	evt_pool_stats.in_use--;
+
+	if(pthread_mutex_unlock(&evt_pool_mutex) != 0)
+	{
+		IPACMERR("unable to unlock the event pool mutex\n");
+	}
+}
+
+void IPACM_EvtDispatcher::GetPoolStats(ipacm_evt_pool_stats *out)
+{
+	if(pthread_mutex_lock(&evt_pool_mutex) != 0)
+	{
+		IPACMERR("unable to lock the event pool mutex\n");
+		memset(out, 0, sizeof(*out));
+		return;
+	}
+	memcpy(out, &evt_pool_stats, sizeof(*out));
+	if(pthread_mutex_unlock(&evt_pool_mutex) != 0)
+	{
+		IPACMERR("unable to unlock the event pool mutex\n");
+	}
+}
+
+void IPACM_EvtDispatcher::DumpStats(void)
+{
+	ipacm_evt_pool_stats pool;
+	ipacm_lane_stats lane;
+	ipacm_event_stat *stat;
+	const char *eventName;
+	int i;
+
+	for(i = 0; i < IPACM_EVENT_MAX; i++)
+	{
+		stat = &ipacm_event_stats[i];
+		if(stat->dispatched == 0)
+		{
+			continue;
+		}
+		eventName = IPACM_Iface::ipacmcfg->getEventName((ipa_cm_event_id)i);
+		IPACMDBG_H("%s: %u events %u callbacks, wait avg %llu max %u us, run avg %llu max %u us\n",
+			(eventName != NULL) ? eventName : "unknown",
+			stat->dispatched, stat->count,
+			(unsigned long long)(stat->wait_us / stat->dispatched), stat->max_wait_us,
+			(unsigned long long)(stat->run_us / stat->dispatched), stat->max_run_us);
+	}
+
+	for(i = 0; i < IPACM_EVT_LANE_MAX; i++)
+	{
+		if(MessageQueue::getLaneStats((ipacm_evt_lane)i, &lane) == IPACM_SUCCESS)
+		{
+			IPACMDBG_H("%s queue: depth %u max %u, %llu posted\n",
+				MessageQueue::getLaneName((ipacm_evt_lane)i),
+				lane.depth, lane.max_depth, (unsigned long long)lane.posted);
+		}
+	}
+
+	GetPoolStats(&pool);
+	IPACMDBG_H("event pool: %u in use max %u, %llu pooled %llu malloc\n",
+		pool.in_use, pool.max_in_use,
+		(unsigned long long)pool.pooled, (unsigned long long)pool.fallback);
+
+	IPACM_Iface::m_filtering.DumpStats();
+}
 
 int IPACM_EvtDispatcher::PostEvt
 (
@@ -57,38 +269,46 @@ int IPACM_EvtDispatcher::PostEvt
 {
 	Message *item = NULL;
 	MessageQueue *MsgQueue = NULL;
+	ipacm_evt_lane lane;
+	struct timespec now;
 
-	if(data->event < IPA_EXTERNAL_EVENT_MAX)
+	if(data->event >= IPACM_EVENT_MAX)
 	{
-		IPACMDBG("Insert event into external queue.\n");
-		MsgQueue = MessageQueue::getInstanceExternal();
-	}
-	else
-	{
-		IPACMDBG("Insert event into internal queue.\n");
-		MsgQueue = MessageQueue::getInstanceInternal();
+		IPACMERR("invalid event %d\n", data->event);
+		return IPACM_FAILURE;
 	}
+
+	lane = MessageQueue::getLane(data->event);
+	IPACMDBG("Insert event into %s queue.\n", MessageQueue::getLaneName(lane));
+	MsgQueue = MessageQueue::getInstance(lane);
 	if(MsgQueue == NULL)
 	{
 		IPACMERR("unable to retrieve MsgQueue instance\n");
 		return IPACM_FAILURE;
 	}
 
-	item = new Message();
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	if(pthread_mutex_lock(&mutex) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return IPACM_FAILURE;
+	}
+
+	item = MessageQueue::getItem();
 	if(item == NULL)
 	{
 		IPACMERR("unable to create new message item\n");
+		if(pthread_mutex_unlock(&mutex) != 0)
+		{
+			IPACMERR("unable to unlock the mutex\n");
+		}
 		return IPACM_FAILURE;
 	}
 
 	item->evt.callback_ptr = IPACM_EvtDispatcher::ProcessEvt;
 	memcpy(&item->evt.data, data, sizeof(ipacm_cmd_q_data));
-
-	if(pthread_mutex_lock(&mutex) != 0)
-	{
-		IPACMERR("unable to lock the mutex\n");
-		return IPACM_FAILURE;
-	}
+	item->post_time = now;
 
 	IPACMDBG("Enqueing item\n");
 	MsgQueue->enqueue(item);
@@ -118,38 +338,48 @@ int IPACM_EvtDispatcher::PostEvt
 void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 {
 
-	cmd_evts *tmp = head, tmp1;
+	cmd_evts *tmp, tmp1;
 
-	if(head == NULL)
+	if(data->event >= IPACM_EVENT_MAX)
 	{
-		IPACMDBG("Queue is empty\n");
+		IPACMERR("invalid event %d\n", data->event);
+		return;
+	}
+
+	tmp = head[data->event];
+	if(tmp == NULL)
+	{
+		IPACMDBG("No listener for event %d\n", data->event);
 	}
 
 	while(tmp != NULL)
 	{
-	        memcpy(&tmp1, tmp, sizeof(tmp1));
-		if(data->event == tmp1.event)
-		{
-			ipacm_event_stats[data->event]++;
-			tmp1.obj->event_callback(data->event, data->evt_data);
-			IPACMDBG(" Find matched registered events\n");
-		}
-	        tmp = tmp1.next;
+		/* the callback may deregister its listener and free the node */
+		memcpy(&tmp1, tmp, sizeof(tmp1));
+		ipacm_event_stats[data->event].count++;
+		tmp1.obj->event_callback(data->event, data->evt_data);
+		tmp = tmp1.next;
 	}
 
 	IPACMDBG(" Finished process events\n");
-			
+
 	if(data->evt_data != NULL)
 	{
 		IPACMDBG("free the event:%d data: %pK\n", data->event, data->evt_data);
-		free(data->evt_data);
+		FreeEvtData(data->evt_data);
 	}
 	return;
 }
 
 int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
 {
-	cmd_evts *tmp = head,*nw;
+	cmd_evts *nw;
+
+	if(event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("invalid event %d\n", event);
+		return IPACM_FAILURE;
+	}
 
 	nw = (cmd_evts *)malloc(sizeof(cmd_evts));
 	if(nw != NULL)
@@ -163,51 +393,55 @@ int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
 		return IPACM_FAILURE;
 	}
 
-	if(head == NULL)
+	if(head[event] == NULL)
 	{
-		head = nw;
+		head[event] = nw;
 	}
 	else
 	{
-		while(tmp->next)
-		{
-			tmp = tmp->next;
-		}
-		tmp->next = nw;
+		tail[event]->next = nw;
 	}
+	tail[event] = nw;
 	return IPACM_SUCCESS;
 }
 
 
 int IPACM_EvtDispatcher::deregistr(IPACM_Listener *param)
 {
-	cmd_evts *tmp = head,*tmp1,*prev = head;
+	cmd_evts *tmp, *tmp1, *prev;
+	int event;
 
-	while(tmp != NULL)
+	for(event = 0; event < IPACM_EVENT_MAX; event++)
 	{
-		if(tmp->obj == param)
+		tmp = head[event];
+		prev = NULL;
+
+		while(tmp != NULL)
 		{
-			tmp1 = tmp;
-			if(tmp == head)
-			{
-				head = head->next;
-			}
-			else if(tmp->next == NULL)
+			if(tmp->obj == param)
 			{
-				prev->next = NULL;
+				tmp1 = tmp;
+				if(prev == NULL)
+				{
+					head[event] = tmp->next;
+				}
+				else
+				{
+					prev->next = tmp->next;
+				}
+				if(tail[event] == tmp)
+				{
+					tail[event] = prev;
+				}
+
+				tmp = tmp->next;
+				free(tmp1);
 			}
 			else
 			{
-				prev->next = tmp->next;
+				prev = tmp;
+				tmp = tmp->next;
 			}
-
-			tmp = tmp->next;
-			free(tmp1);
-		}
-		else
-		{
-			prev = tmp;
-			tmp = tmp->next;
 		}
 	}
 	return IPACM_SUCCESS;
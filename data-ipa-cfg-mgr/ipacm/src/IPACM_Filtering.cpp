@@ -76,6 +76,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "IPACM_Filtering.h"
 #include <IPACM_Log.h>
@@ -95,6 +96,7 @@ IPACM_Filtering::IPACM_Filtering()
 	total_num_offload_rules = 0;
 	pcie_modem_rule_id = 0;
 	memset(pcie_modem_rule_id_in_use, 0, sizeof(pcie_modem_rule_id_in_use));
+	memset(stats, 0, sizeof(stats));
 }
 
 IPACM_Filtering::~IPACM_Filtering()
@@ -107,6 +109,55 @@ bool IPACM_Filtering::DeviceNodeIsOpened()
 	return fd;
 }
 
+/* Issue a filter table ioctl and account for it */
+int IPACM_Filtering::FltIoctl(enum ipacm_flt_op op, unsigned long req, void *arg, int num_rules, bool commit)
+{
+	struct timespec start, end;
+	uint32_t elapsed_us;
+	int retval;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	retval = ioctl(fd, req, arg);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	elapsed_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	stats[op].ioctls++;
+	stats[op].rules += num_rules;
+	if (commit)
+	{
+		stats[op].commits++;
+	}
+	stats[op].total_us += elapsed_us;
+	if (elapsed_us > stats[op].max_us)
+	{
+		stats[op].max_us = elapsed_us;
+	}
+	return retval;
+}
+
+void IPACM_Filtering::GetStats(enum ipacm_flt_op op, struct ipacm_flt_op_stats *out)
+{
+	memcpy(out, &stats[op], sizeof(*out));
+}
+
+void IPACM_Filtering::DumpStats()
+{
+	static const char *op_name[IPACM_FLT_OP_MAX] = { "add", "del", "modify", "commit" };
+	int op;
+
+	for (op = 0; op < IPACM_FLT_OP_MAX; op++)
+	{
+		if (stats[op].ioctls == 0)
+		{
+			continue;
+		}
+		IPACMDBG_H("filter %s: %llu ioctls %llu rules %llu commits, avg %llu max %u us\n",
+			op_name[op], (unsigned long long)stats[op].ioctls,
+			(unsigned long long)stats[op].rules, (unsigned long long)stats[op].commits,
+			(unsigned long long)(stats[op].total_us / stats[op].ioctls), stats[op].max_us);
+	}
+}
+
 bool IPACM_Filtering::AddFilteringRule(struct ipa_ioc_add_flt_rule const *ruleTable)
 {
 	int retval = 0;
@@ -122,7 +173,8 @@ bool IPACM_Filtering::AddFilteringRule(struct ipa_ioc_add_flt_rule const *ruleTa
 				ruleTable->rules[cnt].rule.attrib.attrib_mask);
 	}
 
-	retval = ioctl(fd, IPA_IOC_ADD_FLT_RULE, ruleTable);
+	retval = FltIoctl(IPACM_FLT_OP_ADD, IPA_IOC_ADD_FLT_RULE, (void *)ruleTable,
+		ruleTable->num_rules, ruleTable->commit);
 	if (retval != 0)
 	{
 		IPACMERR("Failed adding Filtering rule %pK\n", ruleTable);
@@ -170,7 +222,8 @@ bool IPACM_Filtering::AddFilteringRule_v2(struct ipa_ioc_add_flt_rule_v2 const *
 				((struct ipa_flt_rule_add_v2  *)ruleTable->rules)[cnt].rule.attrib.attrib_mask);
 	}
 
-	retval = ioctl(fd, IPA_IOC_ADD_FLT_RULE_V2, ruleTable);
+	retval = FltIoctl(IPACM_FLT_OP_ADD, IPA_IOC_ADD_FLT_RULE_V2, (void *)ruleTable,
+		ruleTable->num_rules, ruleTable->commit);
 	if (retval != 0)
 	{
 		for (cnt = 0; cnt < ruleTable->num_rules; cnt++)
@@ -268,7 +321,8 @@ bool IPACM_Filtering::AddFilteringRule_hw_index(struct ipa_ioc_add_flt_rule *rul
 			&flt_rule_entry, sizeof(flt_rule_entry));
 	}
 
-	retval = ioctl(fd, IPA_IOC_ADD_FLT_RULE_V2, ruleTable_v2);
+	retval = FltIoctl(IPACM_FLT_OP_ADD, IPA_IOC_ADD_FLT_RULE_V2, ruleTable_v2,
+		ruleTable_v2->num_rules, ruleTable_v2->commit);
 	if (retval != 0)
 	{
 		IPACMERR("Failed adding Filtering rule %pK\n", ruleTable_v2);
@@ -385,7 +439,8 @@ bool IPACM_Filtering::AddFilteringRuleAfter_hw_index(struct ipa_ioc_add_flt_rule
 				&flt_rule_entry, sizeof(flt_rule_entry));
 		}
 
-		retval = ioctl(fd, IPA_IOC_ADD_FLT_RULE_AFTER_V2, ruleTable_v2);
+		retval = FltIoctl(IPACM_FLT_OP_ADD, IPA_IOC_ADD_FLT_RULE_AFTER_V2, ruleTable_v2,
+			ruleTable_v2->num_rules, ruleTable_v2->commit);
 		if (retval != 0)
 		{
 			IPACMERR("Failed adding Filtering rule %pK\n", ruleTable_v2);
@@ -447,7 +502,8 @@ bool IPACM_Filtering::AddFilteringRuleAfter(struct ipa_ioc_add_flt_rule_after co
 		IPACMDBG("End point: %d\n", ruleTable->ep);
 		IPACMDBG("commit value: %d\n", ruleTable->commit);
 
-		retval = ioctl(fd, IPA_IOC_ADD_FLT_RULE_AFTER, ruleTable);
+		retval = FltIoctl(IPACM_FLT_OP_ADD, IPA_IOC_ADD_FLT_RULE_AFTER, (void *)ruleTable,
+			ruleTable->num_rules, ruleTable->commit);
 
 		for (int cnt = 0; cnt<ruleTable->num_rules; cnt++)
 		{
@@ -477,7 +533,8 @@ bool IPACM_Filtering::DeleteFilteringRule(struct ipa_ioc_del_flt_rule *ruleTable
 {
 	int retval = 0;
 
-	retval = ioctl(fd, IPA_IOC_DEL_FLT_RULE, ruleTable);
+	retval = FltIoctl(IPACM_FLT_OP_DEL, IPA_IOC_DEL_FLT_RULE, ruleTable,
+		ruleTable->num_hdls, ruleTable->commit);
 	if (retval != 0)
 	{
 		IPACMERR("Failed deleting Filtering rule %pK\n", ruleTable);
@@ -492,7 +549,7 @@ bool IPACM_Filtering::Commit(enum ipa_ip_type ip)
 {
 	int retval = 0;
 
-	retval = ioctl(fd, IPA_IOC_COMMIT_FLT, ip);
+	retval = FltIoctl(IPACM_FLT_OP_COMMIT, IPA_IOC_COMMIT_FLT, (void *)(uintptr_t)ip, 0, true);
 	if (retval != 0)
 	{
 		IPACMERR("failed committing Filtering rules.\n");
@@ -528,53 +585,56 @@ bool IPACM_Filtering::DeleteFilteringHdls
 {
 	struct ipa_ioc_del_flt_rule *flt_rule;
 	bool res = true;
-	int len = 0, cnt = 0;
-        const uint8_t UNIT_RULES = 1;
+	int len = 0, cnt = 0, num_hdls = 0;
 
-	len = (sizeof(struct ipa_ioc_del_flt_rule)) + (UNIT_RULES * sizeof(struct ipa_flt_rule_del));
+	/* all handles go in one ioctl, so the table is committed to HW once;
+	   the driver deletes each handle it can and reports the others in status */
+	len = (sizeof(struct ipa_ioc_del_flt_rule)) + (num_rules * sizeof(struct ipa_flt_rule_del));
 	flt_rule = (struct ipa_ioc_del_flt_rule *)malloc(len);
 	if (flt_rule == NULL)
 	{
 		IPACMERR("unable to allocate memory for del filter rule\n");
 		return false;
 	}
+	memset(flt_rule, 0, len);
+	flt_rule->commit = 1;
+	flt_rule->ip = ip;
 
 	for (cnt = 0; cnt < num_rules; cnt++)
 	{
-	    memset(flt_rule, 0, len);
-	    flt_rule->commit = 1;
-	    flt_rule->num_hdls = UNIT_RULES;
-	    flt_rule->ip = ip;
-
-	    if (flt_rule_hdls[cnt] == 0)
-	    {
-		   IPACMERR("invalid filter handle passed, ignoring it: %d\n", cnt)
-	    }
-            else
-	    {
-
-		   flt_rule->hdl[0].status = -1;
-		   flt_rule->hdl[0].hdl = flt_rule_hdls[cnt];
-		   IPACMDBG("Deleting filter hdl:(0x%x) with ip type: %d\n", flt_rule_hdls[cnt], ip);
-
-	           if (DeleteFilteringRule(flt_rule) == false)
-	           {
-		        PERROR("Filter rule deletion failed!\n");
-		        res = false;
-		        goto fail;
-	           }
-		   else
-	           {
-
-		        if (flt_rule->hdl[0].status != 0)
-		        {
-			     IPACMERR("Filter rule hdl 0x%x deletion failed with error:%d\n",
-		        					 flt_rule->hdl[0].hdl, flt_rule->hdl[0].status);
-			     res = false;
-			     goto fail;
-		        }
-		   }
-	    }
+		if (flt_rule_hdls[cnt] == 0)
+		{
+			IPACMERR("invalid filter handle passed, ignoring it: %d\n", cnt);
+			continue;
+		}
+
+		flt_rule->hdl[num_hdls].status = -1;
+		flt_rule->hdl[num_hdls].hdl = flt_rule_hdls[cnt];
+		IPACMDBG("Deleting filter hdl:(0x%x) with ip type: %d\n", flt_rule_hdls[cnt], ip);
+		num_hdls++;
+	}
+
+	if (num_hdls == 0)
+	{
+		goto fail;
+	}
+	flt_rule->num_hdls = num_hdls;
+
+	if (DeleteFilteringRule(flt_rule) == false)
+	{
+		PERROR("Filter rule deletion failed!\n");
+		res = false;
+		goto fail;
+	}
+
+	for (cnt = 0; cnt < num_hdls; cnt++)
+	{
+		if (flt_rule->hdl[cnt].status != 0)
+		{
+			IPACMERR("Filter rule hdl 0x%x deletion failed with error:%d\n",
+				flt_rule->hdl[cnt].hdl, flt_rule->hdl[cnt].status);
+			res = false;
+		}
 	}
 
 fail:
@@ -1092,7 +1152,8 @@ bool IPACM_Filtering::ModifyFilteringRule(struct ipa_ioc_mdfy_flt_rule* ruleTabl
 		IPACMDBG("Filter rule:%d attrib mask: 0x%x\n", i, ruleTable->rules[i].rule.attrib.attrib_mask);
 	}
 
-	ret = ioctl(fd, IPA_IOC_MDFY_FLT_RULE, ruleTable);
+	ret = FltIoctl(IPACM_FLT_OP_MDFY, IPA_IOC_MDFY_FLT_RULE, ruleTable,
+		ruleTable->num_rules, ruleTable->commit);
 
 	for (i = 0; i < ruleTable->num_rules; i++)
 	{
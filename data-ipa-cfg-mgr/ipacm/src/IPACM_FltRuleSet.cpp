@@ -0,0 +1,244 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_FltRuleSet.cpp
+
+	@brief
+	This file implements the desired-state model for filter rule slots
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "IPACM_FltRuleSet.h"
+#include "IPACM_Log.h"
+#include "IPACM_Defs.h"
+
+IPACM_FltRuleSet::IPACM_FltRuleSet()
+{
+	name[0] = '\0';
+	ip = IPA_IP_v4;
+	num_slots = 0;
+	want = NULL;
+	have = NULL;
+	have_valid = NULL;
+	table = NULL;
+	memset(&stats, 0, sizeof(stats));
+}
+
+IPACM_FltRuleSet::~IPACM_FltRuleSet()
+{
+	free(want);
+	free(have);
+	free(have_valid);
+	free(table);
+}
+
+int IPACM_FltRuleSet::Init(const char *iface, const char *what, ipa_ip_type ip_type, int slots)
+{
+	snprintf(name, sizeof(name), "%s %s", iface, what);
+
+	if (slots <= 0 || slots > UINT8_MAX)
+	{
+		IPACMERR("invalid number of slots %d for %s\n", slots, name);
+		return IPACM_FAILURE;
+	}
+
+	want = (struct ipa_flt_rule_mdfy *)calloc(slots, sizeof(struct ipa_flt_rule_mdfy));
+	have = (struct ipa_flt_rule_mdfy *)calloc(slots, sizeof(struct ipa_flt_rule_mdfy));
+	have_valid = (bool *)calloc(slots, sizeof(bool));
+	table = (struct ipa_ioc_mdfy_flt_rule *)calloc(1, sizeof(struct ipa_ioc_mdfy_flt_rule) +
+		slots * sizeof(struct ipa_flt_rule_mdfy));
+	if (want == NULL || have == NULL || have_valid == NULL || table == NULL)
+	{
+		IPACMERR("unable to allocate %d filter rule slots for %s\n", slots, name);
+		free(want);
+		free(have);
+		free(have_valid);
+		free(table);
+		want = NULL;
+		have = NULL;
+		have_valid = NULL;
+		table = NULL;
+		return IPACM_FAILURE;
+	}
+
+	ip = ip_type;
+	num_slots = slots;
+	return IPACM_SUCCESS;
+}
+
+void IPACM_FltRuleSet::Invalidate()
+{
+	if (have_valid != NULL)
+	{
+		memset(have_valid, 0, num_slots * sizeof(bool));
+	}
+}
+
+void IPACM_FltRuleSet::SetRule(int slot, const struct ipa_flt_rule_mdfy *rule)
+{
+	if (slot < 0 || slot >= num_slots)
+	{
+		IPACMERR("%s has no slot %d\n", name, slot);
+		return;
+	}
+	memcpy(&want[slot], rule, sizeof(want[slot]));
+	want[slot].status = -1;
+}
+
+/* the rule a slot holds while unused: matches no packet */
+void IPACM_FltRuleSet::SetDummy(int slot, uint32_t rule_hdl)
+{
+	struct ipa_flt_rule_mdfy flt_rule;
+
+	memset(&flt_rule, 0, sizeof(flt_rule));
+	flt_rule.rule_hdl = rule_hdl;
+	flt_rule.rule.retain_hdr = 0;
+	flt_rule.rule.action = IPA_PASS_TO_EXCEPTION;
+	flt_rule.rule.attrib.attrib_mask = IPA_FLT_SRC_ADDR | IPA_FLT_DST_ADDR;
+
+	if (ip == IPA_IP_v4)
+	{
+		flt_rule.rule.attrib.u.v4.dst_addr = ~0;
+		flt_rule.rule.attrib.u.v4.dst_addr_mask = ~0;
+		flt_rule.rule.attrib.u.v4.src_addr = ~0;
+		flt_rule.rule.attrib.u.v4.src_addr_mask = ~0;
+	}
+	else
+	{
+		memset(flt_rule.rule.attrib.u.v6.src_addr, 0xff, sizeof(flt_rule.rule.attrib.u.v6.src_addr));
+		memset(flt_rule.rule.attrib.u.v6.src_addr_mask, 0xff, sizeof(flt_rule.rule.attrib.u.v6.src_addr_mask));
+		memset(flt_rule.rule.attrib.u.v6.dst_addr, 0xff, sizeof(flt_rule.rule.attrib.u.v6.dst_addr));
+		memset(flt_rule.rule.attrib.u.v6.dst_addr_mask, 0xff, sizeof(flt_rule.rule.attrib.u.v6.dst_addr_mask));
+	}
+
+	SetRule(slot, &flt_rule);
+}
+
+bool IPACM_FltRuleSet::SlotChanged(int slot)
+{
+	return (have_valid[slot] == false ||
+		have[slot].rule_hdl != want[slot].rule_hdl ||
+		memcmp(&have[slot].rule, &want[slot].rule, sizeof(want[slot].rule)) != 0);
+}
+
+/*
+ * Send the slots whose desired rule differs from the installed one,
+ * all in one ioctl so the table is committed to HW once. Nothing is
+ * sent when every slot is up to date.
+ */
+int IPACM_FltRuleSet::Commit(IPACM_Filtering *filtering)
+{
+	struct timespec start, end;
+	uint32_t elapsed_us;
+	int slot, cnt, num = 0, installed = 0;
+	int slot_of[UINT8_MAX];
+
+	if (table == NULL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	for (slot = 0; slot < num_slots; slot++)
+	{
+		if (want[slot].rule_hdl == 0)
+		{
+			/* slot not installed */
+			continue;
+		}
+		installed++;
+		if (SlotChanged(slot))
+		{
+			memcpy(&table->rules[num], &want[slot], sizeof(want[slot]));
+			slot_of[num] = slot;
+			num++;
+		}
+	}
+
+	stats.rules_unchanged += installed - num;
+	if (num == 0)
+	{
+		stats.skipped++;
+		IPACMDBG_H("%s: all %d filter rules up to date\n", name, installed);
+		return IPACM_SUCCESS;
+	}
+
+	table->commit = 1;
+	table->ip = ip;
+	table->num_rules = (uint8_t)num;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (filtering->ModifyFilteringRule(table) == false)
+	{
+		IPACMERR("%s: failed to modify %d filter rules\n", name, num);
+		Invalidate();
+		return IPACM_FAILURE;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (cnt = 0; cnt < num; cnt++)
+	{
+		slot = slot_of[cnt];
+		if (table->rules[cnt].status == 0)
+		{
+			memcpy(&have[slot], &want[slot], sizeof(want[slot]));
+			have_valid[slot] = true;
+		}
+		else
+		{
+			have_valid[slot] = false;
+		}
+	}
+
+	elapsed_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	stats.commits++;
+	stats.rules_sent += num;
+	stats.total_us += elapsed_us;
+	if (elapsed_us > stats.max_us)
+	{
+		stats.max_us = elapsed_us;
+	}
+
+	IPACMDBG_H("%s: %d of %d filter rules changed, committed in %u us (%llu commits, %llu skipped, avg %llu us)\n",
+		name, num, installed, elapsed_us, (unsigned long long)stats.commits,
+		(unsigned long long)stats.skipped, (unsigned long long)(stats.total_us / stats.commits));
+	return IPACM_SUCCESS;
+}
+
+void IPACM_FltRuleSet::GetStats(struct ipacm_flt_rule_set_stats *out)
+{
+	memcpy(out, &stats, sizeof(*out));
+}
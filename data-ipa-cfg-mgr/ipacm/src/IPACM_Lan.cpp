@@ -170,6 +170,9 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 	memset(ipv6_icmp_flt_rule_hdl, 0, NUM_IPV6_ICMP_FLT_RULE * sizeof(uint32_t));
 	memset(ipv6_prefix, 0, sizeof(ipv6_prefix));
 	memset(filter_cfg_rule_hdl, 0, sizeof(filter_cfg_rule_hdl));
+	private_flt_set.Init(dev_name, "private subnet", IPA_IP_v4,
+		IPA_MAX_PRIVATE_SUBNET_ENTRIES + IPA_MAX_MTU_ENTRIES);
+	filter_cfg_flt_set.Init(dev_name, "filter cfg", IPA_IP_v4, IPA_MAX_FILTER_CFG_ENTRIES);
 
 	/* ODU routing table initilization */
 	if(ipa_if_cate == ODU_IF)
@@ -4013,105 +4016,6 @@ int IPACM_Lan::handle_wan_down_v6(ipacm_wan_iface_type backhaul_mode)
 	return IPACM_SUCCESS;
 }
 
-int IPACM_Lan::reset_to_dummy_flt_rule(ipa_ip_type iptype, uint32_t rule_hdl)
-{
-	int len, res = IPACM_SUCCESS;
-	struct ipa_flt_rule_mdfy flt_rule;
-	struct ipa_ioc_mdfy_flt_rule* pFilteringTable;
-
-	IPACMDBG_H("Reset flt rule to dummy, IP type: %d, hdl: %d\n", iptype, rule_hdl);
-	len = sizeof(struct ipa_ioc_mdfy_flt_rule) + sizeof(struct ipa_flt_rule_mdfy);
-	pFilteringTable = (struct ipa_ioc_mdfy_flt_rule*)malloc(len);
-
-	if (pFilteringTable == NULL)
-	{
-		IPACMERR("Error allocate flt rule memory...\n");
-		return IPACM_FAILURE;
-	}
-	memset(pFilteringTable, 0, len);
-
-	pFilteringTable->commit = 1;
-	pFilteringTable->ip = iptype;
-	pFilteringTable->num_rules = 1;
-
-	memset(&flt_rule, 0, sizeof(struct ipa_flt_rule_mdfy));
-	flt_rule.status = -1;
-	flt_rule.rule_hdl = rule_hdl;
-
-	flt_rule.rule.retain_hdr = 0;
-	flt_rule.rule.action = IPA_PASS_TO_EXCEPTION;
-
-	if(iptype == IPA_IP_v4)
-	{
-		IPACMDBG_H("Reset IPv4 flt rule to dummy\n");
-
-		flt_rule.rule.attrib.attrib_mask = IPA_FLT_SRC_ADDR | IPA_FLT_DST_ADDR;
-		flt_rule.rule.attrib.u.v4.dst_addr = ~0;
-		flt_rule.rule.attrib.u.v4.dst_addr_mask = ~0;
-		flt_rule.rule.attrib.u.v4.src_addr = ~0;
-		flt_rule.rule.attrib.u.v4.src_addr_mask = ~0;
-
-		memcpy(&(pFilteringTable->rules[0]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
-		if (false == m_filtering.ModifyFilteringRule(pFilteringTable))
-		{
-			IPACMERR("Error modifying filtering rule.\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
-		else
-		{
-			IPACMDBG_H("Flt rule reset to dummy, hdl: 0x%x, status: %d\n", pFilteringTable->rules[0].rule_hdl,
-						pFilteringTable->rules[0].status);
-		}
-	}
-	else if(iptype == IPA_IP_v6)
-	{
-		IPACMDBG_H("Reset IPv6 flt rule to dummy\n");
-
-		flt_rule.rule.attrib.attrib_mask = IPA_FLT_SRC_ADDR | IPA_FLT_DST_ADDR;
-		flt_rule.rule.attrib.u.v6.src_addr[0] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr[1] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr[2] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr[3] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr_mask[0] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr_mask[1] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr_mask[2] = ~0;
-		flt_rule.rule.attrib.u.v6.src_addr_mask[3] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr[0] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr[1] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr[2] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr[3] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr_mask[0] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr_mask[1] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr_mask[2] = ~0;
-		flt_rule.rule.attrib.u.v6.dst_addr_mask[3] = ~0;
-
-
-		memcpy(&(pFilteringTable->rules[0]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
-		if (false == m_filtering.ModifyFilteringRule(pFilteringTable))
-		{
-			IPACMERR("Error modifying filtering rule.\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
-		else
-		{
-			IPACMDBG_H("Flt rule reset to dummy, hdl: 0x%x, status: %d\n", pFilteringTable->rules[0].rule_hdl,
-						pFilteringTable->rules[0].status);
-		}
-	}
-	else
-	{
-		IPACMERR("IP type is not expected.\n");
-		res = IPACM_FAILURE;
-		goto fail;
-	}
-
-fail:
-	free(pFilteringTable);
-	return res;
-}
-
 void IPACM_Lan::post_del_self_evt()
 {
 	ipacm_cmd_q_data evt;
@@ -4415,6 +4319,8 @@ int IPACM_Lan::add_dummy_private_subnet_flt_rule(ipa_ip_type iptype)
 					goto fail;
 				}
 			}
+			/* fresh slots, nothing IPA holds matches the cached state */
+			private_flt_set.Invalidate();
 		}
 	}
 fail:
@@ -4519,6 +4425,7 @@ int IPACM_Lan::add_dummy_filter_cfg_rules(ipa_ip_type iptype)
 					goto fail;
 				}
 			}
+			filter_cfg_flt_set.Invalidate();
 		}
 	}
 fail:
@@ -4529,9 +4436,8 @@ fail:
 
 int IPACM_Lan::handle_filter_cfg_update(ipa_ip_type iptype)
 {
-	int i, len, res = IPACM_SUCCESS;
+	int i, res = IPACM_SUCCESS;
 	struct ipa_flt_rule_mdfy flt_rule;
-	struct ipa_ioc_mdfy_flt_rule* pFilteringTable = NULL;
 
 	if (rx_prop == NULL)
 	{
@@ -4547,7 +4453,7 @@ int IPACM_Lan::handle_filter_cfg_update(ipa_ip_type iptype)
 
 	for(i=0; i<IPA_MAX_FILTER_CFG_ENTRIES; i++)
 	{
-		reset_to_dummy_flt_rule(IPA_IP_v4, filter_cfg_rule_hdl[i]);
+		filter_cfg_flt_set.SetDummy(i, filter_cfg_rule_hdl[i]);
 	}
 
 	if(IPACM_Iface::ipacmcfg->filter_config.filter_enable == true)
@@ -4557,24 +4463,12 @@ int IPACM_Lan::handle_filter_cfg_update(ipa_ip_type iptype)
 		{
 			IPACMERR("Invalid filter Config num rules %d\n",
 				IPACM_Iface::ipacmcfg->filter_config.num_filter_cfg_entries);
+			filter_cfg_flt_set.Commit(&m_filtering);
 			return IPACM_FAILURE;
 		}
 
 		IPACMDBG_H("total %d filter cfg rules are needed\n", IPACM_Iface::ipacmcfg->filter_config.num_filter_cfg_entries);
 
-		len = sizeof(struct ipa_ioc_mdfy_flt_rule) + IPACM_Iface::ipacmcfg->filter_config.num_filter_cfg_entries * sizeof(struct ipa_flt_rule_mdfy);
-		pFilteringTable = (struct ipa_ioc_mdfy_flt_rule*)malloc(len);
-		if (!pFilteringTable)
-		{
-			IPACMERR("Failed to allocate ipa_ioc_mdfy_flt_rule memory...\n");
-			return IPACM_FAILURE;
-		}
-		memset(pFilteringTable, 0, len);
-
-		pFilteringTable->commit = 1;
-		pFilteringTable->ip = iptype;
-		pFilteringTable->num_rules = (uint8_t)IPACM_Iface::ipacmcfg->filter_config.num_filter_cfg_entries;
-
 		for (i = 0; i < IPACM_Iface::ipacmcfg->filter_config.num_filter_cfg_entries; i++)
 		{
 			/* add filter cfg for ipv4 */
@@ -4591,20 +4485,15 @@ int IPACM_Lan::handle_filter_cfg_update(ipa_ip_type iptype)
 				&IPACM_Iface::ipacmcfg->filter_config.filter_cfg_entries[i].attrib,
 				sizeof(struct ipa_rule_attrib));
 			flt_rule.rule.attrib.attrib_mask |= rx_prop->rx[0].attrib.attrib_mask;
-			memcpy(&(pFilteringTable->rules[i]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
-		}
-
-		if (false == m_filtering.ModifyFilteringRule(pFilteringTable))
-		{
-			IPACMERR("Failed to modify filter config rules.\n");
-			res = IPACM_FAILURE;
-			goto fail;
+			filter_cfg_flt_set.SetRule(i, &flt_rule);
 		}
 	}
-fail:
-	if(pFilteringTable != NULL)
+
+	/* only the slots that changed since the last update reach IPA */
+	if (filter_cfg_flt_set.Commit(&m_filtering) != IPACM_SUCCESS)
 	{
-		free(pFilteringTable);
+		IPACMERR("Failed to modify filter config rules.\n");
+		res = IPACM_FAILURE;
 	}
 	return res;
 }
@@ -4612,9 +4501,8 @@ fail:
 
 int IPACM_Lan::handle_private_subnet_android(ipa_ip_type iptype)
 {
-	int i, len, res = IPACM_SUCCESS;
+	int i, res = IPACM_SUCCESS;
 	struct ipa_flt_rule_mdfy flt_rule;
-	struct ipa_ioc_mdfy_flt_rule* pFilteringTable;
 	int mtu_rule_cnt = 0;
 	uint16_t mtu[IPA_MAX_PRIVATE_SUBNET_ENTRIES + IPA_MAX_MTU_ENTRIES] = { };
 	int mtu_rule_idx = IPACM_Iface::ipacmcfg->ipa_num_private_subnet;
@@ -4634,7 +4522,7 @@ int IPACM_Lan::handle_private_subnet_android(ipa_ip_type iptype)
 	{
 		for(i=0; i<IPA_MAX_PRIVATE_SUBNET_ENTRIES + IPA_MAX_MTU_ENTRIES; i++)
 		{
-			reset_to_dummy_flt_rule(IPA_IP_v4, private_fl_rule_hdl[i]);
+			private_flt_set.SetDummy(i, private_fl_rule_hdl[i]);
 		}
 
 		/* check how many MTU rules we need to add */
@@ -4654,25 +4542,16 @@ int IPACM_Lan::handle_private_subnet_android(ipa_ip_type iptype)
 		}
 		IPACMDBG_H("total %d MTU rules are needed\n", mtu_rule_cnt);
 
-		len = sizeof(struct ipa_ioc_mdfy_flt_rule) + (IPACM_Iface::ipacmcfg->ipa_num_private_subnet + mtu_rule_cnt) * sizeof(struct ipa_flt_rule_mdfy);
-		pFilteringTable = (struct ipa_ioc_mdfy_flt_rule*)malloc(len);
-		if (!pFilteringTable)
-		{
-			IPACMERR("Failed to allocate ipa_ioc_mdfy_flt_rule memory...\n");
-			return IPACM_FAILURE;
-		}
-		memset(pFilteringTable, 0, len);
-
-		pFilteringTable->commit = 1;
-		pFilteringTable->ip = iptype;
-		pFilteringTable->num_rules = (uint8_t)IPACM_Iface::ipacmcfg->ipa_num_private_subnet + mtu_rule_cnt;
-
 		/* Make LAN-traffic always go A5, use default IPA-RT table */
 		if (false == m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_default_v4))
 		{
 			IPACMERR("Failed to get routing table handle.\n");
-			res = IPACM_FAILURE;
-			goto fail;
+			/* still take the old private subnet rules out of IPA */
+			if (private_flt_set.Commit(&m_filtering) != IPACM_SUCCESS)
+			{
+				IPACMERR("Failed to clear private subnet filtering rules.\n");
+			}
+			return IPACM_FAILURE;
 		}
 
 		memset(&flt_rule, 0, sizeof(struct ipa_flt_rule_mdfy));
@@ -4695,7 +4574,7 @@ int IPACM_Lan::handle_private_subnet_android(ipa_ip_type iptype)
 			flt_rule.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
 			flt_rule.rule.attrib.u.v4.dst_addr_mask = IPACM_Iface::ipacmcfg->private_subnet_table[i].subnet_mask;
 			flt_rule.rule.attrib.u.v4.dst_addr = IPACM_Iface::ipacmcfg->private_subnet_table[i].subnet_addr;
-			memcpy(&(pFilteringTable->rules[i]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
+			private_flt_set.SetRule(i, &flt_rule);
 			IPACMDBG_H(" IPACM private subnet_addr as: 0x%x entry(%d)\n", flt_rule.rule.attrib.u.v4.dst_addr, i);
 
 			/* add corresponding MTU rule for ipv4 */
@@ -4710,23 +4589,18 @@ int IPACM_Lan::handle_private_subnet_android(ipa_ip_type iptype)
 				{
 					IPACMERR("Failed to modify MTU filtering rule.\n");
 				}
-				memcpy(&(pFilteringTable->rules[mtu_rule_idx + i]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
+				private_flt_set.SetRule(mtu_rule_idx + i, &flt_rule);
 				IPACMDBG_H("Adding MTU rule for private subnet 0x%x.\n", flt_rule.rule.attrib.u.v4.src_addr);
 			}
 		}
 
-		if (false == m_filtering.ModifyFilteringRule(pFilteringTable))
+		/* only the slots that changed since the last update reach IPA */
+		if (private_flt_set.Commit(&m_filtering) != IPACM_SUCCESS)
 		{
 			IPACMERR("Failed to modify private subnet filtering rules.\n");
 			res = IPACM_FAILURE;
-			goto fail;
 		}
 	}
-fail:
-	if(pFilteringTable != NULL)
-	{
-		free(pFilteringTable);
-	}
 	return res;
 }
 
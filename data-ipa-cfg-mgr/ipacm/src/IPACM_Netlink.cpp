@@ -1451,7 +1451,7 @@ static int ipa_nl_decode_nlmsg
 			}
 
 			/* insert to command queue */
-		    data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+		    data_all = (ipacm_event_data_all *)IPACM_EvtDispatcher::AllocEvtData(sizeof(ipacm_event_data_all));
 		    if(data_all == NULL)
 			{
 		    	IPACMERR("unable to allocate memory for event data_all\n");
@@ -1539,7 +1539,7 @@ static int ipa_nl_decode_nlmsg
 			}
 
 				/* insert to command queue */
-				data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+				data_all = (ipacm_event_data_all *)IPACM_EvtDispatcher::AllocEvtData(sizeof(ipacm_event_data_all));
 				if(data_all == NULL)
 				{
 					IPACMERR("unable to allocate memory for event data_all\n");
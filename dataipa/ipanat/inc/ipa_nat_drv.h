@@ -184,6 +184,23 @@ int ipa_nat_query_timestamp(uint32_t  table_handle,
 				uint32_t  rule_handle,
 				uint32_t  *time_stamp);
 
+/**
+ * ipa_nat_query_timestamps() - to query timestamps of many rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_handles: [in] ipv4 nat rule handles
+ * @time_stamps: [out] time stamp of each rule, zero if unreadable
+ * @num_rules: [in] number of entries in both arrays
+ *
+ * Bulk form of ipa_nat_query_timestamp() for periodic sweeps:
+ * the table is locked once and walked in a single pass
+ *
+ * Returns:	number of timestamps read, negative on failure
+ */
+int ipa_nat_query_timestamps(uint32_t  table_handle,
+				const uint32_t  *rule_handles,
+				uint32_t  *time_stamps,
+				uint32_t  num_rules);
+
 
 /**
  * ipa_nat_modify_pdn() - modify single PDN entry in the PDN config table
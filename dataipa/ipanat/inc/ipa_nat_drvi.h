@@ -291,6 +291,11 @@ int ipa_nati_query_timestamp(uint32_t  tbl_hdl,
 				uint32_t  rule_hdl,
 				uint32_t  *time_stamp);
 
+int ipa_nati_query_timestamps(uint32_t  tbl_hdl,
+				const uint32_t  *rule_hdls,
+				uint32_t  *time_stamps,
+				uint32_t  num_rules);
+
 int ipa_nati_modify_pdn(struct ipa_ioc_nat_pdn_entry *entry);
 
 int ipa_nati_get_pdn_index(uint32_t public_ip, uint8_t *pdn_index);
@@ -389,6 +394,12 @@ int ipa_NATI_query_timestamp(
 	uint32_t  rule_hdl,
 	uint32_t* time_stamp);
 
+int ipa_NATI_query_timestamps(
+	uint32_t        tbl_hdl,
+	const uint32_t* rule_hdls,
+	uint32_t*       time_stamps,
+	uint32_t        num_rules);
+
 int ipa_NATI_add_ipv4_rule(
 	uint32_t                 tbl_hdl,
 	const ipa_nat_ipv4_rule* clnt_rule,
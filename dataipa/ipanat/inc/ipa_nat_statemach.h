@@ -102,6 +102,7 @@ typedef enum {
 	NATI_TRIG_GOTO_DDR   =  9,
 	NATI_TRIG_GOTO_SRAM  = 10,
 	NATI_TRIG_GET_TSTAMP = 11,
+	NATI_TRIG_GET_TSTAMPS = 12,
 
 	NATI_TRIG_LAST
 } ipa_nati_trigger;
@@ -228,6 +229,7 @@ typedef struct
 #define VOTE_REQUIRED(t) \
 	( SRAM_TO_BE_ACCESSED(t) && \
 	  (t) != NATI_TRIG_GET_TSTAMP && \
+	  (t) != NATI_TRIG_GET_TSTAMPS && \
 	  (t) != NATI_TRIG_ADD_TABLE )
 
 /******************************************************************************/
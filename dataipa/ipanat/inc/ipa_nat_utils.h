@@ -63,6 +63,7 @@
 #ifndef IPA_NAT_UTILS_H
 #define IPA_NAT_UTILS_H
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -108,6 +109,55 @@ typedef struct
 	enum ipa_hw_type ver;
 } ipa_descriptor;
 
+/*
+ * All of the calls made against the IPA device and the NAT/IPv6CT
+ * table devices (ie. open, close, ioctl, mmap and munmap) go through
+ * a backend.  The backend is the kernel driver unless a test swaps in
+ * another one, like the user space emulation of the driver in
+ * test/ipa_nat_emu.c, with ipa_nat_set_backend() before any table is
+ * created.
+ */
+typedef struct
+{
+	const char* name;
+	int   (*open_fn)(const char* path, int flags);
+	int   (*close_fn)(int fd);
+	int   (*ioctl_fn)(int fd, unsigned long req, void* arg);
+	void* (*mmap_fn)(size_t len, int fd);
+	int   (*munmap_fn)(void* addr, size_t len);
+} ipa_nat_backend;
+
+extern const ipa_nat_backend ipa_nat_dev_backend;
+
+/*
+ * Returns -EBUSY when the current backend still has IPA descriptors
+ * open against it.  A NULL backend selects the kernel driver.
+ */
+int ipa_nat_set_backend(
+	const ipa_nat_backend* backend);
+
+const ipa_nat_backend* ipa_nat_get_backend(void);
+
+int ipa_nat_backend_open(
+	const char* path,
+	int         flags);
+
+int ipa_nat_backend_close(
+	int fd);
+
+int ipa_nat_backend_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg);
+
+void* ipa_nat_backend_mmap(
+	size_t len,
+	int    fd);
+
+int ipa_nat_backend_munmap(
+	void*  addr,
+	size_t len);
+
 ipa_descriptor* ipa_descriptor_open(void);
 
 void ipa_descriptor_close(
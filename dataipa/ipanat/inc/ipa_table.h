@@ -77,6 +77,13 @@ typedef enum
 #define IPA_TABLE_INDX_MASK      0x00000FFF
 #define IPA_TABLE_TYPE_MEM_SHIFT 15
 
+/*
+ * Expansion slot occupancy is tracked one bit per slot. The entry ID
+ * above limits the expansion table to IPA_TABLE_INDX_MASK + 1 slots.
+ */
+#define IPA_TABLE_EXPN_MAP_WORDS \
+	( (IPA_TABLE_INDX_MASK + 1) / 32 )
+
 #undef BREAK_RULE_HDL
 #define BREAK_RULE_HDL(tbl, hdl, mt, iet, indx) \
 	do { \
@@ -176,6 +183,13 @@ typedef struct
 
 	void*                      meta;
 	int                        meta_entry_size;
+
+	/*
+	 * Bit set while the expansion slot is in use, and the lowest
+	 * word that may still have a clear bit
+	 */
+	uint32_t                   expn_map[IPA_TABLE_EXPN_MAP_WORDS];
+	uint16_t                   expn_map_hint;
 } ipa_table;
 
 typedef struct
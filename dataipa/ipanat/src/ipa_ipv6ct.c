@@ -823,7 +823,7 @@ static int ipa_ipv6ct_post_init_cmd(ipa_ipv6ct_table* ipv6ct_table, uint8_t tbl_
 	cmd.table_entries = ipv6ct_table->table.table_entries - 1;
 	cmd.expn_table_entries = ipv6ct_table->table.expn_table_entries;
 
-	ret = ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_INIT_IPV6CT_TABLE, &cmd);
+	ret = ipa_nat_backend_ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_INIT_IPV6CT_TABLE, &cmd);
 	if (ret)
 	{
 		IPAERR("unable to post init cmd Error: %d IPA fd %d\n", ret, ipv6ct.ipa_desc->fd);
@@ -840,7 +840,7 @@ static int ipa_ipv6ct_post_dma_cmd(struct ipa_ioc_nat_dma_cmd* cmd)
 
 	cmd->mem_type = IPA_NAT_MEM_IN_DDR;
 
-	if (ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_TABLE_DMA_CMD, cmd))
+	if (ipa_nat_backend_ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_TABLE_DMA_CMD, cmd))
 	{
 		IPAERR("ioctl (IPA_IOC_TABLE_DMA_CMD) on fd %d has failed\n",
 			   ipv6ct.ipa_desc->fd);
@@ -900,7 +900,7 @@ int ipa_ipv6ct_add_uc_act_entry(union ipa_ioc_uc_activation_entry *u)
 {
 	IPADBG("\n");
 
-	if(ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_ADD_UC_ACT_ENTRY, u))
+	if(ipa_nat_backend_ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_ADD_UC_ACT_ENTRY, u))
 	{
 		IPAERR("ioctl (IPA_IOC_ADD_UC_ACT_ENTRY) on fd %d has failed\n",
 			ipv6ct.ipa_desc->fd);
@@ -921,7 +921,7 @@ int ipa_ipv6ct_del_uc_act_entry(uint16_t index)
 {
 	IPADBG("\n");
 
-	if(ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_DEL_UC_ACT_ENTRY, index))
+	if(ipa_nat_backend_ioctl(ipv6ct.ipa_desc->fd, IPA_IOC_DEL_UC_ACT_ENTRY, (void*) (uintptr_t) index))
 	{
 		IPAERR("ioctl (IPA_IOC_DEL_UC_ACT_ENTRY) on fd %d has failed\n",
 			ipv6ct.ipa_desc->fd);
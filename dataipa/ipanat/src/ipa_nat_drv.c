@@ -199,6 +199,43 @@ int ipa_nat_query_timestamp(
 	return ipa_nati_query_timestamp(tbl_hdl, rule_hdl, time_stamp);
 }
 
+/**
+ * ipa_nat_query_timestamps() - to query timestamps of many rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_handles: [in] ipv4 nat rule handles
+ * @time_stamps: [out] time stamp of each rule, zero if unreadable
+ * @num_rules: [in] number of entries in both arrays
+ *
+ * Bulk form of ipa_nat_query_timestamp() for periodic sweeps:
+ * the table is locked once and walked in a single pass
+ *
+ * Returns:	number of timestamps read, negative on failure
+ */
+int ipa_nat_query_timestamps(
+	uint32_t tbl_hdl,
+	const uint32_t *rule_hdls,
+	uint32_t *time_stamps,
+	uint32_t num_rules)
+{
+	if ( ! VALID_TBL_HDL(tbl_hdl) ||
+		 rule_hdls == NULL ||
+		 time_stamps == NULL )
+	{
+		IPAERR("Invalid parameters passed tbl_hdl=0x%x rule_hdls=%pK time_stamps=%pK\n",
+			   tbl_hdl, rule_hdls, time_stamps);
+		return -EINVAL;
+	}
+
+	if ( num_rules == 0 )
+	{
+		return 0;
+	}
+
+	IPADBG("Passed Table 0x%x and %u rule handles\n", tbl_hdl, num_rules);
+
+	return ipa_nati_query_timestamps(tbl_hdl, rule_hdls, time_stamps, num_rules);
+}
+
 /**
 * ipa_nat_modify_pdn() - modify single PDN entry in the PDN config table
 * @table_handle: [in] handle of ipv4 nat table
@@ -789,7 +789,7 @@ static int ipa_nati_create_table(
 	base_addr = nat_table->mem_desc.base_addr;
 
 #ifdef IPA_ON_R3PC
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd,
+	ret = ipa_nat_backend_ioctl(nat_cache_ptr->ipa_desc->fd,
 				IPA_IOC_GET_NAT_OFFSET,
 				&nat_mem_offset);
 	if (ret) {
@@ -900,7 +900,7 @@ static int ipa_nati_post_ipv4_init_cmd(
 
 	IPADBG("%s\n", ipa_ioc_v4_nat_init_as_str(&cmd, buf, sizeof(buf)));
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_V4_INIT_NAT, &cmd);
+	ret = ipa_nat_backend_ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_V4_INIT_NAT, &cmd);
 
 	if (ret) {
 		IPAERR("unable to post init cmd Error: %d IPA fd %d\n",
@@ -1091,7 +1091,7 @@ static int ipa_nati_post_ipv4_dma_cmd(
 
 	IPADBG("%s\n", prep_ioc_nat_dma_cmd_4print(cmd, buf, sizeof(buf)));
 
-	if (ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_TABLE_DMA_CMD, cmd)) {
+	if (ipa_nat_backend_ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_TABLE_DMA_CMD, cmd)) {
 		IPAERR("ioctl (IPA_IOC_TABLE_DMA_CMD) on fd %d has failed\n",
 			   nat_cache_ptr->ipa_desc->fd);
 		ret = -EIO;
@@ -1134,7 +1134,7 @@ int ipa_nati_modify_pdn(
 	if (entry->public_ip == 0)
 		IPADBG("PDN %d public ip will be set  to 0\n", entry->pdn_index);
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_NAT_MODIFY_PDN, entry);
+	ret = ipa_nat_backend_ioctl(nat_cache_ptr->ipa_desc->fd, IPA_IOC_NAT_MODIFY_PDN, entry);
 
 	if ( ret ) {
 		IPAERR("unable to call modify pdn icotl\nindex %d, ip 0x%X, src_metdata 0x%X, dst_metadata 0x%X IPA fd %d\n",
@@ -1624,6 +1624,95 @@ bail:
 	return ret;
 }
 
+/*
+ * Bulk variant of ipa_NATI_query_timestamp(). The nat mutex is taken
+ * once and each rule is read straight out of the mapped table, so a
+ * sweep over thousands of rules costs one lock round trip rather than
+ * one per rule. Slots whose rule can't be read are left at zero.
+ *
+ * Returns the number of timestamps read, otherwise negative.
+ */
+int ipa_NATI_query_timestamps(
+	uint32_t        tbl_hdl,
+	const uint32_t* rule_hdls,
+	uint32_t*       time_stamps,
+	uint32_t        num_rules )
+{
+	enum ipa3_nat_mem_in            nmi;
+	struct ipa_nat_cache*           nat_cache_ptr;
+	struct ipa_nat_ip4_table_cache* nat_table;
+	struct ipa_nat_rule*            rule_ptr;
+
+	uint32_t i;
+	int      ret;
+
+	IPADBG("In\n");
+
+	BREAK_TBL_HDL(tbl_hdl, nmi, tbl_hdl);
+
+	if ( ! IPA_VALID_NAT_MEM_IN(nmi) ) {
+		IPAERR("Bad cache type argument passed\n");
+		ret = -EINVAL;
+		goto bail;
+	}
+
+	IPADBG("nmi(%s) num_rules(%u)\n", ipa3_nat_mem_in_as_str(nmi), num_rules);
+
+	nat_cache_ptr = &ipv4_nat_cache[nmi];
+
+	nat_table = &nat_cache_ptr->ip4_tbl[tbl_hdl - 1];
+
+	memset(time_stamps, 0, num_rules * sizeof(*time_stamps));
+
+	if (pthread_mutex_lock(&nat_mutex)) {
+		IPAERR("unable to lock the nat mutex\n");
+		ret = -EINVAL;
+		goto bail;
+	}
+
+	if ( ! nat_table->mem_desc.valid ) {
+		IPAERR("invalid table handle %d\n", tbl_hdl);
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	ret = 0;
+
+	for ( i = 0; i < num_rules; i++ ) {
+
+		if ( ! VALID_RULE_HDL(rule_hdls[i]) ) {
+			continue;
+		}
+
+		if ( ipa_table_get_entry(
+				 &nat_table->table,
+				 rule_hdls[i],
+				 (void**) &rule_ptr,
+				 NULL) ) {
+			IPADBG("Unable to retrive the entry with handle=%u\n",
+				   rule_hdls[i]);
+			continue;
+		}
+
+		time_stamps[i] = rule_ptr->time_stamp;
+
+		ret++;
+	}
+
+	IPADBG("Read %d of %u timestamps\n", ret, num_rules);
+
+unlock:
+	if (pthread_mutex_unlock(&nat_mutex)) {
+		IPAERR("unable to unlock the nat mutex\n");
+		ret = (ret < 0) ? ret : -EPERM;
+	}
+
+bail:
+	IPADBG("Out\n");
+
+	return ret;
+}
+
 int ipa_NATI_add_ipv4_rule(
 	uint32_t                 tbl_hdl,
 	const ipa_nat_ipv4_rule* clnt_rule,
@@ -2053,7 +2142,7 @@ int ipa_nati_get_sram_size(
 
 	memset(&nat_sram_info, 0, sizeof(nat_sram_info));
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd,
+	ret = ipa_nat_backend_ioctl(nat_cache_ptr->ipa_desc->fd,
 				IPA_IOC_GET_NAT_IN_SRAM_INFO,
 				&nat_sram_info);
 
@@ -2669,9 +2758,9 @@ int ipa_nati_vote_clock(
 		}
 	}
 
-	ret = ioctl(nat_cache_ptr->ipa_desc->fd,
+	ret = ipa_nat_backend_ioctl(nat_cache_ptr->ipa_desc->fd,
 				IPA_IOC_APP_CLOCK_VOTE,
-				vote_type);
+				(void*) (uintptr_t) vote_type);
 
 	if (ret) {
 		IPAERR("APP_CLOCK_VOTE ioctl failure %d on IPA fd %d\n",
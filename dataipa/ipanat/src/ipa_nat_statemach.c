@@ -62,6 +62,7 @@
  */
 #include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
 
 #include "ipa_nat_drv.h"
 #include "ipa_nat_drvi.h"
@@ -461,6 +462,30 @@ int ipa_nati_query_timestamp(
 	return ret;
 }
 
+int ipa_nati_query_timestamps(
+	uint32_t        tbl_hdl,
+	const uint32_t* rule_hdls,
+	uint32_t*       time_stamps,
+	uint32_t        num_rules)
+{
+	arb_t* args[] = {
+		(arb_t*)(arb_t)tbl_hdl,
+		(arb_t*) rule_hdls,
+		(arb_t*) time_stamps,
+		(arb_t*)(arb_t)num_rules,
+	};
+
+	int ret;
+
+	IPADBG("In\n");
+
+	ret = ipa_nati_statemach(&nati_obj, NATI_TRIG_GET_TSTAMPS, args);
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
 int ipa_nat_switch_to(
 	enum ipa3_nat_mem_in nmi,
 	bool                 hold_state )
@@ -596,7 +621,10 @@ int ipa_nat_switch_to(
 	ret = 0;
 
 unlock:
-	ret = give_mutex();
+	if ( give_mutex() != 0 )
+	{
+		ret = (ret) ? ret : -EPERM;
+	}
 
 bail:
 	IPADBG("Out\n");
@@ -2447,6 +2475,134 @@ static int _smGetTmStmpHybrid(
 	return ret;
 }
 
+/******************************************************************************/
+/*
+ * FUNCTION: _smGetTmStmps
+ *
+ * PARAMS:
+ *
+ *   nati_obj_ptr (IN) A pointer to an initialized nati object
+ *
+ *   trigger      (IN) The trigger to run through the state machine
+ *
+ *   arb_data_ptr (IN) Whatever you like
+ *
+ * DESCRIPTION:
+ *
+ *   Retrieve the timestamps of many rules from NAT table in one pass.
+ *
+ * RETURNS:
+ *
+ *   number of timestamps read, otherwise negative
+ */
+static int _smGetTmStmps(
+	ipa_nati_obj*    nati_obj_ptr,
+	ipa_nati_trigger trigger,
+	arb_t*           arb_data_ptr )
+{
+	arb_t** args = arb_data_ptr;
+
+	uint32_t        tbl_hdl     = (uint32_t)        args[0];
+	const uint32_t* rule_hdls   = (const uint32_t*) args[1];
+	uint32_t*       time_stamps = (uint32_t*)       args[2];
+	uint32_t        num_rules   = (uint32_t)        args[3];
+
+	int ret;
+
+	IPADBG("In\n");
+
+	IPADBG("tbl_hdl(0x%08X) num_rules(%u)\n", tbl_hdl, num_rules);
+
+	ret = ipa_NATI_query_timestamps(tbl_hdl, rule_hdls, time_stamps, num_rules);
+
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+/******************************************************************************/
+/*
+ * FUNCTION: _smGetTmStmpsHybrid
+ *
+ * PARAMS:
+ *
+ *   nati_obj_ptr (IN) A pointer to an initialized nati object
+ *
+ *   trigger      (IN) The trigger to run through the state machine
+ *
+ *   arb_data_ptr (IN) Whatever you like
+ *
+ * DESCRIPTION:
+ *
+ *   Retrieve the timestamps of many rules from the state approriate
+ *   NAT table. Rules that have no mapping are reported as zero.
+ *
+ * RETURNS:
+ *
+ *   number of timestamps read, otherwise negative
+ */
+static int _smGetTmStmpsHybrid(
+	ipa_nati_obj*    nati_obj_ptr,
+	ipa_nati_trigger trigger,
+	arb_t*           arb_data_ptr )
+{
+	arb_t** args = arb_data_ptr;
+
+	uint32_t        tbl_hdl        = (uint32_t)        args[0];
+	const uint32_t* orig_rule_hdls = (const uint32_t*) args[1];
+	uint32_t*       time_stamps    = (uint32_t*)       args[2];
+	uint32_t        num_rules      = (uint32_t)        args[3];
+
+	uint32_t*       new_rule_hdls;
+
+	uint32_t        orig2new_map, new2orig_map;
+
+	uint32_t        i;
+
+	int             ret;
+
+	IPADBG("In\n");
+
+	new_rule_hdls = malloc(num_rules * sizeof(*new_rule_hdls));
+
+	if ( new_rule_hdls == NULL )
+	{
+		IPAERR("Unable to allocate %u rule handles\n", num_rules);
+		ret = -ENOMEM;
+		goto bail;
+	}
+
+	CHOOSE_MAPS(orig2new_map, new2orig_map);
+
+	for ( i = 0; i < num_rules; i++ )
+	{
+		if ( ipa_nat_map_find(orig2new_map, orig_rule_hdls[i], &new_rule_hdls[i]) )
+		{
+			new_rule_hdls[i] = IPA_TABLE_INVALID_ENTRY;
+		}
+	}
+
+	{
+		arb_t* new_args[] = {
+			(arb_t*)(arb_t)(nati_obj_ptr->curr_state == NATI_STATE_HYBRID) ?
+			         tbl_hdl :
+			         nati_obj_ptr->ddr_tbl_hdl,
+			(arb_t*) new_rule_hdls,
+			(arb_t*) time_stamps,
+			(arb_t*)(arb_t)num_rules,
+		};
+
+		ret = _smGetTmStmps(nati_obj_ptr, trigger, new_args);
+	}
+
+	free(new_rule_hdls);
+
+bail:
+	IPADBG("Out\n");
+
+	return ret;
+}
+
 /******************************************************************************/
 /*
  * The following table relates a nati object's state and a transition
@@ -2468,6 +2624,7 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GET_TSTAMP, _smUndef ),
+		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_GET_TSTAMPS, _smUndef ),
 		SM_ROW( NATI_STATE_NULL,       NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2484,6 +2641,7 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GET_TSTAMP, _smGetTmStmp ),
+		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_GET_TSTAMPS, _smGetTmStmps ),
 		SM_ROW( NATI_STATE_DDR_ONLY,   NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2500,6 +2658,7 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GET_TSTAMP, _smGetTmStmp ),
+		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_GET_TSTAMPS, _smGetTmStmps ),
 		SM_ROW( NATI_STATE_SRAM_ONLY,  NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2516,6 +2675,7 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GOTO_DDR,   _smGoToDdr ),
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GOTO_SRAM,  _smGoToSram ),
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GET_TSTAMP, _smGetTmStmpHybrid ),
+		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_GET_TSTAMPS, _smGetTmStmpsHybrid ),
 		SM_ROW( NATI_STATE_HYBRID,     NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2532,6 +2692,7 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GOTO_DDR,   _smGoToDdr ),
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GOTO_SRAM,  _smGoToSram ),
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GET_TSTAMP, _smGetTmStmpHybrid ),
+		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_GET_TSTAMPS, _smGetTmStmpsHybrid ),
 		SM_ROW( NATI_STATE_HYBRID_DDR, NATI_TRIG_LAST,       _smUndef ),
 	},
 
@@ -2548,6 +2709,7 @@ _state_mach_tbl[NATI_STATE_LAST+1][NATI_TRIG_LAST+1] =
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GOTO_DDR,   _smUndef ),
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GOTO_SRAM,  _smUndef ),
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GET_TSTAMP, _smUndef ),
+		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_GET_TSTAMPS, _smUndef ),
 		SM_ROW( NATI_STATE_LAST,       NATI_TRIG_LAST,       _smUndef ),
 	},
 };
@@ -2662,7 +2824,10 @@ int ipa_nati_statemach(
 	}
 
 unlock:
-	ret = give_mutex();
+	if ( give_mutex() != 0 )
+	{
+		ret = (ret) ? ret : -EPERM;
+	}
 
 bail:
 	IPADBG("Out\n");
@@ -32,11 +32,16 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sys/mman.h>
 
 #define IPA_MAX_MSG_LEN 4096
 
 static char dbg_buff[IPA_MAX_MSG_LEN];
 
+static const ipa_nat_backend* nat_backend       = &ipa_nat_dev_backend;
+static int                    nat_backend_users;
+static pthread_mutex_t        nat_backend_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 #if !defined(MSM_IPA_TESTS) && !defined(USE_GLIB) && !defined(FEATURE_IPA_ANDROID)
 size_t strlcpy(char* dst, const char* src, size_t size)
 {
@@ -54,6 +59,130 @@ size_t strlcpy(char* dst, const char* src, size_t size)
 }
 #endif
 
+static int dev_open(
+	const char* path,
+	int         flags)
+{
+	return open(path, flags);
+}
+
+static int dev_close(
+	int fd)
+{
+	return close(fd);
+}
+
+static int dev_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg)
+{
+	return ioctl(fd, req, arg);
+}
+
+static void* dev_mmap(
+	size_t len,
+	int    fd)
+{
+	return mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+}
+
+static int dev_munmap(
+	void*  addr,
+	size_t len)
+{
+	return munmap(addr, len);
+}
+
+const ipa_nat_backend ipa_nat_dev_backend =
+{
+	.name      = "dev",
+	.open_fn   = dev_open,
+	.close_fn  = dev_close,
+	.ioctl_fn  = dev_ioctl,
+	.mmap_fn   = dev_mmap,
+	.munmap_fn = dev_munmap,
+};
+
+int ipa_nat_set_backend(
+	const ipa_nat_backend* backend)
+{
+	int ret = 0;
+
+	IPADBG("In\n");
+
+	if ( pthread_mutex_lock(&nat_backend_mutex) )
+	{
+		IPAERR("unable to lock the backend mutex\n");
+		ret = -EINVAL;
+		goto bail;
+	}
+
+	if ( nat_backend_users )
+	{
+		IPAERR("%d descriptor(s) still open on the %s backend\n",
+			   nat_backend_users, nat_backend->name);
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	nat_backend = ( backend ) ? backend : &ipa_nat_dev_backend;
+
+	IPADBG("Backend is now %s\n", nat_backend->name);
+
+unlock:
+	if ( pthread_mutex_unlock(&nat_backend_mutex) )
+	{
+		IPAERR("unable to unlock the backend mutex\n");
+		ret = (ret) ? ret : -EPERM;
+	}
+
+bail:
+	IPADBG("Out\n");
+
+	return ret;
+}
+
+const ipa_nat_backend* ipa_nat_get_backend(void)
+{
+	return nat_backend;
+}
+
+int ipa_nat_backend_open(
+	const char* path,
+	int         flags)
+{
+	return ipa_nat_get_backend()->open_fn(path, flags);
+}
+
+int ipa_nat_backend_close(
+	int fd)
+{
+	return ipa_nat_get_backend()->close_fn(fd);
+}
+
+int ipa_nat_backend_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg)
+{
+	return ipa_nat_get_backend()->ioctl_fn(fd, req, arg);
+}
+
+void* ipa_nat_backend_mmap(
+	size_t len,
+	int    fd)
+{
+	return ipa_nat_get_backend()->mmap_fn(len, fd);
+}
+
+int ipa_nat_backend_munmap(
+	void*  addr,
+	size_t len)
+{
+	return ipa_nat_get_backend()->munmap_fn(addr, len);
+}
+
 ipa_descriptor* ipa_descriptor_open(void)
 {
 	ipa_descriptor* desc_ptr;
@@ -69,7 +198,23 @@ ipa_descriptor* ipa_descriptor_open(void)
 		goto bail;
 	}
 
-	desc_ptr->fd = open(IPA_DEV_NAME, O_RDONLY);
+	if ( pthread_mutex_lock(&nat_backend_mutex) )
+	{
+		IPAERR("unable to lock the backend mutex\n");
+		goto free;
+	}
+
+	desc_ptr->fd = ipa_nat_backend_open(IPA_DEV_NAME, O_RDONLY);
+
+	if (desc_ptr->fd >= 0)
+	{
+		nat_backend_users++;
+	}
+
+	if ( pthread_mutex_unlock(&nat_backend_mutex) )
+	{
+		IPAERR("unable to unlock the backend mutex\n");
+	}
 
 	if (desc_ptr->fd < 0)
 	{
@@ -77,7 +222,8 @@ ipa_descriptor* ipa_descriptor_open(void)
 		goto free;
 	}
 
-	res = ioctl(desc_ptr->fd, IPA_IOC_GET_HW_VERSION, &desc_ptr->ver);
+	res = ipa_nat_backend_ioctl(
+		desc_ptr->fd, IPA_IOC_GET_HW_VERSION, &desc_ptr->ver);
 
 	if (res == 0)
 	{
@@ -110,7 +256,10 @@ void ipa_descriptor_close(
 	{
 		if ( desc_ptr->fd >= 0)
 		{
-			close(desc_ptr->fd);
+			pthread_mutex_lock(&nat_backend_mutex);
+			ipa_nat_backend_close(desc_ptr->fd);
+			nat_backend_users--;
+			pthread_mutex_unlock(&nat_backend_mutex);
 		}
 		free(desc_ptr);
 	}
@@ -70,6 +70,14 @@ static int FindExpnTblFreeEntry(
 	void**     free_entry,
 	uint16_t*  entry_index );
 
+static void ExpnSlotTake(
+	ipa_table* table,
+	uint16_t   index );
+
+static void ExpnSlotRelease(
+	ipa_table* table,
+	uint16_t   index );
+
 static int Get2PowerTightUpperBound(
 	uint16_t num);
 
@@ -217,6 +225,9 @@ void ipa_table_reset(
 	for (i = 0; i < tot; i++)
 		table->expn_table_addr[i] = '\0';
 
+	memset(table->expn_map, 0, sizeof(table->expn_map));
+	table->expn_map_hint = 0;
+
 	IPADBG("Out\n");
 }
 
@@ -405,6 +416,8 @@ void ipa_table_erase_entry(
 	else
 	{
 		--table->cur_expn_tbl_cnt;
+
+		ExpnSlotRelease(table, index);
 	}
 
 	IPADBG("Out\n");
@@ -919,6 +932,8 @@ static int InsertTail(
 
 	++table->cur_expn_tbl_cnt;
 
+	ExpnSlotTake(table, iterator.curr_index);
+
 	*rec_index_ptr = iterator.curr_index;
 
 bail:
@@ -974,31 +989,44 @@ static uint16_t MakeEntryHdl(
 	return entry_hdl;
 }
 
-static int mt_slot(
-	ipa_table*      table_ptr,
-	uint32_t        rule_hdl,
-	void*           record_ptr,
-	uint16_t        record_index,
-	void*           meta_record_ptr,
-	uint16_t        meta_record_index,
-	void*           arb_data_ptr )
+static void ExpnSlotTake(
+	ipa_table* table,
+	uint16_t   index )
+{
+	uint16_t slot = index - table->table_entries;
+
+	table->expn_map[slot / 32] |= (1U << (slot % 32));
+}
+
+static void ExpnSlotRelease(
+	ipa_table* table,
+	uint16_t   index )
 {
-	IPADBG("%s: Empty expansion slot: (%u) in table of size: (%u)\n",
-		   table_ptr->name,
-		   record_index,
-		   table_ptr->tot_tbl_ents);
+	uint16_t slot = index - table->table_entries;
 
-	return record_index;
+	table->expn_map[slot / 32] &= ~(1U << (slot % 32));
+
+	if ( slot / 32 < table->expn_map_hint )
+	{
+		table->expn_map_hint = slot / 32;
+	}
 }
 
 /*
  * returns expn table entry absolute index
+ *
+ * The lowest clear bit in the expansion map is taken, which is the
+ * same slot a walk from the start of the expansion table would find,
+ * without touching the records on the way.
  */
 static int FindExpnTblFreeEntry(
 	ipa_table* table,
 	void**     free_entry,
 	uint16_t*  entry_index )
 {
+	uint16_t words, w, slot, index;
+	void*    rec_ptr;
+
 	int ret;
 
 	IPADBG("In\n");
@@ -1015,17 +1043,47 @@ static int FindExpnTblFreeEntry(
 	*entry_index = 0;
 	*free_entry  = NULL;
 
-	/*
-	 * The following will start walk at expansion slots
-	 * (ie. just after table->table_entries)...
-	 */
-	ret = ipa_table_walk(table, table->table_entries, WHEN_SLOT_EMPTY, mt_slot, 0);
+	words = (table->expn_table_entries + 31) / 32;
 
-	if ( ret > 0 )
+	if ( words > IPA_TABLE_EXPN_MAP_WORDS )
 	{
-		*entry_index = (uint16_t) ret;
+		words = IPA_TABLE_EXPN_MAP_WORDS;
+	}
+
+	for ( w = table->expn_map_hint; w < words; )
+	{
+		if ( table->expn_map[w] == 0xFFFFFFFF )
+		{
+			w++;
+			continue;
+		}
+
+		slot = (w * 32) + __builtin_ctz(~table->expn_map[w]);
 
-		*free_entry = GOTO_REC(table, *entry_index);
+		if ( slot >= table->expn_table_entries )
+		{
+			break;
+		}
+
+		index   = table->table_entries + slot;
+		rec_ptr = GOTO_REC(table, index);
+
+		/*
+		 * The map is only updated through this module, so this
+		 * shouldn't happen, but never hand out a live record...
+		 */
+		if ( table->entry_interface->entry_is_valid(rec_ptr) )
+		{
+			IPAERR("%s: expansion slot (%u) in use but not in map\n",
+				   table->name, index);
+			ExpnSlotTake(table, index);
+			continue;
+		}
+
+		table->expn_map_hint = w;
+
+		*entry_index = index;
+		*free_entry  = rec_ptr;
 
 		IPADBG("%s: entry_index val (%u) free_entry val (%p)\n",
 			   table->name,
@@ -1033,27 +1091,20 @@ static int FindExpnTblFreeEntry(
 			   *free_entry);
 
 		ret = 0;
+		goto bail;
 	}
-	else
-	{
-		if ( ret < 0 )
-		{
-			IPAERR("%s: While searching table for emtpy slot\n",
-				   table->name);
-		}
-		else
-		{
-			IPADBG("%s: No empty slots (ie. expansion table full): "
-				   "BASE (avail/used): (%u/%u) EXPN (avail/used): (%u/%u)\n",
-				   table->name,
-				   table->table_entries,
-				   table->cur_tbl_cnt,
-				   table->expn_table_entries,
-				   table->cur_expn_tbl_cnt);
-		}
 
-		ret = -1;
-	}
+	table->expn_map_hint = w;
+
+	IPADBG("%s: No empty slots (ie. expansion table full): "
+		   "BASE (avail/used): (%u/%u) EXPN (avail/used): (%u/%u)\n",
+		   table->name,
+		   table->table_entries,
+		   table->cur_tbl_cnt,
+		   table->expn_table_entries,
+		   table->cur_expn_tbl_cnt);
+
+	ret = -1;
 
 bail:
 	IPADBG("Out\n");
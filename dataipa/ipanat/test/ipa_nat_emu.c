@@ -0,0 +1,795 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ipa_nat_emu.h"
+#include "ipa_table.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+/*
+ * User space emulation of the IPA driver's NAT and IPv6CT table
+ * handling.  Table memory is plain process memory handed back by
+ * mmap, and the DMA commands are applied to it directly, with the
+ * same bounds the driver would enforce.  What the IPA itself does to
+ * the tables (ie. rule lookups and time stamp updates) is not
+ * emulated.
+ *
+ * The following environment variables tune the emulation:
+ *
+ *   IPA_NAT_EMU_SRAM_SIZE     Bytes of SRAM available for the NAT
+ *                             table (default 32K, 0 means no SRAM)
+ *
+ *   IPA_NAT_EMU_DMA_DELAY_NS  Time each DMA command takes to
+ *                             complete (default 0)
+ */
+#define IPA_NAT_EMU_SRAM_SIZE_ENV     "IPA_NAT_EMU_SRAM_SIZE"
+#define IPA_NAT_EMU_DMA_DELAY_ENV     "IPA_NAT_EMU_DMA_DELAY_NS"
+
+#define IPA_NAT_EMU_SRAM_SIZE         (32 * 1024)
+#define IPA_NAT_EMU_HW_VER            IPA_HW_v4_5
+#define IPA_NAT_EMU_PAGE_SIZE         4096
+
+/*
+ * The SRAM set aside for NAT does not start on a page boundary, so
+ * the driver reports where the table starts within the mmap...
+ */
+#define IPA_NAT_EMU_SRAM_MMAP_OFFSET  0x200
+
+#define IPA_NAT_EMU_MAX_FDS           32
+#define IPA_NAT_EMU_FD_BASE           0x4000
+
+#define IPA_NAT_EMU_NUM_DMA_TYPES     (IPA_IPV6CT_EXPN_TBL + 1)
+
+#define IPA_NAT_EMU_NO_BIND           IPA_NAT_MEM_IN_MAX
+
+#undef  ROUND_UP_TO_PAGE
+#define ROUND_UP_TO_PAGE(x) \
+	( ((x) + IPA_NAT_EMU_PAGE_SIZE - 1) & ~(IPA_NAT_EMU_PAGE_SIZE - 1) )
+
+typedef enum
+{
+	EMU_DEV_NONE   = 0,
+	EMU_DEV_IPA    = 1,
+	EMU_DEV_NAT    = 2,
+	EMU_DEV_IPV6CT = 3,
+} emu_dev_type;
+
+/*
+ * A table allocated via one of the ALLOC ioctls.  mem is what mmap
+ * hands back and the table itself starts tbl_offset bytes into it.
+ * Where each sub-table (base, expansion, index...) lives is learned
+ * from the INIT ioctls.
+ */
+typedef struct
+{
+	uint8_t* mem;
+	size_t   mem_size;
+	uint32_t tbl_offset;
+	uint32_t tbl_size;
+	bool     mapped;
+	bool     initialized;
+	uint32_t sub_start[IPA_NAT_EMU_NUM_DMA_TYPES];
+	uint32_t sub_size[IPA_NAT_EMU_NUM_DMA_TYPES];
+} emu_table;
+
+static struct
+{
+	pthread_mutex_t              lock;
+	bool                         configured;
+	uint32_t                     sram_size;
+	uint32_t                     dma_delay_ns;
+	emu_dev_type                 fds[IPA_NAT_EMU_MAX_FDS];
+	/*
+	 * NAT tables are kept by where they were allocated, while the
+	 * INIT and DMA commands name the memory type the client thinks
+	 * it is using.  nat_bind maps the latter to the former.
+	 */
+	emu_table                    nat[IPA_NAT_MEM_IN_MAX];
+	enum ipa3_nat_mem_in         nat_bind[IPA_NAT_MEM_IN_MAX];
+	enum ipa3_nat_mem_in         nat_last_alloc;
+	enum ipa3_nat_mem_in         nat_focus;
+	emu_table                    ipv6ct;
+	struct ipa_ioc_nat_pdn_entry pdns[IPA_MAX_PDN_NUM];
+	ipa_nat_emu_stats            stats;
+} emu = {
+	.lock     = PTHREAD_MUTEX_INITIALIZER,
+	.nat_bind = { IPA_NAT_EMU_NO_BIND, IPA_NAT_EMU_NO_BIND },
+};
+
+static uint32_t emu_env_u32(
+	const char* name,
+	uint32_t    dflt)
+{
+	const char* val = getenv(name);
+	char*       end;
+	unsigned long ul;
+
+	if ( val == NULL || *val == '\0' )
+		return dflt;
+
+	ul = strtoul(val, &end, 0);
+
+	if ( *end != '\0' || ul > UINT32_MAX )
+	{
+		IPAERR("Ignoring bad %s value %s\n", name, val);
+		return dflt;
+	}
+
+	return (uint32_t) ul;
+}
+
+/*
+ * Called with emu.lock held
+ */
+static void emu_configure(void)
+{
+	if ( emu.configured )
+		return;
+
+	emu.sram_size =
+		emu_env_u32(IPA_NAT_EMU_SRAM_SIZE_ENV, IPA_NAT_EMU_SRAM_SIZE);
+	emu.dma_delay_ns =
+		emu_env_u32(IPA_NAT_EMU_DMA_DELAY_ENV, 0);
+
+	IPAINFO("sram_size(0x%x) dma_delay_ns(%u)\n",
+			emu.sram_size, emu.dma_delay_ns);
+
+	emu.configured = true;
+}
+
+static emu_dev_type emu_fd_type(
+	int fd)
+{
+	int idx = fd - IPA_NAT_EMU_FD_BASE;
+
+	if ( idx < 0 || idx >= IPA_NAT_EMU_MAX_FDS )
+		return EMU_DEV_NONE;
+
+	return emu.fds[idx];
+}
+
+static uint32_t emu_sram_mmap_size(void)
+{
+	return ROUND_UP_TO_PAGE(IPA_NAT_EMU_SRAM_MMAP_OFFSET + emu.sram_size);
+}
+
+static int emu_table_alloc(
+	emu_table* tbl,
+	uint32_t   size,
+	bool       in_sram)
+{
+	if ( tbl->mem )
+		return -EEXIST;
+
+	if ( size == 0 )
+		return -EINVAL;
+
+	memset(tbl, 0, sizeof(*tbl));
+
+	tbl->tbl_offset = (in_sram) ? IPA_NAT_EMU_SRAM_MMAP_OFFSET : 0;
+	tbl->tbl_size   = size;
+	tbl->mem_size   =
+		(in_sram) ? emu_sram_mmap_size() : ROUND_UP_TO_PAGE(size);
+
+	tbl->mem = mmap(
+		NULL,
+		tbl->mem_size,
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS,
+		-1,
+		0);
+
+	if ( tbl->mem == MAP_FAILED )
+	{
+		tbl->mem = NULL;
+		return -ENOMEM;
+	}
+
+	emu.stats.table_allocs++;
+
+	return 0;
+}
+
+static int emu_table_free(
+	emu_table* tbl)
+{
+	if ( ! tbl->mem )
+		return -EINVAL;
+
+	munmap(tbl->mem, tbl->mem_size);
+
+	memset(tbl, 0, sizeof(*tbl));
+
+	return 0;
+}
+
+static int emu_alloc_nat(
+	struct ipa_ioc_nat_ipv6ct_table_alloc* cmd)
+{
+	enum ipa3_nat_mem_in nmi;
+	int ret;
+
+	/*
+	 * Same choice as the driver and ipa_mem_descriptor.c make: the
+	 * table goes to SRAM whenever it fits there.
+	 */
+	nmi = ( emu.sram_size && cmd->size <= emu.sram_size ) ?
+		IPA_NAT_MEM_IN_SRAM :
+		IPA_NAT_MEM_IN_DDR;
+
+	ret = emu_table_alloc(
+		&emu.nat[nmi], cmd->size, nmi == IPA_NAT_MEM_IN_SRAM);
+
+	if ( ret == 0 )
+	{
+		emu.nat_last_alloc = nmi;
+		cmd->offset = 0;
+	}
+
+	return ret;
+}
+
+static int emu_del_nat(
+	struct ipa_ioc_nat_ipv6ct_table_del* cmd)
+{
+	uint32_t i;
+	int ret;
+
+	if ( cmd->table_index != 0 || cmd->mem_type >= IPA_NAT_MEM_IN_MAX )
+		return -EINVAL;
+
+	ret = emu_table_free(&emu.nat[cmd->mem_type]);
+
+	if ( ret )
+		return ret;
+
+	for ( i = 0; i < IPA_NAT_MEM_IN_MAX; i++ )
+	{
+		if ( emu.nat_bind[i] == cmd->mem_type )
+			emu.nat_bind[i] = IPA_NAT_EMU_NO_BIND;
+	}
+
+	if ( ! emu.nat[IPA_NAT_MEM_IN_DDR].mem &&
+		 ! emu.nat[IPA_NAT_MEM_IN_SRAM].mem )
+	{
+		memset(emu.pdns, 0, sizeof(emu.pdns));
+	}
+
+	return 0;
+}
+
+static int emu_init_nat(
+	struct ipa_ioc_v4_nat_init* cmd)
+{
+	emu_table* tbl;
+	uint32_t   indx_entry_size;
+	uint32_t   end;
+
+	if ( cmd->tbl_index != 0 || cmd->mem_type >= IPA_NAT_MEM_IN_MAX )
+		return -EINVAL;
+
+	if ( cmd->focus_change )
+	{
+		/*
+		 * Only moves the IPA's attention to an already initialized
+		 * table...
+		 */
+		if ( emu.nat_bind[cmd->mem_type] == IPA_NAT_EMU_NO_BIND )
+			return -EPERM;
+
+		emu.nat_focus = cmd->mem_type;
+
+		return 0;
+	}
+
+	tbl = &emu.nat[emu.nat_last_alloc];
+
+	if ( ! tbl->mem )
+		return -EPERM;
+
+	if ( cmd->expn_rules_offset < cmd->ipv4_rules_offset ||
+		 cmd->index_offset < cmd->expn_rules_offset ||
+		 cmd->index_expn_offset < cmd->index_offset )
+		return -EINVAL;
+
+	indx_entry_size =
+		(cmd->index_expn_offset - cmd->index_offset) /
+		(cmd->table_entries + 1);
+
+	end = cmd->index_expn_offset +
+		cmd->expn_table_entries * indx_entry_size;
+
+	if ( end > tbl->tbl_size )
+	{
+		IPAERR("init cmd spans 0x%x bytes of a 0x%x byte table\n",
+			   end, tbl->tbl_size);
+		return -EINVAL;
+	}
+
+	tbl->sub_start[IPA_NAT_BASE_TBL]       = cmd->ipv4_rules_offset;
+	tbl->sub_size[IPA_NAT_BASE_TBL]        =
+		cmd->expn_rules_offset - cmd->ipv4_rules_offset;
+	tbl->sub_start[IPA_NAT_EXPN_TBL]       = cmd->expn_rules_offset;
+	tbl->sub_size[IPA_NAT_EXPN_TBL]        =
+		cmd->index_offset - cmd->expn_rules_offset;
+	tbl->sub_start[IPA_NAT_INDX_TBL]       = cmd->index_offset;
+	tbl->sub_size[IPA_NAT_INDX_TBL]        =
+		cmd->index_expn_offset - cmd->index_offset;
+	tbl->sub_start[IPA_NAT_INDEX_EXPN_TBL] = cmd->index_expn_offset;
+	tbl->sub_size[IPA_NAT_INDEX_EXPN_TBL]  =
+		end - cmd->index_expn_offset;
+
+	tbl->initialized = true;
+
+	emu.nat_bind[cmd->mem_type] = emu.nat_last_alloc;
+	emu.nat_focus = cmd->mem_type;
+
+	emu.stats.table_inits++;
+
+	return 0;
+}
+
+static int emu_init_ipv6ct(
+	struct ipa_ioc_ipv6ct_init* cmd)
+{
+	emu_table* tbl = &emu.ipv6ct;
+	uint32_t   entry_size;
+	uint32_t   end;
+
+	if ( cmd->tbl_index != 0 )
+		return -EINVAL;
+
+	if ( ! tbl->mem )
+		return -EPERM;
+
+	if ( cmd->expn_table_offset < cmd->base_table_offset )
+		return -EINVAL;
+
+	entry_size =
+		(cmd->expn_table_offset - cmd->base_table_offset) /
+		(cmd->table_entries + 1);
+
+	end = cmd->expn_table_offset +
+		cmd->expn_table_entries * entry_size;
+
+	if ( end > tbl->tbl_size )
+	{
+		IPAERR("init cmd spans 0x%x bytes of a 0x%x byte table\n",
+			   end, tbl->tbl_size);
+		return -EINVAL;
+	}
+
+	tbl->sub_start[IPA_IPV6CT_BASE_TBL] = cmd->base_table_offset;
+	tbl->sub_size[IPA_IPV6CT_BASE_TBL]  =
+		cmd->expn_table_offset - cmd->base_table_offset;
+	tbl->sub_start[IPA_IPV6CT_EXPN_TBL] = cmd->expn_table_offset;
+	tbl->sub_size[IPA_IPV6CT_EXPN_TBL]  =
+		end - cmd->expn_table_offset;
+
+	tbl->initialized = true;
+
+	emu.stats.table_inits++;
+
+	return 0;
+}
+
+static emu_table* emu_dma_table(
+	struct ipa_ioc_nat_dma_cmd* cmd,
+	struct ipa_ioc_nat_dma_one* dma)
+{
+	emu_table* tbl;
+
+	if ( ! VALID_IPA_TABLE_DMA_TYPE(dma->base_addr) || dma->table_index != 0 )
+		return NULL;
+
+	if ( dma->base_addr >= IPA_IPV6CT_BASE_TBL )
+	{
+		tbl = &emu.ipv6ct;
+	}
+	else
+	{
+		if ( cmd->mem_type >= IPA_NAT_MEM_IN_MAX ||
+			 emu.nat_bind[cmd->mem_type] == IPA_NAT_EMU_NO_BIND )
+			return NULL;
+
+		tbl = &emu.nat[emu.nat_bind[cmd->mem_type]];
+	}
+
+	if ( ! tbl->initialized ||
+		 (uint64_t) dma->offset + sizeof(dma->data) >
+		 tbl->sub_size[dma->base_addr] )
+		return NULL;
+
+	return tbl;
+}
+
+static void emu_dma_delay(void)
+{
+	struct timespec start, now;
+	uint64_t elapsed;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	do
+	{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		elapsed =
+			(uint64_t) (now.tv_sec - start.tv_sec) * 1000000000ULL +
+			(uint64_t) now.tv_nsec - (uint64_t) start.tv_nsec;
+	} while ( elapsed < emu.dma_delay_ns );
+}
+
+static int emu_dma(
+	struct ipa_ioc_nat_dma_cmd* cmd)
+{
+	struct ipa_ioc_nat_dma_one* dma;
+	emu_table* tbl;
+	uint32_t   i;
+
+	emu.stats.dma_cmds++;
+
+	/*
+	 * The driver rejects the whole command if any one entry is bad,
+	 * before anything has been written...
+	 */
+	for ( i = 0; i < cmd->entries; i++ )
+	{
+		dma = &cmd->dma[i];
+
+		if ( emu_dma_table(cmd, dma) == NULL )
+		{
+			char buf[1024];
+
+			IPAERR("Bad dma entry %u in %s\n", i,
+				   prep_ioc_nat_dma_cmd_4print(cmd, buf, sizeof(buf)));
+
+			emu.stats.dma_errors++;
+
+			return -EINVAL;
+		}
+	}
+
+	for ( i = 0; i < cmd->entries; i++ )
+	{
+		dma = &cmd->dma[i];
+		tbl = emu_dma_table(cmd, dma);
+
+		memcpy(
+			tbl->mem + tbl->tbl_offset +
+			tbl->sub_start[dma->base_addr] + dma->offset,
+			&dma->data,
+			sizeof(dma->data));
+	}
+
+	emu.stats.dma_entries += cmd->entries;
+
+	if ( emu.dma_delay_ns )
+		emu_dma_delay();
+
+	return 0;
+}
+
+static int emu_modify_pdn(
+	struct ipa_ioc_nat_pdn_entry* entry)
+{
+	if ( entry->pdn_index >= IPA_MAX_PDN_NUM )
+		return -EINVAL;
+
+	if ( ! emu.nat[IPA_NAT_MEM_IN_DDR].initialized &&
+		 ! emu.nat[IPA_NAT_MEM_IN_SRAM].initialized )
+		return -EPERM;
+
+	emu.pdns[entry->pdn_index] = *entry;
+
+	return 0;
+}
+
+static int emu_sram_info(
+	struct ipa_nat_in_sram_info* info)
+{
+	if ( emu.sram_size == 0 )
+		return -EOPNOTSUPP;
+
+	info->sram_mem_available_for_nat = emu.sram_size;
+	info->nat_table_offset_into_mmap = IPA_NAT_EMU_SRAM_MMAP_OFFSET;
+	info->best_nat_in_sram_size_rqst = emu_sram_mmap_size();
+
+	return 0;
+}
+
+static int emu_ioctl_locked(
+	unsigned long req,
+	void*         arg)
+{
+	switch ( req )
+	{
+	case IPA_IOC_GET_HW_VERSION:
+		*(enum ipa_hw_type*) arg = IPA_NAT_EMU_HW_VER;
+		return 0;
+
+	case IPA_IOC_GET_NAT_IN_SRAM_INFO:
+		return emu_sram_info(arg);
+
+	case IPA_IOC_ALLOC_NAT_TABLE:
+		return emu_alloc_nat(arg);
+
+	case IPA_IOC_DEL_NAT_TABLE:
+		return emu_del_nat(arg);
+
+	case IPA_IOC_ALLOC_IPV6CT_TABLE:
+		((struct ipa_ioc_nat_ipv6ct_table_alloc*) arg)->offset = 0;
+		return emu_table_alloc(
+			&emu.ipv6ct,
+			((struct ipa_ioc_nat_ipv6ct_table_alloc*) arg)->size,
+			false);
+
+	case IPA_IOC_DEL_IPV6CT_TABLE:
+		if ( ((struct ipa_ioc_nat_ipv6ct_table_del*) arg)->table_index != 0 )
+			return -EINVAL;
+		return emu_table_free(&emu.ipv6ct);
+
+	case IPA_IOC_V4_INIT_NAT:
+		return emu_init_nat(arg);
+
+	case IPA_IOC_INIT_IPV6CT_TABLE:
+		return emu_init_ipv6ct(arg);
+
+	case IPA_IOC_TABLE_DMA_CMD:
+		return emu_dma(arg);
+
+	case IPA_IOC_NAT_MODIFY_PDN:
+		return emu_modify_pdn(arg);
+
+	case IPA_IOC_APP_CLOCK_VOTE:
+		return ( (uintptr_t) arg <= IPA_APP_CLK_RESET_VOTE ) ? 0 : -EINVAL;
+
+	case IPA_IOC_ADD_UC_ACT_ENTRY:
+	case IPA_IOC_DEL_UC_ACT_ENTRY:
+		return 0;
+
+	default:
+		break;
+	}
+
+	return -ENOTTY;
+}
+
+static int emu_open(
+	const char* path,
+	int         flags)
+{
+	const char*  dev_dir = "/dev/";
+	emu_dev_type type    = EMU_DEV_NONE;
+	int          ret     = -1;
+	int          i;
+
+	(void) flags;
+
+	if ( strcmp(path, IPA_DEV_NAME) == 0 )
+	{
+		type = EMU_DEV_IPA;
+	}
+	else if ( strncmp(path, dev_dir, strlen(dev_dir)) == 0 )
+	{
+		if ( strcmp(path + strlen(dev_dir), IPA_NAT_DEV_NAME) == 0 )
+			type = EMU_DEV_NAT;
+		else if ( strcmp(path + strlen(dev_dir), IPA_IPV6CT_DEV_NAME) == 0 )
+			type = EMU_DEV_IPV6CT;
+	}
+
+	if ( type == EMU_DEV_NONE )
+	{
+		errno = ENOENT;
+		return -1;
+	}
+
+	pthread_mutex_lock(&emu.lock);
+
+	emu_configure();
+
+	for ( i = 0; i < IPA_NAT_EMU_MAX_FDS; i++ )
+	{
+		if ( emu.fds[i] == EMU_DEV_NONE )
+		{
+			emu.fds[i] = type;
+			ret = IPA_NAT_EMU_FD_BASE + i;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&emu.lock);
+
+	if ( ret < 0 )
+		errno = EMFILE;
+
+	return ret;
+}
+
+static int emu_close(
+	int fd)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&emu.lock);
+
+	if ( emu_fd_type(fd) == EMU_DEV_NONE )
+	{
+		errno = EBADF;
+		ret = -1;
+	}
+	else
+	{
+		emu.fds[fd - IPA_NAT_EMU_FD_BASE] = EMU_DEV_NONE;
+	}
+
+	pthread_mutex_unlock(&emu.lock);
+
+	return ret;
+}
+
+static int emu_ioctl(
+	int           fd,
+	unsigned long req,
+	void*         arg)
+{
+	int ret;
+
+	pthread_mutex_lock(&emu.lock);
+
+	emu.stats.ioctls++;
+
+	if ( emu_fd_type(fd) != EMU_DEV_IPA )
+		ret = -ENOTTY;
+	else
+		ret = emu_ioctl_locked(req, arg);
+
+	pthread_mutex_unlock(&emu.lock);
+
+	if ( ret )
+	{
+		errno = -ret;
+		ret = -1;
+	}
+
+	return ret;
+}
+
+static void* emu_mmap(
+	size_t len,
+	int    fd)
+{
+	emu_table* tbl;
+	void*      addr = MAP_FAILED;
+
+	pthread_mutex_lock(&emu.lock);
+
+	switch ( emu_fd_type(fd) )
+	{
+	case EMU_DEV_NAT:
+		tbl = &emu.nat[emu.nat_last_alloc];
+		break;
+	case EMU_DEV_IPV6CT:
+		tbl = &emu.ipv6ct;
+		break;
+	default:
+		errno = EBADF;
+		goto unlock;
+	}
+
+	/*
+	 * Like the driver, only one mapping per allocation...
+	 */
+	if ( ! tbl->mem || tbl->mapped || len > tbl->mem_size )
+	{
+		errno = EINVAL;
+		goto unlock;
+	}
+
+	tbl->mapped = true;
+	addr = tbl->mem;
+
+unlock:
+	pthread_mutex_unlock(&emu.lock);
+
+	return addr;
+}
+
+static int emu_munmap(
+	void*  addr,
+	size_t len)
+{
+	emu_table* tbls[] = {
+		&emu.nat[IPA_NAT_MEM_IN_DDR],
+		&emu.nat[IPA_NAT_MEM_IN_SRAM],
+		&emu.ipv6ct,
+	};
+	uint32_t i;
+	int ret = -1;
+
+	(void) len;
+
+	pthread_mutex_lock(&emu.lock);
+
+	/*
+	 * The memory stays with the table until it is deleted...
+	 */
+	for ( i = 0; i < sizeof(tbls) / sizeof(tbls[0]); i++ )
+	{
+		if ( tbls[i]->mem && tbls[i]->mem == addr && tbls[i]->mapped )
+		{
+			tbls[i]->mapped = false;
+			ret = 0;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&emu.lock);
+
+	if ( ret )
+		errno = EINVAL;
+
+	return ret;
+}
+
+const ipa_nat_backend ipa_nat_emu_backend =
+{
+	.name      = "emu",
+	.open_fn   = emu_open,
+	.close_fn  = emu_close,
+	.ioctl_fn  = emu_ioctl,
+	.mmap_fn   = emu_mmap,
+	.munmap_fn = emu_munmap,
+};
+
+void ipa_nat_emu_get_stats(
+	ipa_nat_emu_stats* stats)
+{
+	pthread_mutex_lock(&emu.lock);
+
+	*stats = emu.stats;
+
+	pthread_mutex_unlock(&emu.lock);
+}
+
+void ipa_nat_emu_reset_stats(void)
+{
+	pthread_mutex_lock(&emu.lock);
+
+	memset(&emu.stats, 0, sizeof(emu.stats));
+
+	pthread_mutex_unlock(&emu.lock);
+}
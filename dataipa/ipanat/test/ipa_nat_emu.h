@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef IPA_NAT_EMU_H
+#define IPA_NAT_EMU_H
+
+#include "ipa_nat_utils.h"
+
+/*
+ * User space emulation of the IPA driver's NAT and IPv6CT table
+ * handling, see ipa_nat_emu.c.  It is only built into the tests and
+ * benchmarks, which plug it in with ipa_nat_set_backend().
+ * ipanattest does so when IPA_NAT_BACKEND is set to "emu".
+ */
+#define IPA_NAT_BACKEND_ENV "IPA_NAT_BACKEND"
+
+extern const ipa_nat_backend ipa_nat_emu_backend;
+
+/*
+ * Counters kept by the emulated backend, so that benchmarks can
+ * report the kernel traffic generated by the table operations.
+ */
+typedef struct
+{
+	uint64_t ioctls;
+	uint64_t dma_cmds;
+	uint64_t dma_entries;
+	uint64_t dma_errors;
+	uint64_t table_allocs;
+	uint64_t table_inits;
+} ipa_nat_emu_stats;
+
+void ipa_nat_emu_get_stats(
+	ipa_nat_emu_stats* stats);
+
+void ipa_nat_emu_reset_stats(void);
+
+#endif /* IPA_NAT_EMU_H */
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_emu_bench.c
+
+	@brief
+	Times the NAT API on the emulated IPA backend (see ipa_nat_emu.c),
+	so no /dev/ipa is needed: rule adds, time stamp queries, rule
+	deletes and, for a HYBRID table, moving the rules between SRAM
+	and DDR.  The DMA traffic each operation generates is taken from
+	the emulator's counters.
+
+	ipa_nat_emu_bench [-m mt] [-e N] [-r N] [-i N] [-s seed]
+	  -m mt  DDR, SRAM or HYBRID (default HYBRID)
+	  -e N   entries requested for the table (default 2000)
+	  -r N   rules to add (default 512)
+	  -i N   SRAM->DDR->SRAM round trips timed (default 20)
+
+	IPA_NAT_EMU_DMA_DELAY_NS can be set to charge each DMA command
+	with the time it takes on target.
+*/
+/*===========================================================================*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_emu.h"
+
+#define BENCH_PUBLIC_IP 0xC0A80101
+
+typedef struct
+{
+	const char*       name;
+	uint32_t          ops;
+	double            secs;
+	ipa_nat_emu_stats stats;
+} bench_phase;
+
+static double now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void phase_start(
+	bench_phase* phase,
+	const char*  name )
+{
+	memset(phase, 0, sizeof(*phase));
+
+	phase->name = name;
+
+	ipa_nat_emu_reset_stats();
+
+	phase->secs = now_secs();
+}
+
+static void phase_end(
+	bench_phase* phase,
+	uint32_t     ops )
+{
+	phase->secs = now_secs() - phase->secs;
+	phase->ops  = ops;
+
+	ipa_nat_emu_get_stats(&phase->stats);
+}
+
+static void phase_print(
+	const bench_phase* phase )
+{
+	uint32_t ops = ( phase->ops ) ? phase->ops : 1;
+
+	printf("%-10s %8u %12.0f %10.2f %10.2f %8llu\n",
+		   phase->name,
+		   phase->ops,
+		   phase->secs * 1e9 / ops,
+		   (double) phase->stats.dma_cmds / ops,
+		   (double) phase->stats.dma_entries / ops,
+		   (unsigned long long) phase->stats.dma_errors);
+}
+
+/*
+ * The rules the table holds must be exactly the ones added and not
+ * yet deleted.
+ */
+static int bench_check(
+	uint32_t tbl_hdl,
+	uint32_t live )
+{
+	ipa_nati_tbl_stats nstats, istats;
+	uint32_t           filled;
+
+	if ( ipa_nati_ipv4_tbl_stats(tbl_hdl, &nstats, &istats) )
+	{
+		fprintf(stderr, "unable to get table stats\n");
+		return -1;
+	}
+
+	filled = nstats.tot_base_ents_filled + nstats.tot_expn_ents_filled;
+
+	if ( filled != live )
+	{
+		fprintf(stderr, "%s table holds %u rules, expected %u\n",
+				ipa3_nat_mem_in_as_str(nstats.nmi), filled, live);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(
+	int   argc,
+	char* argv[] )
+{
+	const char*        mem_type = "HYBRID";
+	uint32_t           entries  = 2000;
+	uint32_t           rules    = 512;
+	uint32_t           iters    = 20;
+	uint32_t           seed     = 1;
+	uint32_t           tbl_hdl  = 0;
+	uint32_t*          rule_hdls;
+	uint32_t*          time_stamps;
+	uint32_t           i, live  = 0;
+	ipa_nat_ipv4_rule  rule;
+	ipa_nati_tbl_stats nstats, istats;
+	bench_phase        phase;
+	bool               hybrid;
+	int                c, ret   = 1;
+
+	while ( (c = getopt(argc, argv, "m:e:r:i:s:")) != -1 )
+	{
+		switch ( c )
+		{
+		case 'm': mem_type = optarg;       break;
+		case 'e': entries  = atoi(optarg); break;
+		case 'r': rules    = atoi(optarg); break;
+		case 'i': iters    = atoi(optarg); break;
+		case 's': seed     = atoi(optarg); break;
+		default:
+			fprintf(stderr,
+					"usage: %s [-m mt] [-e N] [-r N] [-i N] [-s seed]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+
+	hybrid = ( strcmp(mem_type, "HYBRID") == 0 );
+
+	srand(seed);
+
+	if ( ipa_nat_set_backend(&ipa_nat_emu_backend) )
+	{
+		return 1;
+	}
+
+	rule_hdls   = calloc(rules, sizeof(uint32_t));
+	time_stamps = calloc(rules, sizeof(uint32_t));
+
+	if ( ! rule_hdls || ! time_stamps )
+	{
+		return 1;
+	}
+
+	if ( ipa_nat_add_ipv4_tbl(BENCH_PUBLIC_IP, mem_type, entries, &tbl_hdl) )
+	{
+		fprintf(stderr, "unable to add a %s table of %u entries\n",
+				mem_type, entries);
+		return 1;
+	}
+
+	printf("%s table, %u entries requested, %u rules\n",
+		   mem_type, entries, rules);
+	printf("%-10s %8s %12s %10s %10s %8s\n",
+		   "phase", "ops", "ns/op", "dma/op", "writes/op", "dma_err");
+
+	phase_start(&phase, "add");
+
+	for ( i = 0; i < rules; i++ )
+	{
+		memset(&rule, 0, sizeof(rule));
+
+		rule.protocol     = (i & 1) ? IPPROTO_UDP : IPPROTO_TCP;
+		rule.private_ip   = 0x0A000000 | (rand() & 0xFFFF);
+		rule.private_port = rand() & 0xFFFF;
+		rule.target_ip    = rand();
+		rule.target_port  = rand() & 0xFFFF;
+		rule.public_port  = rand() & 0xFFFF;
+
+		if ( ipa_nat_add_ipv4_rule(tbl_hdl, &rule, &rule_hdls[live]) == 0 )
+		{
+			live++;
+		}
+	}
+
+	phase_end(&phase, rules);
+	phase_print(&phase);
+
+	if ( live != rules )
+	{
+		printf("%u of %u rules did not fit\n", rules - live, rules);
+	}
+
+	if ( bench_check(tbl_hdl, live) )
+	{
+		goto bail;
+	}
+
+	phase_start(&phase, "query");
+
+	for ( i = 0; i < live; i++ )
+	{
+		if ( ipa_nat_query_timestamp(tbl_hdl, rule_hdls[i], &time_stamps[i]) )
+		{
+			fprintf(stderr, "query of rule 0x%08X failed\n", rule_hdls[i]);
+			goto bail;
+		}
+	}
+
+	phase_end(&phase, live);
+	phase_print(&phase);
+
+	phase_start(&phase, "query_all");
+
+	if ( ipa_nat_query_timestamps(tbl_hdl, rule_hdls, time_stamps, live) !=
+		 (int) live )
+	{
+		fprintf(stderr, "bulk query failed\n");
+		goto bail;
+	}
+
+	phase_end(&phase, live);
+	phase_print(&phase);
+
+	if ( hybrid &&
+		 ( ipa_nati_ipv4_tbl_stats(tbl_hdl, &nstats, &istats) ||
+		   nstats.nmi != IPA_NAT_MEM_IN_SRAM ) )
+	{
+		printf("rules do not fit in SRAM, not timing table moves\n");
+	}
+	else if ( hybrid )
+	{
+		phase_start(&phase, "move");
+
+		for ( i = 0; i < iters; i++ )
+		{
+			if ( ipa_nat_switch_to(IPA_NAT_MEM_IN_DDR, false) ||
+				 ipa_nat_switch_to(IPA_NAT_MEM_IN_SRAM, false) )
+			{
+				fprintf(stderr, "table move %u failed\n", i);
+				goto bail;
+			}
+		}
+
+		/* two moves per round trip, each moving every live rule */
+		phase_end(&phase, 2 * iters);
+		phase_print(&phase);
+
+		if ( bench_check(tbl_hdl, live) )
+		{
+			goto bail;
+		}
+	}
+
+	phase_start(&phase, "delete");
+
+	for ( i = 0; i < live; i++ )
+	{
+		if ( ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdls[i]) )
+		{
+			fprintf(stderr, "delete of rule 0x%08X failed\n", rule_hdls[i]);
+			goto bail;
+		}
+	}
+
+	phase_end(&phase, live);
+	phase_print(&phase);
+
+	if ( bench_check(tbl_hdl, 0) )
+	{
+		goto bail;
+	}
+
+	ret = 0;
+
+bail:
+	if ( ipa_nat_del_ipv4_tbl(tbl_hdl) )
+	{
+		ret = 1;
+	}
+
+	free(rule_hdls);
+	free(time_stamps);
+
+	return ret;
+}
@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_table_bench.c
+
+	@brief
+	Insert/delete churn against an ipa_table that lives in plain
+	memory. The IPA's part (applying the dma commands the table
+	generates) is emulated here, so no /dev/ipa is needed.
+
+	ipa_table_bench [-e N] [-o N] [-s seed]
+	  -e N  entries requested for the table (default 5120)
+	  -o N  delete/insert pairs timed per fill level (default 200000)
+
+	Fill levels are expansion table occupancy, the part of the table
+	that collision inserts have to search.
+*/
+/*===========================================================================*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "ipa_table.h"
+
+typedef struct
+{
+	uint16_t enable;
+	uint16_t next_index;
+	uint16_t prev_index;
+	uint16_t key;
+} bench_rule;
+
+static int bench_is_valid(
+	void* entry )
+{
+	return ((bench_rule*) entry)->enable;
+}
+
+static uint16_t bench_get_next_index(
+	void* entry )
+{
+	return ((bench_rule*) entry)->next_index;
+}
+
+static uint16_t bench_get_prev_index(
+	void*    entry,
+	uint16_t entry_index,
+	void*    meta,
+	uint16_t base_table_size )
+{
+	return ((bench_rule*) entry)->prev_index;
+}
+
+static void bench_set_prev_index(
+	void*    entry,
+	uint16_t entry_index,
+	uint16_t prev_index,
+	void*    meta,
+	uint16_t base_table_size )
+{
+	((bench_rule*) entry)->prev_index = prev_index;
+}
+
+static int bench_head_insert(
+	void*     entry,
+	void*     user_data,
+	uint16_t* dma_command_data )
+{
+	bench_rule* rule = (bench_rule*) entry;
+
+	rule->key        = *(uint16_t*) user_data;
+	rule->next_index = 0;
+	rule->prev_index = 0;
+
+	/* enable is written by the (emulated) IPA */
+	*dma_command_data = 1;
+
+	return 0;
+}
+
+static int bench_tail_insert(
+	void* entry,
+	void* user_data )
+{
+	((bench_rule*) entry)->key = *(uint16_t*) user_data;
+
+	return 0;
+}
+
+static uint16_t bench_get_delete_head_dma_command_data(
+	void* head,
+	void* next_entry )
+{
+	return 1;
+}
+
+static ipa_table_entry_interface bench_interface =
+{
+	bench_is_valid,
+	bench_get_next_index,
+	bench_get_prev_index,
+	bench_set_prev_index,
+	bench_head_insert,
+	bench_tail_insert,
+	bench_get_delete_head_dma_command_data
+};
+
+typedef struct
+{
+	ipa_table                   table;
+	ipa_table_dma_cmd_helper    help[HELP_UPDATE_MAX];
+	struct ipa_ioc_nat_dma_cmd* cmd;
+
+	uint16_t*                   live;     /* occupied record indices */
+	uint16_t*                   live_pos; /* record index -> slot in live[] */
+	uint32_t                    num_live;
+
+	uint32_t                    collisions;
+	uint32_t                    failures;
+} bench_ctx;
+
+/*
+ * Do what the IPA does with the table's dma commands: write the
+ * 16 bit datum at the offset into the base or expansion table.
+ */
+static void apply_dma(
+	bench_ctx* ctx )
+{
+	uint8_t i;
+
+	for ( i = 0; i < ctx->cmd->entries; i++ )
+	{
+		struct ipa_ioc_nat_dma_one* dma = &ctx->cmd->dma[i];
+
+		uint8_t* base =
+			(dma->base_addr == IPA_NAT_EXPN_TBL) ?
+			ctx->table.expn_table_addr :
+			ctx->table.table_addr;
+
+		memcpy(base + dma->offset, &dma->data, sizeof(dma->data));
+	}
+
+	ctx->cmd->entries = 0;
+}
+
+static void live_add(
+	bench_ctx* ctx,
+	uint16_t   index )
+{
+	ctx->live_pos[index] = ctx->num_live;
+	ctx->live[ctx->num_live++] = index;
+}
+
+static void live_del(
+	bench_ctx* ctx,
+	uint16_t   index )
+{
+	uint32_t pos  = ctx->live_pos[index];
+	uint16_t last = ctx->live[--ctx->num_live];
+
+	ctx->live[pos]      = last;
+	ctx->live_pos[last] = pos;
+}
+
+static int bench_insert(
+	bench_ctx* ctx )
+{
+	uint16_t key, index;
+	bool     collide;
+
+	/*
+	 * With the expansion table full a collision can only fail, so
+	 * draw again as a new connection would
+	 */
+	do
+	{
+		key     = (uint16_t) rand();
+		index   = key & (ctx->table.table_entries - 1);
+		/* as in the driver's hashes, slot zero means no entry */
+		index   = (index) ? index : ctx->table.table_entries - 1;
+		collide = bench_is_valid(GOTO_REC(&ctx->table, index));
+	} while ( collide &&
+			  ctx->table.cur_expn_tbl_cnt == ctx->table.expn_table_entries );
+
+	if ( collide )
+	{
+		ctx->collisions++;
+	}
+
+	if ( ipa_table_add_entry(&ctx->table, &key, &index, NULL, ctx->cmd) )
+	{
+		ctx->cmd->entries = 0;
+		ctx->failures++;
+		return -1;
+	}
+
+	apply_dma(ctx);
+
+	live_add(ctx, index);
+
+	return 0;
+}
+
+/*
+ * Deletes a random record, skipping list heads that still have a
+ * tail (the NAT keeps those as dead heads rather than freeing them).
+ */
+static void bench_delete(
+	bench_ctx* ctx )
+{
+	ipa_table_iterator iterator;
+	uint16_t           index;
+
+	while ( 1 )
+	{
+		index = ctx->live[rand() % ctx->num_live];
+
+		if ( ipa_table_iterator_init(
+				 &iterator,
+				 &ctx->table,
+				 GOTO_REC(&ctx->table, index),
+				 index) )
+		{
+			fprintf(stderr, "iterator init failed at %u\n", index);
+			exit(1);
+		}
+
+		if ( ! ipa_table_iterator_is_head_with_tail(&iterator) )
+		{
+			break;
+		}
+	}
+
+	ipa_table_create_delete_command(&ctx->table, ctx->cmd, &iterator);
+
+	apply_dma(ctx);
+
+	ipa_table_delete_entry(&ctx->table, &iterator, 0);
+
+	live_del(ctx, index);
+}
+
+static double now_secs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Walks every chain and checks that the table's own counts agree
+ * with what is really enabled in memory.
+ */
+static int bench_check(
+	bench_ctx* ctx )
+{
+	ipa_table* t = &ctx->table;
+	uint32_t   i, base = 0, expn = 0;
+
+	for ( i = 0; i < t->tot_tbl_ents; i++ )
+	{
+		if ( bench_is_valid(GOTO_REC(t, i)) )
+		{
+			if ( i < t->table_entries )
+				base++;
+			else
+				expn++;
+		}
+	}
+
+	if ( base != t->cur_tbl_cnt || expn != t->cur_expn_tbl_cnt ||
+		 base + expn != ctx->num_live )
+	{
+		fprintf(stderr,
+				"mismatch: base %u/%u expn %u/%u live %u\n",
+				base, t->cur_tbl_cnt, expn, t->cur_expn_tbl_cnt,
+				ctx->num_live);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(
+	int   argc,
+	char* argv[] )
+{
+	/* expansion table occupancy to churn at, percent */
+	static const int fills[] = { 50, 75, 90, 98 };
+
+	bench_ctx ctx;
+	uint32_t  entries = IPA_TABLE_MAX_ENTRIES;
+	uint32_t  ops     = 200000;
+	uint32_t  seed    = 1;
+	uint32_t  i, f, target;
+	uint8_t*  mem;
+	double    start, secs;
+	int       c, size;
+
+	while ( (c = getopt(argc, argv, "e:o:s:")) != -1 )
+	{
+		switch ( c )
+		{
+		case 'e': entries = atoi(optarg); break;
+		case 'o': ops     = atoi(optarg); break;
+		case 's': seed    = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-e N] [-o N] [-s seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	srand(seed);
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ipa_table_init(
+		&ctx.table, "bench", IPA_NAT_MEM_IN_DDR,
+		sizeof(bench_rule), NULL, 0, &bench_interface);
+
+	if ( ipa_table_calculate_entries_num(&ctx.table, entries, IPA_NAT_MEM_IN_DDR) )
+	{
+		return 1;
+	}
+
+	size = ipa_table_calculate_size(&ctx.table);
+	mem  = calloc(1, size);
+
+	ctx.cmd      = calloc(1, sizeof(*ctx.cmd) + 8 * sizeof(struct ipa_ioc_nat_dma_one));
+	ctx.live     = calloc(ctx.table.tot_tbl_ents, sizeof(uint16_t));
+	ctx.live_pos = calloc(ctx.table.tot_tbl_ents, sizeof(uint16_t));
+
+	if ( ! mem || ! ctx.cmd || ! ctx.live || ! ctx.live_pos )
+	{
+		return 1;
+	}
+
+	ipa_table_calculate_addresses(&ctx.table, mem);
+	ipa_table_reset(&ctx.table);
+
+	ipa_table_dma_cmd_helper_init(
+		&ctx.help[HELP_UPDATE_HEAD], 0, IPA_NAT_BASE_TBL, IPA_NAT_EXPN_TBL,
+		offsetof(bench_rule, enable));
+	ipa_table_dma_cmd_helper_init(
+		&ctx.help[HELP_UPDATE_ENTRY], 0, IPA_NAT_BASE_TBL, IPA_NAT_EXPN_TBL,
+		offsetof(bench_rule, next_index));
+	ipa_table_dma_cmd_helper_init(
+		&ctx.help[HELP_DELETE_HEAD], 0, IPA_NAT_BASE_TBL, IPA_NAT_EXPN_TBL,
+		offsetof(bench_rule, key));
+
+	for ( i = 0; i < HELP_UPDATE_MAX; i++ )
+	{
+		ctx.table.dma_help[i] = &ctx.help[i];
+	}
+
+	printf("table: base %u expn %u\n",
+		   ctx.table.table_entries, ctx.table.expn_table_entries);
+	printf("%5s %8s %8s %10s %10s %12s\n",
+		   "expn%", "base", "expn", "collide%", "failed", "ns/pair");
+
+	for ( f = 0; f < sizeof(fills) / sizeof(fills[0]); f++ )
+	{
+		target = ctx.table.expn_table_entries * fills[f] / 100;
+
+		while ( ctx.table.cur_expn_tbl_cnt < target )
+		{
+			if ( bench_insert(&ctx) )
+			{
+				break;
+			}
+		}
+
+		ctx.collisions = 0;
+		ctx.failures   = 0;
+
+		start = now_secs();
+
+		for ( i = 0; i < ops; i++ )
+		{
+			bench_delete(&ctx);
+			bench_insert(&ctx);
+		}
+
+		secs = now_secs() - start;
+
+		printf("%4d%% %8u %8u %9.1f%% %10u %12.1f\n",
+			   fills[f],
+			   ctx.table.cur_tbl_cnt,
+			   ctx.table.cur_expn_tbl_cnt,
+			   100.0 * ctx.collisions / ops,
+			   ctx.failures,
+			   secs * 1e9 / ops);
+
+		if ( bench_check(&ctx) )
+		{
+			return 1;
+		}
+	}
+
+	free(ctx.live_pos);
+	free(ctx.live);
+	free(ctx.cmd);
+	free(mem);
+
+	return 0;
+}
@@ -39,6 +39,7 @@
 
 #include "ipa_nat_test.h"
 #include "ipa_nat_map.h"
+#include "ipa_nat_emu.h"
 
 #undef strcasesame
 #define strcasesame(x, y) \
@@ -384,8 +385,21 @@ int main(
 
 	int      c, ret;
 
+	char*    backend;
+
 	IPADBG("Testing user space nat driver\n");
 
+	backend = getenv(IPA_NAT_BACKEND_ENV);
+
+	if ( backend && strcmp(backend, ipa_nat_emu_backend.name) == 0 )
+	{
+		if ( ipa_nat_set_backend(&ipa_nat_emu_backend) )
+		{
+			fprintf(stderr, "Unable to use the %s backend\n", backend);
+			exit(1);
+		}
+	}
+
 	while ( (c = getopt(argc, argv, "dr:i:e:m:h:g:?")) != -1 )
 	{
 		switch (c)
@@ -218,6 +218,42 @@ class SDMCompInterface {
   virtual int ShowBuffer(Handle disp_hnd, BufferHandle *buf_handle, int32_t *retire_fence) = 0;
 
 
+  /*! @brief Method to queue a buffer to be rendered to display asynchronously
+
+    @details The buffer is committed to display by a composer thread, in the order it was queued,
+             and this call returns as soon as it is queued. It blocks only while the display has
+             as many buffers waiting to be committed as its queue depth
+             (vendor.display.sdm_comp_queue_depth, 2 by default). The buffer must not be
+             modified until DequeueBuffer() hands it back. Validation is skipped for frames that
+             only change the buffer, not its size, format, stride or crop.
+
+    @param[in] disp_hnd - pointer to display handle which was created during CreateDisplay()
+    @param[in] buf_handle - pointer to buffer handle which specifies the attributes of a buffer
+
+    @return Returns 0 on sucess otherwise errno. An error of an earlier asynchronous commit is
+            reported by the next QueueBuffer() or DequeueBuffer() call.
+  */
+  virtual int QueueBuffer(Handle disp_hnd, BufferHandle *buf_handle) = 0;
+
+
+  /*! @brief Method to get back a buffer queued with QueueBuffer() once it has been committed
+
+    @details Buffers are returned in the order they were queued, after display hw has released
+             them. If the release fence doesn't signal within timeout_ms it is returned in
+             consumer_fence_fd, which the client needs to wait on and close.
+
+    @param[in] disp_hnd - pointer to display handle which was created during CreateDisplay()
+    @param[out] buf_handle - populated with the buffer handle that was queued
+    @param[out] retire_fence - pointer to retire fence of the latest committed frame
+    @param[in] timeout_ms - time to wait for a buffer, -1 to wait until one is committed
+
+    @return Returns 0 on sucess, -ENOENT if no buffer is queued, -ETIMEDOUT if no buffer was
+            committed within timeout_ms otherwise errno
+  */
+  virtual int DequeueBuffer(Handle disp_hnd, BufferHandle *buf_handle, int32_t *retire_fence,
+                            int timeout_ms) = 0;
+
+
   /*! @brief Method to set color mode with render intent
 
     @param[in] disp_hnd - pointer to display handle which was created during CreateDisplay()
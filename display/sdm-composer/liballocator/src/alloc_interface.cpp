@@ -33,17 +33,36 @@
 #include "alloc_interface.h"
 #include "ion_alloc_impl.h"
 #include "dma_buf_alloc_impl.h"
+#include "buffer_pool_alloc_impl.h"
 
 #define __CLASS__ "AllocInterface"
 
 namespace sdm {
 
+static AllocInterface *alloc_intf_ = NULL;
+
 AllocInterface *AllocInterface::GetInstance() {
-  AllocInterface *alloc_intf = sdm::DmaBufAllocator::GetInstance();
-  if (alloc_intf == NULL) {
-    alloc_intf = IonAllocator::GetInstance();
+  if (alloc_intf_) {
+    return alloc_intf_;
+  }
+
+  AllocInterface *heap_intf = sdm::DmaBufAllocator::GetInstance();
+  if (heap_intf == NULL) {
+    heap_intf = IonAllocator::GetInstance();
+  }
+  if (heap_intf == NULL) {
+    return NULL;
   }
-  return alloc_intf;
+
+  BufferPoolConfig config = {};
+  BufferPoolAllocator::GetConfig(&config);
+  if (config.max_bytes) {
+    alloc_intf_ = new BufferPoolAllocator(heap_intf, config);
+  } else {
+    alloc_intf_ = heap_intf;
+  }
+
+  return alloc_intf_;
 }
 
 }  // namespace sdm
@@ -0,0 +1,379 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utils/constants.h>
+
+#include <chrono>
+
+#include "debug_handler.h"
+#include "buffer_pool_alloc_impl.h"
+
+#define DEBUG 0
+#define __CLASS__ "BufferPoolAllocator"
+
+// Defaults, overridden by the vendor.display.alloc_pool_* properties
+#define DEFAULT_POOL_KB (32 * 1024)
+#define DEFAULT_POOL_IDLE_MS 2000
+
+namespace sdm {
+
+static int64_t GetTimeMs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+bool BufferPoolAllocator::PoolKey::operator==(const PoolKey &other) const {
+  return (size == other.size && format == other.format && width == other.width &&
+          height == other.height && uncached == other.uncached &&
+          usage_hints == other.usage_hints);
+}
+
+void BufferPoolAllocator::GetConfig(BufferPoolConfig *config) {
+  int value = 0;
+
+  config->max_bytes = UINT64(DEFAULT_POOL_KB) * 1024;
+  config->idle_ms = DEFAULT_POOL_IDLE_MS;
+  config->zero_buffers = false;
+
+  if (!display::DebugHandler::Get()->GetProperty("vendor.display.alloc_pool_kb", &value) &&
+      value >= 0) {
+    config->max_bytes = UINT64(value) * 1024;
+  }
+  if (!display::DebugHandler::Get()->GetProperty("vendor.display.alloc_pool_idle_ms", &value) &&
+      value >= 0) {
+    config->idle_ms = UINT32(value);
+  }
+  value = 0;
+  if (!display::DebugHandler::Get()->GetProperty("vendor.display.alloc_pool_zero", &value)) {
+    config->zero_buffers = (value != 0);
+  }
+}
+
+BufferPoolAllocator::BufferPoolAllocator(AllocInterface *heap_intf,
+                                         const BufferPoolConfig &config)
+    : heap_intf_(heap_intf), config_(config) {
+  DLOGI("Buffer pool of %llu KB, idle timeout %u ms, zeroing %s",
+        static_cast<unsigned long long>(config_.max_bytes / 1024), config_.idle_ms,
+        config_.zero_buffers ? "on" : "off");
+  if (config_.max_bytes && (config_.idle_ms || config_.zero_buffers)) {
+    pool_thread_ = std::thread(&BufferPoolAllocator::PoolThread, this);
+  }
+}
+
+BufferPoolAllocator::~BufferPoolAllocator() {
+  {
+    std::lock_guard<std::mutex> lock(pool_lock_);
+    pool_thread_exit_ = true;
+    pool_cv_.notify_all();
+  }
+  if (pool_thread_.joinable()) {
+    pool_thread_.join();
+  }
+  Trim(0);
+}
+
+BufferPoolAllocator::PoolKey BufferPoolAllocator::GetKey(const AllocData &data) {
+  PoolKey key = {};
+  key.width = data.width;
+  key.height = data.height;
+  key.format = data.format;
+  key.size = data.size;
+  key.uncached = data.uncached;
+  key.usage_hints = data.usage_hints.hints;
+  return key;
+}
+
+int BufferPoolAllocator::AllocBuffer(AllocData *data, BufferHandle *buffer_handle) {
+  if (!data || !buffer_handle) {
+    DLOGE("Invalid parameter data %p buffer_handle %p", data, buffer_handle);
+    return -EINVAL;
+  }
+
+  PoolKey key = GetKey(*data);
+  bool found = false;
+  bool needs_zero = false;
+  {
+    std::lock_guard<std::mutex> lock(pool_lock_);
+    // Prefer a buffer the pool thread has already cleared
+    auto match = free_list_.end();
+    for (auto it = free_list_.begin(); it != free_list_.end(); it++) {
+      if (it->busy || !(it->key == key)) {
+        continue;
+      }
+      if (match == free_list_.end() || (match->dirty && !it->dirty)) {
+        match = it;
+      }
+      if (!it->dirty) {
+        break;
+      }
+    }
+
+    if (match != free_list_.end()) {
+      *buffer_handle = match->handle;
+      needs_zero = match->dirty;
+      stats_.bytes_held -= match->handle.size;
+      stats_.buffers_held--;
+      stats_.hits++;
+      allocated_[buffer_handle->buffer_id] = key;
+      free_list_.erase(match);
+      found = true;
+    }
+  }
+
+  if (found) {
+    if (needs_zero && ZeroBuffer(buffer_handle) != 0) {
+      DLOGW("Failed to clear pooled buffer fd %d, allocating a new one", buffer_handle->fd);
+      {
+        std::lock_guard<std::mutex> lock(pool_lock_);
+        allocated_.erase(buffer_handle->buffer_id);
+        stats_.hits--;
+      }
+      heap_intf_->FreeBuffer(buffer_handle);
+    } else {
+      DLOGD_IF(DEBUG, "Pooled buffer WxHxF %dx%dx%d size %u fd %d", data->width, data->height,
+               data->format, buffer_handle->size, buffer_handle->fd);
+      return 0;
+    }
+  }
+
+  int err = heap_intf_->AllocBuffer(data, buffer_handle);
+  if (err != 0) {
+    // The heap may be short of memory the pool holds on to
+    bool retry = false;
+    {
+      std::lock_guard<std::mutex> lock(pool_lock_);
+      if (stats_.buffers_held) {
+        TrimLocked(0, &stats_.evicted);
+        retry = true;
+      }
+    }
+    if (retry) {
+      err = heap_intf_->AllocBuffer(data, buffer_handle);
+    }
+    if (err != 0) {
+      return err;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(pool_lock_);
+  stats_.misses++;
+  allocated_[buffer_handle->buffer_id] = key;
+
+  return 0;
+}
+
+int BufferPoolAllocator::FreeBuffer(BufferHandle *buffer_handle) {
+  if (!buffer_handle) {
+    return -EINVAL;
+  }
+
+  std::unique_lock<std::mutex> lock(pool_lock_);
+  auto it = allocated_.find(buffer_handle->buffer_id);
+  if (it == allocated_.end()) {
+    // Cloned or not allocated through the pool
+    lock.unlock();
+    return heap_intf_->FreeBuffer(buffer_handle);
+  }
+
+  PoolEntry entry = {};
+  entry.key = it->second;
+  allocated_.erase(it);
+  if (buffer_handle->size > config_.max_bytes) {
+    stats_.released++;
+    lock.unlock();
+    return heap_intf_->FreeBuffer(buffer_handle);
+  }
+
+  entry.handle = *buffer_handle;
+  entry.handle.producer_fence_fd = -1;
+  entry.handle.consumer_fence_fd = -1;
+  entry.freed_ms = GetTimeMs();
+  entry.dirty = config_.zero_buffers;
+  entry.busy = false;
+  free_list_.push_front(entry);
+  stats_.recycled++;
+  stats_.buffers_held++;
+  stats_.bytes_held += entry.handle.size;
+  TrimLocked(config_.max_bytes, &stats_.evicted);
+  if (stats_.bytes_held > stats_.peak_bytes_held) {
+    stats_.peak_bytes_held = stats_.bytes_held;
+  }
+  pool_cv_.notify_all();
+
+  return 0;
+}
+
+int BufferPoolAllocator::MapBuffer(int fd, unsigned int size, void **base) {
+  return heap_intf_->MapBuffer(fd, size, base);
+}
+
+int BufferPoolAllocator::UnmapBuffer(void *base, unsigned int size) {
+  return heap_intf_->UnmapBuffer(base, size);
+}
+
+int BufferPoolAllocator::SyncBuffer(CacheOp op, int fd) {
+  return heap_intf_->SyncBuffer(op, fd);
+}
+
+int BufferPoolAllocator::CloneBuffer(const CloneData &data, BufferHandle *buffer_handle) {
+  return heap_intf_->CloneBuffer(data, buffer_handle);
+}
+
+void BufferPoolAllocator::Trim(uint64_t max_bytes) {
+  std::lock_guard<std::mutex> lock(pool_lock_);
+  TrimLocked(max_bytes, &stats_.evicted);
+}
+
+// Releases the least recently freed buffers first. Called with pool_lock_ held.
+void BufferPoolAllocator::TrimLocked(uint64_t max_bytes, uint64_t *counter) {
+  auto it = free_list_.end();
+  while (stats_.bytes_held > max_bytes && it != free_list_.begin()) {
+    it--;
+    if (it->busy) {
+      continue;
+    }
+    stats_.bytes_held -= it->handle.size;
+    stats_.buffers_held--;
+    (*counter)++;
+    heap_intf_->FreeBuffer(&it->handle);
+    it = free_list_.erase(it);
+  }
+}
+
+int BufferPoolAllocator::ZeroBuffer(BufferHandle *buffer_handle) {
+  void *base = nullptr;
+  int err = heap_intf_->MapBuffer(buffer_handle->fd, buffer_handle->size, &base);
+  if (err != 0) {
+    return err;
+  }
+
+  if (!buffer_handle->uncached) {
+    heap_intf_->SyncBuffer(kCacheWriteStart, buffer_handle->fd);
+  }
+  memset(base, 0, buffer_handle->size);
+  if (!buffer_handle->uncached) {
+    heap_intf_->SyncBuffer(kCacheWriteDone, buffer_handle->fd);
+  }
+  heap_intf_->UnmapBuffer(base, buffer_handle->size);
+
+  std::lock_guard<std::mutex> lock(pool_lock_);
+  stats_.zeroed++;
+
+  return 0;
+}
+
+// Clears recycled buffers ahead of their reuse and releases the ones left idle
+void BufferPoolAllocator::PoolThread() {
+  std::unique_lock<std::mutex> lock(pool_lock_);
+  while (!pool_thread_exit_) {
+    auto dirty = free_list_.end();
+    if (config_.zero_buffers) {
+      for (auto it = free_list_.begin(); it != free_list_.end(); it++) {
+        if (it->dirty && !it->busy) {
+          dirty = it;
+          break;
+        }
+      }
+    }
+
+    if (dirty != free_list_.end()) {
+      // Busy entries stay in the list, the iterator remains valid
+      dirty->busy = true;
+      BufferHandle handle = dirty->handle;
+      lock.unlock();
+      int err = ZeroBuffer(&handle);
+      lock.lock();
+      dirty->busy = false;
+      if (err != 0) {
+        DLOGW("Failed to clear pooled buffer fd %d, releasing it", handle.fd);
+        stats_.bytes_held -= handle.size;
+        stats_.buffers_held--;
+        stats_.evicted++;
+        heap_intf_->FreeBuffer(&handle);
+        free_list_.erase(dirty);
+      } else {
+        dirty->dirty = false;
+      }
+      continue;
+    }
+
+    if (config_.idle_ms && !free_list_.empty()) {
+      int64_t now = GetTimeMs();
+      while (!free_list_.empty() && !free_list_.back().busy &&
+             (now - free_list_.back().freed_ms) >= config_.idle_ms) {
+        PoolEntry &entry = free_list_.back();
+        stats_.bytes_held -= entry.handle.size;
+        stats_.buffers_held--;
+        stats_.trimmed++;
+        heap_intf_->FreeBuffer(&entry.handle);
+        free_list_.pop_back();
+      }
+      if (!free_list_.empty()) {
+        int64_t wait_ms = free_list_.back().freed_ms + config_.idle_ms - now;
+        pool_cv_.wait_for(lock, std::chrono::milliseconds(wait_ms > 0 ? wait_ms : 1));
+        continue;
+      }
+    }
+
+    pool_cv_.wait(lock);
+  }
+}
+
+void BufferPoolAllocator::GetStats(BufferPoolStats *stats) {
+  std::lock_guard<std::mutex> lock(pool_lock_);
+  *stats = stats_;
+}
+
+void BufferPoolAllocator::DumpStats() {
+  BufferPoolStats stats;
+  GetStats(&stats);
+  DLOGI("hits %llu misses %llu, recycled %llu released %llu evicted %llu trimmed %llu "
+        "zeroed %llu, holding %u buffers %llu KB (peak %llu KB)",
+        static_cast<unsigned long long>(stats.hits),
+        static_cast<unsigned long long>(stats.misses),
+        static_cast<unsigned long long>(stats.recycled),
+        static_cast<unsigned long long>(stats.released),
+        static_cast<unsigned long long>(stats.evicted),
+        static_cast<unsigned long long>(stats.trimmed),
+        static_cast<unsigned long long>(stats.zeroed), stats.buffers_held,
+        static_cast<unsigned long long>(stats.bytes_held / 1024),
+        static_cast<unsigned long long>(stats.peak_bytes_held / 1024));
+}
+
+}  // namespace sdm
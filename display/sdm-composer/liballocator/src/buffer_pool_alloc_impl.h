@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __BUFFER_POOL_ALLOC_IMPL_H__
+#define __BUFFER_POOL_ALLOC_IMPL_H__
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "alloc_interface.h"
+
+namespace sdm {
+
+struct BufferPoolConfig {
+  uint64_t max_bytes = 0;       //!< Memory the pool may hold on to, 0 disables pooling
+  uint32_t idle_ms = 0;         //!< Free buffers unused for this long are released, 0 never
+  bool zero_buffers = false;    //!< Clear recycled buffers on the pool thread before reuse
+};
+
+struct BufferPoolStats {
+  uint64_t hits = 0;            //!< Allocations served from the pool
+  uint64_t misses = 0;          //!< Allocations that went to the heap
+  uint64_t recycled = 0;        //!< Frees kept in the pool
+  uint64_t released = 0;        //!< Frees that went to the heap, over the cap or not pooled
+  uint64_t evicted = 0;         //!< Pooled buffers released to stay under the cap
+  uint64_t trimmed = 0;         //!< Pooled buffers released after being idle
+  uint64_t zeroed = 0;          //!< Buffers cleared before reuse
+  uint64_t bytes_held = 0;      //!< Memory currently held by free buffers
+  uint64_t peak_bytes_held = 0;
+  uint32_t buffers_held = 0;
+};
+
+// Keeps freed buffers, bucketed by their allocation parameters, for the next allocation with the
+// same parameters instead of going back to the heap. Everything else is passed to the heap
+// allocator underneath. Recycled buffers keep their previous contents unless zero_buffers is set.
+class BufferPoolAllocator : public AllocInterface {
+ public:
+  BufferPoolAllocator(AllocInterface *heap_intf, const BufferPoolConfig &config);
+  ~BufferPoolAllocator();
+
+  virtual int AllocBuffer(AllocData *data, BufferHandle *buffer_handle);
+  virtual int FreeBuffer(BufferHandle *buffer_handle);
+  virtual int MapBuffer(int fd, unsigned int size, void **base);
+  virtual int UnmapBuffer(void *base, unsigned int size);
+  virtual int SyncBuffer(CacheOp op, int fd);
+  virtual int CloneBuffer(const CloneData &data, BufferHandle *buffer_handle);
+
+  //! Releases pooled buffers until at most max_bytes are held
+  void Trim(uint64_t max_bytes);
+  void GetStats(BufferPoolStats *stats);
+  void DumpStats();
+
+  //! Pool configuration from vendor.display.alloc_pool_* properties
+  static void GetConfig(BufferPoolConfig *config);
+
+ private:
+  struct PoolKey {
+    uint32_t width;
+    uint32_t height;
+    BufferFormat format;
+    uint32_t size;
+    bool uncached;
+    uint64_t usage_hints;
+    bool operator==(const PoolKey &other) const;
+  };
+
+  struct PoolEntry {
+    PoolKey key;
+    BufferHandle handle;
+    int64_t freed_ms;
+    bool dirty;                 // needs zeroing before reuse
+    bool busy;                  // being zeroed by the pool thread
+  };
+
+  static PoolKey GetKey(const AllocData &data);
+  int ZeroBuffer(BufferHandle *buffer_handle);
+  void TrimLocked(uint64_t max_bytes, uint64_t *counter);
+  void PoolThread();
+
+  AllocInterface *heap_intf_ = nullptr;
+  BufferPoolConfig config_ = {};
+  std::mutex pool_lock_;
+  std::condition_variable pool_cv_;
+  std::list<PoolEntry> free_list_ = {};     // most recently freed first
+  std::map<int64_t, PoolKey> allocated_ = {};  // buffer_id -> key, buffers handed out by us
+  BufferPoolStats stats_ = {};
+  std::thread pool_thread_;
+  bool pool_thread_exit_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __BUFFER_POOL_ALLOC_IMPL_H__
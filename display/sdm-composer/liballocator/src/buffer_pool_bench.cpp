@@ -0,0 +1,157 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Allocate/free churn through liballocator, straight to the heap and through the buffer pool.
+// Each round allocates, maps and frees the buffers of a display mode, cycling through the modes
+// the way a client does on resolution changes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "alloc_interface.h"
+#include "dma_buf_alloc_impl.h"
+#include "ion_alloc_impl.h"
+#include "buffer_pool_alloc_impl.h"
+
+using sdm::AllocData;
+using sdm::AllocInterface;
+using sdm::BufferHandle;
+using sdm::BufferPoolAllocator;
+using sdm::BufferPoolConfig;
+using sdm::BufferPoolStats;
+
+#define BUFFERS_PER_MODE 3
+
+struct Mode {
+  uint32_t width;
+  uint32_t height;
+};
+
+static const Mode modes[] = { {1080, 2400}, {720, 1600}, {1080, 2400}, {1440, 3200} };
+
+static int64_t GetTimeNs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int RunChurn(AllocInterface *alloc_intf, int rounds, bool trusted_ui, int64_t *ns) {
+  BufferHandle buffers[BUFFERS_PER_MODE];
+  int64_t start = GetTimeNs();
+
+  for (int round = 0; round < rounds; round++) {
+    const Mode &mode = modes[round % (sizeof(modes) / sizeof(modes[0]))];
+    for (int i = 0; i < BUFFERS_PER_MODE; i++) {
+      AllocData data = {};
+      data.width = mode.width;
+      data.height = mode.height;
+      data.format = sdm::kBufferFormatRGBA8888;
+      data.uncached = true;
+      data.usage_hints.trusted_ui = trusted_ui;
+      buffers[i] = BufferHandle();
+      int err = alloc_intf->AllocBuffer(&data, &buffers[i]);
+      if (err != 0) {
+        printf("allocation of %ux%u failed: %d\n", mode.width, mode.height, err);
+        return err;
+      }
+
+      void *base = NULL;
+      if (alloc_intf->MapBuffer(buffers[i].fd, buffers[i].size, &base) == 0) {
+        static_cast<volatile char *>(base)[0] = 1;
+        alloc_intf->UnmapBuffer(base, buffers[i].size);
+      }
+    }
+    for (int i = 0; i < BUFFERS_PER_MODE; i++) {
+      alloc_intf->FreeBuffer(&buffers[i]);
+    }
+  }
+
+  *ns = GetTimeNs() - start;
+  return 0;
+}
+
+static void Report(const char *name, int rounds, int64_t ns) {
+  printf("%-16s %8lld ns per buffer\n", name,
+         static_cast<long long>(ns / (rounds * BUFFERS_PER_MODE)));
+}
+
+static void ReportPool(BufferPoolAllocator *pool) {
+  BufferPoolStats stats;
+  pool->GetStats(&stats);
+  printf("%16s hits %llu misses %llu evicted %llu zeroed %llu, peak %llu KB\n", "",
+         static_cast<unsigned long long>(stats.hits),
+         static_cast<unsigned long long>(stats.misses),
+         static_cast<unsigned long long>(stats.evicted),
+         static_cast<unsigned long long>(stats.zeroed),
+         static_cast<unsigned long long>(stats.peak_bytes_held / 1024));
+}
+
+int main(int argc, char **argv) {
+  int rounds = (argc > 1) ? atoi(argv[1]) : 200;
+  bool trusted_ui = (argc > 2) ? (atoi(argv[2]) != 0) : true;
+  int64_t ns = 0;
+
+  AllocInterface *heap_intf = sdm::DmaBufAllocator::GetInstance();
+  if (heap_intf == NULL) {
+    heap_intf = sdm::IonAllocator::GetInstance();
+  }
+  if (heap_intf == NULL || rounds <= 0) {
+    printf("usage: %s [rounds] [trusted_ui], with a dma-buf or ion heap\n", argv[0]);
+    return 1;
+  }
+
+  if (RunChurn(heap_intf, rounds, trusted_ui, &ns)) {
+    return 1;
+  }
+  Report("heap", rounds, ns);
+
+  BufferPoolConfig config = {};
+  BufferPoolAllocator::GetConfig(&config);
+  config.max_bytes = 128ULL * 1024 * 1024;
+  config.idle_ms = 0;
+  for (int zero = 0; zero < 2; zero++) {
+    config.zero_buffers = zero;
+    BufferPoolAllocator *pool = new BufferPoolAllocator(heap_intf, config);
+    if (RunChurn(pool, rounds, trusted_ui, &ns)) {
+      delete pool;
+      return 1;
+    }
+    Report(zero ? "pool, zeroing" : "pool", rounds, ns);
+    ReportPool(pool);
+    delete pool;
+  }
+
+  return 0;
+}
@@ -58,7 +58,7 @@ inline Type ALIGN(Type x, Type align) {
 
 DmaBufAllocator* DmaBufAllocator::dma_buf_allocator_ = NULL;
 BufferAllocator DmaBufAllocator::buffer_allocator_ = {};
-int64_t DmaBufAllocator::id_ = -1;
+std::atomic<int64_t> DmaBufAllocator::id_(-1);
 
 DmaBufAllocator *DmaBufAllocator::GetInstance() {
   if (!dma_buf_allocator_) {
@@ -32,6 +32,8 @@
 
 #include <BufferAllocator/BufferAllocator.h>
 
+#include <atomic>
+
 #include "alloc_interface.h"
 
 namespace sdm {
@@ -57,7 +59,7 @@ class DmaBufAllocator : public AllocInterface {
 
   static DmaBufAllocator* dma_buf_allocator_;
   static BufferAllocator buffer_allocator_;
-  static int64_t id_;
+  static std::atomic<int64_t> id_;
 };
 
 }  // namespace sdm
@@ -59,7 +59,7 @@ inline Type ALIGN(Type x, Type align) {
 }
 
 IonAllocator* IonAllocator::ion_allocator_ = NULL;
-int64_t IonAllocator::id_ = -1;
+std::atomic<int64_t> IonAllocator::id_(-1);
 
 IonAllocator *IonAllocator::GetInstance() {
   if (!ion_allocator_) {
@@ -30,6 +30,8 @@
 #ifndef __ION_ALLOC_IMPL_H__
 #define __ION_ALLOC_IMPL_H__
 
+#include <atomic>
+
 #include "alloc_interface.h"
 
 namespace sdm {
@@ -57,7 +59,7 @@ class IonAllocator : public AllocInterface {
 
   int ion_dev_fd_ = -1;
   static IonAllocator* ion_allocator_;
-  static int64_t id_;
+  static std::atomic<int64_t> id_;
 };
 
 }  // namespace sdm
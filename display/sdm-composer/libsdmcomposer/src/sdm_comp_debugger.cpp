@@ -32,6 +32,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <time.h>
 #ifdef ANDROID
 #include <log/log.h>
 #endif
@@ -39,9 +40,14 @@
 #include "sdm_comp_debugger.h"
 #include <string>
 #include <cstring>
+#include <cinttypes>
+#include <algorithm>
 
 using std::string;
 
+// Frames between two periodic dumps of the frame statistics
+#define FRAME_STATS_DUMP_INTERVAL 600
+
 namespace sdm {
 
 SDMCompDebugHandler SDMCompDebugHandler::debug_handler_;
@@ -268,6 +274,72 @@ int  SDMCompDebugHandler::GetIdleTimeoutMs() {
   return IDLE_TIMEOUT_DEFAULT_MS;
 }
 
+void SDMCompDebugHandler::UpdateFrameStats(int32_t display_id, const SDMCompFrameTiming &timing) {
+  struct timespec now = {};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+  bool dump = false;
+
+  {
+    std::lock_guard<std::mutex> lock(debug_handler_.frame_stats_lock_);
+    SDMCompFrameStats &stats = debug_handler_.frame_stats_[display_id];
+
+    if (stats.last_commit_ns) {
+      uint64_t frame_us = UINT64(now_ns - stats.last_commit_ns) / 1000;
+      stats.frame_us_total += frame_us;
+      stats.frame_us_max = std::max(stats.frame_us_max, frame_us);
+    }
+    stats.last_commit_ns = now_ns;
+    stats.frames++;
+    stats.queue_us_total += timing.queue_us;
+    stats.queue_us_max = std::max(stats.queue_us_max, timing.queue_us);
+    stats.commit_us_total += timing.commit_us;
+    stats.commit_us_max = std::max(stats.commit_us_max, timing.commit_us);
+    if (timing.validated) {
+      stats.validated_frames++;
+      stats.prepare_us_total += timing.prepare_us;
+      stats.prepare_us_max = std::max(stats.prepare_us_max, timing.prepare_us);
+    }
+    dump = (stats.frames % FRAME_STATS_DUMP_INTERVAL) == 0;
+  }
+
+  if (dump && debug_handler_.verbose_level_) {
+    DumpFrameStats(display_id);
+  }
+}
+
+void SDMCompDebugHandler::GetFrameStats(int32_t display_id, SDMCompFrameStats *stats) {
+  std::lock_guard<std::mutex> lock(debug_handler_.frame_stats_lock_);
+  auto it = debug_handler_.frame_stats_.find(display_id);
+  *stats = (it != debug_handler_.frame_stats_.end()) ? it->second : SDMCompFrameStats();
+}
+
+void SDMCompDebugHandler::DumpFrameStats(int32_t display_id) {
+  SDMCompFrameStats stats;
+  GetFrameStats(display_id, &stats);
+  if (!stats.frames) {
+    return;
+  }
+
+  uint64_t intervals = (stats.frames > 1) ? stats.frames - 1 : 1;
+  uint64_t validated = stats.validated_frames ? stats.validated_frames : 1;
+  debug_handler_.Info("Display %d: %" PRIu64 " frames, %" PRIu64 " validated. "
+                      "frame avg %" PRIu64 " max %" PRIu64 " us, "
+                      "queue avg %" PRIu64 " max %" PRIu64 " us, "
+                      "prepare avg %" PRIu64 " max %" PRIu64 " us, "
+                      "commit avg %" PRIu64 " max %" PRIu64 " us", display_id,
+                      stats.frames, stats.validated_frames,
+                      stats.frame_us_total / intervals, stats.frame_us_max,
+                      stats.queue_us_total / stats.frames, stats.queue_us_max,
+                      stats.prepare_us_total / validated, stats.prepare_us_max,
+                      stats.commit_us_total / stats.frames, stats.commit_us_max);
+}
+
+void SDMCompDebugHandler::ResetFrameStats(int32_t display_id) {
+  std::lock_guard<std::mutex> lock(debug_handler_.frame_stats_lock_);
+  debug_handler_.frame_stats_.erase(display_id);
+}
+
 int SDMCompDebugHandler::GetProperty(const char *property_name, int *value) {
   if (!property_name || !value)
     return kErrorNotSupported;
@@ -40,11 +40,34 @@
 
 #include <bitset>
 #include <map>
+#include <mutex>
 
 namespace sdm {
 
 using display::DebugHandler;
 
+// Timing of one frame, as measured by the display that committed it.
+struct SDMCompFrameTiming {
+  uint64_t queue_us = 0;    // time spent in the submission queue
+  uint64_t prepare_us = 0;  // 0 when validation was skipped
+  uint64_t commit_us = 0;
+  bool validated = false;
+};
+
+struct SDMCompFrameStats {
+  uint64_t frames = 0;
+  uint64_t validated_frames = 0;
+  uint64_t frame_us_total = 0;     // interval between consecutive commits
+  uint64_t frame_us_max = 0;
+  uint64_t queue_us_total = 0;
+  uint64_t queue_us_max = 0;
+  uint64_t prepare_us_total = 0;
+  uint64_t prepare_us_max = 0;
+  uint64_t commit_us_total = 0;
+  uint64_t commit_us_max = 0;
+  int64_t last_commit_ns = 0;
+};
+
 class SDMCompDebugHandler : public DebugHandler {
  public:
   SDMCompDebugHandler();
@@ -63,6 +86,10 @@ class SDMCompDebugHandler : public DebugHandler {
   static void DebugDisplay(bool enable, int verbose_level);
   static void DebugAllocator(bool enable, int verbose_level);
   static int  GetIdleTimeoutMs();
+  static void UpdateFrameStats(int32_t display_id, const SDMCompFrameTiming &timing);
+  static void GetFrameStats(int32_t display_id, SDMCompFrameStats *stats);
+  static void DumpFrameStats(int32_t display_id);
+  static void ResetFrameStats(int32_t display_id);
 
   virtual void Error(const char *format, ...);
   virtual void Warning(const char *format, ...);
@@ -82,6 +109,8 @@ class SDMCompDebugHandler : public DebugHandler {
   int32_t verbose_level_;
   std::map<std::string, std::string> properties_map_;
   PropertyParserInterface *prop_parser_intf_ = nullptr;
+  std::mutex frame_stats_lock_;
+  std::map<int32_t, SDMCompFrameStats> frame_stats_;
 };
 
 }  // namespace sdm
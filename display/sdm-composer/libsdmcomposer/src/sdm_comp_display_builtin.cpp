@@ -30,6 +30,7 @@
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <errno.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "sdm_comp_display_builtin.h"
@@ -43,10 +44,17 @@
 
 namespace sdm {
 
+static int64_t GetTimeNs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 SDMCompDisplayBuiltIn::SDMCompDisplayBuiltIn(CoreInterface *core_intf,
-    CallbackInterface *callback, SDMCompDisplayType disp_type, int32_t disp_id)
+    SDMCompBufferSyncHandler *buffer_sync_handler, CallbackInterface *callback,
+    SDMCompDisplayType disp_type, int32_t disp_id)
     : core_intf_(core_intf), callback_(callback), display_type_(disp_type),
-      display_id_(disp_id) {
+      display_id_(disp_id), buffer_sync_handler_(buffer_sync_handler) {
 }
 
 int SDMCompDisplayBuiltIn::Init() {
@@ -84,6 +92,15 @@ int SDMCompDisplayBuiltIn::Init() {
 
   PopulateColorModes();
 
+  {
+    int queue_depth = 0;
+    if (SDMCompDebugHandler::Get()->GetProperty("vendor.display.sdm_comp_queue_depth",
+                                                &queue_depth) == kErrorNone && queue_depth > 0) {
+      queue_depth_ = std::min(UINT32(queue_depth), UINT32(kMaxQueueDepth));
+    }
+  }
+  SDMCompDebugHandler::ResetFrameStats(display_id_);
+
   return status;
 cleanup:
   DestroyLayerSet();
@@ -92,6 +109,9 @@ cleanup:
 }
 
 int SDMCompDisplayBuiltIn::Deinit() {
+  StopCommitThread();
+  SDMCompDebugHandler::DumpFrameStats(display_id_);
+
   DisplayConfigFixedInfo fixed_info = {};
   display_intf_->GetConfig(&fixed_info);
   DisplayError error = kErrorNone;
@@ -137,6 +157,8 @@ int SDMCompDisplayBuiltIn::GetDisplayConfig(int config_idx,
 }
 
 int SDMCompDisplayBuiltIn::SetDisplayConfig(int config_idx) {
+  std::lock_guard<std::mutex> lock(frame_lock_);
+  validated_ = false;
   return display_intf_->SetActiveConfig(config_idx);
 }
 
@@ -158,6 +180,19 @@ int SDMCompDisplayBuiltIn::GetDisplayAttributes(SDMCompDisplayAttributes *displa
 }
 
 int SDMCompDisplayBuiltIn::ShowBuffer(BufferHandle *buf_handle, int32_t *retire_fence) {
+  // Keep frames in order with the ones queued through QueueBuffer()
+  {
+    std::unique_lock<std::mutex> lock(queue_lock_);
+    queue_cv_.wait(lock, [this] { return pending_.empty() && !committing_; });
+  }
+
+  SDMCompFrameTiming timing = {};
+  return ShowFrame(buf_handle, retire_fence, &timing);
+}
+
+int SDMCompDisplayBuiltIn::ShowFrame(BufferHandle *buf_handle, int32_t *retire_fence,
+                                     SDMCompFrameTiming *timing) {
+  std::lock_guard<std::mutex> lock(frame_lock_);
   int status = PrepareLayerStack(buf_handle);
   if (status != 0) {
     DLOGE("PrepareLayerStack failed %d", status);
@@ -169,27 +204,186 @@ int SDMCompDisplayBuiltIn::ShowBuffer(BufferHandle *buf_handle, int32_t *retire_
       DLOGW("Failed to ApplyCurrentColorModeWithRenderIntent. Error = %d", status);
   }
 
-  if (!validated_) {
-    DisplayError error = display_intf_->Prepare(&layer_stack_);
-    if (error != kErrorNone) {
-      DLOGW("Prepare failed. Error = %d", error);
-      return -EINVAL;
+  // Only the buffer changed since the last validated frame, commit it directly.
+  bool skip_validate = validated_;
+  DisplayError error = kErrorNone;
+  int64_t start_ns = 0;
+  for (;;) {
+    if (!validated_) {
+      start_ns = GetTimeNs();
+      error = display_intf_->Prepare(&layer_stack_);
+      timing->prepare_us += UINT64(GetTimeNs() - start_ns) / 1000;
+      timing->validated = true;
+      if (error != kErrorNone) {
+        DLOGW("Prepare failed. Error = %d", error);
+        return -EINVAL;
+      }
+      validated_ = true;
+    }
+
+    start_ns = GetTimeNs();
+    error = display_intf_->Commit(&layer_stack_);
+    timing->commit_us = UINT64(GetTimeNs() - start_ns) / 1000;
+    if (error == kErrorNotValidated && skip_validate) {
+      DLOGI("Display %d needs validation, retrying the commit", display_id_);
+      validated_ = false;
+      skip_validate = false;
+      continue;
     }
-    validated_ = true;
+    break;
   }
 
-  DisplayError error = display_intf_->Commit(&layer_stack_);
   if (error != kErrorNone) {
     DLOGW("Commit failed. Error = %d", error);
+    validated_ = false;
     return -EINVAL;
   }
   Layer *layer = layer_stack_.layers.at(0);
   *retire_fence = Fence::Dup(layer_stack_.retire_fence);
   buf_handle->consumer_fence_fd = Fence::Dup(layer->input_buffer.release_fence);
+  SDMCompDebugHandler::UpdateFrameStats(display_id_, *timing);
+
+  return 0;
+}
+
+int SDMCompDisplayBuiltIn::QueueBuffer(BufferHandle *buf_handle) {
+  if (!buf_handle) {
+    DLOGE("buf_handle pointer is null");
+    return -EINVAL;
+  }
+
+  std::unique_lock<std::mutex> lock(queue_lock_);
+  if (commit_error_) {
+    int error = commit_error_;
+    commit_error_ = 0;
+    return error;
+  }
+
+  if (!commit_thread_.joinable()) {
+    commit_thread_exit_ = false;
+    commit_thread_ = std::thread(&SDMCompDisplayBuiltIn::CommitThread, this);
+  }
+
+  // N-deep buffering: wait until the commit thread catches up
+  queue_cv_.wait(lock, [this] {
+    return (pending_.size() + (committing_ ? 1 : 0)) < queue_depth_;
+  });
+
+  QueuedFrame frame;
+  frame.buffer = *buf_handle;
+  frame.buffer.consumer_fence_fd = -1;
+  frame.queued_ns = GetTimeNs();
+  pending_.push_back(frame);
+  queue_cv_.notify_all();
+
+  return 0;
+}
+
+int SDMCompDisplayBuiltIn::DequeueBuffer(BufferHandle *buf_handle, int32_t *retire_fence,
+                                         int timeout_ms) {
+  if (!buf_handle || !retire_fence) {
+    DLOGE("Invalid input param buf_handle %p, retire_fence %p", buf_handle, retire_fence);
+    return -EINVAL;
+  }
+
+  BufferHandle buffer;
+  {
+    std::unique_lock<std::mutex> lock(queue_lock_);
+    auto ready = [this] {
+      return !released_.empty() || (pending_.empty() && !committing_);
+    };
+    if (timeout_ms < 0) {
+      queue_cv_.wait(lock, ready);
+    } else if (!queue_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready)) {
+      return -ETIMEDOUT;
+    }
+
+    if (released_.empty()) {
+      // Nothing queued
+      int error = commit_error_;
+      commit_error_ = 0;
+      return error ? error : -ENOENT;
+    }
+    buffer = released_.front();
+    released_.pop_front();
+    *retire_fence = (retire_fence_ >= 0) ? dup(retire_fence_) : -1;
+  }
+
+  // Hand the buffer back once display hw is done reading it. If the release fence doesn't
+  // signal in time it is passed on for the client to wait on.
+  if (buffer.consumer_fence_fd >= 0 &&
+      buffer_sync_handler_->SyncWait(buffer.consumer_fence_fd, timeout_ms) == 0) {
+    close(buffer.consumer_fence_fd);
+    buffer.consumer_fence_fd = -1;
+  }
+  *buf_handle = buffer;
 
   return 0;
 }
 
+void SDMCompDisplayBuiltIn::CommitThread() {
+  std::unique_lock<std::mutex> lock(queue_lock_);
+  for (;;) {
+    queue_cv_.wait(lock, [this] { return commit_thread_exit_ || !pending_.empty(); });
+    if (commit_thread_exit_) {
+      break;
+    }
+
+    QueuedFrame frame = pending_.front();
+    pending_.pop_front();
+    committing_ = true;
+    lock.unlock();
+
+    SDMCompFrameTiming timing = {};
+    int32_t retire_fence = -1;
+    timing.queue_us = UINT64(GetTimeNs() - frame.queued_ns) / 1000;
+    int status = ShowFrame(&frame.buffer, &retire_fence, &timing);
+    if (status != 0) {
+      DLOGE("Failed to commit buffer %lld on display %d, error %d",
+            static_cast<long long>(frame.buffer.buffer_id), display_id_, status);
+    }
+
+    lock.lock();
+    committing_ = false;
+    if (status != 0) {
+      commit_error_ = status;
+      frame.buffer.consumer_fence_fd = -1;
+    } else {
+      if (retire_fence_ >= 0) {
+        close(retire_fence_);
+      }
+      retire_fence_ = retire_fence;
+    }
+    released_.push_back(frame.buffer);
+    queue_cv_.notify_all();
+  }
+}
+
+void SDMCompDisplayBuiltIn::StopCommitThread() {
+  {
+    std::lock_guard<std::mutex> lock(queue_lock_);
+    commit_thread_exit_ = true;
+    queue_cv_.notify_all();
+  }
+  if (commit_thread_.joinable()) {
+    commit_thread_.join();
+  }
+
+  // Frames not yet committed are dropped
+  pending_.clear();
+  for (auto &buffer : released_) {
+    if (buffer.consumer_fence_fd >= 0) {
+      close(buffer.consumer_fence_fd);
+    }
+  }
+  released_.clear();
+  if (retire_fence_ >= 0) {
+    close(retire_fence_);
+    retire_fence_ = -1;
+  }
+  commit_error_ = 0;
+}
+
 void SDMCompDisplayBuiltIn::PopulateColorModes() {
   for (uint32_t i = 0; i < stc_mode_list_.list.size(); i++) {
     snapdragoncolor::ColorMode stc_mode = stc_mode_list_.list[i];
@@ -216,6 +410,7 @@ int SDMCompDisplayBuiltIn::SetColorModeWithRenderIntent(struct ColorMode mode) {
     return -EINVAL;
   }
 
+  std::lock_guard<std::mutex> lock(frame_lock_);
   if (current_mode_.gamut == mode.gamut && current_mode_.gamma == mode.gamma &&
       current_mode_.intent == mode.intent) {
     return 0;
@@ -285,6 +480,7 @@ int SDMCompDisplayBuiltIn::ApplyCurrentColorModeWithRenderIntent() {
   }
 
   apply_mode_ = false;
+  validated_ = false;
 
   DLOGV_IF(kTagQDCM, "Successfully applied mode gamut = %d, gamma = %d, intent = %d",
            current_mode_.gamut, current_mode_.gamma, current_mode_.intent);
@@ -346,6 +542,19 @@ int SDMCompDisplayBuiltIn::PrepareLayerStack(BufferHandle *buf_handle) {
   BufferFormat buf_format = GetSDMCompFormat(layer->input_buffer.format);
   LayerRect src_crop = LayerRect(buf_handle->src_crop.left, buf_handle->src_crop.top,
                                  buf_handle->src_crop.right, buf_handle->src_crop.bottom);
+  LayerRect src_rect = LayerRect(0, 0, buf_handle->width, buf_handle->height);
+  if (IsValid(src_crop)) {
+    src_rect = Intersection(src_crop, src_rect);
+  }
+
+  // Anything but a new buffer needs the layer stack to be validated again
+  if (layer->input_buffer.width != buf_handle->width ||
+      layer->input_buffer.height != buf_handle->height ||
+      layer->input_buffer.format != GetSDMFormat(buf_handle->format) ||
+      layer->input_buffer.planes[0].stride != buf_handle->stride_in_bytes ||
+      !IsCongruent(layer->src_rect, src_rect)) {
+    validated_ = false;
+  }
 
   layer->input_buffer.width = buf_handle->width;
   layer->input_buffer.height = buf_handle->height;
@@ -358,15 +567,13 @@ int SDMCompDisplayBuiltIn::PrepareLayerStack(BufferHandle *buf_handle) {
   layer->input_buffer.buffer_id = buf_handle->buffer_id;
   layer->frame_rate = variable_info_.fps;
   layer->blending = kBlendingPremultiplied;
-  layer->src_rect = LayerRect(0, 0, buf_handle->width, buf_handle->height);
-  if (IsValid(src_crop)) {
-    layer->src_rect = Intersection(src_crop, layer->src_rect);
-  }
+  layer->src_rect = src_rect;
 
-  DLOGI("WxHxF %dx%dx%d Crop[LTRB] [%.0f %.0f %.0f %.0f]", layer->input_buffer.width,
+  DLOGV("WxHxF %dx%dx%d Crop[LTRB] [%.0f %.0f %.0f %.0f]", layer->input_buffer.width,
         layer->input_buffer.height, layer->input_buffer.format, layer->src_rect.left,
         layer->src_rect.top, layer->src_rect.right, layer->src_rect.bottom);
 
+  layer_stack_.layers.clear();
   for (auto &it : layer_set_)
     layer_stack_.layers.push_back(it);
 
@@ -32,6 +32,10 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include "utils/constants.h"
 #include "core/display_interface.h"
@@ -39,14 +43,18 @@
 #include "core/sdm_types.h"
 #include "sdm_comp_interface.h"
 #include "private/color_params.h"
+#include "sdm_comp_buffer_sync_handler.h"
+#include "sdm_comp_debugger.h"
 
 namespace sdm {
 
 class SDMCompDisplayBuiltIn : public DisplayEventHandler {
  public:
-  explicit SDMCompDisplayBuiltIn(CoreInterface *core_intf, CallbackInterface *callback,
-                                          SDMCompDisplayType disp_type, int32_t disp_id);
-  virtual ~SDMCompDisplayBuiltIn() { }
+  explicit SDMCompDisplayBuiltIn(CoreInterface *core_intf,
+                                 SDMCompBufferSyncHandler *buffer_sync_handler,
+                                 CallbackInterface *callback, SDMCompDisplayType disp_type,
+                                 int32_t disp_id);
+  virtual ~SDMCompDisplayBuiltIn() { StopCommitThread(); }
 
   virtual DisplayError VSync(const DisplayEventVSync &vsync) { return kErrorNone; }
   virtual DisplayError Refresh() { return kErrorNone; }
@@ -59,6 +67,8 @@ class SDMCompDisplayBuiltIn : public DisplayEventHandler {
   int Deinit();
   int GetDisplayAttributes(SDMCompDisplayAttributes *display_attributes);
   int ShowBuffer(BufferHandle *buf_handle, int32_t *out_release_fence);
+  int QueueBuffer(BufferHandle *buf_handle);
+  int DequeueBuffer(BufferHandle *buf_handle, int32_t *retire_fence, int timeout_ms);
   int SetColorModeWithRenderIntent(struct ColorMode mode);
   int GetColorModes(uint32_t *out_num_modes, struct ColorMode *out_modes);
   SDMCompDisplayType GetDisplayType() { return display_type_; }
@@ -72,6 +82,9 @@ class SDMCompDisplayBuiltIn : public DisplayEventHandler {
   void CreateLayerSet();
   void DestroyLayerSet();
   int PrepareLayerStack(BufferHandle *buf_handle);
+  int ShowFrame(BufferHandle *buf_handle, int32_t *retire_fence, SDMCompFrameTiming *timing);
+  void CommitThread();
+  void StopCommitThread();
 
   void PopulateColorModes();
   int GetStcColorModeFromMap(const ColorMode &mode, snapdragoncolor::ColorMode *out_mode);
@@ -95,6 +108,30 @@ class SDMCompDisplayBuiltIn : public DisplayEventHandler {
   float min_panel_brightness_ = 0.0f;
   bool validated_ = false;
   std::vector<Layer *> layer_set_ = {};
+  SDMCompBufferSyncHandler *buffer_sync_handler_ = nullptr;
+
+  // Serializes the layer stack and Prepare/Commit between the client and the commit thread
+  std::mutex frame_lock_;
+
+  // Asynchronous submission: QueueBuffer() appends to pending_, the commit thread commits the
+  // frames in order and moves them to released_ with their release fence, DequeueBuffer()
+  // hands them back to the client.
+  struct QueuedFrame {
+    BufferHandle buffer = {};
+    int64_t queued_ns = 0;
+  };
+  static const uint32_t kDefaultQueueDepth = 2;
+  static const uint32_t kMaxQueueDepth = 8;
+  std::mutex queue_lock_;
+  std::condition_variable queue_cv_;
+  std::deque<QueuedFrame> pending_ = {};
+  std::deque<BufferHandle> released_ = {};
+  std::thread commit_thread_;
+  bool commit_thread_exit_ = false;
+  bool committing_ = false;
+  uint32_t queue_depth_ = kDefaultQueueDepth;
+  int32_t retire_fence_ = -1;
+  int commit_error_ = 0;
 };
 
 }  // namespace sdm
@@ -76,7 +76,9 @@ SDMCompImpl *SDMCompImpl::sdm_comp_impl_ = nullptr;
 SDMCompDisplayBuiltIn *SDMCompImpl::display_builtin_[kSDMCompDisplayTypeMax] = { nullptr };
 uint32_t SDMCompImpl::ref_count_ = 0;
 uint32_t SDMCompImpl::disp_ref_count_[kSDMCompDisplayTypeMax] = { 0 };
+uint32_t SDMCompImpl::disp_busy_count_[kSDMCompDisplayTypeMax] = { 0 };
 recursive_mutex recursive_mutex_;
+std::condition_variable_any display_idle_cv_;
 
 SDMCompImpl *SDMCompImpl::GetInstance() {
   if (!sdm_comp_impl_) {
@@ -173,8 +175,9 @@ int SDMCompImpl::CreateDisplay(SDMCompDisplayType display_type, CallbackInterfac
     }
 
     DLOGI("Create builtin display, id = %d, type = %d", info.display_id, display_type);
-    SDMCompDisplayBuiltIn *display_builtin = new SDMCompDisplayBuiltIn(core_intf_, callback,
-                                                               display_type, info.display_id);
+    SDMCompDisplayBuiltIn *display_builtin =
+        new SDMCompDisplayBuiltIn(core_intf_, &buffer_sync_handler_, callback, display_type,
+                                  info.display_id);
     status = display_builtin->Init();
     if (status) {
       delete display_builtin;
@@ -192,7 +195,7 @@ int SDMCompImpl::CreateDisplay(SDMCompDisplayType display_type, CallbackInterfac
 }
 
 int SDMCompImpl::DestroyDisplay(Handle disp_hnd) {
-  lock_guard<recursive_mutex> obj(recursive_mutex_);
+  unique_lock<recursive_mutex> obj(recursive_mutex_);
   if (!disp_hnd) {
     DLOGE("Display handle is NULL");
     return -EINVAL;
@@ -202,6 +205,12 @@ int SDMCompImpl::DestroyDisplay(Handle disp_hnd) {
   if (disp_ref_count_[disp_type]) {
     disp_ref_count_[disp_type]--;
     if (!disp_ref_count_[disp_type]) {
+      // Buffer calls run without the lock, wait for the ones still on this display
+      display_idle_cv_.wait(obj, [disp_type] { return !disp_busy_count_[disp_type]; });
+      if (disp_ref_count_[disp_type]) {
+        // Created again meanwhile
+        return 0;
+      }
       int status = sdm_comp_display->Deinit();
       if (status != 0) {
         return status;
@@ -227,15 +236,51 @@ int SDMCompImpl::GetDisplayAttributes(Handle disp_hnd,
 }
 
 int SDMCompImpl::ShowBuffer(Handle disp_hnd, BufferHandle *buf_handle, int32_t *retire_fence) {
-  lock_guard<recursive_mutex> obj(recursive_mutex_);
   if (!disp_hnd || !buf_handle || !retire_fence) {
     DLOGE("Invalid input param disp_hnd %d, buf_handle %d, retire_fence %d", disp_hnd, buf_handle,
           retire_fence);
     return -EINVAL;
   }
 
-  SDMCompDisplayBuiltIn *sdm_comp_display = reinterpret_cast<SDMCompDisplayBuiltIn *>(disp_hnd);
-  return sdm_comp_display->ShowBuffer(buf_handle, retire_fence);
+  SDMCompDisplayBuiltIn *sdm_comp_display = AcquireDisplay(disp_hnd);
+  if (!sdm_comp_display) {
+    return -EINVAL;
+  }
+  int status = sdm_comp_display->ShowBuffer(buf_handle, retire_fence);
+  ReleaseDisplay(sdm_comp_display);
+  return status;
+}
+
+int SDMCompImpl::QueueBuffer(Handle disp_hnd, BufferHandle *buf_handle) {
+  if (!disp_hnd || !buf_handle) {
+    DLOGE("Invalid input param disp_hnd %d, buf_handle %d", disp_hnd, buf_handle);
+    return -EINVAL;
+  }
+
+  SDMCompDisplayBuiltIn *sdm_comp_display = AcquireDisplay(disp_hnd);
+  if (!sdm_comp_display) {
+    return -EINVAL;
+  }
+  int status = sdm_comp_display->QueueBuffer(buf_handle);
+  ReleaseDisplay(sdm_comp_display);
+  return status;
+}
+
+int SDMCompImpl::DequeueBuffer(Handle disp_hnd, BufferHandle *buf_handle, int32_t *retire_fence,
+                               int timeout_ms) {
+  if (!disp_hnd || !buf_handle || !retire_fence) {
+    DLOGE("Invalid input param disp_hnd %d, buf_handle %d, retire_fence %d", disp_hnd, buf_handle,
+          retire_fence);
+    return -EINVAL;
+  }
+
+  SDMCompDisplayBuiltIn *sdm_comp_display = AcquireDisplay(disp_hnd);
+  if (!sdm_comp_display) {
+    return -EINVAL;
+  }
+  int status = sdm_comp_display->DequeueBuffer(buf_handle, retire_fence, timeout_ms);
+  ReleaseDisplay(sdm_comp_display);
+  return status;
 }
 
 int SDMCompImpl::SetColorModeWithRenderIntent(Handle disp_hnd, struct ColorMode mode) {
@@ -354,6 +399,27 @@ int SDMCompImpl::OnEvent(SDMCompServiceEvents event, ...) {
   return err;
 }
 
+SDMCompDisplayBuiltIn *SDMCompImpl::AcquireDisplay(Handle disp_hnd) {
+  lock_guard<recursive_mutex> obj(recursive_mutex_);
+  for (uint32_t disp_type = 0; disp_type < kSDMCompDisplayTypeMax; disp_type++) {
+    if (display_builtin_[disp_type] && display_builtin_[disp_type] == disp_hnd &&
+        disp_ref_count_[disp_type]) {
+      disp_busy_count_[disp_type]++;
+      return display_builtin_[disp_type];
+    }
+  }
+  DLOGE("Invalid display handle %p", disp_hnd);
+  return nullptr;
+}
+
+void SDMCompImpl::ReleaseDisplay(SDMCompDisplayBuiltIn *sdm_comp_display) {
+  lock_guard<recursive_mutex> obj(recursive_mutex_);
+  SDMCompDisplayType disp_type = sdm_comp_display->GetDisplayType();
+  if (!--disp_busy_count_[disp_type]) {
+    display_idle_cv_.notify_all();
+  }
+}
+
 void SDMCompImpl::HandlePendingEvents() {
   for (auto pending_event : pending_events_) {
     SDMCompDisplayType display_type = pending_event.second;
@@ -77,6 +77,7 @@ namespace sdm {
 
 using std::recursive_mutex;
 using std::lock_guard;
+using std::unique_lock;
 
 class SDMCompIPCImpl : public IPCIntf {
 public:
@@ -107,6 +108,9 @@ class SDMCompImpl : public SDMCompInterface, SDMCompServiceCbIntf {
   virtual int DestroyDisplay(Handle disp_hnd);
   virtual int GetDisplayAttributes(Handle disp_hnd, SDMCompDisplayAttributes *display_attributes);
   virtual int ShowBuffer(Handle disp_hnd, BufferHandle *buf_handle, int32_t *retire_fence);
+  virtual int QueueBuffer(Handle disp_hnd, BufferHandle *buf_handle);
+  virtual int DequeueBuffer(Handle disp_hnd, BufferHandle *buf_handle, int32_t *retire_fence,
+                            int timeout_ms);
   virtual int SetColorModeWithRenderIntent(Handle disp_hnd, struct ColorMode mode);
   virtual int GetColorModes(Handle disp_hnd, uint32_t *out_num_modes,
                             struct ColorMode *out_modes);
@@ -115,11 +119,16 @@ class SDMCompImpl : public SDMCompInterface, SDMCompServiceCbIntf {
   virtual int OnEvent(SDMCompServiceEvents event, ...);
 
   void HandlePendingEvents();
+  // Look up a display and keep it alive for calls that block on its queue, these run without
+  // the lock so other displays and the service callbacks are not held up
+  SDMCompDisplayBuiltIn *AcquireDisplay(Handle disp_hnd);
+  void ReleaseDisplay(SDMCompDisplayBuiltIn *sdm_comp_display);
 
   static SDMCompImpl *sdm_comp_impl_;
   static SDMCompDisplayBuiltIn *display_builtin_[kSDMCompDisplayTypeMax];
   static uint32_t ref_count_;
   static uint32_t disp_ref_count_[kSDMCompDisplayTypeMax];
+  static uint32_t disp_busy_count_[kSDMCompDisplayTypeMax];
 
   CoreInterface *core_intf_ = nullptr;
   SDMCompBufferAllocator buffer_allocator_;
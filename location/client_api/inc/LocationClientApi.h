@@ -3181,6 +3181,26 @@ public:
     */
     static string capabilitiesToString(LocationCapabilitiesMask capabMask);
 
+    /** @brief
+        Invoke the report callbacks of the position session directly from the
+        thread that receives the reports from the location hal daemon, instead
+        of handing each report over to the internal thread of this
+        LocationClientApi first. This saves a thread switch per report, which
+        matters for NHz sessions. <br/>
+        Only the LocationCb, GnssLocationCb, GnssSvCb, GnssNmeaCb, GnssDataCb,
+        GnssMeasurementsCb and NHz GnssMeasurementsCb are affected, all other
+        callbacks are still invoked from the internal thread. <br/>
+        Only enable this if those callbacks are thread safe: they may be invoked
+        while other callbacks of this LocationClientApi are running, and must
+        return quickly and not call back into this LocationClientApi. <br/>
+        Disabled by default. <br/>
+
+        @param enable
+        true to invoke the report callbacks directly, false to invoke them from
+        the internal thread. <br/>
+    */
+    void setDirectReportDispatch(bool enable);
+
 private:
     /** Internal implementation for LocationClientApi */
     LocationClientApiImpl* mApiImpl;
@@ -750,6 +750,14 @@ uint16_t LocationClientApi::getYearOfHw() {
     }
 }
 
+void LocationClientApi::setDirectReportDispatch(bool enable) {
+    if (mApiImpl) {
+        mApiImpl->setDirectReportDispatch(enable);
+    } else {
+        LOC_LOGe ("NULL mApiImpl");
+    }
+}
+
 void LocationClientApi::getSingleTerrestrialPosition(
     uint32_t timeoutMsec,
     TerrestrialTechnologyMask techMask,
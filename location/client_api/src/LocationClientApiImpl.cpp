@@ -1236,10 +1236,28 @@ void LocationClientApiImpl::logLocation(const GnssLocation &gnssLocation,
 /******************************************************************************
 ILocIpcListener override
 ******************************************************************************/
+// protobuf messages parsed into again and again for the reports that come at the
+// fix rate, so that a report reuses the repeated fields and strings allocated
+// for the previous one. Only ever used from one thread.
+struct ReportParseCache {
+    PBLocAPIMsgHeader header;
+    PBLocAPILocationIndMsg location;
+    PBLocAPILocationInfoIndMsg locationInfo;
+    PBLocAPISatelliteVehicleIndMsg sv;
+    PBLocAPINmeaIndMsg nmea;
+    PBLocAPIDataIndMsg data;
+    PBLocAPIMeasIndMsg meas;
+};
+
 class IpcListener : public ILocIpcListener {
     MsgTask& mMsgTask;
     LocationClientApiImpl& mApiImpl;
     const SockNode::Type mSockTpye;
+    // mTaskCache is used on mMsgTask, mDirectCache on the receiver thread
+    ReportParseCache mTaskCache;
+    ReportParseCache mDirectCache;
+
+    bool dispatchReportDirect(const char* data, uint32_t length);
 public:
     inline IpcListener(LocationClientApiImpl& apiImpl, MsgTask& msgTask,
                        const SockNode::Type sockType) :
@@ -1332,6 +1350,9 @@ LocationClientApiImpl::LocationClientApiImpl(capabilitiesCallback capabilitiescb
         mLastAddedClientIds({}),
         mCapabilitiesCb(capabilitiescb),
         mPositionSessionResponseCbPending(false),
+        mDirectReportDispatch(false),
+        mDirectReportSessionActive(false),
+        mDirectReportCbsMask(0),
         mGnssEnergyConsumedInfoCb(nullptr),
         mGnssEnergyConsumedResponseCb(nullptr),
         mLocationSysInfoCb(nullptr),
@@ -1343,7 +1364,8 @@ LocationClientApiImpl::LocationClientApiImpl(capabilitiesCallback capabilitiescb
         mPingTestCb(nullptr),
         mMsgTask("LcaMsgTask"),
         mLogger(),
-        mpAntennaInfoCb(nullptr)
+        mpAntennaInfoCb(nullptr),
+        mBatchStoreDisabled(false)
 {
     // read configuration file
     UTIL_READ_CONF(LOC_PATH_GPS_CONF, gConfigTable);
@@ -1588,6 +1610,7 @@ void LocationClientApiImpl::updateCallbacksSync(LocationCallbacks& callbacks) {
     } else {
         LOC_LOGd("No updateCallbacks because same callBacksMask 0x%x", callBacksMask);
     }
+    publishDirectReportState();
 }
 
 uint32_t LocationClientApiImpl::startTracking(TrackingOptions& option) {
@@ -1620,6 +1643,7 @@ uint32_t LocationClientApiImpl::startTrackingSync(TrackingOptions& option) {
         mLocationOptions = option;
         // need to set session id so when hal is ready, the session can be resumed
         mSessionId = mClientId;
+        publishDirectReportState();
         LOC_LOGe(">>> startTracking - Not registered yet");
         return mSessionId;
     }
@@ -1628,6 +1652,7 @@ uint32_t LocationClientApiImpl::startTrackingSync(TrackingOptions& option) {
         mLocationOptions = option;
         //start a new tracking session
         mSessionId = mClientId;
+        publishDirectReportState();
 
         if ((0 != mLocationOptions.minInterval) ||
                 (0 != mLocationOptions.minDistance)) {
@@ -1792,6 +1817,7 @@ void LocationClientApiImpl::stopTrackingSync(bool clearSubscriptions) {
     mSessionId = LOCATION_CLIENT_SESSION_ID_INVALID;
     mPositionSessionResponseCbPending = false;
     mSessionStartBootTimestampNs = 0;
+    publishDirectReportState();
 }
 
 void LocationClientApiImpl::clearSubscriptions(LocationCallbackType cbTypeToClear) {
@@ -1822,6 +1848,7 @@ void LocationClientApiImpl::clearSubscriptions(LocationCallbackType cbTypeToClea
             break;
         default: return;
     }
+    publishDirectReportState();
 }
 
 void LocationClientApiImpl::updateTrackingOptionsSync(TrackingOptions& option,
@@ -1907,7 +1934,7 @@ uint32_t LocationClientApiImpl::startBatchingSync(BatchingOptions& batchOptions)
         mBatchingId = mClientId;
         LocAPIStartBatchingReqMsg msg(mSocketName, mBatchingOptions.minInterval,
                                       mBatchingOptions.minDistance, mBatchingOptions.batchingMode,
-                                      &mPbufMsgConv);
+                                      &mPbufMsgConv, useBatchStore());
         if (msg.serializeToProtobuf(pbStr)) {
             bool rc = sendMessage(
             reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()), pbStr.size());
@@ -1976,6 +2003,7 @@ void LocationClientApiImpl::stopBatching(uint32_t id) {
                 }
             }
             mApiImpl->mBatchingId = LOCATION_CLIENT_SESSION_ID_INVALID;
+            mApiImpl->mBatchStore.reset();
         }
         LocationClientApiImpl *mApiImpl;
     };
@@ -1992,7 +2020,7 @@ void LocationClientApiImpl::updateBatchingOptions(uint32_t id, BatchingOptions&
         LocAPIUpdateBatchingOptionsReqMsg msg(mSocketName, mBatchingOptions.minInterval,
                                               mBatchingOptions.minDistance,
                                               mBatchingOptions.batchingMode,
-                                              &mPbufMsgConv);
+                                              &mPbufMsgConv, useBatchStore());
         if (msg.serializeToProtobuf(pbStr)) {
             bool rc = sendMessage(
                     reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()), pbStr.size());
@@ -2011,6 +2039,73 @@ void LocationClientApiImpl::updateBatchingOptions(uint32_t id, BatchingOptions&
 
 void LocationClientApiImpl::getBatchedLocations(uint32_t id, size_t count) {}
 
+bool LocationClientApiImpl::useBatchStore() const {
+    // the store is a file next to the client socket, only for clients on the same processor
+    return !mBatchStoreDisabled &&
+            (0 == strncmp(mSocketName, SOCKET_LOC_CLIENT_DIR, sizeof(SOCKET_LOC_CLIENT_DIR)-1));
+}
+
+void LocationClientApiImpl::openBatchStore() {
+    // the daemon creates a new store on every start of batching
+    mBatchCursor = LocationApiBatchStore::Cursor();
+    mBatchStore.reset(LocationApiBatchStore::open(LocationApiBatchStore::getPath(mSocketName)));
+    if (nullptr == mBatchStore && !mBatchStoreDisabled) {
+        // have the daemon send the fixes in the indications again
+        LOC_LOGw("batch store not available, fixes are sent inline");
+        mBatchStoreDisabled = true;
+        string pbStr;
+        LocAPIUpdateBatchingOptionsReqMsg msg(mSocketName, mBatchingOptions.minInterval,
+                                              mBatchingOptions.minDistance,
+                                              mBatchingOptions.batchingMode,
+                                              &mPbufMsgConv, false);
+        if (msg.serializeToProtobuf(pbStr)) {
+            bool rc = sendMessage(
+                    reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()), pbStr.size());
+            LOC_LOGd(">>> UpdateBatchingOptionsReq without batch store rc=%d", rc);
+        } else {
+            LOC_LOGe("LocAPIUpdateBatchingOptionsReqMsg serializeToProtobuf failed");
+        }
+    }
+}
+
+void LocationClientApiImpl::readBatchStore(uint64_t endSeq, BatchingMode batchingMode) {
+    static const size_t BATCH_STORE_READ_COUNT = 256;
+
+    if (nullptr == mBatchStore) {
+        openBatchStore();
+        if (nullptr == mBatchStore) {
+            return;
+        }
+    }
+    while (mBatchCursor.seq < endSeq) {
+        uint64_t lost = 0;
+        uint64_t seq = mBatchCursor.seq;
+        size_t count = mBatchStore->read(mBatchCursor, mBatchFixes, BATCH_STORE_READ_COUNT,
+                                         &lost);
+        if (lost > 0) {
+            LOC_LOGw("%" PRIu64 " batched fixes dropped from the store before read", lost);
+        }
+        if (0 == count) {
+            if (mBatchCursor.seq == seq) {
+                break;
+            }
+            continue;
+        }
+        LOC_LOGd("Batch count : %zu", count);
+        for (size_t i = 0; i < count; i++) {
+            Location location = LocationClientApiImpl::parseLocation(mBatchFixes[i]);
+            logLocation(location, BATCHING_MODE_ROUTINE == batchingMode ?
+                        LOC_REPORT_TRIGGER_ROUTINE_BATCHING_SESSION :
+                        LOC_REPORT_TRIGGER_TRIP_BATCHING_SESSION);
+        }
+        if (mLocationCbs.batchingCb) {
+            // note:: batchingOpts is not used by LCA clients today.
+            BatchingOptions batchingOpts = {};
+            mLocationCbs.batchingCb(count, mBatchFixes.data(), batchingOpts);
+        }
+    }
+}
+
 bool LocationClientApiImpl::checkGeofenceMap(size_t count, uint32_t* ids) {
     for (int i=0; i<count; ++i) {
         auto got = mGeofenceMap.find(ids[i]);
@@ -2801,6 +2896,28 @@ void LocationClientApiImpl::pingTest(PingTestCb pingTestCallback) {
     return;
 }
 
+void LocationClientApiImpl::setDirectReportDispatch(bool enable) {
+    struct SetDirectReportDispatchReq : public LocMsg {
+        SetDirectReportDispatchReq(LocationClientApiImpl *apiImpl, bool enable) :
+                mApiImpl(apiImpl), mEnable(enable) {}
+        virtual ~SetDirectReportDispatchReq() {}
+        void proc() const {
+            LOC_LOGd(">>> setDirectReportDispatch %d", mEnable);
+            mApiImpl->mDirectReportDispatch.store(mEnable);
+            if (mEnable) {
+                mApiImpl->publishDirectReportState();
+            } else {
+                lock_guard<mutex> lock(mApiImpl->mDirectReportMutex);
+                mApiImpl->mDirectReportSessionActive = false;
+                mApiImpl->mDirectReportCbs = {};
+            }
+        }
+        LocationClientApiImpl *mApiImpl;
+        bool mEnable;
+    };
+    mMsgTask.sendMsg(new (nothrow) SetDirectReportDispatchReq(this, enable));
+}
+
 void LocationClientApiImpl::invokePositionSessionResponseCb(LocationError errCode) {
     if (mPositionSessionResponseCbPending) {
         parseLocationError(errCode);
@@ -2808,7 +2925,19 @@ void LocationClientApiImpl::invokePositionSessionResponseCb(LocationError errCod
             mLocationCbs.responseCb(errCode, 0);
         }
         mPositionSessionResponseCbPending = false;
+        publishDirectReportState();
+    }
+}
+
+void LocationClientApiImpl::publishDirectReportState() {
+    if (!mDirectReportDispatch.load()) {
+        return;
     }
+    lock_guard<mutex> lock(mDirectReportMutex);
+    mDirectReportSessionActive = (mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
+            (mPositionSessionResponseCbPending == false);
+    mDirectReportCbsMask = mCallbacksMask;
+    mDirectReportCbs = mLocationCbs;
 }
 
 /******************************************************************************
@@ -2838,18 +2967,241 @@ void IpcListener::onListenerReady() {
     mMsgTask.sendMsg(new (nothrow) ClientRegisterReq(mApiImpl));
 }
 
+/* MsgTask deletes every LocMsg after proc(), so each message received from the
+   location hal daemon used to cost one allocation for the OnReceiveHandler and
+   one for its copy of the data. Both are recycled here instead, up to MAX_FREE
+   of each, enough for the burst of reports the daemon sends for one fix. */
+class OnReceivePool {
+public:
+    static const size_t MAX_FREE = 16;
+    // buffers of the occasional large message are not worth keeping around
+    static const size_t MAX_BUFFER_CAPACITY = 16 * 1024;
+
+    static OnReceivePool& get() {
+        // never destroyed, the MsgTask thread may still be deleting messages at exit
+        static OnReceivePool* pool = new OnReceivePool();
+        return *pool;
+    }
+
+    void* allocMsg(size_t size) {
+        {
+            lock_guard<mutex> lock(mMutex);
+            if (size == mMsgSize && !mFreeMsgs.empty()) {
+                void* p = mFreeMsgs.back();
+                mFreeMsgs.pop_back();
+                return p;
+            }
+        }
+        return ::operator new(size, nothrow);
+    }
+
+    void freeMsg(void* p, size_t size) {
+        if (nullptr == p) {
+            return;
+        }
+        {
+            lock_guard<mutex> lock(mMutex);
+            if (0 == mMsgSize) {
+                mMsgSize = size;
+            }
+            if (size == mMsgSize && mFreeMsgs.size() < MAX_FREE) {
+                mFreeMsgs.push_back(p);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    void getBuffer(string& buf, const char* data, uint32_t length) {
+        {
+            lock_guard<mutex> lock(mMutex);
+            if (!mFreeBuffers.empty()) {
+                buf.swap(mFreeBuffers.back());
+                mFreeBuffers.pop_back();
+            }
+        }
+        buf.assign(data, length);
+    }
+
+    void putBuffer(string& buf) {
+        if (buf.capacity() > MAX_BUFFER_CAPACITY) {
+            return;
+        }
+        lock_guard<mutex> lock(mMutex);
+        if (mFreeBuffers.size() < MAX_FREE) {
+            mFreeBuffers.push_back(std::move(buf));
+        }
+    }
+
+private:
+    OnReceivePool() : mMsgSize(0) {
+        mFreeMsgs.reserve(MAX_FREE);
+        mFreeBuffers.reserve(MAX_FREE);
+    }
+
+    mutex mMutex;
+    size_t mMsgSize;
+    vector<void*> mFreeMsgs;
+    vector<string> mFreeBuffers;
+};
+
+// reports sent at the fix rate while a position session is running
+static inline bool isReportMsg(ELocMsgID msgId) {
+    switch (msgId) {
+    case E_LOCAPI_LOCATION_MSG_ID:
+    case E_LOCAPI_LOCATION_INFO_MSG_ID:
+    case E_LOCAPI_SATELLITE_VEHICLE_MSG_ID:
+    case E_LOCAPI_NMEA_MSG_ID:
+    case E_LOCAPI_DATA_MSG_ID:
+    case E_LOCAPI_MEAS_MSG_ID:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Parses a report into the recycled messages of cache and invokes its callback.
+// Caller has checked that a position session is running.
+static void dispatchReport(ELocMsgID msgId, const PBLocAPIMsgHeader& pbLocApiMsg,
+                           LocationCallbacksMask cbMask, const LocationCallbacks& cbs,
+                           ReportParseCache& cache, const LocationApiPbMsgConv& pbMsgConv) {
+    const char* sockName = pbLocApiMsg.msocketname().c_str();
+
+    switch (msgId) {
+    case E_LOCAPI_LOCATION_MSG_ID:
+    {
+        LOC_LOGd("<<< message = simple location");
+        if ((cbMask & E_LOC_CB_TRACKING_BIT) && cbs.trackingCb) {
+            if (0 == cache.location.ParseFromString(pbLocApiMsg.payload())) {
+                LOC_LOGe("Failed to parse pbLocApiLocIndMsg from payload!!");
+                return;
+            }
+            LocAPILocationIndMsg msg(sockName, cache.location, &pbMsgConv);
+            cbs.trackingCb(msg.locationNotification);
+        }
+        break;
+    }
+
+    case E_LOCAPI_LOCATION_INFO_MSG_ID:
+    {
+        LOC_LOGd("<<< message = location info");
+        if ((cbMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT) && cbs.gnssLocationInfoCb) {
+            if (0 == cache.locationInfo.ParseFromString(pbLocApiMsg.payload())) {
+                LOC_LOGe("Failed to parse pbLocApiLocInfoIndMsg from payload!!");
+                return;
+            }
+            LocAPILocationInfoIndMsg msg(sockName, cache.locationInfo, &pbMsgConv);
+            cbs.gnssLocationInfoCb(msg.gnssLocationInfoNotification);
+        }
+        break;
+    }
+
+    case E_LOCAPI_SATELLITE_VEHICLE_MSG_ID:
+    {
+        LOC_LOGd("<<< message = sv");
+        if ((cbMask & E_LOC_CB_GNSS_SV_BIT) && cbs.gnssSvCb) {
+            if (0 == cache.sv.ParseFromString(pbLocApiMsg.payload())) {
+                LOC_LOGe("Failed to parse pbLocApiSatVehIndMsg from payload!!");
+                return;
+            }
+            LocAPISatelliteVehicleIndMsg msg(sockName, cache.sv, &pbMsgConv);
+            cbs.gnssSvCb(msg.gnssSvNotification);
+        }
+        break;
+    }
+
+    case E_LOCAPI_NMEA_MSG_ID:
+    {
+        if ((cbMask & E_LOC_CB_GNSS_NMEA_BIT) && cbs.gnssNmeaCb) {
+            if (0 == cache.nmea.ParseFromString(pbLocApiMsg.payload())) {
+                LOC_LOGe("Failed to parse pbLocApiNmeaIndMsg from payload!!");
+                return;
+            }
+            LocAPINmeaIndMsg msg(sockName, cache.nmea, &pbMsgConv);
+            // nmea is variable length, can not be checked
+            ::GnssNmeaNotification nmeaNotif = {};
+            nmeaNotif.size = sizeof(GnssNmeaNotification);
+            nmeaNotif.timestamp = msg.gnssNmeaNotification.timestamp;
+            nmeaNotif.nmea = msg.gnssNmeaNotification.nmea.c_str();
+            nmeaNotif.length = msg.gnssNmeaNotification.nmea.length();
+            cbs.gnssNmeaCb(nmeaNotif);
+        }
+        break;
+    }
+
+    case E_LOCAPI_DATA_MSG_ID:
+    {
+        LOC_LOGd("<<< message = data");
+        if ((cbMask & E_LOC_CB_GNSS_DATA_BIT) && cbs.gnssDataCb) {
+            if (0 == cache.data.ParseFromString(pbLocApiMsg.payload())) {
+                LOC_LOGe("Failed to parse pbLocApiDataIndMsg from payload!!");
+                return;
+            }
+            LocAPIDataIndMsg msg(sockName, cache.data, &pbMsgConv);
+            cbs.gnssDataCb(msg.gnssDataNotification);
+        }
+        break;
+    }
+
+    case E_LOCAPI_MEAS_MSG_ID:
+    {
+        LOC_LOGd("<<< message = measurements");
+        if (((cbMask & E_LOC_CB_GNSS_NHZ_MEAS_BIT) && cbs.gnssNHzMeasurementsCb) ||
+                ((cbMask & E_LOC_CB_GNSS_MEAS_BIT) && cbs.gnssMeasurementsCb)) {
+            if (0 == cache.meas.ParseFromString(pbLocApiMsg.payload())) {
+                LOC_LOGe("Failed to parse pbLocApiMeasIndMsg from payload!!");
+                return;
+            }
+            LocAPIMeasIndMsg msg(sockName, cache.meas, &pbMsgConv);
+            if (msg.gnssMeasurementsNotification.isNhz) {
+                if ((cbMask & E_LOC_CB_GNSS_NHZ_MEAS_BIT) &&
+                        (nullptr != cbs.gnssNHzMeasurementsCb)) {
+                    cbs.gnssNHzMeasurementsCb(msg.gnssMeasurementsNotification);
+                }
+            } else {
+                if ((cbMask & E_LOC_CB_GNSS_MEAS_BIT) &&
+                        (nullptr != cbs.gnssMeasurementsCb)) {
+                    cbs.gnssMeasurementsCb(msg.gnssMeasurementsNotification);
+                }
+            }
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
 void IpcListener::onReceive(const char* data, uint32_t length,
                             const LocIpcRecver* recver) {
     struct OnReceiveHandler : public LocMsg {
         OnReceiveHandler(LocationClientApiImpl& apiImpl, IpcListener& listener,
                          const char* data, uint32_t length) :
-                mApiImpl(apiImpl), mListener(listener), mMsgData(data, length) {}
+                mApiImpl(apiImpl), mListener(listener) {
+            OnReceivePool::get().getBuffer(mMsgData, data, length);
+        }
 
-        virtual ~OnReceiveHandler() {}
+        virtual ~OnReceiveHandler() {
+            OnReceivePool::get().putBuffer(mMsgData);
+        }
+        static void* operator new(size_t size) {
+            void* p = OnReceivePool::get().allocMsg(size);
+            if (nullptr == p) {
+                throw bad_alloc();
+            }
+            return p;
+        }
+        static void* operator new(size_t size, const nothrow_t&) noexcept {
+            return OnReceivePool::get().allocMsg(size);
+        }
+        static void operator delete(void* p, size_t size) noexcept {
+            OnReceivePool::get().freeMsg(p, size);
+        }
         void proc() const {
             // Protobuff Encoding enabled, so we need to convert the message from proto
             // encoded format to local structure
-            PBLocAPIMsgHeader pbLocApiMsg;
+            PBLocAPIMsgHeader& pbLocApiMsg = mListener.mTaskCache.header;
             if (0 == pbLocApiMsg.ParseFromString(mMsgData)) {
                 LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %" PRIu32,
                         (uint32_t) mMsgData.length());
@@ -2857,7 +3209,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             }
 
             ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
-            string sockName = pbLocApiMsg.msocketname();
+            const string& sockName = pbLocApiMsg.msocketname();
             uint32_t payloadSize = pbLocApiMsg.payloadsize();
             // pbLocApiMsg.payload() contains the payload data.
 
@@ -2870,6 +3222,16 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 return;
             }
 
+            if (isReportMsg(locApiMsg.msgId)) {
+                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
+                        (mApiImpl.mPositionSessionResponseCbPending == false)) {
+                    dispatchReport(locApiMsg.msgId, pbLocApiMsg, mApiImpl.mCallbacksMask,
+                                   mApiImpl.mLocationCbs, mListener.mTaskCache,
+                                   mApiImpl.mPbufMsgConv);
+                }
+                return;
+            }
+
             switch (locApiMsg.msgId) {
             case E_LOCAPI_CAPABILILTIES_MSG_ID:
             {
@@ -2913,6 +3275,10 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 if (locApiMsg.msgId != E_LOCAPI_STOP_TRACKING_MSG_ID) {
                     LocAPIGenericRespMsg respMsg(sockName.c_str(), eLocMsgid, pbLocApiGenericRsp,
                             &mApiImpl.mPbufMsgConv);
+                    if ((E_LOCAPI_START_BATCHING_MSG_ID == locApiMsg.msgId) &&
+                            (LOCATION_ERROR_SUCCESS == respMsg.err) && mApiImpl.useBatchStore()) {
+                        mApiImpl.openBatchStore();
+                    }
                     mApiImpl.invokePositionSessionResponseCb(respMsg.err);
                 }
                 break;
@@ -2955,32 +3321,12 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 }
                 if (mApiImpl.mPositionSessionResponseCbPending) {
                     mApiImpl.mPositionSessionResponseCbPending = false;
+                    mApiImpl.publishDirectReportState();
                 }
                 break;
             }
 
             // async indication messages
-            case E_LOCAPI_LOCATION_MSG_ID:
-            {
-                LOC_LOGd("<<< message = simple location");
-                PBLocAPILocationIndMsg pbLocApiLocIndMsg;
-                if (0 == pbLocApiLocIndMsg.ParseFromString(pbLocApiMsg.payload())) {
-                    LOC_LOGe("Failed to parse pbLocApiLocIndMsg from payload!!");
-                    return;
-                }
-                LocAPILocationIndMsg msg(sockName.c_str(), pbLocApiLocIndMsg,
-                        &mApiImpl.mPbufMsgConv);
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mPositionSessionResponseCbPending == false) &&
-                        (mApiImpl.mCallbacksMask & E_LOC_CB_TRACKING_BIT)) {
-                    const LocAPILocationIndMsg* pLocationIndMsg = (LocAPILocationIndMsg*)(&msg);
-                    if (mApiImpl.mLocationCbs.trackingCb) {
-                        mApiImpl.mLocationCbs.trackingCb(pLocationIndMsg->locationNotification);
-                    }
-                }
-                break;
-            }
-
             case E_LOCAPI_BATCHING_MSG_ID:
             {
                 LOC_LOGd("<<< message = batching");
@@ -3005,6 +3351,12 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                         (BATCHING_STATUS_POSITION_UNAVAILABLE != batchStatus)) {
                         LOC_LOGe("invalid Batching Status!");
                         break;
+                    } else if ((BATCHING_STATUS_POSITION_AVAILABE == batchStatus) &&
+                            (0 != pBatchingIndMsg->batchStoreEndSeq)) {
+                        // fixes are in the batch store, batchingCb is called per chunk read
+                        mApiImpl.readBatchStore(pBatchingIndMsg->batchStoreEndSeq,
+                                                pBatchingIndMsg->batchingMode);
+                        break;
                     } else if (BATCHING_STATUS_POSITION_AVAILABE == batchStatus) {
                         int batchCount = pBatchingIndMsg->batchNotification.location.size();
                         LOC_LOGd("Batch count : %d", batchCount);
@@ -3072,27 +3424,6 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 break;
             }
 
-            case E_LOCAPI_LOCATION_INFO_MSG_ID:
-            {
-                LOC_LOGd("<<< message = location info");
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mPositionSessionResponseCbPending == false) &&
-                        (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT) &&
-                        (mApiImpl.mLocationCbs.gnssLocationInfoCb)) {
-                    PBLocAPILocationInfoIndMsg pbLocApiLocInfoIndMsg;
-                    if (0 == pbLocApiLocInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
-                        LOC_LOGe("Failed to parse pbLocApiLocInfoIndMsg from payload!!");
-                        return;
-                    }
-                    LocAPILocationInfoIndMsg msg(sockName.c_str(), pbLocApiLocInfoIndMsg,
-                            &mApiImpl.mPbufMsgConv);
-                    const LocAPILocationInfoIndMsg* pLocationInfoIndMsg =
-                        (LocAPILocationInfoIndMsg*)(&msg);
-                    mApiImpl.mLocationCbs.gnssLocationInfoCb(
-                            pLocationInfoIndMsg->gnssLocationInfoNotification);
-                }
-                break;
-            }
             case E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID:
             {
                 LOC_LOGd("<<< message = engine location info\n");
@@ -3123,72 +3454,6 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 break;
             }
 
-            case E_LOCAPI_SATELLITE_VEHICLE_MSG_ID:
-            {
-                LOC_LOGd("<<< message = sv");
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mPositionSessionResponseCbPending == false) &&
-                        (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_SV_BIT) &&
-                        (mApiImpl.mLocationCbs.gnssSvCb)) {
-                    PBLocAPISatelliteVehicleIndMsg pbLocApiSatVehIndMsg;
-                    if (0 == pbLocApiSatVehIndMsg.ParseFromString(pbLocApiMsg.payload())) {
-                        LOC_LOGe("Failed to parse pbLocApiSatVehIndMsg from payload!!");
-                        return;
-                    }
-                    LocAPISatelliteVehicleIndMsg msg(sockName.c_str(), pbLocApiSatVehIndMsg,
-                            &mApiImpl.mPbufMsgConv);
-                    const LocAPISatelliteVehicleIndMsg* pSvIndMsg =
-                        (LocAPISatelliteVehicleIndMsg*)(&msg);
-                    mApiImpl.mLocationCbs.gnssSvCb(pSvIndMsg->gnssSvNotification);
-                }
-                break;
-            }
-
-            case E_LOCAPI_NMEA_MSG_ID:
-            {
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mPositionSessionResponseCbPending == false) &&
-                        (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_NMEA_BIT) &&
-                        (mApiImpl.mLocationCbs.gnssNmeaCb)) {
-
-                    PBLocAPINmeaIndMsg pbLocApiNmeaIndMsg;
-                    if (0 == pbLocApiNmeaIndMsg.ParseFromString(pbLocApiMsg.payload())) {
-                        LOC_LOGe("Failed to parse pbLocApiNmeaIndMsg from payload!!");
-                        return;
-                    }
-                    LocAPINmeaIndMsg msg(sockName.c_str(), pbLocApiNmeaIndMsg,
-                            &mApiImpl.mPbufMsgConv);
-                    // nmea is variable length, can not be checked
-                    const LocAPINmeaIndMsg* pNmeaIndMsg = (LocAPINmeaIndMsg*)(&msg);
-                    ::GnssNmeaNotification nmeaNotif = {};
-                    nmeaNotif.size = sizeof(GnssNmeaNotification);
-                    nmeaNotif.timestamp = pNmeaIndMsg->gnssNmeaNotification.timestamp;
-                    nmeaNotif.nmea = pNmeaIndMsg->gnssNmeaNotification.nmea.c_str();
-                    nmeaNotif.length = pNmeaIndMsg->gnssNmeaNotification.nmea.length();
-                    mApiImpl.mLocationCbs.gnssNmeaCb(nmeaNotif);
-                }
-                break;
-            }
-
-            case E_LOCAPI_DATA_MSG_ID:
-            {
-                LOC_LOGd("<<< message = data");
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mPositionSessionResponseCbPending == false) &&
-                        (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_DATA_BIT) &&
-                        (mApiImpl.mLocationCbs.gnssDataCb)) {
-                    PBLocAPIDataIndMsg pbLocApiDataIndMsg;
-                    if (0 == pbLocApiDataIndMsg.ParseFromString(pbLocApiMsg.payload())) {
-                        LOC_LOGe("Failed to parse pbLocApiDataIndMsg from payload!!");
-                        return;
-                    }
-                    LocAPIDataIndMsg msg(sockName.c_str(), pbLocApiDataIndMsg,
-                            &mApiImpl.mPbufMsgConv);
-                    mApiImpl.mLocationCbs.gnssDataCb(msg.gnssDataNotification);
-                }
-                break;
-            }
-
             case E_LOCAPI_DC_REPORT_MSG_ID:
             {
                 LOC_LOGd("<<< message = DC report");
@@ -3207,36 +3472,6 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 break;
             }
 
-            case E_LOCAPI_MEAS_MSG_ID:
-            {
-                LOC_LOGd("<<< message = measurements");
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mPositionSessionResponseCbPending == false)) {
-                    PBLocAPIMeasIndMsg pbLocApiMeasIndMsg;
-                    if (0 == pbLocApiMeasIndMsg.ParseFromString(pbLocApiMsg.payload())) {
-                        LOC_LOGe("Failed to parse pbLocApiMeasIndMsg from payload!!");
-                        return;
-                    }
-                    LocAPIMeasIndMsg msg(sockName.c_str(), pbLocApiMeasIndMsg,
-                            &mApiImpl.mPbufMsgConv);
-                    const LocAPIMeasIndMsg* pMeasIndMsg = (LocAPIMeasIndMsg*)(&msg);
-                    if (pMeasIndMsg->gnssMeasurementsNotification.isNhz) {
-                        if ((mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_NHZ_MEAS_BIT) &&
-                                (nullptr != mApiImpl.mLocationCbs.gnssNHzMeasurementsCb)) {
-                            mApiImpl.mLocationCbs.gnssNHzMeasurementsCb(
-                                    pMeasIndMsg->gnssMeasurementsNotification);
-                        }
-                    } else {
-                        if ((mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_MEAS_BIT) &&
-                                (nullptr != mApiImpl.mLocationCbs.gnssMeasurementsCb)) {
-                            mApiImpl.mLocationCbs.gnssMeasurementsCb(
-                                    pMeasIndMsg->gnssMeasurementsNotification);
-                        }
-                    }
-                }
-                break;
-            }
-
             case E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID:
             {
                 LOC_LOGd("<<< message = GNSS power consumption\n");
@@ -3392,11 +3627,42 @@ void IpcListener::onReceive(const char* data, uint32_t length,
         }
         LocationClientApiImpl& mApiImpl;
         IpcListener& mListener;
-        const string mMsgData;
+        string mMsgData;
     };
+
+    if (mApiImpl.mDirectReportDispatch.load() && dispatchReportDirect(data, length)) {
+        return;
+    }
     mMsgTask.sendMsg(new (nothrow) OnReceiveHandler(mApiImpl, *this, data, length));
 }
 
+// Runs on the receiver thread. Returns false when the message has to go through
+// mMsgTask instead: anything but a report, or a report while the session state is
+// in flux, where mMsgTask has the final say on whether it is delivered.
+bool IpcListener::dispatchReportDirect(const char* data, uint32_t length) {
+    PBLocAPIMsgHeader& pbLocApiMsg = mDirectCache.header;
+    if (0 == pbLocApiMsg.ParseFromArray(data, length)) {
+        return false;
+    }
+    ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
+    if (!isReportMsg(eLocMsgid)) {
+        return false;
+    }
+    LocAPIMsgHeader locApiMsg(pbLocApiMsg.msocketname().c_str(), eLocMsgid);
+    // throw away message that does not come from location hal daemon
+    if (false == locApiMsg.isValidServerMsg(pbLocApiMsg.payloadsize())) {
+        return true;
+    }
+
+    lock_guard<mutex> lock(mApiImpl.mDirectReportMutex);
+    if (!mApiImpl.mDirectReportSessionActive) {
+        return false;
+    }
+    dispatchReport(eLocMsgid, pbLocApiMsg, mApiImpl.mDirectReportCbsMask,
+                   mApiImpl.mDirectReportCbs, mDirectCache, mApiImpl.mPbufMsgConv);
+    return true;
+}
+
 /******************************************************************************
 LocationClientApiImpl - Not implemented overrides
 ******************************************************************************/
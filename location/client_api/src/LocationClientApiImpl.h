@@ -66,6 +66,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define LOCATIONCLIENTAPIIMPL_H
 
 #include <mutex>
+#include <atomic>
 
 #include <loc_pla.h>
 #include <LocIpc.h>
@@ -74,6 +75,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <MsgTask.h>
 #include <LocationApiMsg.h>
 #include <LocationApiPbMsgConv.h>
+#include <LocationApiBatchStore.h>
 #include <LCAReportLoggerUtil.h>
 #ifdef NO_UNORDERED_SET_OR_MAP
     #include <set>
@@ -217,6 +219,7 @@ public:
                       responseCallback responseCb);
 
     void pingTest(PingTestCb pingTestCallback);
+    void setDirectReportDispatch(bool enable);
 
     static LocationSystemInfo parseLocationSystemInfo(
             const::LocationSystemInfo &halSystemInfo);
@@ -281,9 +284,13 @@ private:
     }
 
     void invokePositionSessionResponseCb(LocationError errCode);
+    void publishDirectReportState();
     void diagLogGnssLocation(const GnssLocation &gnssLocation);
     void processGetDebugRespCb(const LocAPIGetDebugRespMsg* pRespMsg);
     void processAntennaInfo(const LocAPIAntennaInfoMsg* pAntennaInfoMsg);
+    bool useBatchStore() const;
+    void openBatchStore();
+    void readBatchStore(uint64_t endSeq, BatchingMode batchingMode);
 
     // protobuf conversion util class
     LocationApiPbMsgConv mPbufMsgConv;
@@ -314,9 +321,24 @@ private:
     GnssDebugReport*           mpDebugReport;
     AntennaInfoCallback*       mpAntennaInfoCb;
 
+    // batched fixes are read from here when the daemon puts them in a store,
+    // see LocationApiBatchStore
+    std::unique_ptr<LocationApiBatchStore> mBatchStore;
+    LocationApiBatchStore::Cursor mBatchCursor;
+    bool                       mBatchStoreDisabled;
+    std::vector<::Location>    mBatchFixes;
+
     // callbacks
     LocationCallbacks       mLocationCbs;
 
+    // copy of the session state and callbacks for the reports dispatched on
+    // the IpcListener receiver threads, see setDirectReportDispatch()
+    std::atomic<bool>          mDirectReportDispatch;
+    std::mutex                 mDirectReportMutex;
+    bool                       mDirectReportSessionActive;
+    LocationCallbacksMask      mDirectReportCbsMask;
+    LocationCallbacks          mDirectReportCbs;
+
     //TODO:: remove after replacing all calls with ILocationAPI callbacks
     capabilitiesCallback    mCapabilitiesCb;
     PingTestCb              mPingTestCb;
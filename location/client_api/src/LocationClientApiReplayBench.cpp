@@ -0,0 +1,494 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Replays location hal daemon traffic into a LocationClientApi and measures how
+the reports reach the callbacks, once with the default dispatch through the
+LocationClientApi thread and once with setDirectReportDispatch(true):
+ - latency: one report at a time, from sending it to its first callback
+ - throughput: all reports back to back, until the last callback
+ - heap allocations per report made by the whole process meanwhile
+
+The benchmark takes the place of location_hal_daemon on its socket, so the
+daemon has to be stopped first. It answers the client registration and the
+start of the position session, then sends the reports of the trace.
+
+The trace is synthesized, location info, SVs, NMEA, data and measurements for
+each fix, or read from a file of captured datagrams: each one a 32 bit length
+in host byte order followed by the serialized PBLocAPIMsgHeader as sent by the
+daemon. Only the reports of a capture are replayed. -w writes the synthesized
+trace in that format.
+
+usage: location_client_api_replay_bench [-f capture] [-w file] [-n fixes]
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <LocationClientApi.h>
+#include <LocationApiMsg.h>
+
+#define DEFAULT_FIXES           200
+#define NUM_SVS                 40
+#define NUM_MEASUREMENTS        32
+#define NUM_NMEA                6
+#define SETUP_TIMEOUT_MS        5000
+#define REPORT_TIMEOUT_NS       100000000ULL    // report that gets no callback
+#define QUIET_NS                1000000ULL      // no more callbacks for this report
+
+static std::atomic<uint64_t> sAllocCount(0);
+
+void* operator new(size_t size) {
+    sAllocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// callbacks of the client, serialized by either dispatch mode
+static std::atomic<uint64_t> sCbCount(0);
+static std::atomic<uint64_t> sCbMark(0);
+static std::atomic<uint64_t> sFirstCbNs(0);
+static std::atomic<uint64_t> sLastCbNs(0);
+
+static void onReport() {
+    uint64_t now = nowNs();
+    if (sCbCount.load() == sCbMark.load()) {
+        sFirstCbNs.store(now);
+    }
+    sLastCbNs.store(now);
+    sCbCount.fetch_add(1);
+}
+
+/******************************************************************************
+Stand-in for location_hal_daemon
+******************************************************************************/
+class FakeHalDaemon : public ILocIpcListener {
+public:
+    void onReceive(const char* data, uint32_t length, const LocIpcRecver*) override {
+        PBLocAPIMsgHeader hdr;
+        if (!hdr.ParseFromArray(data, length)) {
+            return;
+        }
+        switch (hdr.msgid()) {
+        case PB_E_LOCAPI_CLIENT_REGISTER_MSG_ID:
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClient = SockNode::create(hdr.msocketname()).createSender();
+            PBLocAPICapabilitiesIndMsg caps;
+            caps.set_capabilitiesmask(PB_LOCATION_CAPS_TIME_BASED_TRACKING_BIT |
+                                      PB_LOCATION_CAPS_GNSS_MEASUREMENTS_BIT);
+            sendLocked(PB_E_LOCAPI_CAPABILILTIES_MSG_ID, caps);
+            break;
+        }
+        case PB_E_LOCAPI_START_TRACKING_MSG_ID:
+        case PB_E_LOCAPI_STOP_TRACKING_MSG_ID:
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            PBLocAPIGenericRespMsg resp;
+            resp.set_err(PB_LOCATION_ERROR_SUCCESS);
+            sendLocked((PBELocMsgID)hdr.msgid(), resp);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    bool send(const std::string& datagram) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return (nullptr != mClient) && LocIpc::send(*mClient,
+                reinterpret_cast<const uint8_t*>(datagram.data()), datagram.size());
+    }
+
+private:
+    void sendLocked(PBELocMsgID msgId, const google::protobuf::MessageLite& payload) {
+        PBLocAPIMsgHeader hdr;
+        std::string out;
+        hdr.set_msocketname(SERVICE_NAME);
+        hdr.set_msgid(msgId);
+        hdr.set_msgversion(LOCATION_REMOTE_API_MSG_VERSION);
+        hdr.set_payload(payload.SerializeAsString());
+        if ((nullptr != mClient) && hdr.SerializeToString(&out)) {
+            LocIpc::send(*mClient, reinterpret_cast<const uint8_t*>(out.data()), out.size());
+        }
+    }
+
+    std::mutex mMutex;
+    std::shared_ptr<LocIpcSender> mClient;
+};
+
+/******************************************************************************
+Trace
+******************************************************************************/
+static void addReport(std::vector<std::string>& trace, PBELocMsgID msgId,
+                      const google::protobuf::MessageLite& payload) {
+    PBLocAPIMsgHeader hdr;
+    hdr.set_msocketname(SERVICE_NAME);
+    hdr.set_msgid(msgId);
+    hdr.set_msgversion(LOCATION_REMOTE_API_MSG_VERSION);
+    hdr.set_payload(payload.SerializeAsString());
+    trace.emplace_back(hdr.SerializeAsString());
+}
+
+static void synthesizeTrace(std::vector<std::string>& trace, int fixes) {
+    static const char* nmea[NUM_NMEA] = {
+        "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n",
+        "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n",
+        "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n",
+        "$GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14*79\r\n",
+        "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n",
+        "$GPVTG,31.66,T,,M,0.02,N,0.04,K,A*30\r\n",
+    };
+
+    for (int fix = 0; fix < fixes; fix++) {
+        uint64_t timestamp = 1660000000000ULL + fix * 1000;
+
+        PBLocAPILocationInfoIndMsg locInfo;
+        PBGnssLocationInfoNotification* info = locInfo.mutable_gnsslocationinfonotification();
+        PBLocation* location = info->mutable_location();
+        location->set_flags(0x1ff);
+        location->set_timestamp(timestamp);
+        location->set_latitude(37.4219999 + fix * 1e-7);
+        location->set_longitude(-122.0840575 - fix * 1e-7);
+        location->set_altitude(12.5);
+        location->set_speed(1.25f);
+        location->set_bearing(93.5f);
+        location->set_horizontalaccuracy(3.2f);
+        location->set_verticalaccuracy(4.8f);
+        location->set_techmask(0x1);
+        info->set_flags(0x7f);
+        info->set_altitudemeansealevel(-20.5f);
+        info->set_pdop(1.7f);
+        info->set_hdop(1.0f);
+        info->set_vdop(1.4f);
+        addReport(trace, PB_E_LOCAPI_LOCATION_INFO_MSG_ID, locInfo);
+
+        PBLocAPISatelliteVehicleIndMsg sv;
+        PBLocApiGnssSvNotification* svNotif = sv.mutable_gnsssvnotification();
+        svNotif->set_gnsssignaltypemaskvalid(true);
+        for (int i = 0; i < NUM_SVS; i++) {
+            PBLocApiGnssSv* gnssSv = svNotif->add_gnsssvs();
+            gnssSv->set_svid(i + 1);
+            gnssSv->set_type((PBLocApiGnss_LocSvSystemEnumType)(i % 6 + 1));
+            gnssSv->set_cn0dbhz(20.0f + (float)((fix + i) % 300) / 10.0f);
+            gnssSv->set_elevation((float)(i * 7 % 90));
+            gnssSv->set_azimuth((float)((fix + i * 13) % 360));
+            gnssSv->set_gnsssvoptionsmask((fix ^ i) & 0x7);
+            gnssSv->set_carrierfrequencyhz(1575420000.0f);
+            gnssSv->set_gnsssignaltypemask(1 << (i % 12));
+        }
+        addReport(trace, PB_E_LOCAPI_SATELLITE_VEHICLE_MSG_ID, sv);
+
+        for (int i = 0; i < NUM_NMEA; i++) {
+            PBLocAPINmeaIndMsg nmeaMsg;
+            nmeaMsg.mutable_gnssnmeanotification()->set_timestamp(timestamp);
+            nmeaMsg.mutable_gnssnmeanotification()->set_nmea(nmea[i]);
+            addReport(trace, PB_E_LOCAPI_NMEA_MSG_ID, nmeaMsg);
+        }
+
+        PBLocAPIDataIndMsg data;
+        PBGnssDataNotification* dataNotif = data.mutable_gnssdatanotification();
+        dataNotif->set_numbersignaltypes(20);
+        for (int i = 0; i < 20; i++) {
+            dataNotif->add_gnssdatamask(0x3);
+            dataNotif->add_jammerind(i * 0.5);
+            dataNotif->add_agc(-i * 0.25);
+        }
+        addReport(trace, PB_E_LOCAPI_DATA_MSG_ID, data);
+
+        PBLocAPIMeasIndMsg meas;
+        PBGnssMeasurementsNotification* measNotif = meas.mutable_gnssmeasurementsnotification();
+        for (int i = 0; i < NUM_MEASUREMENTS; i++) {
+            PBGnssMeasurementsData* m = measNotif->add_measurements();
+            m->set_flags(0x3ffff);
+            m->set_svid(i + 1);
+            m->set_svtype((PBLocApiGnss_LocSvSystemEnumType)(i % 6 + 1));
+            m->set_statemask(0x3fff);
+            m->set_receivedsvtimens(123456789012LL + fix * 1000 + i);
+            m->set_receivedsvtimeuncertaintyns(15);
+            m->set_carriertonoisedbhz(38.25 + i % 10);
+            m->set_pseudorangeratemps(-512.5 + i);
+            m->set_adrstatemask(1);
+            m->set_adrmeters(20000000.0 + fix);
+            m->set_carrierfrequencyhz(1575420000.0f);
+        }
+        PBGnssMeasurementsClock* clock = measNotif->mutable_clock();
+        clock->set_flags(0x7f);
+        clock->set_leapsecond(18);
+        clock->set_timens(1660000000000000000LL + fix * 1000000000LL);
+        addReport(trace, PB_E_LOCAPI_MEAS_MSG_ID, meas);
+    }
+}
+
+static bool isReport(const std::string& datagram) {
+    PBLocAPIMsgHeader hdr;
+    if (!hdr.ParseFromString(datagram)) {
+        return false;
+    }
+    switch (hdr.msgid()) {
+    case PB_E_LOCAPI_LOCATION_MSG_ID:
+    case PB_E_LOCAPI_LOCATION_INFO_MSG_ID:
+    case PB_E_LOCAPI_SATELLITE_VEHICLE_MSG_ID:
+    case PB_E_LOCAPI_NMEA_MSG_ID:
+    case PB_E_LOCAPI_DATA_MSG_ID:
+    case PB_E_LOCAPI_MEAS_MSG_ID:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool readTrace(const char* path, std::vector<std::string>& trace) {
+    FILE* f = fopen(path, "rb");
+    uint32_t length;
+    size_t skipped = 0;
+
+    if (nullptr == f) {
+        perror(path);
+        return false;
+    }
+    while (1 == fread(&length, sizeof(length), 1, f)) {
+        std::string datagram(length, '\0');
+        if (length != fread(&datagram[0], 1, length, f)) {
+            fprintf(stderr, "%s: truncated\n", path);
+            break;
+        }
+        if (isReport(datagram)) {
+            trace.push_back(std::move(datagram));
+        } else {
+            skipped++;
+        }
+    }
+    fclose(f);
+    printf("%s: %zu reports, %zu other messages skipped\n", path, trace.size(), skipped);
+    return !trace.empty();
+}
+
+static bool writeTrace(const char* path, const std::vector<std::string>& trace) {
+    FILE* f = fopen(path, "wb");
+    if (nullptr == f) {
+        perror(path);
+        return false;
+    }
+    for (const std::string& datagram : trace) {
+        uint32_t length = datagram.size();
+        fwrite(&length, sizeof(length), 1, f);
+        fwrite(datagram.data(), 1, length, f);
+    }
+    return 0 == fclose(f);
+}
+
+/******************************************************************************
+Measurements
+******************************************************************************/
+static void waitQuiet(uint64_t timeoutNs) {
+    uint64_t start = nowNs();
+    uint64_t count = sCbCount.load();
+    uint64_t since = start;
+
+    while (nowNs() - start < timeoutNs) {
+        std::this_thread::yield();
+        uint64_t n = sCbCount.load();
+        if (n != count) {
+            count = n;
+            since = nowNs();
+        } else if (n != sCbMark.load() && nowNs() - since > QUIET_NS) {
+            break;
+        }
+    }
+}
+
+static uint64_t percentileUs(const std::vector<uint64_t>& sortedNs, int percent) {
+    size_t i = (sortedNs.size() * percent + 99) / 100;
+    return sortedNs[i ? i - 1 : 0] / 1000;
+}
+
+static void runMode(const char* name, FakeHalDaemon& daemon,
+                    const std::vector<std::string>& trace) {
+    std::vector<uint64_t> latencies;
+    uint64_t start, allocs, expected, sent;
+
+    // latency, also finds out how many callbacks the trace makes
+    latencies.reserve(trace.size());
+    start = sCbCount.load();
+    for (const std::string& datagram : trace) {
+        sCbMark.store(sCbCount.load());
+        uint64_t sendNs = nowNs();
+        daemon.send(datagram);
+        waitQuiet(REPORT_TIMEOUT_NS);
+        if (sCbCount.load() != sCbMark.load()) {
+            latencies.push_back(sFirstCbNs.load() - sendNs);
+        }
+    }
+    expected = sCbCount.load() - start;
+    if (latencies.empty()) {
+        printf("%-8s no callbacks, is location_hal_daemon still running?\n", name);
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // throughput
+    sCbMark.store(sCbCount.load());
+    start = sCbCount.load();
+    allocs = sAllocCount.load();
+    sent = nowNs();
+    for (const std::string& datagram : trace) {
+        daemon.send(datagram);
+    }
+    uint64_t sendDone = nowNs();
+    while (sCbCount.load() - start < expected &&
+            nowNs() - std::max(sLastCbNs.load(), sendDone) < REPORT_TIMEOUT_NS) {
+        std::this_thread::yield();
+    }
+    uint64_t elapsedNs = sLastCbNs.load() - sent;
+    allocs = sAllocCount.load() - allocs;
+
+    printf("%-8s latency p50 %4" PRIu64 " us  p99 %5" PRIu64 " us  max %5" PRIu64 " us  "
+           "%8.0f reports/s  %6.2f allocs/report  %" PRIu64 "/%" PRIu64 " callbacks\n",
+           name, percentileUs(latencies, 50), percentileUs(latencies, 99),
+           latencies.back() / 1000, trace.size() * 1e9 / (elapsedNs ? elapsedNs : 1),
+           (double)allocs / trace.size(), sCbCount.load() - start, expected);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> trace;
+    const char* capture = nullptr;
+    const char* output = nullptr;
+    int fixes = DEFAULT_FIXES;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:w:n:")) != -1) {
+        switch (opt) {
+        case 'f': capture = optarg; break;
+        case 'w': output = optarg; break;
+        case 'n': fixes = atoi(optarg); break;
+        default:
+            printf("usage: %s [-f capture] [-w file] [-n fixes]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (nullptr != capture) {
+        if (!readTrace(capture, trace)) {
+            return 1;
+        }
+    } else {
+        synthesizeTrace(trace, fixes > 0 ? fixes : DEFAULT_FIXES);
+        if (nullptr != output) {
+            return writeTrace(output, trace) ? 0 : 1;
+        }
+    }
+
+    auto daemon = std::make_shared<FakeHalDaemon>();
+    auto recver = LocIpc::getLocIpcLocalRecver(daemon, SOCKET_TO_LOCATION_HAL_DAEMON);
+    LocIpc ipc;
+    ipc.startNonBlockingListening(recver);
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool capable = false, started = false;
+    location_client::LocationClientApi client(
+            [&](location_client::LocationCapabilitiesMask) {
+                std::lock_guard<std::mutex> lock(mutex);
+                capable = true;
+                cond.notify_all();
+            });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!cond.wait_for(lock, std::chrono::milliseconds(SETUP_TIMEOUT_MS),
+                           [&] { return capable; })) {
+            printf("client did not register\n");
+            return 1;
+        }
+    }
+
+    location_client::GnssReportCbs cbs;
+    cbs.gnssLocationCallback = [](const location_client::GnssLocation&) { onReport(); };
+    cbs.gnssSvCallback = [](const std::vector<location_client::GnssSv>&) { onReport(); };
+    cbs.gnssNmeaCallback = [](uint64_t, const std::string&) { onReport(); };
+    cbs.gnssDataCallback = [](const location_client::GnssData&) { onReport(); };
+    cbs.gnssMeasurementsCallback =
+            [](const location_client::GnssMeasurements&) { onReport(); };
+    client.startPositionSession(1000, cbs, [&](location_client::LocationResponse) {
+                std::lock_guard<std::mutex> lock(mutex);
+                started = true;
+                cond.notify_all();
+            });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!cond.wait_for(lock, std::chrono::milliseconds(SETUP_TIMEOUT_MS),
+                           [&] { return started; })) {
+            printf("position session did not start\n");
+            return 1;
+        }
+    }
+
+    printf("%zu reports per pass\n", trace.size());
+    runMode("msgtask", *daemon, trace);
+    client.setDirectReportDispatch(true);
+    // setDirectReportDispatch() takes effect on the client thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    runMode("direct", *daemon, trace);
+
+    client.stopPositionSession();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return 0;
+}
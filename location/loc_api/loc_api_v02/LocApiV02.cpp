@@ -369,6 +369,8 @@ LocApiV02 :: LocApiV02(LOC_API_ADAPTER_EVENT_MASK_T exMask,
     mMasterRegisterNotSupported(false),
     mCounter(0), mMinInterval(1000),
     mGnssMeasurements(nullptr),
+    mPrevMeasRefFCount(0),
+    mNewMeasProcessed(false),
     mBatchSize(0), mDesiredBatchSize(0),
     mTripBatchSize(0), mDesiredTripBatchSize(0),
     mUseBatching1_0(1),
@@ -3749,45 +3751,146 @@ void  LocApiV02 :: reportSv (
     LocApiBase::reportSv(SvNotify);
 }
 
-static Gnss_LocSvSystemEnumType getLocApiSvSystemType (qmiLocSvSystemEnumT_v02 qmiSvSystemType) {
-    Gnss_LocSvSystemEnumType locSvSystemType = GNSS_LOC_SV_SYSTEM_UNKNOWN;
-
-    switch (qmiSvSystemType) {
-    case eQMI_LOC_SV_SYSTEM_GPS_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_GPS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_GALILEO_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_GALILEO;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_SBAS_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_SBAS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_GLONASS_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_GLONASS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_BDS_V02:
-    case eQMI_LOC_SV_SYSTEM_COMPASS_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_BDS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_QZSS_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_QZSS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_NAVIC_V02:
-        locSvSystemType = GNSS_LOC_SV_SYSTEM_NAVIC;
-        break;
+/* Measurement conversion for each QMI sv system, replaces the per constellation switches.
+   GLONASS time is carried by gloTime, so it has no system time entry. */
+typedef struct {
+    qmiLocSvSystemEnumT_v02 qmiSystem;
+    Gnss_LocSvSystemEnumType locSystem;
+    GnssSvType svType;
+    GnssSystemTimeStructType GnssSvMeasurementHeader::* systemTime;
+    Gnss_LocGnssTimeExtStructType GnssSvMeasurementHeader::* systemTimeExt;
+    GpsSvMeasHeaderFlags systemTimeFlag;
+    GpsSvMeasHeaderFlags systemTimeExtFlag;
+    /* where the system clock bias goes for setGnssBiases(), if it is used */
+    float timeBiases::* clkBias;
+    float timeBiases::* clkBiasUnc;
+    uint64_t clkBiasFlags;
+} measSystemConv;
+
+static const measSystemConv sMeasSystemConv[] = {
+    { eQMI_LOC_SV_SYSTEM_GPS_V02, GNSS_LOC_SV_SYSTEM_GPS, GNSS_SV_TYPE_GPS,
+      &GnssSvMeasurementHeader::gpsSystemTime, &GnssSvMeasurementHeader::gpsSystemTimeExt,
+      GNSS_SV_MEAS_HEADER_HAS_GPS_SYSTEM_TIME, GNSS_SV_MEAS_HEADER_HAS_GPS_SYSTEM_TIME_EXT,
+      &timeBiases::gpsL1, &timeBiases::gpsL1Unc, BIAS_GPSL1_VALID | BIAS_GPSL1_UNC_VALID },
+    { eQMI_LOC_SV_SYSTEM_GALILEO_V02, GNSS_LOC_SV_SYSTEM_GALILEO, GNSS_SV_TYPE_GALILEO,
+      &GnssSvMeasurementHeader::galSystemTime, &GnssSvMeasurementHeader::galSystemTimeExt,
+      GNSS_SV_MEAS_HEADER_HAS_GAL_SYSTEM_TIME, GNSS_SV_MEAS_HEADER_HAS_GAL_SYSTEM_TIME_EXT,
+      &timeBiases::galE1, &timeBiases::galE1Unc, BIAS_GALE1_VALID | BIAS_GALE1_UNC_VALID },
+    { eQMI_LOC_SV_SYSTEM_SBAS_V02, GNSS_LOC_SV_SYSTEM_SBAS, GNSS_SV_TYPE_SBAS,
+      nullptr, nullptr, 0, 0,
+      nullptr, nullptr, 0 },
+    { eQMI_LOC_SV_SYSTEM_GLONASS_V02, GNSS_LOC_SV_SYSTEM_GLONASS, GNSS_SV_TYPE_GLONASS,
+      nullptr, &GnssSvMeasurementHeader::gloSystemTimeExt,
+      0, GNSS_SV_MEAS_HEADER_HAS_GLO_SYSTEM_TIME_EXT,
+      nullptr, nullptr, 0 },
+    { eQMI_LOC_SV_SYSTEM_BDS_V02, GNSS_LOC_SV_SYSTEM_BDS, GNSS_SV_TYPE_BEIDOU,
+      &GnssSvMeasurementHeader::bdsSystemTime, &GnssSvMeasurementHeader::bdsSystemTimeExt,
+      GNSS_SV_MEAS_HEADER_HAS_BDS_SYSTEM_TIME, GNSS_SV_MEAS_HEADER_HAS_BDS_SYSTEM_TIME_EXT,
+      &timeBiases::bdsB1, &timeBiases::bdsB1Unc, BIAS_BDSB1_VALID | BIAS_BDSB1_UNC_VALID },
+    /* deprecated alias of BDS, its measurements never had an sv type */
+    { eQMI_LOC_SV_SYSTEM_COMPASS_V02, GNSS_LOC_SV_SYSTEM_BDS, GNSS_SV_TYPE_UNKNOWN,
+      &GnssSvMeasurementHeader::bdsSystemTime, &GnssSvMeasurementHeader::bdsSystemTimeExt,
+      GNSS_SV_MEAS_HEADER_HAS_BDS_SYSTEM_TIME, GNSS_SV_MEAS_HEADER_HAS_BDS_SYSTEM_TIME_EXT,
+      &timeBiases::bdsB1, &timeBiases::bdsB1Unc, BIAS_BDSB1_VALID | BIAS_BDSB1_UNC_VALID },
+    { eQMI_LOC_SV_SYSTEM_QZSS_V02, GNSS_LOC_SV_SYSTEM_QZSS, GNSS_SV_TYPE_QZSS,
+      &GnssSvMeasurementHeader::qzssSystemTime, &GnssSvMeasurementHeader::qzssSystemTimeExt,
+      GNSS_SV_MEAS_HEADER_HAS_QZSS_SYSTEM_TIME, GNSS_SV_MEAS_HEADER_HAS_QZSS_SYSTEM_TIME_EXT,
+      nullptr, nullptr, 0 },
+    { eQMI_LOC_SV_SYSTEM_NAVIC_V02, GNSS_LOC_SV_SYSTEM_NAVIC, GNSS_SV_TYPE_NAVIC,
+      &GnssSvMeasurementHeader::navicSystemTime, &GnssSvMeasurementHeader::navicSystemTimeExt,
+      GNSS_SV_MEAS_HEADER_HAS_NAVIC_SYSTEM_TIME, GNSS_SV_MEAS_HEADER_HAS_NAVIC_SYSTEM_TIME_EXT,
+      nullptr, nullptr, 0 },
+};
 
-    default:
-        break;
-    }
+static const measSystemConv* getMeasSystemConv(qmiLocSvSystemEnumT_v02 qmiSvSystemType) {
+    for (const measSystemConv& conv : sMeasSystemConv) {
+        if (conv.qmiSystem == qmiSvSystemType) {
+            return &conv;
+        }
+    }
+    return nullptr;
+}
+
+/* Inter system and inter signal biases of the measurement header. The ones used by
+   setGnssBiases() also say where their time bias and its uncertainty are kept, in ns
+   and with the sign setGnssBiases() expects. */
+typedef struct {
+    const char* name;
+    uint8_t qmiLocEventGnssSvMeasInfoIndMsgT_v02::* valid;
+    qmiLocInterSystemBiasStructT_v02 qmiLocEventGnssSvMeasInfoIndMsgT_v02::* bias;
+    Gnss_InterSystemBiasStructType GnssSvMeasurementHeader::* headerBias;
+    GpsSvMeasHeaderFlags headerFlag;
+    float sign;
+    float timeBiases::* timeBias;
+    uint64_t timeBiasFlag;
+    float timeBiases::* timeBiasUnc;
+    uint64_t timeBiasUncFlag;
+} interSystemBiasConv;
+
+#define MEAS_BIAS(qmiField, headerField, headerFlag) \
+    #headerField, \
+    &qmiLocEventGnssSvMeasInfoIndMsgT_v02::qmiField##_valid, \
+    &qmiLocEventGnssSvMeasInfoIndMsgT_v02::qmiField, \
+    &GnssSvMeasurementHeader::headerField, headerFlag
+#define MEAS_TIME_BIAS(sign, field, flag) \
+    sign, &timeBiases::field, flag##_VALID, &timeBiases::field##Unc, flag##_UNC_VALID
+#define MEAS_NO_TIME_BIAS 0.0f, nullptr, 0, nullptr, 0
+
+static const interSystemBiasConv sInterSystemBiasConv[] = {
+    { MEAS_BIAS(gpsGloInterSystemBias, gpsGloInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GPS_GLO_INTER_SYSTEM_BIAS),
+      MEAS_TIME_BIAS(-1.0f, gpsL1_gloG1, BIAS_GPSL1_GLOG1) },
+    { MEAS_BIAS(gpsBdsInterSystemBias, gpsBdsInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GPS_BDS_INTER_SYSTEM_BIAS),
+      MEAS_TIME_BIAS(-1.0f, gpsL1_bdsB1, BIAS_GPSL1_BDSB1) },
+    { MEAS_BIAS(gpsGalInterSystemBias, gpsGalInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GPS_GAL_INTER_SYSTEM_BIAS),
+      MEAS_TIME_BIAS(-1.0f, gpsL1_galE1, BIAS_GPSL1_GALE1) },
+    { MEAS_BIAS(bdsGloInterSystemBias, bdsGloInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_BDS_GLO_INTER_SYSTEM_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(galGloInterSystemBias, galGloInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GAL_GLO_INTER_SYSTEM_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(galBdsInterSystemBias, galBdsInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GAL_BDS_INTER_SYSTEM_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(gpsNavicInterSystemBias, gpsNavicInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GPS_NAVIC_INTER_SYSTEM_BIAS),
+      MEAS_TIME_BIAS(-1.0f, gpsL1_navic, BIAS_GPSL1_NAVIC) },
+    { MEAS_BIAS(galNavicInterSystemBias, galNavicInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GAL_NAVIC_INTER_SYSTEM_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(gloNavicInterSystemBias, gloNavicInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_GLO_NAVIC_INTER_SYSTEM_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(bdsNavicInterSystemBias, bdsNavicInterSystemBias,
+                GNSS_SV_MEAS_HEADER_HAS_BDS_NAVIC_INTER_SYSTEM_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(GpsL1L5TimeBias, gpsL1L5TimeBias, GNSS_SV_MEAS_HEADER_HAS_GPSL1L5_TIME_BIAS),
+      MEAS_TIME_BIAS(-1.0f, gpsL1_gpsL5, BIAS_GPSL1_GPSL5) },
+    { MEAS_BIAS(GalE1E5aTimeBias, galE1E5aTimeBias, GNSS_SV_MEAS_HEADER_HAS_GALE1E5A_TIME_BIAS),
+      MEAS_TIME_BIAS(-1.0f, galE1_galE5a, BIAS_GALE1_GALE5A) },
+    { MEAS_BIAS(BdsB1iB2aTimeBias, bdsB1iB2aTimeBias,
+                GNSS_SV_MEAS_HEADER_HAS_BDSB1IB2A_TIME_BIAS),
+      MEAS_TIME_BIAS(-1.0f, bdsB1_bdsB2a, BIAS_BDSB1_BDSB2A) },
+    { MEAS_BIAS(BdsB1iB2biTimeBias, bdsB1iB2biTimeBias,
+                GNSS_SV_MEAS_HEADER_HAS_BDSB1IB2BI_TIME_BIAS),
+      MEAS_TIME_BIAS(1.0f, bdsB1_bdsB2bi, BIAS_BDSB1_BDSB2BI) },
+    { MEAS_BIAS(BdsB1iB1cTimeBias, bdsB1iB1cTimeBias,
+                GNSS_SV_MEAS_HEADER_HAS_BDSB1IB1C_TIME_BIAS),
+      MEAS_TIME_BIAS(-1.0f, bdsB1_bdsB1c, BIAS_BDSB1_BDSB1C) },
+    { MEAS_BIAS(GpsL1L2cTimeBias, gpsL1L2cTimeBias, GNSS_SV_MEAS_HEADER_HAS_GPSL1L2C_TIME_BIAS),
+      MEAS_TIME_BIAS(1.0f, gpsL1_gpsL2c, BIAS_GPSL1_GPSL2C) },
+    { MEAS_BIAS(GloG1G2TimeBias, gloG1G2TimeBias, GNSS_SV_MEAS_HEADER_HAS_GLOG1G2_TIME_BIAS),
+      MEAS_NO_TIME_BIAS },
+    { MEAS_BIAS(GalE1E5bTimeBias, galE1E5bTimeBias, GNSS_SV_MEAS_HEADER_HAS_GALE1E5B_TIME_BIAS),
+      MEAS_TIME_BIAS(1.0f, galE1_galE5b, BIAS_GALE1_GALE5B) },
+};
 
-    return locSvSystemType;
-}
+#undef MEAS_BIAS
+#undef MEAS_TIME_BIAS
+#undef MEAS_NO_TIME_BIAS
 
 /* convert satellite polynomial to loc eng format and  send the converted
    report to loc eng */
@@ -5186,8 +5289,6 @@ void LocApiV02::reportGnssMeasurementData(
 {
     LOC_LOGv("entering");
 
-    static uint32_t prevRefFCount = 0;
-    static bool newMeasProcessed = false;
     uint8_t maxSubSeqNum = 0;
     uint8_t subSeqNum = 0;
 
@@ -5214,14 +5315,16 @@ void LocApiV02::reportGnssMeasurementData(
              gnss_measurement_report_ptr.svMeasurement_valid,
              gnss_measurement_report_ptr.svMeasurement_len);
 
+    // one buffer for the lifetime of the LocApi, every part of an epoch is converted
+    // straight into it and resetSvMeasurementReport() only clears what got filled
     if (!mGnssMeasurements) {
-        mGnssMeasurements = (GnssMeasurements*)malloc(sizeof(GnssMeasurements));
+        mGnssMeasurements = (GnssMeasurements*)calloc(1, sizeof(GnssMeasurements));
         if (!mGnssMeasurements) {
             LOC_LOGe("Malloc failed to allocate heap memory for mGnssMeasurements");
             return;
         }
         resetSvMeasurementReport();
-        newMeasProcessed = false;
+        mNewMeasProcessed = false;
     }
 
     if (gnss_measurement_report_ptr.seqNum > gnss_measurement_report_ptr.maxMessageNum ||
@@ -5234,20 +5337,20 @@ void LocApiV02::reportGnssMeasurementData(
     // to reset the measurement
     if ((gnss_measurement_report_ptr.seqNum == 1 && subSeqNum <= 1) ||
         (gnss_measurement_report_ptr.systemTimeExt_valid &&
-         gnss_measurement_report_ptr.systemTimeExt.refFCount != prevRefFCount)) {
+         gnss_measurement_report_ptr.systemTimeExt.refFCount != mPrevMeasRefFCount)) {
         // we have received some valid info since we last reported when
         // seq num matches with max seq num
-        if (true == newMeasProcessed) {
+        if (true == mNewMeasProcessed) {
             LOC_LOGe ("report due to seq number jump");
             reportSvMeasurementInternal();
             resetSvMeasurementReport();
-            newMeasProcessed = false;
+            mNewMeasProcessed = false;
         }
 
         mHlosQtimer1 = getQTimerTickCount();
         mRefFCount = gnss_measurement_report_ptr.systemTimeExt.refFCount;
         LOC_LOGv("mHlosQtimer1=%" PRIi64 " mRefFCount=%d", mHlosQtimer1, mRefFCount);
-        prevRefFCount = gnss_measurement_report_ptr.systemTimeExt.refFCount;
+        mPrevMeasRefFCount = gnss_measurement_report_ptr.systemTimeExt.refFCount;
         if (gnss_measurement_report_ptr.nHzMeasurement_valid &&
             gnss_measurement_report_ptr.nHzMeasurement) {
             mGnssMeasurements->gnssSvMeasurementSet.isNhz = true;
@@ -5255,19 +5358,32 @@ void LocApiV02::reportGnssMeasurementData(
         mCounter++;
     }
 
-    Gnss_LocSvSystemEnumType locSvSystemType =
-        getLocApiSvSystemType(gnss_measurement_report_ptr.system);
-    if (GNSS_LOC_SV_SYSTEM_UNKNOWN == locSvSystemType) {
+    const measSystemConv* systemConv = getMeasSystemConv(gnss_measurement_report_ptr.system);
+    if (nullptr == systemConv) {
         LOC_LOGi("Unknown sv system");
         return;
     }
 
     // set up indication that we have processed some new measurement
-    newMeasProcessed = true;
+    mNewMeasProcessed = true;
 
     if (subSeqNum <= 1) {
-        convertGnssMeasurementsHeader(locSvSystemType, gnss_measurement_report_ptr);
+        convertGnssMeasurementsHeader(gnss_measurement_report_ptr);
+    }
+
+    // everything that is the same for all SVs of this part
+    svMeasPartInfo partInfo = {};
+    partInfo.locSvSystem = systemConv->locSystem;
+    partInfo.svType = systemConv->svType;
+    if (gnss_measurement_report_ptr.gnssSignalType_valid) {
+        partInfo.svMeasSignalTypeMask =
+                convertQmiGnssSignalType(gnss_measurement_report_ptr.gnssSignalType);
+    } else {
+        partInfo.svMeasSignalTypeMask =
+                getDefaultGnssSignalTypeMask(gnss_measurement_report_ptr.system);
     }
+    partInfo.agcIsPresent = convertJammerIndicator(gnss_measurement_report_ptr,
+                                                   partInfo.agcLevelDb, partInfo.agcFlags, true);
 
     // check whether we have valid dgnss measurement
     bool validDgnssMeas = false;
@@ -5285,6 +5401,27 @@ void LocApiV02::reportGnssMeasurementData(
         }
     }
 
+    GnssMeasurementsNotification& measNotif = mGnssMeasurements->gnssMeasNotification;
+    auto convertSvList = [&](const qmiLocSVMeasurementStructT_v02* svList, uint32_t len,
+                             bool isExt) {
+        for (uint32_t index = 0;
+                index < len && measNotif.count < GNSS_MEASUREMENTS_MAX; index++) {
+            LOC_LOGv("index=%u count=%" PRIu32, index, measNotif.count);
+            if ((svList[index].validMeasStatusMask &
+                 QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_STAT_BIT_VALID_V02) &&
+                (svList[index].measurementStatus &
+                 QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_VALID_V02)) {
+                mAgcIsPresent &= convertGnssMeasurements(
+                    gnss_measurement_report_ptr, partInfo,
+                    index, isExt, validDgnssMeas);
+                measNotif.count++;
+            } else {
+                LOC_LOGv("Measurements are stale, do not report");
+            }
+        }
+        LOC_LOGv("there are %d SV measurements now, total=%" PRIu32, len, measNotif.count);
+    };
+
     // number of measurements
     if (gnss_measurement_report_ptr.svMeasurement_valid) {
         if (gnss_measurement_report_ptr.svMeasurement_len != 0 &&
@@ -5293,29 +5430,11 @@ void LocApiV02::reportGnssMeasurementData(
             LOC_LOGv("Measurements received for GNSS system %d",
                      gnss_measurement_report_ptr.system);
 
-            if (0 == mGnssMeasurements->gnssMeasNotification.count) {
+            if (0 == measNotif.count) {
                 mAgcIsPresent = true;
             }
-            for (uint32_t index = 0; index < gnss_measurement_report_ptr.svMeasurement_len &&
-                    mGnssMeasurements->gnssMeasNotification.count < GNSS_MEASUREMENTS_MAX;
-                    index++) {
-                LOC_LOGv("index=%u count=%" PRIu32,
-                    index, mGnssMeasurements->gnssMeasNotification.count);
-                if ((gnss_measurement_report_ptr.svMeasurement[index].validMeasStatusMask &
-                     QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_STAT_BIT_VALID_V02) &&
-                    (gnss_measurement_report_ptr.svMeasurement[index].measurementStatus &
-                     QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_VALID_V02)) {
-                    mAgcIsPresent &= convertGnssMeasurements(
-                        gnss_measurement_report_ptr,
-                        index, false, validDgnssMeas);
-                    mGnssMeasurements->gnssMeasNotification.count++;
-                } else {
-                    LOC_LOGv("Measurements are stale, do not report");
-                }
-            }
-            LOC_LOGv("there are %d SV measurements now, total=%" PRIu32,
-                     gnss_measurement_report_ptr.svMeasurement_len,
-                     mGnssMeasurements->gnssMeasNotification.count);
+            convertSvList(gnss_measurement_report_ptr.svMeasurement,
+                          gnss_measurement_report_ptr.svMeasurement_len, false);
 
             /* now check if more measurements are available (some constellations such
             as BDS have more measurements available in extSvMeasurement)
@@ -5327,75 +5446,45 @@ void LocApiV02::reportGnssMeasurementData(
                 // the array of measurements
                 LOC_LOGv("More measurements received for GNSS system %d",
                          gnss_measurement_report_ptr.system);
-                for (uint32_t index = 0; index < gnss_measurement_report_ptr.extSvMeasurement_len &&
-                        mGnssMeasurements->gnssMeasNotification.count < GNSS_MEASUREMENTS_MAX;
-                        index++) {
-                    LOC_LOGv("index=%u count=%" PRIu32, index, mGnssMeasurements->gnssMeasNotification.count);
-                    if ((gnss_measurement_report_ptr.extSvMeasurement[index].validMeasStatusMask &
-                         QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_STAT_BIT_VALID_V02) &&
-                        (gnss_measurement_report_ptr.extSvMeasurement[index].measurementStatus &
-                         QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_VALID_V02)) {
-                        mAgcIsPresent &= convertGnssMeasurements(
-                            gnss_measurement_report_ptr,
-                            index, true, validDgnssMeas);
-                        mGnssMeasurements->gnssMeasNotification.count++;
-                    }
-                    else {
-                        LOC_LOGv("Measurements are stale, do not report");
-                    }
-                }
-                LOC_LOGv("there are %d SV measurements now, total=%" PRIu32,
-                         gnss_measurement_report_ptr.extSvMeasurement_len,
-                         mGnssMeasurements->gnssMeasNotification.count);
+                convertSvList(gnss_measurement_report_ptr.extSvMeasurement,
+                              gnss_measurement_report_ptr.extSvMeasurement_len, true);
             }
         }
     } else {
         LOC_LOGv("there is no valid GNSS measurement for system %d, total=%" PRIu32,
-                 gnss_measurement_report_ptr.system,
-            mGnssMeasurements->gnssMeasNotification.count);
+                 gnss_measurement_report_ptr.system, measNotif.count);
     }
     // the GPS clock time reading
     if (eQMI_LOC_SV_SYSTEM_GPS_V02 == gnss_measurement_report_ptr.system &&
         subSeqNum <= 1 &&
         false == mGPSreceived) {
         mGPSreceived = true;
-        mMsInWeek = convertGnssClock(mGnssMeasurements->gnssMeasNotification.clock,
-                                     gnss_measurement_report_ptr);
+        mMsInWeek = convertGnssClock(measNotif.clock, gnss_measurement_report_ptr);
     }
     // AGC
-    uint32_t temp;
-    mAgcIsPresent = convertJammerIndicator(gnss_measurement_report_ptr,
-            mGnssMeasurements->gnssMeasNotification.
-                    gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].agcLevelDb, temp);
-    convertSvType(gnss_measurement_report_ptr,
-                  mGnssMeasurements->gnssMeasNotification.
-                            gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].svType);
-
-    if (gnss_measurement_report_ptr.gnssSignalType_valid) {
-        LOC_LOGd("sigType=%" PRIu64, gnss_measurement_report_ptr.gnssSignalType);
-        mGnssMeasurements->gnssMeasNotification.
-                gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].
-                        carrierFrequencyHz = convertSignalTypeToCarrierFrequency(
-                                gnss_measurement_report_ptr.gnssSignalType, 8);
+    mAgcIsPresent = partInfo.agcIsPresent;
+    if (measNotif.agcCount < sizeof(measNotif.gnssAgc) / sizeof(measNotif.gnssAgc[0])) {
+        auto& gnssAgc = measNotif.gnssAgc[measNotif.agcCount];
+
+        if (partInfo.agcFlags & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
+            gnssAgc.agcLevelDb = partInfo.agcLevelDb;
+        }
+        gnssAgc.svType = partInfo.svType;
+        if (gnss_measurement_report_ptr.gnssSignalType_valid) {
+            LOC_LOGd("sigType=%" PRIu64, gnss_measurement_report_ptr.gnssSignalType);
+            gnssAgc.carrierFrequencyHz = convertSignalTypeToCarrierFrequency(
+                    gnss_measurement_report_ptr.gnssSignalType, 8);
+        } else {
+            gnssAgc.carrierFrequencyHz = CarrierFrequencies[gnssAgc.svType];
+        }
+        LOC_LOGv("agcCount = %d", measNotif.agcCount);
+        LOC_LOGv("agcLevelDb = %.2f", gnssAgc.agcLevelDb);
+        LOC_LOGv("svType = %d", gnssAgc.svType);
+        LOC_LOGv("carrierFrequencyHz = %.2f", gnssAgc.carrierFrequencyHz);
+        measNotif.agcCount++;
     } else {
-        mGnssMeasurements->gnssMeasNotification.
-                gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].
-                        carrierFrequencyHz =
-                                CarrierFrequencies[mGnssMeasurements->gnssMeasNotification.
-                                        gnssAgc[mGnssMeasurements->gnssMeasNotification.
-                                                agcCount].svType];
-    }
-    LOC_LOGv("agcCount = %d", mGnssMeasurements->gnssMeasNotification.agcCount);
-    LOC_LOGv("agcLevelDb = %.2f",
-             mGnssMeasurements->gnssMeasNotification.
-                    gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].agcLevelDb);
-    LOC_LOGv("svType = %d",
-             mGnssMeasurements->gnssMeasNotification.
-                    gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].svType);
-    LOC_LOGv("carrierFrequencyHz = %.2f",
-             mGnssMeasurements->gnssMeasNotification.
-                    gnssAgc[mGnssMeasurements->gnssMeasNotification.agcCount].carrierFrequencyHz);
-    mGnssMeasurements->gnssMeasNotification.agcCount++;
+        LOC_LOGw("no room left for the AGC of system %d", gnss_measurement_report_ptr.system);
+    }
 
     if (gnss_measurement_report_ptr.maxMessageNum == gnss_measurement_report_ptr.seqNum &&
         maxSubSeqNum == subSeqNum) {
@@ -5445,7 +5534,7 @@ void LocApiV02::reportGnssMeasurementData(
         reportSvMeasurementInternal();
         resetSvMeasurementReport();
         // set up flag to indicate that no new info in mGnssMeasurements
-        newMeasProcessed = false;
+        mNewMeasProcessed = false;
     }
 }
 
@@ -5705,6 +5794,40 @@ void LocApiV02 ::reportSvMeasurementInternal() {
     }
 }
 
+void LocApiV02::resetSvMeasurementReport() {
+    GnssMeasurementsNotification& measNotif = mGnssMeasurements->gnssMeasNotification;
+    GnssSvMeasurementSet& svMeasSet = mGnssMeasurements->gnssSvMeasurementSet;
+    uint32_t used = measNotif.count;
+
+    // The two per SV arrays are most of the buffer but an epoch only fills their first
+    // count entries, so clear those and everything else around the arrays.
+    uint8_t* holeStart[2] = { (uint8_t*)measNotif.measurements, (uint8_t*)svMeasSet.svMeas };
+    size_t holeSize[2] = { sizeof(measNotif.measurements), sizeof(svMeasSet.svMeas) };
+    if (holeStart[1] < holeStart[0]) {
+        std::swap(holeStart[0], holeStart[1]);
+        std::swap(holeSize[0], holeSize[1]);
+    }
+    uint8_t* begin = (uint8_t*)mGnssMeasurements;
+    uint8_t* end = begin + sizeof(GnssMeasurements);
+    memset(begin, 0, holeStart[0] - begin);
+    memset(holeStart[0] + holeSize[0], 0, holeStart[1] - (holeStart[0] + holeSize[0]));
+    memset(holeStart[1] + holeSize[1], 0, end - (holeStart[1] + holeSize[1]));
+    if (used > GNSS_MEASUREMENTS_MAX) {
+        used = GNSS_MEASUREMENTS_MAX;
+    }
+    memset(measNotif.measurements, 0, used * sizeof(measNotif.measurements[0]));
+    memset(svMeasSet.svMeas, 0, used * sizeof(svMeasSet.svMeas[0]));
+
+    mGnssMeasurements->size = sizeof(GnssMeasurements);
+    svMeasSet.size = sizeof(GnssSvMeasurementSet);
+    svMeasSet.isNhz = false;
+    svMeasSet.svMeasSetHeader.size = sizeof(GnssSvMeasurementHeader);
+    memset(&mTimeBiases, 0, sizeof(mTimeBiases));
+    mGPSreceived = false;
+    mMsInWeek = -1;
+    mAgcIsPresent = false;
+}
+
 bool LocApiV02::convertJammerIndicator(
         const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
         double& agcLevelDb,
@@ -5735,46 +5858,7 @@ bool LocApiV02::convertJammerIndicator(
     return bAgcIsPresent;
 }
 
-void LocApiV02::convertSvType(
-        const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
-        GnssSvType& svType) {
-    switch (gnss_measurement_report_ptr.system)
-    {
-    case eQMI_LOC_SV_SYSTEM_GPS_V02:
-        svType = GNSS_SV_TYPE_GPS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_GALILEO_V02:
-        svType = GNSS_SV_TYPE_GALILEO;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_SBAS_V02:
-        svType = GNSS_SV_TYPE_SBAS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_GLONASS_V02:
-        svType = GNSS_SV_TYPE_GLONASS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_BDS_V02:
-        svType = GNSS_SV_TYPE_BEIDOU;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_QZSS_V02:
-        svType = GNSS_SV_TYPE_QZSS;
-        break;
-
-    case eQMI_LOC_SV_SYSTEM_NAVIC_V02:
-        svType = GNSS_SV_TYPE_NAVIC;
-        break;
-
-    default:
-        svType = GNSS_SV_TYPE_UNKNOWN;
-        break;
-    }
-}
-
-void LocApiV02::convertGnssMeasurementsHeader(const Gnss_LocSvSystemEnumType locSvSystemType,
+void LocApiV02::convertGnssMeasurementsHeader(
     const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_info)
 {
     GnssSvMeasurementHeader &svMeasSetHead =
@@ -5818,296 +5902,24 @@ void LocApiV02::convertGnssMeasurementsHeader(const Gnss_LocSvSystemEnumType loc
             svMeasSetHead.leapSec.leapSec, svMeasSetHead.leapSec.leapSecUnc);
     }
 
-    if (1 == gnss_measurement_info.gpsGloInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-            (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.gpsGloInterSystemBias;
-
-        getInterSystemTimeBias("gpsGloInterSystemBias",
-            svMeasSetHead.gpsGloInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GPS_GLO_INTER_SYSTEM_BIAS;
-
-        if (gnss_measurement_info.gpsGloInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.gpsL1_gloG1 =
-                    -gnss_measurement_info.gpsGloInterSystemBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GLOG1_VALID;
-        }
-        if (gnss_measurement_info.gpsGloInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.gpsL1_gloG1Unc =
-                    gnss_measurement_info.gpsGloInterSystemBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GLOG1_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.gpsBdsInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.gpsBdsInterSystemBias;
-
-        getInterSystemTimeBias("gpsBdsInterSystemBias",
-                                svMeasSetHead.gpsBdsInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GPS_BDS_INTER_SYSTEM_BIAS;
-
-        if (gnss_measurement_info.gpsBdsInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.gpsL1_bdsB1 =
-                    -gnss_measurement_info.gpsBdsInterSystemBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_BDSB1_VALID;
-        }
-        if (gnss_measurement_info.gpsBdsInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.gpsL1_bdsB1Unc =
-                    gnss_measurement_info.gpsBdsInterSystemBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_BDSB1_UNC_VALID;
+    for (const interSystemBiasConv& conv : sInterSystemBiasConv) {
+        if (1 != gnss_measurement_info.*conv.valid) {
+            continue;
         }
-    }
+        const qmiLocInterSystemBiasStructT_v02& bias = gnss_measurement_info.*conv.bias;
 
-    if (1 == gnss_measurement_info.gpsGalInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.gpsGalInterSystemBias;
+        getInterSystemTimeBias(conv.name, svMeasSetHead.*conv.headerBias, &bias);
+        svMeasSetHead.flags |= conv.headerFlag;
 
-        getInterSystemTimeBias("gpsGalInterSystemBias",
-                               svMeasSetHead.gpsGalInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GPS_GAL_INTER_SYSTEM_BIAS;
-
-        if (gnss_measurement_info.gpsGalInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.gpsL1_galE1 =
-                    -gnss_measurement_info.gpsGalInterSystemBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GALE1_VALID;
-        }
-        if (gnss_measurement_info.gpsGalInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.gpsL1_galE1Unc =
-                    gnss_measurement_info.gpsGalInterSystemBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GALE1_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.bdsGloInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.bdsGloInterSystemBias;
-
-        getInterSystemTimeBias("bdsGloInterSystemBias",
-                               svMeasSetHead.bdsGloInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_BDS_GLO_INTER_SYSTEM_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.galGloInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.galGloInterSystemBias;
-
-        getInterSystemTimeBias("galGloInterSystemBias",
-                                svMeasSetHead.galGloInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GAL_GLO_INTER_SYSTEM_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.galBdsInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.galBdsInterSystemBias;
-
-        getInterSystemTimeBias("galBdsInterSystemBias",
-                                svMeasSetHead.galBdsInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GAL_BDS_INTER_SYSTEM_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.gpsNavicInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.gpsNavicInterSystemBias;
-
-        getInterSystemTimeBias("gpsNavicInterSystemBias",
-                                svMeasSetHead.gpsNavicInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GPS_NAVIC_INTER_SYSTEM_BIAS;
-
-        if (gnss_measurement_info.gpsNavicInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.gpsL1_navic =
-                    -gnss_measurement_info.gpsNavicInterSystemBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_NAVIC_VALID;
-        }
-        if (gnss_measurement_info.gpsNavicInterSystemBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.gpsL1_navicUnc =
-                    gnss_measurement_info.gpsNavicInterSystemBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_NAVIC_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.galNavicInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.galNavicInterSystemBias;
-
-        getInterSystemTimeBias("galNavicInterSystemBias",
-                                svMeasSetHead.galNavicInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GAL_NAVIC_INTER_SYSTEM_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.gloNavicInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.gloNavicInterSystemBias;
-
-        getInterSystemTimeBias("gloNavicInterSystemBias",
-                                svMeasSetHead.gloNavicInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GLO_NAVIC_INTER_SYSTEM_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.bdsNavicInterSystemBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.bdsNavicInterSystemBias;
-
-        getInterSystemTimeBias("bdsNavicInterSystemBias",
-                                svMeasSetHead.bdsNavicInterSystemBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_BDS_NAVIC_INTER_SYSTEM_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.GpsL1L5TimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.GpsL1L5TimeBias;
-
-        getInterSystemTimeBias("gpsL1L5TimeBias",
-                                svMeasSetHead.gpsL1L5TimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GPSL1L5_TIME_BIAS;
-
-        if (gnss_measurement_info.GpsL1L5TimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.gpsL1_gpsL5 = -gnss_measurement_info.GpsL1L5TimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GPSL5_VALID;
-        }
-        if (gnss_measurement_info.GpsL1L5TimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.gpsL1_gpsL5Unc =
-                    gnss_measurement_info.GpsL1L5TimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GPSL5_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.GalE1E5aTimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.GalE1E5aTimeBias;
-
-        getInterSystemTimeBias("galE1E5aTimeBias",
-                                svMeasSetHead.galE1E5aTimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GALE1E5A_TIME_BIAS;
-
-        if (gnss_measurement_info.GalE1E5aTimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.galE1_galE5a = -gnss_measurement_info.GalE1E5aTimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GALE1_GALE5A_VALID;
-        }
-        if (gnss_measurement_info.GalE1E5aTimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.galE1_galE5aUnc =
-                    gnss_measurement_info.GalE1E5aTimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GALE1_GALE5A_UNC_VALID;
-        }
-    }
-
-
-    if (1 == gnss_measurement_info.BdsB1iB2aTimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.BdsB1iB2aTimeBias;
-
-        getInterSystemTimeBias("bdsB1iB2aTimeBias",
-                               svMeasSetHead.bdsB1iB2aTimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_BDSB1IB2A_TIME_BIAS;
-
-        if (gnss_measurement_info.BdsB1iB2aTimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.bdsB1_bdsB2a = -gnss_measurement_info.BdsB1iB2aTimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_BDSB1_BDSB2A_VALID;
-        }
-        if (gnss_measurement_info.BdsB1iB2aTimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.bdsB1_bdsB2aUnc =
-                    gnss_measurement_info.BdsB1iB2aTimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_BDSB1_BDSB2A_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.BdsB1iB2biTimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.BdsB1iB2biTimeBias;
-
-        getInterSystemTimeBias("bdsB1iB2biTimeBias",
-                               svMeasSetHead.bdsB1iB2biTimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_BDSB1IB2BI_TIME_BIAS;
-
-        if (gnss_measurement_info.BdsB1iB2biTimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.bdsB1_bdsB2bi = gnss_measurement_info.BdsB1iB2biTimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_BDSB1_BDSB2BI_VALID;
-        }
-        if (gnss_measurement_info.BdsB1iB2biTimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.bdsB1_bdsB2biUnc =
-                    gnss_measurement_info.BdsB1iB2biTimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_BDSB1_BDSB2BI_UNC_VALID;
-        }
-    }
-
-
-    if (1 == gnss_measurement_info.BdsB1iB1cTimeBias_valid) {
-        if (gnss_measurement_info.BdsB1iB1cTimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.bdsB1_bdsB1c = -gnss_measurement_info.BdsB1iB1cTimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_BDSB1_BDSB1C_VALID;
-        }
-        if (gnss_measurement_info.BdsB1iB1cTimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.bdsB1_bdsB1cUnc =
-                    gnss_measurement_info.BdsB1iB1cTimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_BDSB1_BDSB1C_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.GpsL1L2cTimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.GpsL1L2cTimeBias;
-
-        getInterSystemTimeBias("gpsL1L2cTimeBias",
-                               svMeasSetHead.gpsL1L2cTimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GPSL1L2C_TIME_BIAS;
-        if (gnss_measurement_info.GpsL1L2cTimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.gpsL1_gpsL2c = gnss_measurement_info.GpsL1L2cTimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GPSL2C_VALID;
-        }
-        if (gnss_measurement_info.GpsL1L2cTimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.gpsL1_gpsL2cUnc =
-                    gnss_measurement_info.GpsL1L2cTimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GPSL1_GPSL2C_UNC_VALID;
-        }
-    }
-
-    if (1 == gnss_measurement_info.GloG1G2TimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.GloG1G2TimeBias;
-
-        getInterSystemTimeBias("gloG1G2TimeBias",
-                               svMeasSetHead.gloG1G2TimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GLOG1G2_TIME_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.BdsB1iB1cTimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.BdsB1iB1cTimeBias;
-
-        getInterSystemTimeBias("bdsB1iB1cTimeBias",
-                               svMeasSetHead.bdsB1iB1cTimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_BDSB1IB1C_TIME_BIAS;
-    }
-
-    if (1 == gnss_measurement_info.GalE1E5bTimeBias_valid) {
-        qmiLocInterSystemBiasStructT_v02* interSystemBias =
-                (qmiLocInterSystemBiasStructT_v02*)&gnss_measurement_info.GalE1E5bTimeBias;
-
-        getInterSystemTimeBias("galE1E5bTimeBias",
-                               svMeasSetHead.galE1E5bTimeBias, interSystemBias);
-        svMeasSetHead.flags |= GNSS_SV_MEAS_HEADER_HAS_GALE1E5B_TIME_BIAS;
-        if (gnss_measurement_info.GalE1E5bTimeBias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
-            mTimeBiases.galE1_galE5b = gnss_measurement_info.GalE1E5bTimeBias.timeBias * 1000000;
-            mTimeBiases.flags |= BIAS_GALE1_GALE5B_VALID;
-        }
-        if (gnss_measurement_info.GalE1E5bTimeBias.validMask &
-            QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
-            mTimeBiases.galE1_galE5bUnc =
-                    gnss_measurement_info.GalE1E5bTimeBias.timeBiasUnc * 1000000;
-            mTimeBiases.flags |= BIAS_GALE1_GALE5B_UNC_VALID;
+        if (nullptr != conv.timeBias) {
+            if (bias.validMask & QMI_LOC_SYS_TIME_BIAS_VALID_V02) {
+                mTimeBiases.*conv.timeBias = conv.sign * bias.timeBias * 1000000;
+                mTimeBiases.flags |= conv.timeBiasFlag;
+            }
+            if (bias.validMask & QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02) {
+                mTimeBiases.*conv.timeBiasUnc = bias.timeBiasUnc * 1000000;
+                mTimeBiases.flags |= conv.timeBiasUncFlag;
+            }
         }
     }
 
@@ -6141,69 +5953,28 @@ void LocApiV02::convertGnssMeasurementsHeader(const Gnss_LocSvSystemEnumType loc
     if ((1 == gnss_measurement_info.systemTime_valid) ||
         (1 == gnss_measurement_info.systemTimeExt_valid)) {
 
+        const measSystemConv* systemConv = getMeasSystemConv(gnss_measurement_info.system);
         GnssSystemTimeStructType* systemTimePtr = nullptr;
         Gnss_LocGnssTimeExtStructType* systemTimeExtPtr = nullptr;
         GpsSvMeasHeaderFlags systemTimeFlags = 0x0;
         GpsSvMeasHeaderFlags systemTimeExtFlags = 0x0;
 
-        switch (locSvSystemType) {
-        case GNSS_LOC_SV_SYSTEM_GPS:
-            systemTimePtr = &svMeasSetHead.gpsSystemTime;
-            systemTimeExtPtr = &svMeasSetHead.gpsSystemTimeExt;
-            systemTimeFlags = GNSS_SV_MEAS_HEADER_HAS_GPS_SYSTEM_TIME;
-            systemTimeExtFlags = GNSS_SV_MEAS_HEADER_HAS_GPS_SYSTEM_TIME_EXT;
-            if (gnss_measurement_info.systemTime_valid) {
-                mTimeBiases.gpsL1 = gnss_measurement_info.systemTime.systemClkTimeBias * 1000000;
-                mTimeBiases.gpsL1Unc =
-                        gnss_measurement_info.systemTime.systemClkTimeUncMs * 1000000;
-                mTimeBiases.flags |= BIAS_GPSL1_VALID;
-                mTimeBiases.flags |= BIAS_GPSL1_UNC_VALID;
+        if (nullptr != systemConv) {
+            if (nullptr != systemConv->systemTime) {
+                systemTimePtr = &(svMeasSetHead.*systemConv->systemTime);
+                systemTimeFlags = systemConv->systemTimeFlag;
             }
-            break;
-        case GNSS_LOC_SV_SYSTEM_GALILEO:
-            systemTimePtr = &svMeasSetHead.galSystemTime;
-            systemTimeExtPtr = &svMeasSetHead.galSystemTimeExt;
-            systemTimeFlags = GNSS_SV_MEAS_HEADER_HAS_GAL_SYSTEM_TIME;
-            systemTimeExtFlags = GNSS_SV_MEAS_HEADER_HAS_GAL_SYSTEM_TIME_EXT;
-            if (gnss_measurement_info.systemTime_valid) {
-                mTimeBiases.galE1 = gnss_measurement_info.systemTime.systemClkTimeBias * 1000000;
-                mTimeBiases.galE1Unc =
-                    gnss_measurement_info.systemTime.systemClkTimeUncMs * 1000000;
-                mTimeBiases.flags |= BIAS_GALE1_VALID;
-                mTimeBiases.flags |= BIAS_GALE1_UNC_VALID;
+            if (nullptr != systemConv->systemTimeExt) {
+                systemTimeExtPtr = &(svMeasSetHead.*systemConv->systemTimeExt);
+                systemTimeExtFlags = systemConv->systemTimeExtFlag;
             }
-            break;
-        case GNSS_LOC_SV_SYSTEM_BDS:
-            systemTimePtr = &svMeasSetHead.bdsSystemTime;
-            systemTimeExtPtr = &svMeasSetHead.bdsSystemTimeExt;
-            systemTimeFlags = GNSS_SV_MEAS_HEADER_HAS_BDS_SYSTEM_TIME;
-            systemTimeExtFlags = GNSS_SV_MEAS_HEADER_HAS_BDS_SYSTEM_TIME_EXT;
-            if (gnss_measurement_info.systemTime_valid) {
-                mTimeBiases.bdsB1 = gnss_measurement_info.systemTime.systemClkTimeBias * 1000000;
-                mTimeBiases.bdsB1Unc =
-                    gnss_measurement_info.systemTime.systemClkTimeUncMs * 1000000;
-                mTimeBiases.flags |= BIAS_BDSB1_VALID;
-                mTimeBiases.flags |= BIAS_BDSB1_UNC_VALID;
+            if (nullptr != systemConv->clkBias && gnss_measurement_info.systemTime_valid) {
+                mTimeBiases.*systemConv->clkBias =
+                        gnss_measurement_info.systemTime.systemClkTimeBias * 1000000;
+                mTimeBiases.*systemConv->clkBiasUnc =
+                        gnss_measurement_info.systemTime.systemClkTimeUncMs * 1000000;
+                mTimeBiases.flags |= systemConv->clkBiasFlags;
             }
-            break;
-        case GNSS_LOC_SV_SYSTEM_QZSS:
-            systemTimePtr = &svMeasSetHead.qzssSystemTime;
-            systemTimeExtPtr = &svMeasSetHead.qzssSystemTimeExt;
-            systemTimeFlags = GNSS_SV_MEAS_HEADER_HAS_QZSS_SYSTEM_TIME;
-            systemTimeExtFlags = GNSS_SV_MEAS_HEADER_HAS_QZSS_SYSTEM_TIME_EXT;
-            break;
-        case GNSS_LOC_SV_SYSTEM_GLONASS:
-            systemTimeExtPtr = &svMeasSetHead.gloSystemTimeExt;
-            systemTimeExtFlags = GNSS_SV_MEAS_HEADER_HAS_GLO_SYSTEM_TIME_EXT;
-            break;
-        case GNSS_LOC_SV_SYSTEM_NAVIC:
-            systemTimePtr = &svMeasSetHead.navicSystemTime;
-            systemTimeExtPtr = &svMeasSetHead.navicSystemTimeExt;
-            systemTimeFlags = GNSS_SV_MEAS_HEADER_HAS_NAVIC_SYSTEM_TIME;
-            systemTimeExtFlags = GNSS_SV_MEAS_HEADER_HAS_NAVIC_SYSTEM_TIME_EXT;
-            break;
-        default:
-            break;
         }
 
         if (systemTimePtr) {
@@ -6351,9 +6122,9 @@ void LocApiV02::wifiStatusInformSync()
 /*convert GnssMeasurement type from QMI LOC to loc eng format*/
 bool LocApiV02 :: convertGnssMeasurements(
     const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
+    const svMeasPartInfo& partInfo,
     int index, bool isExt, bool validDgnssSvMeas)
 {
-    bool bAgcIsPresent = false;
     const qmiLocSVMeasurementStructT_v02 &gnss_measurement_info = isExt ?
             gnss_measurement_report_ptr.extSvMeasurement[index] :
             gnss_measurement_report_ptr.svMeasurement[index];
@@ -6368,16 +6139,10 @@ bool LocApiV02 :: convertGnssMeasurements(
         mGnssMeasurements->gnssSvMeasurementSet.svMeas[count];
 
     svMeas.size = sizeof(Gnss_SVMeasurementStructType);
-    svMeas.gnssSystem = getLocApiSvSystemType(gnss_measurement_report_ptr.system);
+    svMeas.gnssSystem = partInfo.locSvSystem;
     svMeas.gnssSvId = gnss_measurement_info.gnssSvId;
     svMeas.gloFrequency = gnss_measurement_info.gloFrequency;
-    if (gnss_measurement_report_ptr.gnssSignalType_valid) {
-        svMeas.gnssSignalTypeMask =
-                convertQmiGnssSignalType(gnss_measurement_report_ptr.gnssSignalType);
-    } else {
-        svMeas.gnssSignalTypeMask =
-                getDefaultGnssSignalTypeMask(gnss_measurement_report_ptr.system);
-    }
+    svMeas.gnssSignalTypeMask = partInfo.svMeasSignalTypeMask;
     if (gnss_measurement_info.validMask & QMI_LOC_SV_LOSSOFLOCK_VALID_V02) {
         svMeas.lossOfLock = (bool)gnss_measurement_info.lossOfLock;
     }
@@ -6515,7 +6280,7 @@ bool LocApiV02 :: convertGnssMeasurements(
     measurementData.flags |= GNSS_MEASUREMENTS_DATA_SV_ID_BIT | GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT;
 
     // constellation
-    convertSvType(gnss_measurement_report_ptr, measurementData.svType);
+    measurementData.svType = partInfo.svType;
 
     if (GNSS_SV_TYPE_GLONASS == measurementData.svType) {
         measurementData.gloFrequency = gnss_measurement_info.gloFrequency;
@@ -6858,13 +6623,12 @@ bool LocApiV02 :: convertGnssMeasurements(
     measurementData.flags |= GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT;
 
     // AGC
-    bAgcIsPresent = convertJammerIndicator(gnss_measurement_report_ptr,
-                                           measurementData.agcLevelDb,
-                                           measurementData.flags,
-                                           true);
+    if (partInfo.agcFlags & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
+        measurementData.agcLevelDb = partInfo.agcLevelDb;
+        measurementData.flags |= GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
+    }
     if (gnss_measurement_report_ptr.gnssSignalType_valid) {
-        measurementData.gnssSignalType =
-                convertQmiGnssSignalType(gnss_measurement_report_ptr.gnssSignalType);
+        measurementData.gnssSignalType = partInfo.svMeasSignalTypeMask;
         measurementData.flags |= GNSS_MEASUREMENTS_DATA_GNSS_SIGNAL_TYPE_BIT;
     }
 
@@ -6926,14 +6690,6 @@ bool LocApiV02 :: convertGnssMeasurements(
         measurementData.flags |= GNSS_MEASUREMENTS_DATA_BASEBAND_CARRIER_TO_NOISE_BIT;
     }
 
-    // intersignal bias
-    if (gnss_measurement_report_ptr.gnssSignalType_valid &&
-        (gnss_measurement_report_ptr.systemTime_valid ||
-         gnss_measurement_report_ptr.gloTime_valid)) {
-        measurementData.gnssSignalType =
-                convertQmiGnssSignalType(gnss_measurement_report_ptr.gnssSignalType);
-    }
-
     // satellite PVT
     // find in svPolynomial in mSvPolynomialMap and extract it
     GnssSvPolynomial  svPolynomial = {};
@@ -7015,7 +6771,7 @@ bool LocApiV02 :: convertGnssMeasurements(
              measurementData.adrUncertaintyMeters,                              // %f
              measurementData.carrierFrequencyHz,                                // %f
              measurementData.codeType);                                         // %d
-    return bAgcIsPresent;
+    return partInfo.agcIsPresent;
 }
 
 /*convert GnssMeasurementsClock type from QMI LOC to loc eng format*/
@@ -115,6 +115,17 @@ typedef struct
     uint8_t nHzMeasurement;
 } adrData;
 
+/* values shared by all the SVs of one measurement indication */
+typedef struct
+{
+    Gnss_LocSvSystemEnumType locSvSystem;
+    GnssSvType svType;
+    GnssSignalTypeMask svMeasSignalTypeMask;
+    bool agcIsPresent;
+    double agcLevelDb;
+    GnssMeasurementsDataFlagsMask agcFlags;
+} svMeasPartInfo;
+
 typedef uint64_t GpsSvMeasHeaderFlags;
 #define BIAS_GPSL1_VALID                0x00000001
 #define BIAS_GPSL1_UNC_VALID            0x00000002
@@ -194,6 +205,9 @@ protected:
   locClientHandleType clientHandle;
 
 private:
+  /* feeds recorded measurement indications to reportGnssMeasurementData() */
+  friend class LocApiV02MeasReplayBench;
+
   locClientEventMaskType mQmiMask;
   bool mInSession;
   GnssPowerMode mPowerMode;
@@ -205,6 +219,8 @@ private:
   uint32_t mMinInterval;
   std::vector<adrData>  mADRdata;
   GnssMeasurements*  mGnssMeasurements;
+  uint32_t mPrevMeasRefFCount;
+  bool mNewMeasProcessed;
   bool mGPSreceived;
   int  mMsInWeek;
   bool mAgcIsPresent;
@@ -252,6 +268,7 @@ private:
   /*convert GnssMeasurement type from QMI LOC to loc eng format*/
   bool convertGnssMeasurements (
       const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
+      const svMeasPartInfo& partInfo,
       int index, bool isExt, bool validDgnssSvMeas);
 
   /* Convert APN Type mask */
@@ -266,7 +283,7 @@ private:
   /* Convert GnssPowerMode to QMI Loc Power Mode Enum */
   static qmiLocPowerModeEnumT_v02 convertPowerMode(GnssPowerMode powerMode);
 
-  void convertGnssMeasurementsHeader(const Gnss_LocSvSystemEnumType locSvSystemType,
+  void convertGnssMeasurementsHeader(
       const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_info);
 
   /*convert LocGnssClock type from QMI LOC to loc eng format*/
@@ -358,18 +375,8 @@ private:
 
   void reportSvMeasurementInternal();
 
-  inline void resetSvMeasurementReport(){
-      memset(mGnssMeasurements, 0, sizeof(GnssMeasurements));
-      mGnssMeasurements->size = sizeof(GnssMeasurements);
-      mGnssMeasurements->gnssSvMeasurementSet.size = sizeof(GnssSvMeasurementSet);
-      mGnssMeasurements->gnssSvMeasurementSet.isNhz = false;
-      mGnssMeasurements->gnssSvMeasurementSet.svMeasSetHeader.size =
-          sizeof(GnssSvMeasurementHeader);
-      memset(&mTimeBiases, 0, sizeof(mTimeBiases));
-      mGPSreceived = false;
-      mMsInWeek = -1;
-      mAgcIsPresent = false;
-  }
+  /* clear the epoch assembled in mGnssMeasurements for the next one */
+  void resetSvMeasurementReport();
 
   bool convertJammerIndicator(
         const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
@@ -377,10 +384,6 @@ private:
         GnssMeasurementsDataFlagsMask& flags,
         bool updateFlags = false);
 
-  void convertSvType(
-        const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
-        GnssSvType& svType);
-
   void setGnssBiases();
 
   /* convert and report ODCPI request */
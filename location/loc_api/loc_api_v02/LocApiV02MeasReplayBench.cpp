@@ -0,0 +1,332 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Replays QMI LOC GNSS measurement indications through
+LocApiV02::reportGnssMeasurementData() and measures the conversion:
+ - time per indication part and per measurement epoch
+ - heap allocations per epoch
+
+No modem is involved, the indications are handed over the way eventCb() does
+once they were decoded. The converted epochs go to LocApiBase with no adapter
+attached, so only the QMI to GnssMeasurements conversion is timed.
+
+The trace is synthesized, each epoch a multi part indication set over GPS,
+GLONASS, Galileo, BDS and QZSS signals with full SV lists, or read from a file
+of recorded indications: decoded qmiLocEventGnssSvMeasInfoIndMsgT_v02 structs
+back to back, as dumped from eventCb() by a build with the same QMI LOC
+headers. -w writes the synthesized trace in that format.
+
+usage: loc_api_v02_meas_replay_bench [-f recording] [-w file] [-n epochs]
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+#include <LocApiV02.h>
+
+#define DEFAULT_EPOCHS          500
+#define BENCH_PASSES            3
+
+typedef qmiLocEventGnssSvMeasInfoIndMsgT_v02 MeasInd;
+
+static std::atomic<uint64_t> sAllocCount(0);
+
+void* operator new(size_t size) {
+    sAllocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double percentileUs(std::vector<uint64_t>& ns, int percent) {
+    if (ns.empty()) {
+        return 0;
+    }
+    size_t i = (ns.size() - 1) * percent / 100;
+    std::nth_element(ns.begin(), ns.begin() + i, ns.end());
+    return ns[i] / 1000.0;
+}
+
+/* friend of LocApiV02, see LocApiV02.h */
+class LocApiV02MeasReplayBench {
+public:
+    LocApiV02MeasReplayBench() : mApi(new LocApiV02(0, nullptr)) {}
+    ~LocApiV02MeasReplayBench() { delete mApi; }
+    void report(const MeasInd& ind) { mApi->reportGnssMeasurementData(ind); }
+private:
+    LocApiV02* mApi;
+};
+
+/******************************************************************************
+Trace
+******************************************************************************/
+struct SignalPart {
+    qmiLocSvSystemEnumT_v02 system;
+    qmiLocGnssSignalTypeMaskT_v02 signal;
+    uint16_t firstSvId;
+    uint32_t numSvs;        // above QMI_LOC_SV_MEAS_LIST_MAX_SIZE_V02 goes to extSvMeasurement
+};
+
+static const SignalPart sSignalParts[] = {
+    { eQMI_LOC_SV_SYSTEM_GPS_V02,     QMI_LOC_MASK_GNSS_SIGNAL_TYPE_GPS_L1CA_V02,     1,   12 },
+    { eQMI_LOC_SV_SYSTEM_GPS_V02,     QMI_LOC_MASK_GNSS_SIGNAL_TYPE_GPS_L5_Q_V02,     1,   6 },
+    { eQMI_LOC_SV_SYSTEM_GLONASS_V02, QMI_LOC_MASK_GNSS_SIGNAL_TYPE_GLONASS_G1_V02,   65,  9 },
+    { eQMI_LOC_SV_SYSTEM_GALILEO_V02, QMI_LOC_MASK_GNSS_SIGNAL_TYPE_GALILEO_E1_C_V02, 301, 10 },
+    { eQMI_LOC_SV_SYSTEM_GALILEO_V02, QMI_LOC_MASK_GNSS_SIGNAL_TYPE_GALILEO_E5A_Q_V02, 301, 8 },
+    { eQMI_LOC_SV_SYSTEM_BDS_V02,     QMI_LOC_MASK_GNSS_SIGNAL_TYPE_BEIDOU_B1_I_V02,  201, 20 },
+    { eQMI_LOC_SV_SYSTEM_BDS_V02,     QMI_LOC_MASK_GNSS_SIGNAL_TYPE_BEIDOU_B2A_I_V02, 219, 7 },
+    { eQMI_LOC_SV_SYSTEM_QZSS_V02,    QMI_LOC_MASK_GNSS_SIGNAL_TYPE_QZSS_L1CA_V02,    193, 3 },
+};
+
+static void fillSv(qmiLocSVMeasurementStructT_v02& sv, uint16_t svId, uint32_t epoch) {
+    sv.gnssSvId = svId;
+    sv.svStatus = eQMI_LOC_SV_STATUS_TRACK_V02;
+    sv.validMask = QMI_LOC_SV_CARRIER_PHASE_VALID_V02 | QMI_LOC_SV_SV_DIRECTION_VALID_V02 |
+            QMI_LOC_SV_CYCLESLIP_COUNT_VALID_V02;
+    sv.validMeasStatusMask = QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_STAT_BIT_VALID_V02 |
+            0x3F;
+    sv.measurementStatus = QMI_LOC_MASK_MEAS_STATUS_GNSS_FRESH_MEAS_VALID_V02 |
+            QMI_LOC_MASK_MEAS_STATUS_SM_VALID_V02 | QMI_LOC_MASK_MEAS_STATUS_SB_VALID_V02 |
+            QMI_LOC_MASK_MEAS_STATUS_MS_VALID_V02 | QMI_LOC_MASK_MEAS_STATUS_BE_CONFIRM_V02 |
+            QMI_LOC_MASK_MEAS_STATUS_VELOCITY_FINE_V02;
+    sv.CNo = 300 + (svId * 7 + epoch) % 150;
+    sv.gloRfLoss = 20;
+    sv.svTimeSpeed.svTimeMs = 345600000 + epoch * 1000 + svId;
+    sv.svTimeSpeed.svTimeSubMs = 0.25f + svId * 0.001f;
+    sv.svTimeSpeed.svTimeUncMs = 1e-5f;
+    sv.svTimeSpeed.dopplerShift = -1200.0f + svId;
+    sv.svTimeSpeed.dopplerShiftUnc = 0.5f;
+    sv.fineSpeed = -230.0f + svId;
+    sv.fineSpeedUnc = 0.05f;
+    sv.carrierPhase = 1000.0 * epoch + svId;
+    sv.cycleSlipCount = 1;
+    sv.svAzimuth = 1.0f + svId * 0.01f;
+    sv.svElevation = 0.5f;
+}
+
+static void synthesizeTrace(std::vector<MeasInd>& trace, uint32_t epochs) {
+    const uint32_t parts = sizeof(sSignalParts) / sizeof(sSignalParts[0]);
+
+    trace.resize(epochs * parts);
+    memset(trace.data(), 0, trace.size() * sizeof(MeasInd));
+    for (uint32_t epoch = 0; epoch < epochs; epoch++) {
+        for (uint32_t p = 0; p < parts; p++) {
+            const SignalPart& part = sSignalParts[p];
+            MeasInd& ind = trace[epoch * parts + p];
+
+            ind.seqNum = p + 1;
+            ind.maxMessageNum = parts;
+            ind.system = part.system;
+            ind.systemTime_valid = 1;
+            ind.systemTime.systemWeek = 2200;
+            ind.systemTime.systemMsec = 345600000 + epoch * 1000;
+            ind.systemTime.systemClkTimeBias = 0.1f;
+            ind.systemTime.systemClkTimeUncMs = 0.01f;
+            ind.systemTimeExt_valid = 1;
+            ind.systemTimeExt.refFCount = 1000 + epoch * 1000;
+            ind.numClockResets_valid = 1;
+            ind.refCountTicks_valid = 1;
+            ind.refCountTicks = 19200000ULL * (epoch + 1);
+            ind.refCountTicksUnc_valid = 1;
+            ind.refCountTicksUnc = 0.01f;
+            ind.gnssSignalType_valid = 1;
+            ind.gnssSignalType = part.signal;
+            ind.jammerIndicator_valid = 1;
+            ind.jammerIndicator.bpMetricDb = 1200 + p;
+            ind.measurementCodeType_valid = 1;
+            ind.measurementCodeType = eQMI_LOC_GNSS_CODE_TYPE_C_V02;
+            ind.gpsGloInterSystemBias_valid = 1;
+            ind.gpsGloInterSystemBias.validMask =
+                    QMI_LOC_SYS_TIME_BIAS_VALID_V02 | QMI_LOC_SYS_TIME_BIAS_UNC_VALID_V02;
+            ind.gpsGloInterSystemBias.timeBias = 0.001f;
+            ind.gpsBdsInterSystemBias = ind.gpsGloInterSystemBias;
+            ind.gpsBdsInterSystemBias_valid = 1;
+            ind.gpsGalInterSystemBias = ind.gpsGloInterSystemBias;
+            ind.gpsGalInterSystemBias_valid = 1;
+            ind.GpsL1L5TimeBias = ind.gpsGloInterSystemBias;
+            ind.GpsL1L5TimeBias_valid = 1;
+            ind.GalE1E5aTimeBias = ind.gpsGloInterSystemBias;
+            ind.GalE1E5aTimeBias_valid = 1;
+            ind.BdsB1iB2aTimeBias = ind.gpsGloInterSystemBias;
+            ind.BdsB1iB2aTimeBias_valid = 1;
+
+            uint32_t numSvs = std::min(part.numSvs, (uint32_t)
+                    (QMI_LOC_SV_MEAS_LIST_MAX_SIZE_V02 + QMI_LOC_EXT_SV_MEAS_LIST_MAX_SIZE_V02));
+            ind.svMeasurement_valid = 1;
+            ind.svMeasurement_len = std::min(numSvs, (uint32_t)QMI_LOC_SV_MEAS_LIST_MAX_SIZE_V02);
+            ind.svCarrierPhaseUncertainty_valid = 1;
+            ind.svCarrierPhaseUncertainty_len = ind.svMeasurement_len;
+            for (uint32_t i = 0; i < ind.svMeasurement_len; i++) {
+                fillSv(ind.svMeasurement[i], part.firstSvId + i, epoch);
+                ind.svCarrierPhaseUncertainty[i] = 0.01f;
+            }
+            if (numSvs > ind.svMeasurement_len) {
+                ind.extSvMeasurement_valid = 1;
+                ind.extSvMeasurement_len = numSvs - ind.svMeasurement_len;
+                ind.extSvCarrierPhaseUncertainty_valid = 1;
+                ind.extSvCarrierPhaseUncertainty_len = ind.extSvMeasurement_len;
+                for (uint32_t i = 0; i < ind.extSvMeasurement_len; i++) {
+                    fillSv(ind.extSvMeasurement[i],
+                           part.firstSvId + ind.svMeasurement_len + i, epoch);
+                    ind.extSvCarrierPhaseUncertainty[i] = 0.01f;
+                }
+            }
+        }
+    }
+}
+
+static bool readTrace(const char* path, std::vector<MeasInd>& trace) {
+    FILE* file = fopen(path, "rb");
+    if (nullptr == file) {
+        printf("cannot open %s\n", path);
+        return false;
+    }
+    MeasInd ind;
+    while (1 == fread(&ind, sizeof(ind), 1, file)) {
+        trace.push_back(ind);
+    }
+    fclose(file);
+    if (trace.empty()) {
+        printf("no indication in %s, or not recorded with %zu byte structs\n",
+               path, sizeof(MeasInd));
+        return false;
+    }
+    return true;
+}
+
+static bool writeTrace(const char* path, const std::vector<MeasInd>& trace) {
+    FILE* file = fopen(path, "wb");
+    if (nullptr == file) {
+        printf("cannot create %s\n", path);
+        return false;
+    }
+    bool ok = trace.size() == fwrite(trace.data(), sizeof(MeasInd), trace.size(), file);
+    ok = (0 == fclose(file)) && ok;
+    if (!ok) {
+        printf("cannot write %s\n", path);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::vector<MeasInd> trace;
+    const char* recording = nullptr;
+    const char* output = nullptr;
+    int epochs = DEFAULT_EPOCHS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:w:n:")) != -1) {
+        switch (opt) {
+        case 'f': recording = optarg; break;
+        case 'w': output = optarg; break;
+        case 'n': epochs = atoi(optarg); break;
+        default:
+            printf("usage: %s [-f recording] [-w file] [-n epochs]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (nullptr != recording) {
+        if (!readTrace(recording, trace)) {
+            return 1;
+        }
+    } else {
+        synthesizeTrace(trace, epochs > 0 ? epochs : DEFAULT_EPOCHS);
+        if (nullptr != output) {
+            return writeTrace(output, trace) ? 0 : 1;
+        }
+    }
+
+    LocApiV02MeasReplayBench api;
+    std::vector<uint64_t> partNs, epochNs;
+    uint64_t numEpochs = 0;
+
+    partNs.reserve(trace.size());
+    epochNs.reserve(trace.size());
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        uint64_t allocs = sAllocCount.load();
+        uint64_t epochStart = nowNs();
+
+        partNs.clear();
+        epochNs.clear();
+        numEpochs = 0;
+        for (const MeasInd& ind : trace) {
+            uint64_t start = nowNs();
+            api.report(ind);
+            uint64_t end = nowNs();
+
+            partNs.push_back(end - start);
+            if (ind.seqNum == ind.maxMessageNum &&
+                (!ind.subSeqNum_valid || !ind.maxSubSeqNum_valid ||
+                 ind.subSeqNum == ind.maxSubSeqNum)) {
+                epochNs.push_back(end - epochStart);
+                numEpochs++;
+                epochStart = nowNs();
+            }
+        }
+        allocs = sAllocCount.load() - allocs;
+
+        printf("pass %d: %zu parts, %" PRIu64 " epochs\n", pass, trace.size(), numEpochs);
+        printf("  part   p50 %7.1f us  p99 %7.1f us  max %7.1f us\n",
+               percentileUs(partNs, 50), percentileUs(partNs, 99), percentileUs(partNs, 100));
+        printf("  epoch  p50 %7.1f us  p99 %7.1f us  max %7.1f us  %6.2f allocs/epoch\n",
+               percentileUs(epochNs, 50), percentileUs(epochNs, 99), percentileUs(epochNs, 100),
+               numEpochs ? (double)allocs / numEpochs : 0.0);
+    }
+    return 0;
+}
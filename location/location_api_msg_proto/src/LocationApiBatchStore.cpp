@@ -0,0 +1,503 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <log_util.h>
+#include "LocationApiBatchStore.h"
+
+#define BATCH_STORE_SUFFIX      ".batch"
+#define BATCH_STORE_MAGIC       0x4c424253  // "SBBL"
+#define BATCH_STORE_VERSION     1
+#define BATCH_STORE_HEADER_SIZE 64
+
+// shared part of the store, at the start of the file and followed by the ring
+struct LocationApiBatchStore::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t reserved;
+    // byte offsets of the oldest block and of the end of the newest one, they
+    // only grow, the position in the ring is offset % capacity
+    std::atomic<uint64_t> beginOffset;
+    std::atomic<uint64_t> endOffset;
+    // sequence number one past the newest fix, the first fix is 1
+    std::atomic<uint64_t> endSeq;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && ATOMIC_LLONG_LOCK_FREE == 2,
+              "batch store header is shared between processes");
+
+namespace {
+
+struct BlockHeader {
+    uint32_t length;    // in bytes, this header included
+    uint32_t count;
+    uint64_t firstSeq;
+};
+
+// Location fields, in the order of their bits in the changed mask of a fix
+enum {
+    FIELD_FLAGS,
+    FIELD_TIMESTAMP,
+    FIELD_LATITUDE,
+    FIELD_LONGITUDE,
+    FIELD_ALTITUDE,
+    FIELD_SPEED,
+    FIELD_BEARING,
+    FIELD_ACCURACY,
+    FIELD_VERTICAL_ACCURACY,
+    FIELD_SPEED_ACCURACY,
+    FIELD_BEARING_ACCURACY,
+    FIELD_TECH_MASK,
+    FIELD_ELAPSED_REAL_TIME,
+    FIELD_ELAPSED_REAL_TIME_UNC,
+    FIELD_TIME_UNC_MS,
+    FIELD_COUNT
+};
+
+// state carried from one fix of a block to the next
+struct FixState {
+    uint64_t fields[FIELD_COUNT];
+    int64_t intervals[FIELD_COUNT];
+};
+
+inline bool isIntervalField(int field) {
+    return FIELD_TIMESTAMP == field || FIELD_ELAPSED_REAL_TIME == field;
+}
+
+inline uint64_t doubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline uint64_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline double bitsDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline float bitsFloat(uint64_t bits) {
+    uint32_t bits32 = (uint32_t)bits;
+    float value;
+    memcpy(&value, &bits32, sizeof(value));
+    return value;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void toFields(const Location& location, uint64_t fields[FIELD_COUNT]) {
+    fields[FIELD_FLAGS] = location.flags;
+    fields[FIELD_TIMESTAMP] = location.timestamp;
+    fields[FIELD_LATITUDE] = doubleBits(location.latitude);
+    fields[FIELD_LONGITUDE] = doubleBits(location.longitude);
+    fields[FIELD_ALTITUDE] = doubleBits(location.altitude);
+    fields[FIELD_SPEED] = floatBits(location.speed);
+    fields[FIELD_BEARING] = floatBits(location.bearing);
+    fields[FIELD_ACCURACY] = floatBits(location.accuracy);
+    fields[FIELD_VERTICAL_ACCURACY] = floatBits(location.verticalAccuracy);
+    fields[FIELD_SPEED_ACCURACY] = floatBits(location.speedAccuracy);
+    fields[FIELD_BEARING_ACCURACY] = floatBits(location.bearingAccuracy);
+    fields[FIELD_TECH_MASK] = location.techMask;
+    fields[FIELD_ELAPSED_REAL_TIME] = location.elapsedRealTime;
+    fields[FIELD_ELAPSED_REAL_TIME_UNC] = location.elapsedRealTimeUnc;
+    fields[FIELD_TIME_UNC_MS] = floatBits(location.timeUncMs);
+}
+
+void fromFields(const uint64_t fields[FIELD_COUNT], Location& location) {
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(Location);
+    location.flags = (LocationFlagsMask)fields[FIELD_FLAGS];
+    location.timestamp = fields[FIELD_TIMESTAMP];
+    location.latitude = bitsDouble(fields[FIELD_LATITUDE]);
+    location.longitude = bitsDouble(fields[FIELD_LONGITUDE]);
+    location.altitude = bitsDouble(fields[FIELD_ALTITUDE]);
+    location.speed = bitsFloat(fields[FIELD_SPEED]);
+    location.bearing = bitsFloat(fields[FIELD_BEARING]);
+    location.accuracy = bitsFloat(fields[FIELD_ACCURACY]);
+    location.verticalAccuracy = bitsFloat(fields[FIELD_VERTICAL_ACCURACY]);
+    location.speedAccuracy = bitsFloat(fields[FIELD_SPEED_ACCURACY]);
+    location.bearingAccuracy = bitsFloat(fields[FIELD_BEARING_ACCURACY]);
+    location.techMask = (LocationTechnologyMask)fields[FIELD_TECH_MASK];
+    location.elapsedRealTime = fields[FIELD_ELAPSED_REAL_TIME];
+    location.elapsedRealTimeUnc = fields[FIELD_ELAPSED_REAL_TIME_UNC];
+    location.timeUncMs = bitsFloat(fields[FIELD_TIME_UNC_MS]);
+}
+
+// Timestamps are coded as the change of their interval, which is 0 for fixes
+// at a steady rate. The interval is not carried over from a zero value, so
+// that the second fix of a block is coded against the first one and not
+// against its absolute time.
+void encodeFix(std::string& out, FixState& state, const Location& location) {
+    uint64_t fields[FIELD_COUNT];
+    uint64_t values[FIELD_COUNT];
+    uint64_t mask = 0;
+
+    toFields(location, fields);
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (isIntervalField(i)) {
+            int64_t interval = (int64_t)(fields[i] - state.fields[i]);
+            values[i] = zigzag(interval - state.intervals[i]);
+            state.intervals[i] = (0 == state.fields[i]) ? 0 : interval;
+        } else {
+            values[i] = fields[i] ^ state.fields[i];
+        }
+        state.fields[i] = fields[i];
+        if (0 != values[i]) {
+            mask |= 1 << i;
+        }
+    }
+    putVarint(out, mask);
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (mask & (1 << i)) {
+            putVarint(out, values[i]);
+        }
+    }
+}
+
+bool decodeFix(const uint8_t*& p, const uint8_t* end, FixState& state, Location& location) {
+    uint64_t mask;
+
+    if (!getVarint(p, end, mask) || (mask >> FIELD_COUNT)) {
+        return false;
+    }
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        uint64_t value = 0;
+        if ((mask & (1 << i)) && !getVarint(p, end, value)) {
+            return false;
+        }
+        if (isIntervalField(i)) {
+            int64_t interval = state.intervals[i] + unzigzag(value);
+            state.intervals[i] = (0 == state.fields[i]) ? 0 : interval;
+            state.fields[i] += interval;
+        } else {
+            state.fields[i] ^= value;
+        }
+    }
+    fromFields(state.fields, location);
+    return true;
+}
+
+} // namespace
+
+std::string LocationApiBatchStore::getPath(const std::string& socketName) {
+    return socketName + BATCH_STORE_SUFFIX;
+}
+
+LocationApiBatchStore* LocationApiBatchStore::create(const std::string& path, gid_t group,
+        uint32_t capacity) {
+    if (capacity < MIN_CAPACITY || capacity > MAX_CAPACITY) {
+        LOC_LOGe("invalid capacity %u", capacity);
+        return nullptr;
+    }
+    size_t size = BATCH_STORE_HEADER_SIZE + capacity;
+
+    // whatever is left under that name, a store of an earlier daemon included
+    unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        LOC_LOGe("failed to create %s: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    if ((group != getegid()) && (0 != fchown(fd, -1, group))) {
+        LOC_LOGw("%s not readable by group %u: %s", path.c_str(), group, strerror(errno));
+    }
+    // allocated up front so that writing to the mapping can not fail later
+    int err = posix_fallocate(fd, 0, size);
+    if (0 != err) {
+        LOC_LOGe("failed to allocate %zu bytes for %s: %s", size, path.c_str(), strerror(err));
+        close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) {
+        LOC_LOGe("failed to map %s: %s", path.c_str(), strerror(errno));
+        unlink(path.c_str());
+        return nullptr;
+    }
+
+    Header* header = new (map) Header;
+    header->magic = BATCH_STORE_MAGIC;
+    header->version = BATCH_STORE_VERSION;
+    header->capacity = capacity;
+    header->reserved = 0;
+    header->beginOffset.store(0, std::memory_order_relaxed);
+    header->endOffset.store(0, std::memory_order_relaxed);
+    header->endSeq.store(1, std::memory_order_release);
+    return new LocationApiBatchStore(path, (uint8_t*)map, capacity, true);
+}
+
+LocationApiBatchStore* LocationApiBatchStore::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        LOC_LOGe("failed to open %s: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if ((0 != fstat(fd, &st)) || !S_ISREG(st.st_mode) ||
+            (st.st_size < (off_t)BATCH_STORE_HEADER_SIZE + MIN_CAPACITY) ||
+            (st.st_size > (off_t)BATCH_STORE_HEADER_SIZE + MAX_CAPACITY)) {
+        LOC_LOGe("%s is not a batch store", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) {
+        LOC_LOGe("failed to map %s: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+
+    const Header* header = (const Header*)map;
+    if ((BATCH_STORE_MAGIC != header->magic) || (BATCH_STORE_VERSION != header->version) ||
+            (size != BATCH_STORE_HEADER_SIZE + header->capacity)) {
+        LOC_LOGe("%s is not a batch store of version %d", path.c_str(), BATCH_STORE_VERSION);
+        munmap(map, size);
+        return nullptr;
+    }
+    return new LocationApiBatchStore(path, (uint8_t*)map, header->capacity, false);
+}
+
+LocationApiBatchStore::LocationApiBatchStore(const std::string& path, uint8_t* map,
+        uint32_t capacity, bool writer) :
+        mPath(path),
+        mMap(map),
+        mRing(map + BATCH_STORE_HEADER_SIZE),
+        mCapacity(capacity),
+        mWriter(writer),
+        mBeginOffset(0),
+        mEndOffset(0),
+        mEndSeq(1) {
+    static_assert(sizeof(Header) <= BATCH_STORE_HEADER_SIZE, "header does not fit");
+}
+
+LocationApiBatchStore::~LocationApiBatchStore() {
+    munmap(mMap, BATCH_STORE_HEADER_SIZE + mCapacity);
+    if (mWriter) {
+        unlink(mPath.c_str());
+    }
+}
+
+void LocationApiBatchStore::copyIn(uint64_t offset, const uint8_t* data, size_t length) {
+    size_t pos = offset % mCapacity;
+    size_t first = std::min(length, (size_t)mCapacity - pos);
+
+    memcpy(mRing + pos, data, first);
+    memcpy(mRing, data + first, length - first);
+}
+
+void LocationApiBatchStore::copyOut(uint64_t offset, uint8_t* data, size_t length) const {
+    size_t pos = offset % mCapacity;
+    size_t first = std::min(length, (size_t)mCapacity - pos);
+
+    memcpy(data, mRing + pos, first);
+    memcpy(data + first, mRing, length - first);
+}
+
+uint64_t LocationApiBatchStore::append(const Location* locations, size_t count) {
+    if (!mWriter) {
+        return 0;
+    }
+    Header* hdr = header();
+
+    for (size_t i = 0; i < count; ) {
+        uint32_t n = (uint32_t)std::min(count - i, (size_t)FIXES_PER_BLOCK);
+        FixState state = {};
+
+        mScratch.resize(sizeof(BlockHeader));
+        for (uint32_t j = 0; j < n; j++) {
+            encodeFix(mScratch, state, locations[i + j]);
+        }
+        BlockHeader block = { (uint32_t)mScratch.size(), n, mEndSeq };
+        memcpy(&mScratch[0], &block, sizeof(block));
+
+        // drop the oldest blocks to make room, readers see the new begin
+        // before any of the block is overwritten
+        while (mEndOffset + block.length - mBeginOffset > mCapacity) {
+            mBeginOffset += mBlocks.front().first;
+            mBlocks.pop_front();
+        }
+        hdr->beginOffset.store(mBeginOffset, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        copyIn(mEndOffset, (const uint8_t*)mScratch.data(), block.length);
+        mBlocks.push_back(std::make_pair(block.length, n));
+        mEndOffset += block.length;
+        mEndSeq += n;
+        // end sequence first, a reader that got to a fix sees it covered
+        hdr->endSeq.store(mEndSeq, std::memory_order_relaxed);
+        hdr->endOffset.store(mEndOffset, std::memory_order_release);
+        i += n;
+    }
+    return mEndSeq;
+}
+
+uint64_t LocationApiBatchStore::getEndSeq() const {
+    return header()->endSeq.load(std::memory_order_acquire);
+}
+
+uint64_t LocationApiBatchStore::getSize() const {
+    const Header* hdr = header();
+    uint64_t end = hdr->endOffset.load(std::memory_order_acquire);
+    return end - std::min(end, hdr->beginOffset.load(std::memory_order_acquire));
+}
+
+size_t LocationApiBatchStore::read(Cursor& cursor, std::vector<Location>& locations,
+        size_t maxCount, uint64_t* lost) const {
+    const Header* hdr = header();
+
+    locations.clear();
+    if (nullptr != lost) {
+        *lost = 0;
+    }
+    uint64_t endSeq = hdr->endSeq.load(std::memory_order_acquire);
+    if (cursor.seq > endSeq) {
+        LOC_LOGw("%s was emptied, reading from the start", mPath.c_str());
+        cursor = Cursor();
+    }
+
+    while (locations.size() < maxCount) {
+        uint64_t begin = hdr->beginOffset.load(std::memory_order_acquire);
+        uint64_t end = hdr->endOffset.load(std::memory_order_acquire);
+        if ((cursor.offset < begin) || (cursor.offset > end)) {
+            cursor.offset = begin;
+        }
+        if (cursor.offset == end) {
+            break;
+        }
+
+        BlockHeader block;
+        copyOut(cursor.offset, (uint8_t*)&block, sizeof(block));
+        bool valid = (block.length >= sizeof(block)) && (block.length <= end - cursor.offset) &&
+                (block.count > 0) && (block.count <= FIXES_PER_BLOCK);
+        if (valid) {
+            mReadBuffer.resize(block.length);
+            copyOut(cursor.offset, (uint8_t*)&mReadBuffer[0], block.length);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (hdr->beginOffset.load(std::memory_order_relaxed) > cursor.offset) {
+            // dropped by the writer while it was being copied
+            continue;
+        }
+        if (!valid) {
+            LOC_LOGe("%s: bad block at %" PRIu64 ", skipping to the end", mPath.c_str(),
+                     cursor.offset);
+            cursor.offset = end;
+            cursor.seq = hdr->endSeq.load(std::memory_order_acquire);
+            break;
+        }
+
+        if (cursor.seq >= block.firstSeq + block.count) {
+            // looking for the cursor from the oldest block
+            cursor.offset += block.length;
+            continue;
+        }
+        if (cursor.seq < block.firstSeq) {
+            if (nullptr != lost) {
+                *lost += block.firstSeq - cursor.seq;
+            }
+            cursor.seq = block.firstSeq;
+        }
+
+        const uint8_t* p = (const uint8_t*)mReadBuffer.data() + sizeof(block);
+        const uint8_t* pEnd = (const uint8_t*)mReadBuffer.data() + block.length;
+        FixState state = {};
+        Location location;
+        uint64_t seq = block.firstSeq;
+        for (; seq < block.firstSeq + block.count && locations.size() < maxCount; seq++) {
+            if (!decodeFix(p, pEnd, state, location)) {
+                valid = false;
+                break;
+            }
+            if (seq >= cursor.seq) {
+                locations.push_back(location);
+            }
+        }
+        if (!valid) {
+            LOC_LOGe("%s: bad fix %" PRIu64 ", skipping to the end", mPath.c_str(), seq);
+            cursor.offset = end;
+            cursor.seq = hdr->endSeq.load(std::memory_order_acquire);
+            break;
+        }
+        cursor.seq = seq;
+        if (seq == block.firstSeq + block.count) {
+            cursor.offset += block.length;
+        }
+    }
+    return locations.size();
+}
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LOCATION_API_BATCH_STORE_H
+#define LOCATION_API_BATCH_STORE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <LocationDataTypes.h>
+
+// LocationApiBatchStore - ring of batched fixes in a file that location hal
+// daemon writes and the client maps, so that a batch of hours of fixes is not
+// serialized into one indication. When a client asks for it on starting
+// batching, the daemon creates the store next to the client socket, appends
+// the fixes it gets from the engine and only sends the sequence number of the
+// end of the store in the batching indication. The client then reads the
+// fixes with a cursor, as many at a time as it wants.
+//
+// Fixes are kept in blocks of up to FIXES_PER_BLOCK. The first fix of a block
+// is encoded against an all zero Location and every other one against the fix
+// before it: a varint mask of the fields that changed, then for each of those
+// the xor of the bits for floating point fields and masks, or the change of
+// the interval for the two timestamps. A 1 Hz fix takes around 33 bytes this
+// way, against about 83 for PBLocation, so the default capacity holds more
+// than a day of them. When the ring is full the oldest blocks are dropped.
+//
+// The writer keeps the block layout on its side and never reads back from
+// the file. A reader checks after copying a block that it was not
+// overwritten meanwhile and skips ahead to the oldest block if it was.
+class LocationApiBatchStore {
+public:
+    static const uint32_t DEFAULT_CAPACITY = 4 * 1024 * 1024;
+    static const uint32_t MIN_CAPACITY = 64 * 1024;
+    static const uint32_t MAX_CAPACITY = 64 * 1024 * 1024;
+    static const uint32_t FIXES_PER_BLOCK = 64;
+
+    // position of a reader, seq is the sequence number of the next fix to
+    // read and offset a hint to the block holding it; a new cursor starts
+    // from the first fix appended
+    struct Cursor {
+        uint64_t seq;
+        uint64_t offset;
+        inline Cursor() : seq(1), offset(0) {}
+    };
+
+    // store file name for the client socket
+    static std::string getPath(const std::string& socketName);
+
+    // daemon side, creates an empty store of capacity bytes, readable by
+    // group, and maps it for appending. The file is removed again when the
+    // store is deleted.
+    static LocationApiBatchStore* create(const std::string& path, gid_t group,
+                                         uint32_t capacity = DEFAULT_CAPACITY);
+    // client side, maps the store the daemon created for reading
+    static LocationApiBatchStore* open(const std::string& path);
+    ~LocationApiBatchStore();
+
+    // appends count fixes and returns the sequence number one past the last
+    // of them, 0 if the store can not take them
+    uint64_t append(const Location* locations, size_t count);
+    // sequence number one past the newest fix
+    uint64_t getEndSeq() const;
+    // bytes of the ring taken by the fixes in the store
+    uint64_t getSize() const;
+
+    // reads up to maxCount fixes from cursor into locations, which is cleared
+    // first, and moves the cursor past them. Fixes dropped from the ring
+    // before the cursor got to them are counted in lost.
+    size_t read(Cursor& cursor, std::vector<Location>& locations, size_t maxCount,
+                uint64_t* lost = nullptr) const;
+
+private:
+    struct Header;
+
+    LocationApiBatchStore(const std::string& path, uint8_t* map, uint32_t capacity,
+                          bool writer);
+    LocationApiBatchStore(const LocationApiBatchStore&) = delete;
+    LocationApiBatchStore& operator=(const LocationApiBatchStore&) = delete;
+
+    inline Header* header() const { return reinterpret_cast<Header*>(mMap); }
+    void copyIn(uint64_t offset, const uint8_t* data, size_t length);
+    void copyOut(uint64_t offset, uint8_t* data, size_t length) const;
+
+    const std::string mPath;
+    uint8_t* const mMap;
+    uint8_t* const mRing;
+    const uint32_t mCapacity;
+    const bool mWriter;
+
+    // writer state, kept here rather than taken from the shared header;
+    // blocks in the ring as pairs of byte length and fix count
+    std::deque<std::pair<uint32_t, uint32_t>> mBlocks;
+    uint64_t mBeginOffset;
+    uint64_t mEndOffset;
+    uint64_t mEndSeq;
+    std::string mScratch;
+    // reader copy of the block being decoded
+    mutable std::string mReadBuffer;
+};
+
+#endif /* LOCATION_API_BATCH_STORE_H */
@@ -0,0 +1,292 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Batching benchmark for LocationApiBatchStore. For batches of 10k to 100k
+1 Hz fixes it compares sending them the way LocAPIBatchingIndMsg does, all
+fixes in one PBLocAPIBatchingIndMsg serialized into the envelope, with
+appending them to a store and reading them back with a cursor. Reports the
+time the daemon is busy with the batch, the longest stall of the client,
+the peak heap of each side and the bytes per fix, and checks that the fixes
+read from the store are the ones appended.
+
+usage: location_api_batch_store_bench [store directory]
+*/
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+#include "LocationApiMsg.pb.h"
+#include "LocationApiBatchStore.h"
+
+#define READ_COUNT  256     // fixes per read of the client
+
+static const size_t sBatchSizes[] = { 10000, 30000, 100000 };
+
+// heap accounting
+static std::atomic<int64_t> sHeapLive(0);
+static std::atomic<int64_t> sHeapPeak(0);
+
+void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    int64_t live = sHeapLive.fetch_add(malloc_usable_size(p), std::memory_order_relaxed) +
+            malloc_usable_size(p);
+    int64_t peak = sHeapPeak.load(std::memory_order_relaxed);
+    while (live > peak &&
+            !sHeapPeak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (nullptr != p) {
+        sHeapLive.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+        free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int64_t resetHeapPeak() {
+    int64_t live = sHeapLive.load();
+    sHeapPeak.store(live);
+    return live;
+}
+
+// a walk at 1 Hz, with the jitter of real fixes in the low bits
+static void fillFixes(std::vector<Location>& fixes) {
+    double lat = 37.4219999, lon = -122.0840575;
+    for (size_t i = 0; i < fixes.size(); i++) {
+        Location& location = fixes[i];
+        memset(&location, 0, sizeof(location));
+        location.size = sizeof(location);
+        location.flags = 0x1ff;
+        location.timestamp = 1660000000000ULL + i * 1000 + (rand() % 3);
+        lat += 1e-5 * sin(i / 300.0) + (rand() % 100) * 1e-9;
+        lon += 1e-5 * cos(i / 300.0) + (rand() % 100) * 1e-9;
+        location.latitude = lat;
+        location.longitude = lon;
+        location.altitude = 12.5 + (rand() % 50) / 10.0;
+        location.speed = 1.25f + (rand() % 20) / 100.0f;
+        location.bearing = (float)fmod(i / 300.0 * 57.3, 360.0);
+        location.accuracy = 3.0f + (rand() % 4) / 2.0f;
+        location.verticalAccuracy = 4.8f;
+        location.speedAccuracy = 0.4f;
+        location.bearingAccuracy = 5.0f;
+        location.techMask = 0x1;
+        location.elapsedRealTime = 5000000000ULL + i * 1000000000ULL + (rand() % 1000) * 1000;
+        location.elapsedRealTimeUnc = 1000000;
+    }
+}
+
+static bool sameFix(const Location& a, const Location& b) {
+    return a.flags == b.flags && a.timestamp == b.timestamp && a.latitude == b.latitude &&
+            a.longitude == b.longitude && a.altitude == b.altitude && a.speed == b.speed &&
+            a.bearing == b.bearing && a.accuracy == b.accuracy &&
+            a.verticalAccuracy == b.verticalAccuracy && a.speedAccuracy == b.speedAccuracy &&
+            a.bearingAccuracy == b.bearingAccuracy && a.techMask == b.techMask &&
+            a.elapsedRealTime == b.elapsedRealTime &&
+            a.elapsedRealTimeUnc == b.elapsedRealTimeUnc && a.timeUncMs == b.timeUncMs;
+}
+
+// what LocAPIBatchingIndMsg::serializeToProtobuf() and the client do with a batch
+static void benchMessage(const std::vector<Location>& fixes) {
+    uint64_t start, encodeNs, decodeNs;
+    int64_t base, encodeHeap, decodeHeap;
+    size_t bytes;
+
+    base = resetHeapPeak();
+    start = nowNs();
+    std::string out;
+    {
+        PBLocAPIBatchingIndMsg msg;
+        PBLocAPIBatchNotification* notif = msg.mutable_batchnotification();
+        for (const Location& location : fixes) {
+            PBLocation* pbLocation = notif->add_location();
+            pbLocation->set_flags(location.flags);
+            pbLocation->set_timestamp(location.timestamp);
+            pbLocation->set_latitude(location.latitude);
+            pbLocation->set_longitude(location.longitude);
+            pbLocation->set_altitude(location.altitude);
+            pbLocation->set_speed(location.speed);
+            pbLocation->set_bearing(location.bearing);
+            pbLocation->set_horizontalaccuracy(location.accuracy);
+            pbLocation->set_verticalaccuracy(location.verticalAccuracy);
+            pbLocation->set_speedaccuracy(location.speedAccuracy);
+            pbLocation->set_bearingaccuracy(location.bearingAccuracy);
+            pbLocation->set_techmask(location.techMask);
+            pbLocation->set_elapsedrealtime(location.elapsedRealTime);
+            pbLocation->set_elapsedrealtimeunc(location.elapsedRealTimeUnc);
+            pbLocation->set_timeuncms(location.timeUncMs);
+        }
+        std::string pbStr;
+        msg.SerializeToString(&pbStr);
+        PBLocAPIMsgHeader hdr;
+        hdr.set_msocketname("/dev/socket/location/hal_daemon");
+        hdr.set_msgid(PB_E_LOCAPI_BATCHING_MSG_ID);
+        hdr.set_msgversion(1);
+        hdr.set_payload(pbStr);
+        hdr.set_payloadsize(sizeof(PBLocAPIBatchingIndMsg));
+        hdr.SerializeToString(&out);
+    }
+    encodeNs = nowNs() - start;
+    encodeHeap = sHeapPeak.load() - base;
+    bytes = out.size();
+
+    base = resetHeapPeak();
+    start = nowNs();
+    {
+        PBLocAPIMsgHeader hdr;
+        PBLocAPIBatchingIndMsg msg;
+        hdr.ParseFromString(out);
+        msg.ParseFromString(hdr.payload());
+        std::vector<Location> locations(msg.batchnotification().location_size());
+    }
+    decodeNs = nowNs() - start;
+    decodeHeap = sHeapPeak.load() - base;
+
+    printf("  message  %6.1f bytes/fix  daemon %7.2f ms %8.1f KB heap"
+           "  client stall %7.2f ms %8.1f KB heap\n",
+           (double)bytes / fixes.size(), encodeNs / 1e6, encodeHeap / 1024.0,
+           decodeNs / 1e6, decodeHeap / 1024.0);
+}
+
+static int benchStore(const std::string& path, const std::vector<Location>& fixes) {
+    uint64_t start, appendNs, readNs = 0, maxReadNs = 0, lost = 0, lostTotal = 0;
+    int64_t base, appendHeap, readHeap;
+    size_t count, readTotal = 0;
+    int ret = 0;
+
+    LocationApiBatchStore* writer = LocationApiBatchStore::create(path, getgid());
+    if (nullptr == writer) {
+        printf("  FAIL: can not create %s\n", path.c_str());
+        return -1;
+    }
+    LocationApiBatchStore* reader = LocationApiBatchStore::open(path);
+    if (nullptr == reader) {
+        printf("  FAIL: can not open %s\n", path.c_str());
+        delete writer;
+        return -1;
+    }
+
+    base = resetHeapPeak();
+    start = nowNs();
+    uint64_t endSeq = writer->append(fixes.data(), fixes.size());
+    appendNs = nowNs() - start;
+    appendHeap = sHeapPeak.load() - base;
+
+    // the client drains the store READ_COUNT fixes at a time
+    std::vector<Location> locations;
+    LocationApiBatchStore::Cursor cursor;
+    base = resetHeapPeak();
+    while (cursor.seq < endSeq) {
+        start = nowNs();
+        count = reader->read(cursor, locations, READ_COUNT, &lost);
+        uint64_t ns = nowNs() - start;
+        readNs += ns;
+        maxReadNs = std::max(maxReadNs, ns);
+        lostTotal += lost;
+        if (0 == count) {
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (!sameFix(locations[i], fixes[lostTotal + readTotal + i])) {
+                ret = -1;
+            }
+        }
+        readTotal += count;
+    }
+    readHeap = sHeapPeak.load() - base;
+    if (0 != ret || lostTotal + readTotal != fixes.size()) {
+        printf("  FAIL: read %zu and lost %" PRIu64 " of %zu fixes, %s\n", readTotal, lostTotal,
+               fixes.size(), 0 != ret ? "fixes differ" : "count differs");
+        ret = -1;
+    }
+
+    uint64_t mapped = 0;
+    struct stat st;
+    if (0 == stat(path.c_str(), &st)) {
+        mapped = st.st_size;
+    }
+    printf("  store    %6.1f bytes/fix  daemon %7.2f ms %8.1f KB heap"
+           "  client stall %7.2f ms %8.1f KB heap, %.2f ms to drain, %" PRIu64 " lost,"
+           " %.0f KB mapped\n",
+           (double)writer->getSize() / std::max((size_t)1, readTotal), appendNs / 1e6,
+           appendHeap / 1024.0, maxReadNs / 1e6, readHeap / 1024.0, readNs / 1e6, lostTotal,
+           mapped / 1024.0);
+
+    delete reader;
+    delete writer;
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    std::string path = dir + "/location_api_batch_store_bench." + std::to_string(getpid());
+    int ret = 0;
+
+    srand(1);
+    for (size_t n : sBatchSizes) {
+        std::vector<Location> fixes(n);
+        fillFixes(fixes);
+        printf("%zu fixes\n", n);
+        benchMessage(fixes);
+        ret |= benchStore(LocationApiBatchStore::getPath(path), fixes);
+    }
+
+    printf("%s\n", ret ? "FAILED" : "PASSED");
+    return ret ? 1 : 0;
+}
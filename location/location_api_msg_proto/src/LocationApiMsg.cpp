@@ -77,6 +77,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <LocationApiMsg.h>
 #include <LocationApiPbMsgConv.h>
+#include <LocationApiPbEncoder.h>
 
 using namespace loc_util;
 
@@ -236,19 +237,11 @@ int LocAPIClientRegisterReqMsg::serializeToProtobuf(string& protoStr) {
     // PBClientType mClientType = 1;
     pbLocApiClientRegMsg.set_mclienttype(pLocApiPbMsgConv->getPBEnumForClientType(mClientType));
 
-    string pbStr;
-    if (!pbLocApiClientRegMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiClientRegMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIClientRegisterReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiClientRegMsg,
+            sizeof(LocAPIClientRegisterReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiClientRegMsg failed!");
         return 0;
     }
     return protoStr.size();
@@ -302,19 +295,11 @@ int LocAPICapabilitiesIndMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiCapabInd.set_capabilitiesmask(
             pLocApiPbMsgConv->getPBMaskForLocationCapabilitiesMask(capabilitiesMask));
 
-    string pbStr;
-    if (!pbLocApiCapabInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiCapabInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPICapabilitiesIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiCapabInd,
+            sizeof(LocAPICapabilitiesIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiCapabInd failed!");
         return 0;
     }
     return protoStr.size();
@@ -367,19 +352,11 @@ int LocAPIGenericRespMsg::serializeToProtobuf(string& protoStr) {
     // PBLocationError err = 1;
     pbLocApiGenericMsg.set_err(pLocApiPbMsgConv->getPBEnumForLocationError(err));
 
-    string pbStr;
-    if (!pbLocApiGenericMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGenericMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGenericRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiGenericMsg,
+            sizeof(LocAPIGenericRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiGenericMsg failed!");
         return 0;
     }
     return protoStr.size();
@@ -415,19 +392,11 @@ int LocAPICollectiveRespMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiCollctvRspMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiCollctvRspMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPICollectiveRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiCollctvRspMsg,
+            sizeof(LocAPICollectiveRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiCollctvRspMsg failed!");
         return 0;
     }
     // free memory
@@ -465,19 +434,11 @@ int LocAPIStartTrackingReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiStartTrack.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStartTrack failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStartTrackingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiStartTrack,
+            sizeof(LocAPIStartTrackingReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiStartTrack failed!");
         return 0;
     }
     // free memory
@@ -505,19 +466,11 @@ int LocAPIStopTrackingReqMsg::serializeToProtobuf(string& protoStr) {
     // bool clearSubscriptions
     pbLocApiStopTrackingReqMsg.set_clearsubscriptions(clearSubscriptions);
 
-    string pbStr;
-    if (!pbLocApiStopTrackingReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStopTrackingReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStopTrackingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiStopTrackingReqMsg,
+            sizeof(LocAPIStopTrackingReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiStopTrackingReqMsg failed!");
         return 0;
     }
     return protoStr.size();
@@ -544,19 +497,11 @@ int LocAPIUpdateCallbacksReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiUpdateCbsReg.set_locationcallbacks(
             pLocApiPbMsgConv->getPBMaskForLocationCallbacksMask(locationCallbacks));
 
-    string pbStr;
-    if (!pbLocApiUpdateCbsReg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUpdateCbsReg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateCallbacksReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiUpdateCbsReg,
+            sizeof(LocAPIUpdateCallbacksReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiUpdateCbsReg failed!");
         return 0;
     }
     return protoStr.size();
@@ -592,19 +537,11 @@ int LocAPIUpdateTrackingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiUpdtTrackOpt.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUpdtTrackOpt failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateTrackingOptionsReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiUpdtTrackOpt,
+            sizeof(LocAPIUpdateTrackingOptionsReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiUpdtTrackOpt failed!");
         return 0;
     }
     // free memory
@@ -635,20 +572,14 @@ int LocAPIStartBatchingReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiStartBatch.set_distanceinmeters(distanceInMeters);
     // PBBatchingMode batchingMode = 3;
     pbLocApiStartBatch.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
+    // bool useBatchStore = 4;
+    pbLocApiStartBatch.set_usebatchstore(useBatchStore);
 
-    string pbStr;
-    if (!pbLocApiStartBatch.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStartBatch failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStartBatchingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiStartBatch,
+            sizeof(LocAPIStartBatchingReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiStartBatch failed!");
         return 0;
     }
     return protoStr.size();
@@ -703,20 +634,14 @@ int LocAPIUpdateBatchingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiUptBatchOpt.set_distanceinmeters(distanceInMeters);
     // PBBatchingMode batchingMode = 3;
     pbLocApiUptBatchOpt.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
+    // bool useBatchStore = 4;
+    pbLocApiUptBatchOpt.set_usebatchstore(useBatchStore);
 
-    string pbStr;
-    if (!pbLocApiUptBatchOpt.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUptBatchOpt failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateBatchingOptionsReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiUptBatchOpt,
+            sizeof(LocAPIUpdateBatchingOptionsReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiUptBatchOpt failed!");
         return 0;
     }
     return protoStr.size();
@@ -752,19 +677,11 @@ int LocAPIAddGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiAddGfReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiAddGfReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIAddGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiAddGfReqMsg,
+            sizeof(LocAPIAddGeofencesReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiAddGfReqMsg failed!");
         return 0;
     }
     // free memory
@@ -802,19 +719,11 @@ int LocAPIRemoveGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiRemGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiRemGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIRemoveGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiRemGf,
+            sizeof(LocAPIRemoveGeofencesReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiRemGf failed!");
         return 0;
     }
     // free memory
@@ -852,19 +761,11 @@ int LocAPIModifyGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiModGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiModGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIModifyGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiModGf,
+            sizeof(LocAPIModifyGeofencesReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiModGf failed!");
         return 0;
     }
     // free memory
@@ -902,19 +803,11 @@ int LocAPIPauseGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiPauseGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPauseGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPauseGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiPauseGf,
+            sizeof(LocAPIPauseGeofencesReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiPauseGf failed!");
         return 0;
     }
     // free memory
@@ -952,19 +845,11 @@ int LocAPIResumeGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiResumeGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiResumeGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIResumeGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiResumeGf,
+            sizeof(LocAPIResumeGeofencesReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiResumeGf failed!");
         return 0;
     }
     // free memory
@@ -992,19 +877,11 @@ int LocAPIUpdateNetworkAvailabilityReqMsg::serializeToProtobuf(string& protoStr)
     // bool mAvailability = 1;
     pbLocApiUptNetwAvail.set_mavailability(mAvailability);
 
-    string pbStr;
-    if (!pbLocApiUptNetwAvail.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUptNetwAvail failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateNetworkAvailabilityReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiUptNetwAvail,
+            sizeof(LocAPIUpdateNetworkAvailabilityReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiUptNetwAvail failed!");
         return 0;
     }
     return protoStr.size();
@@ -1062,20 +939,11 @@ int LocAPIGetSingleTerrestrialPosReqMsg::serializeToProtobuf(string& protoStr) {
     // float horQoS = 3;
     pbLocGetTerrestrialPosReq.set_horqos(mHorQoS);
 
-    string pbStr;
-    if (!pbLocGetTerrestrialPosReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetTerrestrialPosReq failed!");
-        return 0;
-    }
-
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSingleTerrestrialPosReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocGetTerrestrialPosReq,
+            sizeof(LocAPIGetSingleTerrestrialPosReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocGetTerrestrialPosReq failed!");
         return 0;
     }
     return protoStr.size();
@@ -1127,20 +995,11 @@ int LocAPIGetSingleTerrestrialPosRespMsg::serializeToProtobuf(string& protoStr)
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocGetTerrestrialPosResp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetTerrestrialPosResp failed!");
-        return 0;
-    }
-
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSingleTerrestrialPosRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocGetTerrestrialPosResp,
+            sizeof(LocAPIGetSingleTerrestrialPosRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocGetTerrestrialPosResp failed!");
         return 0;
     }
 
@@ -1191,17 +1050,11 @@ int LocAPIGetSinglePosReqMsg::serializeToProtobuf(string& protoStr) {
     // float horQoS = 2;
     pbLocGetPosReq.set_horqos(mHorQoS);
 
-    string pbStr;
-    if (!pbLocGetPosReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetPosReq failed!");
-        return 0;
-    }
-
-    pLocApiMsgHdr.set_payload(pbStr);
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSinglePosReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    // bytes       payload = 4;
+    // uint32   payloadSize = 5;
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocGetPosReq,
+            sizeof(LocAPIGetSinglePosReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocGetPosReq failed!");
         return 0;
     }
     return protoStr.size();
@@ -1251,18 +1104,11 @@ int LocAPIGetSinglePosRespMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocGetPosResp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetPosResp failed!");
-        pbLocGetPosResp.clear_location();
-        return 0;
-    }
-
-    pLocApiMsgHdr.set_payload(pbStr);
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSinglePosRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    // bytes       payload = 4;
+    // uint32   payloadSize = 5;
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocGetPosResp,
+            sizeof(LocAPIGetSinglePosRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocGetPosResp failed!");
         pbLocGetPosResp.clear_location();
         return 0;
     }
@@ -1291,13 +1137,16 @@ LocAPIGetSinglePosRespMsg::LocAPIGetSinglePosRespMsg(
 
 // Convert LocAPILocationIndMsg -> PBLocAPILocationIndMsg
 int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPILocationIndMsg pbLocApiLocInd;
-
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
+    // sent for every fix, the protobuf objects go on the converter's arena
+    LocationApiPbArena::Lease arena(pLocApiPbMsgConv->getHotMsgArena());
+    PBLocAPIMsgHeader& pLocApiMsgHdr =
+            *google::protobuf::Arena::CreateMessage<PBLocAPIMsgHeader>(arena.get());
+    PBLocAPILocationIndMsg& pbLocApiLocInd =
+            *google::protobuf::Arena::CreateMessage<PBLocAPILocationIndMsg>(arena.get());
     // string      mSocketName = 1;
     pLocApiMsgHdr.set_msocketname(mSocketName);
     // PBELocMsgID  msgId = 2;
@@ -1311,7 +1160,6 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != location) {
         if (pLocApiPbMsgConv->convertLocationToPB(locationNotification, location)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(location);
             return 0;
         }
     } else {
@@ -1319,23 +1167,13 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiLocInd,
+            sizeof(LocAPILocationIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiLocInd failed!");
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPILocationIndMsg(pbLocApiLocInd);
     return protoStr.size();
 }
 
@@ -1371,19 +1209,13 @@ int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
     }
     // PBBatchingMode batchingMode = 2;
     pbLocApiBatchInd.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
-    string pbStr;
-    if (!pbLocApiBatchInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiBatchInd failed!");
-        return 0;
-    }
+    // uint64 batchStoreEndSeq = 3;
+    pbLocApiBatchInd.set_batchstoreendseq(batchStoreEndSeq);
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIBatchingIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiBatchInd,
+            sizeof(LocAPIBatchingIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiBatchInd failed!");
         return 0;
     }
     // free memory
@@ -1423,19 +1255,11 @@ int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiGfBreach.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGfBreach failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGeofenceBreachIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiGfBreach,
+            sizeof(LocAPIGeofenceBreachIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiGfBreach failed!");
         return 0;
     }
     // free memory
@@ -1475,19 +1299,11 @@ int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocInfoInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocInfoInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationInfoIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiLocInfoInd,
+            sizeof(LocAPILocationInfoIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiLocInfoInd failed!");
         return 0;
     }
     // free memory
@@ -1531,19 +1347,11 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
         }
     }
 
-    string pbStr;
-    if (!pbLocApiEngLocInfo.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiEngLocInfo failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIEngineLocationsInfoIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiEngLocInfo,
+            sizeof(LocAPIEngineLocationsInfoIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiEngLocInfo failed!");
         return 0;
     }
     // free memory
@@ -1553,13 +1361,16 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
 
 // Convert LocAPISatelliteVehicleIndMsg -> PBLocAPISatelliteVehicleIndMsg
 int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPISatelliteVehicleIndMsg pbLocApiSatVehInd;
-
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
+    // sent for every fix, the protobuf objects go on the converter's arena
+    LocationApiPbArena::Lease arena(pLocApiPbMsgConv->getHotMsgArena());
+    PBLocAPIMsgHeader& pLocApiMsgHdr =
+            *google::protobuf::Arena::CreateMessage<PBLocAPIMsgHeader>(arena.get());
+    PBLocAPISatelliteVehicleIndMsg& pbLocApiSatVehInd =
+            *google::protobuf::Arena::CreateMessage<PBLocAPISatelliteVehicleIndMsg>(arena.get());
     // string      mSocketName = 1;
     pLocApiMsgHdr.set_msocketname(mSocketName);
     // PBELocMsgID  msgId = 2;
@@ -1573,7 +1384,6 @@ int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gnssSvNotif) {
         if (pLocApiPbMsgConv->convertGnssSvNotifToPB(gnssSvNotification, gnssSvNotif)) {
             LOC_LOGe("convertGnssSvNotifToPB failed");
-            free(gnssSvNotif);
             return 0;
         }
     } else {
@@ -1581,23 +1391,13 @@ int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiSatVehInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiSatVehInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPISatelliteVehicleIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiSatVehInd,
+            sizeof(LocAPISatelliteVehicleIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiSatVehInd failed!");
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPISatelliteVehicleIndMsg(pbLocApiSatVehInd);
     return protoStr.size();
 }
 
@@ -1633,19 +1433,11 @@ int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiNmeaInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiNmeaInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPINmeaIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiNmeaInd,
+            sizeof(LocAPINmeaIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiNmeaInd failed!");
         return 0;
     }
     // free memory
@@ -1683,19 +1475,11 @@ int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiDataInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiDataInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIDataIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiDataInd,
+            sizeof(LocAPIDataIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiDataInd failed!");
         return 0;
     }
     // free memory
@@ -1705,13 +1489,16 @@ int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
 
 // Convert LocAPIMeasIndMsg -> PBLocAPIMeasIndMsg
 int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIMeasIndMsg pbLocApiMeasInd;
-
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
+    // sent for every fix, the protobuf objects go on the converter's arena
+    LocationApiPbArena::Lease arena(pLocApiPbMsgConv->getHotMsgArena());
+    PBLocAPIMsgHeader& pLocApiMsgHdr =
+            *google::protobuf::Arena::CreateMessage<PBLocAPIMsgHeader>(arena.get());
+    PBLocAPIMeasIndMsg& pbLocApiMeasInd =
+            *google::protobuf::Arena::CreateMessage<PBLocAPIMeasIndMsg>(arena.get());
     // string      mSocketName = 1;
     pLocApiMsgHdr.set_msocketname(mSocketName);
     // PBELocMsgID  msgId = 2;
@@ -1727,7 +1514,6 @@ int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertGnssMeasNotifToPB(gnssMeasurementsNotification,
                 gnssMeasNotif)) {
             LOC_LOGe("convertGnssMeasNotifToPB failed");
-            free(gnssMeasNotif);
             return 0;
         }
     } else {
@@ -1735,23 +1521,13 @@ int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiMeasInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiMeasInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIMeasIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiMeasInd,
+            sizeof(LocAPIMeasIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiMeasInd failed!");
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIMeasIndMsg(pbLocApiMeasInd);
     return protoStr.size();
 }
 
@@ -1776,19 +1552,11 @@ int LocAPIGnssEnergyConsumedIndMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiGnssEnrgyConsmdInd.set_totalgnssenergyconsumedsincefirstboot(
             totalGnssEnergyConsumedSinceFirstBoot);
 
-    string pbStr;
-    if (!pbLocApiGnssEnrgyConsmdInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGnssEnrgyConsmdInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGnssEnergyConsumedIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiGnssEnrgyConsmdInd,
+            sizeof(LocAPIGnssEnergyConsumedIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiGnssEnrgyConsmdInd failed!");
         return 0;
     }
     return protoStr.size();
@@ -1824,19 +1592,11 @@ int LocAPILocationSystemInfoIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocSysInfoInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocSysInfoInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationSystemInfoIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiLocSysInfoInd,
+            sizeof(LocAPILocationSystemInfoIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiLocSysInfoInd failed!");
         return 0;
     }
     // free memory
@@ -1872,20 +1632,11 @@ int LocAPIDcReportIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbMsg failed!");
-        pbMsg.clear_dcreportinfo();
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIDcReportIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbMsg,
+            sizeof(LocAPIDcReportIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbMsg failed!");
         pbMsg.clear_dcreportinfo();
         return 0;
     }
@@ -1918,19 +1669,11 @@ int LocConfigConstrainedTuncReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32   mEnergyBudget = 3;
     pbLocConfConstrTunc.set_menergybudget(mEnergyBudget);
 
-    string pbStr;
-    if (!pbLocConfConstrTunc.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfConstrTunc failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigConstrainedTuncReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfConstrTunc,
+            sizeof(LocConfigConstrainedTuncReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfConstrTunc failed!");
         return 0;
     }
     return protoStr.size();
@@ -1957,19 +1700,11 @@ int LocConfigPositionAssistedClockEstimatorReqMsg::serializeToProtobuf(string& p
     // bool     mEnable = 1;
     pbLocConfPosAsstdClockEst.set_menable(mEnable);
 
-    string pbStr;
-    if (!pbLocConfPosAsstdClockEst.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfPosAsstdClockEst failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigPositionAssistedClockEstimatorReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfPosAsstdClockEst,
+            sizeof(LocConfigPositionAssistedClockEstimatorReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfPosAsstdClockEst failed!");
         return 0;
     }
     return protoStr.size();
@@ -2023,19 +1758,11 @@ int LocConfigSvConstellationReqMsg::serializeToProtobuf(string& protoStr) {
     bool resetToDefault = (0 == mConstellationEnablementConfig.size);
     pbLocConfSvConst.set_mresettodefault(resetToDefault);
 
-    string pbStr;
-    if (!pbLocConfSvConst.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfSvConst failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigSvConstellationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfSvConst,
+            sizeof(LocConfigSvConstellationReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfSvConst failed!");
         return 0;
     }
 
@@ -2076,19 +1803,11 @@ int LocConfigConstellationSecondaryBandReqMsg::serializeToProtobuf(string& proto
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgConstlSecBandReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocCfgConstlSecBandReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigConstellationSecondaryBandReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocCfgConstlSecBandReqMsg,
+            sizeof(LocConfigConstellationSecondaryBandReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocCfgConstlSecBandReqMsg failed!");
         return 0;
     }
     // free memory
@@ -2126,19 +1845,11 @@ int LocConfigAidingDataDeletionReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfAidDataDel.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfAidDataDel failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigAidingDataDeletionReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfAidDataDel,
+            sizeof(LocConfigAidingDataDeletionReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfAidDataDel failed!");
         return 0;
     }
     // free memory
@@ -2177,19 +1888,11 @@ int LocConfigLeverArmReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfLeverArm.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfLeverArm failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigLeverArmReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfLeverArm,
+            sizeof(LocConfigLeverArmReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfLeverArm failed!");
         return 0;
     }
     // free memory
@@ -2219,19 +1922,11 @@ int LocConfigRobustLocationReqMsg::serializeToProtobuf(string& protoStr) {
     // bool mEnableForE911 = 2;
     pbLocConfRobustLoc.set_menablefore911(mEnableForE911);
 
-    string pbStr;
-    if (!pbLocConfRobustLoc.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfRobustLoc failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigRobustLocationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfRobustLoc,
+            sizeof(LocConfigRobustLocationReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfRobustLoc failed!");
         return 0;
     }
     return protoStr.size();
@@ -2257,19 +1952,11 @@ int LocConfigMinGpsWeekReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinGpsWeek = 1;
     pbLocConfMinGpsWeek.set_mmingpsweek(mMinGpsWeek);
 
-    string pbStr;
-    if (!pbLocConfMinGpsWeek.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfMinGpsWeek failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigMinGpsWeekReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfMinGpsWeek,
+            sizeof(LocConfigMinGpsWeekReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfMinGpsWeek failed!");
         return 0;
     }
     return protoStr.size();
@@ -2306,19 +1993,11 @@ int LocConfigDrEngineParamsReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgDrEngParamReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfB2sMntParam failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigDrEngineParamsReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocCfgDrEngParamReq,
+            sizeof(LocConfigDrEngineParamsReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocCfgDrEngParamReq failed!");
         return 0;
     }
     // free memory
@@ -2346,19 +2025,11 @@ int LocConfigMinSvElevationReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinSvElevation = 1;
     pbLocConfMinSvElev.set_mminsvelevation(mMinSvElevation);
 
-    string pbStr;
-    if (!pbLocConfMinSvElev.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfMinSvElev failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigMinSvElevationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfMinSvElev,
+            sizeof(LocConfigMinSvElevationReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfMinSvElev failed!");
         return 0;
     }
     return protoStr.size();
@@ -2388,19 +2059,11 @@ int LocConfigEngineRunStateReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocConfEngineRunState.set_mengstate((::PBLocEngineRunState)
             pLocApiPbMsgConv->getPBEnumForLocEngineRunState(mEngState));
 
-    string pbStr;
-    if (!pbLocConfEngineRunState.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfEngineRunState failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigEngineRunStateReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfEngineRunState,
+            sizeof(LocConfigEngineRunStateReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfEngineRunState failed!");
         return 0;
     }
     return protoStr.size();
@@ -2429,20 +2092,11 @@ int LocConfigUserConsentTerrestrialPositioningReqMsg::serializeToProtobuf(
     // bool userConsent
     pbMsg.set_userconsent(mUserConsent);
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(
-            sizeof(LocConfigUserConsentTerrestrialPositioningReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbMsg,
+            sizeof(LocConfigUserConsentTerrestrialPositioningReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbMsg failed!");
         return 0;
     }
     return protoStr.size();
@@ -2483,20 +2137,11 @@ int LocConfigOutputNmeaTypesReqMsg::serializeToProtobuf(
     pbMsg.set_nmeadatumtype((mNmeaDatumType == GEODETIC_TYPE_PZ_90) ?
                             PB_GEODETIC_TYPE_PZ_90 : PB_GEODETIC_TYPE_WGS_84);
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(
-            sizeof(LocConfigOutputNmeaTypesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbMsg,
+            sizeof(LocConfigOutputNmeaTypesReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbMsg failed!");
         return 0;
     }
     return protoStr.size();
@@ -2541,19 +2186,11 @@ int LocConfigEngineIntegrityRiskReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32_t integrityrisk = 2;
     pbLocConfMsg.set_integrityrisk(mIntegrityRisk);
 
-    string pbStr;
-    if (!pbLocConfMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on PBLocConfigEngineIntegrityRiskReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigEngineIntegrityRiskReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfMsg,
+            sizeof(LocConfigEngineIntegrityRiskReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfMsg failed!");
         return 0;
     }
     return protoStr.size();
@@ -2604,19 +2241,11 @@ int LocConfigXtraReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on PBLocConfigEngineIntegrityRiskReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigXtraReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfMsg,
+            sizeof(LocConfigXtraReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfMsg failed!");
         return 0;
     }
 
@@ -2697,19 +2326,11 @@ int LocConfigGetXtraStatusRespMsg::serializeToProtobuf(string& protoStr) {
 
     }
 
-    string pbStr;
-    if (!pbLocMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetXtraStatusRespMsg));
-        LOC_LOGe("enter 7");
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocMsg,
+            sizeof(LocConfigGetXtraStatusRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocMsg failed!");
         return 0;
     }
 
@@ -2837,19 +2458,11 @@ int LocConfigGetRobustLocationConfigRespMsg::serializeToProtobuf(string& protoSt
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfGetRobustLocConfg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetRobustLocConfg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetRobustLocationConfigRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfGetRobustLocConfg,
+            sizeof(LocConfigGetRobustLocationConfigRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfGetRobustLocConfg failed!");
         return 0;
     }
     // free memory
@@ -2903,19 +2516,11 @@ int LocConfigGetMinGpsWeekRespMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinGpsWeek = 1;
     pbLocConfGetMinGpsWeekRsp.set_mmingpsweek(mMinGpsWeek);
 
-    string pbStr;
-    if (!pbLocConfGetMinGpsWeekRsp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetMinGpsWeekRsp failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinGpsWeekRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfGetMinGpsWeekRsp,
+            sizeof(LocConfigGetMinGpsWeekRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfGetMinGpsWeekRsp failed!");
         return 0;
     }
     return protoStr.size();
@@ -2967,19 +2572,11 @@ int LocConfigGetMinSvElevationRespMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinSvElevation = 1;
     pbLocConfGetMinSvElev.set_mminsvelevation(mMinSvElevation);
 
-    string pbStr;
-    if (!pbLocConfGetMinSvElev.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetMinSvElev failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinSvElevationRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocConfGetMinSvElev,
+            sizeof(LocConfigGetMinSvElevationRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocConfGetMinSvElev failed!");
         return 0;
     }
     return protoStr.size();
@@ -3045,19 +2642,11 @@ int LocConfigGetConstellationSecondaryBandConfigRespMsg::serializeToProtobuf(str
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgGetConstlSecBandRespMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocCfgGetConstlSecBandRespMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetConstellationSecondaryBandConfigRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocCfgGetConstlSecBandRespMsg,
+            sizeof(LocConfigGetConstellationSecondaryBandConfigRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocCfgGetConstlSecBandRespMsg failed!");
         return 0;
     }
     // free memory
@@ -3123,17 +2712,11 @@ int LocAPIGetDebugRespMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetDebugRespMsg));
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbMsg,
+            sizeof(LocAPIGetDebugRespMsg), protoStr)) {
+        LOC_LOGe("encode of pbMsg failed!");
         return 0;
     }
 
@@ -3171,18 +2754,12 @@ int LocIntApiInjectLocationMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
+    // bytes       payload = 4;
+    // uint32   payloadSize = 5;
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbMsg, sizeof(LocIntApiInjectLocationMsg),
+            protoStr)) {
+        LOC_LOGe("encode of pbMsg failed!");
         pbMsg.clear_location();
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
-
-    pLocApiMsgHdr.set_payload(pbStr);
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocIntApiInjectLocationMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
         return 0;
     }
 
@@ -3247,17 +2824,11 @@ int LocAPIAntennaInfoMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIAntennaInfoMsg));
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbMsg,
+            sizeof(LocAPIAntennaInfoMsg), protoStr)) {
+        LOC_LOGe("encode of pbMsg failed!");
         return 0;
     }
     // free memory
@@ -3290,19 +2861,11 @@ int LocAPIPingTestReqMsg::serializeToProtobuf(string& protoStr) {
         pbLocApiPingTest.add_data(data[i]);
     }
 
-    string pbStr;
-    if (!pbLocApiPingTest.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPingTest failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPingTestReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiPingTest,
+            sizeof(LocAPIPingTestReqMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiPingTest failed!");
         return 0;
     }
     // free memory
@@ -3335,19 +2898,11 @@ int LocAPIPingTestIndMsg::serializeToProtobuf(string& protoStr) {
         pbLocApiPingTestIndMsg.add_data(data[i]);
     }
 
-    string pbStr;
-    if (!pbLocApiPingTestIndMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPingTestIndMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPingTestIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (!LocationApiPbEncoder::encode(pLocApiMsgHdr, pbLocApiPingTestIndMsg,
+            sizeof(LocAPIPingTestIndMsg), protoStr)) {
+        LOC_LOGe("encode of pbLocApiPingTestIndMsg failed!");
         return 0;
     }
     // free memory
@@ -3481,7 +3036,7 @@ LocAPIUpdateTrackingOptionsReqMsg::LocAPIUpdateTrackingOptionsReqMsg(const char*
 LocAPIStartBatchingReqMsg::LocAPIStartBatchingReqMsg(const char* name,
             const PBLocAPIStartBatchingReqMsg &pbStartBatchReqMsg,
             const LocationApiPbMsgConv *pbMsgConv):
-        LocAPIMsgHeader(name, E_LOCAPI_START_BATCHING_MSG_ID, pbMsgConv) {
+        LocAPIMsgHeader(name, E_LOCAPI_START_BATCHING_MSG_ID, pbMsgConv), useBatchStore(false) {
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return;
@@ -3493,6 +3048,8 @@ LocAPIStartBatchingReqMsg::LocAPIStartBatchingReqMsg(const char* name,
     distanceInMeters = pbStartBatchReqMsg.distanceinmeters();
     // PBBatchingMode batchingMode = 3;
     batchingMode = pLocApiPbMsgConv->getEnumForPBBatchingMode(pbStartBatchReqMsg.batchingmode());
+    // bool useBatchStore = 4;
+    useBatchStore = pbStartBatchReqMsg.usebatchstore();
     LOC_LOGv("LocApiPB: Interval: %d, Distance(m): %d, Batch mode: %d", intervalInMs,
             distanceInMeters, batchingMode);
 }
@@ -3501,7 +3058,8 @@ LocAPIStartBatchingReqMsg::LocAPIStartBatchingReqMsg(const char* name,
 LocAPIUpdateBatchingOptionsReqMsg::LocAPIUpdateBatchingOptionsReqMsg(const char* name,
             const PBLocAPIUpdateBatchingOptionsReqMsg &pbUpdateBatchOptiReqMsg,
             const LocationApiPbMsgConv *pbMsgConv):
-        LocAPIMsgHeader(name, E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID, pbMsgConv) {
+        LocAPIMsgHeader(name, E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID, pbMsgConv),
+        useBatchStore(false) {
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return;
@@ -3514,6 +3072,8 @@ LocAPIUpdateBatchingOptionsReqMsg::LocAPIUpdateBatchingOptionsReqMsg(const char*
     // PBBatchingMode batchingMode = 3;
     batchingMode = pLocApiPbMsgConv->getEnumForPBBatchingMode(
             pbUpdateBatchOptiReqMsg.batchingmode());
+    // bool useBatchStore = 4;
+    useBatchStore = pbUpdateBatchOptiReqMsg.usebatchstore();
     LOC_LOGv("LocApiPB: Interval: %d, Distance(m): %d, Batch mode: %d", intervalInMs,
             distanceInMeters, batchingMode);
 }
@@ -3618,7 +3178,7 @@ LocAPILocationIndMsg::LocAPILocationIndMsg(const char* name,
 LocAPIBatchingIndMsg::LocAPIBatchingIndMsg(const char* name,
             const PBLocAPIBatchingIndMsg &pbLocApiBatchingIndMsg,
             const LocationApiPbMsgConv *pbMsgConv):
-        LocAPIMsgHeader(name, E_LOCAPI_BATCHING_MSG_ID, pbMsgConv) {
+        LocAPIMsgHeader(name, E_LOCAPI_BATCHING_MSG_ID, pbMsgConv), batchStoreEndSeq(0) {
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return;
@@ -3630,6 +3190,8 @@ LocAPIBatchingIndMsg::LocAPIBatchingIndMsg(const char* name,
     // PBBatchingMode batchingMode = 2;
     batchingMode = pLocApiPbMsgConv->getEnumForPBBatchingMode(
             pbLocApiBatchingIndMsg.batchingmode());
+    // uint64 batchStoreEndSeq = 3;
+    batchStoreEndSeq = pbLocApiBatchingIndMsg.batchstoreendseq();
 }
 
 // Decode PBLocAPIGeofenceBreachIndMsg -> LocAPIGeofenceBreachIndMsg
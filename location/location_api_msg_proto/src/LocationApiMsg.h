@@ -686,16 +686,19 @@ struct LocAPIStartBatchingReqMsg: LocAPIMsgHeader
     uint32_t intervalInMs;
     uint32_t distanceInMeters;
     BatchingMode batchingMode;
+    bool useBatchStore;
 
     inline LocAPIStartBatchingReqMsg(const char* name,
                                      uint32_t minInterval,
                                      uint32_t minDistance,
                                      BatchingMode batchMode,
-                                     const LocationApiPbMsgConv *pbMsgConv):
+                                     const LocationApiPbMsgConv *pbMsgConv,
+                                     bool batchStore = false):
         LocAPIMsgHeader(name, E_LOCAPI_START_BATCHING_MSG_ID, pbMsgConv),
         intervalInMs(minInterval),
         distanceInMeters(minDistance),
-        batchingMode(batchMode) { }
+        batchingMode(batchMode),
+        useBatchStore(batchStore) { }
     LocAPIStartBatchingReqMsg(const char* name,
             const PBLocAPIStartBatchingReqMsg &pbStartBatchReqMsg,
             const LocationApiPbMsgConv *pbMsgConv);
@@ -718,16 +721,19 @@ struct LocAPIUpdateBatchingOptionsReqMsg: LocAPIMsgHeader
     uint32_t intervalInMs;
     uint32_t distanceInMeters;
     BatchingMode batchingMode;
+    bool useBatchStore;
 
     inline LocAPIUpdateBatchingOptionsReqMsg(const char* name,
                                              uint32_t sessionInterval,
                                              uint32_t sessionDistance,
                                              BatchingMode batchMode,
-                                             const LocationApiPbMsgConv *pbMsgConv):
+                                             const LocationApiPbMsgConv *pbMsgConv,
+                                             bool batchStore = false):
         LocAPIMsgHeader(name, E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID, pbMsgConv),
         intervalInMs(sessionInterval),
         distanceInMeters(sessionDistance),
-        batchingMode(batchMode) { }
+        batchingMode(batchMode),
+        useBatchStore(batchStore) { }
     LocAPIUpdateBatchingOptionsReqMsg(const char* name,
             const PBLocAPIUpdateBatchingOptionsReqMsg &pbUpdateBatchOptiReqMsg,
             const LocationApiPbMsgConv *pbMsgConv);
@@ -935,13 +941,16 @@ struct LocAPIBatchingIndMsg: LocAPIMsgHeader
 {
     LocAPIBatchNotification batchNotification;
     BatchingMode batchingMode;
+    // fixes are in the client batch store up to this sequence number, 0 if
+    // they are in batchNotification
+    uint64_t batchStoreEndSeq;
 
     inline LocAPIBatchingIndMsg(const char* name, const LocationApiPbMsgConv *pbMsgConv) :
-        LocAPIMsgHeader(name, E_LOCAPI_BATCHING_MSG_ID, pbMsgConv) { }
+        LocAPIMsgHeader(name, E_LOCAPI_BATCHING_MSG_ID, pbMsgConv), batchStoreEndSeq(0) { }
     inline LocAPIBatchingIndMsg(const char* name, LocAPIBatchNotification& batchNotif,
             BatchingMode mode, const LocationApiPbMsgConv *pbMsgConv) :
         LocAPIMsgHeader(name, E_LOCAPI_BATCHING_MSG_ID, pbMsgConv), batchingMode(mode),
-        batchNotification(batchNotif) { }
+        batchNotification(batchNotif), batchStoreEndSeq(0) { }
     LocAPIBatchingIndMsg(const char* name, const PBLocAPIBatchingIndMsg &pbLocApiBatchingIndMsg,
             const LocationApiPbMsgConv *pbMsgConv);
 
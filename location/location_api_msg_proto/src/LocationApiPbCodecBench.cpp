@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Codec benchmark for the LocationApiMsg envelope. Encodes location, SV and
+measurements indications the way the serializeToProtobuf() functions did,
+payload serialized to a string which is then copied into the header and the
+header serialized again, and with LocationApiPbEncoder on a LocationApiPbArena
+into a reused buffer. Checks that both produce the same bytes and reports
+bytes/sec and heap allocations per message.
+
+usage: location_api_msg_codec_bench [iterations]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include "LocationApiPbEncoder.h"
+
+#define DEFAULT_ITERATIONS  20000
+#define NUM_SVS             176     // GNSS_SV_MAX
+#define NUM_MEASUREMENTS    64
+
+using google::protobuf::Arena;
+
+static std::atomic<uint64_t> sAllocCount(0);
+
+void* operator new(size_t size) {
+    sAllocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void fillHeader(PBLocAPIMsgHeader& hdr, PBELocMsgID msgId) {
+    hdr.set_msocketname("/dev/socket/location/hal_daemon");
+    hdr.set_msgid(msgId);
+    hdr.set_msgversion(1);
+}
+
+static void fillLocation(PBLocAPILocationIndMsg& msg, int it) {
+    PBLocation* location = msg.mutable_locationnotification();
+    location->set_flags(0x1ff);
+    location->set_timestamp(1660000000000ULL + it * 100);
+    location->set_latitude(37.4219999 + it * 1e-7);
+    location->set_longitude(-122.0840575 - it * 1e-7);
+    location->set_altitude(12.5);
+    location->set_speed(1.25f);
+    location->set_bearing(93.5f);
+    location->set_horizontalaccuracy(3.2f);
+    location->set_verticalaccuracy(4.8f);
+    location->set_speedaccuracy(0.4f);
+    location->set_bearingaccuracy(5.0f);
+    location->set_techmask(0x1);
+}
+
+static void fillSv(PBLocAPISatelliteVehicleIndMsg& msg, int it) {
+    PBLocApiGnssSvNotification* notif = msg.mutable_gnsssvnotification();
+    notif->set_gnsssignaltypemaskvalid(true);
+    for (int i = 0; i < NUM_SVS; i++) {
+        PBLocApiGnssSv* sv = notif->add_gnsssvs();
+        sv->set_svid(i + 1);
+        sv->set_type((PBLocApiGnss_LocSvSystemEnumType)(i % 6 + 1));
+        sv->set_cn0dbhz(20.0f + (float)((it + i) % 300) / 10.0f);
+        sv->set_elevation((float)(i * 7 % 90));
+        sv->set_azimuth((float)((it + i * 13) % 360));
+        sv->set_gnsssvoptionsmask((it ^ i) & 0x7);
+        sv->set_carrierfrequencyhz(1575420000.0f);
+        sv->set_gnsssignaltypemask(1 << (i % 12));
+        sv->set_basebandcarriertonoisedbhz(35.5 + i % 10);
+    }
+}
+
+static void fillMeas(PBLocAPIMeasIndMsg& msg, int it) {
+    PBGnssMeasurementsNotification* notif = msg.mutable_gnssmeasurementsnotification();
+    for (int i = 0; i < NUM_MEASUREMENTS; i++) {
+        PBGnssMeasurementsData* data = notif->add_measurements();
+        data->set_flags(0x3ffff);
+        data->set_svid(i + 1);
+        data->set_svtype((PBLocApiGnss_LocSvSystemEnumType)(i % 6 + 1));
+        data->set_statemask(0x3fff);
+        data->set_receivedsvtimens(123456789012LL + it * 1000 + i);
+        data->set_receivedsvtimeuncertaintyns(15);
+        data->set_carriertonoisedbhz(38.25 + i % 10);
+        data->set_pseudorangeratemps(-512.5 + i);
+        data->set_pseudorangerateuncertaintymps(0.05);
+        data->set_adrstatemask(1);
+        data->set_adrmeters(20000000.0 + it);
+        data->set_adruncertaintymeters(0.01);
+        data->set_carrierfrequencyhz(1575420000.0f);
+        data->set_carrierphase(0.25);
+        data->set_agcleveldb(1.5);
+        data->set_gnsssignaltype(1 << (i % 12));
+    }
+    PBGnssMeasurementsClock* clock = notif->mutable_clock();
+    clock->set_flags(0x7f);
+    clock->set_leapsecond(18);
+    clock->set_timens(1660000000000000000LL + it * 1000000LL);
+    clock->set_fullbiasns(-1234567890123LL);
+    clock->set_biasns(0.5);
+    clock->set_driftnsps(12.5);
+}
+
+// what serializeToProtobuf() did before LocationApiPbEncoder
+template <typename T>
+static bool encodeTwoPass(PBELocMsgID msgId, void (*fill)(T&, int), int it, std::string& out) {
+    PBLocAPIMsgHeader hdr;
+    T msg;
+    fillHeader(hdr, msgId);
+    fill(msg, it);
+    std::string pbStr;
+    if (!msg.SerializeToString(&pbStr)) {
+        return false;
+    }
+    hdr.set_payload(pbStr);
+    hdr.set_payloadsize(sizeof(T));
+    return hdr.SerializeToString(&out);
+}
+
+template <typename T>
+static bool encodeSinglePass(LocationApiPbArena& arena, PBELocMsgID msgId,
+        void (*fill)(T&, int), int it, std::string& out) {
+    LocationApiPbArena::Lease lease(arena);
+    PBLocAPIMsgHeader& hdr = *Arena::CreateMessage<PBLocAPIMsgHeader>(lease.get());
+    T& msg = *Arena::CreateMessage<T>(lease.get());
+    fillHeader(hdr, msgId);
+    fill(msg, it);
+    return LocationApiPbEncoder::encode(hdr, msg, sizeof(T), out);
+}
+
+template <typename T>
+static int bench(const char* name, PBELocMsgID msgId, void (*fill)(T&, int), int iterations) {
+    LocationApiPbArena arena;
+    std::string ref, out;
+    uint64_t bytes = 0, start, allocs, twoPassNs, singlePassNs, twoPassAllocs, singlePassAllocs;
+
+    // same bytes, and the receiver still gets the payload back
+    for (int it = 0; it < 3; it++) {
+        PBLocAPIMsgHeader hdr;
+        T msg;
+        if (!encodeTwoPass(msgId, fill, it, ref) ||
+                !encodeSinglePass(arena, msgId, fill, it, out) || ref != out ||
+                !hdr.ParseFromString(out) || !msg.ParseFromString(hdr.payload()) ||
+                hdr.payloadsize() != sizeof(T)) {
+            printf("  FAIL: %s encodings differ\n", name);
+            return -1;
+        }
+    }
+
+    start = nowNs();
+    allocs = sAllocCount.load();
+    for (int it = 0; it < iterations; it++) {
+        std::string msgOut;
+        encodeTwoPass(msgId, fill, it, msgOut);
+        bytes += msgOut.size();
+    }
+    twoPassAllocs = sAllocCount.load() - allocs;
+    twoPassNs = nowNs() - start;
+
+    start = nowNs();
+    allocs = sAllocCount.load();
+    for (int it = 0; it < iterations; it++) {
+        encodeSinglePass(arena, msgId, fill, it, out);
+    }
+    singlePassAllocs = sAllocCount.load() - allocs;
+    singlePassNs = nowNs() - start;
+
+    printf("%-9s %6zu bytes  two pass %7.1f MB/s %6.1f allocs/msg"
+           "  single pass %7.1f MB/s %6.1f allocs/msg\n",
+           name, out.size(),
+           (double)bytes * 1000 / twoPassNs, (double)twoPassAllocs / iterations,
+           (double)bytes * 1000 / singlePassNs, (double)singlePassAllocs / iterations);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    int ret = 0;
+
+    if (iterations <= 0) {
+        printf("usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d messages each, bytes/sec includes filling in the protobuf objects\n",
+           iterations);
+    ret |= bench<PBLocAPILocationIndMsg>("location", PB_E_LOCAPI_LOCATION_MSG_ID,
+                                         fillLocation, iterations);
+    ret |= bench<PBLocAPISatelliteVehicleIndMsg>("sv", PB_E_LOCAPI_SATELLITE_VEHICLE_MSG_ID,
+                                                 fillSv, iterations / 10);
+    ret |= bench<PBLocAPIMeasIndMsg>("meas", PB_E_LOCAPI_MEAS_MSG_ID,
+                                     fillMeas, iterations / 10);
+
+    printf("%s\n", ret ? "FAILED" : "PASSED");
+    return ret ? 1 : 0;
+}
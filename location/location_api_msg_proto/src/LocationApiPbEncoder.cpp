@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <limits.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include "LocationApiPbEncoder.h"
+
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+// field numbers of PBLocAPIMsgHeader
+#define HDR_FIELD_SOCKET_NAME   1
+#define HDR_FIELD_MSG_ID        2
+#define HDR_FIELD_MSG_VERSION   3
+#define HDR_FIELD_PAYLOAD       4
+#define HDR_FIELD_PAYLOAD_SIZE  5
+
+bool LocationApiPbEncoder::encode(const PBLocAPIMsgHeader &header,
+        const google::protobuf::MessageLite &payload, uint32_t payloadSize,
+        std::string &out) {
+    // fields are written in field number order and, as proto3 does, only
+    // when they do not have their default value
+    const std::string &socketName = header.msocketname();
+    int msgId = header.msgid();
+    uint32_t msgVersion = header.msgversion();
+    size_t payloadLen = payload.ByteSizeLong();
+    size_t len = 0;
+
+    if (payloadLen > INT_MAX) {
+        return false;
+    }
+    if (!socketName.empty()) {
+        len += 1 + WireFormatLite::StringSize(socketName);
+    }
+    if (0 != msgId) {
+        len += 1 + WireFormatLite::EnumSize(msgId);
+    }
+    if (0 != msgVersion) {
+        len += 1 + WireFormatLite::UInt32Size(msgVersion);
+    }
+    if (0 != payloadLen) {
+        len += 1 + CodedOutputStream::VarintSize32(payloadLen) + payloadLen;
+    }
+    if (0 != payloadSize) {
+        len += 1 + WireFormatLite::UInt32Size(payloadSize);
+    }
+
+    out.resize(len);
+    uint8_t *start = reinterpret_cast<uint8_t*>(&out[0]);
+    uint8_t *target = start;
+
+    if (!socketName.empty()) {
+        target = WireFormatLite::WriteStringToArray(HDR_FIELD_SOCKET_NAME, socketName, target);
+    }
+    if (0 != msgId) {
+        target = WireFormatLite::WriteEnumToArray(HDR_FIELD_MSG_ID, msgId, target);
+    }
+    if (0 != msgVersion) {
+        target = WireFormatLite::WriteUInt32ToArray(HDR_FIELD_MSG_VERSION, msgVersion, target);
+    }
+    if (0 != payloadLen) {
+        target = WireFormatLite::WriteTagToArray(HDR_FIELD_PAYLOAD,
+                WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+        target = CodedOutputStream::WriteVarint32ToArray(payloadLen, target);
+        // sizes were cached by ByteSizeLong() above
+        target = payload.SerializeWithCachedSizesToArray(target);
+    }
+    if (0 != payloadSize) {
+        target = WireFormatLite::WriteUInt32ToArray(HDR_FIELD_PAYLOAD_SIZE, payloadSize, target);
+    }
+    return (size_t)(target - start) == len;
+}
+
+google::protobuf::ArenaOptions LocationApiPbArena::makeOptions(char *initialBlock) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = initialBlock;
+    options.initial_block_size = INITIAL_BLOCK_SIZE;
+    return options;
+}
+
+LocationApiPbArena::LocationApiPbArena() :
+        mInitialBlock(new char[INITIAL_BLOCK_SIZE]),
+        mArena(makeOptions(mInitialBlock.get())) {
+}
+
+LocationApiPbArena::Lease::Lease(LocationApiPbArena &arena) :
+        mOwner(arena), mArena(&arena.mArena), mLocked(arena.mMutex.try_lock()) {
+    if (!mLocked) {
+        mPrivateArena.reset(new google::protobuf::Arena());
+        mArena = mPrivateArena.get();
+    }
+}
+
+LocationApiPbArena::Lease::~Lease() {
+    if (mLocked) {
+        // keeps the initial block for the next message, frees anything beyond it
+        mOwner.mArena.Reset();
+        mOwner.mMutex.unlock();
+    }
+}
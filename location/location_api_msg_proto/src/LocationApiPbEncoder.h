@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LOCATION_API_PB_ENCODER_H
+#define LOCATION_API_PB_ENCODER_H
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <google/protobuf/arena.h>
+#include "LocationApiMsg.pb.h"
+
+// LocationApiPbEncoder - writes a PBLocAPIMsgHeader envelope with its payload
+// message embedded in one pass, instead of serializing the payload to a string,
+// copying that into the header and serializing the header again. The output
+// is byte for byte what PBLocAPIMsgHeader::SerializeToString() produces, so
+// receivers parse it as before. Only the size of out is touched, a string kept
+// by the caller is reused as the output buffer without reallocating.
+class LocationApiPbEncoder {
+public:
+    // header has fields mSocketName, msgId and msgVersion set, payload and
+    // payloadSize are taken from the arguments. Returns false if the message
+    // could not be encoded.
+    static bool encode(const PBLocAPIMsgHeader &header,
+            const google::protobuf::MessageLite &payload, uint32_t payloadSize,
+            std::string &out);
+};
+
+// LocationApiPbArena - protobuf arena with a preallocated first block, for the
+// protobuf objects of the messages sent for every fix (location, SV and
+// measurements) so that converting them does not allocate. One is kept by
+// each LocationApiPbMsgConv, if it is in use when another message is being
+// converted on a different thread, that message gets an arena of its own.
+class LocationApiPbArena {
+public:
+    static const size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+    LocationApiPbArena();
+
+    // Scoped use of the arena, the protobuf objects created on get() are freed
+    // when the lease goes out of scope.
+    class Lease {
+    public:
+        explicit Lease(LocationApiPbArena &arena);
+        ~Lease();
+        inline google::protobuf::Arena* get() { return mArena; }
+    private:
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        LocationApiPbArena &mOwner;
+        std::unique_ptr<google::protobuf::Arena> mPrivateArena;
+        google::protobuf::Arena *mArena;
+        bool mLocked;
+    };
+
+private:
+    LocationApiPbArena(const LocationApiPbArena&) = delete;
+    LocationApiPbArena& operator=(const LocationApiPbArena&) = delete;
+
+    static google::protobuf::ArenaOptions makeOptions(char *initialBlock);
+
+    std::unique_ptr<char[]> mInitialBlock;
+    std::mutex mMutex;
+    google::protobuf::Arena mArena;
+};
+
+#endif /* LOCATION_API_PB_ENCODER_H */
@@ -4159,7 +4159,6 @@ int LocationApiPbMsgConv::convertGnssMeasNotifToPB(
         if (nullptr != gnssMeasData) {
             if (convertGnssMeasDataToPB(gnssMeasNotif.measurements[i], gnssMeasData)) {
                 LOC_LOGe("convertGnssMeasDataToPB failed");
-                free(gnssMeasData);
                 return 1;
             }
         } else {
@@ -4173,7 +4172,6 @@ int LocationApiPbMsgConv::convertGnssMeasNotifToPB(
     if (nullptr != gnssMeasClock) {
         if (convertGnssMeasClockToPB(gnssMeasNotif.clock, gnssMeasClock)) {
             LOC_LOGe("convertGnssMeasClockToPB failed");
-            free(gnssMeasClock);
             return 1;
         }
     } else {
@@ -4246,7 +4244,6 @@ int LocationApiPbMsgConv::convertGnssSvNotifToPB(const GnssSvNotification &gnssS
         if (nullptr != gnssSv) {
             if (convertGnssSvToPB(gnssSvNotif.gnssSvs[i], gnssSv)) {
                 LOC_LOGe("convertGnssSvToPB failed");
-                free(gnssSv);
                 return 1;
             }
         } else {
@@ -66,6 +66,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define LOCATION_API_PBMSGCONV_H
 
 #include <LocationApiMsg.h>
+#include <LocationApiPbEncoder.h>
 
 using namespace std;
 using namespace loc_util;
@@ -81,6 +82,9 @@ public:
     LocationApiPbMsgConv();
     virtual ~LocationApiPbMsgConv() {}
 
+    // arena for the messages sent for every fix, see LocationApiPbArena
+    inline LocationApiPbArena& getHotMsgArena() const { return mHotMsgArena; }
+
     // STRUCTURE CONVERSION
     // ********************
     // **** helper function for structure conversion to protobuf format
@@ -618,6 +622,7 @@ public:
 private:
     bool mPbDebugLogEnabled;
     bool mPbVerboseLogEnabled;
+    mutable LocationApiPbArena mHotMsgArena;
 
     // RIGID TO PROTOBUF FORMAT
     // ************************
@@ -73,6 +73,24 @@ shared_ptr<LocIpcSender> LocHalDaemonClientHandler::createSender(const string so
     return sockNode.createSender();
 }
 
+LocHalDaemonSendQueue::SendFunc LocHalDaemonClientHandler::createSendFunc(
+        shared_ptr<LocIpcSender> sender) {
+    // the sender is held by the send queue thread, which may still be in
+    // LocIpc::send() after this handler is gone
+    return [sender](const uint8_t* data, size_t length) {
+        return (nullptr != sender) && LocIpc::send(*sender, data, length);
+    };
+}
+
+LocHalDaemonSendQueue::PurgeFunc LocHalDaemonClientHandler::createPurgeFunc(
+        LocationApiService* service, const string& clientname, shared_ptr<LocIpcSender> sender) {
+    // called from the send queue thread or from a callback, so only post the
+    // purge, the client is looked up again when it is processed
+    return [service, clientname, sender]() {
+        service->purgeClient(clientname, sender);
+    };
+}
+
 static GeofenceBreachTypeMask parseClientGeofenceBreachType(GeofenceBreachType type);
 
 /******************************************************************************
@@ -315,8 +333,10 @@ void LocHalDaemonClientHandler::updateTrackingOptions(LocationOptions & locOptio
 }
 
 uint32_t LocHalDaemonClientHandler::startBatching(uint32_t minInterval, uint32_t minDistance,
-        BatchingMode batchMode) {
+        BatchingMode batchMode, bool useBatchStore) {
     if (mBatchingId == 0 && mLocationApi) {
+        setBatchStore(useBatchStore);
+
         // update option
         LocationOptions locOption = {};
         locOption.size = sizeof(locOption);
@@ -338,11 +358,16 @@ void LocHalDaemonClientHandler::stopBatching() {
         mLocationApi->stopBatching(mBatchingId);
         mBatchingId = 0;
     }
+    mBatchStore.reset();
 }
 
 void LocHalDaemonClientHandler::updateBatchingOptions(uint32_t minInterval, uint32_t minDistance,
-        BatchingMode batchMode) {
+        BatchingMode batchMode, bool useBatchStore) {
     if (mBatchingId != 0 && mLocationApi) {
+        if (useBatchStore != (nullptr != mBatchStore)) {
+            setBatchStore(useBatchStore);
+        }
+
         // update option
         LocationOptions locOption = {};
         locOption.size = sizeof(locOption);
@@ -356,6 +381,20 @@ void LocHalDaemonClientHandler::updateBatchingOptions(uint32_t minInterval, uint
         mLocationApi->updateBatchingOptions(mBatchingId, mBatchOptions);
     }
 }
+
+void LocHalDaemonClientHandler::setBatchStore(bool enable) {
+    mBatchStore.reset();
+    if (!enable) {
+        return;
+    }
+    if (mName.compare(0, sizeof(SOCKET_LOC_CLIENT_DIR)-1, SOCKET_LOC_CLIENT_DIR) != 0) {
+        LOC_LOGw("no batch store for client %s", mName.c_str());
+        return;
+    }
+    // created anew for every session, the client maps it again on the response
+    mBatchStore.reset(LocationApiBatchStore::create(
+            LocationApiBatchStore::getPath(mName), GID_LOCCLIENT));
+}
 void LocHalDaemonClientHandler::setGeofenceIds(size_t count, uint32_t* clientIds,
         uint32_t* sessionIds) {
     for (int i=0; i<count; ++i) {
@@ -467,8 +506,11 @@ void LocHalDaemonClientHandler::cleanup() {
     // already holds the lock
 
     // set the ptr to null to prevent further sending out message to the
-    // remote client that is no longer reachable
+    // remote client that is no longer reachable, a send that is blocked on
+    // the client is not waited for
+    mSendQueue.stop();
     mIpcSender = nullptr;
+    mBatchStore.reset();
 
     if (0 != remove(mName.c_str())) {
         LOC_LOGw("<-- failed to remove file %s error %s", mName.c_str(), strerror(errno));
@@ -821,10 +863,13 @@ void LocHalDaemonClientHandler::onTrackingCb(Location location) {
     if ((nullptr != mIpcSender) &&
         (mSubscriptionMask & (E_LOC_CB_TRACKING_BIT | E_LOC_CB_SIMPLE_LOCATION_INFO_BIT))) {
         // broadcast
-        string pbStr;
-        LocAPILocationIndMsg msg(SERVICE_NAME, location, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_LOCATION_MSG_ID, location, [this, &location](string& pbStr) {
+            LocAPILocationIndMsg msg(SERVICE_NAME, location, &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(pbStr);
+        });
+        if (nullptr != payload) {
+            bool rc = sendIndication(payload, E_LOCAPI_LOCATION_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
@@ -851,8 +896,14 @@ void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
         LOC_LOGd("Batch count: %ul", (uint32_t)count);
         msg.batchNotification.status = BATCHING_STATUS_POSITION_AVAILABE;
         msg.batchingMode = batchOptions.batchingMode;
-        for (int i = 0; i < count; i++) {
-            msg.batchNotification.location.push_back(location[i]);
+        if (nullptr != mBatchStore) {
+            // only the end of the store is sent, the client reads the fixes from there
+            msg.batchStoreEndSeq = mBatchStore->append(location, count);
+        }
+        if (0 == msg.batchStoreEndSeq) {
+            for (int i = 0; i < count; i++) {
+                msg.batchNotification.location.push_back(location[i]);
+            }
         }
 
         string pbStr;
@@ -942,10 +993,14 @@ void LocHalDaemonClientHandler::onGnssLocationInfoCb(GnssLocationInfoNotificatio
 
     if ((nullptr != mIpcSender) &&
         (mSubscriptionMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT)) {
-        string pbStr;
-        LocAPILocationInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_LOCATION_INFO_MSG_ID, notification,
+                [this, &notification](string& pbStr) {
+            LocAPILocationInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(pbStr);
+        });
+        if (nullptr != payload) {
+            bool rc = sendIndication(payload, E_LOCAPI_LOCATION_INFO_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
@@ -1021,10 +1076,15 @@ void LocHalDaemonClientHandler::onGnssSvCb(GnssSvNotification notification) {
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_GNSS_SV_BIT)) {
         // broadcast
-        string pbStr;
-        LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_SATELLITE_VEHICLE_MSG_ID, notification,
+                [this, &notification](string& pbStr) {
+            LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, notification,
+                                             &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(pbStr);
+        });
+        if (nullptr != payload) {
+            bool rc = sendIndication(payload, E_LOCAPI_SATELLITE_VEHICLE_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
@@ -1049,15 +1109,21 @@ void LocHalDaemonClientHandler::onGnssNmeaCb(GnssNmeaNotification notification)
                 notification.timestamp,
                 notification.length,
                 notification.nmea);
-        // serialize nmea string into ipc message payload
+        // serialize nmea string into ipc message payload, keyed by the
+        // timestamp and sentence as the notification only points to it
         string nmeaStr(notification.nmea, notification.length);
-        LocAPINmeaIndMsg msg(SERVICE_NAME, &mService->mPbufMsgConv);
-        msg.gnssNmeaNotification.timestamp = notification.timestamp;
-        msg.gnssNmeaNotification.nmea = nmeaStr;
-
-        string pbStr;
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), E_LOCAPI_NMEA_MSG_ID);
+        string key(reinterpret_cast<const char*>(&notification.timestamp),
+                   sizeof(notification.timestamp));
+        key.append(nmeaStr);
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_NMEA_MSG_ID, key, [this, &notification, &nmeaStr](string& pbStr) {
+            LocAPINmeaIndMsg msg(SERVICE_NAME, &mService->mPbufMsgConv);
+            msg.gnssNmeaNotification.timestamp = notification.timestamp;
+            msg.gnssNmeaNotification.nmea = nmeaStr;
+            return msg.serializeToProtobuf(pbStr);
+        });
+        if (nullptr != payload) {
+            bool rc = sendIndication(payload, E_LOCAPI_NMEA_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
@@ -1088,11 +1154,14 @@ void LocHalDaemonClientHandler::onGnssDataCb(GnssDataNotification notification)
             }
         }
 
-        string pbStr;
-        LocAPIDataIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_DATA_MSG_ID, notification, [this, &notification](string& pbStr) {
+            LocAPIDataIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(pbStr);
+        });
+        if (nullptr != payload) {
             LOC_LOGv("Sending data message");
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            bool rc = sendIndication(payload, E_LOCAPI_DATA_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
@@ -1111,11 +1180,14 @@ void LocHalDaemonClientHandler::onGnssMeasurementsCb(GnssMeasurementsNotificatio
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & (E_LOC_CB_GNSS_MEAS_BIT | E_LOC_CB_GNSS_NHZ_MEAS_BIT))) {
-        string pbStr;
-        LocAPIMeasIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_MEAS_MSG_ID, notification, [this, &notification](string& pbStr) {
+            LocAPIMeasIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(pbStr);
+        });
+        if (nullptr != payload) {
             LOC_LOGv("Sending meas message");
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            bool rc = sendIndication(payload, E_LOCAPI_MEAS_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
@@ -1135,11 +1207,17 @@ void LocHalDaemonClientHandler::onLocationSystemInfoCb(LocationSystemInfo notifi
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_SYSTEM_INFO_BIT)) {
-        string pbStr;
-        LocAPILocationSystemInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+        LocHalDaemonSendQueue::Payload payload = mService->getIndPayload(
+                E_LOCAPI_LOCATION_SYSTEM_INFO_MSG_ID, notification,
+                [this, &notification](string& pbStr) {
+            LocAPILocationSystemInfoIndMsg msg(SERVICE_NAME, notification,
+                                               &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(pbStr);
+        });
         LOC_LOGv("Sending location system info message");
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        if (nullptr != payload) {
+            // not periodic, must not be dropped
+            bool rc = sendIndication(payload, E_LOCAPI_LOCATION_SYSTEM_INFO_MSG_ID, false);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
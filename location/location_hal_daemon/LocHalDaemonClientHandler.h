@@ -80,6 +80,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <ILocationAPI.h>
 #include <LocIpc.h>
 #include <LocationApiPbMsgConv.h>
+#include <LocationApiBatchStore.h>
+#include <LocHalDaemonSendQueue.h>
 
 using namespace loc_util;
 
@@ -113,6 +115,8 @@ public:
                 mEngineInfoRequestMask(0),
                 mGeofenceIds(nullptr),
                 mIpcSender(createSender(clientname.c_str())),
+                mSendQueue(clientname, createSendFunc(mIpcSender),
+                           createPurgeFunc(service, clientname, mIpcSender)),
                 mAntennaInfoCb(*this) {
 
         if (mClientType == LOCATION_CLIENT_API) {
@@ -130,6 +134,9 @@ public:
     }
 
     static shared_ptr<LocIpcSender> createSender(const string socket);
+    static LocHalDaemonSendQueue::SendFunc createSendFunc(shared_ptr<LocIpcSender> sender);
+    static LocHalDaemonSendQueue::PurgeFunc createPurgeFunc(LocationApiService* service,
+            const string& clientname, shared_ptr<LocIpcSender> sender);
     void cleanup();
 
     // public APIs
@@ -149,9 +156,11 @@ public:
     bool hasPendingEngineInfoRequest(uint32_t mask);
     void addEngineInfoRequst(uint32_t mask);
 
-    uint32_t startBatching(uint32_t minInterval, uint32_t minDistance, BatchingMode batchMode);
+    uint32_t startBatching(uint32_t minInterval, uint32_t minDistance, BatchingMode batchMode,
+                           bool useBatchStore = false);
     void stopBatching();
-    void updateBatchingOptions(uint32_t minInterval, uint32_t minDistance, BatchingMode batchMode);
+    void updateBatchingOptions(uint32_t minInterval, uint32_t minDistance, BatchingMode batchMode,
+                               bool useBatchStore = false);
 
     uint32_t* addGeofences(size_t count, GeofenceOption*, GeofenceInfo*);
     void removeGeofences(size_t count, uint32_t* ids);
@@ -218,21 +227,22 @@ private:
     void onLocationApiDestroyCompleteCb();
     void onAntennaInfoCb(std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
-    // send ipc message to this client for serialized payload
+    // queue ipc message to this client for serialized payload, messages are
+    // delivered in order by mSendQueue, false means the client is being purged
     bool sendMessage(const char* msg, size_t msglen, ELocMsgID msg_id) {
-        bool retVal= LocIpc::send(*mIpcSender, reinterpret_cast<const uint8_t*>(msg), msglen);
-        if (retVal == false) {
-            struct timespec ts;
-            clock_gettime(CLOCK_BOOTTIME, &ts);
-            LOC_LOGe("failed: client %s, msg id: %d, msg size %d, err %s, "
-                     "boot timestamp %" PRIu64" msec",
-                     mName.c_str(), msg_id, msglen, strerror(errno),
-                     (ts.tv_sec * 1000ULL + ts.tv_nsec/1000000));
-        }
-        return retVal;
+        return mSendQueue.enqueue(std::make_shared<const std::string>(msg, msglen),
+                                  msg_id, false);
+    }
+    // queue indication payload that is shared with the other subscribed
+    // clients, droppable for periodic reports a newer one supersedes
+    bool sendIndication(const LocHalDaemonSendQueue::Payload& payload, ELocMsgID msg_id,
+                        bool droppable = true) {
+        return mSendQueue.enqueue(payload, msg_id, droppable);
     }
 
     uint32_t getSupportedTbf (uint32_t tbfMsec);
+    // create the batch store of this client, or remove it
+    void setBatchStore(bool enable);
 
     // pointer to parent service
     LocationApiService* mService;
@@ -251,6 +261,8 @@ private:
     LocationCallbacks mCallbacks;
     TrackingOptions mOptions;
     BatchingOptions mBatchOptions;
+    // batched fixes go here instead of into the indication if the client asked for it
+    std::unique_ptr<LocationApiBatchStore> mBatchStore;
     bool mTracking; // flag indicates whether client has started tracking session or not
 
     // bitmask to hold this client's subscription
@@ -260,6 +272,7 @@ private:
 
     uint32_t* mGeofenceIds;
     shared_ptr<LocIpcSender> mIpcSender;
+    LocHalDaemonSendQueue mSendQueue;
     std::unordered_map<uint32_t, uint32_t> mGfIdsMap; //geofence ID map, clientId-->session
     AntennaInfoHalClientCallback mAntennaInfoCb;
 };
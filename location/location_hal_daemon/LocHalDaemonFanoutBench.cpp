@@ -0,0 +1,380 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Multi-client load benchmark for the indication fan-out of location_hal_daemon.
+
+Fast and slow clients read indications from local sockets, the way the
+location clients read the daemon's. Indications are sent both the way the
+daemon used to, serialized for each client and sent from the callback, and
+through LocHalDaemonSendQueue, serialized once and queued to every client.
+Reports the time the callback path takes per indication, the latency the fast
+clients see, and how many indications the slow clients lost.
+
+usage: location_hal_daemon_fanout_bench [epochs] [fast clients] [slow clients]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <LocHalDaemonSendQueue.h>
+
+#define DEFAULT_EPOCHS        500
+#define DEFAULT_FAST_CLIENTS  6
+#define DEFAULT_SLOW_CLIENTS  2
+#define NUM_SVS               96      // about what an SV report carries
+#define EPOCH_INTERVAL_US     500
+#define SLOW_CLIENT_DELAY_US  2000
+#define SOCKET_BUFFER_SIZE    (64 * 1024)
+#define END_OF_RUN            UINT64_MAX
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct BenchSv {
+    uint16_t svId;
+    uint16_t type;
+    float cN0Dbhz;
+    float elevation;
+    float azimuth;
+    uint32_t flags;
+    double carrierFrequencyHz;
+};
+
+// reports are generated on a fixed schedule, a report is stamped with the time
+// it was due, so time lost to a callback that blocks shows up as latency
+static uint64_t waitForEpoch(uint64_t runStartNs, int epoch) {
+    uint64_t dueNs = runStartNs + (uint64_t)epoch * EPOCH_INTERVAL_US * 1000;
+    uint64_t now = nowNs();
+    if (now < dueNs) {
+        usleep((dueNs - now) / 1000);
+    }
+    return dueNs;
+}
+
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+static void putFixed(std::string& out, const void* data, size_t length) {
+    out.append(reinterpret_cast<const char*>(data), length);
+}
+
+// stands in for the protobuf serialization of an SV report, field tags,
+// varints and fixed width floats, the send time stamp goes first
+static bool serializeReport(uint64_t epoch, uint64_t timestampNs, const BenchSv* svs,
+                            std::string& out) {
+    out.clear();
+    putFixed(out, &timestampNs, sizeof(timestampNs));
+    putVarint(out, epoch);
+    for (int i = 0; i < NUM_SVS; i++) {
+        std::string sv;
+        putVarint(sv, 1 << 3);
+        putVarint(sv, svs[i].svId);
+        putVarint(sv, 2 << 3);
+        putVarint(sv, svs[i].type);
+        putVarint(sv, (3 << 3) | 5);
+        putFixed(sv, &svs[i].cN0Dbhz, sizeof(float));
+        putVarint(sv, (4 << 3) | 5);
+        putFixed(sv, &svs[i].elevation, sizeof(float));
+        putVarint(sv, (5 << 3) | 5);
+        putFixed(sv, &svs[i].azimuth, sizeof(float));
+        putVarint(sv, 6 << 3);
+        putVarint(sv, svs[i].flags);
+        putVarint(sv, (7 << 3) | 1);
+        putFixed(sv, &svs[i].carrierFrequencyHz, sizeof(double));
+        putVarint(out, (3 << 3) | 2);
+        putVarint(out, sv.size());
+        out.append(sv);
+    }
+    return true;
+}
+
+struct Client {
+    bool slow;
+    int fds[2];     // [0] daemon side, [1] client side
+    std::thread reader;
+    uint64_t received;
+    uint64_t outOfOrder;
+    std::vector<uint64_t> latencyNs;
+};
+
+static void readIndications(Client* client) {
+    std::vector<char> buf(SOCKET_BUFFER_SIZE);
+    uint64_t lastEpoch = 0;
+
+    while (true) {
+        ssize_t n = recv(client->fds[1], buf.data(), buf.size(), 0);
+        if (n < (ssize_t)(sizeof(uint64_t) + 1)) {
+            break;
+        }
+        uint64_t sentNs;
+        memcpy(&sentNs, buf.data(), sizeof(sentNs));
+        if (END_OF_RUN == sentNs) {
+            break;
+        }
+        uint64_t epoch = 0;
+        int shift = 0;
+        for (ssize_t i = sizeof(sentNs); i < n; i++, shift += 7) {
+            epoch |= (uint64_t)(buf[i] & 0x7f) << shift;
+            if (!(buf[i] & 0x80)) {
+                break;
+            }
+        }
+        if (client->received > 0 && epoch <= lastEpoch) {
+            client->outOfOrder++;
+        }
+        lastEpoch = epoch;
+        client->received++;
+        if (client->slow) {
+            usleep(SLOW_CLIENT_DELAY_US);
+        } else {
+            client->latencyNs.push_back(nowNs() - sentNs);
+        }
+    }
+}
+
+struct Result {
+    uint64_t callbackNs;
+    uint64_t fastReceived;
+    uint64_t slowReceived;
+    uint64_t outOfOrder;
+    uint64_t dropped;
+    uint64_t purged;
+    std::vector<uint64_t> latencyNs;
+};
+
+static bool openClients(std::vector<std::unique_ptr<Client>>& clients, int fast, int slow) {
+    for (int i = 0; i < fast + slow; i++) {
+        std::unique_ptr<Client> client(new Client());
+        int size = SOCKET_BUFFER_SIZE;
+
+        client->slow = (i >= fast);
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, client->fds) != 0) {
+            perror("socketpair");
+            return false;
+        }
+        setsockopt(client->fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(client->fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        clients.push_back(std::move(client));
+    }
+    for (auto& client : clients) {
+        client->reader = std::thread(readIndications, client.get());
+    }
+    return true;
+}
+
+static std::string endOfRunMsg() {
+    uint64_t endOfRun = END_OF_RUN;
+    std::string end(reinterpret_cast<const char*>(&endOfRun), sizeof(endOfRun));
+    end.push_back(0);
+    return end;
+}
+
+// waits for the clients to read the end of run message
+static void closeClients(std::vector<std::unique_ptr<Client>>& clients, Result& result) {
+    for (auto& client : clients) {
+        client->reader.join();
+        close(client->fds[0]);
+        close(client->fds[1]);
+        if (client->slow) {
+            result.slowReceived += client->received;
+        } else {
+            result.fastReceived += client->received;
+            result.latencyNs.insert(result.latencyNs.end(), client->latencyNs.begin(),
+                                    client->latencyNs.end());
+        }
+        result.outOfOrder += client->outOfOrder;
+    }
+}
+
+static void makeReport(uint64_t epoch, BenchSv* svs) {
+    for (int i = 0; i < NUM_SVS; i++) {
+        svs[i].svId = i + 1;
+        svs[i].type = i % 7;
+        svs[i].cN0Dbhz = 20.0f + (float)((epoch + i) % 300) / 10.0f;
+        svs[i].elevation = (float)(i * 7 % 90);
+        svs[i].azimuth = (float)((epoch + i * 13) % 360);
+        svs[i].flags = (uint32_t)(epoch ^ i) & 0x7;
+        svs[i].carrierFrequencyHz = 1575420000.0 + i;
+    }
+}
+
+// the daemon before the send queues: serialize and send for each client,
+// from the callback
+static bool runPerClient(int epochs, int fast, int slow, Result& result) {
+    std::vector<std::unique_ptr<Client>> clients;
+    BenchSv svs[NUM_SVS];
+    std::string pbStr;
+
+    if (!openClients(clients, fast, slow)) {
+        return false;
+    }
+    uint64_t runStart = nowNs();
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        uint64_t due = waitForEpoch(runStart, epoch);
+        uint64_t start = nowNs();
+        makeReport(epoch, svs);
+        for (auto& client : clients) {
+            serializeReport(epoch, due, svs, pbStr);
+            if (send(client->fds[0], pbStr.data(), pbStr.size(), 0) < 0) {
+                result.purged++;
+            }
+        }
+        result.callbackNs += nowNs() - start;
+    }
+
+    std::string end = endOfRunMsg();
+    for (auto& client : clients) {
+        send(client->fds[0], end.data(), end.size(), 0);
+    }
+    closeClients(clients, result);
+    return true;
+}
+
+// serialize once, then queue the shared payload to each client
+static bool runQueued(int epochs, int fast, int slow, Result& result) {
+    std::vector<std::unique_ptr<Client>> clients;
+    std::vector<std::unique_ptr<LocHalDaemonSendQueue>> queues;
+    std::atomic<uint64_t> purged(0);
+    BenchSv svs[NUM_SVS];
+
+    if (!openClients(clients, fast, slow)) {
+        return false;
+    }
+    for (auto& client : clients) {
+        int fd = client->fds[0];
+        queues.push_back(std::unique_ptr<LocHalDaemonSendQueue>(new LocHalDaemonSendQueue(
+                "bench",
+                [fd](const uint8_t* data, size_t length) {
+                    return send(fd, data, length, 0) == (ssize_t)length;
+                },
+                [&purged]() { purged++; })));
+    }
+    uint64_t runStart = nowNs();
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        uint64_t due = waitForEpoch(runStart, epoch);
+        uint64_t start = nowNs();
+        std::string pbStr;
+        makeReport(epoch, svs);
+        serializeReport(epoch, due, svs, pbStr);
+        LocHalDaemonSendQueue::Payload payload =
+                std::make_shared<const std::string>(std::move(pbStr));
+        for (auto& queue : queues) {
+            queue->enqueue(payload, 0, true);
+        }
+        result.callbackNs += nowNs() - start;
+    }
+
+    // the end of run message goes behind what is queued, the slow clients
+    // take a while to get to it
+    LocHalDaemonSendQueue::Payload end = std::make_shared<const std::string>(endOfRunMsg());
+    for (auto& queue : queues) {
+        queue->enqueue(end, 0, false);
+    }
+    closeClients(clients, result);
+    for (auto& queue : queues) {
+        result.dropped += queue->getDroppedCount();
+        queue->stop();
+    }
+    result.purged = purged;
+    return true;
+}
+
+static uint64_t percentileUs(std::vector<uint64_t>& samples, int percent) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t index = (samples.size() - 1) * percent / 100;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index] / 1000;
+}
+
+static void printResult(const char* name, int epochs, int fast, int slow, Result& result) {
+    printf("%-12s callback %7.1f us/epoch  fast p50 %6" PRIu64 " p99 %6" PRIu64
+           " max %6" PRIu64 " us  fast %" PRIu64 "/%d  slow %" PRIu64 "/%d"
+           "  dropped %" PRIu64 "  purged %" PRIu64 "\n",
+           name, (double)result.callbackNs / epochs / 1000,
+           percentileUs(result.latencyNs, 50), percentileUs(result.latencyNs, 99),
+           percentileUs(result.latencyNs, 100), result.fastReceived, epochs * fast,
+           result.slowReceived, epochs * slow, result.dropped, result.purged);
+}
+
+int main(int argc, char** argv) {
+    int epochs = argc > 1 ? atoi(argv[1]) : DEFAULT_EPOCHS;
+    int fast = argc > 2 ? atoi(argv[2]) : DEFAULT_FAST_CLIENTS;
+    int slow = argc > 3 ? atoi(argv[3]) : DEFAULT_SLOW_CLIENTS;
+    Result perClient = {}, queued = {};
+    int ret = 0;
+
+    if (epochs <= 0 || fast <= 0 || slow < 0) {
+        printf("usage: %s [epochs] [fast clients] [slow clients]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d epochs every %d us, %d fast and %d slow clients (%d us per indication)\n",
+           epochs, EPOCH_INTERVAL_US, fast, slow, SLOW_CLIENT_DELAY_US);
+    if (!runPerClient(epochs, fast, slow, perClient) ||
+            !runQueued(epochs, fast, slow, queued)) {
+        return 1;
+    }
+    printResult("per client", epochs, fast, slow, perClient);
+    printResult("send queues", epochs, fast, slow, queued);
+
+    // the fast clients keep up, they must get every indication in order
+    if (queued.fastReceived != (uint64_t)epochs * fast || queued.outOfOrder != 0 ||
+            queued.purged != 0) {
+        printf("FAILED\n");
+        ret = 1;
+    } else {
+        printf("PASSED\n");
+    }
+    return ret;
+}
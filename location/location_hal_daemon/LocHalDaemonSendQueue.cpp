@@ -0,0 +1,176 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <inttypes.h>
+#include <thread>
+#include <log_util.h>
+#include <loc_pla.h>
+#include <LocHalDaemonSendQueue.h>
+
+#undef LOG_TAG
+#define LOG_TAG "LocSvc_HalDaemon"
+
+LocHalDaemonSendQueue::LocHalDaemonSendQueue(const std::string& name, const SendFunc& sendFunc,
+                                             const PurgeFunc& purgeFunc, size_t maxDepth) :
+        mState(std::make_shared<State>()) {
+    mState->name = name;
+    mState->sendFunc = sendFunc;
+    mState->purgeFunc = purgeFunc;
+    mState->maxDepth = (maxDepth > 0) ? maxDepth : 1;
+    mState->stopped = false;
+    mState->sentCount = 0;
+    mState->droppedCount = 0;
+
+    std::thread(run, mState).detach();
+}
+
+LocHalDaemonSendQueue::~LocHalDaemonSendQueue() {
+    stop();
+}
+
+// called with state.lock held, the returned function is to be called after
+// the lock is released
+LocHalDaemonSendQueue::PurgeFunc LocHalDaemonSendQueue::fail(State& state) {
+    PurgeFunc purgeFunc;
+
+    state.stopped = true;
+    state.entries.clear();
+    purgeFunc.swap(state.purgeFunc);
+    state.cond.notify_all();
+    return purgeFunc;
+}
+
+bool LocHalDaemonSendQueue::enqueue(const Payload& payload, uint32_t msgId, bool droppable) {
+    PurgeFunc purgeFunc;
+    {
+        std::lock_guard<std::mutex> lock(mState->lock);
+        if (mState->stopped) {
+            return false;
+        }
+
+        if (mState->entries.size() >= mState->maxDepth) {
+            auto it = mState->entries.begin();
+            while (it != mState->entries.end() && !it->droppable) {
+                ++it;
+            }
+            if (it == mState->entries.end() && !droppable) {
+                LOC_LOGe("client %s: %zu messages pending, none droppable, msg id %u",
+                         mState->name.c_str(), mState->entries.size(), msgId);
+                purgeFunc = fail(*mState);
+            } else {
+                // drop the oldest droppable message, or the new one when everything
+                // pending must be delivered
+                bool dropNew = (it == mState->entries.end());
+                if (!dropNew) {
+                    mState->entries.erase(it);
+                }
+                if (++mState->droppedCount == 1 || (mState->droppedCount % 100) == 0) {
+                    LOC_LOGw("client %s is not keeping up, %" PRIu64 " indications dropped",
+                             mState->name.c_str(), mState->droppedCount);
+                }
+                if (dropNew) {
+                    return true;
+                }
+            }
+        }
+
+        if (!mState->stopped) {
+            mState->entries.push_back({payload, msgId, droppable});
+            mState->cond.notify_one();
+            return true;
+        }
+    }
+
+    if (purgeFunc) {
+        purgeFunc();
+    }
+    return false;
+}
+
+void LocHalDaemonSendQueue::stop() {
+    std::lock_guard<std::mutex> lock(mState->lock);
+    mState->stopped = true;
+    mState->entries.clear();
+    mState->purgeFunc = nullptr;
+    mState->cond.notify_all();
+}
+
+uint64_t LocHalDaemonSendQueue::getSentCount() const {
+    std::lock_guard<std::mutex> lock(mState->lock);
+    return mState->sentCount;
+}
+
+uint64_t LocHalDaemonSendQueue::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mState->lock);
+    return mState->droppedCount;
+}
+
+void LocHalDaemonSendQueue::run(std::shared_ptr<State> state) {
+    std::unique_lock<std::mutex> lock(state->lock);
+
+    while (true) {
+        state->cond.wait(lock, [&state] { return state->stopped || !state->entries.empty(); });
+        if (state->stopped) {
+            break;
+        }
+
+        Entry entry = state->entries.front();
+        state->entries.pop_front();
+
+        lock.unlock();
+        bool sent = state->sendFunc(reinterpret_cast<const uint8_t*>(entry.payload->data()),
+                                    entry.payload->size());
+        int err = errno;
+        lock.lock();
+
+        if (sent) {
+            state->sentCount++;
+        } else if (!state->stopped) {
+            struct timespec ts;
+            clock_gettime(CLOCK_BOOTTIME, &ts);
+            LOC_LOGe("failed: client %s, msg id: %u, msg size %zu, err %s, "
+                     "boot timestamp %" PRIu64" msec",
+                     state->name.c_str(), entry.msgId, entry.payload->size(), strerror(err),
+                     (uint64_t)(ts.tv_sec * 1000ULL + ts.tv_nsec/1000000));
+            PurgeFunc purgeFunc = fail(*state);
+            lock.unlock();
+            if (purgeFunc) {
+                purgeFunc();
+            }
+            return;
+        }
+    }
+}
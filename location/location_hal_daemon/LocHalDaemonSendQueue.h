@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LOCHAL_DAEMON_SEND_QUEUE_H
+#define LOCHAL_DAEMON_SEND_QUEUE_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/******************************************************************************
+LocHalDaemonSendQueue
+
+Bounded queue of serialized messages to one client, drained by a thread of
+its own so that a client which is slow to read its socket holds up neither
+the engine callbacks nor the other clients. Payloads are shared, so an
+indication serialized once can be queued to every client subscribed to it.
+
+When the queue is full, the oldest droppable message (periodic indications
+such as SV, NMEA or measurements, where a newer one supersedes it) makes
+room for the new one. If nothing can be dropped, or a send fails, the queue
+stops and the purge function is called once, from whichever thread found
+the client stuck, so that the service can remove the client.
+******************************************************************************/
+class LocHalDaemonSendQueue
+{
+public:
+    typedef std::shared_ptr<const std::string> Payload;
+    typedef std::function<bool(const uint8_t* data, size_t length)> SendFunc;
+    typedef std::function<void()> PurgeFunc;
+
+    static const size_t DEFAULT_MAX_DEPTH = 32;
+
+    LocHalDaemonSendQueue(const std::string& name, const SendFunc& sendFunc,
+                          const PurgeFunc& purgeFunc, size_t maxDepth = DEFAULT_MAX_DEPTH);
+    ~LocHalDaemonSendQueue();
+
+    // queue payload for sending, returns false once the queue has stopped
+    bool enqueue(const Payload& payload, uint32_t msgId, bool droppable);
+    // discard what is queued and let the thread exit, does not wait for a
+    // send in progress and the purge function is not called after this
+    void stop();
+
+    uint64_t getSentCount() const;
+    uint64_t getDroppedCount() const;
+
+private:
+    struct Entry {
+        Payload payload;
+        uint32_t msgId;
+        bool droppable;
+    };
+
+    // shared with the sending thread, which may outlive this object
+    struct State {
+        std::string name;
+        SendFunc sendFunc;
+        PurgeFunc purgeFunc;
+        size_t maxDepth;
+        std::mutex lock;
+        std::condition_variable cond;
+        std::deque<Entry> entries;
+        bool stopped;
+        uint64_t sentCount;
+        uint64_t droppedCount;
+    };
+
+    static void run(std::shared_ptr<State> state);
+    static PurgeFunc fail(State& state);
+
+    std::shared_ptr<State> mState;
+};
+
+#endif //LOCHAL_DAEMON_SEND_QUEUE_H
@@ -849,6 +849,58 @@ void LocationApiService::deleteEapClientByIds(int serviceId, int instanceId) {
     }
 }
 
+void LocationApiService::purgeClient(const std::string& clientname,
+                                     shared_ptr<LocIpcSender> sender) {
+
+    struct PurgeClientReq : public LocMsg {
+        PurgeClientReq(LocationApiService* locationApiService, const std::string& clientname,
+                       shared_ptr<LocIpcSender> sender) :
+                mLocationApiService(locationApiService), mClientName(clientname),
+                mSender(sender) {}
+        virtual ~PurgeClientReq() {}
+        void proc() const {
+            std::lock_guard<std::recursive_mutex> lock(LocationApiService::mMutex);
+            // the client may have been deleted, and the name taken by a new one,
+            // since the purge was posted
+            auto client = mLocationApiService->mClients.find(mClientName);
+            if (client != mLocationApiService->mClients.end() &&
+                    client->second->getIpcSender() == mSender) {
+                LOC_LOGe("--< purging client %s", mClientName.c_str());
+                mLocationApiService->deleteClientbyName(mClientName);
+            }
+        }
+        LocationApiService* mLocationApiService;
+        const std::string mClientName;
+        shared_ptr<LocIpcSender> mSender;
+    };
+    mMsgTask.sendMsg(new PurgeClientReq(this, clientname, sender));
+}
+
+LocHalDaemonSendQueue::Payload LocationApiService::getIndPayload(ELocMsgID msgId,
+        const std::string& key, const std::function<bool(std::string&)>& serialize) {
+
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    std::string pbStr;
+
+    if (key.empty()) {
+        if (!serialize(pbStr)) {
+            return nullptr;
+        }
+        return std::make_shared<const std::string>(std::move(pbStr));
+    }
+
+    IndCacheEntry& entry = mIndCache[msgId];
+    if (nullptr == entry.payload || entry.key != key) {
+        entry.payload = nullptr;
+        if (!serialize(pbStr)) {
+            return nullptr;
+        }
+        entry.key = key;
+        entry.payload = std::make_shared<const std::string>(std::move(pbStr));
+    }
+    return entry.payload;
+}
+
 /******************************************************************************
 LocationApiService - implementation - tracking
 ******************************************************************************/
@@ -1097,7 +1149,7 @@ void LocationApiService::startBatching(LocAPIStartBatchingReqMsg *pMsg) {
     }
 
     if (!pClient->startBatching(pMsg->intervalInMs, pMsg->distanceInMeters,
-                pMsg->batchingMode)) {
+                pMsg->batchingMode, pMsg->useBatchStore)) {
         LOC_LOGe("Failed to start session");
         return;
     }
@@ -1131,7 +1183,7 @@ void LocationApiService::updateBatchingOptions(LocAPIUpdateBatchingOptionsReqMsg
     LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
     if (pClient) {
         pClient->updateBatchingOptions(pMsg->intervalInMs, pMsg->distanceInMeters,
-                pMsg->batchingMode);
+                pMsg->batchingMode, pMsg->useBatchStore);
         pClient->mPendingMessages.push(E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID);
     }
 
@@ -66,6 +66,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <string>
 #include <mutex>
+#include <functional>
+#include <type_traits>
 
 #include <loc_pla.h>
 #include <MsgTask.h>
@@ -214,6 +216,22 @@ public:
     // other APIs
     void deleteClientbyName(const std::string name);
     void deleteEapClientByIds(int id1, int id2);
+    // delete client from mMsgTask, for clients found stuck by their send queue
+    void purgeClient(const std::string& clientname, shared_ptr<LocIpcSender> sender);
+
+    // Broadcast indications are serialized once for all the clients that get
+    // the same report, serialize is only called when the report differs from
+    // the last one of msgId. Reports that cannot be compared bytewise are
+    // serialized each time. Caller holds mMutex.
+    template <typename T>
+    LocHalDaemonSendQueue::Payload getIndPayload(ELocMsgID msgId, const T& report,
+            const std::function<bool(std::string&)>& serialize) {
+        return getIndPayload(msgId, indCacheKey(report,
+                std::integral_constant<bool, std::is_trivially_copyable<T>::value>()),
+                serialize);
+    }
+    LocHalDaemonSendQueue::Payload getIndPayload(ELocMsgID msgId, const std::string& key,
+            const std::function<bool(std::string&)>& serialize);
 
     // protobuf conversion util class
     LocationApiPbMsgConv mPbufMsgConv;
@@ -353,6 +371,15 @@ private:
         return nullptr;
     }
 
+    template <typename T>
+    static inline std::string indCacheKey(const T& report, std::true_type) {
+        return std::string(reinterpret_cast<const char*>(&report), sizeof(report));
+    }
+    template <typename T>
+    static inline std::string indCacheKey(const T&, std::false_type) {
+        return std::string();
+    }
+
     GnssInterface* getGnssInterface();
     // OSFramework instance
     void createOSFrameworkInstance();
@@ -372,6 +399,14 @@ private:
 
     // Client propery database
     std::unordered_map<std::string, LocHalDaemonClientHandler*> mClients;
+
+    // last serialized broadcast indication of each msg id, with the report it
+    // was serialized from
+    struct IndCacheEntry {
+        std::string key;
+        LocHalDaemonSendQueue::Payload payload;
+    };
+    std::unordered_map<uint32_t, IndCacheEntry> mIndCache;
     std::unordered_map<uint32_t, ConfigReqClientData> mConfigReqs;
 
     // Location Control API interface
@@ -95,6 +95,7 @@ LOCAL_SRC_FILES := \
     device/src/HeadsetVaMic.cpp \
     device/src/RTProxy.cpp \
     device/src/SpeakerProtection.cpp \
+    device/src/SpeakerCalCache.cpp \
     device/src/FMDevice.cpp \
     device/src/ExtEC.cpp \
     device/src/HapticsDev.cpp \
@@ -115,6 +116,7 @@ LOCAL_SRC_FILES := \
     session/src/ACDEngine.cpp \
     resource_manager/src/ResourceManager.cpp \
     resource_manager/src/SndCardMonitor.cpp \
+    resource_manager/src/DeviceSwitchPlanner.cpp \
     utils/src/SoundTriggerPlatformInfo.cpp \
     utils/src/ACDPlatformInfo.cpp \
     utils/src/VoiceUIPlatformInfo.cpp \
@@ -209,6 +211,44 @@ include $(BUILD_EXECUTABLE)
 
 include $(CLEAR_VARS)
 
+LOCAL_MODULE               := PalDeviceSwitchPlannerTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+LOCAL_VENDOR_MODULE        := true
+
+LOCAL_CFLAGS               := -Wall -Werror -Wno-unused-parameter
+LOCAL_C_INCLUDES           := $(LOCAL_PATH) \
+                              $(LOCAL_PATH)/resource_manager/inc
+
+LOCAL_SRC_FILES            := test/DeviceSwitchPlannerTest.cpp \
+                              resource_manager/src/DeviceSwitchPlanner.cpp
+
+LOCAL_HEADER_LIBRARIES     := libarosal_headers
+LOCAL_SHARED_LIBRARIES     := liblog
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE               := PalSpeakerCalCacheTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+LOCAL_VENDOR_MODULE        := true
+
+LOCAL_CFLAGS               := -Wall -Werror -Wno-unused-parameter
+LOCAL_C_INCLUDES           := $(LOCAL_PATH) \
+                              $(LOCAL_PATH)/device/inc
+
+LOCAL_SRC_FILES            := test/SpeakerCalCacheTest.cpp \
+                              device/src/SpeakerCalCache.cpp
+
+LOCAL_HEADER_LIBRARIES     := libarosal_headers
+LOCAL_SHARED_LIBRARIES     := liblog
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
 include $(PAL_BASE_PATH)/plugins/Android.mk
 include $(PAL_BASE_PATH)/ipc/HwBinders/Android.mk
 
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SPEAKER_CAL_CACHE_H
+#define SPEAKER_CAL_CACHE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#define SPKR_CAL_CACHE_MAGIC 0x43435053 /* "SPCC" */
+#define SPKR_CAL_CACHE_VERSION 1
+#define SPKR_CAL_CACHE_MAX_CH 8
+#define SPKR_CAL_TEMP_MIN_C (-30)
+#define SPKR_CAL_TEMP_MAX_C 80
+#define SPKR_CAL_TEMP_BAND_C 5
+#define SPKR_CAL_NUM_BANDS \
+    ((SPKR_CAL_TEMP_MAX_C - SPKR_CAL_TEMP_MIN_C) / SPKR_CAL_TEMP_BAND_C + 1)
+/* anything outside of this is not a speaker we can trust the result for */
+#define SPKR_CAL_R0_MIN_Q24 (2 * (1 << 24))
+#define SPKR_CAL_R0_MAX_Q24 (40 * (1 << 24))
+#define SPKR_CAL_TEMP_UNKNOWN INT32_MIN
+
+struct spkr_cal_entry {
+    uint32_t ch;
+    int32_t band;
+    int32_t r0_cali_q24;
+    int32_t t0_cali_q6;
+    uint64_t calTimeSec;   /* CLOCK_REALTIME of the calibration */
+};
+
+struct spkr_cal_stats {
+    uint32_t numScheduled;
+    uint32_t numCalibrations;
+    uint32_t numFailures;
+    uint32_t cacheHits;
+    uint32_t cacheMisses;
+    uint64_t lastCalMs;       /* duration of the last calibration run */
+    uint64_t maxCalMs;
+    uint64_t totalCalMs;
+    uint64_t lastWaitMs;      /* from scheduling to the start of the last run */
+    uint64_t lastLookupUs;    /* time playback start spent getting R0T0 */
+};
+
+/* Validated speaker calibration results keyed by speaker and temperature
+ * band, kept in memory and persisted so that playback start never has to
+ * wait for a calibration or touch the file system to get R0T0.
+ */
+class SpeakerCalCache
+{
+public:
+    SpeakerCalCache(const std::string &path);
+
+    static int32_t tempToBand(int32_t tempC);
+    static bool isValid(uint32_t ch, int32_t tempC, int32_t r0Q24);
+
+    int32_t load();
+    int32_t store();
+    /* imports the legacy R0T0 file written by older builds */
+    int32_t importLegacy(const std::string &path, uint32_t numCh);
+    bool update(uint32_t ch, int32_t tempC, int32_t r0Q24, int32_t t0Q6);
+    /* result for the band of tempC, or the latest one if tempC is unknown */
+    bool lookup(uint32_t ch, int32_t tempC, int32_t *r0Q24, int32_t *t0Q6);
+    bool hasBand(uint32_t ch, int32_t tempC);
+    bool empty();
+    void clear();
+
+private:
+    struct spkr_cal_entry *find(uint32_t ch, int32_t band);
+    static uint32_t checksum(const uint8_t *data, size_t size);
+
+    std::string filePath;
+    std::vector<struct spkr_cal_entry> entries;
+    std::mutex cacheMutex;
+};
+
+#endif
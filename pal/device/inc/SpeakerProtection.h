@@ -68,6 +68,7 @@
 #include "sp_vi.h"
 #include "sp_rx.h"
 #include "cps_data_router.h"
+#include "SpeakerCalCache.h"
 #include <tinyalsa/asoundlib.h>
 #include <mutex>
 #include <condition_variable>
@@ -110,6 +111,14 @@ enum {
     SPKR_CLOSE = 3,
 };
 
+/* events handled by the calibration worker */
+#define SPKR_CAL_EVT_BOOT    (1 << 0)  /* no valid calibration at boot */
+#define SPKR_CAL_EVT_DYNAMIC (1 << 1)  /* calibration requested by client */
+#define SPKR_CAL_EVT_RECAL   (1 << 2)  /* idle, calibrate if temp band is new */
+#define SPKR_CAL_EVT_EXIT    (1 << 3)
+#define SPKR_CAL_EVT_PENDING (SPKR_CAL_EVT_BOOT | SPKR_CAL_EVT_DYNAMIC | \
+                              SPKR_CAL_EVT_RECAL)
+
 struct agmMetaData {
     uint8_t *buf;
     uint32_t size;
@@ -122,7 +131,6 @@ class SpeakerProtection : public Device
 {
 protected :
     bool spkrProtEnable;
-    bool threadExit;
     bool triggerCal;
     int minIdleTime;
     static speaker_prot_cal_state spkrCalState;
@@ -130,7 +138,6 @@ protected :
     int *spkerTempList;
     static bool isSpkrInUse;
     static bool calThrdCreated;
-    static bool isDynamicCalTriggered;
     static struct timespec spkrLastTimeUsed;
     static struct mixer *virtMixer;
     static struct mixer *hwMixer;
@@ -147,8 +154,16 @@ protected :
     static int numberOfRequest;
     static struct pal_device_info vi_device;
     static struct pal_device_info cps_device;
+    static SpeakerCalCache calCache;
+    static struct spkr_cal_stats calStats;
+    static int32_t lastSpkrTempC[SPKR_CAL_CACHE_MAX_CH];
+    static uint32_t calEvents;
+    static struct timespec calScheduledTime;
+    static std::mutex calEventMutex;
+    static std::condition_variable calEventCv;
 
 private :
+    bool calWorkerOwner;
 
 public:
     static std::thread mCalThread;
@@ -158,7 +173,9 @@ public:
     static std::mutex calibrationMutex;
     void spkrCalibrationThread();
     int getSpeakerTemperature(int spkr_pos);
-    void spkrCalibrateWait();
+    void startCalibrationWorker();
+    void scheduleCalibration(uint32_t event);
+    bool isCalibrationNeeded(uint32_t events);
     int spkrStartCalibration();
     void speakerProtectionInit();
     void speakerProtectionDeinit();
@@ -181,6 +198,8 @@ public:
     int speakerProtectionDynamicCal();
     void updateSPcustomPayload();
     static int32_t spkrProtSetR0T0Value(vi_r0t0_cfg_t r0t0Array[]);
+    static void getCalibratedR0T0(vi_r0t0_cfg_t r0t0Array[], int numCh);
+    static void getCalibrationStats(struct spkr_cal_stats *stats);
     static void handleSPCallback (uint64_t hdl, uint32_t event_id, void *event_data,
                                   uint32_t event_size);
     void updateCpsCustomPayload(int miid);
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SpeakerCalCache"
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+#include "SpeakerCalCache.h"
+#include "PalCommon.h"
+
+struct spkr_cal_cache_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t checksum;
+};
+
+SpeakerCalCache::SpeakerCalCache(const std::string &path)
+{
+    filePath = path;
+}
+
+int32_t SpeakerCalCache::tempToBand(int32_t tempC)
+{
+    if (tempC < SPKR_CAL_TEMP_MIN_C)
+        tempC = SPKR_CAL_TEMP_MIN_C;
+    if (tempC > SPKR_CAL_TEMP_MAX_C)
+        tempC = SPKR_CAL_TEMP_MAX_C;
+    return (tempC - SPKR_CAL_TEMP_MIN_C) / SPKR_CAL_TEMP_BAND_C;
+}
+
+bool SpeakerCalCache::isValid(uint32_t ch, int32_t tempC, int32_t r0Q24)
+{
+    return ch < SPKR_CAL_CACHE_MAX_CH &&
+           tempC >= SPKR_CAL_TEMP_MIN_C && tempC <= SPKR_CAL_TEMP_MAX_C &&
+           r0Q24 >= SPKR_CAL_R0_MIN_Q24 && r0Q24 <= SPKR_CAL_R0_MAX_Q24;
+}
+
+uint32_t SpeakerCalCache::checksum(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+struct spkr_cal_entry *SpeakerCalCache::find(uint32_t ch, int32_t band)
+{
+    for (auto &entry : entries) {
+        if (entry.ch == ch && entry.band == band)
+            return &entry;
+    }
+    return NULL;
+}
+
+int32_t SpeakerCalCache::load()
+{
+    struct spkr_cal_cache_hdr hdr;
+    std::vector<struct spkr_cal_entry> loaded;
+    FILE *fp;
+    int32_t status = 0;
+
+    fp = fopen(filePath.c_str(), "rb");
+    if (!fp) {
+        PAL_DBG(LOG_TAG, "no calibration cache at %s", filePath.c_str());
+        return -ENOENT;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != SPKR_CAL_CACHE_MAGIC ||
+        hdr.version != SPKR_CAL_CACHE_VERSION ||
+        hdr.numEntries > SPKR_CAL_CACHE_MAX_CH * SPKR_CAL_NUM_BANDS) {
+        PAL_ERR(LOG_TAG, "invalid calibration cache header");
+        status = -EINVAL;
+        goto exit;
+    }
+
+    loaded.resize(hdr.numEntries);
+    if (hdr.numEntries &&
+        fread(loaded.data(), sizeof(struct spkr_cal_entry), hdr.numEntries, fp) !=
+            hdr.numEntries) {
+        PAL_ERR(LOG_TAG, "truncated calibration cache");
+        status = -EINVAL;
+        goto exit;
+    }
+
+    if (checksum((const uint8_t *)loaded.data(),
+                 loaded.size() * sizeof(struct spkr_cal_entry)) != hdr.checksum) {
+        PAL_ERR(LOG_TAG, "calibration cache checksum mismatch");
+        status = -EINVAL;
+        goto exit;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        entries.clear();
+        for (auto &entry : loaded) {
+            int32_t tempC = SPKR_CAL_TEMP_MIN_C + entry.band * SPKR_CAL_TEMP_BAND_C;
+
+            if (entry.band < 0 || entry.band >= SPKR_CAL_NUM_BANDS ||
+                !isValid(entry.ch, tempC, entry.r0_cali_q24) || find(entry.ch, entry.band)) {
+                PAL_ERR(LOG_TAG, "dropping invalid cache entry ch %d band %d r0 %x",
+                        entry.ch, entry.band, entry.r0_cali_q24);
+                continue;
+            }
+            entries.push_back(entry);
+        }
+        PAL_INFO(LOG_TAG, "loaded %zu calibration results", entries.size());
+    }
+
+exit:
+    fclose(fp);
+    return status;
+}
+
+int32_t SpeakerCalCache::store()
+{
+    struct spkr_cal_cache_hdr hdr;
+    std::vector<struct spkr_cal_entry> snapshot;
+    std::string tmpPath = filePath + ".tmp";
+    FILE *fp;
+    bool ok;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        snapshot = entries;
+    }
+
+    hdr.magic = SPKR_CAL_CACHE_MAGIC;
+    hdr.version = SPKR_CAL_CACHE_VERSION;
+    hdr.numEntries = snapshot.size();
+    hdr.checksum = checksum((const uint8_t *)snapshot.data(),
+                            snapshot.size() * sizeof(struct spkr_cal_entry));
+
+    fp = fopen(tmpPath.c_str(), "wb");
+    if (!fp) {
+        PAL_ERR(LOG_TAG, "Unable to open %s for write", tmpPath.c_str());
+        return -EIO;
+    }
+    ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    if (ok && !snapshot.empty())
+        ok = fwrite(snapshot.data(), sizeof(struct spkr_cal_entry), snapshot.size(), fp) ==
+                snapshot.size();
+    if (fclose(fp))
+        ok = false;
+
+    /* rename so that a crash never leaves a half written cache behind */
+    if (!ok || rename(tmpPath.c_str(), filePath.c_str())) {
+        PAL_ERR(LOG_TAG, "Unable to write calibration cache");
+        remove(tmpPath.c_str());
+        return -EIO;
+    }
+    return 0;
+}
+
+int32_t SpeakerCalCache::importLegacy(const std::string &path, uint32_t numCh)
+{
+    int32_t r0Q24 = 0;
+    int16_t t0Q6 = 0;
+    int32_t imported = 0;
+    FILE *fp;
+
+    fp = fopen(path.c_str(), "rb");
+    if (!fp)
+        return -ENOENT;
+
+    for (uint32_t ch = 0; ch < numCh; ch++) {
+        if (fread(&r0Q24, sizeof(r0Q24), 1, fp) != 1 ||
+            fread(&t0Q6, sizeof(t0Q6), 1, fp) != 1)
+            break;
+        if (update(ch, t0Q6 / (1 << 6), r0Q24, t0Q6))
+            imported++;
+    }
+    fclose(fp);
+
+    PAL_DBG(LOG_TAG, "imported %d legacy calibration results", imported);
+    return imported ? 0 : -EINVAL;
+}
+
+bool SpeakerCalCache::update(uint32_t ch, int32_t tempC, int32_t r0Q24, int32_t t0Q6)
+{
+    struct spkr_cal_entry *entry;
+    struct spkr_cal_entry newEntry;
+    int32_t band;
+
+    if (!isValid(ch, tempC, r0Q24)) {
+        PAL_ERR(LOG_TAG, "rejecting calibration ch %d temp %d r0 %x", ch, tempC, r0Q24);
+        return false;
+    }
+
+    band = tempToBand(tempC);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entry = find(ch, band);
+    if (!entry) {
+        newEntry = {};
+        newEntry.ch = ch;
+        newEntry.band = band;
+        entries.push_back(newEntry);
+        entry = &entries.back();
+    }
+    entry->r0_cali_q24 = r0Q24;
+    entry->t0_cali_q6 = t0Q6;
+    entry->calTimeSec = time(NULL);
+    return true;
+}
+
+bool SpeakerCalCache::lookup(uint32_t ch, int32_t tempC, int32_t *r0Q24, int32_t *t0Q6)
+{
+    struct spkr_cal_entry *best = NULL;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (tempC != SPKR_CAL_TEMP_UNKNOWN)
+        best = find(ch, tempToBand(tempC));
+    if (!best) {
+        for (auto &entry : entries) {
+            if (entry.ch == ch && (!best || entry.calTimeSec > best->calTimeSec))
+                best = &entry;
+        }
+    }
+    if (!best)
+        return false;
+
+    *r0Q24 = best->r0_cali_q24;
+    *t0Q6 = best->t0_cali_q6;
+    return true;
+}
+
+bool SpeakerCalCache::hasBand(uint32_t ch, int32_t tempC)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return find(ch, tempToBand(tempC)) != NULL;
+}
+
+bool SpeakerCalCache::empty()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return entries.empty();
+}
+
+void SpeakerCalCache::clear()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+}
@@ -77,10 +77,14 @@
 #ifndef PAL_SP_TEMP_PATH
 #define PAL_SP_TEMP_PATH "/data/misc/audio/audio.cal"
 #endif
+#ifndef PAL_SP_CAL_CACHE_PATH
+#define PAL_SP_CAL_CACHE_PATH "/data/misc/audio/audio_cal_cache.bin"
+#endif
 #define FEEDBACK_MONO_1 "-mono-1"
 
 #define MIN_SPKR_IDLE_SEC (60 * 30)
 #define WAKEUP_MIN_IDLE_CHECK (1000 * 30)
+#define SPKR_TEMP_RETRY_MS (1000 * 60 * 5)
 
 #define SPKR_RIGHT_WSA_TEMP "SpkrRight WSA Temp"
 #define SPKR_LEFT_WSA_TEMP "SpkrLeft WSA Temp"
@@ -121,7 +125,6 @@ std::mutex SpeakerProtection::calibrationMutex;
 
 bool SpeakerProtection::isSpkrInUse;
 bool SpeakerProtection::calThrdCreated;
-bool SpeakerProtection::isDynamicCalTriggered = false;
 struct timespec SpeakerProtection::spkrLastTimeUsed;
 struct mixer *SpeakerProtection::virtMixer;
 struct mixer *SpeakerProtection::hwMixer;
@@ -136,6 +139,16 @@ struct pal_device_info SpeakerProtection::cps_device;
 int SpeakerProtection::calibrationCallbackStatus;
 int SpeakerProtection::numberOfRequest;
 bool SpeakerProtection::mDspCallbackRcvd;
+SpeakerCalCache SpeakerProtection::calCache(PAL_SP_CAL_CACHE_PATH);
+struct spkr_cal_stats SpeakerProtection::calStats;
+int32_t SpeakerProtection::lastSpkrTempC[SPKR_CAL_CACHE_MAX_CH] = {
+    SPKR_CAL_TEMP_UNKNOWN, SPKR_CAL_TEMP_UNKNOWN, SPKR_CAL_TEMP_UNKNOWN,
+    SPKR_CAL_TEMP_UNKNOWN, SPKR_CAL_TEMP_UNKNOWN, SPKR_CAL_TEMP_UNKNOWN,
+    SPKR_CAL_TEMP_UNKNOWN, SPKR_CAL_TEMP_UNKNOWN};
+uint32_t SpeakerProtection::calEvents;
+struct timespec SpeakerProtection::calScheduledTime;
+std::mutex SpeakerProtection::calEventMutex;
+std::condition_variable SpeakerProtection::calEventCv;
 std::shared_ptr<Device> SpeakerFeedback::obj = nullptr;
 int SpeakerFeedback::numSpeaker;
 
@@ -153,6 +166,11 @@ std::string getDefaultSpkrTempCtrl(uint8_t spkr_pos)
     }
 }
 
+static uint64_t spkrTimeDiffMs(const struct timespec &from, const struct timespec &to)
+{
+    return (to.tv_sec - from.tv_sec) * 1000LL + (to.tv_nsec - from.tv_nsec) / 1000000;
+}
+
 cps_reg_wr_values_t sp_cps_thrsh_values = {
     .value_normal_threshold = {0x8E003049, 0x1000304A, 0x0F003472},
     .value_lower_threshold_1 = {0x8F003049, 0xD000304A, 0x0F003472},
@@ -198,17 +216,97 @@ void SpeakerProtection::spkrProtSetSpkrStatus(bool enable)
         isSpkrInUse = false;
         clock_gettime(CLOCK_BOOTTIME, &spkrLastTimeUsed);
         PAL_INFO(LOG_TAG, "Speaker used last time %ld", spkrLastTimeUsed.tv_sec);
+        /* Let the worker recalibrate in the background if the speaker cools
+         * down into a temperature band there is no calibration for yet.
+         */
+        std::lock_guard<std::mutex> lock(calEventMutex);
+        if (calEvents & SPKR_CAL_EVT_EXIT)
+            return;
+        if (!calEvents)
+            clock_gettime(CLOCK_BOOTTIME, &calScheduledTime);
+        calEvents |= SPKR_CAL_EVT_RECAL;
+        calEventCv.notify_all();
     }
 
     PAL_DBG(LOG_TAG, "Exit");
 }
 
-/* Wait function for WAKEUP_MIN_IDLE_CHECK  */
-void SpeakerProtection::spkrCalibrateWait()
+void SpeakerProtection::startCalibrationWorker()
+{
+    std::lock_guard<std::mutex> lock(calEventMutex);
+
+    if (calThrdCreated || (calEvents & SPKR_CAL_EVT_EXIT))
+        return;
+
+    mCalThread = std::thread(&SpeakerProtection::spkrCalibrationThread, this);
+    calThrdCreated = true;
+    calWorkerOwner = true;
+}
+
+/* Queues a calibration request to the single calibration worker, creating
+ * the worker the first time it is needed.
+ */
+void SpeakerProtection::scheduleCalibration(uint32_t event)
+{
+    startCalibrationWorker();
+
+    std::lock_guard<std::mutex> lock(calEventMutex);
+    if (calEvents & SPKR_CAL_EVT_EXIT)
+        return;
+
+    if (!(calEvents & SPKR_CAL_EVT_PENDING))
+        clock_gettime(CLOCK_BOOTTIME, &calScheduledTime);
+    calEvents |= event;
+    calStats.numScheduled++;
+    calEventCv.notify_all();
+}
+
+/* Recalibration is only worth it when the speaker sits in a temperature
+ * band the cache has no result for, a boot or client request always is.
+ */
+bool SpeakerProtection::isCalibrationNeeded(uint32_t events)
+{
+    if (events & (SPKR_CAL_EVT_BOOT | SPKR_CAL_EVT_DYNAMIC))
+        return true;
+
+    for (int i = 0; i < numberOfChannels; i++) {
+        if (!calCache.hasBand(i, spkerTempList[i]))
+            return true;
+    }
+    return false;
+}
+
+void SpeakerProtection::getCalibratedR0T0(vi_r0t0_cfg_t r0t0Array[], int numCh)
+{
+    struct timespec start, end;
+    int32_t r0 = 0, t0 = 0;
+    uint32_t hits = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numCh; i++) {
+        if (i < SPKR_CAL_CACHE_MAX_CH && calCache.lookup(i, lastSpkrTempC[i], &r0, &t0)) {
+            r0t0Array[i].r0_cali_q24 = r0;
+            r0t0Array[i].t0_cali_q6 = t0;
+            hits++;
+        } else {
+            PAL_DBG(LOG_TAG, "Speaker %d not calibrated. Send safe value", i);
+            r0t0Array[i].r0_cali_q24 = MIN_RESISTANCE_SPKR_Q24;
+            r0t0Array[i].t0_cali_q6 = SAFE_SPKR_TEMP_Q6;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    std::lock_guard<std::mutex> lock(calEventMutex);
+    calStats.cacheHits += hits;
+    calStats.cacheMisses += numCh - hits;
+    calStats.lastLookupUs = (end.tv_sec - start.tv_sec) * 1000000LL +
+                            (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+void SpeakerProtection::getCalibrationStats(struct spkr_cal_stats *stats)
 {
-    std::unique_lock<std::mutex> lock(cvMutex);
-    cv.wait_for(lock,
-            std::chrono::milliseconds(WAKEUP_MIN_IDLE_CHECK));
+    std::lock_guard<std::mutex> lock(calEventMutex);
+    *stats = calStats;
 }
 
 // Callback from DSP for Ressistance value
@@ -950,22 +1048,41 @@ int SpeakerProtection::spkrStartCalibration()
 
     // Store the R0T0 values
     if (mDspCallbackRcvd) {
-        if (calibrationCallbackStatus == CALIBRATION_STATUS_SUCCESS) {
+        if (calibrationCallbackStatus == CALIBRATION_STATUS_SUCCESS && callback_data) {
             PAL_DBG(LOG_TAG, "Calibration is done");
-            fp = fopen(PAL_SP_TEMP_PATH, "wb");
-            if (!fp) {
-                PAL_ERR(LOG_TAG, "Unable to open file for write");
+            bool valid = true;
+            for (i = 0; i < numberOfChannels; i++) {
+                if (!SpeakerCalCache::isValid(i, spkerTempList[i] / (1 << 6),
+                                              callback_data->r0_cali_q24[i]))
+                    valid = false;
+            }
+            if (!valid) {
+                PAL_ERR(LOG_TAG, "Calibration result out of range, retry later");
+                spkrCalState = SPKR_NOT_CALIBRATED;
+                clock_gettime(CLOCK_BOOTTIME, &spkrLastTimeUsed);
             } else {
-                PAL_DBG(LOG_TAG, "Write the R0T0 value to file");
-                for (i = 0; i < numberOfChannels; i++) {
-                    fwrite(&callback_data->r0_cali_q24[i],
-                                sizeof(callback_data->r0_cali_q24[i]), 1, fp);
-                    fwrite(&spkerTempList[i], sizeof(int16_t), 1, fp);
-                }
+                for (i = 0; i < numberOfChannels; i++)
+                    calCache.update(i, spkerTempList[i] / (1 << 6),
+                                    callback_data->r0_cali_q24[i], spkerTempList[i]);
+                calCache.store();
                 spkrCalState = SPKR_CALIBRATED;
-                free(callback_data);
-                fclose(fp);
+
+                // Keep the legacy file for tools that still read it
+                fp = fopen(PAL_SP_TEMP_PATH, "wb");
+                if (!fp) {
+                    PAL_ERR(LOG_TAG, "Unable to open file for write");
+                } else {
+                    PAL_DBG(LOG_TAG, "Write the R0T0 value to file");
+                    for (i = 0; i < numberOfChannels; i++) {
+                        fwrite(&callback_data->r0_cali_q24[i],
+                                    sizeof(callback_data->r0_cali_q24[i]), 1, fp);
+                        fwrite(&spkerTempList[i], sizeof(int16_t), 1, fp);
+                    }
+                    fclose(fp);
+                }
             }
+            free(callback_data);
+            callback_data = NULL;
         }
         else if (calibrationCallbackStatus == CALIBRATION_STATUS_FAILURE) {
             PAL_DBG(LOG_TAG, "Calibration is not done");
@@ -1067,95 +1184,114 @@ void SpeakerProtection::getSpeakerTemperatureList()
     PAL_DBG(LOG_TAG, "Exit Speaker Get Temperature List");
 }
 
+/* Single calibration worker. It sleeps until an event is queued and then
+ * waits, without polling, for the speaker to be idle long enough before it
+ * samples the speaker temperature and calibrates.
+ */
 void SpeakerProtection::spkrCalibrationThread()
 {
+    std::unique_lock<std::mutex> lock(calEventMutex);
+    struct timespec start, end;
     unsigned long sec = 0;
-    bool proceed = false;
+    uint64_t calMs;
+    uint32_t events;
+    bool inRange, readFailed;
     int i;
 
-    while (!threadExit) {
-        PAL_DBG(LOG_TAG, "Inside calibration while loop");
-        proceed = false;
-        if (isSpeakerInUse(&sec)) {
-            PAL_DBG(LOG_TAG, "Speaker in use. Wait for proper time");
-            spkrCalibrateWait();
-            PAL_DBG(LOG_TAG, "Waiting done");
+    PAL_DBG(LOG_TAG, "Calibration worker started");
+    while (!(calEvents & SPKR_CAL_EVT_EXIT)) {
+        events = calEvents & SPKR_CAL_EVT_PENDING;
+        if (!events) {
+            calEventCv.wait(lock);
             continue;
         }
-        else {
-            PAL_DBG(LOG_TAG, "Speaker not in use");
-            if (isDynamicCalTriggered) {
-                PAL_DBG(LOG_TAG, "Dynamic Calibration triggered");
-            }
-            else if (sec < minIdleTime) {
-                PAL_DBG(LOG_TAG, "Speaker not idle for minimum time. %lu", sec);
-                spkrCalibrateWait();
-                PAL_DBG(LOG_TAG, "Waited for speaker to be idle for min time");
-                continue;
-            }
-            proceed = true;
+
+        if (isSpeakerInUse(&sec)) {
+            PAL_DBG(LOG_TAG, "Speaker in use. Wait for it to be released");
+            calEventCv.wait(lock);
+            continue;
         }
 
-        if (proceed) {
-            PAL_DBG(LOG_TAG, "Getting temperature of speakers");
-            getSpeakerTemperatureList();
+        if (!(events & SPKR_CAL_EVT_DYNAMIC) && sec < (unsigned long)minIdleTime) {
+            PAL_DBG(LOG_TAG, "Speaker not idle for minimum time. %lu", sec);
+            calEventCv.wait_for(lock, std::chrono::seconds(minIdleTime - sec));
+            continue;
+        }
+        lock.unlock();
 
-            for (i = 0; i < numberOfChannels; i++) {
-                if ((spkerTempList[i] != -EINVAL) &&
-                    (spkerTempList[i] < TZ_TEMP_MIN_THRESHOLD ||
-                     spkerTempList[i] > TZ_TEMP_MAX_THRESHOLD)) {
-                    PAL_ERR(LOG_TAG, "Temperature out of range. Retry");
-                    spkrCalibrateWait();
-                    continue;
-                }
-            }
-            for (i = 0; i < numberOfChannels; i++) {
-                // Converting to Q6 format
-                spkerTempList[i] = (spkerTempList[i]*(1<<6));
-            }
+        PAL_DBG(LOG_TAG, "Getting temperature of speakers");
+        getSpeakerTemperatureList();
+        inRange = true;
+        readFailed = false;
+        for (i = 0; i < numberOfChannels; i++) {
+            // a failed read is no temperature, calibrating on it would
+            // cache a result for the wrong band
+            if (spkerTempList[i] == -EINVAL)
+                readFailed = true;
+            else if (spkerTempList[i] < TZ_TEMP_MIN_THRESHOLD ||
+                spkerTempList[i] > TZ_TEMP_MAX_THRESHOLD)
+                inRange = false;
+        }
+
+        if (readFailed || !inRange) {
+            PAL_ERR(LOG_TAG, "Temperature %s. Retry",
+                    readFailed ? "read failed" : "out of range");
+            lock.lock();
+            calEventCv.wait_for(lock, std::chrono::milliseconds(SPKR_TEMP_RETRY_MS));
+            continue;
         }
-        else {
+        for (i = 0; i < numberOfChannels && i < SPKR_CAL_CACHE_MAX_CH; i++)
+            lastSpkrTempC[i] = spkerTempList[i];
+
+        if (!isCalibrationNeeded(events)) {
+            PAL_DBG(LOG_TAG, "Temperature band already calibrated");
+            lock.lock();
+            calEvents &= ~SPKR_CAL_EVT_RECAL;
             continue;
         }
 
+        for (i = 0; i < numberOfChannels; i++) {
+            // Converting to Q6 format
+            spkerTempList[i] = (spkerTempList[i]*(1<<6));
+        }
+
         // Check whether speaker was in use in the meantime when temperature
         // was being read.
-        proceed = false;
-        if (isSpeakerInUse(&sec)) {
-            PAL_DBG(LOG_TAG, "Speaker in use. Wait for proper time");
-            spkrCalibrateWait();
-            PAL_DBG(LOG_TAG, "Waiting done");
+        if (isSpkrInUse) {
+            PAL_DBG(LOG_TAG, "Speaker taken while reading temperature");
+            lock.lock();
             continue;
         }
-        else {
-            PAL_DBG(LOG_TAG, "Speaker not in use");
-            if (isDynamicCalTriggered) {
-                PAL_DBG(LOG_TAG, "Dynamic calibration triggered");
-            }
-            else if (sec < minIdleTime) {
-                PAL_DBG(LOG_TAG, "Speaker not idle for minimum time. %lu", sec);
-                spkrCalibrateWait();
-                PAL_DBG(LOG_TAG, "Waited for speaker to be idle for min time");
-                continue;
-            }
-            proceed = true;
-        }
 
-        if (proceed) {
-            // Start calibrating the speakers.
-            PAL_DBG(LOG_TAG, "Speaker not in use, start calibration");
-            spkrStartCalibration();
-            if (spkrCalState == SPKR_CALIBRATED) {
-                threadExit = true;
-            }
-        }
-        else {
-            continue;
+        PAL_DBG(LOG_TAG, "Speaker not in use, start calibration");
+        calibrationCallbackStatus = 0;
+        mDspCallbackRcvd = false;
+        clock_gettime(CLOCK_BOOTTIME, &start);
+        spkrStartCalibration();
+        clock_gettime(CLOCK_BOOTTIME, &end);
+
+        lock.lock();
+        calMs = spkrTimeDiffMs(start, end);
+        calStats.lastWaitMs = spkrTimeDiffMs(calScheduledTime, start);
+        if (spkrCalState == SPKR_CALIBRATED) {
+            calStats.numCalibrations++;
+            calStats.lastCalMs = calMs;
+            calStats.totalCalMs += calMs;
+            if (calMs > calStats.maxCalMs)
+                calStats.maxCalMs = calMs;
+            // events queued while calibrating stay pending
+            calEvents &= ~events;
+            PAL_INFO(LOG_TAG, "Calibration took %llu ms, queued for %llu ms, %u done",
+                     (unsigned long long)calMs, (unsigned long long)calStats.lastWaitMs,
+                     calStats.numCalibrations);
+        } else {
+            calStats.numFailures++;
+            PAL_ERR(LOG_TAG, "Calibration not done after %llu ms, %u failures",
+                    (unsigned long long)calMs, calStats.numFailures);
+            calEventCv.wait_for(lock, std::chrono::milliseconds(WAKEUP_MIN_IDLE_CHECK));
         }
     }
-    isDynamicCalTriggered = false;
-    calThrdCreated = false;
-    PAL_DBG(LOG_TAG, "Calibration done, exiting the thread");
+    PAL_DBG(LOG_TAG, "Calibration worker exiting");
 }
 
 SpeakerProtection::SpeakerProtection(struct pal_device *device,
@@ -1163,9 +1299,9 @@ SpeakerProtection::SpeakerProtection(struct pal_device *device,
 {
     int status = 0;
     struct pal_device_info devinfo = {};
-    FILE *fp = NULL;
 
     spkerTempList = NULL;
+    calWorkerOwner = false;
 
     if (ResourceManager::spQuickCalTime > 0 &&
         ResourceManager::spQuickCalTime < MIN_SPKR_IDLE_SEC)
@@ -1178,9 +1314,6 @@ SpeakerProtection::SpeakerProtection(struct pal_device *device,
     memset(&mDeviceAttr, 0, sizeof(struct pal_device));
     memcpy(&mDeviceAttr, device, sizeof(struct pal_device));
 
-    threadExit = false;
-    calThrdCreated = false;
-
     triggerCal = false;
     spkrCalState = SPKR_NOT_CALIBRATED;
     spkrProcessingState = SPKR_PROCESSING_IN_IDLE;
@@ -1222,16 +1355,18 @@ SpeakerProtection::SpeakerProtection(struct pal_device *device,
         goto exit;
     }
 
-    fp = fopen(PAL_SP_TEMP_PATH, "rb");
-    if (fp) {
-        PAL_DBG(LOG_TAG, "Cal File exists. Reading from it");
+    if (calCache.load() && !calCache.importLegacy(PAL_SP_TEMP_PATH, numberOfChannels))
+        calCache.store();
+
+    if (!calCache.empty()) {
+        PAL_DBG(LOG_TAG, "Calibration cache valid, using it");
         spkrCalState = SPKR_CALIBRATED;
+        // idle for recalibration of new temperature bands
+        startCalibrationWorker();
     }
     else {
         PAL_DBG(LOG_TAG, "Calibration Not done");
-        mCalThread = std::thread(&SpeakerProtection::spkrCalibrationThread,
-                            this);
-        calThrdCreated = true;
+        scheduleCalibration(SPKR_CAL_EVT_BOOT);
     }
 exit:
     PAL_DBG(LOG_TAG, "exit. calThrdCreated :%d", calThrdCreated);
@@ -1239,6 +1374,23 @@ exit:
 
 SpeakerProtection::~SpeakerProtection()
 {
+    if (calWorkerOwner) {
+        {
+            std::lock_guard<std::mutex> lock(calEventMutex);
+            calEvents |= SPKR_CAL_EVT_EXIT;
+            calEventCv.notify_all();
+        }
+        // abort a calibration waiting for the DSP
+        cv.notify_all();
+        if (mCalThread.joinable())
+            mCalThread.join();
+        // the events are shared, let the next instance start a worker
+        std::lock_guard<std::mutex> lock(calEventMutex);
+        calEvents &= ~SPKR_CAL_EVT_EXIT;
+        calThrdCreated = false;
+        calWorkerOwner = false;
+    }
+
     if (spkerTempList)
         delete[] spkerTempList;
 
@@ -1405,7 +1557,6 @@ int32_t SpeakerProtection::spkrProtProcessingMode(bool flag)
     struct vi_r0t0_cfg_t r0t0Array[numberOfChannels];
     struct agmMetaData deviceMetaData(nullptr, 0);
     struct mixer_ctl *beMetaDataMixerCtrl = nullptr;
-    FILE *fp;
     std::string backEndName, backEndNameRx, backEndNameCPS;
     std::vector <std::pair<int, int>> keyVector;
     std::vector <std::pair<int, int>> calVector;
@@ -1782,24 +1933,7 @@ int32_t SpeakerProtection::spkrProtProcessingMode(bool flag)
         }
 
         // Setting the R0T0 values
-        PAL_DBG(LOG_TAG, "Read R0T0 from file");
-        fp = fopen(PAL_SP_TEMP_PATH, "rb");
-        if (fp) {
-            for (int i = 0; i < numberOfChannels; i++) {
-                fread(&r0t0Array[i].r0_cali_q24,
-                      sizeof(r0t0Array[i].r0_cali_q24), 1, fp);
-                fread(&r0t0Array[i].t0_cali_q6,
-                      sizeof(r0t0Array[i].t0_cali_q6), 1, fp);
-            }
-            fclose(fp);
-        }
-        else {
-            PAL_DBG(LOG_TAG, "Speaker not calibrated. Send safe value");
-            for (int i = 0; i < numberOfChannels; i++) {
-                r0t0Array[i].r0_cali_q24 = MIN_RESISTANCE_SPKR_Q24;
-                r0t0Array[i].t0_cali_q6 = SAFE_SPKR_TEMP_Q6;
-            }
-        }
+        getCalibratedR0T0(r0t0Array, numberOfChannels);
         spR0T0confg = (param_id_sp_th_vi_r0t0_cfg_t *)calloc(1,
                             sizeof(param_id_sp_th_vi_r0t0_cfg_t) +
                             sizeof(vi_r0t0_cfg_t) * numberOfChannels);
@@ -2330,24 +2464,15 @@ int SpeakerProtection::speakerProtectionDynamicCal()
 
     PAL_DBG(LOG_TAG, "Enter");
 
-    if (calThrdCreated) {
-        PAL_DBG(LOG_TAG, "Calibration already triggered Thread State %d",
-                        calThrdCreated);
-        return ret;
+    {
+        std::lock_guard<std::mutex> lock(calEventMutex);
+        if (calEvents & SPKR_CAL_EVT_DYNAMIC) {
+            PAL_DBG(LOG_TAG, "Calibration already triggered");
+            return ret;
+        }
     }
 
-    threadExit = false;
-    spkrCalState = SPKR_NOT_CALIBRATED;
-
-    calibrationCallbackStatus = 0;
-    mDspCallbackRcvd = false;
-
-    calThrdCreated = true;
-    isDynamicCalTriggered = true;
-
-    std::thread dynamicCalThread(&SpeakerProtection::spkrCalibrationThread, this);
-
-    dynamicCalThread.detach();
+    scheduleCalibration(SPKR_CAL_EVT_DYNAMIC);
 
     PAL_DBG(LOG_TAG, "Exit");
 
@@ -2596,24 +2721,33 @@ int32_t SpeakerProtection::getCalibrationData(void **param)
     memset(dr0, 0, sizeof(double) * numberOfChannels);
     memset(dt0, 0, sizeof(double) * numberOfChannels);
 
-    FILE *fp = fopen(PAL_SP_TEMP_PATH, "rb");
-    if (fp) {
-        for (i = 0; i < numberOfChannels; i++) {
-            fread(&r0t0Array[i].r0_cali_q24,
-                    sizeof(r0t0Array[i].r0_cali_q24), 1, fp);
-            fread(&r0t0Array[i].t0_cali_q6,
-                    sizeof(r0t0Array[i].t0_cali_q6), 1, fp);
-            // Convert to readable format
-            dr0[i] = ((double)r0t0Array[i].r0_cali_q24)/(1 << 24);
-            dt0[i] = ((double)r0t0Array[i].t0_cali_q6)/(1 << 6);
+    int32_t r0 = 0, t0 = 0;
+    struct spkr_cal_stats stats;
+
+    for (i = 0; i < numberOfChannels; i++) {
+        // latest calibration of each speaker
+        if (!calCache.lookup(i, SPKR_CAL_TEMP_UNKNOWN, &r0, &t0)) {
+            status = -EINVAL;
+            continue;
         }
-        PAL_DBG(LOG_TAG, "R0= %lf, %lf, T0= %lf, %lf", dr0[0], dr0[1], dt0[0], dt0[1]);
-        fclose(fp);
-    }
-    else {
-        status = -EINVAL;
-        PAL_ERR(LOG_TAG, "No cal file present");
+        r0t0Array[i].r0_cali_q24 = r0;
+        r0t0Array[i].t0_cali_q6 = t0;
+        // Convert to readable format
+        dr0[i] = ((double)r0t0Array[i].r0_cali_q24)/(1 << 24);
+        dt0[i] = ((double)r0t0Array[i].t0_cali_q6)/(1 << 6);
     }
+    if (status)
+        PAL_ERR(LOG_TAG, "No calibration present");
+    else
+        PAL_DBG(LOG_TAG, "R0= %lf, %lf, T0= %lf, %lf", dr0[0], dr0[1], dt0[0], dt0[1]);
+
+    getCalibrationStats(&stats);
+    PAL_INFO(LOG_TAG, "calibrations %u failed %u scheduled %u, last %llu ms max %llu ms "
+             "total %llu ms, queued %llu ms, cache hits %u misses %u, lookup %llu us",
+             stats.numCalibrations, stats.numFailures, stats.numScheduled,
+             (unsigned long long)stats.lastCalMs, (unsigned long long)stats.maxCalMs,
+             (unsigned long long)stats.totalCalMs, (unsigned long long)stats.lastWaitMs,
+             stats.cacheHits, stats.cacheMisses, (unsigned long long)stats.lastLookupUs);
     resString << "SpkrCalStatus: " << status << "; R0: " << dr0[0] << ", "
               << dr0[1] << "; T0: "<< dt0[0] << ", " << dt0[1] << ";";
 
@@ -2662,7 +2796,6 @@ void SpeakerFeedback::updateVIcustomPayload()
     std::vector<Stream*> activeStreams;
     uint32_t miid = 0, ret = 0;
     struct vi_r0t0_cfg_t r0t0Array[numSpeaker];
-    FILE *fp = NULL;
     param_id_sp_th_vi_r0t0_cfg_t *spR0T0confg;
     param_id_sp_vi_op_mode_cfg_t modeConfg;
     param_id_sp_vi_channel_map_cfg_t viChannelMapConfg;
@@ -2721,23 +2854,7 @@ void SpeakerFeedback::updateVIcustomPayload()
         }
     }
 
-    fp = fopen(PAL_SP_TEMP_PATH, "rb");
-    if (fp) {
-        PAL_DBG(LOG_TAG, "Speaker calibrated. Send calibrated value");
-        for (int i = 0; i < numSpeaker; i++) {
-            fread(&r0t0Array[i].r0_cali_q24,
-                    sizeof(r0t0Array[i].r0_cali_q24), 1, fp);
-            fread(&r0t0Array[i].t0_cali_q6,
-                    sizeof(r0t0Array[i].t0_cali_q6), 1, fp);
-        }
-    }
-    else {
-        PAL_DBG(LOG_TAG, "Speaker not calibrated. Send safe value");
-        for (int i = 0; i < numSpeaker; i++) {
-            r0t0Array[i].r0_cali_q24 = MIN_RESISTANCE_SPKR_Q24;
-            r0t0Array[i].t0_cali_q6 = SAFE_SPKR_TEMP_Q6;
-        }
-    }
+    SpeakerProtection::getCalibratedR0T0(r0t0Array, numSpeaker);
     spR0T0confg = (param_id_sp_th_vi_r0t0_cfg_t *)calloc(1,
                         sizeof(param_id_sp_th_vi_r0t0_cfg_t) +
                         sizeof(vi_r0t0_cfg_t) * numSpeaker);
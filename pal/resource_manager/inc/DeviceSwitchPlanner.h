@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef DEVICE_SWITCH_PLANNER_H
+#define DEVICE_SWITCH_PLANNER_H
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <functional>
+
+typedef enum {
+    SWITCH_STEP_DISCONNECT = 0,
+    SWITCH_STEP_CONNECT,
+} switch_step_type_t;
+
+/* One stream <-> device transition of a device switch. The stream is kept
+ * opaque so that the planner can be driven by a simulated mixer as well.
+ */
+struct switch_step {
+    switch_step_type_t type;
+    void *stream;
+    uint32_t devId;
+    std::string backEnd;
+    void *cookie;          /* caller data, e.g. struct pal_device * for connect */
+    uint32_t group;        /* independent group this step belongs to */
+    int32_t status;
+    bool executed;
+    uint64_t startUs;      /* relative to start of execute() */
+    uint64_t durationUs;
+};
+
+struct switch_plan_stats {
+    uint32_t numSteps;
+    uint32_t numGroups;
+    uint64_t totalUs;      /* wall clock time of execute() */
+    uint64_t sumStepUs;
+    uint64_t maxStepUs;
+};
+
+/* Executes the steps of a device switch and records what each one cost.
+ *
+ * Steps run serially, all disconnects before all connects, each in the
+ * order they were added, as the switch always did. plan() also splits them
+ * into groups: two steps belong to the same group when they share a stream
+ * or a backend. The groups only show up in the stats for now, steps of
+ * different groups still share resource manager state.
+ */
+class DeviceSwitchPlanner
+{
+public:
+    typedef std::function<int32_t(struct switch_step &step)> StepExecutor;
+
+    DeviceSwitchPlanner();
+    void addStep(switch_step_type_t type, void *stream, uint32_t devId,
+                 const std::string &backEnd, void *cookie);
+    /* status returned by a connect step that should not abort its group */
+    void setConnectContinueStatus(int32_t status) { connectContinueStatus = status; };
+    uint32_t plan();
+    int32_t execute(StepExecutor exec);
+    const std::vector<struct switch_step> &getSteps() { return steps; };
+    void getStats(struct switch_plan_stats *stats);
+    void dumpStats();
+
+private:
+    uint32_t findRoot(std::vector<uint32_t> &parent, uint32_t i);
+
+    std::vector<struct switch_step> steps;
+    uint32_t numGroups;
+    int32_t connectContinueStatus;
+    uint64_t totalUs;
+    bool planned;
+};
+
+#endif
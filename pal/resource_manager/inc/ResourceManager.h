@@ -86,6 +86,7 @@
 #include "ContextManager.h"
 #include "SoundTriggerPlatformInfo.h"
 #include "SignalHandler.h"
+#include "DeviceSwitchPlanner.h"
 
 typedef enum {
     RX_HOSTLESS = 1,
@@ -480,6 +481,8 @@ private:
     int32_t streamDevConnect(std::vector <std::tuple<Stream *, struct pal_device *>> streamDevConnectList);
     int32_t streamDevDisconnect_l(std::vector <std::tuple<Stream *, uint32_t>> streamDevDisconnectList);
     int32_t streamDevConnect_l(std::vector <std::tuple<Stream *, struct pal_device *>> streamDevConnectList);
+    int32_t streamDevSwitch_l(std::vector <std::tuple<Stream *, uint32_t>> &streamDevDisconnectList,
+                              std::vector <std::tuple<Stream *, struct pal_device *>> &streamDevConnectList);
     void ssrHandlingLoop(std::shared_ptr<ResourceManager> rm);
     int updateECDeviceMap(std::shared_ptr<Device> rx_dev,
                         std::shared_ptr<Device> tx_dev,
@@ -637,6 +640,7 @@ public:
     static bool isDeviceMuxConfigEnabled;
     static bool isUHQAEnabled;
     static bool isSignalHandlerEnabled;
+    /* Workers for device switch steps, always 1 until the steps are thread safe */
     static std::mutex mChargerBoostMutex;
     /* Variable to store which speaker side is being used for call audio.
      * Valid for Stereo case only
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: DeviceSwitchPlanner"
+#include <errno.h>
+#include <time.h>
+#include <map>
+#include "DeviceSwitchPlanner.h"
+#include "PalCommon.h"
+
+static uint64_t getMonotonicUs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+DeviceSwitchPlanner::DeviceSwitchPlanner()
+{
+    numGroups = 0;
+    connectContinueStatus = 0;
+    totalUs = 0;
+    planned = false;
+}
+
+void DeviceSwitchPlanner::addStep(switch_step_type_t type, void *stream, uint32_t devId,
+                                  const std::string &backEnd, void *cookie)
+{
+    struct switch_step step = {};
+
+    step.type = type;
+    step.stream = stream;
+    step.devId = devId;
+    step.backEnd = backEnd;
+    step.cookie = cookie;
+    steps.push_back(step);
+    planned = false;
+}
+
+uint32_t DeviceSwitchPlanner::findRoot(std::vector<uint32_t> &parent, uint32_t i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+uint32_t DeviceSwitchPlanner::plan()
+{
+    std::vector<uint32_t> parent(steps.size());
+    std::map<void *, uint32_t> streamOwner;
+    std::map<std::string, uint32_t> backEndOwner;
+    std::map<uint32_t, uint32_t> rootToGroup;
+
+    for (uint32_t i = 0; i < steps.size(); i++)
+        parent[i] = i;
+
+    /* steps sharing a stream or a backend must stay ordered */
+    for (uint32_t i = 0; i < steps.size(); i++) {
+        auto sIter = streamOwner.find(steps[i].stream);
+        if (sIter == streamOwner.end())
+            streamOwner[steps[i].stream] = i;
+        else
+            parent[findRoot(parent, i)] = findRoot(parent, sIter->second);
+
+        if (steps[i].backEnd.empty())
+            continue;
+        auto bIter = backEndOwner.find(steps[i].backEnd);
+        if (bIter == backEndOwner.end())
+            backEndOwner[steps[i].backEnd] = i;
+        else
+            parent[findRoot(parent, i)] = findRoot(parent, bIter->second);
+    }
+
+    for (uint32_t i = 0; i < steps.size(); i++) {
+        uint32_t root = findRoot(parent, i);
+        auto gIter = rootToGroup.find(root);
+        if (gIter == rootToGroup.end()) {
+            steps[i].group = rootToGroup.size();
+            rootToGroup[root] = steps[i].group;
+        } else {
+            steps[i].group = gIter->second;
+        }
+    }
+
+    numGroups = rootToGroup.size();
+    planned = true;
+    PAL_DBG(LOG_TAG, "%zu steps in %d groups", steps.size(), numGroups);
+    return numGroups;
+}
+
+int32_t DeviceSwitchPlanner::execute(StepExecutor exec)
+{
+    int32_t status = 0;
+    std::vector<uint32_t> order;
+    uint64_t epochUs, start;
+
+    if (!planned)
+        plan();
+
+    /* legacy ordering: every disconnect, then every connect */
+    for (uint32_t i = 0; i < steps.size(); i++) {
+        if (steps[i].type == SWITCH_STEP_DISCONNECT)
+            order.push_back(i);
+    }
+    for (uint32_t i = 0; i < steps.size(); i++) {
+        if (steps[i].type == SWITCH_STEP_CONNECT)
+            order.push_back(i);
+    }
+
+    epochUs = getMonotonicUs();
+    for (auto idx : order) {
+        struct switch_step &step = steps[idx];
+
+        start = getMonotonicUs();
+        step.status = exec(step);
+        step.executed = true;
+        step.startUs = start - epochUs;
+        step.durationUs = getMonotonicUs() - start;
+        if (step.status) {
+            PAL_ERR(LOG_TAG, "group %d %s of stream %pK device %d failed %d", step.group,
+                    step.type == SWITCH_STEP_CONNECT ? "connect" : "disconnect",
+                    step.stream, step.devId, step.status);
+            if (!status)
+                status = step.status;
+            if (step.type == SWITCH_STEP_CONNECT && step.status == connectContinueStatus)
+                continue;
+            break;
+        }
+    }
+    totalUs = getMonotonicUs() - epochUs;
+    return status;
+}
+
+void DeviceSwitchPlanner::getStats(struct switch_plan_stats *stats)
+{
+    if (!stats)
+        return;
+
+    stats->numSteps = steps.size();
+    stats->numGroups = numGroups;
+    stats->totalUs = totalUs;
+    stats->sumStepUs = 0;
+    stats->maxStepUs = 0;
+    for (auto &step : steps) {
+        stats->sumStepUs += step.durationUs;
+        if (step.durationUs > stats->maxStepUs)
+            stats->maxStepUs = step.durationUs;
+    }
+}
+
+void DeviceSwitchPlanner::dumpStats()
+{
+    struct switch_plan_stats stats;
+
+    getStats(&stats);
+    PAL_DBG(LOG_TAG, "device switch: %d steps in %d groups, total %llu us, longest step %llu us",
+            stats.numSteps, stats.numGroups,
+            (unsigned long long)stats.totalUs, (unsigned long long)stats.maxStepUs);
+    for (auto &step : steps) {
+        if (!step.executed)
+            continue;
+        PAL_VERBOSE(LOG_TAG, "  group %d %s stream %pK dev %d be %s start %llu us took %llu us status %d",
+                step.group, step.type == SWITCH_STEP_CONNECT ? "connect" : "disconnect",
+                step.stream, step.devId, step.backEnd.c_str(),
+                (unsigned long long)step.startUs, (unsigned long long)step.durationUs,
+                step.status);
+    }
+}
@@ -7184,6 +7184,59 @@ error:
 }
 
 
+/* Caller must hold mActiveStreamMutex and the mutexes of all involved streams.
+ * The steps run serially, in the legacy order of all disconnects followed
+ * by all connects. The planner logs the groups it finds, but steps of
+ * different groups are not independent yet: they walk and update active_devices
+ * without mResourceManagerMutex, EC and duty cycle setup couple RX and TX
+ * backends across groups, and lockGraph serializes most of their cost.
+ */
+int32_t ResourceManager::streamDevSwitch_l(std::vector <std::tuple<Stream *, uint32_t>> &streamDevDisconnectList,
+                                           std::vector <std::tuple<Stream *, struct pal_device *>> &streamDevConnectList)
+{
+    int32_t status = 0;
+    DeviceSwitchPlanner planner;
+    std::string backEndName;
+    Stream *s = NULL;
+
+    for (auto &elem : streamDevDisconnectList) {
+        s = std::get<0>(elem);
+        if ((s == NULL) || !isStreamActive(s, mActiveStreams))
+            continue;
+        backEndName.clear();
+        getBackendName(std::get<1>(elem), backEndName);
+        planner.addStep(SWITCH_STEP_DISCONNECT, s, std::get<1>(elem), backEndName, NULL);
+    }
+
+    for (auto &elem : streamDevConnectList) {
+        s = std::get<0>(elem);
+        if ((s == NULL) || !isStreamActive(s, mActiveStreams))
+            continue;
+        backEndName.clear();
+        getBackendName(std::get<1>(elem)->id, backEndName);
+        planner.addStep(SWITCH_STEP_CONNECT, s, std::get<1>(elem)->id, backEndName,
+                        std::get<1>(elem));
+    }
+
+    /* If connectStreamDevice_l failed during SSR down state, allow all other active
+     * streams to pass through connectStreamDevice_l() so that associated device will be
+     * pushed to the streams. When SSR is up streams will be routed to device properly
+     */
+    planner.setConnectContinueStatus(-ENETRESET);
+    planner.plan();
+
+    status = planner.execute([](struct switch_step &step) -> int32_t {
+        Stream *str = (Stream *)step.stream;
+
+        if (step.type == SWITCH_STEP_DISCONNECT)
+            return str->disconnectStreamDevice_l(str, (pal_device_id_t)step.devId);
+        return str->connectStreamDevice_l(str, (struct pal_device *)step.cookie);
+    });
+    planner.dumpStats();
+
+    return status;
+}
+
 template <class T>
 void SortAndUnique(std::vector<T> &streams)
 {
@@ -7279,17 +7332,11 @@ int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint3
         }
     }
 
-    status = streamDevDisconnect_l(streamDevDisconnectList);
+    status = streamDevSwitch_l(streamDevDisconnectList, streamDevConnectList);
     if (status) {
-        PAL_ERR(LOG_TAG, "disconnect failed");
-        goto exit;
-    }
-    status = streamDevConnect_l(streamDevConnectList);
-    if (status) {
-        PAL_ERR(LOG_TAG, "Connect failed");
+        PAL_ERR(LOG_TAG, "device switch failed");
     }
 
-exit:
     // unlock all stream mutexes
     for (sIter = uniqueStreamsList.begin(); sIter != uniqueStreamsList.end(); sIter++) {
         PAL_DBG(LOG_TAG, "uniqueStreamsList stream %pK unlock", (*sIter));
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/* Validates DeviceSwitchPlanner against a simulated mixer. Every backend of
+ * the simulated mixer takes a fixed time to (dis)connect and flags an error
+ * if two steps touch it at the same time or if a stream is connected before
+ * it was disconnected. The groups found by plan() are checked as well.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <map>
+#include <set>
+#include <atomic>
+#include <mutex>
+#include "DeviceSwitchPlanner.h"
+#include "PalCommon.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define STEP_COST_US 2000
+
+class SimulatedMixer
+{
+public:
+    SimulatedMixer() : violations(0) {};
+
+    int32_t apply(struct switch_step &step)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mixerMutex);
+            if (busyBackEnds.count(step.backEnd)) {
+                printf("  violation: backend %s used concurrently\n", step.backEnd.c_str());
+                violations++;
+            }
+            busyBackEnds.insert(step.backEnd);
+            if (step.type == SWITCH_STEP_CONNECT && connected.count(step.stream)) {
+                printf("  violation: stream %p connected before disconnect\n", step.stream);
+                violations++;
+            }
+            if (step.type == SWITCH_STEP_DISCONNECT)
+                connected.erase(step.stream);
+            else
+                connected.insert(step.stream);
+        }
+
+        usleep(STEP_COST_US);
+
+        {
+            std::unique_lock<std::mutex> lock(mixerMutex);
+            busyBackEnds.erase(step.backEnd);
+        }
+        return failStream.count(step.stream) ? -EIO : 0;
+    }
+
+    void connect(void *stream) { connected.insert(stream); };
+    std::set<void *> failStream;
+    std::atomic<uint32_t> violations;
+
+private:
+    std::mutex mixerMutex;
+    std::multiset<std::string> busyBackEnds;
+    std::set<void *> connected;
+};
+
+static const char *backEnds[] = {
+    "CODEC_DMA-LPAIF_WSA-RX-0",
+    "CODEC_DMA-LPAIF_RXTX-RX-0",
+    "CODEC_DMA-LPAIF_VA-TX-0",
+    "CODEC_DMA-LPAIF_RXTX-TX-3",
+    "DISPLAY_PORT-RX-0",
+    "USB_AUDIO-RX",
+};
+
+/* Moves numStreams streams from one backend to another. With spread set the
+ * streams are spread across backend pairs so that independent groups exist.
+ */
+static int runCase(const char *name, uint32_t numStreams, bool spread,
+                   bool injectFailure, uint32_t expectedGroups)
+{
+    SimulatedMixer mixer;
+    DeviceSwitchPlanner planner;
+    struct switch_plan_stats stats;
+    uintptr_t stream;
+    uint32_t pair;
+    int32_t status;
+    int ret = 0;
+
+    for (uint32_t i = 0; i < numStreams; i++) {
+        stream = 0x1000 + i;
+        pair = spread ? (i % 3) * 2 : 0;
+        mixer.connect((void *)stream);
+        planner.addStep(SWITCH_STEP_DISCONNECT, (void *)stream, pair, backEnds[pair], NULL);
+    }
+    for (uint32_t i = 0; i < numStreams; i++) {
+        stream = 0x1000 + i;
+        pair = spread ? (i % 3) * 2 : 0;
+        planner.addStep(SWITCH_STEP_CONNECT, (void *)stream, pair + 1, backEnds[pair + 1], NULL);
+    }
+    if (injectFailure)
+        mixer.failStream.insert((void *)0x1000);
+
+    planner.plan();
+    status = planner.execute([&mixer](struct switch_step &step) -> int32_t {
+        return mixer.apply(step);
+    });
+    planner.getStats(&stats);
+
+    printf("%-28s steps %3d groups %2d total %6llu us longest step %6llu us\n",
+           name, stats.numSteps, stats.numGroups,
+           (unsigned long long)stats.totalUs, (unsigned long long)stats.maxStepUs);
+
+    if (mixer.violations) {
+        printf("  FAIL: %d ordering violations\n", mixer.violations.load());
+        ret = -1;
+    }
+    if (stats.numGroups != expectedGroups) {
+        printf("  FAIL: %d groups, expected %d\n", stats.numGroups, expectedGroups);
+        ret = -1;
+    }
+    if (injectFailure && status != -EIO) {
+        printf("  FAIL: failure not reported, status %d\n", status);
+        ret = -1;
+    }
+    if (!injectFailure && status) {
+        printf("  FAIL: unexpected status %d\n", status);
+        ret = -1;
+    }
+    return ret;
+}
+
+int main()
+{
+    int ret = 0;
+
+    ret |= runCase("shared-backend", 6, false, false, 1);
+    ret |= runCase("spread", 12, true, false, 3);
+    ret |= runCase("spread-failure", 12, true, true, 3);
+
+    printf("%s\n", ret ? "FAILED" : "PASSED");
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/* Validates SpeakerCalCache band lookup, validation and persistence, and
+ * times the R0T0 lookup done at playback start against reading the legacy
+ * calibration file.
+ *
+ * usage: PalSpeakerCalCacheTest [work_dir]
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "SpeakerCalCache.h"
+#include "PalCommon.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define LOOKUP_ITERATIONS 10000
+#define R0_Q24(ohm) ((int32_t)((ohm) * (1 << 24)))
+#define T0_Q6(c) ((c) * (1 << 6))
+
+#define CHECK(cond, msg) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAIL: %s\n", msg); \
+            ret = -1; \
+        } \
+    } while (0)
+
+static uint64_t nowUs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static int testBands()
+{
+    SpeakerCalCache cache("/dev/null");
+    int32_t r0 = 0, t0 = 0;
+    int ret = 0;
+
+    CHECK(SpeakerCalCache::tempToBand(-40) == 0, "band below range");
+    CHECK(SpeakerCalCache::tempToBand(22) == SpeakerCalCache::tempToBand(24), "same band");
+    CHECK(SpeakerCalCache::tempToBand(24) != SpeakerCalCache::tempToBand(25), "band edge");
+    CHECK(SpeakerCalCache::tempToBand(200) == SPKR_CAL_NUM_BANDS - 1, "band above range");
+
+    CHECK(!cache.update(0, 25, R0_Q24(1), T0_Q6(25)), "accepted R0 below range");
+    CHECK(!cache.update(0, 25, R0_Q24(50), T0_Q6(25)), "accepted R0 above range");
+    CHECK(!cache.update(0, 95, R0_Q24(8), T0_Q6(95)), "accepted temp above range");
+    CHECK(!cache.update(SPKR_CAL_CACHE_MAX_CH, 25, R0_Q24(8), T0_Q6(25)), "accepted channel");
+    CHECK(cache.empty(), "invalid results cached");
+
+    CHECK(cache.update(0, 25, R0_Q24(8), T0_Q6(25)), "rejected valid result");
+    CHECK(cache.update(1, 25, R0_Q24(7), T0_Q6(25)), "rejected valid result");
+    CHECK(cache.hasBand(0, 27) && !cache.hasBand(0, 35), "hasBand");
+
+    CHECK(cache.lookup(0, 26, &r0, &t0) && r0 == R0_Q24(8), "exact band lookup");
+    CHECK(cache.lookup(1, SPKR_CAL_TEMP_UNKNOWN, &r0, &t0) && r0 == R0_Q24(7),
+          "unknown temperature lookup");
+    /* no result for the band, falls back to the latest one of the speaker */
+    CHECK(cache.lookup(0, 50, &r0, &t0) && r0 == R0_Q24(8), "fallback lookup");
+    CHECK(!cache.lookup(2, 25, &r0, &t0), "lookup of uncalibrated speaker");
+
+    printf("%-28s %s\n", "bands", ret ? "FAILED" : "ok");
+    return ret;
+}
+
+static int testPersistence(const std::string &dir)
+{
+    std::string path = dir + "/spkr_cal_cache.bin";
+    std::string legacy = dir + "/spkr_audio.cal";
+    SpeakerCalCache cache(path);
+    SpeakerCalCache loaded(path);
+    int32_t r0 = 0, t0 = 0;
+    int16_t t0Legacy;
+    FILE *fp;
+    int ret = 0;
+
+    cache.update(0, 20, R0_Q24(8), T0_Q6(20));
+    cache.update(0, 40, R0_Q24(9), T0_Q6(40));
+    cache.update(1, 20, R0_Q24(6), T0_Q6(20));
+    CHECK(cache.store() == 0, "store");
+    CHECK(loaded.load() == 0, "load");
+    CHECK(loaded.lookup(0, 41, &r0, &t0) && r0 == R0_Q24(9) && t0 == T0_Q6(40),
+          "persisted band");
+    CHECK(loaded.lookup(1, 21, &r0, &t0) && r0 == R0_Q24(6), "persisted speaker");
+
+    /* a corrupted cache must not be used */
+    fp = fopen(path.c_str(), "r+b");
+    if (fp) {
+        fseek(fp, -3, SEEK_END);
+        fputc(0x5a, fp);
+        fclose(fp);
+    }
+    loaded.clear();
+    CHECK(loaded.load() == -EINVAL && loaded.empty(), "corrupted cache loaded");
+
+    /* legacy file holds R0 as int32 followed by T0 as int16 per speaker */
+    fp = fopen(legacy.c_str(), "wb");
+    if (fp) {
+        r0 = R0_Q24(8);
+        t0Legacy = T0_Q6(30);
+        fwrite(&r0, sizeof(r0), 1, fp);
+        fwrite(&t0Legacy, sizeof(t0Legacy), 1, fp);
+        r0 = R0_Q24(1);
+        fwrite(&r0, sizeof(r0), 1, fp);
+        fwrite(&t0Legacy, sizeof(t0Legacy), 1, fp);
+        fclose(fp);
+    }
+    loaded.clear();
+    CHECK(loaded.importLegacy(legacy, 2) == 0, "legacy import");
+    CHECK(loaded.hasBand(0, 30), "legacy result imported");
+    CHECK(!loaded.lookup(1, 30, &r0, &t0), "invalid legacy result imported");
+
+    unlink(path.c_str());
+    unlink(legacy.c_str());
+    printf("%-28s %s\n", "persistence", ret ? "FAILED" : "ok");
+    return ret;
+}
+
+static int benchLookup(const std::string &dir)
+{
+    std::string legacy = dir + "/spkr_audio.cal";
+    SpeakerCalCache cache("/dev/null");
+    int32_t r0 = R0_Q24(8), r0Read = 0, t0 = 0;
+    int16_t t0Legacy = T0_Q6(30);
+    uint64_t start, cacheUs, fileUs;
+    FILE *fp;
+
+    for (int ch = 0; ch < 2; ch++)
+        cache.update(ch, 30, r0, t0Legacy);
+    fp = fopen(legacy.c_str(), "wb");
+    if (!fp)
+        return -1;
+    for (int ch = 0; ch < 2; ch++) {
+        fwrite(&r0, sizeof(r0), 1, fp);
+        fwrite(&t0Legacy, sizeof(t0Legacy), 1, fp);
+    }
+    fclose(fp);
+
+    start = nowUs();
+    for (int i = 0; i < LOOKUP_ITERATIONS; i++) {
+        for (int ch = 0; ch < 2; ch++)
+            cache.lookup(ch, 31, &r0Read, &t0);
+    }
+    cacheUs = nowUs() - start;
+
+    start = nowUs();
+    for (int i = 0; i < LOOKUP_ITERATIONS; i++) {
+        fp = fopen(legacy.c_str(), "rb");
+        if (!fp)
+            break;
+        for (int ch = 0; ch < 2; ch++) {
+            if (fread(&r0Read, sizeof(r0Read), 1, fp) != 1 ||
+                fread(&t0Legacy, sizeof(t0Legacy), 1, fp) != 1)
+                break;
+        }
+        fclose(fp);
+    }
+    fileUs = nowUs() - start;
+
+    unlink(legacy.c_str());
+    printf("%-28s cache %.3f us file %.3f us per playback start\n", "R0T0 lookup",
+           (double)cacheUs / LOOKUP_ITERATIONS, (double)fileUs / LOOKUP_ITERATIONS);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "/data/local/tmp";
+    int ret = 0;
+
+    ret |= testBands();
+    ret |= testPersistence(dir);
+    ret |= benchLookup(dir);
+
+    printf("%s\n", ret ? "FAILED" : "PASSED");
+    return ret ? 1 : 0;
+}
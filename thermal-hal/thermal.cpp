@@ -260,6 +260,20 @@ Return<void> Thermal::unregisterThermalChangedCallback(
 	return Void();
 }
 
+Return<void> Thermal::debug(const hidl_handle& handle,
+				const hidl_vec<hidl_string>& options)
+{
+	if (handle == nullptr || handle->numFds < 1 || handle->data[0] < 0) {
+		LOG(ERROR) << "Invalid debug handle";
+		return Void();
+	}
+	if (!utils.isSensorInitialized())
+		return Void();
+	utils.dumpSensors(handle->data[0]);
+
+	return Void();
+}
+
 void Thermal::sendThrottlingChangeCB(const Temperature &t)
 {
 	std::lock_guard<std::mutex> _lock(thermal_cb_mutex);
@@ -101,6 +101,8 @@ class Thermal : public IThermal {
 				bool filterType,
 				CoolingType type,
 				getCurrentCoolingDevices_cb _hidl_cb) override;
+		Return<void> debug(const hidl_handle& handle,
+				const hidl_vec<hidl_string>& options) override;
 
 		void sendThrottlingChangeCB(const Temperature &t);
 
@@ -32,6 +32,8 @@
 #include <cinttypes>
 #include <string>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <unordered_map>
 #include <fstream>
 
@@ -55,6 +57,12 @@
 #define CDEV_CUR_STATE_PATH	"/sys/class/thermal/cooling_device%d/cur_state"
 #define CPU_USAGE_FILE		"/proc/stat"
 #define CPU_ONLINE_FILE_FORMAT	"/sys/devices/system/cpu/cpu%d/online"
+#define CPU_USAGE_BUF_SIZE	4096
+/* Samples closer together than this are not added to the ring */
+#define SAMPLE_MIN_GAP_MS	100
+/* Samples older than this are left out of the rate estimate */
+#define SLOPE_WINDOW_MS		10000
+#define SLOPE_MIN_SAMPLES	3
 
 namespace android {
 namespace hardware {
@@ -109,7 +117,13 @@ static std::unordered_map<std::string, cdevType> cdev_map = {
 	{"battery", cdevType::BATTERY},
 };
 
-ThermalCommon::ThermalCommon()
+ThermalCommon::ThermalCommon(const std::string& root, int snapshot_window_ms):
+	root(root),
+	snapshot_window(snapshot_window_ms),
+	snapshot_valid(false),
+	batt_tzn(-1),
+	predict_lead_ms(0),
+	notify_hold_ms(0)
 {
 	LOG(DEBUG) << "Entering " << __func__;
 	ncpus = (int)sysconf(_SC_NPROCESSORS_CONF);
@@ -117,6 +131,12 @@ ThermalCommon::ThermalCommon()
 		LOG(ERROR) << "Error retrieving number of cores";
 }
 
+ThermalCommon::~ThermalCommon()
+{
+	for (auto& it: fds)
+		close(it.second);
+}
+
 static int writeToFile(std::string_view path, std::string data)
 {
 	std::fstream outFile;
@@ -171,7 +191,63 @@ int ThermalCommon::readFromFile(std::string_view path, std::string& out)
 	return readLineFromFile(path, out);
 }
 
-static int get_tzn(std::string sensor_name)
+/* Returns the persistent fd of a sysfs or procfs node, opening it on first use */
+int ThermalCommon::getFd(const char *path)
+{
+	std::lock_guard<std::mutex> _lock(fd_mutex);
+	auto it = fds.find(path);
+	int fd;
+
+	if (it != fds.end())
+		return it->second;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		fd = -errno;
+		LOG(ERROR) << "Path:" << path << " file open error.err:"
+			<< strerror(-fd) << std::endl;
+		return fd;
+	}
+	fds[path] = fd;
+
+	return fd;
+}
+
+/* Reads the integer a node holds, returns the bytes read or <= 0 on error */
+int ThermalCommon::readNode(const char *path, long *val)
+{
+	char buf[MAX_LENGTH];
+	char *end;
+	ssize_t rv;
+	int fd, ct = 0;
+
+	fd = getFd(path);
+	if (fd < 0)
+		return fd;
+
+	do {
+		rv = pread(fd, buf, sizeof(buf) - 1, 0);
+		if (rv <= 0) {
+			LOG(ERROR) << "Path:" << path << " read error.err:"
+				<< (rv ? strerror(errno) : "empty") << std::endl;
+			return rv ? -errno : 0;
+		}
+		buf[rv] = '\0';
+		errno = 0;
+		*val = strtol(buf, &end, 0);
+		if (end != buf && !errno) {
+			LOG(DEBUG) << "Path:" << path << " Val:" << *val << std::endl;
+			return (int)rv;
+		}
+		LOG(ERROR) << "Path:" << path << " parse error buf:" << buf
+			<< std::endl;
+		ct++;
+	} while (ct < RETRY_CT);
+
+	return -EINVAL;
+}
+
+static int get_tzn(const std::string& root, std::string sensor_name)
 {
 	DIR *tdir = NULL;
 	struct dirent *tdirent = NULL;
@@ -180,19 +256,20 @@ static int get_tzn(std::string sensor_name)
 	char name[MAX_PATH] = {0};
 	char cwd[MAX_PATH] = {0};
 	int ret = 0;
+	std::string sysfs = root + THERMAL_SYSFS;
 
 	if (!getcwd(cwd, sizeof(cwd)))
 		return found;
 
 	/* Change dir to read the entries. Doesnt work otherwise */
-	ret = chdir(THERMAL_SYSFS);
+	ret = chdir(sysfs.c_str());
 	if (ret) {
-		LOG(ERROR) << "Unable to change to " << THERMAL_SYSFS << std::endl;
+		LOG(ERROR) << "Unable to change to " << sysfs << std::endl;
 		return found;
 	}
-	tdir = opendir(THERMAL_SYSFS);
+	tdir = opendir(sysfs.c_str());
 	if (!tdir) {
-		LOG(ERROR) << "Unable to open " << THERMAL_SYSFS << std::endl;
+		LOG(ERROR) << "Unable to open " << sysfs << std::endl;
 		return found;
 	}
 
@@ -203,7 +280,7 @@ static int get_tzn(std::string sensor_name)
 			strlen(TZ_DIR_NAME)) != 0)
 			continue;
 
-		snprintf(name, MAX_PATH, "%s%s/%s", THERMAL_SYSFS,
+		snprintf(name, MAX_PATH, "%s%s/%s", sysfs.c_str(),
 				tdirent->d_name, TZ_TYPE);
 		ret = readLineFromFile(std::string_view(name), buf);
 		if (ret <= 0) {
@@ -238,7 +315,7 @@ int ThermalCommon::initialize_sensor(struct target_therm_cfg& cfg, int sens_idx)
 	struct therm_sensor sensor;
 	int idx = 0;
 
-	sensor.tzn = get_tzn(cfg.sensor_list[sens_idx]);
+	sensor.tzn = get_tzn(root, cfg.sensor_list[sens_idx]);
 	if (sensor.tzn < 0) {
 		LOG(ERROR) << "No thermal zone for sensor: " <<
 			cfg.sensor_list[sens_idx] << ", ret:" <<
@@ -259,7 +336,11 @@ int ThermalCommon::initialize_sensor(struct target_therm_cfg& cfg, int sens_idx)
 	sensor.sensor_name = cfg.sensor_list[sens_idx];
 	sensor.positiveThresh = cfg.positive_thresh_ramp;
 	sensor.lastThrottleStatus = sensor.t.throttlingStatus =
-		ThrottlingSeverity::NONE;
+		sensor.measuredStatus = ThrottlingSeverity::NONE;
+	sensor.sampleHead = sensor.sampleCount = 0;
+	sensor.slope = UNKNOWN_TEMPERATURE;
+	sensor.dropSince = -1;
+	sensor.notifyCount = sensor.coalesceCount = 0;
 	sensor.thresh.type = sensor.t.type = cfg.type;
 	sensor.thresh.vrThrottlingThreshold =
 	UNKNOWN_TEMPERATURE;
@@ -286,7 +367,12 @@ int ThermalCommon::initialize_sensor(struct target_therm_cfg& cfg, int sens_idx)
 	if (cfg.vr_thresh != 0)
 		sensor.thresh.vrThrottlingThreshold =
 			cfg.vr_thresh / (float)sensor.mulFactor;
+
+	std::lock_guard<std::mutex> _lock(snapshot_mutex);
+	if (cfg.type == TemperatureType::SKIN && batt_tzn < 0)
+		batt_tzn = get_tzn(root, "batt-therm");
 	sens.push_back(sensor);
+	snapshot_valid = false;
 	//read_temperature((struct therm_sensor *)sensor);
 
 	return 0;
@@ -336,19 +422,20 @@ int ThermalCommon::initCdev()
 	char name[MAX_PATH] = {0};
 	char cwd[MAX_PATH] = {0};
 	int ret = 0;
+	std::string sysfs = root + THERMAL_SYSFS;
 
 	if (!getcwd(cwd, sizeof(cwd)))
 		return 0;
 
 	/* Change dir to read the entries. Doesnt work otherwise */
-	ret = chdir(THERMAL_SYSFS);
+	ret = chdir(sysfs.c_str());
 	if (ret) {
-		LOG(ERROR) << "Unable to change to " << THERMAL_SYSFS << std::endl;
+		LOG(ERROR) << "Unable to change to " << sysfs << std::endl;
 		return 0;
 	}
-	tdir = opendir(THERMAL_SYSFS);
+	tdir = opendir(sysfs.c_str());
 	if (!tdir) {
-		LOG(ERROR) << "Unable to open " << THERMAL_SYSFS << std::endl;
+		LOG(ERROR) << "Unable to open " << sysfs << std::endl;
 		return 0;
 	}
 
@@ -362,7 +449,7 @@ int ThermalCommon::initCdev()
 			strlen(CDEV_DIR_NAME)) != 0)
 			continue;
 
-		snprintf(name, MAX_PATH, "%s%s/%s", THERMAL_SYSFS,
+		snprintf(name, MAX_PATH, "%s%s/%s", sysfs.c_str(),
 				tdirent->d_name, TZ_TYPE);
 		ret = readLineFromFile(std::string_view(name), buf);
 		if (ret <= 0) {
@@ -393,47 +480,35 @@ int ThermalCommon::initCdev()
 int ThermalCommon::read_cdev_state(struct therm_cdev& cdev)
 {
 	char file_name[MAX_PATH];
-	std::string buf;
-	int ret = 0, ct = 0;
-	bool read_ok = false;
+	long val;
+	int ret = 0;
 
-	snprintf(file_name, sizeof(file_name), CDEV_CUR_STATE_PATH,
-			cdev.cdevn);
-	do {
-		ret = readLineFromFile(std::string(file_name), buf);
-		if (ret <= 0) {
-			LOG(ERROR) << "Cdev state read error:"<< ret <<
-				" for cdev: " << cdev.c.name;
-			return -1;
-		}
-		try {
-			cdev.c.value = std::stoi(buf, nullptr, 0);
-			read_ok = true;
-		}
-		catch (std::exception &err) {
-			LOG(ERROR) << "Cdev read stoi error:" << err.what()
-				<< " cdev:" << cdev.c.name << " ID:"
-				<< cdev.cdevn << " buf:" << buf <<
-				std::endl;
-		}
-		ct++;
-	} while (!read_ok && ct < RETRY_CT);
+	snprintf(file_name, sizeof(file_name), "%s" CDEV_CUR_STATE_PATH,
+			root.c_str(), cdev.cdevn);
+	ret = readNode(file_name, &val);
+	if (ret <= 0) {
+		LOG(ERROR) << "Cdev state read error:"<< ret <<
+			" for cdev: " << cdev.c.name;
+		return -1;
+	}
+	cdev.c.value = (int)val;
 	LOG(DEBUG) << "cdev Name:" << cdev.c.name << ". state:" <<
 		cdev.c.value << std::endl;
 
 	return cdev.c.value;
 }
 
-int ThermalCommon::estimateSeverity(struct therm_sensor& sensor)
+/* Severity of the current temperature, with hysteresis against cur */
+static ThrottlingSeverity measureSeverity(const struct therm_sensor& sensor,
+					ThrottlingSeverity cur)
 {
 	int idx = 0;
-	ThrottlingSeverity severity = ThrottlingSeverity::NONE;
 	float temp = sensor.t.value;
 
 	for (idx = (int)ThrottlingSeverity::SHUTDOWN; idx >= 0; idx--) {
 		/* If a particular threshold is hit already, check if the
 		 * hysteresis is cleared before changing the severity */
-		if (idx == (int)sensor.t.throttlingStatus) {
+		if (idx == (int)cur) {
 			if ((sensor.positiveThresh &&
 				!isnan(sensor.thresh.hotThrottlingThresholds[idx]) &&
 				temp >=
@@ -458,87 +533,295 @@ int ThermalCommon::estimateSeverity(struct therm_sensor& sensor)
 			break;
 	}
 	if (idx >= 0)
-		severity = (ThrottlingSeverity)(idx);
+		return (ThrottlingSeverity)(idx);
+
+	return ThrottlingSeverity::NONE;
+}
+
+/* The first configured severity above cur, -1 if there is none */
+static int nextSeverity(const struct therm_sensor& sensor,
+			ThrottlingSeverity cur)
+{
+	int idx;
+
+	for (idx = (int)cur + 1; idx <= (int)ThrottlingSeverity::SHUTDOWN;
+			idx++) {
+		if ((sensor.positiveThresh &&
+			!isnan(sensor.thresh.hotThrottlingThresholds[idx])) ||
+			(!sensor.positiveThresh &&
+			!isnan(sensor.thresh.coldThrottlingThresholds[idx])))
+			return idx;
+	}
+
+	return -1;
+}
+
+void ThermalCommon::set_prediction(int lead_ms, int hold_ms)
+{
+	predict_lead_ms = lead_ms > 0 ? lead_ms : 0;
+	notify_hold_ms = hold_ms > 0 ? hold_ms : 0;
+}
+
+/*
+ * Adds the current value to the sensor's sample ring and refits the
+ * slope, by least squares over the samples of the last SLOPE_WINDOW_MS.
+ */
+void ThermalCommon::recordSample(struct therm_sensor& sensor, int64_t now_ms)
+{
+	struct therm_sample *last;
+	double st = 0, sv = 0, stt = 0, stv = 0, t, den;
+	int idx, cnt = 0;
+
+	if (isnan(sensor.t.value))
+		return;
+	if (sensor.sampleCount) {
+		last = &sensor.samples[(sensor.sampleHead + SAMPLE_RING_SIZE - 1)
+					% SAMPLE_RING_SIZE];
+		if (now_ms - last->ts_ms < SAMPLE_MIN_GAP_MS)
+			return;
+	}
+	sensor.samples[sensor.sampleHead].ts_ms = now_ms;
+	sensor.samples[sensor.sampleHead].value = sensor.t.value;
+	sensor.sampleHead = (sensor.sampleHead + 1) % SAMPLE_RING_SIZE;
+	if (sensor.sampleCount < SAMPLE_RING_SIZE)
+		sensor.sampleCount++;
+
+	for (idx = 0; idx < sensor.sampleCount; idx++) {
+		struct therm_sample& smp = sensor.samples[idx];
+
+		if (now_ms - smp.ts_ms > SLOPE_WINDOW_MS)
+			continue;
+		/* seconds relative to now, to keep the sums small */
+		t = (double)(smp.ts_ms - now_ms) / 1000;
+		st += t;
+		sv += smp.value;
+		stt += t * t;
+		stv += t * smp.value;
+		cnt++;
+	}
+	den = cnt * stt - st * st;
+	if (cnt < SLOPE_MIN_SAMPLES || den <= 0) {
+		sensor.slope = UNKNOWN_TEMPERATURE;
+		return;
+	}
+	sensor.slope = (float)((cnt * stv - st * sv) / den);
+}
+
+float ThermalCommon::time_to_threshold(const struct therm_sensor& sensor)
+{
+	int next = nextSeverity(sensor, sensor.measuredStatus);
+	float dist, rate;
+
+	if (next < 0 || isnan(sensor.slope) || isnan(sensor.t.value))
+		return UNKNOWN_TEMPERATURE;
+	if (sensor.positiveThresh) {
+		dist = sensor.thresh.hotThrottlingThresholds[next] -
+			sensor.t.value;
+		rate = sensor.slope;
+	} else {
+		dist = sensor.t.value -
+			sensor.thresh.coldThrottlingThresholds[next];
+		rate = -sensor.slope;
+	}
+	if (rate <= 0)
+		return UNKNOWN_TEMPERATURE;
+	if (dist <= 0)
+		return 0;
+
+	return dist / rate * 1000;
+}
+
+int ThermalCommon::estimateSeverity(struct therm_sensor& sensor, bool sampled)
+{
+	return estimateSeverity(sensor, sampled,
+			std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/*
+ * Reported severity of a sensor. It is the measured severity, raised one
+ * level when sampled reads predict the next threshold within
+ * predict_lead_ms. On sampled reads a drop is only reported once it has
+ * lasted notify_hold_ms, so a temperature wandering around a threshold
+ * does not flap the severity. The trips already follow the measured
+ * severity, so a held drop is only reported if the sensor is evaluated
+ * again at hold_deadline(). Returns -1 if the severity is unchanged.
+ */
+int ThermalCommon::estimateSeverity(struct therm_sensor& sensor, bool sampled,
+					int64_t now_ms)
+{
+	ThrottlingSeverity severity;
+	float ttt;
+	int next;
+
+	recordSample(sensor, now_ms);
+	sensor.measuredStatus = measureSeverity(sensor, sensor.measuredStatus);
+	severity = sensor.measuredStatus;
+
+	if (sampled && predict_lead_ms) {
+		next = nextSeverity(sensor, sensor.measuredStatus);
+		ttt = time_to_threshold(sensor);
+		if (next >= 0 && !isnan(ttt) && ttt <= predict_lead_ms)
+			severity = (ThrottlingSeverity)next;
+	}
+
+	if (sampled && notify_hold_ms && severity < sensor.t.throttlingStatus) {
+		if (sensor.dropSince < 0)
+			sensor.dropSince = now_ms;
+		if (now_ms - sensor.dropSince < notify_hold_ms)
+			severity = sensor.t.throttlingStatus;
+	} else if (sensor.dropSince >= 0) {
+		/* the drop reversed before it was reported */
+		if (severity >= sensor.t.throttlingStatus)
+			sensor.coalesceCount++;
+		sensor.dropSince = -1;
+	}
+
 //	LOG(INFO) << "Sensor Name:" << sensor.t.name << "temp: " <<
-//		temp << ". prev severity:" <<
+//		sensor.t.value << ". prev severity:" <<
 //		(int)sensor.lastThrottleStatus << ". cur severity:" <<
 //		(int)sensor.t.throttlingStatus << " New severity:" <<
 //		(int)severity << std::endl;
 	if (severity == sensor.t.throttlingStatus)
 		return -1;
+	sensor.dropSince = -1;
 	sensor.lastThrottleStatus = sensor.t.throttlingStatus;
 	sensor.t.throttlingStatus = severity;
+	sensor.notifyCount++;
 
 	return (int)severity;
 }
 
-int ThermalCommon::read_temperature(struct therm_sensor& sensor)
+int64_t ThermalCommon::hold_deadline(const struct therm_sensor& sensor)
+{
+	if (sensor.dropSince < 0 || !notify_hold_ms)
+		return -1;
+
+	return sensor.dropSince + notify_hold_ms;
+}
+
+void ThermalCommon::dump_sensor(int fd, const struct therm_sensor& sensor)
+{
+	dprintf(fd, "%s(%s) temp:%.2f slope:%.3f/s severity:%d measured:%d "
+		"ttt_ms:%.0f notify:%u coalesced:%u\n",
+		sensor.t.name.c_str(), sensor.sensor_name.c_str(),
+		sensor.t.value, sensor.slope, (int)sensor.t.throttlingStatus,
+		(int)sensor.measuredStatus, time_to_threshold(sensor),
+		sensor.notifyCount, sensor.coalesceCount);
+}
+
+/* Adds a zone to the snapshot, snapshot_mutex held */
+void ThermalCommon::snapshotZone(int tzn)
 {
 	char file_name[MAX_PATH];
-	float temp;
-	std::string buf;
-	int ret = 0, ct = 0;
-	bool read_ok = false;
+	long val;
 
-	do {
-		snprintf(file_name, sizeof(file_name), TEMPERATURE_FILE_FORMAT,
-			sensor.tzn);
-		ret = readLineFromFile(std::string(file_name), buf);
-		if (ret <= 0) {
-			LOG(ERROR) << "Temperature read error:"<< ret <<
-				" for sensor " << sensor.t.name << std::endl;
-			return -1;
-		}
-		try {
-			sensor.t.value = (float)std::stoi(buf, nullptr, 0) /
-				 (float)sensor.mulFactor;
-			read_ok = true;
-		}
-		catch (std::exception &err) {
-			LOG(ERROR) << "Temperature buf stoi error: "
-				<< err.what()
-				<< " buf:" << buf << " sensor:"
-				<< sensor.t.name << " TZ:" <<
-				sensor.tzn << std::endl;
+	if (snapshot.find(tzn) != snapshot.end())
+		return;
+	snprintf(file_name, sizeof(file_name), "%s" TEMPERATURE_FILE_FORMAT,
+			root.c_str(), tzn);
+	if (readNode(file_name, &val) > 0)
+		snapshot[tzn] = (int)val;
+}
+
+/*
+ * Reads the zones of a request in one pass, for its read_temperature()
+ * calls. A snapshot younger than snapshot_window is reused, so requests
+ * arriving together, or blocked here behind each other, share one pass.
+ * A fresh snapshot only gets the zones it misses, so requests for other
+ * types within the window still share it.
+ */
+int ThermalCommon::snapshot_temperatures(bool filterType, TemperatureType type)
+{
+	bool skin = false;
+	std::lock_guard<std::mutex> _lock(snapshot_mutex);
+
+	if (!snapshot_window.count())
+		return 0;
+	if (!snapshot_valid ||
+			std::chrono::steady_clock::now() - snapshot_time >= snapshot_window) {
+		snapshot.clear();
+		snapshot_time = std::chrono::steady_clock::now();
+		snapshot_valid = true;
+	}
+
+	for (struct therm_sensor& sensor: sens) {
+		if (filterType && sensor.t.type != type)
+			continue;
+		snapshotZone(sensor.tzn);
+		if (sensor.t.type == TemperatureType::SKIN)
+			skin = true;
+	}
+	if (skin && batt_tzn >= 0)
+		snapshotZone(batt_tzn);
+
+	return snapshot.size();
+}
+
+/* Raw temperature of a zone, from a fresh snapshot or else from the node */
+int ThermalCommon::readZone(int tzn, int *val)
+{
+	char file_name[MAX_PATH];
+	long raw;
+	int ret;
+
+	{
+		std::lock_guard<std::mutex> _lock(snapshot_mutex);
+		auto it = snapshot.find(tzn);
+
+		if (snapshot_valid && it != snapshot.end() &&
+				std::chrono::steady_clock::now() - snapshot_time <
+				snapshot_window) {
+			*val = it->second;
+			return 1;
 		}
-		ct++;
-	} while (!read_ok && ct < RETRY_CT);
+	}
+
+	snprintf(file_name, sizeof(file_name), "%s" TEMPERATURE_FILE_FORMAT,
+			root.c_str(), tzn);
+	ret = readNode(file_name, &raw);
+	if (ret > 0)
+		*val = (int)raw;
+
+	return ret;
+}
+
+int ThermalCommon::read_temperature(struct therm_sensor& sensor)
+{
+	int ret = 0, val = 0;
+
+	ret = readZone(sensor.tzn, &val);
+	if (ret <= 0) {
+		LOG(ERROR) << "Temperature read error:"<< ret <<
+			" for sensor " << sensor.t.name << std::endl;
+		return -1;
+	}
+	sensor.t.value = (float)val / (float)sensor.mulFactor;
 	LOG(DEBUG) << "Sensor Name:" << sensor.t.name << ". Temperature:" <<
 		(float)sensor.t.value << std::endl;
 
 	if (sensor.t.type == TemperatureType::SKIN) {
-		struct therm_sensor sensor2;
-		sensor2.tzn = get_tzn("batt-therm");
-		if (sensor2.tzn < 0)
+		float batt_temp;
+		int tzn;
+
+		{
+			std::lock_guard<std::mutex> _lock(snapshot_mutex);
+			if (batt_tzn < 0)
+				batt_tzn = get_tzn(root, "batt-therm");
+			tzn = batt_tzn;
+		}
+		if (tzn < 0)
 			return -1;
-		ct = 0;
-		do {
-			snprintf(file_name, sizeof(file_name), TEMPERATURE_FILE_FORMAT,
-				sensor2.tzn);
-			ret = readLineFromFile(std::string(file_name), buf);
-			if (ret <= 0) {
-				LOG(ERROR) << "Temperature read error:"<< ret <<
-					" for sensor batt-therm" << std::endl;
-				return -1;
-			}
-			try {
-				sensor2.t.value = (float)std::stoi(buf, nullptr, 0) /
-					 (float)1000;
-				read_ok = true;
-			}
-			catch (std::exception &err) {
-				LOG(ERROR) << "Temperature buf stoi error: "
-					<< err.what()
-					<< " buf:" << buf << " sensor: batt-therm TZ:" <<
-					sensor2.tzn << std::endl;
-			}
-			ct++;
-		} while (!read_ok && ct < RETRY_CT);
-		LOG(DEBUG) << "Sensor Name:" << sensor.t.name << ". Temperature:" <<
-			(float)sensor.t.value << std::endl;
+		ret = readZone(tzn, &val);
+		if (ret <= 0) {
+			LOG(ERROR) << "Temperature read error:"<< ret <<
+				" for sensor batt-therm" << std::endl;
+			return -1;
+		}
+		batt_temp = (float)val / (float)1000;
 		LOG(DEBUG) << "Sensor Name:batt-therm. Temperature:" <<
-			(float)sensor2.t.value << std::endl;
-		sensor.t.value = (sensor.t.value + sensor2.t.value) / (float)2;
+			batt_temp << std::endl;
+		sensor.t.value = (sensor.t.value + batt_temp) / (float)2;
 		LOG(DEBUG) << "Sensor Name:" << sensor.t.name << ". (Adjust)Temperature:" <<
 			(float)sensor.t.value << std::endl;
 	}
@@ -561,8 +844,8 @@ void ThermalCommon::initThreshold(struct therm_sensor& sensor)
 		return;
 	}
 #ifndef ENABLE_THERMAL_NETLINK
-	snprintf(file_name, sizeof(file_name), POLICY_FILE_FORMAT,
-			sensor.tzn);
+	snprintf(file_name, sizeof(file_name), "%s" POLICY_FILE_FORMAT,
+			root.c_str(), sensor.tzn);
 	ret = readLineFromFile(std::string(file_name), buf);
 	if (ret <= 0) {
 		LOG(ERROR) << "Policy read error:"<< ret <<
@@ -578,7 +861,7 @@ void ThermalCommon::initThreshold(struct therm_sensor& sensor)
 	next_trip = UNKNOWN_TEMPERATURE;
 	for (idx = 0;idx <= (int)ThrottlingSeverity::SHUTDOWN; idx++) {
 		if (isnan(sensor.thresh.hotThrottlingThresholds[idx])
-			|| idx <= (int)sensor.t.throttlingStatus)
+			|| idx <= (int)sensor.measuredStatus)
 			continue;
 
 		next_trip = sensor.thresh.hotThrottlingThresholds[idx] *
@@ -589,13 +872,13 @@ void ThermalCommon::initThreshold(struct therm_sensor& sensor)
 	if (!isnan(next_trip)) {
 		LOG(DEBUG) << "Sensor: " << sensor.t.name << " high trip:"
 			<< next_trip << std::endl;
-		snprintf(file_name, sizeof(file_name), TRIP_FILE_FORMAT,
-				sensor.tzn);
+		snprintf(file_name, sizeof(file_name), "%s" TRIP_FILE_FORMAT,
+				root.c_str(), sensor.tzn);
 		writeToFile(std::string_view(file_name), std::to_string(next_trip));
 	}
-	if (sensor.t.throttlingStatus != ThrottlingSeverity::NONE) {
+	if (sensor.measuredStatus != ThrottlingSeverity::NONE) {
 		curr_trip = sensor.thresh.hotThrottlingThresholds[
-				(int)sensor.t.throttlingStatus]
+				(int)sensor.measuredStatus]
 					* sensor.mulFactor;
 		if (!isnan(next_trip))
 			hyst_temp = (next_trip - curr_trip) + DEFAULT_HYSTERESIS;
@@ -603,83 +886,121 @@ void ThermalCommon::initThreshold(struct therm_sensor& sensor)
 			hyst_temp = DEFAULT_HYSTERESIS;
 		LOG(DEBUG) << "Sensor: " << sensor.t.name << " hysteresis:"
 			<< hyst_temp << std::endl;
-		snprintf(file_name, sizeof(file_name), HYST_FILE_FORMAT,
-				sensor.tzn);
+		snprintf(file_name, sizeof(file_name), "%s" HYST_FILE_FORMAT,
+				root.c_str(), sensor.tzn);
 		writeToFile(std::string_view(file_name), std::to_string(hyst_temp));
 	}
 
 	return;
 }
 
+/* True once buf holds a complete line following the cpu lines */
+static bool pastCpuLines(const char *buf, size_t len)
+{
+	const char *line = buf, *next;
+	const char *end = buf + len;
+
+	while ((next = (const char *)memchr(line, '\n', end - line))) {
+		if (strncmp(line, "cpu", 3) != 0)
+			return true;
+		line = next + 1;
+	}
+
+	return false;
+}
+
+/* Reads the head of /proc/stat, up to the end of the cpu lines */
+int ThermalCommon::readProcStat()
+{
+	char file_name[MAX_PATH];
+	ssize_t len;
+	int fd;
+
+	snprintf(file_name, sizeof(file_name), "%s" CPU_USAGE_FILE, root.c_str());
+	fd = getFd(file_name);
+	if (fd < 0)
+		return fd;
+
+	if (stat_buf.empty())
+		stat_buf.resize(CPU_USAGE_BUF_SIZE);
+	while (true) {
+		len = pread(fd, stat_buf.data(), stat_buf.size() - 1, 0);
+		if (len < 0) {
+			LOG(ERROR) << "failed to read:" << file_name <<
+				" err:" << strerror(errno);
+			return -errno;
+		}
+		if ((size_t)len < stat_buf.size() - 1 ||
+				pastCpuLines(stat_buf.data(), len))
+			break;
+		stat_buf.resize(stat_buf.size() * 2);
+	}
+	stat_buf[len] = '\0';
+
+	return (int)len;
+}
+
+/* Parses "cpuN user nice system idle ..." */
+static int parseCpuLine(const char *line, int *cpu_num, uint64_t *vals,
+			int count)
+{
+	const char *p = line + 3;
+	char *end;
+	int idx;
+
+	*cpu_num = (int)strtol(p, &end, 10);
+	if (end == p)
+		return -1;
+	for (idx = 0; idx < count; idx++) {
+		p = end;
+		vals[idx] = strtoull(p, &end, 10);
+		if (end == p)
+			return -1;
+	}
+
+	return 0;
+}
+
 int ThermalCommon::get_cpu_usages(hidl_vec<CpuUsage>& list) {
-	int vals, cpu_num, online;
-	ssize_t read;
-	uint64_t user, nice, system, idle, active, total;
-	char *line = NULL;
-	size_t len = 0;
+	int cpu_num, ret;
+	long online;
+	/* user, nice, system, idle */
+	uint64_t vals[4];
+	uint64_t active, total;
 	size_t cpu = 0;
-	char file_name[MAX_LENGTH];
-	FILE *file;
-	FILE *cpu_file;
+	char file_name[MAX_PATH];
+	const char *line, *next, *end;
 
 	list.resize(ncpus);
-	file = fopen(CPU_USAGE_FILE, "r");
-	if (file == NULL) {
-		LOG(ERROR) << "failed to open:" << CPU_USAGE_FILE <<
-			" err:" << strerror(errno);
-		return -errno;
-	}
-
-	while ((read = getline(&line, &len, file)) != -1) {
-		if (strnlen(line, read) < 4 || strncmp(line, "cpu", 3) != 0 ||
-				!isdigit(line[3])) {
-			free(line);
-			line = NULL;
-			len = 0;
+	std::lock_guard<std::mutex> _lock(stat_mutex);
+	ret = readProcStat();
+	if (ret < 0)
+		return ret;
+
+	for (line = stat_buf.data(), end = line + ret; line < end; line = next) {
+		next = (const char *)memchr(line, '\n', end - line);
+		next = next ? next + 1 : end;
+		if (next - line < 4 || strncmp(line, "cpu", 3) != 0 ||
+				!isdigit(line[3]))
 			continue;
-		}
-		vals = sscanf(line, \
-			"cpu%d %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64, \
-			&cpu_num, &user, &nice, &system, &idle);
-
-		free(line);
-		line = NULL;
-		len = 0;
-
-		if (vals != 5 || cpu == ncpus) {
-			if (vals != 5) {
-				LOG(ERROR) <<
-				"failed to read CPU information from file: "
-				<< strerror(errno);
-			} else {
-				LOG(ERROR) <<
-					"/proc/stat file has incorrect format.";
-			}
-			fclose(file);
-			return errno ? -errno : -EIO;
+
+		if (parseCpuLine(line, &cpu_num, vals, 4) || cpu == ncpus ||
+				cpu_num < 0 || cpu_num >= ncpus) {
+			LOG(ERROR) << "/proc/stat file has incorrect format.";
+			return -EIO;
 		}
 
-		active = user + nice + system;
-		total = active + idle;
+		active = vals[0] + vals[1] + vals[2];
+		total = active + vals[3];
 
 		// Read online CPU information.
-		snprintf(file_name, MAX_LENGTH, CPU_ONLINE_FILE_FORMAT,
-				cpu_num);
-		cpu_file = fopen(file_name, "r");
-		online = 0;
-		if (cpu_file == NULL) {
-			LOG(ERROR) << "failed to open file:" << file_name <<
-				" err: " << strerror(errno);
-			fclose(file);
-			return -errno;
-		}
-		if (1 != fscanf(cpu_file, "%d", &online)) {
-			LOG(ERROR) << "failed to read CPU online information" << strerror(errno);
-			fclose(file);
-			fclose(cpu_file);
-			return errno ? -errno : -EIO;
+		snprintf(file_name, sizeof(file_name), "%s" CPU_ONLINE_FILE_FORMAT,
+				root.c_str(), cpu_num);
+		ret = readNode(file_name, &online);
+		if (ret <= 0) {
+			LOG(ERROR) << "failed to read CPU online information";
+			return ret ? ret : -EIO;
 		}
-		fclose(cpu_file);
 
 		list[cpu_num].name = std::string("CPU") + std::to_string(cpu_num);
 		list[cpu_num].active = active;
@@ -687,7 +1008,6 @@ int ThermalCommon::get_cpu_usages(hidl_vec<CpuUsage>& list) {
 		list[cpu_num].isOnline = online;
 		cpu++;
 	}
-	fclose(file);
 	if (cpu != ncpus) {
 		LOG(ERROR) <<"/proc/stat file has incorrect format.";
 		return -EIO;
@@ -31,6 +31,9 @@
 #ifndef THERMAL_THERMAL_COMMON_H__
 #define THERMAL_THERMAL_COMMON_H__
 
+#include <chrono>
+#include <unordered_map>
+
 #include "thermalData.h"
 
 namespace android {
@@ -40,11 +43,20 @@ namespace V2_0 {
 namespace implementation {
 
 #define RETRY_CT 3
+/* Temperature snapshots younger than this are shared between requests */
+#define SNAPSHOT_WINDOW_MS 10
+/* A severity drop seen on sampled reads is reported once it lasts this long */
+#define NOTIFY_HOLD_MS 2000
 
 class ThermalCommon {
 	public:
-		ThermalCommon();
-		~ThermalCommon() = default;
+		/*
+		 * root prefixes the sysfs and procfs paths, for fake trees.
+		 * A snapshot window of 0 reads every sensor on its own.
+		 */
+		ThermalCommon(const std::string& root = "",
+				int snapshot_window_ms = SNAPSHOT_WINDOW_MS);
+		~ThermalCommon();
 
 		int readFromFile(std::string_view path, std::string& out);
 		int initThermalZones(std::vector<struct target_therm_cfg>& cfg);
@@ -53,7 +65,37 @@ class ThermalCommon {
 
 		int read_cdev_state(struct therm_cdev& cdev);
 		int read_temperature(struct therm_sensor& sensor);
-		int estimateSeverity(struct therm_sensor& sensor);
+		/*
+		 * Snapshots the zones of the sensors a request reads, every
+		 * sensor or only those of type when filterType is set.
+		 */
+		int snapshot_temperatures(bool filterType = false,
+				TemperatureType type = TemperatureType::UNKNOWN);
+		/*
+		 * sampled marks periodic reads, as opposed to trip events. Only
+		 * those hold back severity drops and raise the severity ahead of
+		 * a predicted threshold crossing.
+		 */
+		int estimateSeverity(struct therm_sensor& sensor,
+					bool sampled = false);
+		int estimateSeverity(struct therm_sensor& sensor, bool sampled,
+					int64_t now_ms);
+		/*
+		 * steady clock ms at which the severity drop held back on this
+		 * sensor is due to be reported, -1 if none is held. Nothing
+		 * else re-evaluates the sensor, the owner has to do it then.
+		 */
+		int64_t hold_deadline(const struct therm_sensor& sensor);
+		/* ms until the next threshold is crossed, NAN if not approaching */
+		float time_to_threshold(const struct therm_sensor& sensor);
+		/*
+		 * lead_ms: how far ahead of a predicted crossing to raise the
+		 * severity, 0 disables prediction.
+		 * hold_ms: how long a severity drop must last before it is
+		 * reported, 0 reports it at once.
+		 */
+		void set_prediction(int lead_ms, int hold_ms);
+		void dump_sensor(int fd, const struct therm_sensor& sensor);
 		int get_cpu_usages(hidl_vec<CpuUsage>& list);
 
 		std::vector<struct therm_sensor> fetch_sensor_list()
@@ -67,13 +109,38 @@ class ThermalCommon {
 
 	private:
 		int ncpus;
+		std::string root;
 		std::vector<struct target_therm_cfg> cfg;
 		std::vector<struct therm_sensor> sens;
 		std::vector<struct therm_cdev> cdev;
 
+		/* sysfs and procfs nodes stay open, read with pread() */
+		std::mutex fd_mutex;
+		std::unordered_map<std::string, int> fds;
+
+		/* raw temperature by thermal zone, of the sensors requested */
+		std::mutex snapshot_mutex;
+		std::unordered_map<int, int> snapshot;
+		std::chrono::steady_clock::time_point snapshot_time;
+		std::chrono::milliseconds snapshot_window;
+		bool snapshot_valid;
+		int batt_tzn;
+
+		std::mutex stat_mutex;
+		std::vector<char> stat_buf;
+
+		int predict_lead_ms;
+		int notify_hold_ms;
+
 		int initializeCpuSensor(struct target_therm_cfg& cpu_cfg);
 		int initialize_sensor(struct target_therm_cfg& cfg,
 					int sens_idx);
+		int getFd(const char *path);
+		int readNode(const char *path, long *val);
+		int readZone(int tzn, int *val);
+		void snapshotZone(int tzn);
+		int readProcStat();
+		void recordSample(struct therm_sensor& sensor, int64_t now_ms);
 };
 
 }  // namespace implementation
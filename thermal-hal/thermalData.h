@@ -39,6 +39,8 @@
 #include <android/hardware/thermal/2.0/IThermal.h>
 
 #define UNKNOWN_TEMPERATURE (NAN)
+/* Recent samples kept per sensor for the rate estimate */
+#define SAMPLE_RING_SIZE 8
 
 namespace android {
 namespace hardware {
@@ -72,6 +74,11 @@ using ::android::hardware::thermal::V2_0::ThrottlingSeverity;
 		bool positive_thresh_ramp;
 	};
 
+	struct therm_sample {
+		int64_t ts_ms;
+		float value;
+	};
+
 	struct therm_sensor {
 		int tzn;
 		int mulFactor;
@@ -80,6 +87,18 @@ using ::android::hardware::thermal::V2_0::ThrottlingSeverity;
 		ThrottlingSeverity lastThrottleStatus;
 		Temperature t;
 		TemperatureThreshold thresh;
+
+		/* severity of the temperature alone, t holds the reported one */
+		ThrottlingSeverity measuredStatus;
+		struct therm_sample samples[SAMPLE_RING_SIZE];
+		int sampleHead;
+		int sampleCount;
+		/* units per second, NAN until enough samples */
+		float slope;
+		/* when a held severity drop was first seen, -1 if none */
+		int64_t dropSince;
+		unsigned int notifyCount;
+		unsigned int coalesceCount;
 	};
 
 	struct therm_cdev {
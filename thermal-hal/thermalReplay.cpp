@@ -0,0 +1,363 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Replays temperature traces through the severity tracking of ThermalCommon
+ * and reports how many callbacks the framework would get and how far ahead
+ * of each threshold crossing the severity was raised. Every trace runs once
+ * as the HAL used to behave, without prediction or hold, and once with the
+ * given lead and hold. A drop still held when the next sample would come
+ * is reported at its deadline, as the HAL's hold timer does.
+ *
+ * thermal_replay [-l lead_ms] [-h hold_ms] [-t severe_mC] [-s shutdown_mC]
+ *		[trace...]
+ *
+ * A trace has one "<ms> <millidegrees>" sample per line, '#' starts a
+ * comment. Without traces a few synthetic ones are replayed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <android-base/logging.h>
+#include "thermalCommon.h"
+
+using namespace android::hardware::thermal::V2_0::implementation;
+
+#define DEFAULT_LEAD_MS		5000
+#define DEFAULT_SEVERE_MC	45000
+#define DEFAULT_SHUTDOWN_MC	60000
+#define SYNTH_PERIOD_MS		1000
+#define SEVERITY_LEVELS		((int)ThrottlingSeverity::SHUTDOWN + 1)
+
+struct trace {
+	std::string name;
+	std::vector<std::pair<int64_t, int>> samples;
+};
+
+struct replay_result {
+	unsigned int callbacks;
+	unsigned int raises;
+	unsigned int drops;
+	unsigned int crossings;
+	/* crossings that started a reported episode, lead is taken on these */
+	unsigned int episodes;
+	unsigned int early;
+	unsigned int false_alarms;
+	int64_t lead_sum;
+	int64_t lead_min;
+	/* reported severity after the last sample and any held drop */
+	int final_severity;
+};
+
+struct replay_state {
+	ThermalCommon common;
+	struct therm_sensor sensor;
+	struct replay_result res;
+	/* when the reported severity last rose to each level, -1 if below */
+	int64_t since[SEVERITY_LEVELS];
+	bool crossed[SEVERITY_LEVELS];
+};
+
+static bool load_trace(const char *path, struct trace& tr)
+{
+	std::ifstream in(path);
+	std::string line;
+
+	if (!in) {
+		fprintf(stderr, "Cannot open trace %s\n", path);
+		return false;
+	}
+	tr.name = path;
+	while (std::getline(in, line)) {
+		std::istringstream fields(line.substr(0, line.find('#')));
+		int64_t ms;
+		int mc;
+
+		if (fields >> ms >> mc)
+			tr.samples.emplace_back(ms, mc);
+	}
+
+	return !tr.samples.empty();
+}
+
+/* Slow climb through the threshold, as a long game session would */
+static struct trace synth_ramp(int severe)
+{
+	struct trace tr = {"synthetic ramp 0.1C/s", {}};
+	int64_t ms;
+
+	for (ms = 0; ms <= 300000; ms += SYNTH_PERIOD_MS)
+		tr.samples.emplace_back(ms, severe - 20000 + (int)(ms / 10) +
+					(rand() % 601) - 300);
+
+	return tr;
+}
+
+/* Short load bursts over the threshold, two seconds on and two off */
+static struct trace synth_bursts(int severe)
+{
+	struct trace tr = {"synthetic short bursts", {}};
+	int64_t ms;
+
+	for (ms = 0; ms <= 300000; ms += SYNTH_PERIOD_MS) {
+		bool burst = (ms / SYNTH_PERIOD_MS) % 4 >= 2;
+		int temp = burst ? severe + 1000 : severe - 6000;
+
+		tr.samples.emplace_back(ms, temp + (rand() % 1001) - 500);
+	}
+
+	return tr;
+}
+
+/* Fast heating up to shutdown level, then cool down */
+static struct trace synth_spike(int severe, int shutdown)
+{
+	struct trace tr = {"synthetic spike 1C/s", {}};
+	int64_t ms;
+	int temp = severe - 10000;
+
+	for (ms = 0; ms <= 120000; ms += SYNTH_PERIOD_MS) {
+		if (ms < 60000 && temp < shutdown + 2000)
+			temp += 1000;
+		else if (ms >= 60000)
+			temp -= 500;
+		tr.samples.emplace_back(ms, temp + (rand() % 201) - 100);
+	}
+
+	return tr;
+}
+
+/*
+ * Heat over the threshold, then a drop and no more samples, as when the
+ * framework stops polling once the device has cooled down.
+ */
+static struct trace synth_stop(int severe)
+{
+	struct trace tr = {"synthetic drop then no samples", {}};
+	int64_t ms;
+
+	for (ms = 0; ms <= 30000; ms += SYNTH_PERIOD_MS)
+		tr.samples.emplace_back(ms, severe + 2000);
+	tr.samples.emplace_back(ms, severe - 10000);
+
+	return tr;
+}
+
+static struct therm_sensor make_sensor(int severe, int shutdown)
+{
+	struct therm_sensor sensor;
+	int idx;
+
+	sensor.tzn = 0;
+	sensor.mulFactor = 1000;
+	sensor.positiveThresh = true;
+	sensor.sensor_name = "replay";
+	sensor.thresh.name = sensor.t.name = "replay";
+	sensor.thresh.type = sensor.t.type = TemperatureType::SKIN;
+	sensor.lastThrottleStatus = sensor.t.throttlingStatus =
+		sensor.measuredStatus = ThrottlingSeverity::NONE;
+	sensor.sampleHead = sensor.sampleCount = 0;
+	sensor.slope = UNKNOWN_TEMPERATURE;
+	sensor.dropSince = -1;
+	sensor.notifyCount = sensor.coalesceCount = 0;
+	sensor.thresh.vrThrottlingThreshold = UNKNOWN_TEMPERATURE;
+	for (idx = 0; idx < SEVERITY_LEVELS; idx++)
+		sensor.thresh.hotThrottlingThresholds[idx] =
+		sensor.thresh.coldThrottlingThresholds[idx] =
+			UNKNOWN_TEMPERATURE;
+	sensor.thresh.hotThrottlingThresholds[(int)ThrottlingSeverity::SEVERE] =
+		severe / 1000.0f;
+	if (shutdown)
+		sensor.thresh.hotThrottlingThresholds[
+			(int)ThrottlingSeverity::SHUTDOWN] = shutdown / 1000.0f;
+
+	return sensor;
+}
+
+/* One evaluation of the sensor at ms, with the value it holds */
+static void evaluate(struct replay_state& st, int64_t ms)
+{
+	struct therm_sensor& sensor = st.sensor;
+	struct replay_result& res = st.res;
+	int measured = (int)sensor.measuredStatus;
+	int reported = (int)sensor.t.throttlingStatus;
+	int lvl;
+
+	if (st.common.estimateSeverity(sensor, true, ms) != -1) {
+		res.callbacks++;
+		if ((int)sensor.t.throttlingStatus > reported)
+			res.raises++;
+		else
+			res.drops++;
+	}
+	for (lvl = 1; lvl < SEVERITY_LEVELS; lvl++) {
+		bool now_at = (int)sensor.t.throttlingStatus >= lvl;
+
+		if (isnan(sensor.thresh.hotThrottlingThresholds[lvl]))
+			continue;
+
+		if (now_at && st.since[lvl] < 0) {
+			st.since[lvl] = ms;
+			st.crossed[lvl] = false;
+		} else if (!now_at && st.since[lvl] >= 0) {
+			if (!st.crossed[lvl])
+				res.false_alarms++;
+			st.since[lvl] = -1;
+		}
+		if ((int)sensor.measuredStatus < lvl || measured >= lvl)
+			continue;
+		res.crossings++;
+		if (!st.crossed[lvl]) {
+			int64_t lead = ms - st.since[lvl];
+
+			st.crossed[lvl] = true;
+			res.episodes++;
+			res.lead_sum += lead;
+			if (lead > 0)
+				res.early++;
+			if (lead < res.lead_min)
+				res.lead_min = lead;
+		}
+	}
+}
+
+/* Reports a held drop that is due before until, as the hold timer would */
+static void expire_hold(struct replay_state& st, int64_t until)
+{
+	int64_t due;
+
+	while ((due = st.common.hold_deadline(st.sensor)) >= 0 && due < until)
+		evaluate(st, due);
+}
+
+static struct replay_result replay(const struct trace& tr, int lead_ms,
+				   int hold_ms, int severe, int shutdown)
+{
+	struct replay_state st;
+	int lvl;
+
+	st.sensor = make_sensor(severe, shutdown);
+	st.res = {};
+	for (lvl = 0; lvl < SEVERITY_LEVELS; lvl++) {
+		st.since[lvl] = -1;
+		st.crossed[lvl] = false;
+	}
+	st.res.lead_min = INT64_MAX;
+	st.common.set_prediction(lead_ms, hold_ms);
+
+	for (auto& smp: tr.samples) {
+		expire_hold(st, smp.first);
+		st.sensor.t.value = smp.second / 1000.0f;
+		evaluate(st, smp.first);
+	}
+	expire_hold(st, INT64_MAX);
+	st.res.final_severity = (int)st.sensor.t.throttlingStatus;
+
+	return st.res;
+}
+
+static void report(const char *mode, const struct replay_result& res)
+{
+	printf("  %-10s callbacks %4u (raise %u, drop %u)  crossings %u"
+	       "  episodes %u early %u  lead avg %6.0f ms min %6" PRId64
+	       " ms  false alarms %u  final %d\n", mode, res.callbacks, res.raises,
+	       res.drops, res.crossings, res.episodes, res.early,
+	       res.episodes ? (double)res.lead_sum / res.episodes : 0.0,
+	       res.episodes ? res.lead_min : 0, res.false_alarms,
+	       res.final_severity);
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<struct trace> traces;
+	int lead_ms = DEFAULT_LEAD_MS, hold_ms = NOTIFY_HOLD_MS;
+	int severe = DEFAULT_SEVERE_MC, shutdown = DEFAULT_SHUTDOWN_MC;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:h:t:s:")) != -1) {
+		switch (opt) {
+		case 'l':
+			lead_ms = atoi(optarg);
+			break;
+		case 'h':
+			hold_ms = atoi(optarg);
+			break;
+		case 't':
+			severe = atoi(optarg);
+			break;
+		case 's':
+			shutdown = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-l lead_ms] [-h hold_ms] "
+				"[-t severe_mC] [-s shutdown_mC] [trace...]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	for (; optind < argc; optind++) {
+		struct trace tr;
+
+		if (!load_trace(argv[optind], tr))
+			return 1;
+		traces.push_back(tr);
+	}
+	if (traces.empty()) {
+		srand(1);
+		traces.push_back(synth_ramp(severe));
+		traces.push_back(synth_bursts(severe));
+		traces.push_back(synth_spike(severe, shutdown));
+		traces.push_back(synth_stop(severe));
+	}
+
+	printf("severe %d mC, shutdown %d mC, lead %d ms, hold %d ms\n",
+	       severe, shutdown, lead_ms, hold_ms);
+	for (auto& tr: traces) {
+		printf("%s, %zu samples\n", tr.name.c_str(), tr.samples.size());
+		report("baseline", replay(tr, 0, 0, severe, shutdown));
+		report("tracked", replay(tr, lead_ms, hold_ms, severe,
+					 shutdown));
+	}
+
+	return 0;
+}
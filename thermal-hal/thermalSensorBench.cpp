@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted (subject to the limitations in the
+disclaimer below) provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Sensor sampling cost of the HAL requests against a fake sysfs tree:
+ * getCurrentTemperatures over every zone and over the one CPU zone,
+ * getCurrentCoolingDevices and getCpuUsages, the open/read/close way and
+ * through ThermalCommon.
+ *
+ * thermal_sensor_bench [zones] [requests]
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <android-base/logging.h>
+#include "thermalCommon.h"
+
+using namespace android::hardware::thermal::V2_0::implementation;
+
+#define DEFAULT_ZONES		40
+#define DEFAULT_REQUESTS	2000
+#define BENCH_CDEVS		16
+
+static int64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void write_file(const std::string& path, const std::string& data)
+{
+	std::ofstream out(path);
+
+	out << data;
+}
+
+static void make_dirs(const std::string& path)
+{
+	size_t pos = 0;
+
+	while ((pos = path.find('/', pos + 1)) != std::string::npos)
+		mkdir(path.substr(0, pos).c_str(), 0755);
+	mkdir(path.c_str(), 0755);
+}
+
+static void make_tree(const std::string& root, int zones, int ncpus)
+{
+	std::string stat;
+	int idx;
+
+	for (idx = 0; idx < zones; idx++) {
+		std::string dir = root + "/sys/class/thermal/thermal_zone" +
+			std::to_string(idx);
+
+		make_dirs(dir);
+		write_file(dir + "/type", "bench-tz" + std::to_string(idx) + "\n");
+		write_file(dir + "/temp", std::to_string(35000 + idx * 100) + "\n");
+		write_file(dir + "/policy", "user_space\n");
+		write_file(dir + "/trip_point_1_temp", "0\n");
+		write_file(dir + "/trip_point_1_hyst", "0\n");
+	}
+	for (idx = 0; idx < BENCH_CDEVS; idx++) {
+		std::string dir = root + "/sys/class/thermal/cooling_device" +
+			std::to_string(idx);
+
+		make_dirs(dir);
+		write_file(dir + "/type", "cpu-isolate" + std::to_string(idx % 8) + "\n");
+		write_file(dir + "/cur_state", "0\n");
+	}
+
+	stat = "cpu  1000 20 300 4000 5 0 6 0 0 0\n";
+	for (idx = 0; idx < ncpus; idx++) {
+		std::string dir = root + "/sys/devices/system/cpu/cpu" +
+			std::to_string(idx);
+
+		make_dirs(dir);
+		write_file(dir + "/online", "1\n");
+		stat += "cpu" + std::to_string(idx) +
+			" 125 2 37 500 1 0 1 0 0 0\n";
+	}
+	/* /proc/stat is mostly interrupt counts */
+	stat += "intr 123456";
+	for (idx = 0; idx < 1024; idx++)
+		stat += " " + std::to_string(idx * 7);
+	stat += "\nctxt 987654\nbtime 1600000000\nprocesses 4321\n"
+		"procs_running 2\nprocs_blocked 0\nsoftirq 1 2 3 4 5 6 7 8 9 10 11\n";
+	make_dirs(root + "/proc");
+	write_file(root + "/proc/stat", stat);
+}
+
+/* One fopen/fgets/fclose per node, as every request used to */
+static int legacy_read(const std::string& path, int *val)
+{
+	char buf[50];
+	FILE *fd = fopen(path.c_str(), "r");
+	int ret = -1;
+
+	if (!fd)
+		return -1;
+	if (fgets(buf, sizeof(buf), fd)) {
+		*val = std::stoi(buf, nullptr, 0);
+		ret = 0;
+	}
+	fclose(fd);
+
+	return ret;
+}
+
+static int legacy_cpu_usages(const std::string& root, int ncpus,
+			     hidl_vec<CpuUsage>& list)
+{
+	uint64_t user, nice, system, idle;
+	char *line = NULL;
+	size_t len = 0;
+	int cpu_num, online, cpu = 0;
+	FILE *file = fopen((root + "/proc/stat").c_str(), "r");
+
+	if (!file)
+		return -1;
+	list.resize(ncpus);
+	while (getline(&line, &len, file) != -1) {
+		if (strncmp(line, "cpu", 3) != 0 || !isdigit(line[3]))
+			continue;
+		if (sscanf(line, "cpu%d %" SCNu64 " %" SCNu64 " %" SCNu64
+				" %" SCNu64, &cpu_num, &user, &nice,
+				&system, &idle) != 5 || cpu_num >= ncpus)
+			break;
+		if (legacy_read(root + "/sys/devices/system/cpu/cpu" +
+				std::to_string(cpu_num) + "/online", &online))
+			break;
+		list[cpu_num].active = user + nice + system;
+		list[cpu_num].total = user + nice + system + idle;
+		list[cpu_num].isOnline = online;
+		cpu++;
+	}
+	free(line);
+	fclose(file);
+
+	return cpu == ncpus ? cpu : -1;
+}
+
+static void report(const char *name, int64_t ns, int requests)
+{
+	printf("%-34s %8" PRId64 " ns per request\n", name, ns / requests);
+}
+
+int main(int argc, char **argv)
+{
+	int zones = argc > 1 ? atoi(argv[1]) : DEFAULT_ZONES;
+	int requests = argc > 2 ? atoi(argv[2]) : DEFAULT_REQUESTS;
+	int ncpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+	char root_tmpl[] = "/tmp/thermal_bench.XXXXXX";
+	std::vector<struct target_therm_cfg> cfg;
+	std::vector<struct therm_sensor> sensors;
+	std::vector<struct therm_cdev> cdevs;
+	hidl_vec<CpuUsage> usages;
+	int64_t start;
+	int idx, req, val;
+
+	if (zones <= 0 || requests <= 0 || !mkdtemp(root_tmpl)) {
+		printf("usage: %s [zones] [requests]\n", argv[0]);
+		return 1;
+	}
+	std::string root(root_tmpl);
+	make_tree(root, zones, ncpus);
+	android::base::SetMinimumLogSeverity(android::base::WARNING);
+
+	for (idx = 0; idx < zones; idx++) {
+		struct target_therm_cfg zone_cfg = {};
+
+		zone_cfg.type = idx ? TemperatureType::GPU :
+			TemperatureType::CPU;
+		zone_cfg.sensor_list.push_back("bench-tz" + std::to_string(idx));
+		zone_cfg.label = "bench-tz" + std::to_string(idx);
+		zone_cfg.throt_thresh = 95000;
+		zone_cfg.positive_thresh_ramp = true;
+		cfg.push_back(zone_cfg);
+	}
+	printf("%d zones, %d cooling devices, %d cpus, %d requests\n", zones,
+	       BENCH_CDEVS, ncpus, requests);
+
+	start = now_ns();
+	for (req = 0; req < requests; req++) {
+		for (idx = 0; idx < zones; idx++)
+			legacy_read(root + "/sys/class/thermal/thermal_zone" +
+				    std::to_string(idx) + "/temp", &val);
+	}
+	report("temperatures, open per read", now_ns() - start, requests);
+
+	for (int window = 0; window <= SNAPSHOT_WINDOW_MS; window += SNAPSHOT_WINDOW_MS) {
+		ThermalCommon common(root, window);
+
+		if (common.initThermalZones(cfg) != zones ||
+				common.initCdev() != BENCH_CDEVS) {
+			printf("fake tree setup failed\n");
+			return 1;
+		}
+		sensors = common.fetch_sensor_list();
+		cdevs = common.fetch_cdev_list();
+
+		start = now_ns();
+		for (req = 0; req < requests; req++) {
+			common.snapshot_temperatures();
+			for (struct therm_sensor& sens: sensors) {
+				if (common.read_temperature(sens) < 0)
+					return 1;
+			}
+		}
+		report(window ? "temperatures, snapshot coalesced" :
+		       "temperatures, pread per sensor", now_ns() - start, requests);
+
+		if (window) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(window));
+			start = now_ns();
+			for (req = 0; req < requests; req++) {
+				common.snapshot_temperatures(true,
+						TemperatureType::CPU);
+				if (common.read_temperature(sensors[0]) < 0)
+					return 1;
+			}
+			report("cpu temperature, snapshot", now_ns() - start,
+			       requests);
+
+			/* Two binder threads asking at the same time */
+			start = now_ns();
+			std::thread other([&]() {
+				std::vector<struct therm_sensor> mine = sensors;
+
+				for (int r = 0; r < requests; r++) {
+					common.snapshot_temperatures();
+					for (struct therm_sensor& sens: mine)
+						common.read_temperature(sens);
+				}
+			});
+			for (req = 0; req < requests; req++) {
+				common.snapshot_temperatures();
+				for (struct therm_sensor& sens: sensors)
+					common.read_temperature(sens);
+			}
+			other.join();
+			report("temperatures, 2 callers coalesced", now_ns() - start,
+			       requests * 2);
+			continue;
+		}
+
+		start = now_ns();
+		for (req = 0; req < requests; req++) {
+			for (struct therm_cdev& cdev: cdevs)
+				common.read_cdev_state(cdev);
+		}
+		report("cooling devices, pread", now_ns() - start, requests);
+
+		start = now_ns();
+		for (req = 0; req < requests; req++) {
+			if (common.get_cpu_usages(usages) != ncpus)
+				return 1;
+		}
+		report("cpu usages, pread", now_ns() - start, requests);
+	}
+
+	start = now_ns();
+	for (req = 0; req < requests; req++) {
+		for (idx = 0; idx < BENCH_CDEVS; idx++)
+			legacy_read(root + "/sys/class/thermal/cooling_device" +
+				    std::to_string(idx) + "/cur_state", &val);
+	}
+	report("cooling devices, open per read", now_ns() - start, requests);
+
+	start = now_ns();
+	for (req = 0; req < requests; req++) {
+		if (legacy_cpu_usages(root, ncpus, usages) != ncpus)
+			return 1;
+	}
+	report("cpu usages, stdio", now_ns() - start, requests);
+
+	std::string cmd = "rm -rf " + root;
+	return system(cmd.c_str()) ? 1 : 0;
+}
@@ -31,8 +31,10 @@
 #ifndef THERMAL_THERMAL_UTILS_H__
 #define THERMAL_THERMAL_UTILS_H__
 
+#include <condition_variable>
 #include <unordered_map>
 #include <mutex>
+#include <thread>
 #include <android/hardware/thermal/2.0/IThermal.h>
 #include "thermalConfig.h"
 #include "thermalMonitor.h"
@@ -50,7 +52,7 @@ using ueventCB = std::function<void(Temperature &t)>;
 class ThermalUtils {
 	public:
 		ThermalUtils(const ueventCB &inp_cb);
-		~ThermalUtils() = default;
+		~ThermalUtils();
 		bool isSensorInitialized()
 		{
 			return is_sensor_init;
@@ -67,6 +69,7 @@ class ThermalUtils {
 		int readCdevStates(bool filterType, cdevType type,
                                             hidl_vec<CoolingDevice>& cdev);
 		int fetchCpuUsages(hidl_vec<CpuUsage>& cpu_usages);
+		void dumpSensors(int fd);
 	private:
 		bool is_sensor_init;
 		bool is_cdev_init;
@@ -78,9 +81,14 @@ class ThermalUtils {
 		std::vector<struct therm_cdev> cdevList;
 		std::mutex sens_cb_mutex;
 		ueventCB cb;
+		/* reports held severity drops when they are due */
+		std::thread hold_th;
+		std::condition_variable hold_cv;
+		bool hold_shutdown;
 
 		void ueventParse(std::string sensor_name, int temp);
-		void Notify(struct therm_sensor& sens);
+		void Notify(struct therm_sensor& sens, bool sampled = false);
+		void holdTimer();
 };
 
 }  // namespace implementation
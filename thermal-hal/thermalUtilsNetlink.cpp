@@ -39,6 +39,9 @@
 #include "thermalConfig.h"
 #include "thermalUtilsNetlink.h"
 
+#define PREDICT_LEAD_PROP "vendor.thermal.predict_lead_ms"
+#define NOTIFY_HOLD_PROP "vendor.thermal.notify_hold_ms"
+
 namespace android {
 namespace hardware {
 namespace thermal {
@@ -60,11 +63,16 @@ ThermalUtils::ThermalUtils(const ueventCB &inp_cb):
 	cb(inp_cb)
 {
 	int ret = 0;
+	int hold_ms = android::base::GetIntProperty(NOTIFY_HOLD_PROP,
+						NOTIFY_HOLD_MS);
 	std::vector<struct therm_sensor> sensorList;
 	std::vector<struct target_therm_cfg> therm_cfg = cfg.fetchConfig();
 
 	is_sensor_init = false;
 	is_cdev_init = false;
+	hold_shutdown = false;
+	cmnInst.set_prediction(
+		android::base::GetIntProperty(PREDICT_LEAD_PROP, 0), hold_ms);
 	ret = cmnInst.initThermalZones(therm_cfg);
 	if (ret > 0) {
 		is_sensor_init = true;
@@ -83,18 +91,73 @@ ThermalUtils::ThermalUtils(const ueventCB &inp_cb):
 		is_cdev_init = true;
 		cdevList = cmnInst.fetch_cdev_list();
 	}
+	if (hold_ms > 0)
+		hold_th = std::thread(&ThermalUtils::holdTimer, this);
+}
+
+ThermalUtils::~ThermalUtils()
+{
+	{
+		std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+		hold_shutdown = true;
+	}
+	hold_cv.notify_all();
+	if (hold_th.joinable())
+		hold_th.join();
 }
 
-void ThermalUtils::Notify(struct therm_sensor& sens)
+void ThermalUtils::Notify(struct therm_sensor& sens, bool sampled)
 {
-	int severity = cmnInst.estimateSeverity(sens);
+	ThrottlingSeverity measured = sens.measuredStatus;
+	int severity = cmnInst.estimateSeverity(sens, sampled);
 	if (severity != -1) {
 		LOG(INFO) << "sensor: " << sens.sensor_name <<" temperature: "
 			<< sens.t.value << " old: " <<
 			(int)sens.lastThrottleStatus << " new: " <<
-			(int)sens.t.throttlingStatus << std::endl;
+			(int)sens.t.throttlingStatus << " measured: " <<
+			(int)sens.measuredStatus << std::endl;
 		cb(sens.t);
+	}
+	/* Trips follow the temperature, not a predicted or held severity */
+	if (sens.measuredStatus != measured)
 		cmnInst.initThreshold(sens);
+	if (cmnInst.hold_deadline(sens) >= 0)
+		hold_cv.notify_one();
+}
+
+/*
+ * A held severity drop gets no trip event, the trips have already moved
+ * down with the measured severity. Re-read each held sensor once its drop
+ * is due, otherwise the higher severity would stay until the next read.
+ */
+void ThermalUtils::holdTimer()
+{
+	std::unique_lock<std::mutex> _lock(sens_cb_mutex);
+
+	while (!hold_shutdown) {
+		int64_t now = std::chrono::duration_cast<
+			std::chrono::milliseconds>(std::chrono::steady_clock::
+			now().time_since_epoch()).count();
+		int64_t due, next = -1;
+
+		for (auto& it: thermalConfig) {
+			struct therm_sensor& sens = it.second;
+
+			due = cmnInst.hold_deadline(sens);
+			if (due >= 0 && due <= now) {
+				cmnInst.read_temperature(sens);
+				Notify(sens, true);
+				due = cmnInst.hold_deadline(sens);
+			}
+			if (due >= 0 && (next < 0 || due < next))
+				next = due;
+		}
+		if (next < 0)
+			hold_cv.wait(_lock);
+		else
+			hold_cv.wait_until(_lock,
+				std::chrono::steady_clock::time_point(
+				std::chrono::milliseconds(next)));
 	}
 }
 
@@ -122,7 +185,7 @@ void ThermalUtils::sampleParse(int tzn, int temp)
 	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
 	struct therm_sensor& sens = thermalConfig[tzn];
 	sens.t.value = (float)temp / (float)sens.mulFactor;
-	return Notify(sens);
+	return Notify(sens, true);
 }
 
 void ThermalUtils::eventCreateParse(int tzn, const char *name)
@@ -173,6 +236,7 @@ int ThermalUtils::readTemperatures(hidl_vec<Temperature_1_0>& temp)
 	if (!is_sensor_init)
 		return 0;
 	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+	cmnInst.snapshot_temperatures();
 	for (it = thermalConfig.begin(); it != thermalConfig.end();
 			it++, idx++) {
 		struct therm_sensor& sens = it->second;
@@ -184,7 +248,7 @@ int ThermalUtils::readTemperatures(hidl_vec<Temperature_1_0>& temp)
 		ret = cmnInst.read_temperature(sens);
 		if (ret < 0)
 			return ret;
-		Notify(sens);
+		Notify(sens, true);
 		_temp.currentValue = sens.t.value;
 		_temp.name = sens.t.name;
 		_temp.type = (TemperatureType_1_0)sens.t.type;
@@ -208,6 +272,7 @@ int ThermalUtils::readTemperatures(bool filterType, TemperatureType type,
 	std::vector<Temperature> _temp;
 
 	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+	cmnInst.snapshot_temperatures(filterType, type);
 	for (it = thermalConfig.begin(); it != thermalConfig.end(); it++) {
 		struct therm_sensor& sens = it->second;
 
@@ -216,7 +281,7 @@ int ThermalUtils::readTemperatures(bool filterType, TemperatureType type,
 		ret = cmnInst.read_temperature(sens);
 		if (ret < 0)
 			return ret;
-		Notify(sens);
+		Notify(sens, true);
 		_temp.push_back(sens.t);
 	}
 
@@ -263,6 +328,14 @@ int ThermalUtils::readCdevStates(bool filterType, cdevType type,
 	return cdev_out.size();
 }
 
+void ThermalUtils::dumpSensors(int fd)
+{
+	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+
+	for (auto& it: thermalConfig)
+		cmnInst.dump_sensor(fd, it.second);
+}
+
 int ThermalUtils::fetchCpuUsages(hidl_vec<CpuUsage>& cpu_usages)
 {
 	return cmnInst.get_cpu_usages(cpu_usages);